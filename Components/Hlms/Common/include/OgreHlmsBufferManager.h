@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreConstBufferPool.h"
 #include "OgreHlms.h"
 
 #include "OgreHeaderPrefix.h"
@@ -82,43 +83,92 @@ namespace Ogre
 
         VaoManager *mVaoManager;
 
-        uint32 mCurrentConstBuffer;  /// Resets every to zero every new frame.
-        uint32 mCurrentTexBuffer;    /// Resets every to zero every new frame.
-        ConstBufferPackedVec mConstBuffers;
+        ConstBufferPackedVec    mConstBuffers;
         ReadOnlyBufferPackedVec mTexBuffers;
 
-        uint32 *mStartMappedConstBuffer;
-        uint32 *mCurrentMappedConstBuffer;
-        size_t mCurrentConstBufferSize;
-
-        /// Holds ptr to the start of the mapped region
-        float *mRealStartMappedTexBuffer;
-        /// Holds ptr to the start of the **bound** region to the shader slot.
-        /// It is always mStartMappedTexBuffer >= mRealStartMappedTexBuffer
-        float *mStartMappedTexBuffer;
-        float *mCurrentMappedTexBuffer;
-        /// Bindable size left.
-        size_t mCurrentTexBufferSize;
-
-        /** Holds the offset at which all tex. binds should start from.
-            Resets every to zero every new buffer (@see unmapTexBuffer
-            and @see mapNextTexBuffer).
-        @remarks
-            The texture buffer has three location we need to track for:
-                * Where the buffer mapping starts (i.e. beginning of each render_pass)
-                  Tracked via mRealStartMappedTexBuffer
-                * Where the buffer latest bind point starts (i.e. each time we exceed
-                  the HW limit for const buffers, usually 64kb; or rendering between
-                  render queue IDs). Tracked via mStartMappedTexBuffer.
-                * How much data we've written so far for the current texture buffer,
-                  tracked via mTexLastOffset.
+        /** Where per-draw data is being written to (i.e. the mapped const & tex. buffers)
+            and what has been bound so far.
+            The render thread uses mMainState. When recording commands in parallel
+            (see Hlms::setParallelCommandGeneration) each slice has its own, whose
+            buffers are mapped in advance by _beginParallelCommandGeneration since
+            buffers can't be created nor mapped from worker threads.
         */
-        size_t mTexLastOffset;
-
-        /// Stores the offset to the last command buffer's binding command so we can
-        /// write the amount of bytes that should be bound (which is only known after
-        /// we've written them).
-        size_t mLastTexBufferCmdOffset;
+        struct MappedState
+        {
+            uint32 currentConstBuffer;  /// Resets every to zero every new frame.
+            uint32 currentTexBuffer;    /// Resets every to zero every new frame.
+
+            uint32 *startMappedConstBuffer;
+            uint32 *currentMappedConstBuffer;
+            size_t  currentConstBufferSize;
+
+            /// Holds ptr to the start of the mapped region
+            float *realStartMappedTexBuffer;
+            /// Holds ptr to the start of the **bound** region to the shader slot.
+            /// It is always startMappedTexBuffer >= realStartMappedTexBuffer
+            float *startMappedTexBuffer;
+            float *currentMappedTexBuffer;
+            /// Bindable size left.
+            size_t currentTexBufferSize;
+
+            /** Holds the offset at which all tex. binds should start from.
+                Resets every to zero every new buffer (@see unmapTexBuffer
+                and @see mapNextTexBuffer).
+            @remarks
+                The texture buffer has three location we need to track for:
+                    * Where the buffer mapping starts (i.e. beginning of each render_pass)
+                      Tracked via realStartMappedTexBuffer
+                    * Where the buffer latest bind point starts (i.e. each time we exceed
+                      the HW limit for const buffers, usually 64kb; or rendering between
+                      render queue IDs). Tracked via startMappedTexBuffer.
+                    * How much data we've written so far for the current texture buffer,
+                      tracked via texLastOffset.
+            */
+            size_t texLastOffset;
+
+            /// Stores the offset to the last command buffer's binding command so we can
+            /// write the amount of bytes that should be bound (which is only known after
+            /// we've written them).
+            size_t lastTexBufferCmdOffset;
+
+            /// Last material buffer & descriptor sets bound, to skip redundant binds.
+            ConstBufferPool::BufferPool const *lastBoundPool;
+            DescriptorSetTexture const        *lastDescTexture;
+            DescriptorSetSampler const        *lastDescSampler;
+
+            /// Slices only. Const buffers in range [currentConstBuffer; endConstBuffer)
+            /// have been mapped for it.
+            uint32 endConstBuffer;
+            /// Slices only. Tex. buffer region mapped for it, which the first call
+            /// to mapNextTexBuffer will use (at offset texLastOffset).
+            float *reservedTexBuffer;
+            size_t reservedTexBufferSize;
+            /// True if this is the state of a slice (i.e. it must not create nor map buffers)
+            bool isSlice;
+            /// Slices only. Set when the slice needed more memory than what was mapped for it.
+            bool outOfSpace;
+
+            MappedState();
+        };
+
+        MappedState mMainState;
+
+        /// Slices being recorded in parallel. See _beginParallelCommandGeneration
+        FastArray<MappedState> mSliceStates;
+        /// Memory of the const buffers mapped by _beginParallelCommandGeneration,
+        /// starting from mConstBuffers[mFirstSliceConstBuffer]
+        FastArray<uint32 *> mSliceConstBuffersMemory;
+        uint32              mFirstSliceConstBuffer;
+        /// Tex. buffers mapped by _beginParallelCommandGeneration
+        /// (i.e. mTexBuffers[texBufferIdx] mapped in range [offset; offset + sizeBytes) )
+        struct SliceTexBuffer
+        {
+            uint32 texBufferIdx;
+            size_t offset;
+            size_t sizeBytes;
+            float *mappedPtr;
+        };
+        FastArray<SliceTexBuffer> mSliceTexBuffers;
 
         /// The tex. buffer's size. Try raising this number if your API traces/profilers
         /// show we're constantly binding new textures. Should only be relevant if you
@@ -129,18 +179,25 @@ namespace Ogre
         /// Once we're done with it (even if we didn't fully use it) we discard it
         /// and get a new one. We will at least have to get a new one on every pass.
         /// This is affordable since common Const buffer limits are of 64kb.
-        /// At the next frame we restart mCurrentConstBuffer to 0.
-        void unmapConstBuffer();
-
-        /// Warning: Calling this function affects BOTH mCurrentConstBuffer and mCurrentTexBuffer
-        uint32 *RESTRICT_ALIAS_RETURN mapNextConstBuffer( CommandBuffer *commandBuffer );
+        /// At the next frame we restart currentConstBuffer to 0.
+        void unmapConstBuffer( MappedState &state );
+        void unmapConstBuffer() { unmapConstBuffer( mMainState ); }
+
+        /// Warning: Calling this function affects BOTH currentConstBuffer and currentTexBuffer
+        /// Slices get the next const buffer mapped for them, or null if there are none left.
+        uint32 *RESTRICT_ALIAS_RETURN mapNextConstBuffer( MappedState   &state,
+                                                          CommandBuffer *commandBuffer );
+        uint32 *RESTRICT_ALIAS_RETURN mapNextConstBuffer( CommandBuffer *commandBuffer )
+        {
+            return mapNextConstBuffer( mMainState, commandBuffer );
+        }
 
         /// Texture buffers are treated differently than Const buffers. We first map it.
-        /// Once we're done with it, we save our progress (in mTexLastOffset) and in the
+        /// Once we're done with it, we save our progress (in texLastOffset) and in the
         /// next pass start where we left off (i.e. if we wrote to the first 2MB chunk,
         /// start mapping from 2MB onwards). Only when the buffer is full, we get a new
         /// Tex Buffer.
-        /// At the next frame we restart mCurrentTexBuffer to 0.
+        /// At the next frame we restart currentTexBuffer to 0.
         ///
         /// Tex Buffers can be as big as 128MB, thus "restarting" with another 128MB
         /// buffer on every pass is too expensive. This strategy benefits low level RS
@@ -149,22 +206,51 @@ namespace Ogre
         /// or may internally use a new buffer (wasting memory space).
         ///
         /// (*) D3D11.1 allows using MAP_NO_OVERWRITE for texture buffers.
-        void unmapTexBuffer( CommandBuffer *commandBuffer );
-        float *RESTRICT_ALIAS_RETURN mapNextTexBuffer( CommandBuffer *commandBuffer,
+        ///
+        /// Slices get the region reserved for them once. After that they can't get more
+        /// tex. buffer memory; mapNextTexBuffer flags them as outOfSpace.
+        void unmapTexBuffer( MappedState &state, CommandBuffer *commandBuffer );
+        void unmapTexBuffer( CommandBuffer *commandBuffer )
+        {
+            unmapTexBuffer( mMainState, commandBuffer );
+        }
+        float *RESTRICT_ALIAS_RETURN mapNextTexBuffer( MappedState &state, CommandBuffer *commandBuffer,
                                                        size_t minimumSizeBytes );
+        float *RESTRICT_ALIAS_RETURN mapNextTexBuffer( CommandBuffer *commandBuffer,
+                                                       size_t minimumSizeBytes )
+        {
+            return mapNextTexBuffer( mMainState, commandBuffer, minimumSizeBytes );
+        }
 
         /** Rebinds the texture buffer. Finishes the last bind command to the tbuffer.
         @param resetOffset
             When true, the tbuffer will be offsetted so that the shader samples
-            from 0 at the current offset in mCurrentMappedTexBuffer
-            WARNING: mCurrentMappedTexBuffer may be modified due to alignment.
-            mStartMappedTexBuffer & mCurrentTexBufferSize will always be modified
+            from 0 at the current offset in currentMappedTexBuffer
+            WARNING: currentMappedTexBuffer may be modified due to alignment.
+            startMappedTexBuffer & currentTexBufferSize will always be modified
         @param minimumTexBufferSize
             If resetOffset is true and the remaining space in the currently mapped
             tbuffer is less than minimumSizeBytes, we will call mapNextTexBuffer
         */
-        void rebindTexBuffer( CommandBuffer *commandBuffer, bool resetOffset = false,
+        void rebindTexBuffer( MappedState &state, CommandBuffer *commandBuffer, bool resetOffset = false,
                               size_t minimumSizeBytes = 1 );
+        void rebindTexBuffer( CommandBuffer *commandBuffer, bool resetOffset = false,
+                              size_t minimumSizeBytes = 1 )
+        {
+            rebindTexBuffer( mMainState, commandBuffer, resetOffset, minimumSizeBytes );
+        }
+
+        /** Maps the next const buffer, and then maps the next tex. buffer (if exceedsTexBuffer)
+            or rebinds the current one so that at least minimumTexBufferSizeBytes are available.
+        @return
+            False if the state is a slice that ran out of its memory. Nothing must be written then.
+        */
+        bool mapNextBuffers( MappedState &state, CommandBuffer *commandBuffer, bool exceedsTexBuffer,
+                             size_t minimumTexBufferSizeBytes );
+
+        /// Number of bytes of tex. buffer a non-animated renderable needs per draw.
+        /// Used to decide how much memory to map for each slice.
+        virtual size_t getTexBufferBytesPerDraw( bool casterPass ) const { return 128u; }
 
         virtual void destroyAllBuffers();
 
@@ -183,6 +269,10 @@ namespace Ogre
 
         void frameEnded() override;
 
+        void _beginParallelCommandGeneration( CommandBuffer *commandBuffer, bool casterPass,
+                                              size_t numSlices, const size_t *numRenderables ) override;
+        void _endParallelCommandGeneration( CommandBuffer *const *sliceCommandBuffers ) override;
+
         /// Changes the default suggested size for the texture buffer.
         /// Actual size may be lower if the GPU can't honour the request.
         void setTextureBufferDefaultSize( size_t defaultSize );
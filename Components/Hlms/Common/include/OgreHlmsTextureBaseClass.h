@@ -107,6 +107,8 @@ namespace Ogre
 
         void preload() override;
 
+        void _addTextureScreenCoverage( float coverage ) override;
+
         void saveTextures( const String &folderPath, set<String>::type &savedTextures, bool saveOitd,
                            bool saveOriginal, HlmsTextureExportListener *listener ) override;
 
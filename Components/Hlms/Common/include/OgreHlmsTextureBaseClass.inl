@@ -103,6 +103,17 @@ namespace Ogre
         loadAllTextures();
     }
     //-----------------------------------------------------------------------------------
+    void OGRE_HLMS_TEXTURE_BASE_CLASS::_addTextureScreenCoverage( float coverage )
+    {
+        for( size_t i=0; i<OGRE_HLMS_TEXTURE_BASE_MAX_TEX; ++i )
+        {
+            TextureGpu *texture = mTextures[i];
+
+            if( texture && !texture->isDataReady() )
+                texture->getTextureManager()->_addScreenCoverage( texture, coverage );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void OGRE_HLMS_TEXTURE_BASE_CLASS::saveTextures( const String &folderPath,
                                                      set<String>::type &savedTextures,
                                                      bool saveOitd, bool saveOriginal,
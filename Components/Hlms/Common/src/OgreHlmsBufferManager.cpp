@@ -39,21 +39,34 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    HlmsBufferManager::MappedState::MappedState() :
+        currentConstBuffer( 0 ),
+        currentTexBuffer( 0 ),
+        startMappedConstBuffer( 0 ),
+        currentMappedConstBuffer( 0 ),
+        currentConstBufferSize( 0 ),
+        realStartMappedTexBuffer( 0 ),
+        startMappedTexBuffer( 0 ),
+        currentMappedTexBuffer( 0 ),
+        currentTexBufferSize( 0 ),
+        texLastOffset( 0 ),
+        lastTexBufferCmdOffset( std::numeric_limits<size_t>::max() ),
+        lastBoundPool( 0 ),
+        lastDescTexture( 0 ),
+        lastDescSampler( 0 ),
+        endConstBuffer( 0 ),
+        reservedTexBuffer( 0 ),
+        reservedTexBufferSize( 0 ),
+        isSlice( false ),
+        outOfSpace( false )
+    {
+    }
+    //-----------------------------------------------------------------------------------
     HlmsBufferManager::HlmsBufferManager( HlmsTypes type, const String &typeName, Archive *dataFolder,
                                           ArchiveVec *libraryFolders ) :
         Hlms( type, typeName, dataFolder, libraryFolders ),
         mVaoManager( 0 ),
-        mCurrentConstBuffer( 0 ),
-        mCurrentTexBuffer( 0 ),
-        mStartMappedConstBuffer( 0 ),
-        mCurrentMappedConstBuffer( 0 ),
-        mCurrentConstBufferSize( 0 ),
-        mRealStartMappedTexBuffer( 0 ),
-        mStartMappedTexBuffer( 0 ),
-        mCurrentMappedTexBuffer( 0 ),
-        mCurrentTexBufferSize( 0 ),
-        mTexLastOffset( 0 ),
-        mLastTexBufferCmdOffset( std::numeric_limits<size_t>::max() ),
+        mFirstSliceConstBuffer( 0 ),
         mTextureBufferDefaultSize( 4 * 1024 * 1024 )
     {
     }
@@ -93,103 +106,157 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void HlmsBufferManager::unmapConstBuffer()
+    void HlmsBufferManager::unmapConstBuffer( MappedState &state )
     {
-        if( mStartMappedConstBuffer )
+        if( state.startMappedConstBuffer )
         {
-            // Unmap the current buffer
-            ConstBufferPacked *constBuffer = mConstBuffers[mCurrentConstBuffer];
-            constBuffer->unmap(
-                UO_KEEP_PERSISTENT, 0,
-                static_cast<size_t>( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) *
-                    sizeof( uint32 ) );
-
-            ++mCurrentConstBuffer;
-
-            mStartMappedConstBuffer = 0;
-            mCurrentMappedConstBuffer = 0;
-            mCurrentConstBufferSize = 0;
+            // Unmap the current buffer. Slices get theirs unmapped in _endParallelCommandGeneration
+            if( !state.isSlice )
+            {
+                ConstBufferPacked *constBuffer = mConstBuffers[state.currentConstBuffer];
+                constBuffer->unmap( UO_KEEP_PERSISTENT, 0,
+                                    static_cast<size_t>( state.currentMappedConstBuffer -
+                                                         state.startMappedConstBuffer ) *
+                                        sizeof( uint32 ) );
+            }
+
+            ++state.currentConstBuffer;
+
+            state.startMappedConstBuffer = 0;
+            state.currentMappedConstBuffer = 0;
+            state.currentConstBufferSize = 0;
         }
     }
     //-----------------------------------------------------------------------------------
-    uint32 *RESTRICT_ALIAS_RETURN HlmsBufferManager::mapNextConstBuffer( CommandBuffer *commandBuffer )
+    uint32 *RESTRICT_ALIAS_RETURN HlmsBufferManager::mapNextConstBuffer( MappedState   &state,
+                                                                        CommandBuffer *commandBuffer )
     {
-        unmapConstBuffer();
+        if( state.isSlice )
+        {
+            const uint32 nextConstBuffer =
+                state.currentConstBuffer + ( state.startMappedConstBuffer ? 1u : 0u );
+            if( nextConstBuffer >= state.endConstBuffer )
+            {
+                state.outOfSpace = true;
+                return 0;
+            }
+        }
+
+        unmapConstBuffer( state );
+
+        ConstBufferPacked *constBuffer;
 
-        if( mCurrentConstBuffer >= mConstBuffers.size() )
+        if( state.isSlice )
         {
-            size_t bufferSize = std::min<size_t>( 65536, mVaoManager->getConstBufferMaxSize() );
-            ConstBufferPacked *newBuffer =
-                mVaoManager->createConstBuffer( bufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
-            mConstBuffers.push_back( newBuffer );
+            constBuffer = mConstBuffers[state.currentConstBuffer];
+            state.startMappedConstBuffer =
+                mSliceConstBuffersMemory[state.currentConstBuffer - mFirstSliceConstBuffer];
         }
+        else
+        {
+            if( state.currentConstBuffer >= mConstBuffers.size() )
+            {
+                size_t bufferSize = std::min<size_t>( 65536, mVaoManager->getConstBufferMaxSize() );
+                ConstBufferPacked *newBuffer =
+                    mVaoManager->createConstBuffer( bufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
+                mConstBuffers.push_back( newBuffer );
+            }
 
-        ConstBufferPacked *constBuffer = mConstBuffers[mCurrentConstBuffer];
+            constBuffer = mConstBuffers[state.currentConstBuffer];
+            state.startMappedConstBuffer =
+                reinterpret_cast<uint32 *>( constBuffer->map( 0, constBuffer->getNumElements() ) );
+        }
 
-        mStartMappedConstBuffer =
-            reinterpret_cast<uint32 *>( constBuffer->map( 0, constBuffer->getNumElements() ) );
-        mCurrentMappedConstBuffer = mStartMappedConstBuffer;
-        mCurrentConstBufferSize = constBuffer->getNumElements() >> 2;
+        state.currentMappedConstBuffer = state.startMappedConstBuffer;
+        state.currentConstBufferSize = constBuffer->getNumElements() >> 2;
 
         *commandBuffer->addCommand<CbShaderBuffer>() =
             CbShaderBuffer( VertexShader, 2, constBuffer, 0, 0 );
         *commandBuffer->addCommand<CbShaderBuffer>() =
             CbShaderBuffer( PixelShader, 2, constBuffer, 0, 0 );
 
-        return mStartMappedConstBuffer;
+        return state.startMappedConstBuffer;
     }
     //-----------------------------------------------------------------------------------
-    void HlmsBufferManager::unmapTexBuffer( CommandBuffer *commandBuffer )
+    void HlmsBufferManager::unmapTexBuffer( MappedState &state, CommandBuffer *commandBuffer )
     {
         // Save our progress
         const size_t bytesWritten =
-            static_cast<size_t>( mCurrentMappedTexBuffer - mRealStartMappedTexBuffer ) * sizeof( float );
-        mTexLastOffset += bytesWritten;
+            static_cast<size_t>( state.currentMappedTexBuffer - state.realStartMappedTexBuffer ) *
+            sizeof( float );
+        state.texLastOffset += bytesWritten;
 
-        if( mRealStartMappedTexBuffer )
+        if( state.realStartMappedTexBuffer )
         {
-            // Unmap the current buffer
-            TexBufferPacked *texBuffer = mTexBuffers[mCurrentTexBuffer];
-            texBuffer->unmap( UO_KEEP_PERSISTENT, 0, bytesWritten );
+            // Unmap the current buffer. Slices get theirs unmapped in _endParallelCommandGeneration
+            TexBufferPacked *texBuffer = mTexBuffers[state.currentTexBuffer];
+            if( !state.isSlice )
+                texBuffer->unmap( UO_KEEP_PERSISTENT, 0, bytesWritten );
 
             CbShaderBuffer *shaderBufferCmd = reinterpret_cast<CbShaderBuffer *>(
-                commandBuffer->getCommandFromOffset( mLastTexBufferCmdOffset ) );
+                commandBuffer->getCommandFromOffset( state.lastTexBufferCmdOffset ) );
             if( shaderBufferCmd )
             {
                 assert( shaderBufferCmd->bufferPacked == texBuffer );
                 shaderBufferCmd->bindSizeBytes =
-                    (uint32)( mTexLastOffset - shaderBufferCmd->bindOffset );
-                mLastTexBufferCmdOffset = std::numeric_limits<size_t>::max();
+                    (uint32)( state.texLastOffset - shaderBufferCmd->bindOffset );
+                state.lastTexBufferCmdOffset = std::numeric_limits<size_t>::max();
             }
         }
 
-        mRealStartMappedTexBuffer = 0;
-        mStartMappedTexBuffer = 0;
-        mCurrentMappedTexBuffer = 0;
-        mCurrentTexBufferSize = 0;
+        state.realStartMappedTexBuffer = 0;
+        state.startMappedTexBuffer = 0;
+        state.currentMappedTexBuffer = 0;
+        state.currentTexBufferSize = 0;
 
         // Ensure the proper alignment
-        mTexLastOffset =
-            alignToNextMultiple<size_t>( mTexLastOffset, mVaoManager->getTexBufferAlignment() );
+        state.texLastOffset =
+            alignToNextMultiple<size_t>( state.texLastOffset, mVaoManager->getTexBufferAlignment() );
     }
     //-----------------------------------------------------------------------------------
-    float *RESTRICT_ALIAS_RETURN HlmsBufferManager::mapNextTexBuffer( CommandBuffer *commandBuffer,
-                                                                      size_t minimumSizeBytes )
+    float *RESTRICT_ALIAS_RETURN HlmsBufferManager::mapNextTexBuffer( MappedState   &state,
+                                                                      CommandBuffer *commandBuffer,
+                                                                      size_t         minimumSizeBytes )
     {
-        unmapTexBuffer( commandBuffer );
+        if( state.isSlice )
+        {
+            if( !state.reservedTexBuffer || state.reservedTexBufferSize < minimumSizeBytes )
+            {
+                state.outOfSpace = true;
+                return 0;
+            }
+
+            unmapTexBuffer( state, commandBuffer );
+
+            state.realStartMappedTexBuffer = state.reservedTexBuffer;
+            state.startMappedTexBuffer = state.realStartMappedTexBuffer;
+            state.currentMappedTexBuffer = state.realStartMappedTexBuffer;
+            state.currentTexBufferSize = state.reservedTexBufferSize >> 2u;
+            state.reservedTexBuffer = 0;
+            state.reservedTexBufferSize = 0;
+
+            CbShaderBuffer *shaderBufferCmd = commandBuffer->addCommand<CbShaderBuffer>();
+            *shaderBufferCmd = CbShaderBuffer( VertexShader, 0, mTexBuffers[state.currentTexBuffer],
+                                               (uint32)state.texLastOffset, 0 );
+            state.lastTexBufferCmdOffset = commandBuffer->getCommandOffset( shaderBufferCmd );
 
-        ReadOnlyBufferPacked *texBuffer = mTexBuffers[mCurrentTexBuffer];
+            return state.startMappedTexBuffer;
+        }
+
+        unmapTexBuffer( state, commandBuffer );
+
+        ReadOnlyBufferPacked *texBuffer = mTexBuffers[state.currentTexBuffer];
 
-        mTexLastOffset =
-            alignToNextMultiple<size_t>( mTexLastOffset, mVaoManager->getTexBufferAlignment() );
+        state.texLastOffset =
+            alignToNextMultiple<size_t>( state.texLastOffset, mVaoManager->getTexBufferAlignment() );
 
         // We'll go out of bounds. This buffer is full. Get a new one and remap from 0.
-        if( mTexLastOffset + minimumSizeBytes >= texBuffer->getTotalSizeBytes() )
+        if( state.texLastOffset + minimumSizeBytes >= texBuffer->getTotalSizeBytes() )
         {
-            mTexLastOffset = 0;
-            ++mCurrentTexBuffer;
+            state.texLastOffset = 0;
+            ++state.currentTexBuffer;
 
-            if( mCurrentTexBuffer >= mTexBuffers.size() )
+            if( state.currentTexBuffer >= mTexBuffers.size() )
             {
                 size_t bufferSize = std::min<size_t>( mTextureBufferDefaultSize,
                                                       mVaoManager->getReadOnlyBufferMaxSize() );
@@ -198,41 +265,44 @@ namespace Ogre
                 mTexBuffers.push_back( newBuffer );
             }
 
-            texBuffer = mTexBuffers[mCurrentTexBuffer];
+            texBuffer = mTexBuffers[state.currentTexBuffer];
         }
 
-        mRealStartMappedTexBuffer = reinterpret_cast<float *>(
-            texBuffer->map( mTexLastOffset, texBuffer->getNumElements() - mTexLastOffset, false ) );
-        mStartMappedTexBuffer = mRealStartMappedTexBuffer;
-        mCurrentMappedTexBuffer = mRealStartMappedTexBuffer;
-        mCurrentTexBufferSize = ( texBuffer->getNumElements() - mTexLastOffset ) >> 2;
+        state.realStartMappedTexBuffer = reinterpret_cast<float *>( texBuffer->map(
+            state.texLastOffset, texBuffer->getNumElements() - state.texLastOffset, false ) );
+        state.startMappedTexBuffer = state.realStartMappedTexBuffer;
+        state.currentMappedTexBuffer = state.realStartMappedTexBuffer;
+        state.currentTexBufferSize = ( texBuffer->getNumElements() - state.texLastOffset ) >> 2;
 
         CbShaderBuffer *shaderBufferCmd = commandBuffer->addCommand<CbShaderBuffer>();
-        *shaderBufferCmd = CbShaderBuffer( VertexShader, 0, texBuffer, (uint32)mTexLastOffset, 0 );
+        *shaderBufferCmd =
+            CbShaderBuffer( VertexShader, 0, texBuffer, (uint32)state.texLastOffset, 0 );
 
-        mLastTexBufferCmdOffset = commandBuffer->getCommandOffset( shaderBufferCmd );
+        state.lastTexBufferCmdOffset = commandBuffer->getCommandOffset( shaderBufferCmd );
 
-        return mStartMappedTexBuffer;
+        return state.startMappedTexBuffer;
     }
     //-----------------------------------------------------------------------------------
-    void HlmsBufferManager::rebindTexBuffer( CommandBuffer *commandBuffer, bool resetOffset,
-                                             size_t minimumSizeBytes )
+    void HlmsBufferManager::rebindTexBuffer( MappedState &state, CommandBuffer *commandBuffer,
+                                             bool resetOffset, size_t minimumSizeBytes )
     {
         assert( minimumSizeBytes > 0 );
 
         // Set the binding size of the old binding command (if exists)
         CbShaderBuffer *shaderBufferCmd = reinterpret_cast<CbShaderBuffer *>(
-            commandBuffer->getCommandFromOffset( mLastTexBufferCmdOffset ) );
+            commandBuffer->getCommandFromOffset( state.lastTexBufferCmdOffset ) );
         if( shaderBufferCmd )
         {
-            assert( shaderBufferCmd->bufferPacked == mTexBuffers[mCurrentTexBuffer] );
+            assert( shaderBufferCmd->bufferPacked == mTexBuffers[state.currentTexBuffer] );
             shaderBufferCmd->bindSizeBytes =
-                static_cast<uint32>( mCurrentMappedTexBuffer - mStartMappedTexBuffer ) * sizeof( float );
+                static_cast<uint32>( state.currentMappedTexBuffer - state.startMappedTexBuffer ) *
+                sizeof( float );
         }
 
-        const size_t bufferSizeBytes = mCurrentTexBufferSize * sizeof( float );
+        const size_t bufferSizeBytes = state.currentTexBufferSize * sizeof( float );
         size_t currentOffset =
-            static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer ) * sizeof( float );
+            static_cast<size_t>( state.currentMappedTexBuffer - state.startMappedTexBuffer ) *
+            sizeof( float );
         currentOffset =
             alignToNextMultiple<size_t>( currentOffset, mVaoManager->getTexBufferAlignment() );
         currentOffset = std::min( bufferSizeBytes, currentOffset );
@@ -240,44 +310,223 @@ namespace Ogre
 
         if( resetOffset && remainingSize < minimumSizeBytes )
         {
-            mapNextTexBuffer( commandBuffer, minimumSizeBytes );
+            mapNextTexBuffer( state, commandBuffer, minimumSizeBytes );
         }
         else
         {
             size_t bindOffset =
-                static_cast<size_t>( mStartMappedTexBuffer - mRealStartMappedTexBuffer ) *
+                static_cast<size_t>( state.startMappedTexBuffer - state.realStartMappedTexBuffer ) *
                 sizeof( float );
             if( resetOffset )
             {
-                mStartMappedTexBuffer = reinterpret_cast<float *>(
-                    reinterpret_cast<unsigned char *>( mStartMappedTexBuffer ) + currentOffset );
-                mCurrentMappedTexBuffer = mStartMappedTexBuffer;
-                mCurrentTexBufferSize -= currentOffset / sizeof( float );
+                state.startMappedTexBuffer = reinterpret_cast<float *>(
+                    reinterpret_cast<unsigned char *>( state.startMappedTexBuffer ) + currentOffset );
+                state.currentMappedTexBuffer = state.startMappedTexBuffer;
+                state.currentTexBufferSize -= currentOffset / sizeof( float );
 
-                bindOffset = static_cast<size_t>( mCurrentMappedTexBuffer - mRealStartMappedTexBuffer ) *
+                bindOffset = static_cast<size_t>( state.currentMappedTexBuffer -
+                                                  state.realStartMappedTexBuffer ) *
                              sizeof( float );
             }
 
-            if( mTexLastOffset + bindOffset >= mTexBuffers[mCurrentTexBuffer]->getTotalSizeBytes() )
+            if( state.texLastOffset + bindOffset >=
+                mTexBuffers[state.currentTexBuffer]->getTotalSizeBytes() )
             {
-                mapNextTexBuffer( commandBuffer, minimumSizeBytes );
+                mapNextTexBuffer( state, commandBuffer, minimumSizeBytes );
             }
             else
             {
                 // Add a new binding command.
                 shaderBufferCmd = commandBuffer->addCommand<CbShaderBuffer>();
-                *shaderBufferCmd = CbShaderBuffer( VertexShader, 0, mTexBuffers[mCurrentTexBuffer],
-                                                   uint32( mTexLastOffset + bindOffset ), 0 );
-                mLastTexBufferCmdOffset = commandBuffer->getCommandOffset( shaderBufferCmd );
+                *shaderBufferCmd =
+                    CbShaderBuffer( VertexShader, 0, mTexBuffers[state.currentTexBuffer],
+                                    uint32( state.texLastOffset + bindOffset ), 0 );
+                state.lastTexBufferCmdOffset = commandBuffer->getCommandOffset( shaderBufferCmd );
             }
         }
     }
     //-----------------------------------------------------------------------------------
+    bool HlmsBufferManager::mapNextBuffers( MappedState &state, CommandBuffer *commandBuffer,
+                                            bool exceedsTexBuffer, size_t minimumTexBufferSizeBytes )
+    {
+        if( !mapNextConstBuffer( state, commandBuffer ) )
+            return false;
+
+        if( exceedsTexBuffer )
+            mapNextTexBuffer( state, commandBuffer, minimumTexBufferSizeBytes );
+        else
+            rebindTexBuffer( state, commandBuffer, true, minimumTexBufferSizeBytes );
+
+        return !state.outOfSpace;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsBufferManager::_beginParallelCommandGeneration( CommandBuffer *commandBuffer,
+                                                             bool casterPass, size_t numSlices,
+                                                             const size_t *numRenderables )
+    {
+        // The slices take their buffers from where the render thread was; which then
+        // continues after them, with fresh buffers.
+        unmapConstBuffer( mMainState );
+        unmapTexBuffer( mMainState, commandBuffer );
+
+        const size_t constBufferSize = std::min<size_t>( 65536, mVaoManager->getConstBufferMaxSize() );
+        const size_t texBufferSize =
+            std::min<size_t>( mTextureBufferDefaultSize, mVaoManager->getReadOnlyBufferMaxSize() );
+        const size_t texBufferAlignment = mVaoManager->getTexBufferAlignment();
+        const size_t texBytesPerDraw = getTexBufferBytesPerDraw( casterPass );
+
+        mSliceStates.resize( numSlices );
+        mSliceConstBuffersMemory.clear();
+        mSliceTexBuffers.clear();
+        mFirstSliceConstBuffer = mMainState.currentConstBuffer;
+
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            MappedState &state = mSliceStates[i];
+            state = MappedState();
+            state.isSlice = true;
+            state.currentConstBuffer = mMainState.currentConstBuffer;
+            state.endConstBuffer = mMainState.currentConstBuffer;
+            state.currentTexBuffer = mMainState.currentTexBuffer;
+            state.texLastOffset = mMainState.texLastOffset;
+
+            if( !numRenderables[i] )
+                continue;
+
+            // 4 uint32 per draw. Slices that need more (e.g. skeletal animation may
+            // need more tex. buffer memory) finish in the render thread.
+            const size_t numConstBuffers =
+                ( numRenderables[i] * 4u * sizeof( uint32 ) ) / constBufferSize + 1u;
+            for( size_t j = 0u; j < numConstBuffers; ++j )
+            {
+                if( mMainState.currentConstBuffer >= mConstBuffers.size() )
+                {
+                    ConstBufferPacked *newBuffer = mVaoManager->createConstBuffer(
+                        constBufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
+                    mConstBuffers.push_back( newBuffer );
+                }
+
+                ConstBufferPacked *constBuffer = mConstBuffers[mMainState.currentConstBuffer];
+                mSliceConstBuffersMemory.push_back(
+                    reinterpret_cast<uint32 *>( constBuffer->map( 0, constBuffer->getNumElements() ) ) );
+                ++mMainState.currentConstBuffer;
+            }
+            state.endConstBuffer = mMainState.currentConstBuffer;
+
+            // Leave some room for the rebinds' alignment
+            size_t texBytes = numRenderables[i] * texBytesPerDraw;
+            texBytes += texBytes / 8u + 2u * texBufferAlignment;
+            texBytes = alignToNextMultiple<size_t>( texBytes, texBufferAlignment );
+
+            size_t texOffset =
+                alignToNextMultiple<size_t>( mMainState.texLastOffset, texBufferAlignment );
+            if( texOffset + texBytes > mTexBuffers[mMainState.currentTexBuffer]->getTotalSizeBytes() )
+            {
+                texOffset = 0u;
+                ++mMainState.currentTexBuffer;
+                if( mMainState.currentTexBuffer >= mTexBuffers.size() )
+                {
+                    ReadOnlyBufferPacked *newBuffer = mVaoManager->createReadOnlyBuffer(
+                        PFG_RGBA32_FLOAT, texBufferSize, BT_DYNAMIC_PERSISTENT, 0, false );
+                    mTexBuffers.push_back( newBuffer );
+                }
+                texBytes = std::min( texBytes,
+                                     mTexBuffers[mMainState.currentTexBuffer]->getTotalSizeBytes() );
+            }
+
+            if( mSliceTexBuffers.empty() ||
+                mSliceTexBuffers.back().texBufferIdx != mMainState.currentTexBuffer )
+            {
+                SliceTexBuffer sliceTexBuffer;
+                sliceTexBuffer.texBufferIdx = mMainState.currentTexBuffer;
+                sliceTexBuffer.offset = texOffset;
+                sliceTexBuffer.sizeBytes = 0u;
+                sliceTexBuffer.mappedPtr = 0;
+                mSliceTexBuffers.push_back( sliceTexBuffer );
+            }
+            // Grow the region of this tex. buffer. Mapped below, once its size is known.
+            mSliceTexBuffers.back().sizeBytes = texOffset + texBytes - mSliceTexBuffers.back().offset;
+
+            state.currentTexBuffer = mMainState.currentTexBuffer;
+            state.texLastOffset = texOffset;
+            state.reservedTexBufferSize = texBytes;
+
+            mMainState.texLastOffset = texOffset + texBytes;
+        }
+
+        FastArray<SliceTexBuffer>::iterator itor = mSliceTexBuffers.begin();
+        FastArray<SliceTexBuffer>::iterator endt = mSliceTexBuffers.end();
+
+        while( itor != endt )
+        {
+            ReadOnlyBufferPacked *texBuffer = mTexBuffers[itor->texBufferIdx];
+            itor->mappedPtr =
+                reinterpret_cast<float *>( texBuffer->map( itor->offset, itor->sizeBytes, false ) );
+            ++itor;
+        }
+
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            MappedState &state = mSliceStates[i];
+            if( !numRenderables[i] )
+                continue;
+
+            itor = mSliceTexBuffers.begin();
+            while( itor->texBufferIdx != state.currentTexBuffer )
+                ++itor;
+
+            state.reservedTexBuffer =
+                itor->mappedPtr + ( state.texLastOffset - itor->offset ) / sizeof( float );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsBufferManager::_endParallelCommandGeneration( CommandBuffer *const *sliceCommandBuffers )
+    {
+        const size_t numSlices = mSliceStates.size();
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            MappedState &state = mSliceStates[i];
+
+            // Write the size of the last tex. buffer bind
+            unmapTexBuffer( state, sliceCommandBuffers[i] );
+
+            if( state.startMappedConstBuffer )
+            {
+                const size_t bytesWritten = static_cast<size_t>( state.currentMappedConstBuffer -
+                                                                 state.startMappedConstBuffer ) *
+                                            sizeof( uint32 );
+                mConstBuffers[state.currentConstBuffer]->unmap( UO_KEEP_PERSISTENT, 0, bytesWritten );
+                mSliceConstBuffersMemory[state.currentConstBuffer - mFirstSliceConstBuffer] = 0;
+            }
+        }
+
+        // The rest were either fully written or not used at all
+        const size_t numSliceConstBuffers = mSliceConstBuffersMemory.size();
+        for( size_t i = 0u; i < numSliceConstBuffers; ++i )
+        {
+            if( mSliceConstBuffersMemory[i] )
+                mConstBuffers[mFirstSliceConstBuffer + i]->unmap( UO_KEEP_PERSISTENT );
+        }
+
+        FastArray<SliceTexBuffer>::const_iterator itor = mSliceTexBuffers.begin();
+        FastArray<SliceTexBuffer>::const_iterator endt = mSliceTexBuffers.end();
+
+        while( itor != endt )
+        {
+            mTexBuffers[itor->texBufferIdx]->unmap( UO_KEEP_PERSISTENT, 0, itor->sizeBytes );
+            ++itor;
+        }
+
+        mSliceStates.clear();
+        mSliceConstBuffersMemory.clear();
+        mSliceTexBuffers.clear();
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsBufferManager::destroyAllBuffers()
     {
-        mCurrentConstBuffer = 0;
-        mCurrentTexBuffer = 0;
-        mTexLastOffset = 0;
+        mMainState.currentConstBuffer = 0;
+        mMainState.currentTexBuffer = 0;
+        mMainState.texLastOffset = 0;
 
         {
             ReadOnlyBufferPackedVec::const_iterator itor = mTexBuffers.begin();
@@ -339,9 +588,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsBufferManager::frameEnded()
     {
-        mCurrentConstBuffer = 0;
-        mCurrentTexBuffer = 0;
-        mTexLastOffset = 0;
+        mMainState.currentConstBuffer = 0;
+        mMainState.currentTexBuffer = 0;
+        mMainState.texLastOffset = 0;
 
         ReadOnlyBufferPackedVec::const_iterator itor = mTexBuffers.begin();
         ReadOnlyBufferPackedVec::const_iterator end = mTexBuffers.end();
@@ -54,6 +54,27 @@ namespace Ogre
 
     class _OgreHlmsPbsExport InstantRadiosity
     {
+        /// Bounding Volume Hierarchy over the triangles of a MeshData, in object space.
+        /// Lets the raycaster skip the triangles whose nodes the rays don't go through.
+        struct MeshBvh
+        {
+            struct Node
+            {
+                Aabb aabb;
+                /// Inner nodes: index to the first of its two (contiguous) children.
+                /// Leaves: index to the first of its entries in MeshBvh::triangles.
+                uint32 firstChildOrTriangle;
+                /// 0 for inner nodes.
+                uint32 numTriangles;
+            };
+
+            /// nodes[0] is the root.
+            FastArray<Node> nodes;
+            /// Index to the first vertex element of each triangle (i.e. a multiple of 3),
+            /// sorted so that the triangles of each leaf are contiguous.
+            FastArray<uint32> triangles;
+        };
+
         struct MeshData
         {
             float *RESTRICT_ALIAS vertexData;
@@ -67,8 +88,13 @@ namespace Ogre
             size_t numVertices;
             size_t numIndices;
             bool   useIndices16bit;
+            /// Built right after downloading the mesh. Owned by us.
+            MeshBvh *bvh;
 
             float *getUvStart( uint8_t uvSet ) const;
+            /// Returns the vertex indices of the triangle starting at element firstElement
+            void    getTriangle( size_t firstElement, uint32 outVertexIdx[3] ) const;
+            Vector3 getPosition( uint32 vertexIdx ) const;
         };
 
         struct MaterialData
@@ -251,6 +277,21 @@ namespace Ogre
 
         bool mUseIrradianceVolume;
 
+        bool mDeterministicRaycast;
+
+        /// Arguments of the raycastLightRayVsMesh call whose rays are being
+        /// distributed across the worker threads.
+        struct RaycastJob
+        {
+            Real                     lightRange;
+            MeshData const          *meshData;
+            Matrix4                  worldMatrix;
+            Matrix4                  invWorldMatrix;
+            MaterialData const      *material;
+            FastArray<size_t> const *raysThatHitObj;
+        };
+        RaycastJob mRaycastJob;
+
         /**
         @param lightPos
         @param lightRot
@@ -286,6 +327,25 @@ namespace Ogre
         void raycastLightRayVsMesh( Real lightRange, const MeshData meshData, Matrix4 worldMatrix,
                                     const MaterialData      &material,
                                     const FastArray<size_t> &raysThatHitObj );
+        /// Reference implementation of raycastLightRayVsMesh. Tests every ray against
+        /// every triangle, in order.
+        void raycastLightRayVsAllTriangles( Real lightRange, const MeshData &meshData,
+                                            const Matrix4 &worldMatrix, const MaterialData &material,
+                                            const FastArray<size_t> &raysThatHitObj );
+        /** Raycasts (*mRaycastJob.raysThatHitObj)[firstRay] through
+            (*mRaycastJob.raysThatHitObj)[lastRay-1] against the BVH, in packets of
+            ARRAY_PACKED_REALS rays.
+        @remarks
+            Produces the same hits as raycastLightRayVsAllTriangles: triangles are
+            intersected in world space the same way, and ties in distance go to the
+            triangle that comes first in the mesh.
+        */
+        void raycastLightRaysVsBvh( size_t firstRay, size_t lastRay );
+
+        static void buildBvh( MeshData &meshData );
+        static void setRayHit( RayHit &rayHit, Real distance, const MeshData &meshData,
+                               const MaterialData &material, const Vector3 triVerts[3],
+                               const Vector3 &triNormal, const uint32 vertexIdx[3] );
 
         Vpl convertToVpl( Vector3 lightColour, Vector3 pointOnTri, const RayHit &hit );
         /// Generates the VPLs from a particular lights, and clusters them.
@@ -348,6 +408,45 @@ namespace Ogre
         void setUseIrradianceVolume( bool bUseIrradianceVolume );
         bool getUseIrradianceVolume() const { return mUseIrradianceVolume; }
 
+        /** By default, build() raycasts against a BVH built for each mesh and splits
+            the rays across the SceneManager's worker threads.
+            When deterministic, every ray is tested against every triangle on the calling
+            thread, in order; which is much slower but matches older versions bit-for-bit.
+            Useful for regression tests.
+        @remarks
+            The default path already produces the same hits regardless of the number of
+            worker threads.
+        */
+        void setDeterministicRaycast( bool bDeterministic );
+        bool getDeterministicRaycast() const { return mDeterministicRaycast; }
+
+        /// For internal use. Called from each worker thread to raycast its share of mRaycastJob.
+        void _raycastJob( size_t threadId, size_t numThreads );
+
+        /** Raycasts the given rays against a triangle mesh the same way build() does against
+            each mesh in the scene: against its BVH, or testing every triangle if
+            getDeterministicRaycast is true. Meant for regression tests.
+        @param vertexPositions
+            3 floats per vertex, in object space.
+        @param indexData
+            Array of 16-bit or 32-bit indices. Null if the mesh isn't indexed.
+        @param worldMatrix
+            Transforms the mesh to world space.
+        @param rays
+            Array of numRays rays, in world space.
+        @param maxDistance
+            Hits farther than this are ignored.
+        @param outDistances
+            Array of numRays. Distance to the closest hit, or maxDistance if there was none.
+        @param outTriVerts
+            Array of numRays * 3. World-space vertices of the triangle each ray hit.
+            Left untouched for rays that don't hit anything.
+        */
+        void _raycastMesh( const float *vertexPositions, size_t numVertices, const void *indexData,
+                           size_t numIndices, bool useIndices16bit, const Matrix4 &worldMatrix,
+                           const Ray *rays, size_t numRays, Real maxDistance, Real *outDistances,
+                           Vector3 *outTriVerts );
+
         /** Outputs suggested parameters for a volumetric texture that will encompass all
             VPLs. They are suggestions, you don't have to follow them.
         @param inCellSize
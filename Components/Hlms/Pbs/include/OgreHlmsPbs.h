@@ -165,6 +165,8 @@ namespace Ogre
         /// use the reflections if they were built for a different camera angle)
         bool  mHasPlanarReflections;
         uint8 mLastBoundPlanarReflection;
+        /// Same as mLastBoundPlanarReflection, for each slice (see setParallelCommandGeneration)
+        FastArray<uint8> mSliceLastBoundPlanarReflection;
 #endif
         TextureGpu             *mAreaLightMasks;
         HlmsSamplerblock const *mAreaLightMasksSamplerblock;
@@ -182,15 +184,11 @@ namespace Ogre
         TextureGpu             *mDecalsTextures[3];
         HlmsSamplerblock const *mDecalsSamplerblock;
 
-        ConstBufferPool::BufferPool const *mLastBoundPool;
-
         float mConstantBiasScale;
 
-        bool                        mHasSeparateSamplers;
-        DescriptorSetTexture const *mLastDescTexture;
-        DescriptorSetSampler const *mLastDescSampler;
-        uint8                       mReservedTexBufferSlots;  // Includes ReadOnly
-        uint8                       mReservedTexSlots;  // These get added to mReservedTexBufferSlots
+        bool  mHasSeparateSamplers;
+        uint8 mReservedTexBufferSlots;  // Includes ReadOnly
+        uint8 mReservedTexSlots;        // These get added to mReservedTexBufferSlots
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
         bool mFineLightMaskGranularity;
 #endif
@@ -240,10 +238,16 @@ namespace Ogre
 
         void destroyAllBuffers() override;
 
+        size_t getTexBufferBytesPerDraw( bool casterPass ) const override
+        {
+            return casterPass ? 64u : 128u;
+        }
+
+        /// sliceIdx is std::numeric_limits<size_t>::max() when called from the render thread
         FORCEINLINE uint32 fillBuffersFor( const HlmsCache        *cache,
                                            const QueuedRenderable &queuedRenderable, bool casterPass,
                                            uint32 lastCacheHash, CommandBuffer *commandBuffer,
-                                           bool isV1 );
+                                           bool isV1, size_t sliceIdx );
 
     public:
         HlmsPbs( Archive *dataFolder, ArchiveVec *libraryFolders );
@@ -267,6 +271,12 @@ namespace Ogre
                                  bool casterPass, uint32 lastCacheHash,
                                  CommandBuffer *commandBuffer ) override;
 
+        void   _beginParallelCommandGeneration( CommandBuffer *commandBuffer, bool casterPass,
+                                                size_t numSlices, const size_t *numRenderables ) override;
+        uint32 _fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass,
+                                       uint32 lastCacheHash, CommandBuffer *commandBuffer ) override;
+
         void postCommandBufferExecution( CommandBuffer *commandBuffer ) override;
         void frameEnded() override;
 
@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "OgreRay.h"
 #include "OgreSceneManager.h"
 #include "OgreTextureGpu.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Vao/OgreAsyncTicket.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreVertexArrayObject.h"
@@ -52,6 +53,85 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    /// BVH leaves hold up to this many triangles
+    static const uint32 c_maxTrianglesPerBvhLeaf = 4u;
+    /// Deep enough for the median split of 2^32 triangles
+    static const size_t c_maxBvhStackDepth = 64u;
+    /// Meshes hit by fewer rays are raycasted on the calling thread
+    static const size_t c_minRaysForWorkerThreads = 64u;
+
+    namespace
+    {
+        /// Raycasts the rays in InstantRadiosity::mRaycastJob
+        class InstantRadiosityRaycastTask : public UniformScalableTask
+        {
+            InstantRadiosity *mInstantRadiosity;
+
+        public:
+            InstantRadiosityRaycastTask( InstantRadiosity *instantRadiosity ) :
+                mInstantRadiosity( instantRadiosity )
+            {
+            }
+
+            void execute( size_t threadId, size_t numThreads ) override
+            {
+                mInstantRadiosity->_raycastJob( threadId, numThreads );
+            }
+        };
+
+        /** Same as ArrayRay::intersects, but takes the inverse of the direction (computed once per
+            packet) and also returns the distance at which each ray enters the box.
+        @remarks
+            The NaN-propagating min/max clamps tmin & tmax to the same value when the slabs don't
+            overlap, so unlike ArrayRay::intersects we require tmax > tmin. Otherwise most rays
+            would "hit" most nodes. This misses boxes with no volume, but BVH nodes are never flat.
+        */
+        inline ArrayMaskR intersectsBvhNode( const ArrayVector3 &origin, const ArrayVector3 &invDir,
+                                             const ArrayAabb &aabb, ArrayReal &outTmin )
+        {
+            ArrayVector3 intersectAtMinPlane = ( aabb.getMinimum() - origin ) * invDir;
+            ArrayVector3 intersectAtMaxPlane = ( aabb.getMaximum() - origin ) * invDir;
+
+            ArrayVector3 minIntersect = intersectAtMinPlane;
+            minIntersect.makeFloor( intersectAtMaxPlane );
+            ArrayVector3 maxIntersect = intersectAtMinPlane;
+            maxIntersect.makeCeil( intersectAtMaxPlane );
+
+            ArrayReal tmin, tmax;
+            tmin = minIntersect.mChunkBase[0];
+            tmax = maxIntersect.mChunkBase[0];
+
+#if OGRE_CPU == OGRE_CPU_ARM && OGRE_USE_SIMD == 1
+            tmin = Mathlib::Max( Mathlib::Max( minIntersect.mChunkBase[0], minIntersect.mChunkBase[1] ),
+                                 minIntersect.mChunkBase[2] );
+            tmax = Mathlib::Min( Mathlib::Min( maxIntersect.mChunkBase[0], maxIntersect.mChunkBase[1] ),
+                                 maxIntersect.mChunkBase[2] );
+#else
+            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[1], tmax ) );
+            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[1], tmin ) );
+
+            tmin = Mathlib::Max( tmin, Mathlib::Min( minIntersect.mChunkBase[2], tmax ) );
+            tmax = Mathlib::Min( tmax, Mathlib::Max( maxIntersect.mChunkBase[2], tmin ) );
+#endif
+            outTmin = tmin;
+            return Mathlib::CompareGreater( tmax, Mathlib::Max( tmin, ARRAY_REAL_ZERO ) );
+        }
+
+        /// Sorts triangles by their centroid along one axis
+        struct OrderTriangleByCentroid
+        {
+            float const *centroids;
+            size_t       axis;
+
+            bool operator()( uint32 _l, uint32 _r ) const
+            {
+                const float l = centroids[_l + axis];
+                const float r = centroids[_r + axis];
+                return l < r || ( l == r && _l < _r );
+            }
+        };
+    }  // namespace
+
     class RandomNumberGenerator
     {
         std::mt19937 mRng;
@@ -157,7 +237,8 @@ namespace Ogre
         mTotalNumRays( 0 ),
         mEnableDebugMarkers( false ),
         mUseTextures( true ),
-        mUseIrradianceVolume( false )
+        mUseIrradianceVolume( false ),
+        mDeterministicRaycast( false )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -879,6 +960,8 @@ namespace Ogre
             }
         }
 
+        buildBvh( meshData );
+
         mMeshDataMapV2[vao] = meshData;
 
         return &mMeshDataMapV2[vao];
@@ -1005,6 +1088,8 @@ namespace Ogre
                     renderOp.indexData->indexCount * renderOp.indexData->indexBuffer->getIndexSize() );
         }
 
+        buildBvh( meshData );
+
         mMeshDataMapV1[renderOp] = meshData;
 
         return &mMeshDataMapV1[renderOp];
@@ -1183,54 +1268,267 @@ namespace Ogre
                                                   Matrix4 worldMatrix, const MaterialData &material,
                                                   const FastArray<size_t> &raysThatHitObj )
     {
-        const size_t numElements = meshData.indexData ? meshData.numIndices : meshData.numVertices;
+        if( mDeterministicRaycast || !meshData.bvh )
+        {
+            raycastLightRayVsAllTriangles( lightRange, meshData, worldMatrix, material,
+                                           raysThatHitObj );
+            return;
+        }
 
-        const uint16 *RESTRICT_ALIAS indexData16 =
-            reinterpret_cast<const uint16 * RESTRICT_ALIAS>( meshData.indexData );
-        const uint32 *RESTRICT_ALIAS indexData32 =
-            reinterpret_cast<const uint32 * RESTRICT_ALIAS>( meshData.indexData );
+        mRaycastJob.lightRange = lightRange;
+        mRaycastJob.meshData = &meshData;
+        mRaycastJob.worldMatrix = worldMatrix;
+        mRaycastJob.invWorldMatrix = worldMatrix.inverseAffine();
+        mRaycastJob.material = &material;
+        mRaycastJob.raysThatHitObj = &raysThatHitObj;
+
+        // Each ray is only written by the thread that owns it, so the
+        // results don't depend on how many threads there are.
+        if( raysThatHitObj.size() >= c_minRaysForWorkerThreads && mSceneManager &&
+            mSceneManager->getNumWorkerThreads() > 1u )
+        {
+            InstantRadiosityRaycastTask task( this );
+            mSceneManager->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            raycastLightRaysVsBvh( 0u, raysThatHitObj.size() );
+        }
 
-        for( size_t i = 0; i < numElements; i += 3 )
+        mRaycastJob.meshData = 0;
+        mRaycastJob.material = 0;
+        mRaycastJob.raysThatHitObj = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::_raycastJob( size_t threadId, size_t numThreads )
+    {
+        // Split in whole packets
+        const size_t numRays = mRaycastJob.raysThatHitObj->size();
+        const size_t numPackets = ( numRays + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+
+        const size_t firstRay = ( threadId * numPackets / numThreads ) * ARRAY_PACKED_REALS;
+        const size_t lastRay =
+            std::min( ( ( threadId + 1u ) * numPackets / numThreads ) * ARRAY_PACKED_REALS, numRays );
+
+        if( firstRay < lastRay )
+            raycastLightRaysVsBvh( firstRay, lastRay );
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::_raycastMesh( const float *vertexPositions, size_t numVertices,
+                                         const void *indexData, size_t numIndices,
+                                         bool useIndices16bit, const Matrix4 &worldMatrix,
+                                         const Ray *rays, size_t numRays, Real maxDistance,
+                                         Real *outDistances, Vector3 *outTriVerts )
+    {
+        // Same layout as the meshes downloaded by build(), without UVs
+        FastArray<float> vertexData;
+        vertexData.appendPOD( vertexPositions, vertexPositions + numVertices * 3u );
+
+        MeshData meshData;
+        meshData.vertexData = vertexData.begin();
+        meshData.indexDataConst = reinterpret_cast<const uint8 *>( indexData );
+        meshData.numVertices = numVertices;
+        meshData.numIndices = numIndices;
+        meshData.useIndices16bit = useIndices16bit;
+        meshData.bvh = 0;
+        if( !mDeterministicRaycast )
+            buildBvh( meshData );
+
+        MaterialData material;
+        material.diffuse = Vector3::ZERO;
+        material.needsUv = false;
+        for( size_t i = 0; i < 5u; ++i )
         {
-            Vector3 triVerts[3];
+            material.image[i] = 0;
+            material.uvSet[i] = 0;
+        }
 
-            uint32 vertexIdx[3];
+        // Don't disturb the rays of a previous build()
+        RayHitVec savedRayHits;
+        savedRayHits.swap( mRayHits );
 
-            if( meshData.indexData )
+        mRayHits.resize( numRays );
+        FastArray<size_t> raysThatHitObj;
+        raysThatHitObj.resizePOD( numRays );
+        for( size_t i = 0; i < numRays; ++i )
+        {
+            mRayHits[i].ray = rays[i];
+            mRayHits[i].distance = maxDistance;
+            mRayHits[i].accumDistance = 0;
+            raysThatHitObj[i] = i;
+        }
+
+        raycastLightRayVsMesh( maxDistance, meshData, worldMatrix, material, raysThatHitObj );
+
+        for( size_t i = 0; i < numRays; ++i )
+        {
+            outDistances[i] = mRayHits[i].distance;
+            if( mRayHits[i].distance < maxDistance )
+            {
+                outTriVerts[i * 3u + 0u] = mRayHits[i].triVerts[0];
+                outTriVerts[i * 3u + 1u] = mRayHits[i].triVerts[1];
+                outTriVerts[i * 3u + 2u] = mRayHits[i].triVerts[2];
+            }
+        }
+
+        mRayHits.swap( savedRayHits );
+        OGRE_DELETE_T( meshData.bvh, MeshBvh, MEMCATEGORY_GEOMETRY );
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycastLightRaysVsBvh( size_t firstRay, size_t lastRay )
+    {
+        const RaycastJob &job = mRaycastJob;
+        const MeshData &meshData = *job.meshData;
+        const MeshBvh &bvh = *meshData.bvh;
+        const FastArray<size_t> &raysThatHitObj = *job.raysThatHitObj;
+
+        const uint32 c_noTriangle = std::numeric_limits<uint32>::max();
+
+        ArrayAabb nodeAabb( ArrayVector3::ZERO, ArrayVector3::ZERO );
+        uint32 nodeStack[c_maxBvhStackDepth];
+
+        for( size_t i = firstRay; i < lastRay; i += ARRAY_PACKED_REALS )
+        {
+            const size_t raysInPacket = std::min<size_t>( ARRAY_PACKED_REALS, lastRay - i );
+            const uint32 packetMask = ( 1u << raysInPacket ) - 1u;
+
+            // Rays in object space, to traverse the BVH. Unused lanes repeat the last ray.
+            // The direction isn't normalized so distances along the ray are the same in
+            // object & world space.
+            ArrayVector3 packetOrigin;
+            ArrayVector3 packetDir;
+            OGRE_SIMD_ALIGNED_DECL( Real, bestDistance[ARRAY_PACKED_REALS] );
+            uint32 bestTriangle[ARRAY_PACKED_REALS];
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                const RayHit &rayHit = mRayHits[raysThatHitObj[i + std::min( j, raysInPacket - 1u )]];
+                packetOrigin.setFromVector3(
+                    job.invWorldMatrix.transformAffine( rayHit.ray.getOrigin() ), j );
+                packetDir.setFromVector3(
+                    job.invWorldMatrix.transformDirectionAffine( rayHit.ray.getDirection() ), j );
+                bestDistance[j] = rayHit.distance;
+                bestTriangle[j] = c_noTriangle;
+            }
+
+            const ArrayVector3 packetInvDir = Mathlib::SetAll( 1.0f ) / packetDir;
+            // Used to pick which child to visit first
+            const Vector3 firstRayDir = packetDir.getAsVector3( 0u );
+
+            size_t stackSize = 0;
+            nodeStack[stackSize++] = 0u;
+
+            while( stackSize > 0u )
             {
-                if( meshData.useIndices16bit )
+                const MeshBvh::Node &node = bvh.nodes[nodeStack[--stackSize]];
+
+                // Skip the rays that miss the node, or that already hit something closer.
+                // Nodes are slightly bigger than their triangles, so rays enter them
+                // before reaching any distance we may still need to consider.
+                nodeAabb.setAll( node.aabb );
+                ArrayReal tmin;
+                const ArrayMaskR hitsNode =
+                    intersectsBvhNode( packetOrigin, packetInvDir, nodeAabb, tmin );
+                const ArrayMaskR notFarther = Mathlib::CompareLessEqual(
+                    tmin, *reinterpret_cast<const ArrayReal *>( bestDistance ) );
+                const uint32 hitMask = BooleanMask4::getScalarMask( hitsNode ) &
+                                       BooleanMask4::getScalarMask( notFarther ) & packetMask;
+
+                if( !hitMask )
+                    continue;
+
+                if( node.numTriangles == 0u )
                 {
-                    vertexIdx[0] = indexData16[i + 0];
-                    vertexIdx[1] = indexData16[i + 1];
-                    vertexIdx[2] = indexData16[i + 2];
+                    // Front to back, so that closer hits cull the farther child
+                    const uint32 firstChild = node.firstChildOrTriangle;
+                    const Vector3 childDir = bvh.nodes[firstChild + 1u].aabb.mCenter -
+                                             bvh.nodes[firstChild].aabb.mCenter;
+                    const uint32 nearChild = childDir.dotProduct( firstRayDir ) >= 0 ? 0u : 1u;
+                    nodeStack[stackSize++] = firstChild + ( 1u - nearChild );
+                    nodeStack[stackSize++] = firstChild + nearChild;
+                    continue;
                 }
-                else
+
+                for( uint32 k = 0; k < node.numTriangles; ++k )
                 {
-                    vertexIdx[0] = indexData32[i + 0];
-                    vertexIdx[1] = indexData32[i + 1];
-                    vertexIdx[2] = indexData32[i + 2];
+                    const uint32 triangle = bvh.triangles[node.firstChildOrTriangle + k];
+
+                    // Same math as raycastLightRayVsAllTriangles, so that hits are identical
+                    uint32 vertexIdx[3];
+                    meshData.getTriangle( triangle, vertexIdx );
+
+                    Vector3 triVerts[3];
+                    triVerts[0] = job.worldMatrix * meshData.getPosition( vertexIdx[0] );
+                    triVerts[1] = job.worldMatrix * meshData.getPosition( vertexIdx[1] );
+                    triVerts[2] = job.worldMatrix * meshData.getPosition( vertexIdx[2] );
+
+                    Vector3 triNormal = Math::calculateBasicFaceNormalWithoutNormalize(
+                        triVerts[0], triVerts[1], triVerts[2] );
+                    triNormal.normalise();
+
+                    for( size_t j = 0; j < raysInPacket; ++j )
+                    {
+                        if( !IS_BIT_SET( j, hitMask ) )
+                            continue;
+
+                        Ray ray = mRayHits[raysThatHitObj[i + j]].ray;
+
+                        const std::pair<bool, Real> inters = Math::intersects(
+                            ray, triVerts[0], triVerts[1], triVerts[2], triNormal, true, false );
+
+                        // The reference implementation keeps the first triangle with the
+                        // closest distance, and never replaces an equally distant previous hit
+                        if( inters.first && inters.second <= job.lightRange &&
+                            ( inters.second < bestDistance[j] ||
+                              ( inters.second == bestDistance[j] && bestTriangle[j] != c_noTriangle &&
+                                triangle < bestTriangle[j] ) ) )
+                        {
+                            bestDistance[j] = inters.second;
+                            bestTriangle[j] = triangle;
+                        }
+                    }
                 }
             }
-            else
+
+            for( size_t j = 0; j < raysInPacket; ++j )
             {
-                vertexIdx[0] = uint32( i + 0u );
-                vertexIdx[1] = uint32( i + 1u );
-                vertexIdx[2] = uint32( i + 2u );
+                if( bestTriangle[j] == c_noTriangle )
+                    continue;
+
+                uint32 vertexIdx[3];
+                meshData.getTriangle( bestTriangle[j], vertexIdx );
+
+                Vector3 triVerts[3];
+                triVerts[0] = job.worldMatrix * meshData.getPosition( vertexIdx[0] );
+                triVerts[1] = job.worldMatrix * meshData.getPosition( vertexIdx[1] );
+                triVerts[2] = job.worldMatrix * meshData.getPosition( vertexIdx[2] );
+
+                Vector3 triNormal = Math::calculateBasicFaceNormalWithoutNormalize(
+                    triVerts[0], triVerts[1], triVerts[2] );
+                triNormal.normalise();
+
+                setRayHit( mRayHits[raysThatHitObj[i + j]], bestDistance[j], meshData, *job.material,
+                           triVerts, triNormal, vertexIdx );
             }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycastLightRayVsAllTriangles( Real lightRange, const MeshData &meshData,
+                                                          const Matrix4 &worldMatrix,
+                                                          const MaterialData &material,
+                                                          const FastArray<size_t> &raysThatHitObj )
+    {
+        const size_t numElements = meshData.indexData ? meshData.numIndices : meshData.numVertices;
+
+        for( size_t i = 0; i < numElements; i += 3 )
+        {
+            Vector3 triVerts[3];
 
-            triVerts[0].x = meshData.vertexData[vertexIdx[0] * 3u + 0];
-            triVerts[0].y = meshData.vertexData[vertexIdx[0] * 3u + 1];
-            triVerts[0].z = meshData.vertexData[vertexIdx[0] * 3u + 2];
-            triVerts[1].x = meshData.vertexData[vertexIdx[1] * 3u + 0];
-            triVerts[1].y = meshData.vertexData[vertexIdx[1] * 3u + 1];
-            triVerts[1].z = meshData.vertexData[vertexIdx[1] * 3u + 2];
-            triVerts[2].x = meshData.vertexData[vertexIdx[2] * 3u + 0];
-            triVerts[2].y = meshData.vertexData[vertexIdx[2] * 3u + 1];
-            triVerts[2].z = meshData.vertexData[vertexIdx[2] * 3u + 2];
+            uint32 vertexIdx[3];
+            meshData.getTriangle( i, vertexIdx );
 
-            triVerts[0] = worldMatrix * triVerts[0];
-            triVerts[1] = worldMatrix * triVerts[1];
-            triVerts[2] = worldMatrix * triVerts[2];
+            triVerts[0] = worldMatrix * meshData.getPosition( vertexIdx[0] );
+            triVerts[1] = worldMatrix * meshData.getPosition( vertexIdx[1] );
+            triVerts[2] = worldMatrix * meshData.getPosition( vertexIdx[2] );
 
             Vector3 triNormal =
                 Math::calculateBasicFaceNormalWithoutNormalize( triVerts[0], triVerts[1], triVerts[2] );
@@ -1250,26 +1548,8 @@ namespace Ogre
                     RayHit &rayHit = mRayHits[*itRayIdx];
                     if( inters.second < rayHit.distance && inters.second <= lightRange )
                     {
-                        rayHit.distance = inters.second;
-                        rayHit.material = material;
-                        rayHit.triVerts[0] = triVerts[0];
-                        rayHit.triVerts[1] = triVerts[1];
-                        rayHit.triVerts[2] = triVerts[2];
-                        rayHit.triNormal = triNormal;
-
-                        for( int j = 0; j < 5 && material.image[j]; ++j )
-                        {
-                            const uint8 uvSet = material.uvSet[j];
-                            const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
-                            rayHit.triUVs[j][0].x = uvPtr[vertexIdx[0] * 2u + 0];
-                            rayHit.triUVs[j][0].y = uvPtr[vertexIdx[0] * 2u + 1];
-
-                            rayHit.triUVs[j][1].x = uvPtr[vertexIdx[1] * 2u + 0];
-                            rayHit.triUVs[j][1].y = uvPtr[vertexIdx[1] * 2u + 1];
-
-                            rayHit.triUVs[j][2].x = uvPtr[vertexIdx[2] * 2u + 0];
-                            rayHit.triUVs[j][2].y = uvPtr[vertexIdx[2] * 2u + 1];
-                        }
+                        setRayHit( rayHit, inters.second, meshData, material, triVerts, triNormal,
+                                   vertexIdx );
                     }
                 }
 
@@ -1278,6 +1558,189 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::setRayHit( RayHit &rayHit, Real distance, const MeshData &meshData,
+                                      const MaterialData &material, const Vector3 triVerts[3],
+                                      const Vector3 &triNormal, const uint32 vertexIdx[3] )
+    {
+        rayHit.distance = distance;
+        rayHit.material = material;
+        rayHit.triVerts[0] = triVerts[0];
+        rayHit.triVerts[1] = triVerts[1];
+        rayHit.triVerts[2] = triVerts[2];
+        rayHit.triNormal = triNormal;
+
+        for( int j = 0; j < 5 && material.image[j]; ++j )
+        {
+            const uint8 uvSet = material.uvSet[j];
+            const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
+            rayHit.triUVs[j][0].x = uvPtr[vertexIdx[0] * 2u + 0];
+            rayHit.triUVs[j][0].y = uvPtr[vertexIdx[0] * 2u + 1];
+
+            rayHit.triUVs[j][1].x = uvPtr[vertexIdx[1] * 2u + 0];
+            rayHit.triUVs[j][1].y = uvPtr[vertexIdx[1] * 2u + 1];
+
+            rayHit.triUVs[j][2].x = uvPtr[vertexIdx[2] * 2u + 0];
+            rayHit.triUVs[j][2].y = uvPtr[vertexIdx[2] * 2u + 1];
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::buildBvh( MeshData &meshData )
+    {
+        MeshBvh *bvh = OGRE_NEW_T( MeshBvh, MEMCATEGORY_GEOMETRY )();
+        meshData.bvh = bvh;
+
+        const size_t numElements = meshData.indexData ? meshData.numIndices : meshData.numVertices;
+        const uint32 numTriangles = static_cast<uint32>( numElements / 3u );
+
+        if( numTriangles == 0u )
+        {
+            // Empty leaf as root. Nothing will be hit.
+            MeshBvh::Node root;
+            root.aabb = Aabb::BOX_NULL;
+            root.firstChildOrTriangle = 0u;
+            root.numTriangles = 0u;
+            bvh->nodes.push_back( root );
+            return;
+        }
+
+        // Per triangle bounds & centroids, indexed by the triangle's first element
+        FastArray<float> centroids;
+        FastArray<Vector3> triMin;
+        FastArray<Vector3> triMax;
+        centroids.resizePOD( numTriangles * 3u );
+        triMin.resizePOD( numTriangles );
+        triMax.resizePOD( numTriangles );
+        bvh->triangles.resizePOD( numTriangles );
+
+        Vector3 meshMin( std::numeric_limits<Real>::max() );
+        Vector3 meshMax( -std::numeric_limits<Real>::max() );
+
+        for( uint32 i = 0; i < numTriangles; ++i )
+        {
+            uint32 vertexIdx[3];
+            meshData.getTriangle( i * 3u, vertexIdx );
+
+            const Vector3 v0 = meshData.getPosition( vertexIdx[0] );
+            const Vector3 v1 = meshData.getPosition( vertexIdx[1] );
+            const Vector3 v2 = meshData.getPosition( vertexIdx[2] );
+
+            triMin[i] = v0;
+            triMin[i].makeFloor( v1 );
+            triMin[i].makeFloor( v2 );
+            triMax[i] = v0;
+            triMax[i].makeCeil( v1 );
+            triMax[i].makeCeil( v2 );
+
+            const Vector3 centroid = ( triMin[i] + triMax[i] ) * 0.5f;
+            centroids[i * 3u + 0u] = centroid.x;
+            centroids[i * 3u + 1u] = centroid.y;
+            centroids[i * 3u + 2u] = centroid.z;
+
+            meshMin.makeFloor( triMin[i] );
+            meshMax.makeCeil( triMax[i] );
+
+            bvh->triangles[i] = i * 3u;
+        }
+
+        // Rays are transformed to object space to traverse the BVH, while triangles are
+        // transformed to world space to be intersected. Grow the nodes a little so that
+        // rounding differences between both can't make a ray skip a triangle it hits.
+        // This also ensures no node is flat (e.g. a floor made of a single quad).
+        Real maxAbsCoord = 0;
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            maxAbsCoord = std::max( maxAbsCoord,
+                                    std::max( Math::Abs( meshMin[i] ), Math::Abs( meshMax[i] ) ) );
+        }
+        const Real epsilon = std::max(
+            std::max( ( meshMax - meshMin ).length(), maxAbsCoord ) * Real( 1e-4 ), Real( 1e-6 ) );
+
+        struct BuildEntry
+        {
+            uint32 nodeIdx;
+            uint32 start;
+            uint32 count;
+        };
+
+        FastArray<BuildEntry> buildStack;
+        {
+            MeshBvh::Node root;
+            root.firstChildOrTriangle = 0u;
+            root.numTriangles = 0u;
+            bvh->nodes.push_back( root );
+
+            const BuildEntry rootEntry = { 0u, 0u, numTriangles };
+            buildStack.push_back( rootEntry );
+        }
+
+        uint32 *RESTRICT_ALIAS triangles = bvh->triangles.begin();
+
+        while( !buildStack.empty() )
+        {
+            const BuildEntry entry = buildStack.back();
+            buildStack.pop_back();
+
+            Vector3 nodeMin( std::numeric_limits<Real>::max() );
+            Vector3 nodeMax( -std::numeric_limits<Real>::max() );
+            Vector3 centroidMin( std::numeric_limits<Real>::max() );
+            Vector3 centroidMax( -std::numeric_limits<Real>::max() );
+
+            for( uint32 i = entry.start; i < entry.start + entry.count; ++i )
+            {
+                const uint32 triIdx = triangles[i] / 3u;
+                nodeMin.makeFloor( triMin[triIdx] );
+                nodeMax.makeCeil( triMax[triIdx] );
+
+                const Vector3 centroid( centroids[triangles[i] + 0u], centroids[triangles[i] + 1u],
+                                        centroids[triangles[i] + 2u] );
+                centroidMin.makeFloor( centroid );
+                centroidMax.makeCeil( centroid );
+            }
+
+            MeshBvh::Node &node = bvh->nodes[entry.nodeIdx];
+            node.aabb = Aabb::newFromExtents( nodeMin - epsilon, nodeMax + epsilon );
+
+            if( entry.count <= c_maxTrianglesPerBvhLeaf )
+            {
+                node.firstChildOrTriangle = entry.start;
+                node.numTriangles = entry.count;
+                continue;
+            }
+
+            // Median split along the axis where the centroids are most spread
+            const Vector3 centroidSize = centroidMax - centroidMin;
+            size_t axis = 0u;
+            if( centroidSize.y > centroidSize[axis] )
+                axis = 1u;
+            if( centroidSize.z > centroidSize[axis] )
+                axis = 2u;
+
+            const uint32 half = entry.count / 2u;
+
+            OrderTriangleByCentroid orderTriangles;
+            orderTriangles.centroids = centroids.begin();
+            orderTriangles.axis = axis;
+            std::nth_element( triangles + entry.start, triangles + entry.start + half,
+                              triangles + entry.start + entry.count, orderTriangles );
+
+            const uint32 firstChild = static_cast<uint32>( bvh->nodes.size() );
+            node.firstChildOrTriangle = firstChild;
+            node.numTriangles = 0u;
+
+            // Careful: 'node' is invalidated from here on
+            MeshBvh::Node child;
+            child.firstChildOrTriangle = 0u;
+            child.numTriangles = 0u;
+            bvh->nodes.push_back( child );
+            bvh->nodes.push_back( child );
+
+            const BuildEntry leftEntry = { firstChild, entry.start, half };
+            const BuildEntry rightEntry = { firstChild + 1u, entry.start + half, entry.count - half };
+            buildStack.push_back( rightEntry );
+            buildStack.push_back( leftEntry );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::updateExistingVpls()
     {
         SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
@@ -1491,6 +1954,8 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_DELETE_T( meshData.bvh, MeshBvh, MEMCATEGORY_GEOMETRY );
+                meshData.bvh = 0;
                 if( meshData.indexData && !itor->first->getIndexBuffer()->getShadowCopy() )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1510,6 +1975,8 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_DELETE_T( meshData.bvh, MeshBvh, MEMCATEGORY_GEOMETRY );
+                meshData.bvh = 0;
                 if( meshData.indexData )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1587,6 +2054,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void InstantRadiosity::destroyDebugMarkers()
     {
+        if( mDebugMarkers.empty() )
+            return;
+
         Hlms *hlms = mHlmsManager->getHlms( HLMS_UNLIT );
 
         vector<Item *>::type::const_iterator itor = mDebugMarkers.begin();
@@ -1625,6 +2095,11 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::setDeterministicRaycast( bool bDeterministic )
+    {
+        mDeterministicRaycast = bDeterministic;
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::setUseIrradianceVolume( bool bUseIrradianceVolume )
     {
         if( bUseIrradianceVolume != mUseIrradianceVolume )
@@ -1894,4 +2369,39 @@ namespace Ogre
     {
         return vertexData + numVertices * 3u + uvSet * 2u;
     }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::MeshData::getTriangle( size_t firstElement, uint32 outVertexIdx[3] ) const
+    {
+        if( indexData )
+        {
+            if( useIndices16bit )
+            {
+                const uint16 *RESTRICT_ALIAS indexData16 =
+                    reinterpret_cast<const uint16 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData16[firstElement + 0u];
+                outVertexIdx[1] = indexData16[firstElement + 1u];
+                outVertexIdx[2] = indexData16[firstElement + 2u];
+            }
+            else
+            {
+                const uint32 *RESTRICT_ALIAS indexData32 =
+                    reinterpret_cast<const uint32 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData32[firstElement + 0u];
+                outVertexIdx[1] = indexData32[firstElement + 1u];
+                outVertexIdx[2] = indexData32[firstElement + 2u];
+            }
+        }
+        else
+        {
+            outVertexIdx[0] = uint32( firstElement + 0u );
+            outVertexIdx[1] = uint32( firstElement + 1u );
+            outVertexIdx[2] = uint32( firstElement + 2u );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    Vector3 InstantRadiosity::MeshData::getPosition( uint32 vertexIdx ) const
+    {
+        return Vector3( vertexData[vertexIdx * 3u + 0u], vertexData[vertexIdx * 3u + 1u],
+                        vertexData[vertexIdx * 3u + 2u] );
+    }
 }  // namespace Ogre
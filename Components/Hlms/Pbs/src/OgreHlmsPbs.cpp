@@ -297,11 +297,8 @@ namespace Ogre
         mLtcMatrixTexture( 0 ),
         mDecalsDiffuseMergedEmissive( false ),
         mDecalsSamplerblock( 0 ),
-        mLastBoundPool( 0 ),
         mConstantBiasScale( 0.1f ),
         mHasSeparateSamplers( 0 ),
-        mLastDescTexture( 0 ),
-        mLastDescSampler( 0 ),
         mReservedTexBufferSlots( 1u ),  // Vertex shader consumes 1 slot with its tbuffer.
         mReservedTexSlots( 0u ),
 #if !OGRE_NO_FINE_LIGHT_MASK_GRANULARITY
@@ -2831,9 +2828,9 @@ namespace Ogre
             mTexBuffers.push_back( newBuffer );
         }
 
-        mLastDescTexture = 0;
-        mLastDescSampler = 0;
-        mLastBoundPool = 0;
+        mMainState.lastDescTexture = 0;
+        mMainState.lastDescSampler = 0;
+        mMainState.lastBoundPool = 0;
 
         if( mShadowFilter == ExponentialShadowMaps )
             mCurrentShadowmapSamplerblock = mShadowmapEsmSamplerblock;
@@ -2925,7 +2922,8 @@ namespace Ogre
                                       bool casterPass, uint32 lastCacheHash,
                                       CommandBuffer *commandBuffer )
     {
-        return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer, true );
+        return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer, true,
+                               std::numeric_limits<size_t>::max() );
     }
     //-----------------------------------------------------------------------------------
     uint32 HlmsPbs::fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
@@ -2933,17 +2931,59 @@ namespace Ogre
                                       CommandBuffer *commandBuffer )
     {
         return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer,
-                               false );
+                               false, std::numeric_limits<size_t>::max() );
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsPbs::_fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                            const QueuedRenderable &queuedRenderable, bool casterPass,
+                                            uint32 lastCacheHash, CommandBuffer *commandBuffer )
+    {
+        MappedState &state = mSliceStates[sliceIdx];
+        const MappedState prevState = state;
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+        const uint8 prevBoundPlanarReflection = mSliceLastBoundPlanarReflection[sliceIdx];
+#endif
+
+        const uint32 retVal = fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash,
+                                              commandBuffer, false, sliceIdx );
+
+        if( retVal == c_retryFillInRenderThread )
+        {
+            // RenderQueue discards the commands we've recorded. See Hlms::_fillBuffersForV2Slice
+            state = prevState;
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+            mSliceLastBoundPlanarReflection[sliceIdx] = prevBoundPlanarReflection;
+#endif
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPbs::_beginParallelCommandGeneration( CommandBuffer *commandBuffer, bool casterPass,
+                                                   size_t numSlices, const size_t *numRenderables )
+    {
+        HlmsBufferManager::_beginParallelCommandGeneration( commandBuffer, casterPass, numSlices,
+                                                            numRenderables );
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+        mSliceLastBoundPlanarReflection.resizePOD( numSlices, 0u );
+#endif
     }
     //-----------------------------------------------------------------------------------
     uint32 HlmsPbs::fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
                                     bool casterPass, uint32 lastCacheHash, CommandBuffer *commandBuffer,
-                                    bool isV1 )
+                                    bool isV1, size_t sliceIdx )
     {
         assert( dynamic_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() ) );
         const HlmsPbsDatablock *datablock =
             static_cast<const HlmsPbsDatablock *>( queuedRenderable.renderable->getDatablock() );
 
+        const bool isSlice = sliceIdx != std::numeric_limits<size_t>::max();
+        MappedState &state = isSlice ? mSliceStates[sliceIdx] : mMainState;
+#ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
+        uint8 &lastBoundPlanarReflection =
+            isSlice ? mSliceLastBoundPlanarReflection[sliceIdx] : mLastBoundPlanarReflection;
+#endif
+
         if( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( lastCacheHash ) != mType )
         {
             // layout(binding = 0) uniform PassBuffer {} pass
@@ -3120,32 +3160,32 @@ namespace Ogre
                 }
             }
 
-            mLastDescTexture = 0;
-            mLastDescSampler = 0;
-            mLastBoundPool = 0;
+            state.lastDescTexture = 0;
+            state.lastDescSampler = 0;
+            state.lastBoundPool = 0;
 
             // layout(binding = 2) uniform InstanceBuffer {} instance
-            if( mCurrentConstBuffer < mConstBuffers.size() &&
-                (size_t)( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) + 4 ) <=
-                    mCurrentConstBufferSize )
+            if( state.currentConstBuffer < mConstBuffers.size() &&
+                (size_t)( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) + 4 ) <=
+                    state.currentConstBufferSize )
             {
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( VertexShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( VertexShader, 2, mConstBuffers[state.currentConstBuffer], 0, 0 );
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( PixelShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( PixelShader, 2, mConstBuffers[state.currentConstBuffer], 0, 0 );
             }
 
-            rebindTexBuffer( commandBuffer );
+            rebindTexBuffer( state, commandBuffer );
 
 #ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
-            mLastBoundPlanarReflection = 0u;
+            lastBoundPlanarReflection = 0u;
 #endif
             mListener->hlmsTypeChanged( casterPass, commandBuffer, datablock, texUnit );
         }
 
         // Don't bind the material buffer on caster passes (important to keep
         // MDI & auto-instancing running on shadow map passes)
-        if( mLastBoundPool != datablock->getAssignedPool() &&
+        if( state.lastBoundPool != datablock->getAssignedPool() &&
             ( !casterPass || datablock->getAlphaTest() != CMPF_ALWAYS_PASS ) )
         {
             // layout(binding = 1) uniform MaterialBuf {} materialArray
@@ -3166,11 +3206,11 @@ namespace Ogre
                 *commandBuffer->addCommand<CbShaderBuffer>() =
                     CbShaderBuffer( PixelShader, 3, probeConstBuf, 0, 0 );
             }
-            mLastBoundPool = newPool;
+            state.lastBoundPool = newPool;
         }
 
-        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mCurrentMappedConstBuffer;
-        float *RESTRICT_ALIAS currentMappedTexBuffer = mCurrentMappedTexBuffer;
+        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = state.currentMappedConstBuffer;
+        float *RESTRICT_ALIAS currentMappedTexBuffer = state.currentMappedTexBuffer;
 
         bool hasSkeletonAnimation = queuedRenderable.renderable->hasSkeletonAnimation();
         uint32 numPoses = queuedRenderable.renderable->getNumPoses();
@@ -3187,28 +3227,28 @@ namespace Ogre
             // We need to correct currentMappedConstBuffer to point to the right texture buffer's
             // offset, which may not be in sync if the previous draw had skeletal and/or pose animation.
             const size_t currentConstOffset =
-                static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) >>
+                static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) >>
                 ( 2u + !casterPass );
-            currentMappedConstBuffer = currentConstOffset + mStartMappedConstBuffer;
+            currentMappedConstBuffer = currentConstOffset + state.startMappedConstBuffer;
             bool exceedsConstBuffer =
-                static_cast<size_t>( ( currentMappedConstBuffer - mStartMappedConstBuffer ) + 4u ) >
-                mCurrentConstBufferSize;
+                static_cast<size_t>( ( currentMappedConstBuffer - state.startMappedConstBuffer ) +
+                                     4u ) > state.currentConstBufferSize;
 
             const size_t minimumTexBufferSize = 16u * ( 1u + !casterPass );
             bool exceedsTexBuffer =
-                ( static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) +
-                  minimumTexBufferSize ) >= mCurrentTexBufferSize;
+                ( static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) +
+                  minimumTexBufferSize ) >= state.currentTexBufferSize;
 
             if( exceedsConstBuffer || exceedsTexBuffer )
             {
-                currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
-
-                if( exceedsTexBuffer )
-                    mapNextTexBuffer( commandBuffer, minimumTexBufferSize * sizeof( float ) );
-                else
-                    rebindTexBuffer( commandBuffer, true, minimumTexBufferSize * sizeof( float ) );
+                if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                     minimumTexBufferSize * sizeof( float ) ) )
+                {
+                    return c_retryFillInRenderThread;
+                }
 
-                currentMappedTexBuffer = mCurrentMappedTexBuffer;
+                currentMappedConstBuffer = state.currentMappedConstBuffer;
+                currentMappedTexBuffer = state.currentMappedTexBuffer;
             }
 
             // uint worldMaterialIdx[]
@@ -3249,8 +3289,9 @@ namespace Ogre
         }
         else
         {
-            bool exceedsConstBuffer = (size_t)( ( currentMappedConstBuffer - mStartMappedConstBuffer ) +
-                                                4 ) > mCurrentConstBufferSize;
+            bool exceedsConstBuffer =
+                (size_t)( ( currentMappedConstBuffer - state.startMappedConstBuffer ) + 4 ) >
+                state.currentConstBufferSize;
 
             if( hasSkeletonAnimation )
             {
@@ -3262,26 +3303,26 @@ namespace Ogre
                     const size_t poseDataSize = numPoses > 0u ? ( 4u + poseWeightsNumFloats ) : 0u;
                     const size_t minimumTexBufferSize = 12 * numWorldTransforms + poseDataSize;
                     const bool exceedsTexBuffer =
-                        static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) +
+                        static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) +
                             minimumTexBufferSize >=
-                        mCurrentTexBufferSize;
+                        state.currentTexBufferSize;
 
                     if( exceedsConstBuffer || exceedsTexBuffer )
                     {
-                        currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
-
-                        if( exceedsTexBuffer )
-                            mapNextTexBuffer( commandBuffer, minimumTexBufferSize * sizeof( float ) );
-                        else
-                            rebindTexBuffer( commandBuffer, true,
-                                             minimumTexBufferSize * sizeof( float ) );
+                        if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                             minimumTexBufferSize * sizeof( float ) ) )
+                        {
+                            return c_retryFillInRenderThread;
+                        }
 
-                        currentMappedTexBuffer = mCurrentMappedTexBuffer;
+                        currentMappedConstBuffer = state.currentMappedConstBuffer;
+                        currentMappedTexBuffer = state.currentMappedTexBuffer;
                     }
 
                     // uint worldMaterialIdx[]
                     size_t distToWorldMatStart =
-                        static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
+                        static_cast<size_t>( state.currentMappedTexBuffer -
+                                             state.startMappedTexBuffer );
                     distToWorldMatStart >>= 2;
                     *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
                                                         ( datablock->getAssignedSlot() & 0x1FF ) );
@@ -3323,26 +3364,26 @@ namespace Ogre
                     const size_t poseDataSize = numPoses > 0u ? ( 4u + poseWeightsNumFloats ) : 0u;
                     const size_t minimumTexBufferSize = 12 * indexMap->size() + poseDataSize;
                     bool exceedsTexBuffer =
-                        static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) +
+                        static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) +
                             minimumTexBufferSize >=
-                        mCurrentTexBufferSize;
+                        state.currentTexBufferSize;
 
                     if( exceedsConstBuffer || exceedsTexBuffer )
                     {
-                        currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
-
-                        if( exceedsTexBuffer )
-                            mapNextTexBuffer( commandBuffer, minimumTexBufferSize * sizeof( float ) );
-                        else
-                            rebindTexBuffer( commandBuffer, true,
-                                             minimumTexBufferSize * sizeof( float ) );
+                        if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                             minimumTexBufferSize * sizeof( float ) ) )
+                        {
+                            return c_retryFillInRenderThread;
+                        }
 
-                        currentMappedTexBuffer = mCurrentMappedTexBuffer;
+                        currentMappedConstBuffer = state.currentMappedConstBuffer;
+                        currentMappedTexBuffer = state.currentMappedTexBuffer;
                     }
 
                     // uint worldMaterialIdx[]
                     size_t distToWorldMatStart =
-                        static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
+                        static_cast<size_t>( state.currentMappedTexBuffer -
+                                             state.startMappedTexBuffer );
                     distToWorldMatStart >>= 2;
                     *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
                                                         ( datablock->getAssignedSlot() & 0x1FF ) );
@@ -3370,26 +3411,26 @@ namespace Ogre
                     // the weight of each pose, 3 vec4's for worldMat, and 4 vec4's for worldView.
                     const size_t minimumTexBufferSize = 4 + poseWeightsNumFloats + 3 * 4 + 4 * 4;
                     bool exceedsTexBuffer =
-                        static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) +
+                        static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) +
                             minimumTexBufferSize >=
-                        mCurrentTexBufferSize;
+                        state.currentTexBufferSize;
 
                     if( exceedsConstBuffer || exceedsTexBuffer )
                     {
-                        currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
-
-                        if( exceedsTexBuffer )
-                            mapNextTexBuffer( commandBuffer, minimumTexBufferSize * sizeof( float ) );
-                        else
-                            rebindTexBuffer( commandBuffer, true,
-                                             minimumTexBufferSize * sizeof( float ) );
+                        if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                             minimumTexBufferSize * sizeof( float ) ) )
+                        {
+                            return c_retryFillInRenderThread;
+                        }
 
-                        currentMappedTexBuffer = mCurrentMappedTexBuffer;
+                        currentMappedConstBuffer = state.currentMappedConstBuffer;
+                        currentMappedTexBuffer = state.currentMappedTexBuffer;
                     }
 
                     // uint worldMaterialIdx[]
                     size_t distToWorldMatStart =
-                        static_cast<size_t>( mCurrentMappedTexBuffer - mStartMappedTexBuffer );
+                        static_cast<size_t>( state.currentMappedTexBuffer -
+                                             state.startMappedTexBuffer );
                     distToWorldMatStart >>= 2;
                     *currentMappedConstBuffer = uint32( ( distToWorldMatStart << 9 ) |
                                                         ( datablock->getAssignedSlot() & 0x1FF ) );
@@ -3465,11 +3506,12 @@ namespace Ogre
             // currentMappedTexBuffer to be 16/32-byte aligned.
             // Non-skeletally animated objects are far more common than skeletal ones,
             // so we do this here instead of doing it before rendering the non-skeletal ones.
-            size_t currentConstOffset = (size_t)( currentMappedTexBuffer - mStartMappedTexBuffer );
+            size_t currentConstOffset =
+                (size_t)( currentMappedTexBuffer - state.startMappedTexBuffer );
             currentConstOffset =
                 alignToNextMultiple<size_t>( currentConstOffset, 16 + 16 * !casterPass );
-            currentConstOffset = std::min( currentConstOffset, mCurrentTexBufferSize );
-            currentMappedTexBuffer = mStartMappedTexBuffer + currentConstOffset;
+            currentConstOffset = std::min( currentConstOffset, state.currentTexBufferSize );
+            currentMappedTexBuffer = state.startMappedTexBuffer + currentConstOffset;
         }
 
         *reinterpret_cast<float * RESTRICT_ALIAS>( currentMappedConstBuffer + 1 ) =
@@ -3491,16 +3533,16 @@ namespace Ogre
 #ifdef OGRE_BUILD_COMPONENT_PLANAR_REFLECTIONS
             if( !casterPass && mHasPlanarReflections &&
                 ( queuedRenderable.renderable->mCustomParameter & 0x80 /* UseActiveActor */ ) &&
-                mLastBoundPlanarReflection != queuedRenderable.renderable->mCustomParameter )
+                lastBoundPlanarReflection != queuedRenderable.renderable->mCustomParameter )
             {
                 const uint8 activeActorIdx = queuedRenderable.renderable->mCustomParameter & 0x7F;
                 TextureGpu *planarReflTex = mPlanarReflections->getTexture( activeActorIdx );
                 *commandBuffer->addCommand<CbTexture>() = CbTexture(
                     uint16( mTexUnitSlotStart - 1u ), planarReflTex, mPlanarReflectionsSamplerblock );
-                mLastBoundPlanarReflection = queuedRenderable.renderable->mCustomParameter;
+                lastBoundPlanarReflection = queuedRenderable.renderable->mCustomParameter;
             }
 #endif
-            if( datablock->mTexturesDescSet != mLastDescTexture )
+            if( datablock->mTexturesDescSet != state.lastDescTexture )
             {
                 if( datablock->mTexturesDescSet )
                 {
@@ -3518,10 +3560,10 @@ namespace Ogre
                     // texUnit += datablock->mTexturesDescSet->mTextures.size();
                 }
 
-                mLastDescTexture = datablock->mTexturesDescSet;
+                state.lastDescTexture = datablock->mTexturesDescSet;
             }
 
-            if( datablock->mSamplersDescSet != mLastDescSampler && mHasSeparateSamplers )
+            if( datablock->mSamplersDescSet != state.lastDescSampler && mHasSeparateSamplers )
             {
                 if( datablock->mSamplersDescSet )
                 {
@@ -3529,15 +3571,16 @@ namespace Ogre
                     size_t texUnit = mTexUnitSlotStart;
                     *commandBuffer->addCommand<CbSamplers>() =
                         CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
-                    mLastDescSampler = datablock->mSamplersDescSet;
+                    state.lastDescSampler = datablock->mSamplersDescSet;
                 }
             }
         }
 
-        mCurrentMappedConstBuffer = currentMappedConstBuffer;
-        mCurrentMappedTexBuffer = currentMappedTexBuffer;
+        state.currentMappedConstBuffer = currentMappedConstBuffer;
+        state.currentMappedTexBuffer = currentMappedTexBuffer;
 
-        return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) - 1u );
+        return uint32(
+            ( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) >> 2u ) - 1u );
     }
     //-----------------------------------------------------------------------------------
     void HlmsPbs::destroyAllBuffers()
@@ -75,11 +75,7 @@ namespace Ogre
         ConstBufferPackedVec mPassBuffers;
         uint32               mCurrentPassBuffer;  /// Resets to zero every new frame.
 
-        ConstBufferPool::BufferPool const *mLastBoundPool;
-
-        bool                        mHasSeparateSamplers;
-        DescriptorSetTexture const *mLastDescTexture;
-        DescriptorSetSampler const *mLastDescSampler;
+        bool mHasSeparateSamplers;
 
         float mConstantBiasScale;
         bool  mUsingInstancedStereo;
@@ -109,10 +105,12 @@ namespace Ogre
 
         void destroyAllBuffers() override;
 
+        size_t getTexBufferBytesPerDraw( bool casterPass ) const override { return 64u; }
+
         FORCEINLINE uint32 fillBuffersFor( const HlmsCache        *cache,
                                            const QueuedRenderable &queuedRenderable, bool casterPass,
                                            uint32 lastCacheHash, CommandBuffer *commandBuffer,
-                                           bool isV1 );
+                                           bool isV1, MappedState &state );
 
         HlmsUnlit( Archive *dataFolder, ArchiveVec *libraryFolders, uint32 constBufferSize );
         HlmsUnlit( Archive *dataFolder, ArchiveVec *libraryFolders, HlmsTypes type,
@@ -143,6 +141,10 @@ namespace Ogre
                                  bool casterPass, uint32 lastCacheHash,
                                  CommandBuffer *commandBuffer ) override;
 
+        uint32 _fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass,
+                                       uint32 lastCacheHash, CommandBuffer *commandBuffer ) override;
+
         void frameEnded() override;
 
         void setShadowSettings( bool useExponentialShadowMaps );
@@ -79,10 +79,7 @@ namespace Ogre
         HlmsBufferManager( HLMS_UNLIT, "unlit", dataFolder, libraryFolders ),
         ConstBufferPool( constBufferSize, ExtraBufferParams( 64 * NUM_UNLIT_TEXTURE_TYPES ) ),
         mCurrentPassBuffer( 0 ),
-        mLastBoundPool( 0 ),
         mHasSeparateSamplers( 0 ),
-        mLastDescTexture( 0 ),
-        mLastDescSampler( 0 ),
         mConstantBiasScale( 0.1f ),
         mUsingInstancedStereo( false ),
         mUsingExponentialShadowMaps( false ),
@@ -104,9 +101,6 @@ namespace Ogre
         HlmsBufferManager( type, typeName, dataFolder, libraryFolders ),
         ConstBufferPool( constBufferSize, ExtraBufferParams( 64 * NUM_UNLIT_TEXTURE_TYPES ) ),
         mCurrentPassBuffer( 0 ),
-        mLastBoundPool( 0 ),
-        mLastDescTexture( 0 ),
-        mLastDescSampler( 0 ),
         mConstantBiasScale( 0.1f ),
         mUsingInstancedStereo( false ),
         mUsingExponentialShadowMaps( false ),
@@ -862,9 +856,9 @@ namespace Ogre
             mTexBuffers.push_back( newBuffer );
         }
 
-        mLastDescTexture = 0;
-        mLastDescSampler = 0;
-        mLastBoundPool = 0;
+        mMainState.lastDescTexture = 0;
+        mMainState.lastDescSampler = 0;
+        mMainState.lastBoundPool = 0;
 
         uploadDirtyDatablocks();
 
@@ -884,7 +878,8 @@ namespace Ogre
                                         bool casterPass, uint32 lastCacheHash,
                                         CommandBuffer *commandBuffer )
     {
-        return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer, true );
+        return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer, true,
+                               mMainState );
     }
     //-----------------------------------------------------------------------------------
     uint32 HlmsUnlit::fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
@@ -892,12 +887,29 @@ namespace Ogre
                                         CommandBuffer *commandBuffer )
     {
         return fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash, commandBuffer,
-                               false );
+                               false, mMainState );
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 HlmsUnlit::_fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                              const QueuedRenderable &queuedRenderable, bool casterPass,
+                                              uint32 lastCacheHash, CommandBuffer *commandBuffer )
+    {
+        MappedState &state = mSliceStates[sliceIdx];
+        const MappedState prevState = state;
+
+        const uint32 retVal = fillBuffersFor( cache, queuedRenderable, casterPass, lastCacheHash,
+                                              commandBuffer, false, state );
+
+        // RenderQueue discards the commands we've recorded. See Hlms::_fillBuffersForV2Slice
+        if( retVal == c_retryFillInRenderThread )
+            state = prevState;
+
+        return retVal;
     }
     //-----------------------------------------------------------------------------------
     uint32 HlmsUnlit::fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
                                       bool casterPass, uint32 lastCacheHash,
-                                      CommandBuffer *commandBuffer, bool isV1 )
+                                      CommandBuffer *commandBuffer, bool isV1, MappedState &state )
     {
         assert(
             dynamic_cast<const HlmsUnlitDatablock *>( queuedRenderable.renderable->getDatablock() ) );
@@ -907,9 +919,9 @@ namespace Ogre
         if( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( lastCacheHash ) != mType )
         {
             // We changed HlmsType, rebind the shared textures.
-            mLastDescTexture = 0;
-            mLastDescSampler = 0;
-            mLastBoundPool = 0;
+            state.lastDescTexture = 0;
+            state.lastDescSampler = 0;
+            state.lastBoundPool = 0;
 
             // layout(binding = 0) uniform PassBuffer {} pass
             ConstBufferPacked *passBuffer = mPassBuffers[mCurrentPassBuffer - 1];
@@ -919,24 +931,24 @@ namespace Ogre
                 CbShaderBuffer( PixelShader, 0, passBuffer, 0, (uint32)passBuffer->getTotalSizeBytes() );
 
             // layout(binding = 2) uniform InstanceBuffer {} instance
-            if( mCurrentConstBuffer < mConstBuffers.size() &&
-                (size_t)( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) + 4 ) <=
-                    mCurrentConstBufferSize )
+            if( state.currentConstBuffer < mConstBuffers.size() &&
+                (size_t)( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) + 4 ) <=
+                    state.currentConstBufferSize )
             {
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( VertexShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( VertexShader, 2, mConstBuffers[state.currentConstBuffer], 0, 0 );
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( PixelShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( PixelShader, 2, mConstBuffers[state.currentConstBuffer], 0, 0 );
             }
 
-            rebindTexBuffer( commandBuffer );
+            rebindTexBuffer( state, commandBuffer );
 
             mListener->hlmsTypeChanged( casterPass, commandBuffer, datablock, 0u );
         }
 
         // Don't bind the material buffer on caster passes (important to keep
         // MDI & auto-instancing running on shadow map passes)
-        if( mLastBoundPool != datablock->getAssignedPool() && !casterPass )
+        if( state.lastBoundPool != datablock->getAssignedPool() && !casterPass )
         {
             // layout(binding = 1) uniform MaterialBuf {} materialArray
             const ConstBufferPool::BufferPool *newPool = datablock->getAssignedPool();
@@ -953,32 +965,34 @@ namespace Ogre
                     VertexShader, 1, extraBuffer, 0, (uint32)extraBuffer->getTotalSizeBytes() );
             }
 
-            mLastBoundPool = newPool;
+            state.lastBoundPool = newPool;
         }
 
-        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mCurrentMappedConstBuffer;
-        float *RESTRICT_ALIAS currentMappedTexBuffer = mCurrentMappedTexBuffer;
+        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = state.currentMappedConstBuffer;
+        float *RESTRICT_ALIAS currentMappedTexBuffer = state.currentMappedTexBuffer;
 
         const Matrix4 &worldMat = queuedRenderable.movableObject->_getParentNodeFullTransform();
 
-        bool exceedsConstBuffer = (size_t)( ( currentMappedConstBuffer - mStartMappedConstBuffer ) +
-                                            4 ) > mCurrentConstBufferSize;
+        bool exceedsConstBuffer =
+            (size_t)( ( currentMappedConstBuffer - state.startMappedConstBuffer ) + 4 ) >
+            state.currentConstBufferSize;
 
         const size_t minimumTexBufferSize = 16;
-        bool exceedsTexBuffer = static_cast<size_t>( currentMappedTexBuffer - mStartMappedTexBuffer ) +
-                                    minimumTexBufferSize >=
-                                mCurrentTexBufferSize;
+        bool exceedsTexBuffer =
+            static_cast<size_t>( currentMappedTexBuffer - state.startMappedTexBuffer ) +
+                minimumTexBufferSize >=
+            state.currentTexBufferSize;
 
         if( exceedsConstBuffer || exceedsTexBuffer )
         {
-            currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
-
-            if( exceedsTexBuffer )
-                mapNextTexBuffer( commandBuffer, minimumTexBufferSize * sizeof( float ) );
-            else
-                rebindTexBuffer( commandBuffer, true, minimumTexBufferSize * sizeof( float ) );
+            if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                 minimumTexBufferSize * sizeof( float ) ) )
+            {
+                return c_retryFillInRenderThread;
+            }
 
-            currentMappedTexBuffer = mCurrentMappedTexBuffer;
+            currentMappedConstBuffer = state.currentMappedConstBuffer;
+            currentMappedTexBuffer = state.currentMappedTexBuffer;
         }
 
         //---------------------------------------------------------------------------
@@ -1015,7 +1029,7 @@ namespace Ogre
 
         if( !casterPass )
         {
-            if( datablock->mTexturesDescSet != mLastDescTexture )
+            if( datablock->mTexturesDescSet != state.lastDescTexture )
             {
                 // Bind textures
                 size_t texUnit = mTexUnitSlotStart;
@@ -1035,10 +1049,10 @@ namespace Ogre
                     texUnit += datablock->mTexturesDescSet->mTextures.size();
                 }
 
-                mLastDescTexture = datablock->mTexturesDescSet;
+                state.lastDescTexture = datablock->mTexturesDescSet;
             }
 
-            if( datablock->mSamplersDescSet != mLastDescSampler && mHasSeparateSamplers )
+            if( datablock->mSamplersDescSet != state.lastDescSampler && mHasSeparateSamplers )
             {
                 if( datablock->mSamplersDescSet )
                 {
@@ -1046,15 +1060,16 @@ namespace Ogre
                     size_t texUnit = mSamplerUnitSlotStart;
                     *commandBuffer->addCommand<CbSamplers>() =
                         CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
-                    mLastDescSampler = datablock->mSamplersDescSet;
+                    state.lastDescSampler = datablock->mSamplersDescSet;
                 }
             }
         }
 
-        mCurrentMappedConstBuffer = currentMappedConstBuffer;
-        mCurrentMappedTexBuffer = currentMappedTexBuffer;
+        state.currentMappedConstBuffer = currentMappedConstBuffer;
+        state.currentMappedTexBuffer = currentMappedTexBuffer;
 
-        return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 2u ) - 1u );
+        return uint32(
+            ( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) >> 2u ) - 1u );
     }
     //-----------------------------------------------------------------------------------
     void HlmsUnlit::destroyAllBuffers()
@@ -39,6 +39,7 @@ namespace Ogre
     class _OgreLodExport LodCollapser
     {
     public:
+        LodCollapser() : mLastReducedVertex( 0 ), mNumCollapsedTriangles( 0 ) {}
         virtual ~LodCollapser() {}
         /// Reduces vertices until vertexCountLimit or collapseCostLimit is reached.
         virtual void collapse( LodData *data, LodCollapseCost *cost, LodOutputProvider *output,
@@ -68,6 +69,9 @@ namespace Ogre
          */
         bool _getLastVertexCollapseTo( LodData *data, Vector3 &outVec );
 
+        /// Number of triangles removed by all the collapses made so far.
+        size_t getNumCollapsedTriangles() const { return mNumCollapsedTriangles; }
+
     protected:
         struct CollapsedEdge
         {
@@ -85,6 +89,8 @@ namespace Ogre
         /// it to select edge.
         LodData::Vertex *mLastReducedVertex;
 
+        size_t mNumCollapsedTriangles;
+
         /// Collapses a single vertex.
         void collapseVertex( LodData *data, LodCollapseCost *cost, LodOutputProvider *output,
                              LodData::Vertex *src );
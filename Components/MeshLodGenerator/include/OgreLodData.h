@@ -66,11 +66,78 @@ namespace Ogre
             InvalidIndex = (unsigned)-1
         };
 
-        typedef vector<Vertex>::type          VertexList;
-        typedef vector<Triangle>::type        TriangleList;
-        typedef multimap<Real, VertexI>::type CollapseCostHeap;
-        typedef VectorSet<Edge, 8>            VEdges;
-        typedef VectorSet<TriangleI, 7>       VTriangles;
+        typedef vector<Vertex>::type    VertexList;
+        typedef vector<Triangle>::type  TriangleList;
+        typedef VectorSet<Edge, 8>      VEdges;
+        typedef VectorSet<TriangleI, 7> VTriangles;
+
+        /** Binary min-heap of the vertices that can still be collapsed, sorted by collapse cost.
+            Vertices with the same cost come out in the order they were (re)inserted, like the
+            std::multimap that used to be used here; so the generated Lods don't change.
+        @remarks
+            The heap position of each vertex is kept in an array indexed by VertexI, so updating
+            or removing a vertex needs no search and no node allocations.
+        */
+        class _OgreLodExport CollapseCostHeap
+        {
+        public:
+            struct Entry
+            {
+                Real    cost;
+                VertexI vertexi;
+                /// Insertion order. Breaks ties between equal costs.
+                uint64 order;
+            };
+
+            typedef vector<Entry>::type::const_iterator const_iterator;
+
+        protected:
+            vector<Entry>::type   mHeap;
+            vector<VertexI>::type mHeapIdx;  /// mHeap index of each vertex. InvalidIndex if not in
+            uint64                mNextOrder;
+
+            static bool isLess( const Entry &a, const Entry &b )
+            {
+                return a.cost < b.cost || ( a.cost == b.cost && a.order < b.order );
+            }
+
+            void siftUp( size_t heapIdx );
+            void siftDown( size_t heapIdx );
+            void placeEntry( size_t heapIdx, const Entry &entry );
+
+        public:
+            CollapseCostHeap() : mNextOrder( 0 ) {}
+
+            void clear();
+            void reserve( size_t numVertices );
+
+            size_t size() const { return mHeap.size(); }
+            bool   empty() const { return mHeap.empty(); }
+
+            /// Iterates in heap order, not sorted by cost.
+            const_iterator begin() const { return mHeap.begin(); }
+            const_iterator end() const { return mHeap.end(); }
+
+            /// Vertex with the lowest collapse cost. Heap must not be empty.
+            const Entry &top() const { return mHeap.front(); }
+
+            bool contains( VertexI vi ) const
+            {
+                return vi < mHeapIdx.size() && mHeapIdx[vi] != (VertexI)InvalidIndex;
+            }
+            Real getCost( VertexI vi ) const
+            {
+                OgreAssert( contains( vi ), "" );
+                return mHeap[mHeapIdx[vi]].cost;
+            }
+
+            /// Vertex must not be in the heap.
+            void insert( VertexI vi, Real cost );
+            /// Same as erase + insert. Vertex must be in the heap.
+            void update( VertexI vi, Real cost );
+            /// Vertex must be in the heap.
+            void erase( VertexI vi );
+        };
 
         // Hash function for UniqueVertexSet.
         struct VertexHash
@@ -114,10 +181,8 @@ namespace Ogre
             VEdges     edges;
             VTriangles triangles;
 
-            VertexI                    collapseToi;
-            bool                       seam;
-            CollapseCostHeap::iterator costHeapPosition;  /// Iterator pointing to the position in the
-                                                          /// mCollapseCostSet, which allows fast remove.
+            VertexI collapseToi;
+            bool    seam;
 
             void addEdge( const Edge &edge );
             void removeEdge( const Edge &edge );
@@ -41,9 +41,26 @@
 
 namespace Ogre
 {
+    class TaskScheduler;
+
     class _OgreLodExport MeshLodGenerator : public Singleton<MeshLodGenerator>
     {
     public:
+        typedef vector<LodConfig>::type LodConfigList;
+
+        /// Returned by generateLodLevelsBatch
+        struct BatchStats
+        {
+            size_t numMeshes;
+            /// Triangles removed across all meshes and Lod levels
+            size_t numCollapsedTriangles;
+            /// Wall time of the parallel part (building LodData, collapsing & baking), in
+            /// microseconds. Divide numCollapsedTriangles by it to get the throughput.
+            uint64 reductionTimeUs;
+            /// Wall time of the whole call, in microseconds.
+            uint64 totalTimeUs;
+        };
+
         static MeshLodGenerator *getSingletonPtr();
         static MeshLodGenerator &getSingleton();
 
@@ -72,6 +89,24 @@ namespace Ogre
          */
         void generateAutoconfiguredLodLevels( v1::MeshPtr &mesh );
 
+        /**
+         * @brief Generates the Lod levels of many meshes, reducing several of them at the same time.
+         *
+         * Meshes are read into buffers and the results are injected on the calling thread. Only
+         * the reduction (building LodData, computing collapse costs, collapsing and baking) runs
+         * on the worker threads, one mesh per task. Each mesh uses the default components.
+         * lodConfig.advanced.useBackgroundQueue is ignored: this call blocks until every mesh
+         * is done.
+         *
+         * @param lodConfigs Specification of the requested Lod levels of each mesh. The out* values
+         * of their levels are filled.
+         * @param taskScheduler Threads used to reduce the meshes, e.g.
+         * SceneManager::getTaskScheduler. When null, a temporary one is created with one thread
+         * per logical core.
+         */
+        BatchStats generateLodLevelsBatch( LodConfigList &lodConfigs,
+                                           TaskScheduler *taskScheduler = 0 );
+
         /**
          * @brief Fills Lod Config with a config, which works on any mesh.
          *
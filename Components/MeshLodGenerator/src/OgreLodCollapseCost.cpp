@@ -37,6 +37,7 @@ namespace Ogre
     void LodCollapseCost::initCollapseCosts( LodData *data )
     {
         data->mCollapseCostHeap.clear();
+        data->mCollapseCostHeap.reserve( data->mVertexList.size() );
         LodData::VertexList::iterator it = data->mVertexList.begin();
         LodData::VertexList::iterator itEnd = data->mVertexList.end();
         LodData::VertexI vi = 0;
@@ -85,8 +86,7 @@ namespace Ogre
         computeVertexCollapseCost( data, vertexi, collapseCost, collapseToi );
 
         vertex->collapseToi = collapseToi;
-        vertex->costHeapPosition = data->mCollapseCostHeap.insert(
-            LodData::CollapseCostHeap::value_type( collapseCost, vertexi ) );
+        data->mCollapseCostHeap.insert( vertexi, collapseCost );
     }
 
     void LodCollapseCost::updateVertexCollapseCost( LodData *data, LodData::VertexI vertexi )
@@ -96,21 +96,19 @@ namespace Ogre
         computeVertexCollapseCost( data, vertexi, collapseCost, collapseToi );
 
         LodData::Vertex *vertex = &data->mVertexList[vertexi];
-        if( vertex->collapseToi != collapseToi || collapseCost != vertex->costHeapPosition->first )
+        if( vertex->collapseToi != collapseToi ||
+            collapseCost != data->mCollapseCostHeap.getCost( vertexi ) )
         {
-            OgreAssert( vertex->costHeapPosition != data->mCollapseCostHeap.end(), "" );
-            data->mCollapseCostHeap.erase( vertex->costHeapPosition );
             if( collapseCost != LodData::UNINITIALIZED_COLLAPSE_COST )
             {
                 vertex->collapseToi = collapseToi;
-                vertex->costHeapPosition = data->mCollapseCostHeap.insert(
-                    LodData::CollapseCostHeap::value_type( collapseCost, vertexi ) );
+                data->mCollapseCostHeap.update( vertexi, collapseCost );
             }
             else
             {
+                data->mCollapseCostHeap.erase( vertexi );
 #if OGRE_DEBUG_MODE
                 vertex->collapseToi = LodData::InvalidIndex;
-                vertex->costHeapPosition = data->mCollapseCostHeap.end();
 #endif
             }
         }
@@ -39,10 +39,10 @@ namespace Ogre
     {
         while( data->mCollapseCostHeap.size() > static_cast<size_t>( vertexCountLimit ) )
         {
-            LodData::CollapseCostHeap::iterator nextVertex = data->mCollapseCostHeap.begin();
-            if( nextVertex->first < collapseCostLimit )
+            const LodData::CollapseCostHeap::Entry &nextVertex = data->mCollapseCostHeap.top();
+            if( nextVertex.cost < collapseCostLimit )
             {
-                mLastReducedVertex = &data->mVertexList[nextVertex->second];
+                mLastReducedVertex = &data->mVertexList[nextVertex.vertexi];
                 collapseVertex( data, cost, output, mLastReducedVertex );
             }
             else
@@ -58,11 +58,11 @@ namespace Ogre
         // Allows to find bugs in collapsing.
         //  size_t s1 = mUniqueVertexSet.size();
         //  size_t s2 = mCollapseCostHeap.size();
-        LodData::CollapseCostHeap::iterator it = data->mCollapseCostHeap.begin();
-        LodData::CollapseCostHeap::iterator itEnd = data->mCollapseCostHeap.end();
+        LodData::CollapseCostHeap::const_iterator it = data->mCollapseCostHeap.begin();
+        LodData::CollapseCostHeap::const_iterator itEnd = data->mCollapseCostHeap.end();
         while( it != itEnd )
         {
-            assertValidVertex( data, it->second );
+            assertValidVertex( data, it->vertexi );
             it++;
         }
     }
@@ -79,7 +79,7 @@ namespace Ogre
             for( int i = 0; i < 3; i++ )
             {
                 LodData::Vertex *tvi = &data->mVertexList[t->vertexi[i]];
-                OgreAssert( tvi->costHeapPosition != data->mCollapseCostHeap.end(), "" );
+                OgreAssert( data->mCollapseCostHeap.contains( t->vertexi[i] ), "" );
                 tvi->edges.findExists( LodData::Edge( tvi->collapseToi ) );
                 for( int n = 0; n < 3; n++ )
                 {
@@ -141,6 +141,7 @@ namespace Ogre
         LodData::TriangleI trianglei =
             (LodData::TriangleI)LodData::getVectorIDFromPointer( data->mTriangleList, triangle );
         triangle->setRemoved();
+        ++mNumCollapsedTriangles;
         // skip is needed if we are iterating on the vertex's edges or triangles.
         for( int i = 0; i < 3; i++ )
         {
@@ -231,8 +232,9 @@ namespace Ogre
         assertValidVertex( data, dsti );
         assertValidVertex( data, srci );
 #endif
-        OgreAssert( src->costHeapPosition->first != LodData::NEVER_COLLAPSE_COST, "" );
-        OgreAssert( src->costHeapPosition->first != LodData::UNINITIALIZED_COLLAPSE_COST, "" );
+        OgreAssert( data->mCollapseCostHeap.getCost( srci ) != LodData::NEVER_COLLAPSE_COST, "" );
+        OgreAssert( data->mCollapseCostHeap.getCost( srci ) != LodData::UNINITIALIZED_COLLAPSE_COST,
+                    "" );
         OgreAssert( !src->edges.empty(), "" );
         OgreAssert( !src->triangles.empty(), "" );
         OgreAssert( src->edges.find( LodData::Edge( dsti ) ) != src->edges.end(), "" );
@@ -363,11 +365,10 @@ namespace Ogre
         assertOutdatedCollapseCost( data, cost, dsti );
 #    endif                                                       // ifndef OGRE_DEBUG_MODE
 #endif                                                           // ifndef MESHLOD_QUALITY
-        data->mCollapseCostHeap.erase( src->costHeapPosition );  // Remove src from collapse costs.
-        src->edges.clear();                                      // Free memory
-        src->triangles.clear();                                  // Free memory
+        data->mCollapseCostHeap.erase( srci );  // Remove src from collapse costs.
+        src->edges.clear();                     // Free memory
+        src->triangles.clear();                 // Free memory
 #if OGRE_DEBUG_MODE
-        src->costHeapPosition = data->mCollapseCostHeap.end();
         assertValidVertex( data, dsti );
 #endif
     }
@@ -132,4 +132,106 @@ namespace Ogre
 
     bool LodData::Edge::operator==( const LodData::Edge &other ) const { return dsti == other.dsti; }
 
+    void LodData::CollapseCostHeap::clear()
+    {
+        mHeap.clear();
+        mHeapIdx.clear();
+        mNextOrder = 0;
+    }
+
+    void LodData::CollapseCostHeap::reserve( size_t numVertices )
+    {
+        mHeap.reserve( numVertices );
+        if( mHeapIdx.size() < numVertices )
+            mHeapIdx.resize( numVertices, (VertexI)InvalidIndex );
+    }
+
+    void LodData::CollapseCostHeap::placeEntry( size_t heapIdx, const Entry &entry )
+    {
+        mHeap[heapIdx] = entry;
+        mHeapIdx[entry.vertexi] = (VertexI)heapIdx;
+    }
+
+    void LodData::CollapseCostHeap::siftUp( size_t heapIdx )
+    {
+        const Entry entry = mHeap[heapIdx];
+        while( heapIdx > 0 )
+        {
+            const size_t parentIdx = ( heapIdx - 1u ) >> 1u;
+            if( !isLess( entry, mHeap[parentIdx] ) )
+                break;
+            placeEntry( heapIdx, mHeap[parentIdx] );
+            heapIdx = parentIdx;
+        }
+        placeEntry( heapIdx, entry );
+    }
+
+    void LodData::CollapseCostHeap::siftDown( size_t heapIdx )
+    {
+        const Entry entry = mHeap[heapIdx];
+        const size_t heapSize = mHeap.size();
+        while( true )
+        {
+            size_t childIdx = heapIdx * 2u + 1u;
+            if( childIdx >= heapSize )
+                break;
+            if( childIdx + 1u < heapSize && isLess( mHeap[childIdx + 1u], mHeap[childIdx] ) )
+                ++childIdx;
+            if( !isLess( mHeap[childIdx], entry ) )
+                break;
+            placeEntry( heapIdx, mHeap[childIdx] );
+            heapIdx = childIdx;
+        }
+        placeEntry( heapIdx, entry );
+    }
+
+    void LodData::CollapseCostHeap::insert( VertexI vi, Real cost )
+    {
+        if( vi >= mHeapIdx.size() )
+            mHeapIdx.resize( vi + 1u, (VertexI)InvalidIndex );
+        OgreAssert( !contains( vi ), "" );
+
+        Entry entry;
+        entry.cost = cost;
+        entry.vertexi = vi;
+        entry.order = mNextOrder++;
+        mHeap.push_back( entry );
+        mHeapIdx[vi] = (VertexI)( mHeap.size() - 1u );
+        siftUp( mHeap.size() - 1u );
+    }
+
+    void LodData::CollapseCostHeap::update( VertexI vi, Real cost )
+    {
+        OgreAssert( contains( vi ), "" );
+        const size_t heapIdx = mHeapIdx[vi];
+        Entry &entry = mHeap[heapIdx];
+        const Real oldCost = entry.cost;
+        entry.cost = cost;
+        // Goes after every other entry with the same cost, just like a reinsertion
+        entry.order = mNextOrder++;
+        if( cost < oldCost )
+            siftUp( heapIdx );
+        else
+            siftDown( heapIdx );
+    }
+
+    void LodData::CollapseCostHeap::erase( VertexI vi )
+    {
+        OgreAssert( contains( vi ), "" );
+        const size_t heapIdx = mHeapIdx[vi];
+        mHeapIdx[vi] = (VertexI)InvalidIndex;
+
+        const Entry last = mHeap.back();
+        mHeap.pop_back();
+        if( heapIdx == mHeap.size() )
+            return;
+
+        // Move the last entry into the hole and restore the heap from there
+        placeEntry( heapIdx, last );
+        if( heapIdx > 0 && isLess( last, mHeap[( heapIdx - 1u ) >> 1u] ) )
+            siftUp( heapIdx );
+        else
+            siftDown( heapIdx );
+    }
+
 }  // namespace Ogre
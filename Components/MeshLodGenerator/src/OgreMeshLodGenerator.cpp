@@ -46,9 +46,46 @@
 #include "OgreLodWorkQueueWorker.h"
 #include "OgreMesh.h"
 #include "OgrePixelCountLodStrategy.h"
+#include "OgrePlatformInformation.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
 
 namespace Ogre
 {
+    namespace
+    {
+        struct LodBatchJob
+        {
+            LodConfig            config;
+            LodCollapseCostPtr   cost;
+            LodDataPtr           data;
+            LodInputProviderPtr  input;
+            LodOutputProviderPtr output;
+            LodCollapserPtr      collapser;
+        };
+
+        /// Reduces one mesh of MeshLodGenerator::generateLodLevelsBatch per chunk
+        class LodBatchTask : public Task
+        {
+            MeshLodGenerator *mGenerator;
+            LodBatchJob      *mJobs;
+
+        public:
+            LodBatchTask( MeshLodGenerator *generator, LodBatchJob *jobs ) :
+                mGenerator( generator ),
+                mJobs( jobs )
+            {
+            }
+
+            void execute( size_t chunkIdx, size_t threadIdx ) override
+            {
+                LodBatchJob &job = mJobs[chunkIdx];
+                mGenerator->_process( job.config, job.cost.get(), job.data.get(), job.input.get(),
+                                      job.output.get(), job.collapser.get() );
+            }
+        };
+    }  // namespace
+
     template <>
     MeshLodGenerator *Singleton<MeshLodGenerator>::msSingleton = 0;
     MeshLodGenerator *MeshLodGenerator::getSingletonPtr() { return msSingleton; }
@@ -257,6 +294,89 @@ namespace Ogre
         lodConfig.mesh->prepareForShadowMapping( false );
     }
 
+    MeshLodGenerator::BatchStats MeshLodGenerator::generateLodLevelsBatch( LodConfigList &lodConfigs,
+                                                                          TaskScheduler *taskScheduler )
+    {
+        Timer timer;
+
+        BatchStats stats;
+        stats.numMeshes = lodConfigs.size();
+        stats.numCollapsedTriangles = 0;
+        stats.reductionTimeUs = 0;
+        stats.totalTimeUs = 0;
+
+        // Read the meshes on this thread. Meshes with only manual levels are done right away.
+        vector<LodBatchJob>::type jobs;
+        vector<size_t>::type jobConfigIdx;
+        jobs.reserve( lodConfigs.size() );
+        jobConfigIdx.reserve( lodConfigs.size() );
+
+        for( size_t i = 0; i < lodConfigs.size(); ++i )
+        {
+            LodConfig &lodConfig = lodConfigs[i];
+
+            bool hasGeneratedLevels = false;
+            for( size_t j = 0; j < lodConfig.levels.size() && !hasGeneratedLevels; ++j )
+                hasGeneratedLevels = lodConfig.levels[j].manualMeshName.empty();
+
+            if( !hasGeneratedLevels )
+            {
+                _generateManualLodLevels( lodConfig );
+                lodConfig.mesh->prepareForShadowMapping( false );
+                continue;
+            }
+
+            jobs.push_back( LodBatchJob() );
+            jobConfigIdx.push_back( i );
+
+            // The background queue path is the one whose providers are safe to use from
+            // other threads: they work on copies of the mesh buffers.
+            LodBatchJob &job = jobs.back();
+            job.config = lodConfig;
+            job.config.advanced.useBackgroundQueue = true;
+            _resolveComponents( job.config, job.cost, job.data, job.input, job.output,
+                                job.collapser );
+        }
+
+        if( !jobs.empty() )
+        {
+            TaskScheduler *ownScheduler = 0;
+            if( !taskScheduler )
+            {
+                ownScheduler = OGRE_NEW TaskScheduler(
+                    std::max<size_t>( PlatformInformation::getNumLogicalCores(), 1u ) );
+                taskScheduler = ownScheduler;
+            }
+
+            const uint64 reductionStart = timer.getMicroseconds();
+
+            LodBatchTask task( this, &jobs[0] );
+            taskScheduler->wait( taskScheduler->submit( &task, jobs.size() ) );
+
+            stats.reductionTimeUs = timer.getMicroseconds() - reductionStart;
+
+            OGRE_DELETE ownScheduler;
+        }
+
+        // Inject the results on this thread
+        for( size_t i = 0; i < jobs.size(); ++i )
+        {
+            LodBatchJob &job = jobs[i];
+            LodConfig &lodConfig = lodConfigs[jobConfigIdx[i]];
+            lodConfig.levels = job.config.levels;
+
+            job.output->inject();
+            _configureMeshLodUsage( lodConfig );
+            lodConfig.mesh->prepareForShadowMapping( false );
+
+            stats.numCollapsedTriangles += job.collapser->getNumCollapsedTriangles();
+        }
+
+        stats.totalTimeUs = timer.getMicroseconds();
+
+        return stats;
+    }
+
     void MeshLodGenerator::computeLods( LodConfig &lodConfig, LodData *data, LodCollapseCost *cost,
                                         LodOutputProvider *output, LodCollapser *collapser )
     {
@@ -274,6 +274,18 @@ namespace Ogre
         void _swapBoneWeightsUniquePtr(
             RawSimdUniquePtr<ArrayReal, MEMCATEGORY_ANIMATION> &inOutBoneWeights );
 
+        /** For internal use. Appends the per-bone weights to inOutWeights and combines them
+            into hash, in an order that doesn't depend on which SIMD slots mOwner's bones use.
+            See SkeletonInstance::setPoseSharing
+        @param manualBones
+            mOwner's manual bone mask (0 for manual bones). Manual bones are written by the
+            user, thus their weight doesn't matter and the default (1) is used instead.
+        @return
+            The new hash
+        */
+        uint32 _addBoneWeightsToPoseKey( uint32 hash, const Real *manualBones,
+                                         FastArray<Real> &inOutWeights ) const;
+
         const SkeletonAnimationDef *getDefinition() const { return mDefinition; }
     };
 
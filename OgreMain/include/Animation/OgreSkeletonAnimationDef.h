@@ -30,6 +30,7 @@ THE SOFTWARE.
 #define __SkeletonAnimationDef_H__
 
 #include "OgreIdString.h"
+#include "OgreRawPtr.h"
 #include "OgreSkeletonTrack.h"
 
 #include "ogrestd/map.h"
@@ -62,6 +63,11 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mKfTransformMemoryManager;
 
+        /// Used by the tracks once compressed, instead of mKfTransformMemoryManager.
+        /// See SkeletonTrack::_compress
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> mDequantization;
+        RawSimdUniquePtr<uint16, MEMCATEGORY_ANIMATION>      mQuantizedKeyFrames;
+
         typedef vector<Real>::type              TimestampVec;
         typedef map<size_t, TimestampVec>::type TimestampsPerBlock;
 
@@ -87,6 +93,9 @@ namespace Ogre
         void allocateCacheFriendlyKeyframes( const TimestampsPerBlock &timestampsByBlock,
                                              Real                      frameRate );
 
+        /// Compresses all mTracks, and frees mKfTransformMemoryManager
+        void compressTracks( const SkeletonTrackCompression &settings );
+
     public:
         SkeletonAnimationDef();
         ~SkeletonAnimationDef();
@@ -98,7 +107,19 @@ namespace Ogre
         Real getNumFrames() const { return mNumFrames; }
         Real getOriginalFrameRate() const { return mOriginalFrameRate; }
 
-        void build( const v1::Skeleton *skeleton, const v1::Animation *animation, Real frameRate );
+        /** Converts a v1 animation.
+        @param compression
+            When not null, the tracks are compressed using these settings. Compressed tracks
+            use a fraction of the memory at a small CPU cost when sampling them, and lose some
+            precision. See SkeletonTrackCompression.
+        */
+        void build( const v1::Skeleton *skeleton, const v1::Animation *animation, Real frameRate,
+                    const SkeletonTrackCompression *compression = 0 );
+
+        bool isCompressed() const { return !mTracks.empty() && mTracks.front().isCompressed(); }
+
+        /// Bytes used by the keyframes' transforms of all tracks
+        size_t getKeyFrameDataSize() const;
 
         /// Dumps all the tracks in CSV format to the output string argument.
         /// Mostly for debugging purposes. (also easy example to show how to
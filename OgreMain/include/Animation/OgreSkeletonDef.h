@@ -141,8 +141,11 @@ namespace Ogre
             time values end up rounded.
         @remarks
             If the framerate information has been lost, set it to 1.
+        @param trackCompression
+            When not null, the animation tracks are compressed. See SkeletonAnimationDef::build.
         */
-        SkeletonDef( const v1::Skeleton *originalSkeleton, Real frameRate );
+        SkeletonDef( const v1::Skeleton *originalSkeleton, Real frameRate,
+                     const SkeletonTrackCompression *trackCompression = 0 );
 
         const String &getNameStr() const { return mName; }
 
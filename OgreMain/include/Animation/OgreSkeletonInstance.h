@@ -33,6 +33,8 @@ THE SOFTWARE.
 
 #include "Animation/OgreBone.h"
 
+#include "ogrestd/unordered_map.h"
+
 namespace Ogre
 {
 #if defined( __GNUC__ ) && !defined( __clang__ )
@@ -79,6 +81,24 @@ namespace Ogre
     public:
         typedef vector<Bone>::type BoneVec;
 
+        /// Describes what an active animation contributes to the pose. @see setPoseSharing
+        struct SharedPoseKeyEntry
+        {
+            SkeletonAnimationDef const *animationDef;
+            int32                       quantizedFrame;
+            Real                        weight;
+
+            bool operator==( const SharedPoseKeyEntry &other ) const
+            {
+                return animationDef == other.animationDef && quantizedFrame == other.quantizedFrame &&
+                       weight == other.weight;
+            }
+        };
+        typedef FastArray<SharedPoseKeyEntry> SharedPoseKey;
+
+        /// Hash of the SharedPoseKey -> instance that evaluated that pose in the current frame
+        typedef unordered_map<uint32, SkeletonInstance *>::type SharedPoseMap;
+
     protected:
         BoneVec        mBones;
         TransformArray mBoneStartTransforms;  /// The start of Transform at each depth level
@@ -116,14 +136,120 @@ namespace Ogre
 
         uint16 mRefCount;
 
+        /// Number of bones set via setManualBone
+        uint32 mNumManualBones;
+
+        /// See setUpdateLod. Null when disabled
+        MovableObject const *mUpdateLodSource;
+        /// Update interval (in frames) for each mesh LOD level of mUpdateLodSource
+        FastArray<uint8> mUpdateLodIntervals;
+        /// Frames since the active animations were last evaluated
+        uint8 mFramesSinceEvaluation;
+        /// Number of valid poses in mPoseHistory (0, 1 or 2)
+        uint8 mNumPosesInHistory;
+        /// Which half of mPoseHistory holds the newest pose
+        uint8 mNewestPoseIdx;
+        /** The last two evaluated poses, for interpolating in between while the update LOD
+            skips frames. Each half has one KfTransform per bone block, in the same layout
+            as the blocks we occupy in the BoneMemoryManager.
+        */
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> mPoseHistory;
+
+        /// See setPoseSharing. 0 when disabled
+        Real          mPoseShareFrameQuantum;
+        SharedPoseKey mSharedPoseKey;
+        /// Per-bone weights of each entry of mSharedPoseKey.
+        /// See SkeletonAnimation::_addBoneWeightsToPoseKey
+        FastArray<Real> mSharedPoseBoneWeights;
+
+        void updateImpl( SharedPoseMap *sharedPoses );
+
+        /** Evaluates the active animations, reusing the pose from sharedPoses if possible.
+        @param canProvidePose
+            When true we may register ourselves in sharedPoses so that others can copy from us.
+            Must be false if our bones won't hold the evaluated pose by the end of the frame.
+        */
+        void evaluate( SharedPoseMap *sharedPoses, bool canProvidePose );
+
+        /// Builds mSharedPoseKey & mSharedPoseBoneWeights. Returns their hash
+        uint32 buildSharedPoseKey();
+
+        /// Copies the local transforms of the animated (non-manual) bones from source.
+        void copyPoseFrom( const SkeletonInstance &source );
+
+        /// Stores the current local transforms of our bones as the newest pose in mPoseHistory.
+        void pushPoseHistory();
+
+        /// Sets our non-manual bones to the interpolation between the two poses in mPoseHistory.
+        void applyPoseHistory( Real alpha );
+
+        uint8 getUpdateInterval() const;
+
     public:
         SkeletonInstance( const SkeletonDef *skeletonDef, BoneMemoryManager *boneMemoryManager );
         ~SkeletonInstance();
 
         const SkeletonDef *getDefinition() const { return mDefinition; }
 
+        /** Evaluates the active animations and leaves the result in the bones' local transforms.
+            Honours the update LOD (see setUpdateLod).
+        */
         void update();
 
+        /** Internal use. Same as update(), but instances with pose sharing enabled may reuse
+            the pose of another instance registered in sharedPoses, or register their own.
+            All instances updated with the same map must share the same BoneMemoryManager.
+        */
+        void _update( SharedPoseMap &sharedPoses );
+
+        /** Enables update-rate LOD. When the LOD of lodSource is high (i.e. it's far away), the
+            animations are evaluated once every few frames, and the frames in between are
+            interpolated from the last two evaluated poses.
+        @remarks
+            Interpolating requires the two poses to be known in advance, thus the skeleton
+            lags behind its animations by one update interval (e.g. 3 frames at interval 3).
+            The interpolated frames are much cheaper than evaluating the animations, but
+            SceneManager still needs to derive the full transforms of every bone each frame.
+        @par
+            Bones that are manual (see setManualBone) are not touched on the interpolated
+            frames either.
+        @param lodSource
+            Object whose mesh LOD (see MovableObject::getCurrentMeshLod) determines the
+            update rate. Usually the Item this skeleton belongs to. It must outlive us or
+            be unset first. Use a null pointer to disable update LOD.
+        @param updateIntervals
+            Number of frames between each evaluation, per mesh LOD level. A value of 1
+            (or 0) means every frame. LOD levels past the end of the array use the last
+            entry.
+            e.g. { 1, 1, 2, 4 } updates every frame at LOD 0 and 1, every other frame at
+            LOD 2, and once every 4 frames at LOD 3 and above.
+        */
+        void setUpdateLod( const MovableObject *lodSource, const FastArray<uint8> &updateIntervals );
+
+        /// Returns the source set by setUpdateLod. Null when update LOD is disabled
+        const MovableObject *getUpdateLodSource() const { return mUpdateLodSource; }
+
+        /** Enables sharing the evaluated pose with other instances of the same SkeletonDef.
+            Instances that have the same active animations, with the same weights, and at the
+            same quantized frame are only evaluated once per frame; the rest copy the result.
+            Useful for crowds where many characters play the same animation.
+        @remarks
+            Sharing only happens between instances that are updated by the same worker
+            thread, and that both have pose sharing enabled with the same quantum.
+        @par
+            Per-bone weights (see SkeletonAnimation::setBoneWeight) must match too, except
+            the ones of manual bones. Manual bones are never overwritten; however instances
+            with manual bones won't provide their pose to others.
+        @param frameQuantum
+            Frame intervals (in keyframe units, see SkeletonAnimation::getCurrentFrame) that
+            are considered the same pose. Larger values share more often but the motion
+            becomes choppier. Use 0 to disable pose sharing.
+        */
+        void setPoseSharing( Real frameQuantum );
+
+        /// Returns the quantum set by setPoseSharing. 0 when disabled
+        Real getPoseSharing() const { return mPoseShareFrameQuantum; }
+
         /// Resets the transform of all bones to the binding pose. Manual bones are not reset
         void resetToPose();
 
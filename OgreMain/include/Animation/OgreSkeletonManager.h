@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "Animation/OgreSkeletonTrack.h"
 #include "OgreIdString.h"
 #include "OgreResourceManager.h"
 #include "OgreSingleton.h"
@@ -53,6 +54,9 @@ namespace Ogre
         typedef map<IdString, SkeletonDefPtr>::type SkeletonDefMap;
         SkeletonDefMap                              mSkeletonDefs;
 
+        bool                     mTrackCompressionEnabled;
+        SkeletonTrackCompression mTrackCompression;
+
     public:
         /// Constructor
         SkeletonManager();
@@ -78,6 +82,18 @@ namespace Ogre
         */
         void remove( const IdString &name );
 
+        /** When enabled, the animation tracks of the skeletons created from now on are
+            compressed with the given settings. Disabled by default.
+        @remarks
+            Saves a lot of memory for long animations (e.g. motion capture) but they lose a
+            bit of precision. See SkeletonTrackCompression.
+            Skeletons that were already created are not affected.
+        */
+        void setTrackCompression( bool bEnable,
+                                  const SkeletonTrackCompression &settings = SkeletonTrackCompression() );
+        bool getTrackCompressionEnabled() const { return mTrackCompressionEnabled; }
+        const SkeletonTrackCompression &getTrackCompression() const { return mTrackCompression; }
+
         /** Override standard Singleton retrieval.
         @remarks
         Why do we do this? Well, it's because the Singleton
@@ -46,6 +46,7 @@ namespace Ogre
         Real mInvNextFrameDistance;  // 1.0f / (KeyFrameRig[1].mFrame - KeyFrameRig[0].mFrame)
 
         // SoA variable. Packs posrotscale posrotscale ...
+        // Null when the track is compressed. See SkeletonTrack::getKeyFrameTransform
         KfTransform *RESTRICT_ALIAS mBoneTransform;
     };
 
@@ -53,8 +54,35 @@ namespace Ogre
 
     typedef FastArray<BoneTransform> TransformArray;
 
+    /// See SkeletonAnimationDef::build and SkeletonTrack::_prepareCompression
+    struct SkeletonTrackCompression
+    {
+        /// Keyframes are removed while interpolating their neighbours stays this close to them.
+        /// A channel (position, orientation or scale) that stays this close to its first value
+        /// during the whole animation is stored once.
+        Real positionTolerance;
+        /// In radians
+        Real orientationTolerance;
+        Real scaleTolerance;
+
+        SkeletonTrackCompression() :
+            positionTolerance( 1e-4f ),
+            orientationTolerance( 1e-3f ),
+            scaleTolerance( 1e-4f )
+        {
+        }
+    };
+
     class _OgreExport SkeletonTrack : public OgreAllocatedObj
     {
+    public:
+        enum AnimatedChannels
+        {
+            AnimatedPosition = 1u << 0u,
+            AnimatedOrientation = 1u << 1u,
+            AnimatedScale = 1u << 2u
+        };
+
     protected:
         /// There is one entry per each parent level
         KeyFrameRigVec mKeyFrameRigs;
@@ -81,6 +109,25 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mLocalMemoryManager;
 
+        /** Compressed tracks quantize each animated component of each keyframe to 16 bits,
+            relative to the range of values it takes in the track:
+                value = mDequantization[0] + quantized * mDequantization[1]
+            Channels that are not animated are stored in mDequantization[0] and take no space
+            in mQuantizedKeyFrames. mDequantization is null when the track is not compressed;
+            mQuantizedKeyFrames may also be null when compressed if no channel is animated.
+            Memory is owned by SkeletonAnimationDef.
+        */
+        KfTransform const *RESTRICT_ALIAS mDequantization;
+        /// ARRAY_PACKED_REALS values per animated component per keyframe. i.e. when only
+        /// position is animated: x x x x y y y y z z z z | x x x x y y y y z z z z | ...
+        uint16 const *RESTRICT_ALIAS mQuantizedKeyFrames;
+        /// Number of uint16 per keyframe in mQuantizedKeyFrames
+        uint32 mQuantizedStride;
+        /// Combination of AnimatedChannels
+        uint8 mAnimatedChannels;
+
+        inline void decompressKeyFrame( size_t keyFrameIdx, KfTransform &outTransform ) const;
+
     public:
         SkeletonTrack( uint32 boneBlockIdx, KfTransformArrayMemoryManager *kfTransformMemoryManager );
         ~SkeletonTrack();
@@ -127,6 +174,40 @@ namespace Ogre
             mUsedSlots <= (ARRAY_PACKED_REALS >> 1). Otherwise it does nothing.
         */
         void _bakeUnusedSlots();
+
+        bool isCompressed() const { return mDequantization != 0; }
+
+        /// Combination of AnimatedChannels. Only meaningful once compressed.
+        uint8 getAnimatedChannels() const { return mAnimatedChannels; }
+
+        /// Retrieves the transform of the given keyframe, decompressing it if needed
+        void getKeyFrameTransform( size_t keyFrameIdx, KfTransform &outTransform ) const;
+
+        /// Bytes used by the keyframes' transforms
+        size_t getKeyFrameDataSize() const;
+
+        /** First step of compressing this track. Removes the keyframes that can be
+            interpolated from their neighbours within the given tolerances, and looks
+            for the channels that don't change.
+        @remarks
+            The track keeps working uncompressed until _compress is called.
+        @return
+            Number of uint16 _compress needs in quantizedKeyFrames.
+        */
+        size_t _prepareCompression( const SkeletonTrackCompression &settings );
+
+        /// Number of uint16 per keyframe. Valid after _prepareCompression.
+        uint32 _getQuantizedStride() const { return mQuantizedStride; }
+
+        /** Quantizes the keyframes. After this call the track no longer references its
+            KfTransforms (mLocalMemoryManager can be destroyed).
+        @param dequantization
+            Memory for 2 KfTransforms. Must remain valid for as long as this track lives.
+        @param quantizedKeyFrames
+            Memory for as many values as returned by _prepareCompression.
+            Must remain valid for as long as this track lives.
+        */
+        void _compress( KfTransform *dequantization, uint16 *quantizedKeyFrames );
     };
 
     typedef vector<SkeletonTrack>::type SkeletonTrackVec;
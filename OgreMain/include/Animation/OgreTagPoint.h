@@ -125,12 +125,12 @@ namespace Ogre
         /// in world space (supporting non-uniform scaling), and decomposes the matrix
         /// into derived position/quaternion/scale (the quaternion and scale aren't very
         /// useful *if* the skeleton is actually using non-uniform scaling though)
-        static void updateAllTransformsBoneToTag( const size_t numNodes, Transform t );
+        static size_t updateAllTransformsBoneToTag( const size_t numNodes, Transform t );
 
         /// @See Node::updateAllTransforms.
         /// This version grabs the parent of a TagPoint, and derives the final transform
         /// of another TagPoint, respecting non-uniform scaling.
-        static void updateAllTransformsTagOnTag( const size_t numNodes, Transform t );
+        static size_t updateAllTransformsTagOnTag( const size_t numNodes, Transform t );
 
         virtual TagPoint *createChildTagPoint( const Vector3    &vPos = Vector3::ZERO,
                                                const Quaternion &qRot = Quaternion::IDENTITY );
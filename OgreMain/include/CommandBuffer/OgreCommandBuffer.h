@@ -123,6 +123,10 @@ namespace Ogre
             return retVal;
         }
 
+        /// Moves all the commands recorded in 'other' to the end of this command buffer.
+        /// 'other' is left empty. Offsets returned by other.getCommandOffset are invalidated.
+        void appendAndClear( CommandBuffer *other );
+
         /// Returns a pointer to the last created command
         CbBase *getLastCommand();
 
@@ -135,6 +139,13 @@ namespace Ogre
         /// Returns null if no such command at that offset (out of bounds).
         /// @see getCommandOffset.
         CbBase *getCommandFromOffset( size_t offset );
+
+        /// Returns the offset the next created command will have. @see rollbackTo.
+        size_t getEndOffset() const { return mCommandBuffer.size(); }
+
+        /// Removes the commands created after getEndOffset returned the given offset.
+        /// Offsets of the removed commands (@see getCommandOffset) become invalid.
+        void rollbackTo( size_t offset );
     };
 }  // namespace Ogre
 
@@ -147,6 +147,14 @@ namespace Ogre
         */
         virtual void postInitializePass( CompositorPass *pass ) {}
 
+        /** Returns true if _update should execute the given pass.
+        @param shadowNode
+            When in a caster pass, the current shadow node. Passes of shadow maps
+            that don't need to be updated are skipped. Null otherwise.
+        */
+        static bool shouldExecutePass( const CompositorPass *pass,
+                                       const CompositorShadowNode *shadowNode, uint8 executionMask );
+
     public:
         /** The Id must be unique across all engine so we can create unique named textures.
             The name is only unique across the workspace
@@ -98,6 +98,14 @@ namespace Ogre
 
         void execute( const Camera *lodCamera ) override;
 
+        /** Queues the culling execute will do into SceneManager::_addBatchedCull, so that it
+            gets culled together with other passes. Does nothing if the pass can't be batched
+            (e.g. it reuses the cull data or reorients the camera for each cubemap face).
+        @param lodCamera
+            Same as the one that will be passed to execute
+        */
+        void _addBatchedCull( const Camera *lodCamera );
+
         CompositorShadowNode *getShadowNode() const { return mShadowNode; }
         Camera               *getCamera() const { return mCamera; }
         void                  _setCustomCamera( Camera *camera ) { mCamera = camera; }
@@ -145,6 +145,15 @@ namespace Ogre
         /// the most recent frustum culling execution are used.
         bool mReuseCullData;
 
+        /** When true, objects hidden behind occluders (see MovableObject::setOccluder) are
+            discarded after frustum culling, using a low resolution depth buffer rasterized
+            on the CPU. See SceneManager::getOcclusionCullingStats.
+        @remarks
+            Only worth it when there are large occluders hiding lots of objects (i.e. cities,
+            indoors). Ignored by shadow caster passes.
+        */
+        bool mOcclusionCulling;
+
         /// Same as CompositorPassDef::mFlushCommandBuffers, but executed after the shadow node
         /// Note you may end up flushing twice if the shadow node also has flushing of its own
         ///
@@ -204,6 +213,7 @@ namespace Ogre
             mLodBias( 1.0f ),
             mInstancedStereo( false ),
             mReuseCullData( false ),
+            mOcclusionCulling( false ),
             mFlushCommandBuffersAfterShadowNode( false ),
             mUvBakingSet( 0xFF ),
             mBakeLightingOnly( false ),
@@ -235,6 +235,9 @@ namespace Ogre
 
         static inline ArrayInt SetAll( uint32 val ) { return val; }
 
+        /// Loads an uint16 and converts it to Real.
+        static inline ArrayReal LoadUnsignedShorts( const uint16 *src ) { return static_cast<Real>( *src ); }
+
         static inline void Set( ArrayReal &dst, Real val, size_t index ) { dst = val; }
 
         /** Returns the result of "a == std::numeric_limits<float>::infinity()"
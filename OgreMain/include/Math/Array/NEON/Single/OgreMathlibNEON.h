@@ -386,6 +386,12 @@ namespace Ogre
 
         static inline ArrayInt SetAll( uint32 val ) { return vdupq_n_u32( val ); }
 
+        /// Loads 4 consecutive uint16 and converts them to Real. No alignment required.
+        static inline ArrayReal LoadUnsignedShorts( const uint16 *src )
+        {
+            return vcvtq_f32_u32( vmovl_u16( vld1_u16( src ) ) );
+        }
+
         static inline void Set( ArrayReal &_dst, Real val, size_t index )
         {
             float *dst = reinterpret_cast<float *>( &_dst );
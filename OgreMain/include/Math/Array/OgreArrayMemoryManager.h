@@ -137,6 +137,22 @@ namespace Ogre
             virtual void performCleanup( uint16 level, const MemoryPoolVec &basePtrs,
                                          size_t const *elementsMemSizes, size_t startInstance,
                                          size_t diffInstances ) = 0;
+
+            /** Called by ArrayMemoryManager::defragmentIncremental. Same as performCleanup, but
+                only the instances in range [startInstance; endInstance) have been shifted
+                diffInstances places backwards. Everything past endInstance stays where it was.
+                @remarks
+                    The default implementation calls performCleanup, which is correct but
+                    goes through every instance past startInstance.
+                @param endInstance
+                    One past the last instance that was shifted.
+            */
+            virtual void performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                                size_t const *elementsMemSizes, size_t startInstance,
+                                                size_t endInstance, size_t diffInstances )
+            {
+                performCleanup( level, basePtrs, elementsMemSizes, startInstance, diffInstances );
+            }
         };
 
     protected:
@@ -156,6 +172,11 @@ namespace Ogre
         SlotsVec                    mAvailableSlots;
         RebaseListener             *mRebaseListener;
 
+        /// See setDeferredCleanup
+        bool mDeferredCleanup;
+        /// mCleanupThreshold was reached while mDeferredCleanup was true
+        bool mCleanupPending;
+
         /// The hierarchy depth level. This value is not used by the manager,
         /// just passed to the listeners so they can know to which level it
         /// belongs
@@ -230,6 +251,43 @@ namespace Ogre
         /// of fragmented slots reaches mCleanupThreshold
         void defragment();
 
+        /** Performs a bounded amount of the work done by defragment(), so that the cost
+            of compacting the pools can be spread across several frames.
+        @remarks
+            Slots keep their relative order. The first unused slots are moved towards the
+            end of the pool (merging with the other unused slots on their way) until they
+            can be released. All pointers remain valid between calls, thus it is safe to
+            keep using the pool (create, destroy, iterate) in the meantime.
+        @param maxSlotsToMove
+            Maximum number of slots to move in this call. The RebaseListener is only
+            notified about the slots that were moved.
+        @return
+            The number of slots that were moved. Unused slots that are already at the
+            end of the pool are released without counting towards maxSlotsToMove.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove );
+
+        /** When true, destroySlot won't call defragment() once the number of fragmented
+            slots goes above mCleanupThreshold. Instead isCleanupPending() will return true
+            until defragmentIncremental (or defragment) releases all the fragmented slots.
+            Useful to avoid spikes when lots of slots are destroyed at once.
+        @par
+            Default is false.
+        */
+        void setDeferredCleanup( bool bDeferred );
+        bool getDeferredCleanup() const { return mDeferredCleanup; }
+
+        /// See setDeferredCleanup
+        bool isCleanupPending() const { return mCleanupPending; }
+
+        /// Returns the number of slots that have been released but can't be
+        /// returned yet because they're not at the end of the pool.
+        size_t getNumFragmentedSlots() const { return mAvailableSlots.size(); }
+
+        /// Returns getNumFragmentedSlots() / getNumUsedSlotsIncludingFragmented(),
+        /// in range [0; 1]. 0 means no fragmentation.
+        float getFragmentationRatio() const;
+
         /// Defragments memory, then reallocates a smaller pool that tightly fits
         /// the current number of objects. Useful when you know you won't be creating
         /// more slots and you need to reclaim memory.
@@ -278,7 +336,22 @@ namespace Ogre
         @param prevNumSlots
             The previous value of mMaxMemory before changing mMemoryPools
         */
-        virtual void initializeEmptySlots( size_t prevNumSlots ) {}
+        void initializeEmptySlots( size_t prevNumSlots )
+        {
+            initializeEmptySlotRange( prevNumSlots, mMaxMemory );
+        }
+
+        /** Initializes the unused slots in range [startSlot; endSlot) to values derived
+            classes consider safe (e.g. pointing to dummy nodes). See initializeEmptySlots.
+        @remarks
+            defragmentIncremental also calls this for unused slots that are still
+            surrounded by used slots.
+        */
+        virtual void initializeEmptySlotRange( size_t startSlot, size_t endSlot ) {}
+
+        /// Default-initializes the memory of the unused slots in range [startSlot; endSlot)
+        /// using mCleanupRoutines, without touching the slots past endSlot.
+        void cleanupSlotRange( size_t startSlot, size_t endSlot );
     };
 
     /** Implementation to create the Transform variables needed by Nodes & SceneNodes
@@ -294,7 +367,7 @@ namespace Ogre
 
     protected:
         /// We overload to set all mParents to point to mDummyNode
-        void initializeEmptySlots( size_t prevNumSlots ) override;
+        void initializeEmptySlotRange( size_t startSlot, size_t endSlot ) override;
 
     public:
         enum MemoryTypes
@@ -310,6 +383,7 @@ namespace Ogre
             WorldMat,
             InheritOrientation,
             InheritScale,
+            Dirty,
             NumMemoryTypes
         };
 
@@ -366,7 +440,7 @@ namespace Ogre
 
     protected:
         /// We overload to set all mParents to point to mDummyNode
-        void initializeEmptySlots( size_t prevNumSlots ) override;
+        void initializeEmptySlotRange( size_t startSlot, size_t endSlot ) override;
 
     public:
         enum MemoryTypes
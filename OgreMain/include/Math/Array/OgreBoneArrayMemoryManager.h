@@ -49,7 +49,7 @@ namespace Ogre
     {
     protected:
         /// We overload to set all mParentTransform to point to a dummy matrix
-        void initializeEmptySlots( size_t prevNumSlots ) override;
+        void initializeEmptySlotRange( size_t startSlot, size_t endSlot ) override;
 
     public:
         enum MemoryTypes
@@ -168,6 +168,9 @@ namespace Ogre
                           const ArrayMemoryManager::PtrdiffVec &diffsList ) override;
         void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
                              size_t startInstance, size_t diffInstances ) override;
+        void performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                    size_t const *elementsMemSizes, size_t startInstance,
+                                    size_t endInstance, size_t diffInstances ) override;
     };
 
     /** @} */
@@ -68,6 +68,9 @@ namespace Ogre
         SceneMemoryMgrTypes mMemoryManagerType;
         NodeMemoryManager  *mTwinMemoryManager;
 
+        /// See setDeferredCleanup
+        bool mDeferredCleanup;
+
         /** Makes mMemoryManagers big enough to be able to fulfill mMemoryManagers[newDepth]
         @param newDepth
             Hierarchy level depth we wish to grow to.
@@ -191,6 +194,29 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::defragment
         void defragment();
 
+        /** Calls ArrayMemoryManager::defragmentIncremental on every depth level, until
+            maxSlotsToMove slots have been moved.
+        @param maxSlotsToMove
+            Maximum number of slots to move, in total.
+        @param onlyPendingCleanups
+            When true, only depth levels whose ArrayMemoryManager::isCleanupPending returns
+            true are defragmented. See setDeferredCleanup.
+        @return
+            The number of slots that were moved.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove, bool onlyPendingCleanups = false );
+
+        /// @copydoc ArrayMemoryManager::setDeferredCleanup
+        void setDeferredCleanup( bool bDeferred );
+        bool getDeferredCleanup() const { return mDeferredCleanup; }
+
+        /// Returns the sum of ArrayMemoryManager::getNumFragmentedSlots from all depth levels
+        size_t getNumFragmentedSlots() const;
+
+        /// Returns the sum of ArrayMemoryManager::getNumUsedSlotsIncludingFragmented
+        /// from all depth levels
+        size_t getNumUsedSlotsIncludingFragmented() const;
+
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFit();
 
@@ -211,6 +237,14 @@ namespace Ogre
         */
         size_t getFirstNode( Transform &outTransform, size_t depth );
 
+        /** Resets Transform::mDirty of all nodes from the given depth onwards.
+            Used on static nodes so that the changes from their last update don't
+            keep forcing their children to update.
+        @param firstDepth
+            First hierarchy level depth to reset.
+        */
+        void _clearDirtyFlags( size_t firstDepth );
+
         // Derived from ArrayMemoryManager::RebaseListener
         void buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                             ArrayMemoryManager::PtrdiffVec &outDiffsList ) override;
@@ -218,6 +252,9 @@ namespace Ogre
                           const ArrayMemoryManager::PtrdiffVec &diffsList ) override;
         void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
                              size_t startInstance, size_t diffInstances ) override;
+        void performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                    size_t const *elementsMemSizes, size_t startInstance,
+                                    size_t endInstance, size_t diffInstances ) override;
     };
 
     /** @} */
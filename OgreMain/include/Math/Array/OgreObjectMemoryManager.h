@@ -32,6 +32,8 @@ THE SOFTWARE.
 #include "Math/Array/OgreObjectData.h"
 
 #include "Math/Array/OgreTransform.h"
+#include "OgreFastArray.h"
+#include "OgreVector3.h"
 
 namespace Ogre
 {
@@ -55,7 +57,34 @@ namespace Ogre
     */
     class _OgreExport ObjectMemoryManager final : ArrayMemoryManager::RebaseListener
     {
+    public:
+        /// Number of consecutive slots of a render queue whose bounds are merged into
+        /// one Cluster. Must be a multiple of ARRAY_PACKED_REALS. @See setClusterCulling
+        static const size_t c_objsPerCluster = ARRAY_PACKED_REALS * 16u;
+
+        /// World space bounds of c_objsPerCluster consecutive objects. Stored as min/max
+        /// rather than center/half size so that objects with infinite bounds can be merged in.
+        struct Cluster
+        {
+            Vector3 vMin;
+            Vector3 vMax;
+        };
+
+    private:
         typedef vector<ObjectDataArrayMemoryManager>::type ArrayMemoryManagerVec;
+        typedef FastArray<Cluster>                         ClusterArray;
+
+        struct ClusterList
+        {
+            ClusterArray clusters;
+            /// False when slots were created, moved or rebased since the clusters were last
+            /// built. Invalid lists are ignored by culling until the next _updateClusters.
+            bool valid;
+
+            ClusterList() : valid( false ) {}
+        };
+        typedef vector<ClusterList>::type ClusterListVec;
+
         /// ArrayMemoryManagers grouped by hierarchy depth
         ArrayMemoryManagerVec mMemoryManagers;
 
@@ -74,6 +103,15 @@ namespace Ogre
         SceneMemoryMgrTypes  mMemoryManagerType;
         ObjectMemoryManager *mTwinMemoryManager;
 
+        /// See setDeferredCleanup
+        bool mDeferredCleanup;
+
+        /// One entry per render queue. Empty if mClusterCulling is false.
+        ClusterListVec mClusterLists;
+        bool           mClusterCulling;
+
+        void invalidateClusters( size_t renderQueue );
+
         /** Makes mMemoryManagers big enough to be able to fulfill mMemoryManagers[newDepth]
         @param newDepth
             Hierarchy level depth we wish to grow to.
@@ -135,6 +173,29 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::defragment
         void defragment();
 
+        /** Calls ArrayMemoryManager::defragmentIncremental on every render queue, until
+            maxSlotsToMove slots have been moved.
+        @param maxSlotsToMove
+            Maximum number of slots to move, in total.
+        @param onlyPendingCleanups
+            When true, only render queues whose ArrayMemoryManager::isCleanupPending returns
+            true are defragmented. See setDeferredCleanup.
+        @return
+            The number of slots that were moved.
+        */
+        size_t defragmentIncremental( size_t maxSlotsToMove, bool onlyPendingCleanups = false );
+
+        /// @copydoc ArrayMemoryManager::setDeferredCleanup
+        void setDeferredCleanup( bool bDeferred );
+        bool getDeferredCleanup() const { return mDeferredCleanup; }
+
+        /// Returns the sum of ArrayMemoryManager::getNumFragmentedSlots from all render queues
+        size_t getNumFragmentedSlots() const;
+
+        /// Returns the sum of ArrayMemoryManager::getNumUsedSlotsIncludingFragmented
+        /// from all render queues
+        size_t getNumUsedSlotsIncludingFragmented() const;
+
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFit();
 
@@ -182,6 +243,53 @@ namespace Ogre
         */
         size_t getFirstObjectData( ObjectData &outObjectData, size_t renderQueue );
 
+        /** Enables keeping the world bounds of every c_objsPerCluster consecutive objects
+            of each render queue, so that frustum culling can discard all of them with a
+            single test before looking at the objects themselves.
+        @remarks
+            The clusters are rebuilt whenever SceneManager updates the bounds of this
+            manager (every frame for dynamic objects, only when they're dirty for static
+            ones), which costs slightly more than what it saves if the objects are scattered
+            all over the scene. Objects are clustered in the order they were created, hence
+            this pays off when nearby objects get created together (i.e. a level being loaded),
+            which is usually the case for static geometry.
+        @par
+            Disabled by default.
+        */
+        void setClusterCulling( bool bEnable );
+        bool getClusterCulling() const { return mClusterCulling; }
+
+        /** Sizes the cluster lists to fit all render queues and flags them as valid.
+            Must be called from the main thread before calling _updateClusters
+            for all the objects.
+        */
+        void _prepareClusters();
+
+        /** Rebuilds the clusters covering the given range of objects from their world Aabbs.
+            Different threads can update different ranges concurrently.
+        @param renderQueue
+            Render queue the objects belong to.
+        @param firstObj
+            Index of the first object. Must be a multiple of c_objsPerCluster.
+        @param numObjs
+            Number of objects. Must be a multiple of c_objsPerCluster unless the
+            range reaches the last object of the render queue.
+        @param objData
+            ObjectData pointing to firstObj.
+        */
+        void _updateClusters( size_t renderQueue, size_t firstObj, size_t numObjs,
+                              ObjectData objData );
+
+        /// Grows the cluster the object belongs to so it contains the given world Aabb.
+        /// Used when a single object updates its bounds after _updateClusters.
+        void _growCluster( const ObjectData &objData, size_t renderQueue, const Aabb &worldAabb );
+
+        /** Returns the clusters of the given render queue, where cluster i contains the objects
+            [i * c_objsPerCluster; (i + 1) * c_objsPerCluster). Null if cluster culling is
+            disabled, or the clusters are out of date.
+        */
+        const Cluster *_getClusters( size_t renderQueue ) const;
+
         // Derived from ArrayMemoryManager::RebaseListener
         void buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                             ArrayMemoryManager::PtrdiffVec &outDiffsList ) override;
@@ -189,6 +297,9 @@ namespace Ogre
                           const ArrayMemoryManager::PtrdiffVec &diffsList ) override;
         void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
                              size_t startInstance, size_t diffInstances ) override;
+        void performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                    size_t const *elementsMemSizes, size_t startInstance,
+                                    size_t endInstance, size_t diffInstances ) override;
     };
 
     /** @} */
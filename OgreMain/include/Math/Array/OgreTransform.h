@@ -36,6 +36,17 @@ namespace Ogre
     /** Represents the transform of a single object, arranged in SoA (Structure of Arrays) */
     struct Transform
     {
+        /// Bits stored in mDirty
+        enum DirtyFlags
+        {
+            /// Our position, orientation, scale, inheritance or parent changed since the last
+            /// time our derived transform was updated. Set by Node's setters.
+            DirtyLocal = 1u << 0u,
+            /// Our derived transform changed in the last update, thus our children must be
+            /// updated too. Set by Node::updateAllTransforms & Node::updateDirtyTransforms.
+            DirtyDerived = 1u << 1u
+        };
+
         /// Which of the packed values is ours. Value in range [0; 4) for SSE2
         unsigned char mIndex;
 
@@ -74,6 +85,9 @@ namespace Ogre
         /// Ours is mInheritScale[mIndex]
         bool *RESTRICT_ALIAS mInheritScale;
 
+        /// Combination of DirtyFlags. Ours is mDirty[mIndex]
+        uint8 *RESTRICT_ALIAS mDirty;
+
         Transform() :
             mIndex( 0 ),
             mParents( 0 ),
@@ -86,7 +100,8 @@ namespace Ogre
             mDerivedScale( 0 ),
             mDerivedTransform( 0 ),
             mInheritOrientation( 0 ),
-            mInheritScale( 0 )
+            mInheritScale( 0 ),
+            mDirty( 0 )
         {
         }
 
@@ -100,7 +115,8 @@ namespace Ogre
             those two options should memcpy memory, or rebase the pointers, hence
             explicit functions are much preferred. @See rebasePtrs
 
-            Note that we do NOT copy the mIndex member.
+            Note that we do NOT copy the mIndex member. The copy is flagged as DirtyLocal
+            since we're usually copied because our parent or depth level changed.
         */
         void copy( const Transform &inCopy )
         {
@@ -138,6 +154,8 @@ namespace Ogre
 
             mInheritOrientation[mIndex] = inCopy.mInheritOrientation[inCopy.mIndex];
             mInheritScale[mIndex] = inCopy.mInheritScale[inCopy.mIndex];
+
+            mDirty[mIndex] = DirtyLocal;
         }
 
         /** Rebases all the pointers from our SoA structs so that they point to a new location
@@ -174,6 +192,7 @@ namespace Ogre
                 newBasePtrs[NodeArrayMemoryManager::InheritOrientation] + diff );
             mInheritScale =
                 reinterpret_cast<bool *>( newBasePtrs[NodeArrayMemoryManager::InheritScale] + diff );
+            mDirty = reinterpret_cast<uint8 *>( newBasePtrs[NodeArrayMemoryManager::Dirty] + diff );
         }
 
         /** Advances all pointers to the next pack, i.e. if we're processing 4 elements at a time, move
@@ -192,6 +211,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS;
             mInheritOrientation += ARRAY_PACKED_REALS;
             mInheritScale += ARRAY_PACKED_REALS;
+            mDirty += ARRAY_PACKED_REALS;
         }
 
         void advancePack( size_t numAdvance )
@@ -207,6 +227,7 @@ namespace Ogre
             mDerivedTransform += ARRAY_PACKED_REALS * numAdvance;
             mInheritOrientation += ARRAY_PACKED_REALS * numAdvance;
             mInheritScale += ARRAY_PACKED_REALS * numAdvance;
+            mDirty += ARRAY_PACKED_REALS * numAdvance;
         }
     };
 }  // namespace Ogre
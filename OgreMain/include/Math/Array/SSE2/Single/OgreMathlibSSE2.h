@@ -268,6 +268,13 @@ namespace Ogre
 
         static inline ArrayInt SetAll( uint32 val ) { return _mm_set1_epi32( static_cast<int>( val ) ); }
 
+        /// Loads 4 consecutive uint16 and converts them to Real. No alignment required.
+        static inline ArrayReal LoadUnsignedShorts( const uint16 *src )
+        {
+            const __m128i vals = _mm_loadl_epi64( reinterpret_cast<const __m128i *>( src ) );
+            return _mm_cvtepi32_ps( _mm_unpacklo_epi16( vals, _mm_setzero_si128() ) );
+        }
+
         static inline void Set( ArrayReal &_dst, Real val, size_t index )
         {
             float *dst = reinterpret_cast<float *>( &_dst );
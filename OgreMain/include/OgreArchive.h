@@ -165,6 +165,14 @@ namespace Ogre
         */
         virtual void remove( const String &filename );
 
+        /** Renames a file, replacing the destination if it already exists.
+        @remarks Not possible on read-only archives. Used to replace a file atomically
+            after writing it under a temporary name.
+        @param oldFilename The fully qualified name of the file to rename
+        @param newFilename The fully qualified new name
+        */
+        virtual void rename( const String &oldFilename, const String &newFilename );
+
         /** List all file names in the archive.
         @note
             This method only returns filenames, you can also retrieve other
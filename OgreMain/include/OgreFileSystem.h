@@ -106,6 +106,9 @@ namespace Ogre
         /// @copydoc Archive::remove
         void remove( const String &filename ) override;
 
+        /// @copydoc Archive::rename
+        void rename( const String &oldFilename, const String &newFilename ) override;
+
         /// @copydoc Archive::list
         StringVectorPtr list( bool recursive = true, bool dirs = false ) override;
 
@@ -32,7 +32,7 @@ THE SOFTWARE.
 
 #include "OgreForwardPlusBase.h"
 #include "OgreRawPtr.h"
-#include "Threading/OgreUniformScalableTask.h"
+#include "Threading/OgreTaskScheduler.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -46,7 +46,7 @@ namespace Ogre
      */
 
     /** Implementation of Clustered Forward Shading */
-    class _OgreExport ForwardClustered : public ForwardPlusBase, public UniformScalableTask
+    class _OgreExport ForwardClustered : public ForwardPlusBase, public Task
     {
         struct ArrayPlane
         {
@@ -121,7 +121,8 @@ namespace Ogre
         void setFreezeDebugFrustum( bool freezeDebugFrustum );
         bool getFreezeDebugFrustum() const;
 
-        void execute( size_t threadId, size_t numThreads ) override;
+        /// Collects the lights of one slice. Called from the worker threads.
+        void execute( size_t chunkIdx, size_t threadIdx ) override;
 
         void collectLights( Camera *camera ) override;
 
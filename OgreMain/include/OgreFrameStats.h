@@ -30,6 +30,8 @@ THE SOFTWARE.
 
 #include "OgreMemoryAllocatorConfig.h"
 
+#include "OgreFastArray.h"
+
 namespace Ogre
 {
     /** \addtogroup Core
@@ -40,8 +42,43 @@ namespace Ogre
      */
 
 #define OGRE_FRAME_STATS_SAMPLES 60
+#define OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS 4
+/// Histogram buckets are 1ms wide. The last one gathers everything above
+#define OGRE_FRAME_STATS_HISTOGRAM_BUCKETS 100
+
+    namespace FrameStage
+    {
+        /// Parts of a frame FrameStats keeps track of, so that slow frames can be
+        /// attributed to something. Note that stages may nest (e.g. Compositor
+        /// contains most of the ShaderCompile and TextureStreamingStall time)
+        enum FrameStage
+        {
+            /// SceneManager::updateSceneGraph
+            SceneUpdate,
+            /// Updating all workspaces, including swapping buffers
+            Compositor,
+            /// Time the render thread spent creating & compiling shaders.
+            /// See Hlms::ShaderGenerationStats::compileTimeUs
+            ShaderCompile,
+            /// Time the render thread spent blocked waiting for textures to stream.
+            /// See TextureGpuManager::getStreamingStallTimeUs
+            TextureStreamingStall,
+            NumFrameStages
+        };
+    }  // namespace FrameStage
+
     /** All return values are either in milliseconds or frames per second;
         but they're internally stored in microseconds
+    @remarks
+        Besides the last OGRE_FRAME_STATS_SAMPLES frames (used by getAvgTime & co.),
+        FrameStats also keeps:
+            - A bigger window of frames (see setWindowSize) for percentiles and per-stage
+              breakdowns (see getPercentile, getStageAvgTime)
+            - A histogram since the last reset, with 1ms buckets (see getHistogramBucket)
+            - Hitch counters since the last reset (see setHitchThresholds)
+
+        All of them are O(1) per frame. Only percentiles need some work (O(window size))
+        and only when they're asked for. Thus they're meant to be left enabled.
     */
     class _OgreExport FrameStats : public OgreAllocatedObj
     {
@@ -52,8 +89,27 @@ namespace Ogre
         unsigned long mFrameTimes[OGRE_FRAME_STATS_SAMPLES];
         size_t        mFramesSampled;
 
+        /// Ring buffers of size mWindowSize. Frame times are in microseconds
+        FastArray<uint32> mWindowFrameTimes;
+        FastArray<uint32> mWindowStageTimes[FrameStage::NumFrameStages];
+        size_t            mWindowSize;
+        size_t            mWindowNext;
+        size_t            mWindowSampled;
+
+        /// Stage times of the frame currently being measured, in microseconds
+        uint64 mPendingStageTimes[FrameStage::NumFrameStages];
+
+        uint32 mHitchThresholds[OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS];
+        uint64 mNumHitches[OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS];
+        size_t mNumHitchThresholds;
+
+        uint64 mHistogram[OGRE_FRAME_STATS_HISTOGRAM_BUCKETS];
+        uint64 mTotalFrames;
+
+        mutable FastArray<uint32> mScratch;
+
     public:
-        FrameStats() { reset( 0 ); }
+        FrameStats();
 
         float getFps() const { return 1000.0f / getLastTime(); }
         float getAvgFps() const { return 1000.0f / getAvgTime(); }
@@ -89,28 +145,72 @@ namespace Ogre
         }
 
         /// Adds a new measured time, in *microseconds*
-        void addSample( uint64 timeMs )
+        void addSample( uint64 timeMs );
+
+        /** Adds time spent in a stage of the current frame. Can be called multiple times
+            per frame; the times are added together until the next addSample.
+            Must be called from the same thread that calls addSample.
+        @param timeUs
+            Time in *microseconds*
+        */
+        void addStageTime( FrameStage::FrameStage stage, uint64 timeUs )
         {
-            unsigned long frameTimeMs = static_cast<unsigned long>( timeMs - mLastTime );
-            mFrameTimes[mNextFrame] = frameTimeMs;
-            mBestFrameTime = std::min( frameTimeMs, mBestFrameTime );
-            mWorstFrameTime = std::max( frameTimeMs, mWorstFrameTime );
-
-            mFramesSampled = std::min<size_t>( ( mFramesSampled + 1 ), OGRE_FRAME_STATS_SAMPLES );
-            mNextFrame = ( mNextFrame + 1 ) % OGRE_FRAME_STATS_SAMPLES;
-
-            mLastTime = timeMs;
+            mPendingStageTimes[stage] += timeUs;
         }
 
-        void reset( uint64 timeMs )
-        {
-            mNextFrame = 0;
-            mBestFrameTime = std::numeric_limits<unsigned long>::max();
-            mWorstFrameTime = 0;
-            mLastTime = timeMs;
-            memset( mFrameTimes, 0, sizeof( unsigned long ) * OGRE_FRAME_STATS_SAMPLES );
-            mFramesSampled = 0;
-        }
+        void reset( uint64 timeMs );
+
+        /** Sets how many of the latest frames are used for percentiles & stage stats.
+            Resets the window.
+        @param numFrames
+            0 to disable. Default is 600
+        */
+        void   setWindowSize( size_t numFrames );
+        size_t getWindowSize() const { return mWindowSize; }
+        /// Number of frames currently in the window. Never bigger than getWindowSize
+        size_t getNumWindowFrames() const { return mWindowSampled; }
+
+        /** Returns the frame time at the given percentile of the window (nearest rank)
+        @param percentile
+            In range [0; 100]. e.g. 99 for p99
+        @return
+            Time in milliseconds. 0 if the window is empty
+        */
+        float getPercentile( float percentile ) const;
+        /// Average frame time in the window, in milliseconds. Unlike getAvgTime, which
+        /// only covers the last OGRE_FRAME_STATS_SAMPLES frames
+        float getWindowAvgTime() const;
+        /// Worst frame time in the window, in milliseconds
+        float getWindowWorstTime() const;
+
+        /// Average time spent in the given stage per frame, across the window. In milliseconds
+        float getStageAvgTime( FrameStage::FrameStage stage ) const;
+        /// Worst time spent in the given stage in a single frame of the window. In milliseconds
+        float getStageWorstTime( FrameStage::FrameStage stage ) const;
+
+        /** Frames slower than these thresholds are counted as hitches. Resets hitch counters.
+        @param thresholdsMs
+            Array of thresholds, in milliseconds
+        @param numThresholds
+            Up to OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS.
+            Default is 3 thresholds: 33.3ms, 50ms and 100ms
+        */
+        void setHitchThresholds( const float *thresholdsMs, size_t numThresholds );
+        size_t getNumHitchThresholds() const { return mNumHitchThresholds; }
+        float  getHitchThreshold( size_t idx ) const { return mHitchThresholds[idx] * 0.001f; }
+        /// Number of frames (since reset) that took longer than getHitchThreshold( idx )
+        uint64 getNumHitches( size_t idx ) const { return mNumHitches[idx]; }
+
+        /// Number of frames (since reset) that took [idx; idx + 1) milliseconds.
+        /// The last bucket contains all the frames that took longer.
+        uint64 getHistogramBucket( size_t idx ) const { return mHistogram[idx]; }
+        /// Number of frames since reset
+        uint64 getTotalFrames() const { return mTotalFrames; }
+
+        /// Human readable summary of all the stats, e.g. for logging
+        void dumpStats( String &outString ) const;
+        /// Writes dumpStats' output to the Ogre log
+        void logStats() const;
     };
 
 }  // Namespace Ogre
@@ -43,6 +43,7 @@ namespace Ogre
 {
     class CompositorShadowNode;
     struct QueuedRenderable;
+    class TaskScheduler;
     typedef vector<Archive *>::type ArchiveVec;
 
     /** \addtogroup Core
@@ -182,6 +183,12 @@ namespace Ogre
             /// Contains merged properties (pass and renderable's)
             RenderableCache mergedCache;
             GpuProgramPtr   shaders[NumShaderTypes];
+            /// Template & piece files (see TemplateSources::fileNames) the generated
+            /// shaders depend on. Sorted.
+            FastArray<uint16> templateDependencies;
+            /// Pieces the templates tried to insert but weren't defined by anyone.
+            /// Defining them in a piece file would change the generated shaders.
+            IdStringVec missingPieces;
 
             ShaderCodeCache( const PiecesMap *_pieces ) : mergedCache( HlmsPropertyVec(), _pieces ) {}
 
@@ -221,6 +228,232 @@ namespace Ogre
         HlmsPropertyVec mSetProperties;
         PiecesMap       mPieces;
 
+        /// State the template preprocessor reads & modifies while expanding a shader variant.
+        /// Each thread expanding templates at the same time needs its own.
+        struct ThreadData
+        {
+            HlmsPropertyVec setProperties;
+            PiecesMap       pieces;
+
+            /// Dependency tracking. Index (in TemplateSources::fileNames) of the file being
+            /// parsed, TemplateSources::NoFile if not tracking.
+            uint16 currentFile;
+            /// Which file defined each piece in 'pieces'
+            map<IdString, uint16>::type pieceOrigins;
+            /// See ShaderCodeCache::templateDependencies & ShaderCodeCache::missingPieces
+            FastArray<uint16> dependencies;
+            IdStringVec       missingPieces;
+
+            ThreadData();
+        };
+
+        /** A template or piece file parsed once when it's loaded, so that expanding a variant
+            doesn't need to parse it again. The @pset & co. don't depend on anything else than
+            the order they appear, thus they become a list of operations. The @foreach and
+            @property blocks become a tree that is walked with the properties of the variant.
+        @remarks
+            Equivalent to parseMath + parseForEach + parseProperties. Files using syntax the
+            tree can't reproduce exactly (or with syntax errors) only have their @pset & co.
+            compiled; the rest is parsed like before (see isCompiled).
+        */
+        struct CompiledTemplate
+        {
+            static const uint32 NoNode = 0xFFFFFFFF;
+
+            /// A number, or the value of a property if isNumber is false
+            struct Arg
+            {
+                IdString property;
+                int32    value;
+                bool     isNumber;
+            };
+
+            /// @pset, @padd, etc.
+            struct MathOp
+            {
+                IdString dstProperty;
+                Arg      op1;
+                Arg      op2;
+                uint8    operation;
+            };
+
+            /// Range of 'text' (or 'varNames') to output. Or the value of the counter of
+            /// the @foreach at nesting level counterLevel, if counterLevel >= 0
+            struct TextSegment
+            {
+                uint32 start;
+                uint32 length;
+                int32  counterLevel;
+            };
+
+            /// Parsed @property() expression. See Hlms::Expression
+            struct ExpressionNode
+            {
+                uint8 type;  ///< ExpressionType
+                bool  negated;
+                /// EXPR_VAR. If numSegments > 0 the name contains @foreach counters and
+                /// must be formed again from 'segments'
+                Arg    var;
+                uint32 firstSegment;
+                uint32 numSegments;
+                /// EXPR_OBJECT
+                uint32 firstChild;
+                uint32 nextSibling;
+            };
+
+            enum NodeType
+            {
+                NodeText,
+                NodeForEach,
+                NodeProperty
+            };
+
+            struct Node
+            {
+                NodeType type;
+                /// NodeText
+                uint32 firstSegment;
+                uint32 numSegments;
+                /// NodeForEach. The counter is at nesting level 'counterLevel'
+                Arg    count;
+                Arg    start;
+                uint32 counterLevel;
+                /// NodeProperty
+                uint32 expression;
+                /// Body of @foreach; or the block of @property when it evaluates to true
+                uint32 firstChild;
+                /// Block after @property's @else
+                uint32 firstElseChild;
+                uint32 nextSibling;
+            };
+
+            /// Maximum @foreach nesting supported by the tree
+            static const uint32 MaxForEachNesting = 8u;
+
+            /// The file after removing the @pset & co.
+            String                    text;
+            FastArray<MathOp>         mathOps;
+            bool                      mathSyntaxError;
+            bool                      isCompiled;
+            FastArray<TextSegment>    segments;
+            FastArray<ExpressionNode> expressions;
+            /// Names of the properties in expressions that contain @foreach counters
+            String                    varNames;
+            FastArray<Node>           nodes;
+            uint32                    firstNode;
+            /// Properties used as the start of a @foreach. They're invalid if not set
+            FastArray<IdString>       forEachStartProperties;
+
+            CompiledTemplate();
+        };
+
+        /// Raw contents of the templates & their piece files. Loaded once (and again after
+        /// the shader cache is cleared) so that generating a variant doesn't touch the Archives.
+        struct TemplateSources
+        {
+            static const uint16 NoFile = 0xFFFF;
+
+            bool   hasTemplate[NumShaderTypes];
+            String templateFile[NumShaderTypes];
+            /// Library piece files first, then our own. Only those matching mShaderFileExt.
+            StringVector pieceFiles[NumShaderTypes];
+
+            /// Every file above, without repetitions (".any" piece files are shared by the
+            /// stages). Relative to its Archive, so that caches survive moving the install
+            /// folder. Library files are prefixed with "Library<index>/" to tell them apart.
+            StringVector fileNames;
+            /// 128-bit hash of the contents of each file in fileNames (2 entries per file)
+            FastArray<uint64> fileHashes;
+            /// Whether the file uses directives that modify the properties or remove
+            /// pieces (e.g. @set, @undefpiece). Every shader of the stage depends on them.
+            FastArray<uint8> fileModifiesProperties;
+            /// Index in fileNames of templateFile & pieceFiles
+            uint16            templateFileId[NumShaderTypes];
+            FastArray<uint16> pieceFileIds[NumShaderTypes];
+
+            /// templateFile & pieceFiles, compiled. See CompiledTemplate
+            CompiledTemplate                     compiledTemplate[NumShaderTypes];
+            vector<CompiledTemplate>::type compiledPieceFiles[NumShaderTypes];
+
+            /// Adds the file to fileNames if it's not there yet. Returns its index.
+            uint16 addFile( const String &fileName, const String &contents );
+            /// Returns NoFile if not found
+            uint16 findFile( const String &fileName ) const;
+
+            TemplateSources();
+        };
+
+        /// A shader variant scheduled for generation in the worker threads.
+        /// See Hlms::setParallelShaderGeneration
+        struct PendingShaderCode
+        {
+            ShaderCodeCache codeCache;
+            /// Filled by the worker threads: the final properties (templates can modify
+            /// them), the generated source code, and how long it took
+            HlmsPropertyVec finalProperties;
+            String          source[NumShaderTypes];
+            String          debugFilenameOutput[NumShaderTypes];
+            bool            syntaxError[NumShaderTypes];
+            uint64          generationTimeUs;
+
+            PendingShaderCode( const ShaderCodeCache &_codeCache );
+        };
+
+        typedef vector<PendingShaderCode>::type PendingShaderCodeVec;
+
+        class AsyncShaderGenerationTask;
+
+    public:
+        struct ShaderGenerationStats
+        {
+            /// Number of new shader variants (i.e. mShaderCodeCache entries) created
+            uint32 numVariants;
+            /// Out of numVariants, how many had their templates expanded by the worker threads
+            uint32 numParallelVariants;
+            /// Time spent expanding templates, summed across all threads
+            uint64 generationTimeUs;
+            /// Time spent creating & compiling the GPU programs in the render thread
+            uint64 compileTimeUs;
+            /// Time it took each variant to be generated & compiled, in order of creation
+            FastArray<uint32> variantTimeUs;
+            /// Number of times getMaterial returned null because the shaders weren't ready
+            /// (see setAsyncShaderCompilation)
+            uint32 numSkippedRenderables;
+
+            ShaderGenerationStats();
+            void reset();
+        };
+
+    protected:
+        TemplateSources     *mTemplateSources;
+        PendingShaderCodeVec mPendingShaderCode;
+        /// Sorted. Final hashes (see getMaterial) already scheduled through _queueShaderGeneration
+        FastArray<uint32> mPendingFinalHashes;
+
+        bool                  mParallelShaderGeneration;
+        bool                  mParallelCommandGeneration;
+        bool                  mUseCompiledTemplates;
+        bool                  mAsyncShaderCompilation;
+        uint32                mMaxAsyncCompilesPerFrame;
+        /// Variants requested by getMaterial while mAsyncShaderCompilation is enabled,
+        /// waiting for their templates to be expanded.
+        PendingShaderCodeVec  mAsyncShaderCode;
+        /// Variants being expanded by mAsyncGenerationTask. The render thread must not
+        /// modify them (nor resize the container) until the task is finished.
+        PendingShaderCodeVec  mAsyncGeneratingShaderCode;
+        /// Variants already expanded, waiting to be compiled when the frame ends.
+        PendingShaderCodeVec  mAsyncGeneratedShaderCode;
+        TaskScheduler        *mAsyncTaskScheduler;
+        AsyncShaderGenerationTask *mAsyncGenerationTask;
+        /// TaskScheduler::TaskId of mAsyncGenerationTask. TaskScheduler::FinishedTask if idle.
+        uint64 mAsyncGenerationTaskId;
+        /// When true, createShaderCacheEntry assumes mSetProperties already holds the
+        /// merged properties (see createShaderCacheEntryAsync)
+        bool mShaderCacheEntryPropertiesMerged;
+        Timer                *mTimer;
+        ShaderGenerationStats mCurrentFrameStats;
+        ShaderGenerationStats mLastFrameStats;
+
     public:
         struct Library
         {
@@ -326,20 +559,23 @@ namespace Ogre
 
         typedef std::vector<Expression> ExpressionVec;
 
-        inline int interpretAsNumberThenAsProperty( const String &argValue ) const;
+        static inline int interpretAsNumberThenAsProperty( const String   &argValue,
+                                                           const ThreadData &td );
 
         static void copy( String &outBuffer, const SubStringRef &inSubString, size_t length );
         static void repeat( String &outBuffer, const SubStringRef &inSubString, size_t length,
                             size_t passNum, const String &counterVar );
 
-        bool parseMath( const String &inBuffer, String &outBuffer );
-        bool parseForEach( const String &inBuffer, String &outBuffer ) const;
-        bool parseProperties( String &inBuffer, String &outBuffer ) const;
-        bool parseUndefPieces( String &inBuffer, String &outBuffer );
-        bool collectPieces( const String &inBuffer, String &outBuffer );
-        bool insertPieces( String &inBuffer, String &outBuffer ) const;
-        bool parseCounter( const String &inBuffer, String &outBuffer );
-        bool parse( const String &inBuffer, String &outBuffer ) const;
+        /// The parse functions only read & modify the given ThreadData. They can be called
+        /// from multiple threads simultaneously as long as each thread uses its own.
+        static bool parseMath( const String &inBuffer, String &outBuffer, ThreadData &td );
+        static bool parseForEach( const String &inBuffer, String &outBuffer, const ThreadData &td );
+        static bool parseProperties( String &inBuffer, String &outBuffer, const ThreadData &td );
+        static bool parseUndefPieces( String &inBuffer, String &outBuffer, ThreadData &td );
+        static bool collectPieces( const String &inBuffer, String &outBuffer, ThreadData &td );
+        static bool insertPieces( String &inBuffer, String &outBuffer, ThreadData &td );
+        static bool parseCounter( const String &inBuffer, String &outBuffer, ThreadData &td );
+        static bool parse( const String &inBuffer, String &outBuffer, const ThreadData &td );
 
         /** Goes through 'buffer', starting from startPos (inclusive) looking for the given
             character while skipping whitespace. If any character other than whitespace or
@@ -355,8 +591,10 @@ namespace Ogre
         static bool findBlockEnd( SubStringRef &outSubString, bool &syntaxError,
                                   bool allowsElse = false );
 
-        bool  evaluateExpression( SubStringRef &outSubString, bool &outSyntaxError ) const;
-        int32 evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError ) const;
+        static bool  evaluateExpression( SubStringRef &outSubString, bool &outSyntaxError,
+                                         const ThreadData &td );
+        static int32 evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError,
+                                                  const ThreadData &td );
         static size_t evaluateExpressionEnd( const SubStringRef &outSubString );
 
         static void evaluateParamArgs( SubStringRef &outSubString, StringVector &outArgs,
@@ -365,6 +603,49 @@ namespace Ogre
         static unsigned long calculateLineCount( const String &buffer, size_t idx );
         static unsigned long calculateLineCount( const SubStringRef &subString );
 
+        /// Splits the expression at the start of outSubString into tokens. Advances outSubString
+        /// past the expression. See evaluateExpression
+        static void parseExpression( SubStringRef &outSubString, ExpressionVec &outExpressions,
+                                     bool &outSyntaxError );
+
+        /// Compiles a template or piece file. See CompiledTemplate
+        static void compileTemplate( const String &source, CompiledTemplate &outCompiled );
+        static bool compileMath( const String &inBuffer, CompiledTemplate &outCompiled );
+        /// Compiles the @foreach & @property blocks in the range [start; end) of outCompiled.text
+        /// Returns the first node, CompiledTemplate::NoNode if empty. outFailed is set to
+        /// true if the tree can't reproduce it.
+        static uint32 compileBlocks( CompiledTemplate &outCompiled, size_t start, size_t end,
+                                     StringVector &counterVars, bool &outFailed );
+        static void   compileText( CompiledTemplate &outCompiled, const String &buffer,
+                                   size_t start, size_t end, const StringVector &counterVars,
+                                   uint32 &outFirstSegment, uint32 &outNumSegments );
+        static uint32 compileExpression( CompiledTemplate &outCompiled,
+                                         const ExpressionVec &expression,
+                                         const StringVector &counterVars );
+        /// parseInt selects how numbers are read: like interpretAsNumberThenAsProperty if
+        /// true, like parseForEach & evaluateExpressionRecursive (i.e. strtol) if false.
+        static CompiledTemplate::Arg compileArg( const String &argValue, bool parseInt );
+        static inline int32 getArgValue( const CompiledTemplate::Arg &arg, const ThreadData &td,
+                                         int32 defaultVal );
+
+        static void  appendSegments( const String &buffer, const CompiledTemplate &compiled,
+                                     uint32 firstSegment, uint32 numSegments,
+                                     const size_t *counters, String &outBuffer );
+        static void  evaluateNodes( const CompiledTemplate &compiled, uint32 firstNode,
+                                    const ThreadData &td, size_t *counters, String &outBuffer );
+        static int32 evaluateCompiledExpression( const CompiledTemplate &compiled,
+                                                 uint32 firstExpression, const ThreadData &td,
+                                                 const size_t *counters );
+
+        /** Same as parseMath + parseForEach + parseProperties, with a compiled file.
+        @param outBuffer
+            Result of running the file through parseProperties.
+        @param stopOnSyntaxError
+            Whether @foreach expansion stops after a syntax error. Templates do, piece files don't.
+        */
+        static bool parseCompiled( const CompiledTemplate &compiled, String &outBuffer,
+                                   String &tmpBuffer, ThreadData &td, bool stopOnSyntaxError );
+
         /** Caches a set of properties (i.e. key-value pairs) & snippets of shaders. If an
             exact entry exists in the cache, its index is returned. Otherwise a new entry
             will be created.
@@ -386,10 +667,48 @@ namespace Ogre
         const HlmsCache *getShaderCache( uint32 hash ) const;
         virtual void     clearShaderCache();
 
-        void processPieces( Archive *archive, const StringVector &pieceFiles );
-        void hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
-                             FastArray<uint8> &fileContents ) const;
+        /// Runs the piece files of the given stage through the preprocessor
+        /// to collect their pieces into td.pieces
+        static void processPieces( const TemplateSources &sources, ShaderType shaderType,
+                                   ThreadData &td, bool useCompiledTemplates );
+        /** Runs the piece files and then the template of the given stage through the
+            preprocessor. See expandTemplate.
+        @param useCompiledTemplates
+            Whether to use TemplateSources::compiledTemplate & compiledPieceFiles, or to parse
+            the text of the files.
+        @return
+            True if there were syntax errors.
+        */
+        static bool preprocessTemplate( const TemplateSources &sources, ShaderType shaderType,
+                                        ThreadData &td, String &outSource,
+                                        bool useCompiledTemplates );
+        void        hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
+                                    FastArray<uint8> &fileContents ) const;
+
+        static void readPieceFiles( Archive *archive, const StringVector &pieceFiles,
+                                    const String &shaderFileExt, const String &fileNamePrefix,
+                                    ShaderType shaderType, TemplateSources &sources );
+        /// Loads mTemplateSources if it isn't loaded yet.
+        void loadTemplateSources();
+
+        static void addDependency( ThreadData &td, uint16 fileId );
+        /// Moves the dependencies gathered while expanding the templates into codeCache
+        static void storeDependencies( ThreadData &td, ShaderCodeCache &codeCache );
+
+        /** Expands the template of the given stage into valid shader code.
+            Must be called once per stage in order (stages can see the properties
+            the previous ones set). Only reads & modifies 'td' and read-only state, thus
+            it's safe to call it from multiple threads as long as each uses its own ThreadData.
+        @remarks
+            loadTemplateSources must have been called (and found a template for this stage).
+            td.pieces must contain the renderable's pieces for this stage.
+        @return
+            True if there were syntax errors.
+        */
+        bool expandTemplate( ShaderType shaderType, uint32 finalHash, ThreadData &td,
+                             String &outSource, String &outDebugFilenameOutput ) const;
 
+        void dumpProperties( std::ofstream &outFile, const ThreadData &td ) const;
         void dumpProperties( std::ofstream &outFile );
 
         /** Modifies the PSO's macroblock if there are reasons to do that, and creates
@@ -405,6 +724,45 @@ namespace Ogre
                                                   const String &debugFilenameOutput, uint32 finalHash,
                                                   ShaderType shaderType );
 
+        /** Merges the renderable's cached properties with the pass', adds the RenderSystem
+            specific ones and lets notifyPropertiesMergedPreGenerationStep & the listener derive
+            the rest. The result is left in mSetProperties, ready to be used as a key in
+            mShaderCodeCache.
+        */
+        void mergeShaderCacheEntryProperties( uint32 renderableHash, const HlmsCache &passCache,
+                                              const QueuedRenderable &queuedRenderable );
+
+        /// Same as createShaderCacheEntry, but if the shaders don't exist yet, they're
+        /// scheduled for compilation and null is returned. See setAsyncShaderCompilation
+        const HlmsCache *createShaderCacheEntryAsync( uint32 renderableHash, const HlmsCache &passCache,
+                                                      uint32 finalHash,
+                                                      const QueuedRenderable &queuedRenderable );
+
+        static bool containsShaderCode( const PendingShaderCodeVec &pendingShaderCode,
+                                        const ShaderCodeCache      &codeCache );
+
+        /** Expands the templates of a scheduled variant. Thread safe, as long as each thread
+            works on a different entry and mTemplateSources is already loaded.
+        @param finalHash
+            Name of the shaders, only used for the debug output.
+        */
+        void generatePendingShader( PendingShaderCode &pending, uint32 finalHash ) const;
+
+        /// Render thread. Creates the GPU programs of an expanded variant and adds it to
+        /// mShaderCodeCache
+        void compilePendingShader( PendingShaderCode &pending );
+
+        /** Called when the frame ends while mAsyncShaderCompilation is enabled:
+            collects the variants mAsyncGenerationTask finished expanding, hands the next
+            batch of mAsyncShaderCode to the worker threads, and compiles up to
+            mMaxAsyncCompilesPerFrame expanded variants.
+        */
+        void updateAsyncShaders();
+
+        /// Blocks until mAsyncGenerationTask is finished, if it is running, and moves
+        /// its variants to mAsyncGeneratedShaderCode
+        void waitForAsyncShaderGeneration();
+
     public:
         void _compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
                                                    const String           source[NumShaderTypes] );
@@ -799,11 +1157,103 @@ namespace Ogre
         @param casterPass
             True if this pass is the shadow mapping caster pass, false otherwise
         @return
-            Structure containing all necessary shaders
+            Structure containing all necessary shaders.
+            Null if setAsyncShaderCompilation is enabled and the shaders aren't ready yet;
+            in which case the renderable must be skipped.
         */
         const HlmsCache *getMaterial( HlmsCache const *lastReturnedValue, const HlmsCache &passCache,
                                       const QueuedRenderable &queuedRenderable, bool casterPass );
 
+        /** When enabled, RenderQueue gathers all the shader variants missing from a pass before
+            rendering it, and expands their templates in parallel using the SceneManager's worker
+            threads; instead of generating them one by one the first time getMaterial sees them.
+        @remarks
+            Creating the GPU programs (i.e. calling the shader compiler) and the PSOs still
+            happens in the render thread, as RenderSystems can't be called from other threads.
+        @par
+            Listeners and derived implementations must not rely on state other than the
+            properties while the templates are being expanded (same rule as HlmsDiskCache).
+        @par
+            Ignored if the Hlms doesn't generate shaders from templates (e.g. HlmsLowLevel).
+            Disabled by default.
+        */
+        void setParallelShaderGeneration( bool bParallel );
+        bool getParallelShaderGeneration() const { return mParallelShaderGeneration; }
+
+        /** Called by RenderQueue for every renderable in a pass before rendering it, when
+            getParallelShaderGeneration is enabled.
+            If no PSO exists yet for it, its shader variant is scheduled for generation.
+        */
+        void _queueShaderGeneration( const HlmsCache &passCache, const QueuedRenderable &queuedRenderable,
+                                     bool casterPass );
+
+        /// Returns true if _queueShaderGeneration scheduled variants that haven't been generated yet
+        bool _hasPendingShaderGeneration() const { return !mPendingShaderCode.empty(); }
+
+        /// Returns the number of variants scheduled by _queueShaderGeneration
+        size_t _getNumPendingShaders() const { return mPendingShaderCode.size(); }
+
+        /** Expands the templates of the scheduled variant at index idx.
+            Called from the worker threads (one TaskScheduler chunk per variant);
+            different indices can be generated at the same time.
+        */
+        void _generatePendingShader( size_t idx );
+
+        /// Render thread. Must be called after _generatePendingShader has finished for all variants.
+        /// Afterwards getMaterial will find the generated shaders in the cache.
+        void _compilePendingShaders();
+
+        /** When enabled, getMaterial no longer stalls the frame to compile shaders it has never
+            seen. Instead they're scheduled and getMaterial returns null (RenderQueue then skips
+            the renderable). The worker threads of taskScheduler expand their templates in the
+            background; when the frame ends the render thread compiles the expanded ones, at
+            most maxCompilesPerFrame per frame. The renderables appear once their shaders are
+            ready.
+        @remarks
+            PSOs whose shaders are already compiled (e.g. only the macroblock differs) are
+            still created immediately.
+        @par
+            This trades a few frames of missing objects for bounded frame times, which is
+            useful when streaming content. Takes precedence over setParallelShaderGeneration.
+            Disabled by default.
+        @param bAsync
+            True to enable. When disabling, scheduled shaders that weren't compiled are discarded.
+        @param taskScheduler
+            Scheduler whose worker threads expand the templates, usually
+            SceneManager::getTaskScheduler. Must be created from the render thread, and must
+            outlive this Hlms or be replaced (i.e. call this function again) before it is
+            destroyed. Ignored when bAsync is false.
+        @param maxCompilesPerFrame
+            Maximum number of shader variants compiled every frame. Must be > 0.
+        */
+        void setAsyncShaderCompilation( bool bAsync, TaskScheduler *taskScheduler,
+                                        uint32 maxCompilesPerFrame = 1u );
+        bool getAsyncShaderCompilation() const { return mAsyncShaderCompilation; }
+
+        /** When enabled (default), the templates & piece files are parsed once when loaded
+            into a tree that is evaluated for every shader variant (see CompiledTemplate),
+            instead of parsing their text again for each variant. The generated shaders are
+            the same.
+        @remarks
+            Disabling it is only useful to debug the preprocessor or to compare performance.
+        */
+        void setUseCompiledTemplates( bool bUseCompiledTemplates );
+        bool getUseCompiledTemplates() const { return mUseCompiledTemplates; }
+
+        /// Number of shader variants waiting to be expanded or compiled.
+        /// See setAsyncShaderCompilation
+        size_t getNumPendingAsyncShaders() const
+        {
+            return mAsyncShaderCode.size() + mAsyncGeneratingShaderCode.size() +
+                   mAsyncGeneratedShaderCode.size();
+        }
+
+        /// Statistics about the shader variants generated in the last frame.
+        const ShaderGenerationStats &getShaderGenerationStats() const { return mLastFrameStats; }
+
+        /// Called by Root when the frame ends. See getShaderGenerationStats
+        void _notifyFrameEnded();
+
         /** Fills the constant buffers. Gets executed right before drawing the mesh.
         @param cache
             Current cache of Shaders to be used.
@@ -830,6 +1280,71 @@ namespace Ogre
                                          const QueuedRenderable &queuedRenderable, bool casterPass,
                                          uint32 lastCacheHash, CommandBuffer *commandBuffer ) = 0;
 
+        /// Returned by _fillBuffersForV2Slice when the renderable (and the rest of its slice)
+        /// must be filled from the render thread instead.
+        static const uint32 c_retryFillInRenderThread;
+
+        /** When enabled, RenderQueue may split FAST render queues with many renderables into
+            contiguous slices and record each slice's commands in a different worker thread,
+            each into its own CommandBuffer. They're stitched back in order before execution.
+        @remarks
+            It only has effect on implementations that override _beginParallelCommandGeneration
+            & co. (i.e. HlmsPbs & HlmsUnlit). A render queue is only split if all of its
+            renderables belong to Hlms with this setting enabled.
+        @par
+            Listeners (e.g. HlmsListener::hlmsTypeChanged) get called from the worker threads.
+            Disabled by default.
+        */
+        void setParallelCommandGeneration( bool bParallel );
+        bool getParallelCommandGeneration() const { return mParallelCommandGeneration; }
+
+        /** Render thread. Called before the slices of a render queue are recorded in parallel,
+            so each slice gets its own memory to write its per-draw data into.
+        @param commandBuffer
+            The CommandBuffer that holds everything recorded so far (not the slices').
+        @param casterPass
+            Whether this is a shadow mapping caster pass.
+        @param numSlices
+            Number of slices. Slice i will be recorded with sliceIdx = i.
+        @param numRenderables
+            Array with numSlices elements. How many renderables of this Hlms are in each slice.
+        */
+        virtual void _beginParallelCommandGeneration( CommandBuffer *commandBuffer, bool casterPass,
+                                                      size_t numSlices, const size_t *numRenderables )
+        {
+        }
+
+        /** Same as fillBuffersForV2, but called from a worker thread for one of the slices
+            prepared by _beginParallelCommandGeneration. Different slices may be filled at
+            the same time; the same slice is always filled from the same thread, in order.
+        @return
+            Same as fillBuffersForV2. Or c_retryFillInRenderThread if the slice ran out of
+            its memory; in which case RenderQueue records this renderable and the rest of the
+            slice in the render thread with fillBuffersForV2.
+        @remarks
+            Commands may have been added to commandBuffer before running out of memory.
+            RenderQueue discards every command added for this renderable (including its
+            own, e.g. the PSO) so implementations don't need to check for space beforehand.
+            But they must restore the slice's state (e.g. mapped buffers, last bound
+            buffers) to what it was before the call that returned c_retryFillInRenderThread.
+            Listeners (e.g. HlmsListener::hlmsTypeChanged) may have been called for it,
+            and will be called again from the render thread.
+        */
+        virtual uint32 _fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                               const QueuedRenderable &queuedRenderable,
+                                               bool casterPass, uint32 lastCacheHash,
+                                               CommandBuffer *commandBuffer )
+        {
+            return c_retryFillInRenderThread;
+        }
+
+        /** Render thread. Called once all slices have been recorded, but before stitching them.
+            After this call fillBuffersForV2 must work as if the slices never happened.
+        @param sliceCommandBuffers
+            Array with the CommandBuffer of each slice.
+        */
+        virtual void _endParallelCommandGeneration( CommandBuffer *const *sliceCommandBuffers ) {}
+
         /// This gets called right before executing the command buffer.
         virtual void preCommandBufferExecution( CommandBuffer *commandBuffer ) {}
         /// This gets called after executing the command buffer.
@@ -470,6 +470,11 @@ namespace Ogre
         /// Do not call this function aggressively (e.g. for lots of material every frame)
         virtual void preload();
 
+        /// Tells the textures still loading that an object using this datablock covers
+        /// the given fraction of the screen, in range [0; 1].
+        /// See TextureGpuManager::setAutomaticLoadPriorities
+        virtual void _addTextureScreenCoverage( float coverage );
+
         virtual bool hasCustomShadowMacroblock() const;
 
         /// Returns the closest match for a diffuse colour,
@@ -132,10 +132,27 @@ namespace Ogre
     class _OgreExport HlmsDiskCache : public OgreAllocatedObj
     {
     public:
+        /// A template or piece file the cached shaders depend on
+        struct TemplateFile
+        {
+            String name;
+            uint64 hash[2];  // 128 bit hash of its contents
+
+            bool operator==( const TemplateFile &_r ) const
+            {
+                return name == _r.name && hash[0] == _r.hash[0] && hash[1] == _r.hash[1];
+            }
+        };
+
+        typedef vector<TemplateFile>::type TemplateFileVec;
+
         struct SourceCode
         {
             Hlms::RenderableCache mergedCache;
             String                sourceFile[NumShaderTypes];
+            /// Indices to Cache::templateFiles. See Hlms::ShaderCodeCache::templateDependencies
+            FastArray<uint16> templateDependencies;
+            IdStringVec       missingPieces;
 
             SourceCode();
             SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache );
@@ -160,10 +177,11 @@ namespace Ogre
 
         struct Cache
         {
-            uint64        templateHash[2];  // 128 bit hash
-            uint8         type;             /// See HlmsTypes
-            SourceCodeVec sourceCode;
-            PsoVec        pso;
+            uint64          templateHash[2];  // 128 bit hash
+            uint8           type;             /// See HlmsTypes
+            TemplateFileVec templateFiles;
+            SourceCodeVec   sourceCode;
+            PsoVec          pso;
         };
 
         bool         mTemplatesOutOfDate;
@@ -180,10 +198,40 @@ namespace Ogre
         void save( DataStreamPtr &dataStream, const HlmsPropertyVec &properties );
         void save( DataStreamPtr &dataStream, const Hlms::RenderableCache &renderableCache );
 
+        void save( DataStreamPtr &dataStream, const SourceCode &sourceCode );
+
         void load( DataStreamPtr &dataStream, IdString &hashedString );
         void load( DataStreamPtr &dataStream, String &string );
         void load( DataStreamPtr &dataStream, HlmsPropertyVec &properties );
         void load( DataStreamPtr &dataStream, Hlms::RenderableCache &renderableCache );
+        void load( DataStreamPtr &dataStream, SourceCode &sourceCode );
+
+        /// Adds the file to mCache.templateFiles if it's not there yet. Returns its index.
+        uint16 addTemplateFile( const TemplateFile &templateFile );
+
+        /** Finds out which entries in mCache.sourceCode can still be used, given the template
+            & piece files have changed. An entry is out of date if a file it depends on changed,
+            or a changed file now defines a piece the entry tried to insert but didn't exist.
+        @param outOutOfDate [out]
+            One entry per mCache.sourceCode. True if out of date.
+        @return
+            Number of entries out of date.
+        */
+        size_t findOutOfDateEntries( const Hlms::TemplateSources &sources,
+                                     FastArray<uint8> &outOutOfDate ) const;
+
+        /// Name of the file saveEntriesTo uses for the given entry
+        String getEntryFilename( const SourceCode &sourceCode ) const;
+        /// Writes a single entry, with everything needed to be loaded on its own
+        void saveEntry( DataStreamPtr &dataStream, const SourceCode &sourceCode );
+        /** Reads the entry's header. Returns false if the entry is incomplete (e.g. another
+            process is still writing it) or doesn't match mCache's type & settings.
+            On success the stream is left at the start of the entry's dependencies.
+        */
+        bool loadEntryHeader( DataStreamPtr &dataStream );
+        /// Reads the dependencies of an entry. See loadEntryHeader
+        void loadEntryDependencies( DataStreamPtr &dataStream, TemplateFileVec &outTemplateFiles,
+                                    IdStringVec &outMissingPieces );
 
     public:
         HlmsDiskCache( HlmsManager *hlmsManager );
@@ -196,6 +244,33 @@ namespace Ogre
 
         void saveTo( DataStreamPtr &dataStream );
         void loadFrom( DataStreamPtr &dataStream );
+
+        /** Saves every shader in the cache as an individual file in the given folder, named
+            after the hash of its merged properties & pieces and the Hlms settings.
+        @remarks
+            Saving is incremental: files already in the folder that are up to date are
+            left untouched. Only the shaders that are new or were generated again (i.e.
+            their templates changed) get written.
+        @par
+            Several processes can share the same folder. Entries are written under a
+            temporary name and then renamed over the old file, so they're never seen half
+            written. Each entry also ends with a footer that is written last, and
+            loadEntriesFrom skips entries without it.
+        @par
+            PSOs are not saved, only the shaders. Use saveTo for a single-file cache.
+        @param archive
+            Writable Archive that supports Archive::rename. Usually a FileSystemArchive.
+        */
+        void saveEntriesTo( Archive *archive );
+
+        /** Loads the entries written by saveEntriesTo for the given Hlms. Entries from other
+            Hlms types, shader profiles or settings are ignored.
+            Call applyTo afterwards to compile them.
+        @remarks
+            Unlike loadFrom, entries whose templates have changed are detected individually
+            in applyTo; so only those get parsed again.
+        */
+        void loadEntriesFrom( Archive *archive, Hlms *hlms );
     };
 
     /** @} */
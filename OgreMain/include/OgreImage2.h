@@ -378,6 +378,9 @@ namespace Ogre
         @param textureType
             Required to properly calculate the return value
         @param filter
+        @param useSimd
+            When false, imageDownsampler2D is always the scalar version even if the CPU
+            supports a faster SIMD one. Both produce the same output.
         @return
             True if mipmaps can be generated.
             False if mipmaps cannot be generated.
@@ -390,7 +393,8 @@ namespace Ogre
                                              bool                       gammaCorrected,        //
                                              uint32                     depthOrSlices,         //
                                              TextureTypes::TextureTypes textureType,           //
-                                             Filter                     filter );
+                                             Filter                     filter,                //
+                                             bool                       useSimd = true );
 
         static bool supportsSwMipmaps( PixelFormatGpu format, uint32 depthOrSlices,
                                        TextureTypes::TextureTypes textureType, Filter filter );
@@ -277,6 +277,16 @@ namespace Ogre
     extern const FilterKernel          c_filterKernels[3];
     extern const FilterSeparableKernel c_filterSeparableKernels[1];
 
+    /** Returns the SSE2 / NEON version of a 2D downsampler, if there is one and the CPU
+        supports it. Otherwise returns scalarFunc.
+    @remarks
+        SIMD versions only speed up the 2x2 box kernel (FILTER_LINEAR & FILTER_BILINEAR)
+        and forward every other kernel to scalarFunc. Their output is bit-identical.
+        Currently available for downscale2x_XXXA8888, downscale2x_sRGB_XXXA8888,
+        downscale2x_Float32_XXXA and downscale2x_Float32_X.
+    */
+    ImageDownsampler2D *getSimdImageDownsampler2D( ImageDownsampler2D *scalarFunc );
+
     /** @} */
     /** @} */
 }  // namespace Ogre
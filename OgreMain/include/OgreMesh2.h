@@ -241,6 +241,14 @@ namespace Ogre
         /** Gets the radius of the bounding sphere surrounding this mesh. */
         Real getBoundingSphereRadius() const;
 
+        /** Internal use by MeshManager::loadInBackground. Provides the contents of the
+            file, already read into RAM by another thread. The next load() will use them
+            instead of reading the file again.
+        @param data
+            Must be a MemoryDataStream.
+        */
+        void _setPreparedData( const DataStreamPtr &data );
+
         /** Manually set the bounding box for this Mesh.
         @remarks
             Calling this method is required when building manual meshes now, because OGRE can no longer
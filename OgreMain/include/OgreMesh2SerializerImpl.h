@@ -99,6 +99,10 @@ namespace Ogre
             uint32               numIndices;
             void                *indexData;
             OperationType        operationType;
+            /// When true, vertexBuffers point into the memory of the stream being read. Don't free
+            bool vertexDataInPlace;
+            /// When true, indexData points into the memory of the stream being read. Don't free
+            bool indexDataInPlace;
 
             SubMeshLod();
         };
@@ -162,6 +166,14 @@ namespace Ogre
                                   uint8 numVaoPasses );
         virtual void readSubMeshLod( DataStreamPtr &stream, Mesh *pMesh, SubMeshLod *subLod,
                                      uint8 currentLod );
+        /// Frees the vertex & index data the SubMeshLods still own. Used on errors
+        void freeSubMeshLodData( SubMeshLodVec &submeshLods );
+
+        /** Returns a pointer to the next numBytes of the stream (which must be a
+            MemoryDataStream) and skips them. Throws if the stream is too short
+        */
+        static uint8 *readInPlace( DataStreamPtr &stream, size_t numBytes );
+
         virtual void readIndexes( DataStreamPtr &stream, SubMeshLod *subLod );
         virtual void readGeometry( DataStreamPtr &stream, SubMeshLod *subLod );
         virtual void readVertexDeclaration( DataStreamPtr &stream, SubMeshLod *subLod );
@@ -217,6 +229,14 @@ namespace Ogre
         uint64      mCalculatedHash[2];  // Calculated when exporting
         ushort      exportedLodCount;    // Needed to limit exported Edge data, when exporting
         VaoManager *mVaoManager;
+
+        /** When importing from a MemoryDataStream with native endianness, the vertex (or index)
+            data is handed to the VaoManager straight from the stream's memory, instead of
+            being copied into a temporary buffer first. Only possible when the buffers are not
+            shadowed, because shadow copies take ownership of the pointer.
+        */
+        bool mVertexDataInPlace;
+        bool mIndexDataInPlace;
     };
 
     class _OgrePrivate MeshSerializerImpl_v2_1_R1 : public MeshSerializerImpl
@@ -33,6 +33,9 @@ THE SOFTWARE.
 #include "OgreResourceManager.h"
 #include "OgreSingleton.h"
 #include "OgreVector3.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
 #include "Vao/OgreBufferPacked.h"
 
 #include "OgreHeaderPrefix.h"
@@ -56,6 +59,19 @@ namespace Ogre
                                           public Singleton<MeshManager>,
                                           public ManualResourceLoader
     {
+    public:
+        /// A Mesh requested via loadInBackground that could not be loaded
+        struct BackgroundLoadError
+        {
+            String meshName;
+            String groupName;
+            /// Exception::ExceptionCodes of the error
+            int    code;
+            /// Full description of the error
+            String description;
+        };
+        typedef vector<BackgroundLoadError>::type BackgroundLoadErrorVec;
+
     protected:
         /// @copydoc ResourceManager::createImpl
         Resource *createImpl( const String &name, ResourceHandle handle, const String &group,
@@ -67,6 +83,43 @@ namespace Ogre
         // the factor by which the bounding box of an entity is padded
         Real mBoundsPaddingFactor;
 
+        struct BackgroundLoadRequest
+        {
+            MeshPtr  mesh;
+            Archive *archive;
+            /// Filled by the worker thread
+            DataStreamPtr data;
+            /// Filled by the worker thread if reading failed
+            String error;
+            int    errorCode;
+        };
+        typedef vector<BackgroundLoadRequest>::type BackgroundLoadRequestVec;
+
+        /// Main thread -> worker thread. Protected by mBackgroundLoadMutex
+        BackgroundLoadRequestVec mPendingBackgroundLoads;
+        /// Worker thread -> main thread. Protected by mBackgroundLoadMutex
+        BackgroundLoadRequestVec mFinishedBackgroundLoads;
+        /// Only accessed by the worker thread
+        BackgroundLoadRequestVec mWorkerBackgroundLoads;
+        /// Requests not yet handed back to the main thread. Only accessed by the main thread
+        size_t mNumBackgroundLoadsInFlight;
+        /// Failed requests not yet retrieved. Only accessed by the main thread
+        BackgroundLoadErrorVec mBackgroundLoadErrors;
+
+        LightweightMutex mBackgroundLoadMutex;
+        WaitableEvent    mBackgroundLoadEvent;
+        WaitableEvent    mBackgroundLoadDoneEvent;
+        /// Created on the first call to loadInBackground
+        ThreadHandleVec mBackgroundLoadThread;
+        bool            mShuttingDown;
+
+        void destroyBackgroundLoadThread();
+
+        /// Reads into RAM the files of all the pending requests. Runs in the worker thread
+        void processBackgroundLoads();
+
+        void reportBackgroundLoadError( Mesh *mesh, int code, const String &description );
+
     public:
         MeshManager();
         ~MeshManager() override;
@@ -165,6 +218,60 @@ namespace Ogre
 #    pragma clang diagnostic pop
 #endif
 
+        /** Same as load(), but reading the file happens in a background thread, so the
+            main thread doesn't stall on IO.
+        @remarks
+            The Mesh is returned immediately, but it won't be loaded until a later call to
+            _update (which Root calls every frame) picks it up, which parses it and creates
+            its GPU buffers on the main thread (the VaoManager is not thread safe).
+            Use Resource::Listener::loadingComplete to get notified, or waitForBackgroundLoads.
+        @par
+            Nothing stops the Mesh from being loaded synchronously (e.g. by an Item being
+            created with it) while the request is in flight, in which case the result of the
+            background request is discarded.
+        @par
+            When vertexBufferShadowed and indexBufferShadowed are false, the vertex and index
+            data are handed to the GPU straight from the file's contents in RAM, without any
+            intermediate copies.
+        @par
+            If the Mesh can't be loaded, it is left unloaded, the error is logged,
+            Resource::Listener::loadingFailed is called, and the error is kept in
+            getBackgroundLoadErrors until waitForBackgroundLoads throws it or
+            clearBackgroundLoadErrors is called.
+        @see MeshManager::load for the parameters
+        */
+        MeshPtr loadInBackground( const String &filename, const String &groupName,
+                                  BufferType vertexBufferType = BT_IMMUTABLE,
+                                  BufferType indexBufferType = BT_IMMUTABLE,
+                                  bool vertexBufferShadowed = true, bool indexBufferShadowed = true );
+
+        /** Loads the meshes whose files were already read by the background thread.
+            See loadInBackground.
+        @param syncWithWorkerThread
+            When false, the meshes may be picked up by a later call if the worker
+            thread is busy, rather than stalling.
+        @return
+            True if there are no more background loads in flight.
+        */
+        bool _update( bool syncWithWorkerThread );
+
+        /** Blocks until all the meshes requested via loadInBackground are loaded (or failed)
+        @exception
+            If any of them failed (including those that failed in earlier calls to _update
+            and were not cleared yet), throws an Exception listing them all, with the code
+            of the first one. The errors are cleared before throwing.
+        */
+        void waitForBackgroundLoads();
+
+        /// Meshes requested via loadInBackground that failed to load, oldest first
+        const BackgroundLoadErrorVec &getBackgroundLoadErrors() const { return mBackgroundLoadErrors; }
+
+        /// Forgets the errors returned by getBackgroundLoadErrors
+        void clearBackgroundLoadErrors() { mBackgroundLoadErrors.clear(); }
+
+        /// Internal use. Entry point of the background thread
+        unsigned long _updateBackgroundLoadThread( ThreadHandle *threadHandle );
+
         /** Creates a new Mesh specifically for manual definition rather
             than loading from an object file.
         @remarks
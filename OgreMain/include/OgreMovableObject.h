@@ -97,6 +97,8 @@ namespace Ogre
         // One for each submesh/Renderable
         FastArray<Real> const *mLodMesh;
         unsigned char          mCurrentMeshLod;
+        /// @See setOccluder
+        bool mIsOccluder;
 
         /// Minimum pixel size to still render
         Real mMinPixelSize;
@@ -261,6 +263,18 @@ namespace Ogre
                                                          ArrayAabb *RESTRICT_ALIAS worldAabb,
                                                          ArrayReal *RESTRICT_ALIAS worldRadius );
 
+        /// SIMD constants of one frustum, shared by cullFrustum & cullFrustumBatch
+        struct ArrayFrustumCullParams;
+
+        static inline void setupFrustumCullParams( ArrayFrustumCullParams &outParams,
+                                                   const Camera *frustum, uint32 sceneVisibilityFlags,
+                                                   const Camera *lodCamera );
+
+        /// Culls ARRAY_PACKED_REALS objects. Writes their distance to camera into
+        /// objData.mDistanceToCamera and returns a bitmask with the visible ones.
+        static inline uint32 cullFrustumPack( const ArrayFrustumCullParams &params,
+                                              const ObjectData             &objData );
+
     public:
         /** @See SceneManager::cullFrustum
         @remarks
@@ -284,6 +298,32 @@ namespace Ogre
                                  uint32 sceneVisibilityFlags, MovableObjectArray &outCulledObjects,
                                  const Camera *lodCamera );
 
+        /** Same as cullFrustum, but tests each object against numFrustums frustums at once
+            so that the object data is only brought into cache once for all of them.
+            @See SceneManager::_fireBatchedCull
+        @remarks
+            The distance to each camera is written to outDistances instead, since
+            mDistanceToCamera can only hold one of them.
+        @param frustums
+            Array of numFrustums frustums to clip against
+        @param sceneVisibilityFlags
+            Array of numFrustums combined visibility flags. @See cullFrustum
+        @param lodCameras
+            Array of numFrustums lod cameras. @See cullFrustum
+        @param outCulledObjects
+            Out. Array of numFrustums lists. The visible objects are appended to the list
+            of each frustum.
+        @param outDistances
+            Out. Array of numFrustums lists. For each entry appended to outCulledObjects[i],
+            its distance to frustums[i] is appended to outDistances[i].
+        */
+        static void cullFrustumBatch( const size_t numNodes, ObjectData objData,
+                                      const Camera *const *frustums,
+                                      const uint32 *sceneVisibilityFlags,
+                                      const Camera *const *lodCameras, const size_t numFrustums,
+                                      MovableObjectArray *outCulledObjects,
+                                      FastArray<RealAsUint> *outDistances );
+
         /// @See InstancingTheadedCullingMethod, @see InstanceBatch::instanceBatchCullFrustumThreaded
         virtual void instanceBatchCullFrustumThreaded( const Frustum *frustum, const Camera *lodCamera,
                                                        uint32 combinedVisibilityFlags )
@@ -509,6 +549,10 @@ namespace Ogre
         /// Returns the distance to camera as calculated in @cullFrustum
         inline Real getCachedDistanceToCameraAsReal() const;
 
+        /// Overwrites the value returned by getCachedDistanceToCamera. Used by
+        /// SceneManager when the distance was calculated by @cullFrustumBatch
+        inline void _setCachedDistanceToCamera( RealAsUint distance );
+
         /** Sets the visibility flags for this object.
         @remarks
             As well as a simple true/false value for visibility (as seen in setVisible),
@@ -602,6 +646,18 @@ namespace Ogre
         /** Returns whether shadow casting is enabled for this object. */
         inline bool getCastShadows() const;
 
+        /** Sets whether this object hides the objects behind it, when the pass has occlusion
+            culling enabled. @See SceneManager::setOcclusionBufferResolution
+        @remarks
+            The local Aabb is what gets rasterized as the occluder, hence only flag objects that
+            fill most of their bounds (i.e. walls, buildings, terrain blocks) and are large on
+            screen. Otherwise objects partially visible behind them may get culled.
+        @par
+            Only objects created by a SceneManager can be occluders.
+        */
+        void setOccluder( bool bOccluder );
+        bool isOccluder() const { return mIsOccluder; }
+
         SkeletonInstance *getSkeletonInstance() const { return mSkeletonInstance; }
 
 #if OGRE_DEBUG_MODE
@@ -50,6 +50,11 @@ namespace Ogre
         return (reinterpret_cast<Real*RESTRICT_ALIAS>(mObjectData.mDistanceToCamera))[mObjectData.mIndex];
     }
     //-----------------------------------------------------------------------------------
+    inline void MovableObject::_setCachedDistanceToCamera( RealAsUint distance )
+    {
+        mObjectData.mDistanceToCamera[mObjectData.mIndex] = distance;
+    }
+    //-----------------------------------------------------------------------------------
     inline void MovableObject::setVisibilityFlags( uint32 flags )
     {
         mObjectData.mVisibilityFlags[mObjectData.mIndex] =
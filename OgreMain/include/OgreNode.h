@@ -159,6 +159,10 @@ namespace Ogre
         */
         virtual void updateFromParentImpl();
 
+        /// Updates the derived transforms of the ARRAY_PACKED_REALS nodes t points to.
+        /// Their parents must be up to date.
+        static inline void updateTransformPack( const Transform &t );
+
         /** Internal method for creating a new child node - must be overridden per subclass. */
         virtual Node *createChildImpl( SceneMemoryMgrTypes sceneType ) = 0;
 
@@ -251,9 +255,16 @@ namespace Ogre
         /// Returns how deep in the hierarchy we are (eg. 0 -> root node, 1 -> child of root)
         uint16 getDepthLevel() const { return mDepthLevel; }
 
-        /// Returns a direct access to the Transform state
+        /// Returns a direct access to the Transform state. If you modify the local
+        /// position, orientation, scale or inheritance through it, call _notifyTransformDirty
         Transform &_getTransform() { return mTransform; }
 
+        /** Flags our local transform as changed, so that the next
+            SceneManager::updateAllTransforms updates us and our children.
+            All of Node's setters already call this.
+        */
+        void _notifyTransformDirty() { mTransform.mDirty[mTransform.mIndex] |= Transform::DirtyLocal; }
+
         /// Called by SceneManager when it is telling we're a static node being dirty
         /// Don't call this directly. @see SceneManager::notifyStaticDirty
         virtual void _notifyStaticDirty() const;
@@ -708,8 +719,19 @@ namespace Ogre
         /** @See SceneManager::updateAllTransforms()
         @remarks
             We don't pass by reference on purpose (avoid implicit aliasing)
+        @return
+            Number of nodes that were updated, i.e. numNodes.
+        */
+        static size_t updateAllTransforms( const size_t numNodes, Transform t );
+
+        /** Same as updateAllTransforms, but packs of ARRAY_PACKED_REALS nodes in which no
+            node changed (Transform::DirtyLocal) and no parent was updated
+            (Transform::DirtyDerived) are skipped.
+            @See SceneManager::setTransformDirtyTracking
+        @return
+            Number of nodes that were updated, counting the whole pack.
         */
-        static void updateAllTransforms( const size_t numNodes, Transform t );
+        static size_t updateDirtyTransforms( const size_t numNodes, Transform t );
 
         /** Gets the local position, relative to this node, of the given world-space position */
         virtual_l2 Vector3 convertWorldToLocalPosition( const Vector3 &worldPos );
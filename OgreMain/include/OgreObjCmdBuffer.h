@@ -65,19 +65,34 @@ namespace Ogre
     protected:
         FastArray<uint8> mCommandAllocator;
         FastArray<Cmd *> mCommandBuffer;
+        /// Sequence of each command in mCommandBuffer. See setSequence
+        FastArray<uint64> mCommandSequences;
+        uint64            mCurrentSequence;
 
         void *requestMemory( size_t sizeBytes );
 
     public:
+        ObjCmdBuffer();
         ~ObjCmdBuffer();
         void clear();
         void execute();
 
+        /** Executes the commands of all the buffers, in the order of their sequence.
+            Commands of the same buffer are always executed in the order they were added.
+            See setSequence.
+        */
+        static void executeMerged( ObjCmdBuffer *const *cmdBuffers, size_t numCmdBuffers );
+
+        /// Commands added from now on are tagged with the given sequence (e.g. the order
+        /// of the request that produced them). See executeMerged
+        void setSequence( uint64 sequence ) { mCurrentSequence = sequence; }
+
         template <typename T>
         T *addCommand()
         {
             T *newCmd = reinterpret_cast<T *>( requestMemory( sizeof( T ) ) );
             mCommandBuffer.push_back( newCmd );
+            mCommandSequences.push_back( mCurrentSequence );
             return newCmd;
         }
 
@@ -109,10 +124,13 @@ namespace Ogre
         class ExceptionThrown : public Cmd
         {
             TextureGpu *texture;
-            Exception   exception;
+            /// Kept on the heap: commands get moved around with memcpy when the
+            /// buffer grows (see requestMemory), and Exception holds Strings
+            Exception *exception;
 
         public:
             ExceptionThrown( TextureGpu *_texture, const Exception &_exception );
+            ~ExceptionThrown() override;
             void execute() override;
         };
 
@@ -139,6 +157,27 @@ namespace Ogre
             NotifyDataIsReady( TextureGpu *_textureGpu, FilterBaseArray &inOutFilters );
             void execute() override;
         };
+
+        /// Progressive streaming: mips [mostDetailedMip; numMipmaps) have been uploaded.
+        /// See TextureGpu::_notifyMostDetailedMipReady
+        class NotifyMipsAreReady : public Cmd
+        {
+            TextureGpu *texture;
+            uint8       mostDetailedMip;
+
+        public:
+            NotifyMipsAreReady( TextureGpu *_texture, uint8 _mostDetailedMip );
+            void execute() override;
+        };
+
+        class LoadCancelled : public Cmd
+        {
+            TextureGpu *texture;
+
+        public:
+            LoadCancelled( TextureGpu *_texture );
+            void execute() override;
+        };
     };
 
     /** @} */
@@ -0,0 +1,160 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreOcclusionBuffer_H_
+#define _OgreOcclusionBuffer_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Simple/OgreAabb.h"
+#include "OgreFastArray.h"
+#include "OgreMatrix4.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    /** Low resolution depth buffer rasterized on the CPU, used to discard objects that are
+        hidden behind large occluders before they reach the RenderQueue.
+        @See CompositorPassSceneDef::mOcclusionCulling and MovableObject::setOccluder
+    @remarks
+        Usage:
+            1. Call beginOccluders with the camera's view projection matrix.
+            2. Call addOccluder for each occluder.
+            3. Call rasterize for all rows. Different threads can rasterize
+               different (non-overlapping) ranges of rows at the same time.
+            4. Call isOccluded for each object to test. It's thread safe.
+    @par
+        Depth is stored as NDC z (-1 at the near plane, 1 at the far plane). Pixels not covered by
+        any occluder keep an infinite depth, thus they never occlude anything.
+    @par
+        Rasterization is done ARRAY_PACKED_REALS pixels at a time. Pixels are considered covered
+        when their center is, which means an object whose only visible part is a sliver thinner
+        than a pixel (at this resolution) along an occluder's silhouette may be discarded.
+    */
+    class _OgreExport OcclusionBuffer : public OgreAllocatedObj
+    {
+    public:
+        struct Triangle
+        {
+            /// Screen space position (in pixels) and NDC depth of each vertex
+            Real x[3];
+            Real y[3];
+            Real z[3];
+        };
+
+    protected:
+        typedef FastArray<Triangle> TriangleArray;
+
+        uint32 mWidth;
+        uint32 mHeight;
+        /// Values per row. mWidth rounded up to a multiple of ARRAY_PACKED_REALS
+        uint32 mRowPitch;
+        /// SIMD aligned. mRowPitch * mHeight values
+        Real *mDepthBuffer;
+
+        Matrix4       mViewProjMatrix;
+        TriangleArray mTriangles;
+
+        /// Transforms a corner to screen space. Returns false if it's behind the near plane.
+        inline bool projectToScreen( const Matrix4 &worldViewProj, const Vector3 &localPos,
+                                     Real &outX, Real &outY, Real &outZ ) const;
+
+        void rasterizeTriangle( const Triangle &triangle, uint32 firstRow, uint32 lastRow );
+
+    public:
+        OcclusionBuffer( uint32 width = 256u, uint32 height = 128u );
+        ~OcclusionBuffer();
+
+        /// Changes the resolution of the buffer. Occluders must be added again.
+        void setResolution( uint32 width, uint32 height );
+
+        uint32 getWidth() const { return mWidth; }
+        uint32 getHeight() const { return mHeight; }
+        uint32 getRowPitch() const { return mRowPitch; }
+
+        /// Read only access to the depth values. Useful for debugging.
+        const Real *getDepthBuffer() const { return mDepthBuffer; }
+
+        /** Discards all occluders added so far.
+        @param viewProjMatrix
+            Projection * View matrix of the camera. Use the projection matrix without
+            render system specific depth adjustments (Frustum::getProjectionMatrix).
+        */
+        void beginOccluders( const Matrix4 &viewProjMatrix );
+
+        /** Adds the 12 triangles of a box to the list of triangles to rasterize.
+        @remarks
+            The box must be fully inside the occluder's geometry, since everything
+            behind it can get culled.
+        @param localBox
+            Box in local space.
+        @param worldMatrix
+            Transform of the box to world space.
+        @return
+            False if the box wasn't added because it is infinite or crosses the near plane.
+            Occluders that close to the camera can't be rasterized correctly without clipping.
+        */
+        bool addOccluder( const Aabb &localBox, const Matrix4 &worldMatrix );
+
+        /// Number of triangles added since beginOccluders
+        size_t getNumTriangles() const { return mTriangles.size(); }
+
+        /** Clears the given rows and rasterizes all the occluders into them.
+        @remarks
+            Can be called from multiple threads at the same time as long as
+            the ranges don't overlap.
+        @param firstRow
+            First row to rasterize.
+        @param numRows
+            Number of rows to rasterize. Clamped to the height of the buffer.
+        */
+        void rasterize( uint32 firstRow, uint32 numRows );
+
+        /** Returns true if the given box is fully hidden behind the rasterized occluders.
+            Thread safe.
+        @remarks
+            Boxes crossing the near plane or that are infinite are never occluded.
+        */
+        bool isOccluded( const Aabb &worldAabb ) const;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
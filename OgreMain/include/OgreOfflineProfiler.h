@@ -17,7 +17,10 @@ namespace Ogre
     /**
     @class OfflineProfiler
         Simple profiler that will produce a CSV file for offline
-        analysis once dumpProfileResults is called
+        analysis once dumpProfileResults is called.
+
+        It can also produce a timeline of all threads via dumpTimeline, in the Chrome
+        trace event format (open it with chrome://tracing or https://ui.perfetto.dev)
     @remarks
         Because this profiler collects sample undefinitely, it will cause
         memory consumption to grow over time.
@@ -47,8 +50,14 @@ namespace Ogre
             ProfileSample *mCurrentSample;
             Timer         *mTimer;
 
+            /// Add to mTimer's timestamps to convert them to OfflineProfiler::mTimer's
+            /// so that all threads share the same timeline
+            uint64 mUsTimerOffset;
+
             uint64 mTotalAccumTime;
 
+            char mThreadName[OGRE_OFFLINE_PROFILER_NAME_STR_LENGTH];
+
             FastArray<uint8_t *> mMemoryPool;
             size_t               mCurrMemoryPoolOffset;
             size_t               mBytesPerPool;
@@ -58,6 +67,7 @@ namespace Ogre
              * mMemoryPool
              * mCurrMemoryPoolOffset
              * mTotalAccumTime
+             * mThreadName
              */
             LightweightMutex mMutex;
 
@@ -70,12 +80,20 @@ namespace Ogre
             void dumpSample( ProfileSample *sample, LwString &tmpStr, String &outCsvString,
                              StdMap<IdString, ProfileSample> &accumStats, uint32 stackDepth );
 
+            /// Whether profileEnd hasn't been called yet for the sample
+            bool isSampleOpen( const ProfileSample *sample ) const;
+
+            void dumpTimelineSample( const ProfileSample *sample, LwString &tmpStr, String &outJson,
+                                     size_t threadIdx, uint64 usNow ) const;
+
             void reset();
 
         public:
-            PerThreadData( bool startPaused, size_t bytesPerPool );
+            PerThreadData( bool startPaused, size_t bytesPerPool, Timer *profilerTimer );
             ~PerThreadData();
 
+            void setThreadName( const char *name );
+
             void setPauseRequest( bool bPause );
             void requestReset();
 
@@ -84,20 +102,29 @@ namespace Ogre
 
             void dumpProfileResultsStr( String &outCsvStringPerFrame, String &outCsvStringAccum );
             void dumpProfileResults( const String &fullPathPerFrame, const String &fullPathAccum );
+
+            /// Appends the trace events of this thread. Unlike dumpProfileResultsStr,
+            /// collected samples are not reset.
+            void dumpTimelineStr( String &outJson, size_t threadIdx );
         };
 
         typedef FastArray<PerThreadData *> PerThreadDataArray;
 
         bool mPaused;
 
-        LightweightMutex   mMutex;  // Protects mThreadData
+        LightweightMutex   mMutex;  // Protects mThreadData, mTimer & mFrameMarkers
         TlsHandle          mTlsHandle;
         PerThreadDataArray mThreadData;
 
+        /// Reference timer for the timeline. Every thread's timestamps are relative to it
+        Timer            *mTimer;
+        FastArray<uint64> mFrameMarkers;
+
         size_t mBytesPerPool;
 
         String mOnShutdownPerFramePath;
         String mOnShutdownAccumPath;
+        String mOnShutdownTimelinePath;
 
         PerThreadData *allocatePerThreadData();
 
@@ -135,6 +162,18 @@ namespace Ogre
         void profileBegin( const char *name, ProfileSampleFlags::ProfileSampleFlags flags );
         void profileEnd();
 
+        /// Records the start of a new frame. Shows up as a global marker in the timeline.
+        /// Root calls it for you at the beginning of each frame.
+        void markFrame();
+
+        /** Names the calling thread in the timeline (e.g. "Main Thread" or "Worker 3").
+            Unnamed threads appear as "Thread N", where N is the order in which they
+            first collected a sample.
+        @param name
+            Null terminated string. Truncated to OGRE_OFFLINE_PROFILER_NAME_STR_LENGTH - 1
+        */
+        void setCurrentThreadName( const char *name );
+
         /** Dumps CSV data into two CSV files
         @param fullPathPerFrame
             Full path to csv without extension to generate where to dump the per-frame CSV data.
@@ -149,6 +188,25 @@ namespace Ogre
         */
         void dumpProfileResults( const String &fullPathPerFrame, const String &fullPathAccum );
 
+        /** Generates a timeline of every collected sample of every thread, in Chrome's
+            trace event JSON format (which Perfetto also understands).
+            Each thread is a track, and frames are marked with global instant events.
+        @remarks
+            Unlike dumpProfileResults, samples are not reset. Thus if you want both, call
+            dumpTimeline first.
+            Samples flagged as ProfileSampleFlags::Aggregate are merged with their previous
+            sibling of the same name, therefore they span from the first begin to the last end.
+        @param outJson [out]
+            The JSON string
+        */
+        void dumpTimelineStr( String &outJson );
+
+        /** Same as dumpTimelineStr, but writes it into a file
+        @param fullPath
+            Full path to the file, including extension (i.e. usually .json)
+        */
+        void dumpTimeline( const String &fullPath );
+
         /** Ogre will call dumpProfileResults for your on shutdown if you set these paths
         @param fullPathPerFrame
             Full path to csv without extension to generate where to dump the per-frame CSV data.
@@ -160,9 +218,13 @@ namespace Ogre
             Empty string to skip it.
             Note that the CSV extension will be appended, and the actual filename
             my vary as there will be one file per thread that was collected.
+        @param fullPathTimeline
+            Full path to the JSON file where to dump the timeline. Empty string to skip it.
         @see    OfflineProfiler::dumpProfileResults
+        @see    OfflineProfiler::dumpTimeline
         */
-        void setDumpPathsOnShutdown( const String &fullPathPerFrame, const String &fullPathAccum );
+        void setDumpPathsOnShutdown( const String &fullPathPerFrame, const String &fullPathAccum,
+                                     const String &fullPathTimeline = "" );
     };
 }  // namespace Ogre
 
@@ -116,6 +116,8 @@ namespace Ogre
 
         static PixelFormatDesc msPixelFormatDesc[PFG_COUNT + 1u];
 
+        static uint32 msMaxBulkConversionThreads;
+
         static inline const PixelFormatDesc &getDescriptionFor( const PixelFormatGpu fmt );
 
         template <typename T>
@@ -212,10 +214,26 @@ namespace Ogre
 
         static void convertForNormalMapping( TextureBox src, PixelFormatGpu srcFormat, TextureBox dst,
                                              PixelFormatGpu dstFormat );
+        /** Converts src into dst.
+        @remarks
+            The most common pairs (e.g. RGB8 -> RGBA8, RGBA8 <-> BGRA8, RGBA8 <-> RGBA16F / RGBA32F,
+            sRGB <-> linear) have fast paths, some of them using SIMD. The rest go through a
+            generic (slow) per-pixel path.
+            Large images may be split across multiple threads. See setMaxBulkConversionThreads
+        */
         static void bulkPixelConversion( const TextureBox &src, PixelFormatGpu srcFormat,
                                          TextureBox &dst, PixelFormatGpu dstFormat,
                                          bool verticalFlip = false );
 
+        /** Sets the max number of threads bulkPixelConversion can use for large images.
+            The calling thread counts as one of them. Default is 1 (no threading).
+        @remarks
+            Not thread safe. Set it once at startup, before any conversion may be running
+            (e.g. before the texture streaming threads start).
+        */
+        static void   setMaxBulkConversionThreads( uint32 maxThreads );
+        static uint32 getMaxBulkConversionThreads();
+
         /// See PixelFormatFlags
         static uint32 getFlags( PixelFormatGpu format );
 
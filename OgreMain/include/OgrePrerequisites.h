@@ -220,6 +220,7 @@ namespace Ogre
     class NodeMemoryManager;
     struct ObjectData;
     class ObjectMemoryManager;
+    class OcclusionBuffer;
     class Particle;
     class ParticleAffector;
     class ParticleAffectorFactory;
@@ -198,6 +198,13 @@ namespace Ogre
 #    define OgreProfileExhaustiveAggr( a )
 #endif
 
+// For code that runs in worker threads. OGRE_PROFILING_INTERNAL is not thread safe
+#if OGRE_PROFILING == OGRE_PROFILING_REMOTERY || OGRE_PROFILING == OGRE_PROFILING_INTERNAL_OFFLINE
+#    define OgreProfileWorker( a ) OgreProfile( a )
+#else
+#    define OgreProfileWorker( a )
+#endif
+
 namespace Ogre
 {
     /** \addtogroup Core
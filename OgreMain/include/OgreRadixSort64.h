@@ -0,0 +1,181 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreRadixSort64_H_
+#define _OgreRadixSort64_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreFastArray.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    class TaskScheduler;
+
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup General
+     *  @{
+     */
+
+    /** Stable LSD radix sort of 64-bit keys, 8 bits per pass.
+    @remarks
+        Unlike RadixSort, it doesn't sort the container directly but (key, index) pairs, so
+        the caller can then gather its own (possibly large) elements once in the right order.
+    @par
+        Before sorting, a histogram of every byte of the keys is built in a single read. Passes
+        on bytes that are the same in all keys (e.g. the upper bits of RenderQueue's hashes,
+        which are often unused) are skipped.
+    @par
+        Large arrays are split in contiguous chunks which are counted and scattered by the
+        worker threads of a TaskScheduler. Each pass is chained to the previous one as a
+        dependency, so the caller only waits once.
+    */
+    class _OgreExport RadixSort64
+    {
+    public:
+        struct Entry
+        {
+            uint64 key;
+            uint32 idx;
+        };
+
+        typedef FastArray<Entry> EntryArray;
+
+    protected:
+        class CountTask;
+        class ScatterTask;
+
+        EntryArray mScratch;
+        /// Per-chunk histograms. mHistograms[(chunkIdx * 8u + byteIdx) * 256u + value]
+        FastArray<uint32> mHistograms;
+        size_t            mNumChunks;
+        size_t            mChunkSize;
+        size_t            mNumEntries;
+        size_t            mParallelThreshold;
+
+        /// Counts all the bytes of the keys in the chunk
+        void countAllBytes( const Entry *src, size_t chunkIdx );
+        /// Counts byteIdx of the keys in the chunk
+        void countByte( const Entry *src, size_t chunkIdx, size_t byteIdx );
+        /// Moves the entries of the chunk to their place in dst, according to byteIdx
+        void scatter( const Entry *src, Entry *dst, size_t chunkIdx, size_t byteIdx );
+
+    public:
+        RadixSort64();
+
+        /** Sorts the entries in ascending key order. Entries with the same key keep their order.
+        @param entries
+            Entries to sort. The array may get swapped with an internal one.
+        @param taskScheduler
+            Used to sort in parallel when there are at least getParallelThreshold() entries.
+            Can be null.
+        */
+        void sort( EntryArray &entries, TaskScheduler *taskScheduler = 0 );
+
+        /** Insertion sort that gives up once it has moved too many entries. Very fast
+            when the input is already almost sorted (e.g. it's the order from last frame).
+        @param maxMoves
+            Maximum number of positions entries may be shifted in total.
+        @return
+            True if the range was sorted. False if it gave up, in which case the range is
+            left in an unspecified order (but still contains the same entries).
+        */
+        static bool insertionSort( Entry *begin, Entry *end, size_t maxMoves );
+
+        /// Arrays with fewer entries are sorted in the calling thread. Default is 16384.
+        void   setParallelThreshold( size_t numEntries );
+        size_t getParallelThreshold() const { return mParallelThreshold; }
+    };
+
+    /** Remembers the sorted order of a set of objects from one sort to the next, so that a
+        sort of almost the same objects (e.g. the render queue of the next frame) can start
+        from it and finish with RadixSort64::insertionSort.
+    @remarks
+        The order is keyed by an id given by the caller that identifies each object (e.g. its
+        address), not by its position in the input. Thus it is still useful when the objects
+        are gathered in a different order every time.
+    */
+    class _OgreExport FrameCoherentSortOrder
+    {
+        struct Slot
+        {
+            uint64 id;
+            /// Position in the sorted order. NoRank if the slot is empty
+            uint32 rank;
+        };
+
+        static const uint32 NoRank = 0xFFFFFFFF;
+
+        /// Open addressing hash table from id to rank. Size is a power of 2
+        FastArray<Slot>          mTable;
+        uint32                   mNumRanks;
+        RadixSort64::EntryArray  mScratch;
+        FastArray<uint8>         mRankTaken;
+
+        size_t findSlot( uint64 id ) const;
+
+        /** Reorders entries to follow the remembered order. Objects that weren't there
+            last time go last.
+        @return
+            False if the objects changed too much for the order to be useful, in which
+            case entries is left untouched.
+        */
+        bool applyLastOrder( RadixSort64::EntryArray &entries, const uint64 *ids );
+
+    public:
+        FrameCoherentSortOrder();
+
+        /** Sorts the entries in ascending key order, starting from the order remembered
+            from the last call when possible; and remembers the new order.
+        @param entries
+            Entries to sort. entries[i].idx must be i.
+        @param ids
+            ids[i] identifies the object of entries[i]. The same object must keep its id
+            between calls.
+        @return
+            True if the remembered order was close enough and the insertion sort finished
+            it. False if a full sort with radixSort was needed.
+        */
+        bool sort( RadixSort64::EntryArray &entries, const uint64 *ids, RadixSort64 &radixSort,
+                   TaskScheduler *taskScheduler = 0 );
+
+        /// Forgets the remembered order
+        void clear();
+    };
+
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
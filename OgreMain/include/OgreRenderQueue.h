@@ -32,7 +32,9 @@ THE SOFTWARE.
 
 #include "OgreHlmsCommon.h"
 #include "OgreIteratorWrappers.h"
+#include "OgreRadixSort64.h"
 #include "OgreSharedPtr.h"
+#include "ogrestd/map.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -152,6 +154,38 @@ namespace Ogre
 
         typedef vector<IndirectBufferPacked *>::type IndirectBufferPackedVec;
 
+        /// Sorted order of a render queue in the last frame it was rendered by a camera.
+        /// See RenderQueue::setFrameCoherentSorting
+        struct FrameCoherentOrder
+        {
+            /// Keyed by the renderable & movable object, since the order in which they're
+            /// gathered changes every frame (e.g. whichever thread culled them first).
+            FrameCoherentSortOrder order;
+            uint32                 lastFrame;
+
+            FrameCoherentOrder() : lastFrame( 0 ) {}
+        };
+
+        typedef std::pair<Camera const *, uint8>                     FrameCoherentOrderKey;
+        typedef map<FrameCoherentOrderKey, FrameCoherentOrder>::type FrameCoherentOrderMap;
+
+        /// A contiguous range of a FAST render queue, recorded into its own CommandBuffer.
+        /// See Hlms::setParallelCommandGeneration
+        struct CommandSlice
+        {
+            CommandBuffer   *commandBuffer;
+            size_t           firstIdx;
+            size_t           lastIdx;
+            /// First renderable that still needs to be recorded from the render thread.
+            /// Equals lastIdx once the whole slice has been recorded.
+            size_t           resumeIdx;
+            unsigned char   *indirectDraw;
+            uint32           lastVaoName;
+            RenderingMetrics stats;
+        };
+
+        class CommandSliceTask;
+
         RenderQueueGroup mRenderQueues[256];
 
         HlmsManager  *mHlmsManager;
@@ -171,6 +205,24 @@ namespace Ogre
 
         HlmsCache mPassCache[HLMS_MAX];
 
+        FastArray<CommandSlice>    mCommandSlices;
+        FastArray<CommandBuffer *> mSliceCommandBuffers;
+        /// HlmsCache of each renderable of the render queue being recorded in slices
+        FastArray<HlmsCache const *> mSliceHlmsCaches;
+        /// Number of renderables of each Hlms in each slice.
+        /// mSliceRenderablesPerHlms[hlmsType * numSlices + sliceIdx]
+        FastArray<size_t> mSliceRenderablesPerHlms;
+        size_t            mMinRenderablesPerSlice;
+
+        RadixSort64             mRadixSort;
+        RadixSort64::EntryArray mSortEntries;
+        /// Identity of each renderable in mSortEntries. See FrameCoherentSortOrder
+        FastArray<uint64>       mSortIds;
+        QueuedRenderableArray   mSortScratch;
+        FrameCoherentOrderMap   mFrameCoherentOrders;
+        bool                    mFrameCoherentSorting;
+        uint32                  mFrameCount;
+
         uint32 mRenderingStarted;
 
         /** Returns a new (or an existing) indirect buffer that can hold the requested number of draws.
@@ -198,6 +250,41 @@ namespace Ogre
         void renderGL3V1( RenderSystem *rs, bool casterPass, bool dualParaboloid, HlmsCache passCache[],
                           const RenderQueueGroup &renderQueueGroup );
 
+        /** Records queuedRenderables in range [slice.resumeIdx; slice.lastIdx) into
+            slice.commandBuffer, writing the indirect draws from slice.indirectDraw onwards.
+        @param sliceIdx
+            When std::numeric_limits<size_t>::max(), it runs in the render thread.
+            Otherwise it runs in a worker thread, using the HlmsCaches from mSliceHlmsCaches
+            and Hlms::_fillBuffersForV2Slice. If an Hlms runs out of memory for the slice,
+            it stops early leaving slice.resumeIdx at the renderable that couldn't be recorded,
+            after discarding the commands recorded for it.
+        */
+        void renderGL3Range( CommandSlice &slice, bool casterPass, HlmsCache passCache[],
+                             const QueuedRenderableArray &queuedRenderables,
+                             IndirectBufferPacked *indirectBuffer, unsigned char *startIndirectDraw,
+                             size_t sliceIdx );
+
+        /// Returns how many slices renderQueueGroup should be split into for recording it
+        /// in parallel. 1 if it should be recorded serially.
+        size_t getNumCommandSlices( const RenderQueueGroup &renderQueueGroup ) const;
+
+        /// Same as renderGL3, but the range is split in numSlices recorded by the worker threads
+        unsigned char *renderGL3Parallel( RenderSystem *rs, bool casterPass, HlmsCache passCache[],
+                                          const RenderQueueGroup &renderQueueGroup,
+                                          IndirectBufferPacked *indirectBuffer,
+                                          unsigned char *indirectDraw, unsigned char *startIndirectDraw,
+                                          size_t numSlices );
+
+        /// Sorts the render queues in range [firstRq; lastRq) that haven't been sorted yet
+        void sortRenderQueues( uint8 firstRq, uint8 lastRq );
+
+        /// Sorts the already merged renderables of the render queue by their hash
+        void sortRenderQueue( uint8 rqId );
+
+        /// Generates in the worker threads the shaders of the renderables in range
+        /// [firstRq; lastRq) that don't have a PSO yet. See Hlms::setParallelShaderGeneration
+        void generateShaders( uint8 firstRq, uint8 lastRq, bool casterPass );
+
     public:
         RenderQueue( HlmsManager *hlmsManager, SceneManager *sceneManager, VaoManager *vaoManager );
         ~RenderQueue();
@@ -294,6 +381,31 @@ namespace Ogre
         */
         void       setSortRenderQueue( uint8 rqId, RqSortMode sortMode );
         RqSortMode getSortRenderQueue( uint8 rqId ) const;
+
+        /** FAST render queues whose Hlms have Hlms::setParallelCommandGeneration enabled are
+            split in slices of at least this many renderables (at most one per worker thread).
+            Render queues with fewer renderables are recorded serially.
+        @param minRenderables
+            Must be > 0. Default is 512.
+        */
+        void   setMinRenderablesPerSlice( size_t minRenderables );
+        size_t getMinRenderablesPerSlice() const { return mMinRenderablesPerSlice; }
+
+        /** When enabled, NormalSort render queues remember their sorted order per camera and
+            start the next frame's sort from it, fixing it up with an insertion sort.
+        @remarks
+            This pays off when the visible set barely changes between frames (i.e. the camera
+            and objects move slowly), since their hashes rarely change. The order is kept per
+            renderable (see FrameCoherentSortOrder), so it doesn't matter that the worker
+            threads gather them in a different order every frame. If it's too different, it falls
+            back to a full sort; the result is always correctly sorted either way.
+        @par
+            StableSort render queues are never affected, as reusing the order from last
+            frame would not preserve the order of renderables with the same hash.
+            Default is false.
+        */
+        void setFrameCoherentSorting( bool frameCoherentSorting );
+        bool getFrameCoherentSorting() const { return mFrameCoherentSorting; }
     };
 
 #define OGRE_RQ_MAKE_MASK( x ) ( ( 1 << ( x ) ) - 1 )
@@ -109,6 +109,17 @@ namespace Ogre
 
             /** Called whenever the resource has been unloaded. */
             virtual void unloadingComplete( Resource * ) {}
+
+            /** Called when loading the resource failed in a way the caller of load() cannot
+                see, i.e. when it was requested from a background thread
+                (@see MeshManager::loadInBackground). The resource is left unloaded.
+            @remarks
+                Like loadingComplete, the call occurs in the application's primary frame
+                loop thread.
+            @param description
+                Full description of the error.
+            */
+            virtual void loadingFailed( Resource *, const String &description ) {}
         };
 
         /// Enum identifying the loading state of the resource
@@ -475,6 +486,14 @@ namespace Ogre
         */
         virtual void _fireUnloadingComplete();
 
+        /** Firing of loading failed event
+        @remarks
+            You should call this from the thread that runs the main frame loop
+            to avoid having to make the receivers of this event thread-safe.
+            @param description Full description of the error
+        */
+        virtual void _fireLoadingFailed( const String &description );
+
         /** Calculate the size of a resource; this will only be called after 'load' */
         virtual size_t calculateSize() const;
     };
@@ -161,6 +161,9 @@ namespace Ogre
 
         bool mFrameStarted;
 
+        /// Value of TextureGpuManager::getStreamingStallTimeUs at the end of the last frame
+        uint64 mLastStreamingStallTimeUs;
+
         /// Tells whether blend indices information needs to be passed to the GPU
         bool mIsBlendIndicesGpuRedundant;
         /// Tells whether blend weights information needs to be passed to the GPU
@@ -528,6 +531,7 @@ namespace Ogre
         bool endRenderingQueued();
 
         const FrameStats *getFrameStats() const { return mFrameStats; }
+        FrameStats       *getFrameStats() { return mFrameStats; }
 
         /** Starts / restarts the automatic rendering cycle.
             @remarks
@@ -34,6 +34,7 @@ Torus Knot Software Ltd.
 #include "OgrePrerequisites.h"
 
 #include "Animation/OgreSkeletonAnimManager.h"
+#include "Animation/OgreSkeletonInstance.h"
 #include "Compositor/Pass/OgreCompositorPass.h"
 #include "Math/Array/OgreNodeMemoryManager.h"
 #include "Math/Array/OgreObjectMemoryManager.h"
@@ -47,7 +48,9 @@ Torus Knot Software Ltd.
 #include "OgreRenderSystem.h"
 #include "OgreResourceGroupManager.h"
 #include "OgreSceneQuery.h"
-#include "Threading/OgreThreads.h"
+#include "OgreTransformUpdateScheduler.h"
+#include "Threading/OgreTaskScheduler.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -82,7 +85,6 @@ namespace Ogre
     struct EntityMeshLodChangedEvent;
     struct EntityMaterialLodChangedEvent;
     class CompositorShadowNode;
-    class UniformScalableTask;
 
     class RadialDensityMask;
 
@@ -104,6 +106,11 @@ namespace Ogre
         /// Whether we should immediately add to render queue v2 objects
         bool addToRenderQueue;
         bool cullingLights;
+        /// Whether to discard the objects hidden behind occluders. @See OcclusionBuffer
+        bool occlusionCulling;
+        /// Whether to estimate the screen coverage of the visible objects.
+        /// @See TextureGpuManager::setAutomaticLoadPriorities
+        bool textureScreenCoverage;
         /** Memory manager of the objects to cull. Could contain all Lights, all Entity, etc.
             Could be more than one depending on the high level cull system (i.e. tree-based sys)
             Must be const (it is read only for all threads).
@@ -120,6 +127,8 @@ namespace Ogre
             casterPass( false ),
             addToRenderQueue( true ),
             cullingLights( false ),
+            occlusionCulling( false ),
+            textureScreenCoverage( false ),
             objectMemManager( 0 ),
             camera( 0 ),
             lodCamera( 0 )
@@ -133,6 +142,8 @@ namespace Ogre
             casterPass( _casterPass ),
             addToRenderQueue( _addToRenderQueue ),
             cullingLights( _cullingLights ),
+            occlusionCulling( false ),
+            textureScreenCoverage( false ),
             objectMemManager( _objectMemManager ),
             camera( _camera ),
             lodCamera( _lodCamera )
@@ -154,23 +165,6 @@ namespace Ogre
         }
     };
 
-    struct UpdateTransformRequest
-    {
-        Transform t;
-        /// Number of nodes to process for each thread. Must be multiple of ARRAY_PACKED_REALS
-        size_t numNodesPerThread;
-        size_t numTotalNodes;
-
-        UpdateTransformRequest() : numNodesPerThread( 0 ), numTotalNodes( 0 ) {}
-
-        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerThread, size_t _numTotalNodes ) :
-            t( _t ),
-            numNodesPerThread( _numNodesPerThread ),
-            numTotalNodes( _numTotalNodes )
-        {
-        }
-    };
-
     struct BuildLightListRequest
     {
         size_t startLightIdx;
@@ -415,6 +409,13 @@ namespace Ogre
         ObjectMemoryManagerVec mForwardPlusMemoryManagerCullList;
         SkeletonAnimManagerVec mSkeletonAnimManagerCulledList;
 
+        /// One per thread. See SkeletonInstance::setPoseSharing
+        typedef vector<SkeletonInstance::SharedPoseMap>::type SharedPoseMapPerThread;
+        SharedPoseMapPerThread                                mSharedSkeletonPoses;
+
+        /// See setIncrementalDefragmentation
+        size_t mIncrementalDefragSlotsPerFrame;
+
         uint32 mNumDecals;
         uint32 mNumCubemapProbes;
 
@@ -426,6 +427,15 @@ namespace Ogre
         */
         uint16 mStaticMinDepthLevelDirty;
 
+        /** Lowest depth level of mNodeMemoryManager[SCENE_STATIC] whose Transform::mDirty flags
+            may still be set by its last update. They're kept for one more frame, because dynamic
+            children of static nodes are updated before their parents. @See updateAllTransforms
+        */
+        uint16 mStaticDirtyFlagsMinDepth;
+
+        /// @See setTransformDirtyTracking
+        bool mTransformDirtyTracking;
+
         /** Whether mEntityMemoryManager[SCENE_STATIC] is dirty (assume all render queues,
             you shouldn't be doing this often anyway!)
         */
@@ -821,29 +831,137 @@ namespace Ogre
         {
             CULL_FRUSTUM,
             UPDATE_ALL_ANIMATIONS,
-            UPDATE_ALL_TRANSFORMS,
-            UPDATE_ALL_BONE_TO_TAG_TRANSFORMS,
-            UPDATE_ALL_TAG_ON_TAG_TRANSFORMS,
             UPDATE_ALL_BOUNDS,
             UPDATE_ALL_LODS,
             BUILD_LIGHT_LIST01,
             BUILD_LIGHT_LIST02,
-            USER_UNIFORM_SCALABLE_TASK,
-            STOP_THREADS,
+            CULL_FRUSTUM_BATCH,
+            ADD_BATCHED_CULL_RESULTS,
+            RASTERIZE_OCCLUDERS,
             NUM_REQUESTS
         };
 
+        /// Runs mRequestType split in exactly one chunk per thread. @See updateWorkerThreadImpl
+        class UniformRequestTask : public UniformScalableTask
+        {
+            SceneManager *mSceneManager;
+
+        public:
+            UniformRequestTask( SceneManager *sceneManager ) : mSceneManager( sceneManager ) {}
+            void execute( size_t threadId, size_t numThreads ) override;
+        };
+
+        /// Runs mRequestType over mObjectChunks. @See executeChunkedRequest
+        class ChunkedRequestTask : public Task
+        {
+            SceneManager *mSceneManager;
+
+        public:
+            ChunkedRequestTask( SceneManager *sceneManager ) : mSceneManager( sceneManager ) {}
+            void execute( size_t chunkIdx, size_t threadIdx ) override;
+        };
+
+        /// A range of objects from one render queue of an ObjectMemoryManager
+        struct ObjectChunk
+        {
+            ObjectData           objData;
+            size_t               numObjs;
+            uint8                renderQueueId;
+            ObjectMemoryManager *memoryManager;
+            /// Index of the first object within its render queue
+            size_t firstObj;
+        };
+
+        /// A camera queued by _addBatchedCull, and the state it had when _fireBatchedCull culled it
+        struct BatchedCullCamera
+        {
+            Camera const *camera;
+            Camera const *lodCamera;
+            uint32        visibilityMask;
+            uint8         firstRq;
+            uint8         lastRq;
+            Vector3       cameraPos;
+            Vector3       lodCameraPos;
+            Plane         frustumPlanes[6];
+        };
+
         size_t mNumWorkerThreads;
         bool   mForceMainThread;
 
-        CullFrustumRequest            mCurrentCullFrustumRequest;
-        UpdateLodRequest              mUpdateLodRequest;
-        UpdateTransformRequest        mUpdateTransformRequest;
-        ObjectMemoryManagerVec const *mUpdateBoundsRequest;
-        UniformScalableTask          *mUserTask;
-        RequestType                   mRequestType;
-        Barrier                      *mWorkerThreadsBarrier;
-        ThreadHandleVec               mWorkerThreads;
+        CullFrustumRequest    mCurrentCullFrustumRequest;
+        UpdateLodRequest      mUpdateLodRequest;
+        RequestType           mRequestType;
+        TaskScheduler        *mTaskScheduler;
+        UniformRequestTask    mUniformRequestTask;
+        ChunkedRequestTask    mChunkedRequestTask;
+        TaskScheduler::TaskId mUserTaskId;
+
+        FastArray<ObjectChunk>   mObjectChunks;
+        TransformUpdateScheduler mTransformUpdateScheduler;
+
+        /// @See _addBatchedCull
+        FastArray<BatchedCullCamera> mBatchedCullCameras;
+        FastArray<Camera const *>    mBatchedCullFrustums;
+        FastArray<Camera const *>    mBatchedCullLodCameras;
+        FastArray<uint32>            mBatchedCullVisibilityMasks;
+        /// The mObjectChunks that _fireBatchedCull split the objects into
+        FastArray<ObjectChunk> mBatchedCullChunks;
+        /// Results of _fireBatchedCull. Entry [chunkIdx * mBatchedCullCameras.size() + cameraIdx]
+        /// contains the visible objects from mBatchedCullChunks[chunkIdx] seen by cameraIdx
+        FastArray<MovableObject::MovableObjectArray> mBatchedCullObjects;
+        FastArray<FastArray<RealAsUint> >            mBatchedCullDistances;
+        /// Camera whose results are being added by ADD_BATCHED_CULL_RESULTS
+        size_t mBatchedCullCameraIdx;
+        bool   mBatchedCullFired;
+
+    public:
+        struct OcclusionCullingStats
+        {
+            /// Occluders rasterized into the occlusion buffer
+            size_t numOccluders;
+            /// Objects that passed frustum culling and were tested against the occlusion buffer
+            size_t numTested;
+            /// Objects that were discarded because they were hidden behind the occluders
+            size_t numRejected;
+
+            OcclusionCullingStats() : numOccluders( 0 ), numTested( 0 ), numRejected( 0 ) {}
+        };
+
+        struct TransformUpdateStats
+        {
+            /// Nodes (SoA slots, including empty ones) that were visited
+            size_t numNodes;
+            /// Nodes whose derived transform was recomputed. Nodes are recomputed in packs of
+            /// ARRAY_PACKED_REALS; if any node in the pack needs it, the whole pack is counted.
+            size_t numNodesUpdated;
+            /// Tasks submitted to the TaskScheduler. Each one waited for the previous one.
+            /// See setTransformUpdateScheduling
+            size_t numTasks;
+
+            TransformUpdateStats() : numNodes( 0 ), numNodesUpdated( 0 ), numTasks( 0 ) {}
+        };
+
+    protected:
+        /// Objects flagged with MovableObject::setOccluder
+        FastArray<MovableObject *> mOccluders;
+        /// Created the first time a pass enables occlusion culling
+        OcclusionBuffer *mOcclusionBuffer;
+        uint32           mOcclusionBufferWidth;
+        uint32           mOcclusionBufferHeight;
+        /// Rows rasterized by each RASTERIZE_OCCLUDERS chunk
+        uint32 mOcclusionRowsPerBand;
+        bool   mOcclusionCullingInPass;
+        /// Stats of the last pass that used occlusion culling
+        OcclusionCullingStats            mOcclusionCullingStats;
+        FastArray<OcclusionCullingStats> mOcclusionCullingStatsPerThread;
+
+        typedef map<HlmsDatablock *, float>::type DatablockScreenCoverageMap;
+        /// Largest screen coverage of each datablock seen by each cull thread in the
+        /// last pass. @See accumulateTextureScreenCoverage
+        vector<DatablockScreenCoverageMap>::type mTextureScreenCoveragePerThread;
+
+        /// Stats of the last updateAllTransforms
+        TransformUpdateStats mTransformUpdateStats;
 
         /** Contains MovableObjects to be visited and rendered.
         @rermarks
@@ -914,36 +1032,28 @@ namespace Ogre
         void updateAllAnimationsThread( size_t threadIdx );
         void updateAnimationTransforms( BySkeletonDef &bySkeletonDef, size_t threadIdx );
 
-        /** Updates the Nodes from the given request inside a thread. @See updateAllTransforms
-        @param request
-            Fully setup request. @See UpdateTransformRequest.
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
-        */
-        void updateAllTransformsThread( const UpdateTransformRequest &request, size_t threadIdx );
-
-        /// @see TagPoint::updateAllTransformsBoneToTag
-        void updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
-                                                 size_t                        threadIdx );
+        /// How many objects (or nodes) go in each chunk when splitting numObjects of them
+        /// across the worker threads. Always a multiple of ARRAY_PACKED_REALS.
+        size_t getObjectsPerChunk( size_t numObjects ) const;
 
-        /// @see TagPoint::updateAllTransformsTagOnTag
-        void updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
-                                                size_t                        threadIdx );
-
-        /** Updates the world aabbs from the given request inside a thread. @See updateAllTransforms
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
+        /** Updates every depth level of the given managers with mTransformUpdateScheduler.
+            Each level depends on the previous one. Returns after all of them are done.
+        @param rootUpdateFunction
+            Used for the first depth level. updateFunction is used for the rest.
+        @param staticStartDepth
+            First depth level of the static managers. Dynamic ones always start at 0.
         */
-        void updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager, size_t threadIdx );
+        TransformUpdateStats updateTransformsInTasks(
+            const NodeMemoryManagerVec &nodeMemoryManagers,
+            UpdateTransformTask::UpdateFunction rootUpdateFunction,
+            UpdateTransformTask::UpdateFunction updateFunction, size_t staticStartDepth );
 
-        /**
-        @param threadIdx
-            Thread index so we know at which point we should start at.
-            Must be unique for each worker thread
-        */
-        void updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx );
+        /// Splits the objects from render queues [firstRq; lastRq) into mObjectChunks
+        void prepareObjectChunks( const ObjectMemoryManagerVec &objectMemManager, size_t firstRq,
+                                  size_t lastRq );
+
+        /// Runs mRequestType over each entry in mObjectChunks. Called from the worker threads.
+        void executeChunkedRequest( size_t chunkIdx, size_t threadIdx );
 
         /** Low level culling, culls all objects against the given frustum active cameras. This
             includes checking visibility flags (both scene and viewport's)
@@ -956,6 +1066,67 @@ namespace Ogre
         */
         void cullFrustum( const CullFrustumRequest &request, size_t threadIdx );
 
+        /** Culls numObjs objects from the given render queue, adding the results to
+            mVisibleObjects[threadIdx] (or directly to the RenderQueue). @See cullFrustum
+        @param clusters
+            When not null, the clusters of the objects (starting at the one objData
+            belongs to). Objects in clusters outside the frustum are skipped.
+            @See ObjectMemoryManager::setClusterCulling
+        */
+        void cullFrustumRange( const CullFrustumRequest &request, ObjectData objData, size_t numObjs,
+                               uint8 renderQueueId, size_t threadIdx,
+                               const ObjectMemoryManager::Cluster *clusters );
+
+        /** Rasterizes the occluders seen by the camera into mOcclusionBuffer.
+        @return
+            False if there are no occluders to rasterize.
+        */
+        bool prepareOcclusionBuffer( const Camera *camera, uint8 firstRq, uint8 lastRq );
+
+        /// Removes the entries of inOutVisibleObjects from index firstIdx onwards
+        /// that are hidden behind the occluders in mOcclusionBuffer.
+        void applyOcclusionCulling( MovableObject::MovableObjectArray &inOutVisibleObjects,
+                                    size_t firstIdx, size_t threadIdx );
+
+        /// Estimates how much of the screen each entry of visibleObjects from index
+        /// firstIdx onwards covers, and keeps the largest value per datablock in
+        /// mTextureScreenCoveragePerThread. Called from the cull threads.
+        void accumulateTextureScreenCoverage( const Camera                            *camera,
+                                              const MovableObject::MovableObjectArray &visibleObjects,
+                                              size_t firstIdx, size_t threadIdx );
+
+        /// Passes what accumulateTextureScreenCoverage collected in each thread to the
+        /// datablocks, so that the textures still loading can be prioritized.
+        /// See TextureGpuManager::setAutomaticLoadPriorities
+        void collectTextureScreenCoverage();
+
+        /// When the render queue is in FAST mode, adds the objects culled by cullFrustumRange
+        /// to the RenderQueue and empties inOutVisibleObjects.
+        void addVisibleObjectsToRenderQueue( const CullFrustumRequest        &request,
+                                             MovableObject::MovableObjectArray &inOutVisibleObjects,
+                                             uint8 renderQueueId, size_t threadIdx );
+
+        /// Culls mBatchedCullChunks[chunkIdx] against all mBatchedCullCameras
+        void cullFrustumBatchChunk( size_t chunkIdx );
+
+        /// Adds the results of mBatchedCullChunks[chunkIdx] for mBatchedCullCameraIdx
+        /// to mVisibleObjects[threadIdx] (or directly to the RenderQueue).
+        void addBatchedCullResultsChunk( size_t chunkIdx, size_t threadIdx );
+
+        /** If _fireBatchedCull already culled request.camera with the same parameters (and the
+            camera hasn't moved since), adds those results to mVisibleObjects and the RenderQueue
+            as fireCullFrustumTasks would have.
+        @return
+            False if there were no valid batched results for the request. Nothing was done.
+        */
+        bool addBatchedCullResults( const CullFrustumRequest &request );
+
+        /// Returns the visibility mask cullFrustumRange would use for the given viewport mask
+        uint32 getCombinedVisibilityMask( uint32 viewportVisibilityMask ) const;
+
+        /// Clamps [firstRq; lastRq) to the render queues that are in use
+        void clampToUsedRenderQueues( uint8 &inOutFirstRq, uint8 &inOutLastRq ) const;
+
         /** Builds a list of all lights that are visible by all queued cameras (this should be fed by
             Compositor). Then calls MovableObject::buildLightList with that list so that each
             MovableObject gets it's own sorted list of the closest lights.
@@ -1326,6 +1497,67 @@ namespace Ogre
         /// @see CompositorPassSceneDef::mEnableForwardPlus
         void _setForwardPlusEnabledInPass( bool bEnable );
 
+        /// For internal use.
+        /// @see CompositorPassSceneDef::mOcclusionCulling
+        void _setOcclusionCullingInPass( bool bEnable ) { mOcclusionCullingInPass = bEnable; }
+
+        /// For internal use. Called by MovableObject::setOccluder
+        void _addOccluder( MovableObject *occluder );
+        void _removeOccluder( MovableObject *occluder );
+
+        /** Sets the resolution of the depth buffer the occluders are rasterized into,
+            for passes that have occlusion culling enabled.
+            @See CompositorPassSceneDef::mOcclusionCulling
+        @remarks
+            Higher resolutions reject objects more accurately (i.e. those barely peeking through
+            gaps between occluders), at a higher CPU cost. Default is 256x128.
+        */
+        void   setOcclusionBufferResolution( uint32 width, uint32 height );
+        uint32 getOcclusionBufferWidth() const { return mOcclusionBufferWidth; }
+        uint32 getOcclusionBufferHeight() const { return mOcclusionBufferHeight; }
+
+        /// Returns the occlusion buffer of the last pass that used it. Useful for debugging.
+        /// May be null.
+        const OcclusionBuffer *getOcclusionBuffer() const { return mOcclusionBuffer; }
+
+        /// Stats of the last pass that had occlusion culling enabled
+        const OcclusionCullingStats &getOcclusionCullingStats() const
+        {
+            return mOcclusionCullingStats;
+        }
+
+        /** When enabled (default), updateAllTransforms skips the nodes whose transform didn't
+            change since the last frame and whose parents didn't change either. It is tracked
+            for every pack of ARRAY_PACKED_REALS nodes: if a single node in the pack changed, all
+            of them are updated.
+        @remarks
+            Node's setters flag the changes. If you write directly to Node::_getTransform,
+            call Node::_notifyTransformDirty, or disable this feature.
+        */
+        void setTransformDirtyTracking( bool bEnable ) { mTransformDirtyTracking = bEnable; }
+        bool getTransformDirtyTracking() const { return mTransformDirtyTracking; }
+
+        /// Stats of the last updateAllTransforms. Useful to see how many nodes are actually
+        /// being updated each frame with setTransformDirtyTracking.
+        const TransformUpdateStats &getTransformUpdateStats() const { return mTransformUpdateStats; }
+
+        /** How the depth levels of the node hierarchy are spread across the worker threads
+            when updating transforms. See TransformUpdateScheduler.
+        @remarks
+            The default, SchedulingMergeNarrowLevels, updates consecutive depth levels too
+            small to be split on a single thread without going back to the scheduler between
+            them. This benefits deep hierarchies with few nodes per level. SchedulingPerLevel
+            always splits every level in its own task.
+        */
+        void setTransformUpdateScheduling( TransformUpdateScheduler::Scheduling scheduling )
+        {
+            mTransformUpdateScheduler.setScheduling( scheduling );
+        }
+        TransformUpdateScheduler::Scheduling getTransformUpdateScheduling() const
+        {
+            return mTransformUpdateScheduler.getScheduling();
+        }
+
         /// For internal use.
         /// @see CompositorPassSceneDef::mPrePassMode
         void        _setPrePassMode( PrePassMode mode, const TextureGpuVec &prepassTextures,
@@ -1359,6 +1591,39 @@ namespace Ogre
         /// @copydoc ArrayMemoryManager::defragment
         void defragmentMemoryPools();
 
+        /** Defragments the memory pools (like defragmentMemoryPools) but moving at
+            most maxSlotsToMove slots, so that it can be spread across several frames
+            (e.g. called every frame while the app is idle, until
+            getMemoryPoolsFragmentationRatio returns 0).
+            See ArrayMemoryManager::defragmentIncremental.
+        @param onlyPendingCleanups
+            When true, only the pools that reached their cleanup threshold while
+            setIncrementalDefragmentation was enabled are defragmented.
+        @return
+            The number of slots that were moved.
+        */
+        size_t defragmentMemoryPoolsIncremental( size_t maxSlotsToMove,
+                                                 bool   onlyPendingCleanups = false );
+
+        /** Returns how fragmented the memory pools are, in range [0; 1].
+            It's the number of slots that are unused because their objects got destroyed,
+            divided by the total number of slots including those unused.
+            0 means no fragmentation at all.
+        */
+        float getMemoryPoolsFragmentationRatio() const;
+
+        /** By default, once too many objects are destroyed in non-LIFO order, their memory
+            pool is defragmented immediately. When lots of objects get destroyed at once
+            (e.g. a section of the level is unloaded) this can take several milliseconds.
+        @remarks
+            When maxSlotsPerFrame is not 0, those cleanups are deferred and instead every
+            updateSceneGraph moves at most maxSlotsPerFrame slots until they're done.
+        @param maxSlotsPerFrame
+            Maximum number of slots to move per frame. 0 to disable (default).
+        */
+        void setIncrementalDefragmentation( size_t maxSlotsPerFrame );
+        size_t getIncrementalDefragmentation() const { return mIncrementalDefragSlotsPerFrame; }
+
         /// @copydoc ArrayMemoryManager::shrinkToFit
         void shrinkToFitMemoryPools();
 
@@ -1873,6 +2138,39 @@ namespace Ogre
         virtual void _cullPhase01( Camera *cullCamera, Camera *renderCamera, const Camera *lodCamera,
                                    uint8 firstRq, uint8 lastRq, bool reuseCullData );
 
+        /** Queues a camera to be culled by _fireBatchedCull together with the other queued cameras.
+            Culling many cameras in a single pass over the objects saves a round trip to the worker
+            threads per camera, and each object is brought into cache once for all of them.
+            Used by the Compositor to cull the shadow map cameras (and the camera of the pass that
+            owns the shadow node) before rendering them.
+        @remarks
+            _cullPhase01 will use the results instead of culling again if the camera is still
+            the same (position, orientation, frustum, visibility mask and render queue range).
+            Otherwise the results are ignored and _cullPhase01 culls normally.
+        @par
+            The results are kept until _clearBatchedCull is called; do not create, destroy, or move
+            objects in the meantime.
+        @param cullCamera
+            Camera to cull with. Its frustum must already be setup.
+        @param lodCamera
+            See _cullPhase01
+        @param viewportVisibilityMask
+            The visibility mask the viewport will have when _cullPhase01 gets called.
+            @See Viewport::getVisibilityMask
+        @param firstRq
+            See _cullPhase01
+        @param lastRq
+            See _cullPhase01
+        */
+        void _addBatchedCull( const Camera *cullCamera, const Camera *lodCamera,
+                              uint32 viewportVisibilityMask, uint8 firstRq, uint8 lastRq );
+
+        /// Culls all the cameras queued with _addBatchedCull at once. @See _addBatchedCull
+        void _fireBatchedCull();
+
+        /// Discards the cameras queued with _addBatchedCull and the results of _fireBatchedCull
+        void _clearBatchedCull();
+
         /** Prompts the class to send its contents to the renderer.
             @remarks
                 This method prompts the scene manager to send the
@@ -2492,6 +2790,15 @@ namespace Ogre
         */
         virtual bool getFindVisibleObjects() { return mFindVisibleObjects; }
 
+        /** Culls the objects in groups before culling them individually.
+            @See ObjectMemoryManager::setClusterCulling
+        @param sceneType
+            Whether to enable it for static or dynamic objects. Static objects
+            are the ones that benefit the most.
+        */
+        void setClusterCulling( SceneMemoryMgrTypes sceneType, bool bEnable );
+        bool getClusterCulling( SceneMemoryMgrTypes sceneType ) const;
+
         /** Set whether to automatically flip the culling mode on objects whenever they
             are negatively scaled.
         @remarks
@@ -2634,17 +2941,36 @@ namespace Ogre
         IlluminationRenderStage _getCurrentRenderStage() const { return mIlluminationStage; }
 
     protected:
+        /// Runs mRequestType on all the worker threads, and waits for them.
         void fireWorkerThreadsAndWait();
 
+        /// Runs mRequestType over mObjectChunks, and waits for it.
+        void fireChunkedRequestAndWait();
+
         /** Launches cullFrustum on all worker threads with the requested parameters
         @remarks
             Will block until all threads are done.
+            Each thread culls a fixed range of each render queue, so the order of the
+            results in mVisibleObjects is always the same.
         */
         void fireCullFrustumThreads( const CullFrustumRequest &request );
+
+        /** Like fireCullFrustumThreads, but the objects are split in many small chunks that
+            idle threads steal from busy ones. Which thread's list in mVisibleObjects gets each
+            object varies from run to run; use it only when that order doesn't matter.
+        */
+        void fireCullFrustumTasks( const CullFrustumRequest &request );
         void startWorkerThreads();
         void stopWorkerThreads();
 
     public:
+        /** Returns the scheduler that runs the worker threads of this SceneManager.
+        @remarks
+            Applications and components can submit their own Tasks to it, see TaskScheduler.
+            Do not wait on it from inside a Task.
+        */
+        TaskScheduler *getTaskScheduler() const { return mTaskScheduler; }
+
         /** Processes a user-defined UniformScalableTask in the worker threads
             spawned by SceneManager.
         @remarks
@@ -2666,13 +2992,8 @@ namespace Ogre
         */
         void waitForPendingUserScalableTask();
 
-        /** Called from the worker thread, polls to process frustum culling
-            requests when a sync is performed
-        */
-        unsigned long _updateWorkerThread( ThreadHandle *threadHandle );
-
     protected:
-        inline bool updateWorkerThreadImpl( size_t threadIdx );
+        inline void updateWorkerThreadImpl( size_t threadIdx );
     };
 
     /** Default implementation of IntersectionSceneQuery. */
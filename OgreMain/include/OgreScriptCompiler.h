@@ -985,6 +985,7 @@ namespace Ogre
                     ID_LOD_CAMERA,
                     ID_CULL_REUSE_DATA,
                     ID_CULL_CAMERA,
+                    ID_OCCLUSION_CULLING,
                     ID_MATERIAL_SCHEME,
                     ID_VISIBILITY_MASK,
                     ID_LIGHT_VISIBILITY_MASK,
@@ -322,6 +322,9 @@ namespace Ogre
         /// _isDataReadyImpl CAN return false if mDataReady == 0
         uint8 mDataPreparationsPending;
 
+        /// See TextureGpu::setMostDetailedMipToLoad
+        uint8 mMostDetailedMipToLoad;
+
         /// This setting can only be altered if mResidencyStatus == OnStorage).
         TextureTypes::TextureTypes mTextureType;
         PixelFormatGpu             mPixelFormat;
@@ -330,6 +333,8 @@ namespace Ogre
         uint32 mTextureFlags;
         /// Used if hasAutomaticBatching() == true
         uint32 mPoolId;
+        /// See TextureGpu::setLoadPriority
+        float mLoadPriority;
 
         /// If this pointer is nullptr and mResidencyStatus == GpuResidency::OnSystemRam
         /// then that means the data is being loaded to SystemRAM
@@ -433,6 +438,32 @@ namespace Ogre
         */
         void scheduleReupload( Image2 *image = 0, bool autoDeleteImage = true );
 
+        /** Sets how urgent it is to load this texture compared to others. Loads with
+            higher priority are processed first by the streaming threads. Loads with the same
+            priority are processed in the order they were scheduled. Default is 0.
+        @remarks
+            Can be called after the load was scheduled, in which case it affects the
+            requests that haven't started yet.
+            See TextureGpuManager::setAutomaticLoadPriorities
+        */
+        void  setLoadPriority( float priority );
+        float getLoadPriority() const { return mLoadPriority; }
+
+        /** Skips the most detailed mipmaps when loading from file, thus the texture will use
+            less memory (i.e. a value of 1 loads a 2048x2048 texture as 1024x1024).
+            Useful to reduce VRAM consumption under memory pressure.
+        @remarks
+            Only files that already contain mipmaps (e.g. DDS, KTX, OITD) can skip mips.
+            The least detailed mip is always loaded.
+        @par
+            If the texture is already Resident, it will be reloaded from file.
+            Textures with a value other than 0 don't use the metadata cache.
+        @param mipLevel
+            Most detailed mip to load. Default is 0 (full resolution).
+        */
+        void  setMostDetailedMipToLoad( uint8 mipLevel );
+        uint8 getMostDetailedMipToLoad() const { return mMostDetailedMipToLoad; }
+
         // See isMetadataReady for threadsafety on these functions.
         void   setResolution( uint32 width, uint32 height, uint32 depthOrSlices = 1u );
         uint32 getWidth() const;
@@ -528,6 +559,17 @@ namespace Ogre
         /// Notifies it is safe to use the real data. Everything has been uploaded.
         virtual void notifyDataIsReady() = 0;
 
+        /** For internal use. Called during progressive streaming (see
+            TextureGpuManager::setProgressiveStreaming) after mips [mipLevel; numMipmaps)
+            have been uploaded. The texture should be displayed, sampling only from those
+            mips. It is called with mipLevel = 0 right before notifyDataIsReady.
+        @remarks
+            RenderSystems that implement it must set
+            TextureGpuManager::mSupportsProgressiveStreaming.
+            Must not alter mDataPreparationsPending.
+        */
+        virtual void _notifyMostDetailedMipReady( uint8 mipLevel );
+
         /// Forces downloading data from GPU to CPU, usually because the data on GPU changed
         /// and we're in strategy AlwaysKeepSystemRamCopy. May stall.
         void _syncGpuResidentToSystemRam();
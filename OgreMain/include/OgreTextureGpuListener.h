@@ -99,6 +99,10 @@ namespace Ogre
             /// It does NOT mean that Ogre has finished issueing rendering commands to
             /// a RenderTexture and is now ready to be presented to the monitor.
             ReadyForRendering,
+            /// Only with progressive streaming (see TextureGpuManager::setProgressiveStreaming).
+            /// The least detailed mips have been uploaded and the texture can be displayed,
+            /// but it's not ready yet: ReadyForRendering will follow once all mips are there.
+            PartiallyReadyForRendering,
             Deleted
         };
 
@@ -146,6 +146,21 @@ namespace Ogre
         The worker thread (_updateStreamingWorkerThread) runs an infinite loop
         waiting for new requests.
 
+        There can be more than one worker thread (see setNumStreamingThreads). Each
+        has its own StreamingThread with its own requests, queued images, command
+        buffer & StagingTextures; and all requests for a given texture go to the same
+        one. Everything described below happens independently in each of them, except
+        that they share the available StagingTextures, the budget and the usage stats.
+
+        Incoming requests are processed by priority (see TextureGpu::setLoadPriority and
+        setAutomaticLoadPriorities), and in the order they were scheduled when priorities
+        are equal. Priority changes and cancellations are sent as special entries in the
+        same queue (see LoadRequestType) so they keep their order relative to the requests.
+
+        With progressive streaming (see setProgressiveStreaming) a QueuedImage uploads its
+        mip tail first and sends ObjCmdBuffer::NotifyMipsAreReady so the texture can be
+        displayed; the remaining mips are uploaded coarsest first, limited per frame.
+
         The worker thread will process incoming LoadRequest: it will open the file
         and retrieve the important information first aka the metadata (such as
         resolution, pixel format, number of mipmaps, etc). It is most likely
@@ -159,7 +174,7 @@ namespace Ogre
                can actually work (like copying from StagingTexture to the
                final texture object)
 
-        The worker thread will now push an entry to mStreamingData.queuedImages
+        The worker thread will now push an entry to StreamingThread::queuedImages
         for all the slices & mips that are pending to copy from RAM to a
         StagingTexture. That includes slice 0 mip 0.
 
@@ -171,8 +186,8 @@ namespace Ogre
         can hold the data we want to upload.
 
         If no such Texture is available, we cannot upload the texture yet and this
-        failure is recorded; and we do not remove the entry from mStreamingData.queuedImages
-        Until mStreamingData.queuedImages[i].empty() returns true, the worker thread,
+        failure is recorded; and we do not remove the entry from StreamingThread::queuedImages
+        Until StreamingThread::queuedImages[i].empty() returns true, the worker thread,
         with each new iteration, will try again to grab a StagingTexture to finish the jobs.
 
         From the main thread, with each TextureGpuManager::_update; fullfillBudget will
@@ -196,7 +211,7 @@ namespace Ogre
 
         When everything's done, queuedImage.empty() returns true, a
         ObjCmdBuffer::NotifyDataIsReady command to the main thread is issued,
-        and the entry is removed from mStreamingData.queuedImages
+        and the entry is removed from StreamingThread::queuedImages
 
         Of course, the main thread tries to predict how much StagingTexture will
         be needed by tracking past usage and by trying to fullfill mBudget
@@ -300,6 +315,18 @@ namespace Ogre
         typedef map<IdString, ResourceEntry>::type ResourceEntryMap;
 
     protected:
+        enum LoadRequestType
+        {
+            /// Load the texture (or a slice of it)
+            LoadRequestLoad,
+            /// Not an actual request. Changes the priority of all the previous
+            /// requests of the same texture that haven't started yet.
+            LoadRequestUpdatePriority,
+            /// Not an actual request. Cancels the previous requests of the same
+            /// texture, as long as none of them has started yet.
+            LoadRequestCancel
+        };
+
         struct LoadRequest
         {
             String                   name;
@@ -317,6 +344,23 @@ namespace Ogre
             bool autoDeleteImage;
             /// Indicates we're going to GpuResidency::OnSystemRam instead of Resident
             bool toSysRam;
+            /// Whether a LoadRequestCancel can cancel this request. Only plain loads
+            /// to Resident are (e.g. reuploads are not)
+            bool cancellable;
+            /// See LoadRequestType
+            uint8 requestType;
+            /// Requests with higher priority are processed first.
+            /// See TextureGpu::setLoadPriority
+            float priority;
+            /// Mips more detailed than this one are not loaded.
+            /// See TextureGpu::setMostDetailedMipToLoad
+            uint8 mostDetailedMip;
+            /// Whether the image may be uploaded progressively. See setProgressiveStreaming
+            bool progressive;
+            /// Order in which it was requested. The main thread executes the commands of all
+            /// streaming threads in this order (see ObjCmdBuffer::executeMerged) so that
+            /// listeners are notified in the same order as with just one thread.
+            uint64 sequence;
 
             LoadRequest( const String &_name, Archive *_archive,
                          ResourceLoadingListener *_loadingListener, Image2 *_image, TextureGpu *_texture,
@@ -329,9 +373,24 @@ namespace Ogre
                 sliceOrDepth( _sliceOrDepth ),
                 filters( _filters ),
                 autoDeleteImage( _autoDeleteImage ),
-                toSysRam( _toSysRam )
+                toSysRam( _toSysRam ),
+                cancellable( false ),
+                requestType( LoadRequestLoad ),
+                priority( 0.0f ),
+                mostDetailedMip( 0u ),
+                progressive( false ),
+                sequence( 0u )
             {
             }
+
+            /// Sorts by priority, highest first
+            struct PriorityCmp
+            {
+                bool operator()( const LoadRequest &_l, const LoadRequest &_r ) const
+                {
+                    return _l.priority > _r.priority;
+                }
+            };
         };
 
         typedef vector<LoadRequest>::type LoadRequestVec;
@@ -360,7 +419,7 @@ namespace Ogre
                 1. Find if the texture has any pending transition or finishing loading
                     1a. If so place a task in mScheduledTasks
                     1b. Otherwise execute the task immediately
-                2. The texture is placed from main thread in mThreadData[].loadRequests
+                2. The texture is placed from main thread in StreamingThread::threadData[].loadRequests
                 3. Worker thread parses that request. Assuming all goes smoothly (e.g. Image loaded
                    successfully, metadata cache was not out of date, etc) the Image is fully
                    loaded from disk into memory as an Image2.
@@ -402,9 +461,18 @@ namespace Ogre
             /// See LoadRequest::sliceOrDepth
             uint32          dstSliceOrDepth;
             FilterBaseArray filters;
+            /// When progressive streaming, mips [mipTail; numMips) are uploaded right away
+            /// and the rest are uploaded from coarsest to finest as the budget allows.
+            /// 0 when not progressive. See setProgressiveStreaming
+            uint8 mipTail;
+            /// When progressive streaming, the most detailed mip (and all the coarser ones)
+            /// we told the main thread it's ready. See ObjCmdBuffer::NotifyMipsAreReady
+            uint8 mostDetailedMipReady;
+            /// See LoadRequest::sequence
+            uint64 sequence;
 
             QueuedImage( Image2 &srcImage, TextureGpu *_dstTexture, uint32 _dstSliceOrDepth,
-                         FilterBaseArray &inOutFilters );
+                         FilterBaseArray &inOutFilters, uint64 _sequence );
             void  destroy();
             bool  empty() const;
             bool  isMipSliceQueued( uint8 mipLevel, uint8 slice ) const;
@@ -440,18 +508,17 @@ namespace Ogre
             ObjCmdBuffer     *objCmdBuffer;
             StagingTextureVec usedStagingTex;
         };
+        /// State shared by all the streaming threads. Protected by mMutex unless noted otherwise.
         struct StreamingData
         {
-            StagingTextureVec availableStagingTex;  /// Used by both threads. Needs mutex protection.
-            QueuedImageVec    queuedImages;         /// Used by mostly by worker thread. Needs mutex.
-            UsageStatsVec     usageStats;  /// Exclusively used by worker thread. No protection needed.
-            UsageStatsVec     prevStats;   /// Used by both threads.
-            /// Set to true when worker thread iterates (meaning prevStats.loopCount
+            StagingTextureVec availableStagingTex;  /// Used by all threads. Needs mutex protection.
+            UsageStatsVec     prevStats;            /// Used by all threads.
+            /// Set to true when a worker thread iterates (meaning prevStats.loopCount
             /// can be decremented).
             /// Set to false by main thread every _update call.
             /// Needs mutex.
             bool workerThreadRan;
-            /// Number of bytes preloaded by worker thread. Main thread resets this counter.
+            /// Number of bytes preloaded by all worker threads. Main thread resets this counter.
             size_t bytesPreloaded;
             /// See setWorkerThreadMinimumBudget
             /// Read by worker thread. Occasionally written by main thread. Not protected.
@@ -459,22 +526,58 @@ namespace Ogre
             /// See setWorkerThreadMaxPerStagingTextureRequestBytes
             /// Read by worker thread. Occasionally written by main thread. Not protected.
             size_t maxPerStagingTextureRequestBytes;
+            /// Number of bytes uploaded by all worker threads for mips outside the mip tail
+            /// of progressive textures. Main thread resets this counter. Needs mutex.
+            size_t progressiveBytesUploaded;
+            /// See setProgressiveStreaming
+            /// Read by worker thread. Occasionally written by main thread. Not protected.
+            size_t maxProgressiveBytesPerFrame;
+            /// See setProgressiveStreaming
+            /// Read by worker thread. Occasionally written by main thread. Not protected.
+            uint32 progressiveMipTailResolution;
+        };
+
+        /** State of each streaming thread. All requests for the same texture are always
+            sent to the same StreamingThread (see TextureGpuManager::addLoadRequest), so
+            they're processed in the order they were scheduled; and the per-texture
+            tracking below (rescheduled textures, partial images) never needs to be shared.
+        */
+        struct StreamingThread
+        {
+            /// threadData[c_mainThread] is used by main thread (its loadRequests are
+            /// protected by mLoadRequestsMutex). threadData[c_workerThread] is protected
+            /// by mutex.
+            ThreadData     threadData[2];
+            QueuedImageVec queuedImages;  /// Protected by mutex.
+            UsageStatsVec  usageStats;    /// Exclusively used by its worker thread.
 
             /// Resheduled textures are textures which were transitioned to Resident
             /// preemptively using the metadata cache, but it turned out to be wrong
             /// (out of date), so we need to do some ping pong first
             ///
-            /// Used by worker thread. No protection needed.
+            /// Used by its worker thread. No protection needed.
             set<TextureGpu *>::type rescheduledTextures;
 
             /// Only used for textures that need more than one Image to load
             ///
-            /// Used by worker thread. No protection needed (except in abortAllRequests).
+            /// Used by its worker thread. No protection needed (except in abortAllRequests).
             ///
             /// @see    TextureGpuManager::PartialImage
             PartialImageMap partialImages;
+
+            /// Held by the worker thread while it iterates. Must be acquired before mMutex.
+            LightweightMutex mutex;
+            /// Main thread wakes, worker waits.
+            WaitableEvent wakeUpEvent;
+            /// Counts how many times mutex.tryLock returned false in a row
+            uint32 tryLockFailureCount;
+
+            StreamingThread();
+            ~StreamingThread();
         };
 
+        typedef vector<StreamingThread *>::type StreamingThreadVec;
+
         enum TasksType
         {
             TaskTypeResidencyTransition,
@@ -515,21 +618,43 @@ namespace Ogre
         DefaultMipmapGen::DefaultMipmapGen mDefaultMipmapGen;
         DefaultMipmapGen::DefaultMipmapGen mDefaultMipmapGenCubemaps;
         bool                               mShuttingDown;
-        ThreadHandlePtr                    mWorkerThread;
-        /// Main thread wakes, worker waits.
-        WaitableEvent mWorkerWaitableEvent;
-        /// Worker wakes, main thread waits. Used by waitForStreamingCompletion();
+        ThreadHandleVec                    mWorkerThreads;
+        /// Workers wake, main thread waits. Used by waitForStreamingCompletion();
         WaitableEvent    mRequestToMainThreadEvent;
         LightweightMutex mLoadRequestsMutex;
         LightweightMutex mMutex;
-        // Counts how many times mMutex.tryLock returned false in a row
-        uint32        mTryLockMutexFailureCount;
-        uint32        mTryLockMutexFailureLimit;
-        uint64        mLoadRequestsCounter;
-        bool          mLastUpdateIsStreamingDone;
-        bool          mAddedNewLoadRequests;
-        ThreadData    mThreadData[2];
-        StreamingData mStreamingData;
+        /// Serializes opening & reading files from Archives (and the ResourceLoadingListener
+        /// calls) when there's more than one streaming thread. Decoding happens outside.
+        LightweightMutex mStreamingIoMutex;
+        uint32             mTryLockMutexFailureLimit;
+        uint64             mLoadRequestsCounter;
+        bool               mLastUpdateIsStreamingDone;
+        bool               mAddedNewLoadRequests;
+        StreamingThreadVec mStreamingThreads;
+        StreamingData      mStreamingData;
+
+        struct ScreenCoverage
+        {
+            /// Value last sent to the streaming threads
+            float sent;
+            /// Largest value collected since the last flushScreenCoverage
+            float current;
+        };
+        typedef map<TextureGpu *, ScreenCoverage>::type ScreenCoverageMap;
+
+        /// See setAutomaticLoadPriorities. Only contains textures that are loading.
+        ScreenCoverageMap mScreenCoverage;
+        bool              mAutomaticLoadPriorities;
+        bool              mScreenCoverageDirty;
+
+        /// See setProgressiveStreaming
+        bool mProgressiveStreaming;
+        /// Set by RenderSystems that implement TextureGpu::_notifyMostDetailedMipReady
+        bool mSupportsProgressiveStreaming;
+
+        /// See getStreamingStallTimeUs
+        Timer *mStallTimer;
+        uint64 mStreamingStallTimeUs;
 
         TexturePoolList  mTexturePool;
         ResourceEntryMap mEntries;
@@ -655,15 +780,16 @@ namespace Ogre
         /// Assumes we're protected by mMutex! Called from main thread.
         void fullfillBudget();
 
-        /// Must be called from worker thread.
-        void mergeUsageStatsIntoPrevStats();
+        /// Must be called from worker thread. Assumes we're protected by mMutex!
+        void mergeUsageStatsIntoPrevStats( StreamingThread &streamingThread );
 
         /** Finds a StagingTexture that can map the given region defined by the box & pixelFormat.
             Searches in both used & available textures.
             If no staging texture supports this request, it will fill a RareRequest entry.
         @remarks
-            Assumes workerData is protected by a mutex.
-        @param workerData
+            Assumes streamingThread is protected by its mutex. Grabs mMutex to search
+            in the available textures shared by all worker threads.
+        @param streamingThread
             Worker thread data.
         @param box
         @param pixelFormat
@@ -672,15 +798,23 @@ namespace Ogre
         @return
             The mapped region. If TextureBox::data is null, it couldn't be mapped.
         */
-        static TextureBox getStreaming( ThreadData &workerData, StreamingData &streamingData,
-                                        const TextureBox &box, PixelFormatGpu pixelFormat,
-                                        StagingTexture **outStagingTexture );
-        static void       processQueuedImage( QueuedImage &queuedImage, ThreadData &workerData,
-                                              StreamingData &streamingData );
+        TextureBox getStreaming( StreamingThread &streamingThread, const TextureBox &box,
+                                 PixelFormatGpu pixelFormat, StagingTexture **outStagingTexture );
+        void       processQueuedImage( QueuedImage &queuedImage, StreamingThread &streamingThread );
+
+        /// Must be called from worker thread. Grabs mMutex. See setProgressiveStreaming
+        bool isProgressiveBudgetExceeded();
+        /// Must be called from worker thread. Grabs mMutex. See setProgressiveStreaming
+        void addProgressiveBytesUploaded( size_t bytes );
 
         static void addTransitionToLoadedCmd( ObjCmdBuffer *commandBuffer, TextureGpu *texture,
                                               void *sysRamCopy, bool toSysRam );
 
+        /// Copies mips [mostDetailedMip; numMipmaps) of srcImage into dstImage, which will
+        /// have a lower resolution. See TextureGpu::setMostDetailedMipToLoad
+        static void copyLeastDetailedMips( const Image2 &srcImage, Image2 &dstImage,
+                                           uint8 mostDetailedMip );
+
         /// Retrieves, in bytes, the memory consumed by StagingTextures in a container like
         /// mAvailableStagingTextures, which are textures waiting either to be reused, or to be
         /// destroyed.
@@ -741,11 +875,48 @@ namespace Ogre
         /// but in the case of Cubemaps being made up from multiple separate images,
         /// it may be called once per face.
         /// Must be called from worker thread.
-        /// workerData is needed to pass it on to processQueuedImage
-        void processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
+        /// streamingThread is needed to pass it on to processQueuedImage
+        void processLoadRequest( ObjCmdBuffer *commandBuffer, StreamingThread &streamingThread,
                                  const LoadRequest &loadRequest );
 
+        /// Opens the file of the load request through its Archive or ResourceLoadingListener.
+        /// If readIntoMemory, the whole file is read into memory before returning.
+        /// Must be called from worker thread.
+        DataStreamPtr openLoadRequest( ObjCmdBuffer *commandBuffer, const LoadRequest &loadRequest,
+                                       bool readIntoMemory );
+
+        /// Sends the request to the streaming thread in charge of its texture.
+        /// Must be called from main thread.
+        void addLoadRequest( const LoadRequest &loadRequest );
+
+        /// Sends a LoadRequestUpdatePriority or LoadRequestCancel to the streaming
+        /// thread in charge of the texture. Must be called from main thread.
+        void addLoadRequestUpdate( TextureGpu *texture, LoadRequestType requestType );
+
+        /// Returns the priority the streaming threads should use for the texture's requests.
+        /// Must be called from main thread.
+        float getEffectiveLoadPriority( TextureGpu *texture ) const;
+
+        /// Applies the LoadRequestUpdatePriority & LoadRequestCancel entries found
+        /// in the worker's loadRequests (removing them) and sorts the remaining
+        /// requests by priority. Must be called from worker thread.
+        void applyLoadRequestUpdates( StreamingThread &streamingThread );
+
+        /// Sends the screen coverage collected since the last call to the worker threads.
+        /// Must be called from main thread.
+        void flushScreenCoverage();
+
+        void createWorkerThreads();
+        void destroyWorkerThreads();
+
+        /// Processes one iteration of the given streaming thread.
+        void _updateStreaming( size_t threadIdx );
+
+        /// Returns true if bytesPreloaded exceeded the budget. Grabs mMutex.
+        bool isPreloadBudgetExceeded();
+
     public:
+        /// Processes one iteration of all streaming threads from the calling thread.
         void _updateStreaming();
 
         /** Returns true if there is no more streaming work to be done yet
@@ -790,6 +961,15 @@ namespace Ogre
         /// Blocks main thread until all pending textures are fully loaded.
         void waitForStreamingCompletion();
 
+        /** Returns the accumulated time the main thread spent blocked in
+            waitForStreamingCompletion and waiting for a texture (e.g. TextureGpu::waitForData)
+            since this TextureGpuManager was created.
+            Root uses the difference between frames for FrameStage::TextureStreamingStall
+        @return
+            Time in microseconds
+        */
+        uint64 getStreamingStallTimeUs() const { return mStreamingStallTimeUs; }
+
         /** Calling waitForStreamingCompletion before Root::renderOneFrame should
             guarantee the render is perfect.
 
@@ -1185,6 +1365,83 @@ namespace Ogre
         */
         void setTrylockMutexFailureLimit( uint32 tryLockFailureLimit );
 
+        /** When enabled, textures that are still loading get their priority raised based
+            on how much of the screen is covered by the visible objects using them (collected
+            by SceneManager while culling). Bigger objects get their textures first.
+        @remarks
+            The screen coverage is in range [0; 1] and is added to TextureGpu::getLoadPriority,
+            thus priorities set by the app that are 1 apart still take precedence.
+        @par
+            This costs estimating the coverage of every visible object in each (non-shadow)
+            pass. The cull threads do it as they cull, but it is still disabled by default.
+        */
+        void setAutomaticLoadPriorities( bool bEnable );
+        bool getAutomaticLoadPriorities() const { return mAutomaticLoadPriorities; }
+
+        /// Called by HlmsDatablock to raise the priority of a texture that is still loading.
+        /// See setAutomaticLoadPriorities. Must be called from main thread.
+        void _addScreenCoverage( TextureGpu *texture, float coverage );
+
+        /// Called by TextureGpu::setLoadPriority. Reprioritizes the pending requests
+        /// of the texture that haven't started yet.
+        void _notifyLoadPriorityChanged( TextureGpu *texture );
+
+        /// Called from main thread when the streaming thread honoured a LoadRequestCancel.
+        /// See _scheduleTransitionTo.
+        void _notifyLoadCancelled( TextureGpu *texture );
+
+        /** Sets how many background threads load textures. Each one opens, decodes and
+            processes (e.g. generates mipmaps) its own images, and copies them into its
+            own StagingTextures; so loading lots of textures can use several cores.
+        @remarks
+            All requests for the same texture are handled by the same thread, thus each
+            texture still sees its listener calls in the same order as before. What the
+            threads send back is applied in the order the textures were scheduled, so
+            textures that finish by the same _update still notify their listeners in
+            that order (a texture that takes longer to load still finishes later).
+        @par
+            Reading from Archives is serialized when there's more than one thread (but
+            decoding is not), since Archives and ResourceLoadingListeners aren't guaranteed
+            to be thread safe.
+        @par
+            setWorkerThreadMaxPreloadBytes and setWorkerThreadMinimumBudget are shared by
+            all threads (i.e. they're not multiplied by the number of threads).
+        @par
+            This function waits for all pending streaming to finish before changing
+            the number of threads. Must be called from main thread.
+            It has no effect when streaming is forced to run on the main thread.
+        @param numThreads
+            Number of threads. Must be > 0. Default is 1.
+        */
+        void   setNumStreamingThreads( size_t numThreads );
+        size_t getNumStreamingThreads() const { return mStreamingThreads.size(); }
+
+        /** When enabled, textures loaded from files that already contain all of their mipmaps
+            (e.g. DDS, KTX, OITD) are uploaded starting from the coarsest mips (the "mip tail")
+            and can be displayed as soon as the tail is uploaded, sampling only from the mips
+            that are ready. The more detailed mips are uploaded over the following frames.
+        @remarks
+            While this is happening TextureGpu::isDataReady still returns false; listeners get
+            TextureGpuListener::PartiallyReadyForRendering when the texture can be displayed,
+            and ReadyForRendering when all of its mips are uploaded.
+        @par
+            Requires support from the RenderSystem (see supportsProgressiveStreaming).
+            Textures with automatic batching, or loaded from multiple images (i.e. cubemaps
+            from 6 files) are always fully uploaded before being displayed.
+        @param bEnable
+            Default is false.
+        @param maxBytesPerFrame
+            How many bytes of the mips outside the tail can be uploaded per frame, shared
+            by all streaming threads. The tail is always uploaded right away.
+            It's a soft limit: the last mip is always finished.
+        @param mipTailResolution
+            Mips whose width and height are both <= mipTailResolution belong to the tail.
+        */
+        void setProgressiveStreaming( bool bEnable, size_t maxBytesPerFrame = 4u * 1024u * 1024u,
+                                      uint32 mipTailResolution = 128u );
+        bool getProgressiveStreaming() const { return mProgressiveStreaming; }
+        bool supportsProgressiveStreaming() const { return mSupportsProgressiveStreaming; }
+
         /// This function CAN be called from any thread
         const String *findAliasNameStr( IdString idName ) const;
         /// This function CAN be called from any thread
@@ -0,0 +1,192 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreTransformUpdateScheduler_H_
+#define _OgreTransformUpdateScheduler_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Array/OgreTransform.h"
+#include "OgreFastArray.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Scene
+     *  @{
+     */
+
+    struct UpdateTransformRequest
+    {
+        Transform t;
+        /// Number of nodes to process in each chunk. Must be multiple of ARRAY_PACKED_REALS
+        size_t numNodesPerChunk;
+        size_t numTotalNodes;
+
+        UpdateTransformRequest() : numNodesPerChunk( 0 ), numTotalNodes( 0 ) {}
+
+        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerChunk, size_t _numTotalNodes ) :
+            t( _t ),
+            numNodesPerChunk( _numNodesPerChunk ),
+            numTotalNodes( _numTotalNodes )
+        {
+        }
+
+        size_t getNumChunks() const
+        {
+            return ( numTotalNodes + numNodesPerChunk - 1u ) / numNodesPerChunk;
+        }
+    };
+
+    /** Updates the transforms of one depth level of a NodeMemoryManager, split in chunks.
+        Children read their parent's derived transform, therefore the task that updates the
+        next depth level must depend on this one.
+    */
+    class _OgreExport UpdateTransformTask : public Task
+    {
+    public:
+        /// Returns the number of nodes that were actually updated
+        typedef size_t ( *UpdateFunction )( const size_t numNodes, Transform t );
+
+        UpdateTransformRequest request;
+        /// Node::updateAllTransforms, TagPoint::updateAllTransformsBoneToTag, etc.
+        UpdateFunction updateFunction;
+        /// The result of updateFunction is added to numUpdatedPerThread[threadIdx]. Can be null.
+        size_t *numUpdatedPerThread;
+
+        UpdateTransformTask() : updateFunction( 0 ), numUpdatedPerThread( 0 ) {}
+        UpdateTransformTask( const UpdateTransformRequest &_request, UpdateFunction _updateFunction,
+                             size_t *_numUpdatedPerThread = 0 ) :
+            request( _request ),
+            updateFunction( _updateFunction ),
+            numUpdatedPerThread( _numUpdatedPerThread )
+        {
+        }
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override;
+    };
+
+    /** Updates several consecutive depth levels, one after the other, as a single chunk.
+        Each level must fit in a single chunk of its UpdateTransformTask.
+    */
+    class _OgreExport UpdateTransformLevelsTask : public Task
+    {
+    public:
+        UpdateTransformTask *levels;
+        size_t               numLevels;
+
+        UpdateTransformLevelsTask() : levels( 0 ), numLevels( 0 ) {}
+        UpdateTransformLevelsTask( UpdateTransformTask *_levels, size_t _numLevels ) :
+            levels( _levels ),
+            numLevels( _numLevels )
+        {
+        }
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override;
+    };
+
+    /** Updates the transforms of a node hierarchy, depth level by depth level, using the
+        TaskScheduler.
+    @remarks
+        Nodes are stored per depth level in SoA packs, and a pack can hold nodes from
+        unrelated subtrees, so a level can only start once its parent level is done.
+        Splitting each level across the worker threads pays off for wide levels, but deep
+        hierarchies with a handful of nodes per level (skeleton attachments, vehicle rigs)
+        would spend more time going through the scheduler than updating nodes.
+    @par
+        With SchedulingMergeNarrowLevels, consecutive levels that fit in a single chunk are
+        updated back to back by one thread, as one task. A deep and narrow hierarchy ends up
+        being a single task while wide levels are still split across threads. Independent
+        work (e.g. tasks submitted by the user) can keep the other threads busy meanwhile.
+    */
+    class _OgreExport TransformUpdateScheduler
+    {
+    public:
+        enum Scheduling
+        {
+            /// Every depth level is a task that depends on the previous level
+            SchedulingPerLevel,
+            /// Consecutive depth levels too small to be split are merged into one task
+            SchedulingMergeNarrowLevels
+        };
+
+    protected:
+        /// One per depth level. Must not move in memory while the tasks run
+        vector<UpdateTransformTask>::type       mLevels;
+        vector<UpdateTransformLevelsTask>::type mMergedLevels;
+        FastArray<size_t>                       mNumUpdatedPerThread;
+
+        Scheduling mScheduling;
+        size_t     mNumTasks;
+
+        TaskScheduler::TaskId submitMergedLevels( TaskScheduler *taskScheduler, size_t firstLevel,
+                                                  size_t lastLevel, TaskScheduler::TaskId dependency );
+
+    public:
+        TransformUpdateScheduler();
+
+        void       setScheduling( Scheduling scheduling ) { mScheduling = scheduling; }
+        Scheduling getScheduling() const { return mScheduling; }
+
+        /** Adds the next depth level to update. Levels are updated in the order they are
+            added, each one after the previous one is done.
+        @param t
+            First node of the level, see NodeMemoryManager::getFirstNode.
+        @param numNodes
+            Number of nodes in the level. Empty levels are ignored.
+        @param numNodesPerChunk
+            How many nodes each thread grabs at a time. Must be multiple of ARRAY_PACKED_REALS.
+            Levels with no more than this many nodes are the ones that can be merged.
+        */
+        void addLevel( const Transform &t, size_t numNodes, size_t numNodesPerChunk,
+                       UpdateTransformTask::UpdateFunction updateFunction );
+
+        /** Submits all the levels added so far and waits for them to finish. Clears the
+            levels afterwards.
+        @return
+            The sum of what the UpdateFunctions returned, i.e. the number of updated nodes.
+        */
+        size_t execute( TaskScheduler *taskScheduler );
+
+        /// Number of tasks the last execute submitted. Every one of them had to wait for
+        /// the previous one.
+        size_t getNumTasks() const { return mNumTasks; }
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
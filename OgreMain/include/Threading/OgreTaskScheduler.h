@@ -0,0 +1,195 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef _OgreTaskScheduler_H_
+#define _OgreTaskScheduler_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWaitableEvent.h"
+
+#include "ogrestd/deque.h"
+#include "ogrestd/vector.h"
+
+namespace Ogre
+{
+    class UniformScalableTask;
+
+    /** A Task is work that can be split in many small chunks which can run in any order
+        and on any thread. See TaskScheduler.
+    */
+    class _OgreExport Task
+    {
+    public:
+        virtual ~Task();
+
+        /** Overload this function to perform whatever you want. It will be called once
+            per chunk, from any of the worker threads; possibly at the same time.
+        @param chunkIdx
+            The chunk to process. In range [0; numChunks) as given to TaskScheduler::submit.
+        @param threadIdx
+            The index of the thread it is being called from. In range
+            [0; TaskScheduler::getNumThreads()). Use it to index per-thread outputs.
+        */
+        virtual void execute( size_t chunkIdx, size_t threadIdx ) = 0;
+    };
+
+    /** Runs Tasks on a fixed pool of worker threads.
+    @remarks
+        Each task is split in chunks that are spread across the worker threads. A worker
+        that runs out of chunks steals from the others, so that uneven chunks don't leave
+        threads idling while one of them finishes its share.
+    @par
+        Instead of a barrier between two dependent tasks, the second one can be submitted
+        right away declaring the first one as a dependency. It will start as soon as all
+        its dependencies have finished, and it won't block unrelated tasks.
+    @par
+        submit can be called from any thread, including from inside a Task. wait and
+        waitForAll must only be called from the thread that created the scheduler.
+        That thread does not execute chunks: waiting puts it to sleep.
+    @par
+        When created with 0 worker threads, tasks are executed by the caller inside submit.
+    */
+    class _OgreExport TaskScheduler : public OgreAllocatedObj
+    {
+    public:
+        /// Identifies a submitted task. It stays valid (and finished) after the task is done.
+        typedef uint64 TaskId;
+        /// Refers to a task that has already finished.
+        static const TaskId FinishedTask;
+
+    protected:
+        struct WorkItem
+        {
+            Task                *task;
+            UniformScalableTask *uniformTask;
+            uint32               taskIdx;
+            uint32               chunkIdx;
+            uint32               numChunks;
+        };
+
+        struct TaskRecord
+        {
+            Task                *task;
+            UniformScalableTask *uniformTask;
+            /// Incremented when the task finishes, so that old TaskIds can tell
+            uint32 generation;
+            uint32 numChunks;
+            uint32 remainingChunks;
+            uint32 pendingDependencies;
+            /// Indices to mTasks of the tasks waiting for this one
+            FastArray<uint32> dependents;
+
+            TaskRecord();
+        };
+
+        struct Worker
+        {
+            LightweightMutex      mutex;
+            deque<WorkItem>::type workItems;
+            WaitableEvent         wakeUpEvent;
+        };
+
+        size_t          mNumWorkerThreads;
+        Worker         *mWorkers;
+        ThreadHandleVec mThreads;
+        volatile bool   mExitThreads;
+
+        /// Protects mTasks, mFreeTasks & mNumActiveTasks
+        LightweightMutex         mTasksMutex;
+        vector<TaskRecord>::type mTasks;
+        FastArray<uint32>        mFreeTasks;
+        size_t                   mNumActiveTasks;
+        /// Woken up every time a task finishes
+        WaitableEvent mTaskFinishedEvent;
+
+        TaskId submitImpl( Task *task, UniformScalableTask *uniformTask, size_t numChunks,
+                           const TaskId *dependencies, size_t numDependencies );
+
+        /// mTasksMutex must be held
+        WorkItem getReadyTask( uint32 taskIdx ) const;
+        /// mTasksMutex must be held. Releases the task and adds the tasks that were only
+        /// waiting for it to outReadyTasks.
+        void finishTask( uint32 taskIdx, FastArray<WorkItem> &outReadyTasks );
+        /// Spreads the chunks of each task across the workers' queues and wakes them up.
+        void startTasks( FastArray<WorkItem> &readyTasks );
+
+        /// Pops a work item from the thread's own queue, otherwise steals one from another.
+        bool grabWorkItem( size_t threadIdx, WorkItem &outWorkItem );
+        void executeWorkItem( const WorkItem &workItem, size_t threadIdx );
+
+        /// mTasksMutex must be held
+        bool isFinished( TaskId taskId ) const;
+
+    public:
+        TaskScheduler( size_t numWorkerThreads );
+        ~TaskScheduler();
+
+        /// Number of different threadIdx the tasks will see. At least 1.
+        size_t getNumThreads() const { return std::max<size_t>( mNumWorkerThreads, 1u ); }
+
+        /** Schedules a task.
+        @param task
+            Task to run. Pointer must be valid at least until the task is finished.
+        @param numChunks
+            Number of times Task::execute will be called. Smaller chunks balance better across
+            threads; but each chunk has a small overhead. 0 is valid (finishes right away).
+        @param dependencies
+            Tasks that must finish before this one starts. Can be null if numDependencies = 0.
+        @return
+            Id to wait on, or to use as a dependency of other tasks.
+        */
+        TaskId submit( Task *task, size_t numChunks, const TaskId *dependencies = 0,
+                       size_t numDependencies = 0 );
+
+        /** Schedules a UniformScalableTask. It is split in exactly getNumThreads() chunks
+            and each chunk calls UniformScalableTask::execute( chunkIdx, getNumThreads() ).
+        @remarks
+            Two chunks may end up being run by the same thread. The threadId argument is
+            only guaranteed to be unique & in range.
+        */
+        TaskId submit( UniformScalableTask *task, const TaskId *dependencies = 0,
+                       size_t numDependencies = 0 );
+
+        /// Blocks until the task is finished.
+        void wait( TaskId taskId );
+
+        /// Returns true if the task has finished. Never blocks; can be called from any thread.
+        bool isTaskFinished( TaskId taskId );
+
+        /// Blocks until all the submitted tasks are finished.
+        void waitForAll();
+
+        /// Worker thread entry point. Do not call directly.
+        unsigned long _workerThread( ThreadHandle *threadHandle );
+    };
+}  // namespace Ogre
+
+#endif
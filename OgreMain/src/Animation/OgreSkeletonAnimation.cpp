@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "Animation/OgreSkeletonAnimation.h"
 
 #include "Animation/OgreSkeletonAnimationDef.h"
+#include "Animation/OgreSkeletonDef.h"
 #include "Animation/OgreSkeletonInstance.h"
 
 #if defined( __GNUC__ ) && !defined( __clang__ )
@@ -332,6 +333,41 @@ namespace Ogre
     {
         inOutBoneWeights.swap( mBoneWeights );
     }
+    //-----------------------------------------------------------------------------------
+    uint32 SkeletonAnimation::_addBoneWeightsToPoseKey( uint32 hash, const Real *manualBones,
+                                                        FastArray<Real> &inOutWeights ) const
+    {
+        const SkeletonDef *skeletonDef = mDefinition->mSkeletonDef;
+        const Real *boneWeightsScalar = reinterpret_cast<const Real *>( mBoneWeights.get() );
+
+        SkeletonTrackVec::const_iterator itor = mDefinition->mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mDefinition->mTracks.end();
+
+        while( itor != endt )
+        {
+            const size_t level = itor->getBoneBlockIdx() >> 24;
+            const size_t blockIdx = skeletonDef->getNumberOfBoneBlocks( level ) +
+                                    ( itor->getBoneBlockIdx() & 0x00FFFFFF );
+            const Real *manualBonesInBlock = manualBones + blockIdx * ARRAY_PACKED_REALS;
+
+            // Same slots _initialize gave our bones
+            const size_t slotStart =
+                itor->getUsedSlots() <= ( ARRAY_PACKED_REALS >> 1 ) ? ( *mSlotStarts )[level] : 0u;
+
+            for( size_t i = slotStart; i < slotStart + itor->getUsedSlots(); ++i )
+            {
+                const Real weight =
+                    manualBonesInBlock[i] == 0.0f ? Real( 1.0f ) : boneWeightsScalar[i];
+                inOutWeights.push_back( weight );
+                hash = HashCombine( hash, weight );
+            }
+
+            boneWeightsScalar += ARRAY_PACKED_REALS;
+            ++itor;
+        }
+
+        return hash;
+    }
 }  // namespace Ogre
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #    pragma GCC diagnostic pop
@@ -64,7 +64,7 @@ namespace Ogre
     }
     //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::build( const v1::Skeleton *skeleton, const v1::Animation *animation,
-                                      Real frameRate )
+                                      Real frameRate, const SkeletonTrackCompression *compression )
     {
         mOriginalFrameRate = frameRate;
         mNumFrames = animation->getLength() * frameRate;
@@ -219,6 +219,9 @@ namespace Ogre
 
             ++itTrack;
         }
+
+        if( compression )
+            compressTracks( *compression );
     }
     //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::getInterpolatedUnnormalizedKeyFrame( v1::OldNodeAnimationTrack *oldTrack,
@@ -384,6 +387,58 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonAnimationDef::compressTracks( const SkeletonTrackCompression &settings )
+    {
+        assert( !isCompressed() );
+
+        size_t numQuantizedValues = 0;
+        SkeletonTrackVec::iterator itor = mTracks.begin();
+        SkeletonTrackVec::iterator endt = mTracks.end();
+        while( itor != endt )
+        {
+            numQuantizedValues += itor->_prepareCompression( settings );
+            ++itor;
+        }
+
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> dequantization( mTracks.size() * 2u );
+        RawSimdUniquePtr<uint16, MEMCATEGORY_ANIMATION> quantizedKeyFrames( numQuantizedValues );
+        mDequantization.swap( dequantization );
+        mQuantizedKeyFrames.swap( quantizedKeyFrames );
+
+        KfTransform *RESTRICT_ALIAS dequantizationPtr = mDequantization.get();
+        uint16 *RESTRICT_ALIAS quantizedPtr = mQuantizedKeyFrames.get();
+
+        itor = mTracks.begin();
+        while( itor != endt )
+        {
+            const size_t numValues = itor->getKeyFrames().size() * itor->_getQuantizedStride();
+            itor->_compress( dequantizationPtr, numValues ? quantizedPtr : 0 );
+            dequantizationPtr += 2u;
+            quantizedPtr += numValues;
+            ++itor;
+        }
+
+        if( mKfTransformMemoryManager )
+        {
+            mKfTransformMemoryManager->destroy();
+            delete mKfTransformMemoryManager;
+            mKfTransformMemoryManager = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonAnimationDef::getKeyFrameDataSize() const
+    {
+        size_t retVal = 0;
+        SkeletonTrackVec::const_iterator itor = mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mTracks.end();
+        while( itor != endt )
+        {
+            retVal += itor->getKeyFrameDataSize();
+            ++itor;
+        }
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::_dumpCsvTracks( String &outText ) const
     {
         const SkeletonDef::BoneDataVec &mBones = mSkeletonDef->getBones();
@@ -421,7 +476,10 @@ namespace Ogre
                         outText += StringConverter::toString( itKeyFrames->mFrame );
                         outText += ",";
 
-                        const KfTransform *RESTRICT_ALIAS boneTransform = itKeyFrames->mBoneTransform;
+                        KfTransform kfTransform;
+                        track.getKeyFrameTransform(
+                            static_cast<size_t>( itKeyFrames - keyFrames.begin() ), kfTransform );
+                        const KfTransform *RESTRICT_ALIAS boneTransform = &kfTransform;
 
                         Vector3 vPos, vScale;
                         Quaternion qRot;
@@ -40,7 +40,8 @@ THE SOFTWARE.
 
 namespace Ogre
 {
-    SkeletonDef::SkeletonDef( const v1::Skeleton *originalSkeleton, Real frameRate ) :
+    SkeletonDef::SkeletonDef( const v1::Skeleton *originalSkeleton, Real frameRate,
+                              const SkeletonTrackCompression *trackCompression ) :
         mNumUnusedSlots( 0 ),
         mName( originalSkeleton->getName() )
     {
@@ -126,7 +127,7 @@ namespace Ogre
             mAnimationDefs[i]._setSkeletonDef( this );
             mAnimationDefs[i].setName( originalSkeleton->getAnimation( (uint16)i )->getName() );
             mAnimationDefs[i].build( originalSkeleton, originalSkeleton->getAnimation( (uint16)i ),
-                                     frameRate );
+                                     frameRate, trackCompression );
         }
 
         // Create the bones (just like we would for SkeletonInstance)so we can
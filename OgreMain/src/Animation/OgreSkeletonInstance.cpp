@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "Animation/OgreSkeletonDef.h"
 #include "Animation/OgreSkeletonManager.h"
 #include "OgreId.h"
+#include "OgreMovableObject.h"
 #include "OgreOldBone.h"
 #include "OgreSceneNode.h"
 #include "OgreSkeleton.h"
@@ -49,7 +50,13 @@ namespace Ogre
                                         BoneMemoryManager *boneMemoryManager ) :
         mDefinition( skeletonDef ),
         mParentNode( 0 ),
-        mRefCount( 1 )
+        mRefCount( 1 ),
+        mNumManualBones( 0u ),
+        mUpdateLodSource( 0 ),
+        mFramesSinceEvaluation( 0u ),
+        mNumPosesInHistory( 0u ),
+        mNewestPoseIdx( 0u ),
+        mPoseShareFrameQuantum( 0 )
     {
         mBones.resize( mDefinition->getBones().size(), Bone() );
 
@@ -238,10 +245,84 @@ namespace Ogre
         mBones.clear();
     }
     //-----------------------------------------------------------------------------------
-    void SkeletonInstance::update()
+    void SkeletonInstance::update() { updateImpl( 0 ); }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::_update( SharedPoseMap &sharedPoses ) { updateImpl( &sharedPoses ); }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::updateImpl( SharedPoseMap *sharedPoses )
+    {
+        if( mActiveAnimations.empty() )
+        {
+            mNumPosesInHistory = 0u;
+            return;
+        }
+
+        const uint8 updateInterval = getUpdateInterval();
+        if( updateInterval <= 1u )
+        {
+            mNumPosesInHistory = 0u;
+            evaluate( sharedPoses, true );
+            return;
+        }
+
+        ++mFramesSinceEvaluation;
+        if( mFramesSinceEvaluation < updateInterval && mNumPosesInHistory != 0u )
+        {
+            // With only one pose there is nothing to interpolate. Our bones
+            // still hold it since nobody else writes to them.
+            if( mNumPosesInHistory == 2u )
+                applyPoseHistory( Real( mFramesSinceEvaluation ) / Real( updateInterval ) );
+            return;
+        }
+
+        if( mNumPosesInHistory == 0u )
+        {
+            // Stagger the evaluations so that all the instances entering the
+            // same LOD don't evaluate their animations in the same frame
+            mFramesSinceEvaluation = static_cast<uint8>( mBones.front().getId() % updateInterval );
+        }
+        else
+        {
+            mFramesSinceEvaluation = 0u;
+        }
+
+        // Once we have two poses our bones show the older pose, not the one we evaluate now
+        evaluate( sharedPoses, mNumPosesInHistory == 0u );
+        pushPoseHistory();
+        if( mNumPosesInHistory == 2u )
+            applyPoseHistory( 0.0f );
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::evaluate( SharedPoseMap *sharedPoses, bool canProvidePose )
     {
-        if( !mActiveAnimations.empty() )
-            resetToPose();
+        if( sharedPoses && mPoseShareFrameQuantum > 0 )
+        {
+            const uint32 hash = buildSharedPoseKey();
+
+            SharedPoseMap::const_iterator itor = sharedPoses->find( hash );
+            if( itor != sharedPoses->end() )
+            {
+                const SkeletonInstance *source = itor->second;
+                if( source->mPoseShareFrameQuantum == mPoseShareFrameQuantum &&
+                    source->mSharedPoseKey.size() == mSharedPoseKey.size() &&
+                    std::equal( mSharedPoseKey.begin(), mSharedPoseKey.end(),
+                                source->mSharedPoseKey.begin() ) &&
+                    source->mSharedPoseBoneWeights.size() == mSharedPoseBoneWeights.size() &&
+                    std::equal( mSharedPoseBoneWeights.begin(), mSharedPoseBoneWeights.end(),
+                                source->mSharedPoseBoneWeights.begin() ) )
+                {
+                    copyPoseFrom( *source );
+                    return;
+                }
+                // Else hash collision. Just evaluate ourselves
+            }
+            else if( canProvidePose && !mNumManualBones )
+            {
+                ( *sharedPoses )[hash] = this;
+            }
+        }
+
+        resetToPose();
 
         ActiveAnimationsVec::iterator itor = mActiveAnimations.begin();
         ActiveAnimationsVec::iterator endt = mActiveAnimations.end();
@@ -253,6 +334,223 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    uint32 SkeletonInstance::buildSharedPoseKey()
+    {
+        mSharedPoseKey.clear();
+        mSharedPoseBoneWeights.clear();
+
+        uint32 hash = HashCombine( 0u, mPoseShareFrameQuantum );
+        const Real *manualBones = reinterpret_cast<const Real *>( mManualBones.get() );
+
+        ActiveAnimationsVec::const_iterator itor = mActiveAnimations.begin();
+        ActiveAnimationsVec::const_iterator endt = mActiveAnimations.end();
+
+        while( itor != endt )
+        {
+            const SkeletonAnimation *animation = *itor;
+
+            SharedPoseKeyEntry entry;
+            entry.animationDef = animation->getDefinition();
+            entry.quantizedFrame = static_cast<int32>(
+                Math::Floor( animation->getCurrentFrame() / mPoseShareFrameQuantum ) );
+            entry.weight = animation->mWeight;
+            mSharedPoseKey.push_back( entry );
+
+            hash = HashCombine( hash, entry.animationDef );
+            hash = HashCombine( hash, entry.quantizedFrame );
+            hash = HashCombine( hash, entry.weight );
+            hash = animation->_addBoneWeightsToPoseKey( hash, manualBones, mSharedPoseBoneWeights );
+
+            ++itor;
+        }
+
+        return hash;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::copyPoseFrom( const SkeletonInstance &source )
+    {
+        assert( source.mDefinition == mDefinition );
+
+        ArrayReal const *RESTRICT_ALIAS manualBones = mManualBones.get();
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::const_iterator itSrc = source.mBoneStartTransforms.begin();
+        TransformArray::iterator itor = mBoneStartTransforms.begin();
+        TransformArray::iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            BoneTransform srcT = *itSrc;
+            const size_t numBonesInLevel = itDepthLevelInfo->numBonesInLevel;
+
+            if( t.mIndex == srcT.mIndex )
+            {
+                // Same slots in the SIMD block. The mask leaves our manual bones
+                // and the bones from other instances sharing the block untouched.
+                for( size_t i = 0; i < numBonesInLevel; i += ARRAY_PACKED_REALS )
+                {
+                    *t.mPosition = Math::lerp( *t.mPosition, *srcT.mPosition, *manualBones );
+                    *t.mOrientation = Math::lerp( *t.mOrientation, *srcT.mOrientation, *manualBones );
+                    *t.mScale = Math::lerp( *t.mScale, *srcT.mScale, *manualBones );
+                    t.advancePack();
+                    srcT.advancePack();
+                    ++manualBones;
+                }
+            }
+            else
+            {
+                // Only happens in levels with few bones, where several
+                // instances share the same SIMD block. Copy one by one.
+                const Real *manualBonesScalar = reinterpret_cast<const Real *>( manualBones );
+
+                Vector3 tmpVec;
+                Quaternion tmpQuat;
+                for( size_t i = 0; i < numBonesInLevel; ++i )
+                {
+                    const size_t dstSlot = t.mIndex + i;
+                    const size_t srcSlot = srcT.mIndex + i;
+                    if( manualBonesScalar[dstSlot] != 0.0f )
+                    {
+                        const size_t dstBlock = dstSlot / ARRAY_PACKED_REALS;
+                        const size_t srcBlock = srcSlot / ARRAY_PACKED_REALS;
+                        const size_t dstIdx = dstSlot % ARRAY_PACKED_REALS;
+                        const size_t srcIdx = srcSlot % ARRAY_PACKED_REALS;
+
+                        srcT.mPosition[srcBlock].getAsVector3( tmpVec, srcIdx );
+                        t.mPosition[dstBlock].setFromVector3( tmpVec, dstIdx );
+                        srcT.mOrientation[srcBlock].getAsQuaternion( tmpQuat, srcIdx );
+                        t.mOrientation[dstBlock].setFromQuaternion( tmpQuat, dstIdx );
+                        srcT.mScale[srcBlock].getAsVector3( tmpVec, srcIdx );
+                        t.mScale[dstBlock].setFromVector3( tmpVec, dstIdx );
+                    }
+                }
+
+                manualBones += ( numBonesInLevel + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+            }
+
+            ++itSrc;
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::pushPoseHistory()
+    {
+        const size_t numBlocks = mManualBones.size();
+        mNewestPoseIdx ^= 1u;
+        KfTransform *RESTRICT_ALIAS pose = mPoseHistory.get() + numBlocks * mNewestPoseIdx;
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::const_iterator itor = mBoneStartTransforms.begin();
+        TransformArray::const_iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                pose->mPosition = *t.mPosition;
+                pose->mOrientation = *t.mOrientation;
+                pose->mScale = *t.mScale;
+                t.advancePack();
+                ++pose;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+
+        mNumPosesInHistory = std::min<uint8>( mNumPosesInHistory + 1u, 2u );
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::applyPoseHistory( Real alpha )
+    {
+        assert( mNumPosesInHistory == 2u );
+
+        const size_t numBlocks = mManualBones.size();
+        KfTransform const *RESTRICT_ALIAS newest = mPoseHistory.get() + numBlocks * mNewestPoseIdx;
+        KfTransform const *RESTRICT_ALIAS oldest =
+            mPoseHistory.get() + numBlocks * ( mNewestPoseIdx ^ 1u );
+        ArrayReal const *RESTRICT_ALIAS manualBones = mManualBones.get();
+
+        const ArrayReal arrayAlpha = Mathlib::SetAll( alpha );
+
+        SkeletonDef::DepthLevelInfoVec::const_iterator itDepthLevelInfo =
+            mDefinition->getDepthLevelInfo().begin();
+
+        TransformArray::iterator itor = mBoneStartTransforms.begin();
+        TransformArray::iterator endt = mBoneStartTransforms.end();
+
+        while( itor != endt )
+        {
+            BoneTransform t = *itor;
+            for( size_t i = 0; i < itDepthLevelInfo->numBonesInLevel; i += ARRAY_PACKED_REALS )
+            {
+                const ArrayVector3 vPos =
+                    Math::lerp( oldest->mPosition, newest->mPosition, arrayAlpha );
+                const ArrayQuaternion qRot =
+                    ArrayQuaternion::nlerpShortest( arrayAlpha, oldest->mOrientation,
+                                                    newest->mOrientation );
+                const ArrayVector3 vScale = Math::lerp( oldest->mScale, newest->mScale, arrayAlpha );
+
+                *t.mPosition = Math::lerp( *t.mPosition, vPos, *manualBones );
+                *t.mOrientation = Math::lerp( *t.mOrientation, qRot, *manualBones );
+                *t.mScale = Math::lerp( *t.mScale, vScale, *manualBones );
+                t.advancePack();
+
+                ++oldest;
+                ++newest;
+                ++manualBones;
+            }
+
+            ++itor;
+            ++itDepthLevelInfo;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    uint8 SkeletonInstance::getUpdateInterval() const
+    {
+        if( !mUpdateLodSource || mUpdateLodIntervals.empty() )
+            return 1u;
+
+        const size_t lod = std::min<size_t>( mUpdateLodSource->getCurrentMeshLod(),
+                                             mUpdateLodIntervals.size() - 1u );
+        return mUpdateLodIntervals[lod];
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setUpdateLod( const MovableObject *lodSource,
+                                         const FastArray<uint8> &updateIntervals )
+    {
+        mUpdateLodSource = lodSource;
+        mUpdateLodIntervals = updateIntervals;
+        mFramesSinceEvaluation = 0u;
+        mNumPosesInHistory = 0u;
+
+        if( lodSource && !mPoseHistory.get() )
+        {
+            mPoseHistory =
+                RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION>( mManualBones.size() * 2u );
+        }
+        else if( !lodSource )
+        {
+            RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> emptyPtr;
+            mPoseHistory.swap( emptyPtr );
+            mUpdateLodIntervals.clear();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::setPoseSharing( Real frameQuantum )
+    {
+        mPoseShareFrameQuantum = std::max<Real>( frameQuantum, 0 );
+        if( mPoseShareFrameQuantum == 0 )
+            mSharedPoseKey.clear();
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonInstance::resetToPose()
     {
         KfTransform const *RESTRICT_ALIAS bindPose = mDefinition->getBindPose();
@@ -309,6 +607,13 @@ namespace Ogre
                 "Offset incorrectly calculated. manualBones[diff] will overflow!" );
 
         Real *manualBones = reinterpret_cast<Real *>( mManualBones.get() );
+        if( isManual != ( manualBones[diff] == 0.0f ) )
+        {
+            if( isManual )
+                ++mNumManualBones;
+            else
+                --mNumManualBones;
+        }
         manualBones[diff] = isManual ? 0.0f : 1.0f;
     }
     //-----------------------------------------------------------------------------------
@@ -552,6 +857,9 @@ namespace Ogre
             ++itor;
         }
 
+        // The poses were stored using the old slots
+        mNumPosesInHistory = 0u;
+
         SkeletonAnimationVec::iterator itAnim = mAnimations.begin();
         SkeletonAnimationVec::iterator enAnim = mAnimations.end();
 
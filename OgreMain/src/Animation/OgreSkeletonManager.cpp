@@ -45,10 +45,16 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
-    SkeletonManager::SkeletonManager() {}
+    SkeletonManager::SkeletonManager() : mTrackCompressionEnabled( false ) {}
     //-----------------------------------------------------------------------
     SkeletonManager::~SkeletonManager() {}
     //-----------------------------------------------------------------------
+    void SkeletonManager::setTrackCompression( bool bEnable, const SkeletonTrackCompression &settings )
+    {
+        mTrackCompressionEnabled = bEnable;
+        mTrackCompression = settings;
+    }
+    //-----------------------------------------------------------------------
     SkeletonDefPtr SkeletonManager::getSkeletonDef( v1::Skeleton *oldSkeletonBase )
     {
         IdString idName( oldSkeletonBase->getName() );
@@ -57,7 +63,8 @@ namespace Ogre
         if( itor == mSkeletonDefs.end() )
         {
             oldSkeletonBase->load();
-            retVal = SkeletonDefPtr( new SkeletonDef( oldSkeletonBase, 1.0f ) );
+            retVal = SkeletonDefPtr( new SkeletonDef(
+                oldSkeletonBase, 1.0f, mTrackCompressionEnabled ? &mTrackCompression : 0 ) );
             mSkeletonDefs[idName] = retVal;
         }
         else
@@ -90,7 +97,8 @@ namespace Ogre
             oldSkeleton->load();
             if( oldSkeleton->isLoaded() )
             {
-                retVal = SkeletonDefPtr( new SkeletonDef( oldSkeleton.get(), 1.0f ) );
+                retVal = SkeletonDefPtr( new SkeletonDef(
+                    oldSkeleton.get(), 1.0f, mTrackCompressionEnabled ? &mTrackCompression : 0 ) );
                 if( wasUnloaded )
                     oldSkeleton->unload();
                 if( wasNonExistent )
@@ -37,13 +37,84 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    namespace
+    {
+        /// KfTransform seen as 10 components: position xyz, orientation wxyz, scale xyz
+        static const size_t c_numKfComponents = 10u;
+
+        inline ArrayReal &getKfComponent( KfTransform &transform, size_t component )
+        {
+            if( component < 3u )
+                return transform.mPosition.mChunkBase[component];
+            else if( component < 7u )
+                return transform.mOrientation.mChunkBase[component - 3u];
+            return transform.mScale.mChunkBase[component - 7u];
+        }
+
+        inline Real getKfComponent( const KfTransform &transform, size_t component, size_t slot )
+        {
+            return reinterpret_cast<const Real *>(
+                &getKfComponent( const_cast<KfTransform &>( transform ), component ) )[slot];
+        }
+
+        inline void setKfComponent( KfTransform &transform, size_t component, size_t slot, Real value )
+        {
+            reinterpret_cast<Real *>( &getKfComponent( transform, component ) )[slot] = value;
+        }
+
+        inline uint8 getKfComponentChannel( size_t component )
+        {
+            if( component < 3u )
+                return SkeletonTrack::AnimatedPosition;
+            else if( component < 7u )
+                return SkeletonTrack::AnimatedOrientation;
+            return SkeletonTrack::AnimatedScale;
+        }
+
+        /// Rotation angle (in radians) between two unit quaternions. Unlike acos( dot ),
+        /// it is precise for small angles.
+        inline Real getAngleBetween( const Quaternion &a, const Quaternion &b )
+        {
+            const Quaternion diff = a.Dot( b ) < 0.0f ? a + b : a - b;
+            const Real halfChord = std::min( Math::Sqrt( diff.Norm() ) * 0.5f, Real( 1.0f ) );
+            return 4.0f * Math::ASin( halfChord ).valueRadians();
+        }
+
+        /// Errors between two bone transforms, in the units of SkeletonTrackCompression
+        struct SlotTransform
+        {
+            Vector3    vPos;
+            Quaternion qRot;
+            Vector3    vScale;
+
+            bool equals( const SlotTransform &other, const SkeletonTrackCompression &settings,
+                         uint8 channels ) const
+            {
+                bool retVal = true;
+                if( channels & SkeletonTrack::AnimatedPosition )
+                    retVal &= vPos.distance( other.vPos ) <= settings.positionTolerance;
+                if( channels & SkeletonTrack::AnimatedOrientation )
+                {
+                    retVal &= getAngleBetween( qRot, other.qRot ) <= settings.orientationTolerance;
+                }
+                if( channels & SkeletonTrack::AnimatedScale )
+                    retVal &= vScale.distance( other.vScale ) <= settings.scaleTolerance;
+                return retVal;
+            }
+        };
+    }  // namespace
+
     SkeletonTrack::SkeletonTrack( uint32 boneBlockIdx,
                                   KfTransformArrayMemoryManager *kfTransformMemoryManager ) :
         mKeyFrameRigs( 0 ),
         mNumFrames( 0 ),
         mBoneBlockIdx( boneBlockIdx ),
         mUsedSlots( 0 ),
-        mLocalMemoryManager( kfTransformMemoryManager )
+        mLocalMemoryManager( kfTransformMemoryManager ),
+        mDequantization( 0 ),
+        mQuantizedKeyFrames( 0 ),
+        mQuantizedStride( 0 ),
+        mAnimatedChannels( AnimatedPosition | AnimatedOrientation | AnimatedScale )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -83,6 +154,8 @@ namespace Ogre
                          "SkeletonTrack::setKeyFrameTransform" );
         }
 
+        assert( !isCompressed() && "Can't modify a compressed track" );
+
         itor->mBoneTransform->mPosition.setFromVector3( vPos, slot );
         itor->mBoneTransform->mOrientation.setFromQuaternion( qRot, slot );
         itor->mBoneTransform->mScale.setFromVector3( vScale, slot );
@@ -112,6 +185,47 @@ namespace Ogre
         outNextFrame = nextFrame;
     }
     //-----------------------------------------------------------------------------------
+    inline void SkeletonTrack::decompressKeyFrame( size_t keyFrameIdx,
+                                                   KfTransform &outTransform ) const
+    {
+        const uint16 *RESTRICT_ALIAS src = mQuantizedKeyFrames + keyFrameIdx * mQuantizedStride;
+        const KfTransform &bias = mDequantization[0];
+        const KfTransform &scale = mDequantization[1];
+
+        outTransform = bias;
+
+        if( mAnimatedChannels & AnimatedPosition )
+        {
+            for( size_t i = 0; i < 3u; ++i )
+            {
+                outTransform.mPosition.mChunkBase[i] =
+                    bias.mPosition.mChunkBase[i] +
+                    Mathlib::LoadUnsignedShorts( src ) * scale.mPosition.mChunkBase[i];
+                src += ARRAY_PACKED_REALS;
+            }
+        }
+        if( mAnimatedChannels & AnimatedOrientation )
+        {
+            for( size_t i = 0; i < 4u; ++i )
+            {
+                outTransform.mOrientation.mChunkBase[i] =
+                    bias.mOrientation.mChunkBase[i] +
+                    Mathlib::LoadUnsignedShorts( src ) * scale.mOrientation.mChunkBase[i];
+                src += ARRAY_PACKED_REALS;
+            }
+        }
+        if( mAnimatedChannels & AnimatedScale )
+        {
+            for( size_t i = 0; i < 3u; ++i )
+            {
+                outTransform.mScale.mChunkBase[i] =
+                    bias.mScale.mChunkBase[i] +
+                    Mathlib::LoadUnsignedShorts( src ) * scale.mScale.mChunkBase[i];
+                src += ARRAY_PACKED_REALS;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonTrack::applyKeyFrameRigAt( KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig,
                                             float frame, ArrayReal animWeight,
                                             const ArrayReal *RESTRICT_ALIAS perBoneWeights,
@@ -131,8 +245,19 @@ namespace Ogre
         ArrayVector3 *RESTRICT_ALIAS finalScale = boneTransforms[level].mScale + offset;
         ArrayQuaternion *RESTRICT_ALIAS finalRot = boneTransforms[level].mOrientation + offset;
 
-        KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
-        KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+        KfTransform const *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
+        KfTransform const *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+
+        KfTransform decompressed[2];
+        if( mDequantization )
+        {
+            decompressKeyFrame( static_cast<size_t>( prevFrame - mKeyFrameRigs.begin() ),
+                                decompressed[0] );
+            decompressKeyFrame( static_cast<size_t>( nextFrame - mKeyFrameRigs.begin() ),
+                                decompressed[1] );
+            prevTransf = &decompressed[0];
+            nextTransf = &decompressed[1];
+        }
 
         ArrayVector3 interpPos, interpScale;
         ArrayQuaternion interpRot;
@@ -159,6 +284,7 @@ namespace Ogre
     void SkeletonTrack::_bakeUnusedSlots()
     {
         assert( mUsedSlots <= ARRAY_PACKED_REALS );
+        assert( !isCompressed() && "Can't modify a compressed track" );
 
         if( mUsedSlots <= ( ARRAY_PACKED_REALS >> 1 ) )
         {
@@ -185,4 +311,191 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::getKeyFrameTransform( size_t keyFrameIdx, KfTransform &outTransform ) const
+    {
+        assert( keyFrameIdx < mKeyFrameRigs.size() );
+        if( mDequantization )
+            decompressKeyFrame( keyFrameIdx, outTransform );
+        else
+            outTransform = *mKeyFrameRigs[keyFrameIdx].mBoneTransform;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::getKeyFrameDataSize() const
+    {
+        if( mDequantization )
+        {
+            return 2u * sizeof( KfTransform ) +
+                   mKeyFrameRigs.size() * mQuantizedStride * sizeof( uint16 );
+        }
+        return mKeyFrameRigs.size() * sizeof( KfTransform );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t SkeletonTrack::_prepareCompression( const SkeletonTrackCompression &settings )
+    {
+        assert( !isCompressed() );
+
+        const size_t numKeyFrames = mKeyFrameRigs.size();
+
+        vector<SlotTransform>::type values( numKeyFrames * ARRAY_PACKED_REALS );
+        for( size_t i = 0; i < numKeyFrames; ++i )
+        {
+            const KfTransform *RESTRICT_ALIAS kfTransform = mKeyFrameRigs[i].mBoneTransform;
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                SlotTransform &value = values[i * ARRAY_PACKED_REALS + j];
+                kfTransform->mPosition.getAsVector3( value.vPos, j );
+                kfTransform->mOrientation.getAsQuaternion( value.qRot, j );
+                kfTransform->mScale.getAsVector3( value.vScale, j );
+                // Keyframes may not be normalized, but the interpolated result always is
+                value.qRot.normalise();
+            }
+        }
+
+        // Find the channels that don't change
+        mAnimatedChannels = 0;
+        const uint8 allChannels = AnimatedPosition | AnimatedOrientation | AnimatedScale;
+        for( size_t i = 1u; i < numKeyFrames && mAnimatedChannels != allChannels; ++i )
+        {
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                const SlotTransform &first = values[j];
+                const SlotTransform &value = values[i * ARRAY_PACKED_REALS + j];
+                for( uint8 channel = AnimatedPosition; channel <= AnimatedScale; channel <<= 1u )
+                {
+                    if( !first.equals( value, settings, channel ) )
+                        mAnimatedChannels |= channel;
+                }
+            }
+        }
+
+        // Remove the keyframes that can be interpolated from the last one we kept & a later one.
+        // Both the original and the reduced tracks are linear between keyframes, thus their
+        // difference is largest at the original keyframes; checking them is enough.
+        KeyFrameRigVec keptKeyFrames;
+        keptKeyFrames.reserve( numKeyFrames );
+        keptKeyFrames.push_back( mKeyFrameRigs.front() );
+
+        size_t lastKept = 0;
+        for( size_t i = 2u; i < numKeyFrames; ++i )
+        {
+            const Real startFrame = mKeyFrameRigs[lastKept].mFrame;
+            const Real invDistance = 1.0f / ( mKeyFrameRigs[i].mFrame - startFrame );
+
+            bool canInterpolate = true;
+            for( size_t k = lastKept + 1u; k < i && canInterpolate; ++k )
+            {
+                const Real fTime = ( mKeyFrameRigs[k].mFrame - startFrame ) * invDistance;
+                for( size_t j = 0; j < ARRAY_PACKED_REALS && canInterpolate; ++j )
+                {
+                    const SlotTransform &a = values[lastKept * ARRAY_PACKED_REALS + j];
+                    const SlotTransform &b = values[i * ARRAY_PACKED_REALS + j];
+                    SlotTransform interp;
+                    interp.vPos = Math::lerp( a.vPos, b.vPos, fTime );
+                    interp.qRot = Quaternion::nlerp( fTime, a.qRot, b.qRot, true );
+                    interp.vScale = Math::lerp( a.vScale, b.vScale, fTime );
+                    canInterpolate = interp.equals( values[k * ARRAY_PACKED_REALS + j], settings,
+                                                    allChannels );
+                }
+            }
+
+            if( !canInterpolate )
+            {
+                lastKept = i - 1u;
+                keptKeyFrames.push_back( mKeyFrameRigs[lastKept] );
+            }
+        }
+
+        if( numKeyFrames > 1u )
+            keptKeyFrames.push_back( mKeyFrameRigs.back() );
+
+        for( size_t i = 0; i + 1u < keptKeyFrames.size(); ++i )
+        {
+            keptKeyFrames[i].mInvNextFrameDistance =
+                1.0f / ( keptKeyFrames[i + 1u].mFrame - keptKeyFrames[i].mFrame );
+        }
+        keptKeyFrames.back().mInvNextFrameDistance = 1.0f;
+
+        mKeyFrameRigs.swap( keptKeyFrames );
+
+        mQuantizedStride = 0;
+        for( size_t c = 0; c < c_numKfComponents; ++c )
+        {
+            if( mAnimatedChannels & getKfComponentChannel( c ) )
+                mQuantizedStride += ARRAY_PACKED_REALS;
+        }
+
+        return mKeyFrameRigs.size() * mQuantizedStride;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::_compress( KfTransform *dequantization, uint16 *quantizedKeyFrames )
+    {
+        assert( !isCompressed() );
+
+        KfTransform &bias = dequantization[0];
+        KfTransform &scale = dequantization[1];
+
+        // Constant channels are taken from the first keyframe
+        bias = *mKeyFrameRigs.front().mBoneTransform;
+        for( size_t c = 0; c < c_numKfComponents; ++c )
+            getKfComponent( scale, c ) = Mathlib::SetAll( 0.0f );
+
+        const size_t numKeyFrames = mKeyFrameRigs.size();
+
+        for( size_t c = 0; c < c_numKfComponents; ++c )
+        {
+            if( !( mAnimatedChannels & getKfComponentChannel( c ) ) )
+                continue;
+
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                Real minValue = std::numeric_limits<Real>::max();
+                Real maxValue = -std::numeric_limits<Real>::max();
+                for( size_t i = 0; i < numKeyFrames; ++i )
+                {
+                    const Real value = getKfComponent( *mKeyFrameRigs[i].mBoneTransform, c, j );
+                    minValue = std::min( minValue, value );
+                    maxValue = std::max( maxValue, value );
+                }
+
+                setKfComponent( bias, c, j, minValue );
+                setKfComponent( scale, c, j, ( maxValue - minValue ) / 65535.0f );
+            }
+        }
+
+        uint16 *RESTRICT_ALIAS dst = quantizedKeyFrames;
+        for( size_t i = 0; i < numKeyFrames; ++i )
+        {
+            const KfTransform &kfTransform = *mKeyFrameRigs[i].mBoneTransform;
+            for( size_t c = 0; c < c_numKfComponents; ++c )
+            {
+                if( !( mAnimatedChannels & getKfComponentChannel( c ) ) )
+                    continue;
+
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    const Real minValue = getKfComponent( bias, c, j );
+                    const Real step = getKfComponent( scale, c, j );
+                    Real quantized = 0.0f;
+                    if( step > 0.0f )
+                    {
+                        quantized = ( getKfComponent( kfTransform, c, j ) - minValue ) / step;
+                        quantized = Math::Clamp( quantized + 0.5f, 0.0f, 65535.0f );
+                    }
+                    *dst++ = static_cast<uint16>( quantized );
+                }
+            }
+        }
+
+        KeyFrameRigVec::iterator itor = mKeyFrameRigs.begin();
+        KeyFrameRigVec::iterator endt = mKeyFrameRigs.end();
+        while( itor != endt )
+        {
+            itor->mBoneTransform = 0;
+            ++itor;
+        }
+
+        mDequantization = dequantization;
+        mQuantizedKeyFrames = quantizedKeyFrames;
+    }
 }  // namespace Ogre
@@ -113,7 +113,7 @@ namespace Ogre
         // I'm lazy, but before you implement it, remember that the skeleton needs to be updated as well.
     }
     //-----------------------------------------------------------------------
-    void TagPoint::updateAllTransformsBoneToTag( const size_t numNodes, Transform t )
+    size_t TagPoint::updateAllTransformsBoneToTag( const size_t numNodes, Transform t )
     {
         SimpleMatrixAf4x3 const *RESTRICT_ALIAS parentBoneParentNodeTransform[ARRAY_PACKED_REALS];
         SimpleMatrixAf4x3 const *RESTRICT_ALIAS parentBoneTransform[ARRAY_PACKED_REALS];
@@ -175,9 +175,11 @@ namespace Ogre
 
             t.advancePack();
         }
+
+        return numNodes;
     }
     //-----------------------------------------------------------------------
-    void TagPoint::updateAllTransformsTagOnTag( const size_t numNodes, Transform t )
+    size_t TagPoint::updateAllTransformsTagOnTag( const size_t numNodes, Transform t )
     {
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
         {
@@ -222,6 +224,8 @@ namespace Ogre
 
             t.advancePack();
         }
+
+        return numNodes;
     }
     //-----------------------------------------------------------------------
     TagPoint *TagPoint::createChildTagPoint( const Vector3 &vPos, const Quaternion &qRot )
@@ -112,6 +112,12 @@ namespace Ogre
         mCommandBuffer.clear();
     }
     //-----------------------------------------------------------------------------------
+    void CommandBuffer::appendAndClear( CommandBuffer *other )
+    {
+        mCommandBuffer.appendPOD( other->mCommandBuffer.begin(), other->mCommandBuffer.end() );
+        other->mCommandBuffer.clear();
+    }
+    //-----------------------------------------------------------------------------------
     CbBase *CommandBuffer::getLastCommand()
     {
         return reinterpret_cast<CbBase *>( mCommandBuffer.end() - COMMAND_FIXED_SIZE );
@@ -135,4 +141,10 @@ namespace Ogre
 
         return retVal;
     }
+    //-----------------------------------------------------------------------------------
+    void CommandBuffer::rollbackTo( size_t offset )
+    {
+        assert( offset <= mCommandBuffer.size() && !( offset % COMMAND_FIXED_SIZE ) );
+        mCommandBuffer.resizePOD( offset );
+    }
 }  // namespace Ogre
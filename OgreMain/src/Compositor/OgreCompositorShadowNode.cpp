@@ -642,6 +642,29 @@ namespace Ogre
         SceneManager::IlluminationRenderStage previous = sceneManager->_getCurrentRenderStage();
         sceneManager->_setCurrentRenderStage( SceneManager::IRS_RENDER_TO_TEXTURE );
 
+        {
+            // All shadow cameras are setup. Cull them in one go (together with whatever
+            // the pass that owns us queued) rather than once per pass.
+            const CompositorShadowNode *shadowNode = sceneManager->getCurrentShadowNode();
+            const uint8 executionMask = mWorkspace->getExecutionMask();
+
+            CompositorPassVec::const_iterator itPass = mPasses.begin();
+            CompositorPassVec::const_iterator enPass = mPasses.end();
+
+            while( itPass != enPass )
+            {
+                if( ( *itPass )->getType() == PASS_SCENE &&
+                    shouldExecutePass( *itPass, shadowNode, executionMask ) )
+                {
+                    assert( dynamic_cast<CompositorPassScene *>( *itPass ) );
+                    static_cast<CompositorPassScene *>( *itPass )->_addBatchedCull( lodCamera );
+                }
+                ++itPass;
+            }
+
+            sceneManager->_fireBatchedCull();
+        }
+
         // Now render all passes
         CompositorNode::_update( lodCamera, sceneManager );
 
@@ -256,6 +256,9 @@ namespace Ogre
             // (ie VR) shadows are not 'over culled'
             mCullCamera->_notifyViewport( viewport );
 
+            // Our camera gets culled together with the shadow cameras
+            _addBatchedCull( lodCamera );
+
             shadowNode->_update( mCullCamera, usedLodCamera, sceneManager );
 
             // ShadowNode passes may've overriden these settings.
@@ -279,6 +282,7 @@ namespace Ogre
         setRenderPassDescToCurrent();
 
         sceneManager->_setForwardPlusEnabledInPass( mDefinition->mEnableForwardPlus );
+        sceneManager->_setOcclusionCullingInPass( mDefinition->mOcclusionCulling );
         sceneManager->_setPrePassMode( mDefinition->mPrePassMode, mPrePassTextures, mPrePassDepthTexture,
                                        mSsrTexture );
         sceneManager->_setRefractions( mDepthTextureNoMsaa, mRefractionsTexture );
@@ -287,6 +291,9 @@ namespace Ogre
         viewport->_updateCullPhase01( mCamera, mCullCamera, usedLodCamera, mDefinition->mFirstRQ,
                                       mDefinition->mLastRQ, mDefinition->mReuseCullData );
 
+        if( mUpdateShadowNode && shadowNode )
+            sceneManager->_clearBatchedCull();
+
         notifyPassSceneAfterFrustumCullingListeners();
 
 #if TODO_OGRE_2_2
@@ -307,6 +314,7 @@ namespace Ogre
 #endif
 
         sceneManager->_setPrePassMode( PrePassNone, TextureGpuVec(), 0, 0 );
+        sceneManager->_setOcclusionCullingInPass( false );
         sceneManager->_setCurrentCompositorPass( 0 );
 
         if( mDefinition->mShadowNodeRecalculation != SHADOW_NODE_CASTER_PASS )
@@ -320,6 +328,20 @@ namespace Ogre
         profilingEnd();
     }
     //-----------------------------------------------------------------------------------
+    void CompositorPassScene::_addBatchedCull( const Camera *lodCamera )
+    {
+        if( !mNumPassesLeft || mDefinition->mReuseCullData || mDefinition->mCameraCubemapReorient )
+            return;
+
+        Camera const *usedLodCamera = mLodCamera;
+        if( lodCamera && mDefinition->mLodCameraName == IdString() )
+            usedLodCamera = lodCamera;
+
+        SceneManager *sceneManager = mCamera->getSceneManager();
+        sceneManager->_addBatchedCull( mCullCamera, usedLodCamera, mDefinition->mVisibilityMask,
+                                       mDefinition->mFirstRQ, mDefinition->mLastRQ );
+    }
+    //-----------------------------------------------------------------------------------
     void CompositorPassScene::analyzeBarriers( const bool bClearBarriers )
     {
         CompositorPass::analyzeBarriers( bClearBarriers );
@@ -142,6 +142,7 @@ namespace Ogre
             mCullCamera->_notifyViewport( viewport );
 
             ( *itor )->_update( mCullCamera, usedLodCamera, sceneManager );
+            sceneManager->_clearBatchedCull();
 
             ++itor;
         }
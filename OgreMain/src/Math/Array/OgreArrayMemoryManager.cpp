@@ -59,6 +59,8 @@ namespace Ogre
         mMaxHardLimit( maxHardLimit ),
         mCleanupThreshold( cleanupThreshold ),
         mRebaseListener( rebaseListener ),
+        mDeferredCleanup( false ),
+        mCleanupPending( false ),
         mLevel( depthLevel )
     {
         // If the assert triggers, their values will overflow to 0 when
@@ -151,6 +153,20 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     size_t ArrayMemoryManager::getAllMemory() const { return mMaxMemory * mTotalMemoryMultiplier; }
     //-----------------------------------------------------------------------------------
+    float ArrayMemoryManager::getFragmentationRatio() const
+    {
+        if( !mUsedMemory )
+            return 0.0f;
+        return static_cast<float>( mAvailableSlots.size() ) / static_cast<float>( mUsedMemory );
+    }
+    //-----------------------------------------------------------------------------------
+    void ArrayMemoryManager::setDeferredCleanup( bool bDeferred )
+    {
+        mDeferredCleanup = bDeferred;
+        if( !mDeferredCleanup && mCleanupPending )
+            defragment();
+    }
+    //-----------------------------------------------------------------------------------
     size_t ArrayMemoryManager::createNewSlot()
     {
         size_t usedMemory = mUsedMemory;
@@ -246,59 +262,142 @@ namespace Ogre
             // The pool is getting to big? Do some cleanup (depending
             // on fragmentation, may take a performance hit)
             if( mAvailableSlots.size() > mCleanupThreshold )
-                defragment();
+            {
+                if( mDeferredCleanup )
+                    mCleanupPending = true;
+                else
+                    defragment();
+            }
         }
     }
     //-----------------------------------------------------------------------------------
     void ArrayMemoryManager::defragment()
     {
-        // Sort, last values first. This may improve performance in some
-        // scenarios by reducing the amount of data to be shifted
-        std::sort( mAvailableSlots.begin(), mAvailableSlots.end(), std::greater<size_t>() );
-        SlotsVec::const_iterator itor = mAvailableSlots.begin();
-        SlotsVec::const_iterator endt = mAvailableSlots.end();
+        defragmentIncremental( std::numeric_limits<size_t>::max() );
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ArrayMemoryManager::defragmentIncremental( size_t maxSlotsToMove )
+    {
+        if( mAvailableSlots.empty() )
+            return 0u;
 
-        while( itor != endt )
+        // Start from the first unused slots and move them towards the end of the pool, merging
+        // them with every unused slot they run into. This way each used slot gets moved only
+        // once (rather than once per range of unused slots below it), and we can stop at any
+        // point: the unused slots ahead haven't been touched yet.
+        if( !std::is_sorted( mAvailableSlots.begin(), mAvailableSlots.end() ) )
+            std::sort( mAvailableSlots.begin(), mAvailableSlots.end() );
+
+        size_t slotsMoved = 0;
+
+        // The unused slots [rangeStart; rangeStart + numFree) we're moving.
+        // They are the first numFree entries in mAvailableSlots
+        size_t rangeStart = mAvailableSlots[0];
+        size_t numFree = 0;
+
+        while( true )
         {
-            // First see if we have a continuous range of unused slots
-            size_t lastRange = 1;
-            SlotsVec::const_iterator it = itor + 1;
-            while( it != endt && ( *itor - lastRange ) == *it )
+            while( numFree < mAvailableSlots.size() &&
+                   mAvailableSlots[numFree] == rangeStart + numFree )
+            {
+                ++numFree;
+            }
+
+            const size_t rangeEnd = rangeStart + numFree;
+            const size_t nextFree =
+                numFree < mAvailableSlots.size() ? mAvailableSlots[numFree] : mUsedMemory;
+
+            // Shift the used slots right after the range backwards, as many as we're allowed
+            const size_t numSlots = std::min( nextFree - rangeEnd, maxSlotsToMove - slotsMoved );
+
+            if( numSlots )
             {
-                ++lastRange;
-                ++it;
+                size_t i = 0;
+                MemoryPoolVec::iterator itPools = mMemoryPools.begin();
+                MemoryPoolVec::iterator enPools = mMemoryPools.end();
+
+                while( itPools != enPools )
+                {
+                    char *dstPtr = *itPools + rangeStart * mElementsMemSizes[i];
+                    size_t indexDst = rangeStart % ARRAY_PACKED_REALS;
+                    char *srcPtr = *itPools + rangeEnd * mElementsMemSizes[i];
+                    size_t indexSrc = rangeEnd % ARRAY_PACKED_REALS;
+                    mCleanupRoutines[i]( dstPtr, indexDst, srcPtr, indexSrc, numSlots, 0u,
+                                         mElementsMemSizes[i] );
+                    ++i;
+                    ++itPools;
+                }
+
+                // Only the slots we've just moved out of still have their old values
+                const size_t dirtyStart = std::max( rangeEnd, rangeStart + numSlots );
+                cleanupSlotRange( dirtyStart, rangeEnd + numSlots );
+                initializeEmptySlotRange( dirtyStart, rangeEnd + numSlots );
+
+                mRebaseListener->performPartialCleanup( mLevel, mMemoryPools, mElementsMemSizes,
+                                                        rangeStart, rangeStart + numSlots,
+                                                        numFree );
+
+                slotsMoved += numSlots;
+                rangeStart += numSlots;
             }
 
+            if( rangeStart + numFree == mUsedMemory )
+            {
+                // The range reached the end. We can release it.
+                mUsedMemory -= numFree;
+                initializeEmptySlots( mUsedMemory );
+                mAvailableSlots.clear();
+                numFree = 0;
+                break;
+            }
+
+            if( slotsMoved == maxSlotsToMove )
+                break;
+        }
+
+        for( size_t i = 0; i < numFree; ++i )
+            mAvailableSlots[i] = rangeStart + i;
+
+        if( mAvailableSlots.empty() )
+            mCleanupPending = false;
+
+        return slotsMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void ArrayMemoryManager::cleanupSlotRange( size_t startSlot, size_t endSlot )
+    {
+        // The cleanup routines default-initialize the free slots up to the next multiple of
+        // ARRAY_PACKED_REALS when there's more than one pack. That's fine at the end of the pool,
+        // but here used slots may follow. Split the range so that never happens.
+        const size_t firstPackEnd =
+            std::min( alignToNextMultiple<size_t>( startSlot + 1u, ARRAY_PACKED_REALS ), endSlot );
+        const size_t lastPackStart =
+            std::max( endSlot - endSlot % ARRAY_PACKED_REALS, firstPackEnd );
+
+        const size_t ranges[3][2] = { { startSlot, firstPackEnd },
+                                      { firstPackEnd, lastPackStart },
+                                      { lastPackStart, endSlot } };
+
+        for( size_t rangeIdx = 0; rangeIdx < 3u; ++rangeIdx )
+        {
+            const size_t numFreeSlots = ranges[rangeIdx][1] - ranges[rangeIdx][0];
+            if( !numFreeSlots )
+                continue;
+
             size_t i = 0;
-            const size_t newEnd = *itor + 1;
             MemoryPoolVec::iterator itPools = mMemoryPools.begin();
             MemoryPoolVec::iterator enPools = mMemoryPools.end();
 
-            // Shift everything N slots (N = lastRange)
             while( itPools != enPools )
             {
-                char *dstPtr = *itPools + ( newEnd - lastRange ) * mElementsMemSizes[i];
-                size_t indexDst = ( newEnd - lastRange ) % ARRAY_PACKED_REALS;
-                char *srcPtr = *itPools + newEnd * mElementsMemSizes[i];
-                size_t indexSrc = newEnd % ARRAY_PACKED_REALS;
-                size_t numSlots = ( mUsedMemory - newEnd );
-                size_t numFreeSlots = lastRange;
-                mCleanupRoutines[i]( dstPtr, indexDst, srcPtr, indexSrc, numSlots, numFreeSlots,
+                char *dstPtr = *itPools + ranges[rangeIdx][0] * mElementsMemSizes[i];
+                const size_t indexDst = ranges[rangeIdx][0] % ARRAY_PACKED_REALS;
+                mCleanupRoutines[i]( dstPtr, indexDst, dstPtr, indexDst, 0u, numFreeSlots,
                                      mElementsMemSizes[i] );
                 ++i;
                 ++itPools;
             }
-
-            mUsedMemory -= lastRange;
-            initializeEmptySlots( mUsedMemory );
-
-            mRebaseListener->performCleanup( mLevel, mMemoryPools, mElementsMemSizes,
-                                             ( newEnd - lastRange ), lastRange );
-
-            itor += static_cast<ptrdiff_t>( lastRange );
         }
-
-        mAvailableSlots.clear();
     }
     //-----------------------------------------------------------------------------------
     void ArrayMemoryManager::shrinkToFit()
@@ -80,18 +80,18 @@ namespace Ogre
     {
     }
     //-----------------------------------------------------------------------------------
-    void BoneArrayMemoryManager::initializeEmptySlots( size_t prevNumSlots )
+    void BoneArrayMemoryManager::initializeEmptySlotRange( size_t startSlot, size_t endSlot )
     {
-        ArrayMemoryManager::initializeEmptySlots( prevNumSlots );
+        ArrayMemoryManager::initializeEmptySlotRange( startSlot, endSlot );
 
         bool *inheritOrientation =
-            reinterpret_cast<bool *>( mMemoryPools[InheritOrientation] ) + prevNumSlots;
-        bool *inheritScale = reinterpret_cast<bool *>( mMemoryPools[InheritScale] ) + prevNumSlots;
+            reinterpret_cast<bool *>( mMemoryPools[InheritOrientation] ) + startSlot;
+        bool *inheritScale = reinterpret_cast<bool *>( mMemoryPools[InheritScale] ) + startSlot;
         SimpleMatrixAf4x3 const **parentMatPtr =
-            reinterpret_cast<const SimpleMatrixAf4x3 **>( mMemoryPools[ParentMat] ) + prevNumSlots;
+            reinterpret_cast<const SimpleMatrixAf4x3 **>( mMemoryPools[ParentMat] ) + startSlot;
         SimpleMatrixAf4x3 const **parentNodePtr =
-            reinterpret_cast<const SimpleMatrixAf4x3 **>( mMemoryPools[ParentNode] ) + prevNumSlots;
-        for( size_t i = prevNumSlots; i < mMaxMemory; ++i )
+            reinterpret_cast<const SimpleMatrixAf4x3 **>( mMemoryPools[ParentNode] ) + startSlot;
+        for( size_t i = startSlot; i < endSlot; ++i )
         {
             *inheritOrientation++ = true;
             *inheritScale++ = true;
@@ -227,9 +227,17 @@ namespace Ogre
     void BoneMemoryManager::performCleanup( uint16 level, const MemoryPoolVec &basePtrs,
                                             size_t const *elementsMemSizes, size_t startInstance,
                                             size_t diffInstances )
+    {
+        performPartialCleanup( level, basePtrs, elementsMemSizes, startInstance,
+                               std::numeric_limits<size_t>::max(), diffInstances );
+    }
+    //---------------------------------------------------------------------
+    void BoneMemoryManager::performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                                   size_t const *elementsMemSizes, size_t startInstance,
+                                                   size_t endInstance, size_t diffInstances )
     {
         BoneTransform transform;
-        const size_t numNodes = this->getFirstNode( transform, level );
+        const size_t numNodes = std::min( this->getFirstNode( transform, level ), endInstance );
 
         size_t roundedStart = startInstance / ARRAY_PACKED_REALS;
 
@@ -46,7 +46,8 @@ namespace Ogre
         3 * sizeof( Ogre::Real ),   // ArrayMemoryManager::DerivedScale
         16 * sizeof( Ogre::Real ),  // ArrayMemoryManager::WorldMat
         sizeof( bool ),             // ArrayMemoryManager::InheritOrientation
-        sizeof( bool )              // ArrayMemoryManager::InheritScale
+        sizeof( bool ),             // ArrayMemoryManager::InheritScale
+        sizeof( uint8 )             // ArrayMemoryManager::Dirty
     };
     const CleanupRoutines NodeArrayMemoryManager::NodeInitRoutines[NumMemoryTypes] = {
         0,                        // ArrayMemoryManager::Parent
@@ -59,7 +60,8 @@ namespace Ogre
         cleanerArrayVector3Unit,  // ArrayMemoryManager::DerivedScale
         0,                        // ArrayMemoryManager::WorldMat
         0,                        // ArrayMemoryManager::InheritOrientation
-        0                         // ArrayMemoryManager::InheritScale
+        0,                        // ArrayMemoryManager::InheritScale
+        0                         // ArrayMemoryManager::Dirty
     };
     const CleanupRoutines NodeArrayMemoryManager::NodeCleanupRoutines[NumMemoryTypes] = {
         cleanerFlat,              // ArrayMemoryManager::Parent
@@ -72,7 +74,8 @@ namespace Ogre
         cleanerArrayVector3Unit,  // ArrayMemoryManager::DerivedScale
         cleanerFlat,              // ArrayMemoryManager::WorldMat
         cleanerFlat,              // ArrayMemoryManager::InheritOrientation
-        cleanerFlat               // ArrayMemoryManager::InheritScale
+        cleanerFlat,              // ArrayMemoryManager::InheritScale
+        cleanerFlat               // ArrayMemoryManager::Dirty
     };
     //-----------------------------------------------------------------------------------
     NodeArrayMemoryManager::NodeArrayMemoryManager( uint16 depthLevel, size_t hintMaxNodes,
@@ -86,12 +89,12 @@ namespace Ogre
     {
     }
     //-----------------------------------------------------------------------------------
-    void NodeArrayMemoryManager::initializeEmptySlots( size_t prevNumSlots )
+    void NodeArrayMemoryManager::initializeEmptySlotRange( size_t startSlot, size_t endSlot )
     {
-        ArrayMemoryManager::initializeEmptySlots( prevNumSlots );
+        ArrayMemoryManager::initializeEmptySlotRange( startSlot, endSlot );
 
-        Node **nodesPtr = reinterpret_cast<Node **>( mMemoryPools[Parent] ) + prevNumSlots;
-        for( size_t i = prevNumSlots; i < mMaxMemory; ++i )
+        Node **nodesPtr = reinterpret_cast<Node **>( mMemoryPools[Parent] ) + startSlot;
+        for( size_t i = startSlot; i < endSlot; ++i )
             *nodesPtr++ = mDummyNode;
     }
     //-----------------------------------------------------------------------------------
@@ -125,6 +128,8 @@ namespace Ogre
             mMemoryPools[InheritOrientation] + nextSlotBase * mElementsMemSizes[InheritOrientation] );
         outTransform.mInheritScale = reinterpret_cast<bool *>(
             mMemoryPools[InheritScale] + nextSlotBase * mElementsMemSizes[InheritScale] );
+        outTransform.mDirty =
+            reinterpret_cast<uint8 *>( mMemoryPools[Dirty] + nextSlotBase * mElementsMemSizes[Dirty] );
 
         // Set default values
         outTransform.mParents[nextSlotIdx] = mDummyNode;
@@ -138,6 +143,7 @@ namespace Ogre
         outTransform.mDerivedTransform[nextSlotIdx] = Matrix4::IDENTITY;
         outTransform.mInheritOrientation[nextSlotIdx] = true;
         outTransform.mInheritScale[nextSlotIdx] = true;
+        outTransform.mDirty[nextSlotIdx] = Transform::DirtyLocal;
     }
     //-----------------------------------------------------------------------------------
     void NodeArrayMemoryManager::destroyNode( Transform &inOutTransform )
@@ -147,6 +153,8 @@ namespace Ogre
 
         inOutTransform.mParents[inOutTransform.mIndex] = mDummyNode;
         inOutTransform.mOwner[inOutTransform.mIndex] = 0;
+        // Empty slots must not force their whole pack to be updated
+        inOutTransform.mDirty[inOutTransform.mIndex] = 0;
         destroySlot( reinterpret_cast<char *>( inOutTransform.mParents ), inOutTransform.mIndex );
         // Zero out all pointers
         inOutTransform = Transform();
@@ -167,6 +175,7 @@ namespace Ogre
         outTransform.mDerivedTransform = reinterpret_cast<Matrix4 *>( mMemoryPools[WorldMat] );
         outTransform.mInheritOrientation = reinterpret_cast<bool *>( mMemoryPools[InheritOrientation] );
         outTransform.mInheritScale = reinterpret_cast<bool *>( mMemoryPools[InheritScale] );
+        outTransform.mDirty = reinterpret_cast<uint8 *>( mMemoryPools[Dirty] );
 
         return mUsedMemory;
     }
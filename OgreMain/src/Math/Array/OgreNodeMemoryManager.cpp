@@ -37,7 +37,8 @@ namespace Ogre
     NodeMemoryManager::NodeMemoryManager() :
         mDummyNode( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
-        mTwinMemoryManager( 0 )
+        mTwinMemoryManager( 0 ),
+        mDeferredCleanup( false )
     {
         // Manually allocate the memory for the dummy scene nodes (since we can't pass ourselves
         // or yet another object) We only allocate what's needed to prevent access violations.
@@ -64,11 +65,16 @@ namespace Ogre
         mDummyTransformPtrs.mInheritScale       = OGRE_MALLOC_SIMD( sizeof( bool ) * ARRAY_PACKED_REALS,
                                                                     MEMCATEGORY_SCENE_OBJECTS );*/
 
+        mDummyTransformPtrs.mDirty = reinterpret_cast<uint8 *>(
+            OGRE_MALLOC_SIMD( sizeof( uint8 ) * ARRAY_PACKED_REALS, MEMCATEGORY_SCENE_OBJECTS ) );
+
         *mDummyTransformPtrs.mDerivedPosition = ArrayVector3::ZERO;
         *mDummyTransformPtrs.mDerivedOrientation = ArrayQuaternion::IDENTITY;
         *mDummyTransformPtrs.mDerivedScale = ArrayVector3::UNIT_SCALE;
         for( int i = 0; i < ARRAY_PACKED_REALS; ++i )
             mDummyTransformPtrs.mDerivedTransform[i] = Matrix4::IDENTITY;
+        // The dummy never changes, thus never forces root nodes to be updated
+        memset( mDummyTransformPtrs.mDirty, 0, sizeof( uint8 ) * ARRAY_PACKED_REALS );
 
         mDummyNode = new SceneNode( mDummyTransformPtrs );
     }
@@ -98,6 +104,7 @@ namespace Ogre
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedScale, MEMCATEGORY_SCENE_OBJECTS );
 
         OGRE_FREE_SIMD( mDummyTransformPtrs.mDerivedTransform, MEMCATEGORY_SCENE_OBJECTS );
+        OGRE_FREE_SIMD( mDummyTransformPtrs.mDirty, MEMCATEGORY_SCENE_OBJECTS );
         /*OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritOrientation, MEMCATEGORY_SCENE_OBJECTS );
         OGRE_FREE_SIMD( mDummyTransformPtrs.mInheritScale, MEMCATEGORY_SCENE_OBJECTS );*/
         mDummyTransformPtrs = Transform();
@@ -119,6 +126,7 @@ namespace Ogre
                 NodeArrayMemoryManager( (uint16)mMemoryManagers.size(), 100, mDummyNode, 100,
                                         ArrayMemoryManager::MAX_MEMORY_SLOTS, this ) );
             mMemoryManagers.back().initialize();
+            mMemoryManagers.back().setDeferredCleanup( mDeferredCleanup );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -182,6 +190,67 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::defragmentIncremental( size_t maxSlotsToMove, bool onlyPendingCleanups )
+    {
+        size_t slotsMoved = 0;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt && slotsMoved < maxSlotsToMove )
+        {
+            if( !onlyPendingCleanups || itor->isCleanupPending() )
+                slotsMoved += itor->defragmentIncremental( maxSlotsToMove - slotsMoved );
+            ++itor;
+        }
+
+        return slotsMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void NodeMemoryManager::setDeferredCleanup( bool bDeferred )
+    {
+        mDeferredCleanup = bDeferred;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            itor->setDeferredCleanup( bDeferred );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::getNumFragmentedSlots() const
+    {
+        size_t retVal = 0;
+        ArrayMemoryManagerVec::const_iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::const_iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            retVal += itor->getNumFragmentedSlots();
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t NodeMemoryManager::getNumUsedSlotsIncludingFragmented() const
+    {
+        size_t retVal = 0;
+        ArrayMemoryManagerVec::const_iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::const_iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            retVal += itor->getNumUsedSlotsIncludingFragmented();
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
     void NodeMemoryManager::shrinkToFit()
     {
         ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
@@ -258,6 +327,18 @@ namespace Ogre
         return mMemoryManagers[depth].getFirstNode( outTransform );
     }
     //-----------------------------------------------------------------------------------
+    void NodeMemoryManager::_clearDirtyFlags( size_t firstDepth )
+    {
+        for( size_t i = firstDepth; i < mMemoryManagers.size(); ++i )
+        {
+            Transform t;
+            const size_t numNodes = mMemoryManagers[i].getFirstNode( t );
+            const size_t numSlots =
+                ( ( numNodes + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+            memset( t.mDirty, 0, numSlots * sizeof( uint8 ) );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void NodeMemoryManager::buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                                            ArrayMemoryManager::PtrdiffVec &outDiffsList )
     {
@@ -305,9 +386,17 @@ namespace Ogre
     void NodeMemoryManager::performCleanup( uint16 level, const MemoryPoolVec &basePtrs,
                                             size_t const *elementsMemSizes, size_t startInstance,
                                             size_t diffInstances )
+    {
+        performPartialCleanup( level, basePtrs, elementsMemSizes, startInstance,
+                               std::numeric_limits<size_t>::max(), diffInstances );
+    }
+    //---------------------------------------------------------------------
+    void NodeMemoryManager::performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                                   size_t const *elementsMemSizes, size_t startInstance,
+                                                   size_t endInstance, size_t diffInstances )
     {
         Transform transform;
-        const size_t numNodes = this->getFirstNode( transform, level );
+        const size_t numNodes = std::min( this->getFirstNode( transform, level ), endInstance );
 
         size_t roundedStart = startInstance / ARRAY_PACKED_REALS;
 
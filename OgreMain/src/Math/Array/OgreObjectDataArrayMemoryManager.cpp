@@ -76,14 +76,14 @@ namespace Ogre
     {
     }
     //-----------------------------------------------------------------------------------
-    void ObjectDataArrayMemoryManager::initializeEmptySlots( size_t prevNumSlots )
+    void ObjectDataArrayMemoryManager::initializeEmptySlotRange( size_t startSlot, size_t endSlot )
     {
-        ArrayMemoryManager::initializeEmptySlots( prevNumSlots );
+        ArrayMemoryManager::initializeEmptySlotRange( startSlot, endSlot );
 
-        Node **nodesPtr = reinterpret_cast<Node **>( mMemoryPools[Parent] ) + prevNumSlots;
+        Node **nodesPtr = reinterpret_cast<Node **>( mMemoryPools[Parent] ) + startSlot;
         MovableObject **ownersPtr =
-            reinterpret_cast<MovableObject **>( mMemoryPools[Owner] ) + prevNumSlots;
-        for( size_t i = prevNumSlots; i < mMaxMemory; ++i )
+            reinterpret_cast<MovableObject **>( mMemoryPools[Owner] ) + startSlot;
+        for( size_t i = startSlot; i < endSlot; ++i )
         {
             *nodesPtr++ = mDummyNode;
             *ownersPtr++ = mDummyObject;
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "Math/Array/OgreObjectMemoryManager.h"
 
+#include "Math/Array/OgreBooleanMask.h"
 #include "OgreMovableObject.h"
 
 namespace Ogre
@@ -39,7 +40,9 @@ namespace Ogre
         mDummyNode( 0 ),
         mDummyObject( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
-        mTwinMemoryManager( 0 )
+        mTwinMemoryManager( 0 ),
+        mDeferredCleanup( false ),
+        mClusterCulling( false )
     {
         // Manually allocate the memory for the dummy scene nodes (since we can't pass ourselves
         // or yet another object) We only allocate what's needed to prevent access violations.
@@ -123,6 +126,7 @@ namespace Ogre
                 (uint16)mMemoryManagers.size(), 100, mDummyNode, mDummyObject, 100,
                 ArrayMemoryManager::MAX_MEMORY_SLOTS, this ) );
             mMemoryManagers.back().initialize();
+            mMemoryManagers.back().setDeferredCleanup( mDeferredCleanup );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -132,6 +136,7 @@ namespace Ogre
 
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[renderQueue];
         mgr.createNewNode( outObjectData );
+        invalidateClusters( renderQueue );
 
         ++mTotalObjects;
     }
@@ -143,6 +148,7 @@ namespace Ogre
 
         ObjectData tmp;
         mMemoryManagers[newRenderQueue].createNewNode( tmp );
+        invalidateClusters( newRenderQueue );
 
         tmp.copy( inOutObjectData );
 
@@ -182,6 +188,67 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::defragmentIncremental( size_t maxSlotsToMove, bool onlyPendingCleanups )
+    {
+        size_t slotsMoved = 0;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt && slotsMoved < maxSlotsToMove )
+        {
+            if( !onlyPendingCleanups || itor->isCleanupPending() )
+                slotsMoved += itor->defragmentIncremental( maxSlotsToMove - slotsMoved );
+            ++itor;
+        }
+
+        return slotsMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::setDeferredCleanup( bool bDeferred )
+    {
+        mDeferredCleanup = bDeferred;
+
+        ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            itor->setDeferredCleanup( bDeferred );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::getNumFragmentedSlots() const
+    {
+        size_t retVal = 0;
+        ArrayMemoryManagerVec::const_iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::const_iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            retVal += itor->getNumFragmentedSlots();
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t ObjectMemoryManager::getNumUsedSlotsIncludingFragmented() const
+    {
+        size_t retVal = 0;
+        ArrayMemoryManagerVec::const_iterator itor = mMemoryManagers.begin();
+        ArrayMemoryManagerVec::const_iterator endt = mMemoryManagers.end();
+
+        while( itor != endt )
+        {
+            retVal += itor->getNumUsedSlotsIncludingFragmented();
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::shrinkToFit()
     {
         ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
@@ -232,6 +299,126 @@ namespace Ogre
         return mMemoryManagers[renderQueue].getFirstNode( outObjectData );
     }
     //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::invalidateClusters( size_t renderQueue )
+    {
+        if( renderQueue < mClusterLists.size() )
+            mClusterLists[renderQueue].valid = false;
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::setClusterCulling( bool bEnable )
+    {
+        mClusterCulling = bEnable;
+        // They'll be rebuilt the next time our bounds get updated
+        mClusterLists.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_prepareClusters()
+    {
+        assert( mClusterCulling );
+
+        mClusterLists.resize( mMemoryManagers.size() );
+
+        ClusterListVec::iterator itor = mClusterLists.begin();
+        ClusterListVec::iterator endt = mClusterLists.end();
+        ArrayMemoryManagerVec::const_iterator itMgr = mMemoryManagers.begin();
+
+        while( itor != endt )
+        {
+            const size_t numSlots = itMgr->getNumUsedSlotsIncludingFragmented();
+            itor->clusters.resize( ( numSlots + c_objsPerCluster - 1u ) / c_objsPerCluster );
+            itor->valid = true;
+            ++itMgr;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_updateClusters( size_t renderQueue, size_t firstObj, size_t numObjs,
+                                               ObjectData objData )
+    {
+        assert( firstObj % c_objsPerCluster == 0u );
+        assert( renderQueue < mClusterLists.size() );
+
+        ClusterArray &clusters = mClusterLists[renderQueue].clusters;
+
+        ArrayVector3 infinity;
+        infinity.setAll( Vector3( std::numeric_limits<Real>::infinity(),
+                                  std::numeric_limits<Real>::infinity(),
+                                  std::numeric_limits<Real>::infinity() ) );
+        const ArrayVector3 negInfinity = -infinity;
+
+        ClusterArray::iterator itCluster = clusters.begin() + firstObj / c_objsPerCluster;
+
+        for( size_t i = 0; i < numObjs; i += c_objsPerCluster )
+        {
+            assert( itCluster != clusters.end() );
+
+            const size_t objsInCluster = std::min( c_objsPerCluster, numObjs - i );
+
+            ArrayVector3 vMin = infinity;
+            ArrayVector3 vMax = negInfinity;
+
+            for( size_t j = 0; j < objsInCluster; j += ARRAY_PACKED_REALS )
+            {
+                // Unused slots may hold any Aabb (i.e. BOX_ZERO after a cleanup)
+                bool isUsed[ARRAY_PACKED_REALS];
+                for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                    isUsed[k] = objData.mOwner[k] != 0 && objData.mOwner[k] != mDummyObject;
+                const ArrayMaskR usedMask = BooleanMask4::getMask( isUsed );
+
+                ArrayVector3 objMin = objData.mWorldAabb->mCenter - objData.mWorldAabb->mHalfSize;
+                ArrayVector3 objMax = objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize;
+                objMin.CmovRobust( usedMask, infinity );
+                objMax.CmovRobust( usedMask, negInfinity );
+
+                vMin.makeFloor( objMin );
+                vMax.makeCeil( objMax );
+
+                objData.advancePack();
+            }
+
+            itCluster->vMin = vMin.collapseMin();
+            itCluster->vMax = vMax.collapseMax();
+            ++itCluster;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_growCluster( const ObjectData &objData, size_t renderQueue,
+                                            const Aabb &worldAabb )
+    {
+        if( renderQueue >= mClusterLists.size() || !mClusterLists[renderQueue].valid )
+            return;
+
+        ObjectData firstObjData;
+        mMemoryManagers[renderQueue].getFirstNode( firstObjData );
+        const size_t slotIdx = static_cast<size_t>( objData.mOwner - firstObjData.mOwner ) +
+                               objData.mIndex;
+
+        ClusterArray &clusters = mClusterLists[renderQueue].clusters;
+        const size_t clusterIdx = slotIdx / c_objsPerCluster;
+        if( clusterIdx < clusters.size() )
+        {
+            clusters[clusterIdx].vMin.makeFloor( worldAabb.getMinimum() );
+            clusters[clusterIdx].vMax.makeCeil( worldAabb.getMaximum() );
+        }
+        else
+        {
+            // The slot was created after the clusters were built (which should've
+            // invalidated them)
+            mClusterLists[renderQueue].valid = false;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    const ObjectMemoryManager::Cluster *ObjectMemoryManager::_getClusters( size_t renderQueue ) const
+    {
+        if( !mClusterCulling || renderQueue >= mClusterLists.size() ||
+            !mClusterLists[renderQueue].valid )
+        {
+            return 0;
+        }
+
+        return mClusterLists[renderQueue].clusters.begin();
+    }
+    //-----------------------------------------------------------------------------------
     void ObjectMemoryManager::buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
                                              ArrayMemoryManager::PtrdiffVec &outDiffsList )
     {
@@ -257,6 +444,8 @@ namespace Ogre
     void ObjectMemoryManager::applyRebase( uint16 level, const MemoryPoolVec &newBasePtrs,
                                            const ArrayMemoryManager::PtrdiffVec &diffsList )
     {
+        invalidateClusters( level );
+
         ObjectData objectData;
         const size_t numObjs = this->getFirstObjectData( objectData, level );
 
@@ -279,8 +468,20 @@ namespace Ogre
                                               size_t const *elementsMemSizes, size_t startInstance,
                                               size_t diffInstances )
     {
+        performPartialCleanup( level, basePtrs, elementsMemSizes, startInstance,
+                               std::numeric_limits<size_t>::max(), diffInstances );
+    }
+    //---------------------------------------------------------------------
+    void ObjectMemoryManager::performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                                     size_t const *elementsMemSizes,
+                                                     size_t startInstance, size_t endInstance,
+                                                     size_t diffInstances )
+    {
+        // Slots were shifted, they no longer match their clusters
+        invalidateClusters( level );
+
         ObjectData objectData;
-        const size_t numObjs = this->getFirstObjectData( objectData, level );
+        const size_t numObjs = std::min( this->getFirstObjectData( objectData, level ), endInstance );
 
         size_t roundedStart = startInstance / ARRAY_PACKED_REALS;
 
@@ -421,6 +421,35 @@ namespace Ogre
         ::remove( full_path.c_str() );
 #endif
     }
+    //---------------------------------------------------------------------
+    void FileSystemArchive::rename( const String &oldFilename, const String &newFilename )
+    {
+        if( isReadOnly() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Cannot rename a file in a read-only archive",
+                         "FileSystemArchive::rename" );
+        }
+        String oldPath = concatenate_path( mName, oldFilename );
+        String newPath = concatenate_path( mName, newFilename );
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32 || OGRE_PLATFORM == OGRE_PLATFORM_WINRT
+        // ::rename fails on Windows if the destination exists
+#    ifdef _OGRE_FILESYSTEM_ARCHIVE_UNICODE
+        const bool success = MoveFileExW( to_wpath( oldPath ).c_str(), to_wpath( newPath ).c_str(),
+                                          MOVEFILE_REPLACE_EXISTING ) != 0;
+#    else
+        const bool success =
+            MoveFileExA( oldPath.c_str(), newPath.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#    endif
+#else
+        const bool success = ::rename( oldPath.c_str(), newPath.c_str() ) == 0;
+#endif
+        if( !success )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE,
+                         "Cannot rename file: " + oldFilename + " to " + newFilename,
+                         "FileSystemArchive::rename" );
+        }
+    }
     //-----------------------------------------------------------------------
     StringVectorPtr FileSystemArchive::list( bool recursive, bool dirs )
     {
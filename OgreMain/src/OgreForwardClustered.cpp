@@ -132,16 +132,11 @@ namespace Ogre
             floorf( Math::Log2( std::max( -depth - mMinDistance, Real( 1 ) ) ) * mInvExponentK ) );
     }
     //-----------------------------------------------------------------------------------
-    void ForwardClustered::execute( size_t threadId, size_t numThreads )
+    void ForwardClustered::execute( size_t chunkIdx, size_t threadIdx )
     {
-        const size_t slicesPerThread = mNumSlices / numThreads;
-
-        for( size_t i = 0; i < slicesPerThread; ++i )
-            collectLightForSlice( i + threadId * slicesPerThread, threadId );
-
-        const size_t slicesRemainder = mNumSlices % numThreads;
-        if( slicesRemainder > threadId )
-            collectLightForSlice( threadId + numThreads * slicesPerThread, threadId );
+        // One chunk per slice. The cost of a slice depends on how many lights touch it,
+        // idle threads steal the remaining slices from the busy ones.
+        collectLightForSlice( chunkIdx, threadIdx );
     }
     //-----------------------------------------------------------------------------------
     inline size_t ForwardClustered::getDecalsOffsetStart() const
@@ -857,7 +852,8 @@ namespace Ogre
         mCurrentCamera->getDerivedPosition();
         mCurrentCamera->getWorldSpaceCorners();
 
-        mSceneManager->executeUserScalableTask( this, true );
+        TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        taskScheduler->wait( taskScheduler->submit( this, mNumSlices ) );
 
         if( !mDebugWireAabb.empty() && !mDebugWireAabbFrozen )
         {
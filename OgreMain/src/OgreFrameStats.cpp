@@ -0,0 +1,239 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreFrameStats.h"
+
+#include "OgreLogManager.h"
+#include "OgreMath.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace Ogre
+{
+    static const char *c_frameStageNames[FrameStage::NumFrameStages] = {
+        "Scene update", "Compositor", "Shader compile", "Texture streaming stall"
+    };
+
+    FrameStats::FrameStats() : mWindowSize( 0 ), mWindowNext( 0 ), mWindowSampled( 0 )
+    {
+        const float defaultThresholds[3] = { 33.3f, 50.0f, 100.0f };
+        setHitchThresholds( defaultThresholds, 3u );
+        setWindowSize( 600u );
+        reset( 0 );
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::addSample( uint64 timeMs )
+    {
+        unsigned long frameTimeMs = static_cast<unsigned long>( timeMs - mLastTime );
+        mFrameTimes[mNextFrame] = frameTimeMs;
+        mBestFrameTime = std::min( frameTimeMs, mBestFrameTime );
+        mWorstFrameTime = std::max( frameTimeMs, mWorstFrameTime );
+
+        mFramesSampled = std::min<size_t>( ( mFramesSampled + 1 ), OGRE_FRAME_STATS_SAMPLES );
+        mNextFrame = ( mNextFrame + 1 ) % OGRE_FRAME_STATS_SAMPLES;
+
+        mLastTime = timeMs;
+
+        const uint32 frameTimeUs =
+            static_cast<uint32>( std::min<uint64>( frameTimeMs, std::numeric_limits<uint32>::max() ) );
+
+        if( mWindowSize )
+        {
+            mWindowFrameTimes[mWindowNext] = frameTimeUs;
+            for( size_t i = 0; i < FrameStage::NumFrameStages; ++i )
+            {
+                mWindowStageTimes[i][mWindowNext] = static_cast<uint32>(
+                    std::min<uint64>( mPendingStageTimes[i], std::numeric_limits<uint32>::max() ) );
+            }
+            mWindowNext = ( mWindowNext + 1u ) % mWindowSize;
+            mWindowSampled = std::min( mWindowSampled + 1u, mWindowSize );
+        }
+
+        for( size_t i = 0; i < FrameStage::NumFrameStages; ++i )
+            mPendingStageTimes[i] = 0;
+
+        for( size_t i = 0; i < mNumHitchThresholds; ++i )
+        {
+            if( frameTimeUs > mHitchThresholds[i] )
+                ++mNumHitches[i];
+        }
+
+        const size_t bucketIdx =
+            std::min<size_t>( frameTimeUs / 1000u, OGRE_FRAME_STATS_HISTOGRAM_BUCKETS - 1u );
+        ++mHistogram[bucketIdx];
+        ++mTotalFrames;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::reset( uint64 timeMs )
+    {
+        mNextFrame = 0;
+        mBestFrameTime = std::numeric_limits<unsigned long>::max();
+        mWorstFrameTime = 0;
+        mLastTime = timeMs;
+        memset( mFrameTimes, 0, sizeof( unsigned long ) * OGRE_FRAME_STATS_SAMPLES );
+        mFramesSampled = 0;
+
+        mWindowNext = 0;
+        mWindowSampled = 0;
+        memset( mPendingStageTimes, 0, sizeof( mPendingStageTimes ) );
+        memset( mNumHitches, 0, sizeof( mNumHitches ) );
+        memset( mHistogram, 0, sizeof( mHistogram ) );
+        mTotalFrames = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::setWindowSize( size_t numFrames )
+    {
+        mWindowSize = numFrames;
+        mWindowNext = 0;
+        mWindowSampled = 0;
+
+        mWindowFrameTimes.resizePOD( numFrames );
+        for( size_t i = 0; i < FrameStage::NumFrameStages; ++i )
+            mWindowStageTimes[i].resizePOD( numFrames );
+        mScratch.reserve( numFrames );
+    }
+    //-----------------------------------------------------------------------------------
+    float FrameStats::getPercentile( float percentile ) const
+    {
+        if( !mWindowSampled )
+            return 0.0f;
+
+        // The order doesn't matter for percentiles, thus the ring can be copied as is
+        mScratch.resizePOD( mWindowSampled );
+        memcpy( mScratch.begin(), mWindowFrameTimes.begin(), mWindowSampled * sizeof( uint32 ) );
+
+        // Nearest rank
+        const float rank = std::ceil( Math::saturate( percentile * 0.01f ) * (float)mWindowSampled );
+        const size_t idx = static_cast<size_t>( std::max( rank, 1.0f ) ) - 1u;
+
+        std::nth_element( mScratch.begin(), mScratch.begin() + idx, mScratch.end() );
+        return mScratch[idx] * 0.001f;
+    }
+    //-----------------------------------------------------------------------------------
+    float FrameStats::getWindowAvgTime() const
+    {
+        if( !mWindowSampled )
+            return 0.0f;
+
+        uint64 total = 0;
+        for( size_t i = 0; i < mWindowSampled; ++i )
+            total += mWindowFrameTimes[i];
+        return static_cast<float>( (double)total / (double)mWindowSampled * 0.001 );
+    }
+    //-----------------------------------------------------------------------------------
+    float FrameStats::getWindowWorstTime() const
+    {
+        uint32 worst = 0;
+        for( size_t i = 0; i < mWindowSampled; ++i )
+            worst = std::max( worst, mWindowFrameTimes[i] );
+        return worst * 0.001f;
+    }
+    //-----------------------------------------------------------------------------------
+    float FrameStats::getStageAvgTime( FrameStage::FrameStage stage ) const
+    {
+        if( !mWindowSampled )
+            return 0.0f;
+
+        uint64 total = 0;
+        for( size_t i = 0; i < mWindowSampled; ++i )
+            total += mWindowStageTimes[stage][i];
+        return static_cast<float>( (double)total / (double)mWindowSampled * 0.001 );
+    }
+    //-----------------------------------------------------------------------------------
+    float FrameStats::getStageWorstTime( FrameStage::FrameStage stage ) const
+    {
+        uint32 worst = 0;
+        for( size_t i = 0; i < mWindowSampled; ++i )
+            worst = std::max( worst, mWindowStageTimes[stage][i] );
+        return worst * 0.001f;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::setHitchThresholds( const float *thresholdsMs, size_t numThresholds )
+    {
+        OGRE_ASSERT_LOW( numThresholds <= OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS );
+        mNumHitchThresholds = std::min<size_t>( numThresholds, OGRE_FRAME_STATS_MAX_HITCH_THRESHOLDS );
+        for( size_t i = 0; i < mNumHitchThresholds; ++i )
+        {
+            mHitchThresholds[i] = static_cast<uint32>( std::max( thresholdsMs[i], 0.0f ) * 1000.0f );
+            mNumHitches[i] = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::dumpStats( String &outString ) const
+    {
+        StringStream stream;
+        stream.setf( std::ios::fixed );
+        stream.precision( 2 );
+
+        stream << "Frame stats (last " << mWindowSampled << " frames):"
+               << "\n\tAverage time: " << getWindowAvgTime() << " ms"
+               << "\n\tp50: " << getPercentile( 50.0f ) << " ms"
+               << "\n\tp90: " << getPercentile( 90.0f ) << " ms"
+               << "\n\tp99: " << getPercentile( 99.0f ) << " ms"
+               << "\n\tWorst: " << getWindowWorstTime() << " ms";
+
+        for( size_t i = 0; i < FrameStage::NumFrameStages; ++i )
+        {
+            const FrameStage::FrameStage stage = static_cast<FrameStage::FrameStage>( i );
+            stream << "\n\t" << c_frameStageNames[i] << ": avg " << getStageAvgTime( stage )
+                   << " ms, worst " << getStageWorstTime( stage ) << " ms";
+        }
+
+        stream << "\nSince reset (" << mTotalFrames << " frames):";
+        for( size_t i = 0; i < mNumHitchThresholds; ++i )
+        {
+            stream << "\n\tFrames above " << getHitchThreshold( i ) << " ms: " << mNumHitches[i];
+        }
+
+        stream << "\n\tHistogram (ms: frames):";
+        for( size_t i = 0; i < OGRE_FRAME_STATS_HISTOGRAM_BUCKETS; ++i )
+        {
+            if( mHistogram[i] )
+            {
+                stream << " " << i << ( i == OGRE_FRAME_STATS_HISTOGRAM_BUCKETS - 1u ? "+" : "" )
+                       << ": " << mHistogram[i];
+            }
+        }
+
+        outString = stream.str();
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameStats::logStats() const
+    {
+        LogManager *logManager = LogManager::getSingletonPtr();
+        if( !logManager )
+            return;
+
+        String stats;
+        dumpStats( stats );
+        logManager->logMessage( stats );
+    }
+}  // namespace Ogre
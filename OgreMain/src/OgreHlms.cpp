@@ -49,7 +49,9 @@ THE SOFTWARE.
 #include "OgreRenderQueue.h"
 #include "OgreRootLayout.h"
 #include "OgreSceneManager.h"
+#include "OgreTimer.h"
 #include "OgreViewport.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Vao/OgreVaoManager.h"
 #include "Vao/OgreVertexArrayObject.h"
 
@@ -85,6 +87,8 @@ namespace Ogre
     const int HlmsBits::RenderableMask = ( 1 << RenderableBits ) - 1;
     const int HlmsBits::PassMask = ( 1 << PassBits ) - 1;
 
+    const uint32 Hlms::c_retryFillInRenderThread = 0xFFFFFFFFu;
+
     // Change per mesh (hash can be cached on the renderable)
     const IdString HlmsBaseProp::Skeleton = IdString( "hlms_skeleton" );
     const IdString HlmsBaseProp::BonesPerVertex = IdString( "hlms_bones_per_vertex" );
@@ -247,8 +251,37 @@ namespace Ogre
 
     static HlmsListener c_defaultListener;
 
+    /// Expands the templates of Hlms::mAsyncGeneratingShaderCode. One chunk per variant.
+    class Hlms::AsyncShaderGenerationTask : public Task, public OgreAllocatedObj
+    {
+        Hlms *mHlms;
+
+    public:
+        /// Name of the shaders of the first variant. The rest follow consecutively.
+        uint32 mFirstFinalHash;
+
+        AsyncShaderGenerationTask( Hlms *hlms ) : mHlms( hlms ), mFirstFinalHash( 0u ) {}
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            mHlms->generatePendingShader( mHlms->mAsyncGeneratingShaderCode[chunkIdx],
+                                          mFirstFinalHash + static_cast<uint32>( chunkIdx ) );
+        }
+    };
+
     Hlms::Hlms( HlmsTypes type, const String &typeName, Archive *dataFolder,
                 ArchiveVec *libraryFolders ) :
+        mTemplateSources( 0 ),
+        mParallelShaderGeneration( false ),
+        mParallelCommandGeneration( false ),
+        mUseCompiledTemplates( true ),
+        mAsyncShaderCompilation( false ),
+        mMaxAsyncCompilesPerFrame( 1u ),
+        mAsyncTaskScheduler( 0 ),
+        mAsyncGenerationTask( 0 ),
+        mAsyncGenerationTaskId( TaskScheduler::FinishedTask ),
+        mShaderCacheEntryPropertiesMerged( false ),
+        mTimer( OGRE_NEW Timer() ),
         mDataFolder( dataFolder ),
         mHlmsManager( 0 ),
         mLightGatheringMode( LightGatherForward ),
@@ -313,6 +346,9 @@ namespace Ogre
     {
         clearShaderCache();
 
+        OGRE_DELETE mAsyncGenerationTask;
+        mAsyncGenerationTask = 0;
+
         _destroyAllDatablocks();
 
         if( mHlmsManager && mType < HLMS_MAX )
@@ -320,6 +356,9 @@ namespace Ogre
             mHlmsManager->unregisterHlms( mType );
             mHlmsManager = 0;
         }
+
+        OGRE_DELETE mTimer;
+        mTimer = 0;
     }
     //-----------------------------------------------------------------------------------
     static void hashFileConcatenate( DataStreamPtr &inFile, FastArray<uint8> &fileContents )
@@ -683,14 +722,44 @@ namespace Ogre
         return isElse;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::evaluateExpression( SubStringRef &outSubString, bool &outSyntaxError ) const
+    bool Hlms::evaluateExpression( SubStringRef &outSubString, bool &outSyntaxError,
+                                   const ThreadData &td )
+    {
+        bool syntaxError = false;
+        ExpressionVec outExpressions;
+
+        const SubStringRef subString = outSubString;
+        parseExpression( outSubString, outExpressions, syntaxError );
+
+        if( syntaxError && outExpressions.empty() )
+        {
+            // Parenthesis without matching closure
+            outSyntaxError = true;
+            return false;
+        }
+
+        bool retVal = false;
+
+        if( !syntaxError )
+            retVal = evaluateExpressionRecursive( outExpressions, syntaxError, td ) != 0;
+
+        if( syntaxError )
+            printf( "Syntax Error at line %lu\n", calculateLineCount( subString ) );
+
+        outSyntaxError = syntaxError;
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::parseExpression( SubStringRef &outSubString, ExpressionVec &outExpressions,
+                                bool &outSyntaxError )
     {
         size_t expEnd = evaluateExpressionEnd( outSubString );
 
         if( expEnd == String::npos )
         {
             outSyntaxError = true;
-            return false;
+            return;
         }
 
         SubStringRef subString( &outSubString.getOriginalBuffer(), outSubString.getStart(),
@@ -704,7 +773,6 @@ namespace Ogre
         bool nextExpressionNegates = false;
 
         std::vector<Expression *> expressionParents;
-        ExpressionVec outExpressions;
         outExpressions.clear();
         outExpressions.resize( 1 );
 
@@ -781,23 +849,14 @@ namespace Ogre
             ++it;
         }
 
-        bool retVal = false;
-
         if( !expressionParents.empty() )
             syntaxError = true;
 
-        if( !syntaxError )
-            retVal = evaluateExpressionRecursive( outExpressions, syntaxError ) != 0;
-
-        if( syntaxError )
-            printf( "Syntax Error at line %lu\n", calculateLineCount( subString ) );
-
         outSyntaxError = syntaxError;
-
-        return retVal;
     }
     //-----------------------------------------------------------------------------------
-    int32 Hlms::evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError ) const
+    int32 Hlms::evaluateExpressionRecursive( ExpressionVec &expression, bool &outSyntaxError,
+                                             const ThreadData &td )
     {
         bool syntaxError = outSyntaxError;
         bool lastExpWasOperator = true;
@@ -897,13 +956,13 @@ namespace Ogre
                 if( exp.value.c_str() == endPtr )
                 {
                     // This isn't a number. Let's try if it's a variable
-                    exp.result = getProperty( exp.value );
+                    exp.result = getProperty( td.setProperties, exp.value );
                 }
                 lastExpWasOperator = false;
             }
             else
             {
-                exp.result = evaluateExpressionRecursive( exp.children, syntaxError );
+                exp.result = evaluateExpressionRecursive( exp.children, syntaxError, td );
                 lastExpWasOperator = false;
             }
 
@@ -1131,47 +1190,56 @@ namespace Ogre
         Operation( "pmin", sizeof( "@pmin" ), &minOp ), Operation( "pmax", sizeof( "@pmax" ), &maxOp )
     };
     //-----------------------------------------------------------------------------------
-    inline int Hlms::interpretAsNumberThenAsProperty( const String &argValue ) const
+    inline int Hlms::interpretAsNumberThenAsProperty( const String &argValue, const ThreadData &td )
     {
         int opValue = StringConverter::parseInt( argValue, -std::numeric_limits<int>::max() );
         if( opValue == -std::numeric_limits<int>::max() )
         {
             // Not a number, interpret as property
-            opValue = getProperty( argValue );
+            opValue = getProperty( td.setProperties, argValue );
         }
 
         return opValue;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseMath( const String &inBuffer, String &outBuffer )
+    /// Finds the next @pset & co. in subString. Returns its position relative to subString
+    /// (String::npos if there are no more) and its index in c_operations in outKeyword.
+    static size_t findNextMathOperation( const SubStringRef &subString, size_t &outKeyword )
     {
-        outBuffer.clear();
-        outBuffer.reserve( inBuffer.size() );
-
-        StringVector argValues;
-        SubStringRef subString( &inBuffer, 0 );
-
-        size_t pos;
-        pos = subString.find( "@" );
-        size_t keyword = std::numeric_limits<size_t>::max();
+        size_t pos = subString.find( "@" );
+        outKeyword = std::numeric_limits<size_t>::max();
 
-        while( pos != String::npos && keyword == std::numeric_limits<size_t>::max() )
+        while( pos != String::npos && outKeyword == std::numeric_limits<size_t>::max() )
         {
             size_t maxSize = subString.findFirstOf( " \t(", pos + 1 );
             maxSize = maxSize == String::npos ? subString.getSize() : maxSize;
-            SubStringRef keywordStr( &inBuffer, subString.getStart() + pos + 1,
+            SubStringRef keywordStr( &subString.getOriginalBuffer(), subString.getStart() + pos + 1,
                                      subString.getStart() + maxSize );
 
-            for( size_t i = 0; i < 8 && keyword == std::numeric_limits<size_t>::max(); ++i )
+            for( size_t i = 0; i < 8 && outKeyword == std::numeric_limits<size_t>::max(); ++i )
             {
                 if( keywordStr.matchEqual( c_operations[i].opName ) )
-                    keyword = i;
+                    outKeyword = i;
             }
 
-            if( keyword == std::numeric_limits<size_t>::max() )
+            if( outKeyword == std::numeric_limits<size_t>::max() )
                 pos = subString.find( "@", pos + 1 );
         }
 
+        return pos;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseMath( const String &inBuffer, String &outBuffer, ThreadData &td )
+    {
+        outBuffer.clear();
+        outBuffer.reserve( inBuffer.size() );
+
+        StringVector argValues;
+        SubStringRef subString( &inBuffer, 0 );
+
+        size_t keyword;
+        size_t pos = findNextMathOperation( subString, keyword );
+
         bool syntaxError = false;
 
         while( pos != String::npos && !syntaxError )
@@ -1188,11 +1256,11 @@ namespace Ogre
             {
                 const IdString dstProperty = argValues[0];
                 const size_t idx = argValues.size() == 3 ? 1 : 0;
-                const int op1Value = interpretAsNumberThenAsProperty( argValues[idx] );
-                const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1] );
+                const int op1Value = interpretAsNumberThenAsProperty( argValues[idx], td );
+                const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1], td );
 
                 int result = c_operations[keyword].opFunc( op1Value, op2Value );
-                setProperty( dstProperty, result );
+                setProperty( td.setProperties, dstProperty, result );
             }
             else
             {
@@ -1209,25 +1277,7 @@ namespace Ogre
                 }
             }
 
-            pos = subString.find( "@" );
-            keyword = std::numeric_limits<size_t>::max();
-
-            while( pos != String::npos && keyword == std::numeric_limits<size_t>::max() )
-            {
-                size_t maxSize = subString.findFirstOf( " \t(", pos + 1 );
-                maxSize = maxSize == String::npos ? subString.getSize() : maxSize;
-                SubStringRef keywordStr( &inBuffer, subString.getStart() + pos + 1,
-                                         subString.getStart() + maxSize );
-
-                for( size_t i = 0; i < 8 && keyword == std::numeric_limits<size_t>::max(); ++i )
-                {
-                    if( keywordStr.matchEqual( c_operations[i].opName ) )
-                        keyword = i;
-                }
-
-                if( keyword == std::numeric_limits<size_t>::max() )
-                    pos = subString.find( "@", pos + 1 );
-            }
+            pos = findNextMathOperation( subString, keyword );
         }
 
         copy( outBuffer, subString, subString.getSize() );
@@ -1235,7 +1285,7 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseForEach( const String &inBuffer, String &outBuffer ) const
+    bool Hlms::parseForEach( const String &inBuffer, String &outBuffer, const ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1265,7 +1315,7 @@ namespace Ogre
                 {
                     // This isn't a number. Let's try if it's a variable
                     // count = getProperty( argValues[0], -1 );
-                    count = getProperty( argValues[0], 0 );
+                    count = getProperty( td.setProperties, argValues[0], 0 );
                 }
 
                 /*if( count < 0 )
@@ -1288,7 +1338,7 @@ namespace Ogre
                     if( argValues[2].c_str() == endPtr )
                     {
                         // This isn't a number. Let's try if it's a variable
-                        start = static_cast<int32>( getProperty( argValues[2], -1 ) );
+                        start = static_cast<int32>( getProperty( td.setProperties, argValues[2], -1 ) );
                     }
 
                     if( start < 0 )
@@ -1319,7 +1369,7 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseProperties( String &inBuffer, String &outBuffer ) const
+    bool Hlms::parseProperties( String &inBuffer, String &outBuffer, const ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1335,7 +1385,7 @@ namespace Ogre
             copy( outBuffer, subString, pos );
 
             subString.setStart( subString.getStart() + pos + sizeof( "@property" ) );
-            bool result = evaluateExpression( subString, syntaxError );
+            bool result = evaluateExpression( subString, syntaxError, td );
 
             SubStringRef blockSubString = subString;
             bool isElse = findBlockEnd( blockSubString, syntaxError, true );
@@ -1365,13 +1415,13 @@ namespace Ogre
         while( !syntaxError && outBuffer.find( "@property" ) != String::npos )
         {
             inBuffer.swap( outBuffer );
-            syntaxError = parseProperties( inBuffer, outBuffer );
+            syntaxError = parseProperties( inBuffer, outBuffer, td );
         }
 
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseUndefPieces( String &inBuffer, String &outBuffer )
+    bool Hlms::parseUndefPieces( String &inBuffer, String &outBuffer, ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1395,9 +1445,9 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
-                    mPieces.erase( it );
+                PiecesMap::iterator it = td.pieces.find( pieceName );
+                if( it != td.pieces.end() )
+                    td.pieces.erase( it );
             }
             else
             {
@@ -1413,7 +1463,7 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::collectPieces( const String &inBuffer, String &outBuffer )
+    bool Hlms::collectPieces( const String &inBuffer, String &outBuffer, ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1437,8 +1487,8 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::const_iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
+                PiecesMap::const_iterator it = td.pieces.find( pieceName );
+                if( it != td.pieces.end() )
                 {
                     syntaxError = true;
                     printf( "Error at line %lu: @piece '%s' already defined",
@@ -1451,7 +1501,9 @@ namespace Ogre
 
                     String tmpBuffer;
                     copy( tmpBuffer, blockSubString, blockSubString.getSize() );
-                    mPieces[pieceName] = tmpBuffer;
+                    td.pieces[pieceName] = tmpBuffer;
+                    if( td.currentFile != TemplateSources::NoFile )
+                        td.pieceOrigins[pieceName] = td.currentFile;
 
                     subString.setStart( blockSubString.getEnd() + sizeof( "@end" ) );
                 }
@@ -1470,7 +1522,7 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::insertPieces( String &inBuffer, String &outBuffer ) const
+    bool Hlms::insertPieces( String &inBuffer, String &outBuffer, ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1494,9 +1546,26 @@ namespace Ogre
             if( !syntaxError )
             {
                 const IdString pieceName( argValues[0] );
-                PiecesMap::const_iterator it = mPieces.find( pieceName );
-                if( it != mPieces.end() )
+                PiecesMap::const_iterator it = td.pieces.find( pieceName );
+                if( it != td.pieces.end() )
                     outBuffer += it->second;
+
+                if( td.currentFile != TemplateSources::NoFile )
+                {
+                    if( it != td.pieces.end() )
+                    {
+                        // Pieces not in pieceOrigins came from the renderable (i.e. the properties)
+                        map<IdString, uint16>::type::const_iterator itOrigin =
+                            td.pieceOrigins.find( pieceName );
+                        if( itOrigin != td.pieceOrigins.end() )
+                            addDependency( td, itOrigin->second );
+                    }
+                    else if( std::find( td.missingPieces.begin(), td.missingPieces.end(),
+                                        pieceName ) == td.missingPieces.end() )
+                    {
+                        td.missingPieces.push_back( pieceName );
+                    }
+                }
             }
             else
             {
@@ -1520,7 +1589,7 @@ namespace Ogre
         Operation( "min", sizeof( "@min" ), &minOp ),    Operation( "max", sizeof( "@max" ), &maxOp )
     };
     //-----------------------------------------------------------------------------------
-    bool Hlms::parseCounter( const String &inBuffer, String &outBuffer )
+    bool Hlms::parseCounter( const String &inBuffer, String &outBuffer, ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
@@ -1570,7 +1639,7 @@ namespace Ogre
                 {
                     const IdString dstProperty = argValues[0];
                     const IdString srcProperty = dstProperty;
-                    int op1Value = getProperty( srcProperty );
+                    int op1Value = getProperty( td.setProperties, srcProperty );
 
                     //@value & @counter write, the others are invisible
                     char tmp[16];
@@ -1580,18 +1649,18 @@ namespace Ogre
                     if( keyword == 0 )
                     {
                         ++op1Value;
-                        setProperty( dstProperty, op1Value );
+                        setProperty( td.setProperties, dstProperty, op1Value );
                     }
                 }
                 else
                 {
                     const IdString dstProperty = argValues[0];
                     const size_t idx = argValues.size() == 3 ? 1 : 0;
-                    const int op1Value = interpretAsNumberThenAsProperty( argValues[idx] );
-                    const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1] );
+                    const int op1Value = interpretAsNumberThenAsProperty( argValues[idx], td );
+                    const int op2Value = interpretAsNumberThenAsProperty( argValues[idx + 1], td );
 
                     int result = c_counterOperations[keyword].opFunc( op1Value, op2Value );
-                    setProperty( dstProperty, result );
+                    setProperty( td.setProperties, dstProperty, result );
                 }
             }
             else
@@ -1635,151 +1704,801 @@ namespace Ogre
         return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    bool Hlms::parse( const String &inBuffer, String &outBuffer ) const
+    bool Hlms::parse( const String &inBuffer, String &outBuffer, const ThreadData &td )
     {
         outBuffer.clear();
         outBuffer.reserve( inBuffer.size() );
 
-        return parseForEach( inBuffer, outBuffer );
+        return parseForEach( inBuffer, outBuffer, td );
         // return parseProperties( inBuffer, outBuffer );
     }
     //-----------------------------------------------------------------------------------
-    uint32 Hlms::addRenderableCache( const HlmsPropertyVec &renderableSetProperties,
-                                     const PiecesMap *pieces )
-    {
-        assert( mRenderableCache.size() <= HlmsBits::RenderableMask );
-
-        RenderableCache cacheEntry( renderableSetProperties, pieces );
-
-        RenderableCacheVec::iterator it =
-            std::find( mRenderableCache.begin(), mRenderableCache.end(), cacheEntry );
-        if( it == mRenderableCache.end() )
-        {
-            mRenderableCache.push_back( cacheEntry );
-            it = mRenderableCache.end() - 1;
-        }
-
-        // 3 bits for mType (see getMaterial)
-        return ( static_cast<uint32>( mType ) << HlmsBits::HlmsTypeShift ) |
-               ( static_cast<uint32>( it - mRenderableCache.begin() ) << HlmsBits::RenderableShift );
-    }
-    //-----------------------------------------------------------------------------------
-    const Hlms::RenderableCache &Hlms::getRenderableCache( uint32 hash ) const
-    {
-        return mRenderableCache[( hash >> HlmsBits::RenderableShift ) & HlmsBits::RenderableMask];
-    }
-    //-----------------------------------------------------------------------------------
-    HlmsDatablock *Hlms::createDefaultDatablock()
+    Hlms::CompiledTemplate::CompiledTemplate() :
+        mathSyntaxError( false ),
+        isCompiled( false ),
+        firstNode( NoNode )
     {
-        return createDatablock( IdString(), "[Default]", HlmsMacroblock(), HlmsBlendblock(),
-                                HlmsParamVec(), false );
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::setPrecisionMode( PrecisionMode precisionMode )
+    Hlms::CompiledTemplate::Arg Hlms::compileArg( const String &argValue, bool parseInt )
     {
-        if( mPrecisionMode != precisionMode )
+        CompiledTemplate::Arg arg;
+        if( parseInt )
         {
-            clearShaderCache();
-            mPrecisionMode = precisionMode;
+            // Same as interpretAsNumberThenAsProperty
+            arg.value = StringConverter::parseInt( argValue, -std::numeric_limits<int>::max() );
+            arg.isNumber = arg.value != -std::numeric_limits<int>::max();
+        }
+        else
+        {
+            // Same as parseForEach & evaluateExpressionRecursive
+            char *endPtr;
+            arg.value = static_cast<int32>( strtol( argValue.c_str(), &endPtr, 10 ) );
+            arg.isNumber = argValue.c_str() != endPtr;
         }
+
+        if( !arg.isNumber )
+        {
+            arg.property = argValue;
+            arg.value = 0;
+        }
+
+        return arg;
     }
     //-----------------------------------------------------------------------------------
-    Hlms::PrecisionMode Hlms::getPrecisionMode() const
+    inline int32 Hlms::getArgValue( const CompiledTemplate::Arg &arg, const ThreadData &td,
+                                    int32 defaultVal )
     {
-        return static_cast<PrecisionMode>( mPrecisionMode );
+        return arg.isNumber ? arg.value : getProperty( td.setProperties, arg.property, defaultVal );
     }
     //-----------------------------------------------------------------------------------
-    Hlms::PrecisionMode Hlms::getSupportedPrecisionMode() const
+    bool Hlms::compileMath( const String &inBuffer, CompiledTemplate &outCompiled )
     {
-        switch( mPrecisionMode )
-        {
-        case PrecisionFull32:
-            return PrecisionFull32;
+        String &outBuffer = outCompiled.text;
+        outBuffer.clear();
+        outBuffer.reserve( inBuffer.size() );
 
-        case PrecisionMidf16:
-        {
-            const RenderSystemCapabilities *capabilities = mRenderSystem->getCapabilities();
-            if( capabilities->hasCapability( RSC_SHADER_FLOAT16 ) )
-                return PrecisionMidf16;
-            else if( capabilities->hasCapability( RSC_SHADER_RELAXED_FLOAT ) )
-                return PrecisionRelaxed;
-            else
-                return PrecisionFull32;
-        }
+        StringVector argValues;
+        SubStringRef subString( &inBuffer, 0 );
 
-        case PrecisionRelaxed:
+        size_t keyword;
+        size_t pos = findNextMathOperation( subString, keyword );
+
+        bool syntaxError = false;
+
+        while( pos != String::npos && !syntaxError )
         {
-            const RenderSystemCapabilities *capabilities = mRenderSystem->getCapabilities();
-            if( capabilities->hasCapability( RSC_SHADER_RELAXED_FLOAT ) )
-                return PrecisionRelaxed;
-            else if( capabilities->hasCapability( RSC_SHADER_FLOAT16 ) )
-                return PrecisionMidf16;
+            // Copy what comes before the block
+            copy( outBuffer, subString, pos );
+
+            subString.setStart( subString.getStart() + pos + c_operations[keyword].length );
+            evaluateParamArgs( subString, argValues, syntaxError );
+
+            syntaxError |= argValues.size() < 2 || argValues.size() > 3;
+
+            if( !syntaxError )
+            {
+                const size_t idx = argValues.size() == 3 ? 1 : 0;
+
+                CompiledTemplate::MathOp mathOp;
+                mathOp.dstProperty = argValues[0];
+                mathOp.op1 = compileArg( argValues[idx], true );
+                mathOp.op2 = compileArg( argValues[idx + 1], true );
+                mathOp.operation = static_cast<uint8>( keyword );
+                outCompiled.mathOps.push_back( mathOp );
+            }
             else
-                return PrecisionFull32;
-        }
+            {
+                printf( "Syntax Error at line %lu: @%s expects two or three parameters\n",
+                        calculateLineCount( subString ), c_operations[keyword].opName );
+            }
+
+            pos = findNextMathOperation( subString, keyword );
         }
 
-        return static_cast<PrecisionMode>( mPrecisionMode );
+        copy( outBuffer, subString, subString.getSize() );
+
+        return syntaxError;
     }
     //-----------------------------------------------------------------------------------
-    int32 Hlms::getSupportedPrecisionModeHash() const
+    void Hlms::compileText( CompiledTemplate &outCompiled, const String &buffer, size_t start,
+                            size_t end, const StringVector &counterVars, uint32 &outFirstSegment,
+                            uint32 &outNumSegments )
     {
-        switch( getSupportedPrecisionMode() )
+        outFirstSegment = static_cast<uint32>( outCompiled.segments.size() );
+
+        CompiledTemplate::TextSegment segment;
+        segment.counterLevel = -1;
+
+        size_t segmentStart = start;
+
+        if( !counterVars.empty() )
         {
-        case PrecisionFull32:
-            return static_cast<int32>( HlmsBaseProp::Full32.mHash );
-        case PrecisionMidf16:
-            return static_cast<int32>( HlmsBaseProp::Midf16.mHash );
-        case PrecisionRelaxed:
-            return static_cast<int32>( HlmsBaseProp::Relaxed.mHash );
+            // Same as repeat(). The outermost @foreach replaces its counter first
+            for( size_t i = start; i < end; ++i )
+            {
+                if( buffer[i] != '@' )
+                    continue;
+
+                for( size_t level = 0u; level < counterVars.size(); ++level )
+                {
+                    const String &counterVar = counterVars[level];
+                    if( !counterVar.empty() &&
+                        buffer.compare( i + 1u, counterVar.size(), counterVar ) == 0 )
+                    {
+                        if( i > segmentStart )
+                        {
+                            segment.start = static_cast<uint32>( segmentStart );
+                            segment.length = static_cast<uint32>( i - segmentStart );
+                            segment.counterLevel = -1;
+                            outCompiled.segments.push_back( segment );
+                        }
+
+                        segment.start = 0u;
+                        segment.length = 0u;
+                        segment.counterLevel = static_cast<int32>( level );
+                        outCompiled.segments.push_back( segment );
+
+                        i += counterVar.size();
+                        segmentStart = i + 1u;
+                        break;
+                    }
+                }
+            }
         }
 
-        // Silence MSVC warning
-        return static_cast<int32>( HlmsBaseProp::Full32.mHash );
-    }
-    //-----------------------------------------------------------------------------------
-    bool Hlms::getFastShaderBuildHack() const { return mFastShaderBuildHack; }
-    //-----------------------------------------------------------------------------------
-    void Hlms::setMaxNonCasterDirectionalLights( uint16 maxLights ) { mNumLightsLimit = maxLights; }
-    //-----------------------------------------------------------------------------------
-    void Hlms::setStaticBranchingLights( bool staticBranchingLights )
-    {
-        mStaticBranchingLights = staticBranchingLights;
-    }
-    //-----------------------------------------------------------------------------------
-    void Hlms::setAreaLightForwardSettings( uint16 areaLightsApproxLimit, uint16 areaLightsLtcLimit )
-    {
-        mNumAreaApproxLightsLimit = areaLightsApproxLimit;
-        mNumAreaLtcLightsLimit = areaLightsLtcLimit;
+        if( end > segmentStart )
+        {
+            segment.start = static_cast<uint32>( segmentStart );
+            segment.length = static_cast<uint32>( end - segmentStart );
+            segment.counterLevel = -1;
+            outCompiled.segments.push_back( segment );
+        }
+
+        outNumSegments = static_cast<uint32>( outCompiled.segments.size() ) - outFirstSegment;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::saveAllTexturesFromDatablocks( const String &folderPath, set<String>::type &savedTextures,
-                                              bool saveOitd, bool saveOriginal,
-                                              HlmsTextureExportListener *listener )
+    uint32 Hlms::compileExpression( CompiledTemplate &outCompiled, const ExpressionVec &expression,
+                                    const StringVector &counterVars )
     {
-        HlmsDatablockMap::const_iterator itor = mDatablocks.begin();
-        HlmsDatablockMap::const_iterator endt = mDatablocks.end();
+        uint32 firstIdx = CompiledTemplate::NoNode;
+        uint32 lastIdx = CompiledTemplate::NoNode;
+
+        ExpressionVec::const_iterator itor = expression.begin();
+        ExpressionVec::const_iterator endt = expression.end();
 
         while( itor != endt )
         {
-            itor->second.datablock->saveTextures( folderPath, savedTextures, saveOitd, saveOriginal,
-                                                  listener );
+            CompiledTemplate::ExpressionNode node;
+            node.type = static_cast<uint8>( itor->type );
+            node.negated = itor->negated;
+            node.var.value = 0;
+            node.var.isNumber = true;
+            node.firstSegment = 0u;
+            node.numSegments = 0u;
+            node.firstChild = CompiledTemplate::NoNode;
+            node.nextSibling = CompiledTemplate::NoNode;
+
+            if( itor->type == EXPR_VAR )
+            {
+                if( !counterVars.empty() && itor->value.find( '@' ) != String::npos )
+                {
+                    const size_t start = outCompiled.varNames.size();
+                    outCompiled.varNames += itor->value;
+                    compileText( outCompiled, outCompiled.varNames, start,
+                                 outCompiled.varNames.size(), counterVars, node.firstSegment,
+                                 node.numSegments );
+                    if( node.numSegments == 1u &&
+                        outCompiled.segments[node.firstSegment].counterLevel < 0 )
+                    {
+                        // No counters after all
+                        outCompiled.segments.pop_back();
+                        outCompiled.varNames.resize( start );
+                        node.numSegments = 0u;
+                    }
+                }
+
+                if( node.numSegments == 0u )
+                    node.var = compileArg( itor->value, false );
+            }
+
+            const uint32 nodeIdx = static_cast<uint32>( outCompiled.expressions.size() );
+            outCompiled.expressions.push_back( node );
+
+            if( itor->type == EXPR_OBJECT )
+            {
+                const uint32 firstChild = compileExpression( outCompiled, itor->children, counterVars );
+                outCompiled.expressions[nodeIdx].firstChild = firstChild;
+            }
+
+            if( lastIdx == CompiledTemplate::NoNode )
+                firstIdx = nodeIdx;
+            else
+                outCompiled.expressions[lastIdx].nextSibling = nodeIdx;
+            lastIdx = nodeIdx;
+
             ++itor;
         }
+
+        return firstIdx;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::reloadFrom( Archive *newDataFolder, ArchiveVec *libraryFolders )
+    uint32 Hlms::compileBlocks( CompiledTemplate &outCompiled, size_t start, size_t end,
+                                StringVector &counterVars, bool &outFailed )
     {
-        clearShaderCache();
+        const String &text = outCompiled.text;
 
-        if( libraryFolders )
-        {
-            mLibrary.clear();
+        uint32 firstIdx = CompiledTemplate::NoNode;
+        uint32 lastIdx = CompiledTemplate::NoNode;
 
-            ArchiveVec::const_iterator itor = libraryFolders->begin();
-            ArchiveVec::const_iterator endt = libraryFolders->end();
+        StringVector argValues;
+        ExpressionVec expression;
 
-            while( itor != endt )
+        CompiledTemplate::Node node;
+        node.count.value = 0;
+        node.count.isNumber = true;
+        node.start = node.count;
+        node.counterLevel = 0u;
+        node.expression = CompiledTemplate::NoNode;
+
+        while( start < end && !outFailed )
+        {
+            SubStringRef subString( &text, start, end );
+
+            const size_t forEachPos = subString.find( "@foreach" );
+            const size_t propertyPos = subString.find( "@property" );
+            const size_t pos = std::min( forEachPos, propertyPos );
+
+            const size_t textEnd = pos == String::npos ? end : start + pos;
+
+            uint32 nodeIdx = CompiledTemplate::NoNode;
+
+            if( textEnd > start )
+            {
+                node.type = CompiledTemplate::NodeText;
+                compileText( outCompiled, text, start, textEnd, counterVars, node.firstSegment,
+                             node.numSegments );
+                node.firstChild = CompiledTemplate::NoNode;
+                node.firstElseChild = CompiledTemplate::NoNode;
+                node.nextSibling = CompiledTemplate::NoNode;
+
+                nodeIdx = static_cast<uint32>( outCompiled.nodes.size() );
+                outCompiled.nodes.push_back( node );
+
+                if( lastIdx == CompiledTemplate::NoNode )
+                    firstIdx = nodeIdx;
+                else
+                    outCompiled.nodes[lastIdx].nextSibling = nodeIdx;
+                lastIdx = nodeIdx;
+            }
+
+            if( pos == String::npos )
+                break;
+
+            bool syntaxError = false;
+
+            node.firstSegment = 0u;
+            node.numSegments = 0u;
+            node.firstChild = CompiledTemplate::NoNode;
+            node.firstElseChild = CompiledTemplate::NoNode;
+            node.nextSibling = CompiledTemplate::NoNode;
+
+            size_t blockStart, blockEnd;
+            size_t elseStart = 0u, elseEnd = 0u;
+            bool isElse = false;
+
+            if( pos == forEachPos )
+            {
+                SubStringRef argsSubString(
+                    &text, std::min( start + pos + sizeof( "@foreach" ), end ), end );
+
+                // The counters of outer @foreach would have to be replaced before
+                // reading the arguments
+                const size_t argsEnd = evaluateExpressionEnd( argsSubString );
+                if( argsEnd == String::npos ||
+                    std::find( argsSubString.begin(),
+                               argsSubString.begin() + static_cast<ptrdiff_t>( argsEnd ),
+                               '@' ) != argsSubString.begin() + static_cast<ptrdiff_t>( argsEnd ) )
+                {
+                    outFailed = true;
+                    break;
+                }
+
+                evaluateParamArgs( argsSubString, argValues, syntaxError );
+
+                SubStringRef blockSubString = argsSubString;
+                findBlockEnd( blockSubString, syntaxError );
+
+                const String counterVar = argValues.size() > 1u ? argValues[1] : String();
+
+                node.type = CompiledTemplate::NodeForEach;
+                node.count = compileArg( argValues[0], false );
+                if( argValues.size() > 2u )
+                    node.start = compileArg( argValues[2], false );
+                else
+                {
+                    node.start.property = IdString();
+                    node.start.value = 0;
+                    node.start.isNumber = true;
+                }
+                node.counterLevel = static_cast<uint32>( counterVars.size() );
+
+                // The tree can't reproduce counters whose replacement would break directives
+                // or expressions (or be matched by an inner counter), nor negative starts
+                const char *c_directives[] = { "foreach", "property", "piece", "else", "end" };
+                for( size_t i = 0; i < sizeof( c_directives ) / sizeof( c_directives[0] ); ++i )
+                {
+                    if( !counterVar.empty() &&
+                        strncmp( c_directives[i], counterVar.c_str(), counterVar.size() ) == 0 )
+                    {
+                        syntaxError = true;
+                    }
+                }
+                syntaxError |= counterVar.find_first_of( "0123456789!=<>" ) != String::npos;
+                syntaxError |= node.start.isNumber && node.start.value < 0;
+                syntaxError |= counterVars.size() >= CompiledTemplate::MaxForEachNesting;
+
+                if( syntaxError )
+                {
+                    outFailed = true;
+                    break;
+                }
+
+                if( !node.start.isNumber &&
+                    std::find( outCompiled.forEachStartProperties.begin(),
+                               outCompiled.forEachStartProperties.end(),
+                               node.start.property ) == outCompiled.forEachStartProperties.end() )
+                {
+                    outCompiled.forEachStartProperties.push_back( node.start.property );
+                }
+
+                counterVars.push_back( counterVar );
+                blockStart = blockSubString.getStart();
+                blockEnd = blockSubString.getEnd();
+                start = blockEnd + sizeof( "@end" );
+            }
+            else
+            {
+                SubStringRef exprSubString(
+                    &text, std::min( start + pos + sizeof( "@property" ), end ), end );
+
+                parseExpression( exprSubString, expression, syntaxError );
+                if( !syntaxError )
+                {
+                    // Resolves operator precedence (and checks the syntax). That doesn't depend
+                    // on the properties, thus the evaluation can be done later
+                    const ThreadData emptyThreadData;
+                    evaluateExpressionRecursive( expression, syntaxError, emptyThreadData );
+                }
+
+                SubStringRef blockSubString = exprSubString;
+                isElse = !syntaxError && findBlockEnd( blockSubString, syntaxError, true );
+
+                blockStart = blockSubString.getStart();
+                blockEnd = blockSubString.getEnd();
+                start = blockEnd + sizeof( "@end" );
+
+                if( isElse && !syntaxError )
+                {
+                    SubStringRef elseSubString(
+                        &text, std::min( blockEnd + sizeof( "@else" ), end ), end );
+                    findBlockEnd( elseSubString, syntaxError );
+                    elseStart = elseSubString.getStart();
+                    elseEnd = elseSubString.getEnd();
+                    start = elseEnd + sizeof( "@end" );
+                }
+
+                if( syntaxError )
+                {
+                    outFailed = true;
+                    break;
+                }
+
+                node.type = CompiledTemplate::NodeProperty;
+                node.expression = compileExpression( outCompiled, expression, counterVars );
+            }
+
+            start = std::min( start, end );
+
+            nodeIdx = static_cast<uint32>( outCompiled.nodes.size() );
+            outCompiled.nodes.push_back( node );
+
+            if( lastIdx == CompiledTemplate::NoNode )
+                firstIdx = nodeIdx;
+            else
+                outCompiled.nodes[lastIdx].nextSibling = nodeIdx;
+            lastIdx = nodeIdx;
+
+            const uint32 firstChild =
+                compileBlocks( outCompiled, blockStart, blockEnd, counterVars, outFailed );
+            outCompiled.nodes[nodeIdx].firstChild = firstChild;
+
+            if( isElse )
+            {
+                const uint32 firstElseChild =
+                    compileBlocks( outCompiled, elseStart, elseEnd, counterVars, outFailed );
+                outCompiled.nodes[nodeIdx].firstElseChild = firstElseChild;
+            }
+
+            if( outCompiled.nodes[nodeIdx].type == CompiledTemplate::NodeForEach )
+                counterVars.pop_back();
+        }
+
+        return firstIdx;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::compileTemplate( const String &source, CompiledTemplate &outCompiled )
+    {
+        outCompiled = CompiledTemplate();
+        outCompiled.mathSyntaxError = compileMath( source, outCompiled );
+
+        if( outCompiled.mathSyntaxError )
+            return;
+
+        const String &text = outCompiled.text;
+
+        // The parser skips the character following @end and @else. When that character starts
+        // another @end or @else, what gets skipped depends on the order the parser processes
+        // the blocks. Leave those files to the parser.
+        const char *c_blockEnds[] = { "@end", "@else" };
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            const size_t keywordLength = strlen( c_blockEnds[i] );
+            size_t pos = text.find( c_blockEnds[i] );
+            while( pos != String::npos )
+            {
+                if( pos + keywordLength < text.size() && text[pos + keywordLength] == '@' )
+                    return;
+                pos = text.find( c_blockEnds[i], pos + 1u );
+            }
+        }
+
+        StringVector counterVars;
+        bool failed = false;
+        const uint32 firstNode = compileBlocks( outCompiled, 0u, text.size(), counterVars, failed );
+
+        if( !failed )
+        {
+            outCompiled.firstNode = firstNode;
+            outCompiled.isCompiled = true;
+        }
+        else
+        {
+            outCompiled.segments.clear();
+            outCompiled.expressions.clear();
+            outCompiled.nodes.clear();
+            outCompiled.varNames.clear();
+            outCompiled.forEachStartProperties.clear();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::appendSegments( const String &buffer, const CompiledTemplate &compiled,
+                               uint32 firstSegment, uint32 numSegments, const size_t *counters,
+                               String &outBuffer )
+    {
+        const CompiledTemplate::TextSegment *segment = compiled.segments.begin() + firstSegment;
+        const CompiledTemplate::TextSegment *segmentEnd = segment + numSegments;
+
+        while( segment != segmentEnd )
+        {
+            if( segment->counterLevel < 0 )
+            {
+                outBuffer.append( buffer, segment->start, segment->length );
+            }
+            else
+            {
+                char tmp[16];
+                sprintf( tmp, "%lu", (unsigned long)counters[segment->counterLevel] );
+                outBuffer += tmp;
+            }
+            ++segment;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    int32 Hlms::evaluateCompiledExpression( const CompiledTemplate &compiled, uint32 expressionIdx,
+                                            const ThreadData &td, const size_t *counters )
+    {
+        // Same as evaluateExpressionRecursive
+        int32 retVal = 1;
+        ExpressionType nextOperation = EXPR_VAR;
+
+        while( expressionIdx != CompiledTemplate::NoNode )
+        {
+            const CompiledTemplate::ExpressionNode &node = compiled.expressions[expressionIdx];
+            const ExpressionType type = static_cast<ExpressionType>( node.type );
+
+            if( type == EXPR_VAR || type == EXPR_OBJECT )
+            {
+                int32 result;
+                if( type == EXPR_OBJECT )
+                {
+                    result = evaluateCompiledExpression( compiled, node.firstChild, td, counters );
+                }
+                else if( node.numSegments == 0u )
+                {
+                    result = getArgValue( node.var, td, 0 );
+                }
+                else
+                {
+                    String varName;
+                    appendSegments( compiled.varNames, compiled, node.firstSegment,
+                                    node.numSegments, counters, varName );
+                    result = getArgValue( compileArg( varName, false ), td, 0 );
+                }
+
+                if( node.negated )
+                    result = !result;
+
+                switch( nextOperation )
+                {
+                case EXPR_OPERATOR_OR:
+                    retVal = ( retVal != 0 ) | ( result != 0 );
+                    break;
+                case EXPR_OPERATOR_AND:
+                    retVal = ( retVal != 0 ) & ( result != 0 );
+                    break;
+                case EXPR_OPERATOR_LE:
+                    retVal = retVal < result;
+                    break;
+                case EXPR_OPERATOR_LEEQ:
+                    retVal = retVal <= result;
+                    break;
+                case EXPR_OPERATOR_EQ:
+                    retVal = retVal == result;
+                    break;
+                case EXPR_OPERATOR_NEQ:
+                    retVal = retVal != result;
+                    break;
+                case EXPR_OPERATOR_GR:
+                    retVal = retVal > result;
+                    break;
+                case EXPR_OPERATOR_GREQ:
+                    retVal = retVal >= result;
+                    break;
+                case EXPR_OBJECT:
+                case EXPR_VAR:
+                    retVal = result;
+                    break;
+                }
+            }
+
+            nextOperation = type;
+            expressionIdx = node.nextSibling;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::evaluateNodes( const CompiledTemplate &compiled, uint32 nodeIdx, const ThreadData &td,
+                              size_t *counters, String &outBuffer )
+    {
+        while( nodeIdx != CompiledTemplate::NoNode )
+        {
+            const CompiledTemplate::Node &node = compiled.nodes[nodeIdx];
+
+            switch( node.type )
+            {
+            case CompiledTemplate::NodeText:
+                appendSegments( compiled.text, compiled, node.firstSegment, node.numSegments,
+                                counters, outBuffer );
+                break;
+            case CompiledTemplate::NodeForEach:
+            {
+                const int32 count = getArgValue( node.count, td, 0 );
+                const int32 start = getArgValue( node.start, td, -1 );
+                for( int32 i = start; i < count; ++i )
+                {
+                    counters[node.counterLevel] = static_cast<size_t>( i );
+                    evaluateNodes( compiled, node.firstChild, td, counters, outBuffer );
+                }
+                break;
+            }
+            case CompiledTemplate::NodeProperty:
+                if( evaluateCompiledExpression( compiled, node.expression, td, counters ) != 0 )
+                    evaluateNodes( compiled, node.firstChild, td, counters, outBuffer );
+                else
+                    evaluateNodes( compiled, node.firstElseChild, td, counters, outBuffer );
+                break;
+            }
+
+            nodeIdx = node.nextSibling;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseCompiled( const CompiledTemplate &compiled, String &outBuffer, String &tmpBuffer,
+                              ThreadData &td, bool stopOnSyntaxError )
+    {
+        {
+            // @pset & co.
+            FastArray<CompiledTemplate::MathOp>::const_iterator itor = compiled.mathOps.begin();
+            FastArray<CompiledTemplate::MathOp>::const_iterator endt = compiled.mathOps.end();
+
+            while( itor != endt )
+            {
+                const int op1Value = getArgValue( itor->op1, td, 0 );
+                const int op2Value = getArgValue( itor->op2, td, 0 );
+
+                int result = c_operations[itor->operation].opFunc( op1Value, op2Value );
+                setProperty( td.setProperties, itor->dstProperty, result );
+                ++itor;
+            }
+        }
+
+        bool syntaxError = compiled.mathSyntaxError;
+
+        bool useTree = compiled.isCompiled;
+
+        {
+            // A negative @foreach start is a syntax error. Let the parser report it
+            FastArray<IdString>::const_iterator itor = compiled.forEachStartProperties.begin();
+            FastArray<IdString>::const_iterator endt = compiled.forEachStartProperties.end();
+
+            while( itor != endt && useTree )
+            {
+                useTree = getProperty( td.setProperties, *itor, -1 ) >= 0;
+                ++itor;
+            }
+        }
+
+        if( useTree )
+        {
+            outBuffer.clear();
+            outBuffer.reserve( compiled.text.size() );
+
+            size_t counters[CompiledTemplate::MaxForEachNesting];
+            evaluateNodes( compiled, compiled.firstNode, td, counters, outBuffer );
+        }
+        else
+        {
+            tmpBuffer = compiled.text;
+            while( ( !syntaxError || !stopOnSyntaxError ) &&
+                   tmpBuffer.find( "@foreach" ) != String::npos )
+            {
+                syntaxError |= parseForEach( tmpBuffer, outBuffer, td );
+                outBuffer.swap( tmpBuffer );
+            }
+            syntaxError |= parseProperties( tmpBuffer, outBuffer, td );
+        }
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 Hlms::addRenderableCache( const HlmsPropertyVec &renderableSetProperties,
+                                     const PiecesMap *pieces )
+    {
+        assert( mRenderableCache.size() <= HlmsBits::RenderableMask );
+
+        RenderableCache cacheEntry( renderableSetProperties, pieces );
+
+        RenderableCacheVec::iterator it =
+            std::find( mRenderableCache.begin(), mRenderableCache.end(), cacheEntry );
+        if( it == mRenderableCache.end() )
+        {
+            mRenderableCache.push_back( cacheEntry );
+            it = mRenderableCache.end() - 1;
+        }
+
+        // 3 bits for mType (see getMaterial)
+        return ( static_cast<uint32>( mType ) << HlmsBits::HlmsTypeShift ) |
+               ( static_cast<uint32>( it - mRenderableCache.begin() ) << HlmsBits::RenderableShift );
+    }
+    //-----------------------------------------------------------------------------------
+    const Hlms::RenderableCache &Hlms::getRenderableCache( uint32 hash ) const
+    {
+        return mRenderableCache[( hash >> HlmsBits::RenderableShift ) & HlmsBits::RenderableMask];
+    }
+    //-----------------------------------------------------------------------------------
+    HlmsDatablock *Hlms::createDefaultDatablock()
+    {
+        return createDatablock( IdString(), "[Default]", HlmsMacroblock(), HlmsBlendblock(),
+                                HlmsParamVec(), false );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setPrecisionMode( PrecisionMode precisionMode )
+    {
+        if( mPrecisionMode != precisionMode )
+        {
+            clearShaderCache();
+            mPrecisionMode = precisionMode;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::PrecisionMode Hlms::getPrecisionMode() const
+    {
+        return static_cast<PrecisionMode>( mPrecisionMode );
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::PrecisionMode Hlms::getSupportedPrecisionMode() const
+    {
+        switch( mPrecisionMode )
+        {
+        case PrecisionFull32:
+            return PrecisionFull32;
+
+        case PrecisionMidf16:
+        {
+            const RenderSystemCapabilities *capabilities = mRenderSystem->getCapabilities();
+            if( capabilities->hasCapability( RSC_SHADER_FLOAT16 ) )
+                return PrecisionMidf16;
+            else if( capabilities->hasCapability( RSC_SHADER_RELAXED_FLOAT ) )
+                return PrecisionRelaxed;
+            else
+                return PrecisionFull32;
+        }
+
+        case PrecisionRelaxed:
+        {
+            const RenderSystemCapabilities *capabilities = mRenderSystem->getCapabilities();
+            if( capabilities->hasCapability( RSC_SHADER_RELAXED_FLOAT ) )
+                return PrecisionRelaxed;
+            else if( capabilities->hasCapability( RSC_SHADER_FLOAT16 ) )
+                return PrecisionMidf16;
+            else
+                return PrecisionFull32;
+        }
+        }
+
+        return static_cast<PrecisionMode>( mPrecisionMode );
+    }
+    //-----------------------------------------------------------------------------------
+    int32 Hlms::getSupportedPrecisionModeHash() const
+    {
+        switch( getSupportedPrecisionMode() )
+        {
+        case PrecisionFull32:
+            return static_cast<int32>( HlmsBaseProp::Full32.mHash );
+        case PrecisionMidf16:
+            return static_cast<int32>( HlmsBaseProp::Midf16.mHash );
+        case PrecisionRelaxed:
+            return static_cast<int32>( HlmsBaseProp::Relaxed.mHash );
+        }
+
+        // Silence MSVC warning
+        return static_cast<int32>( HlmsBaseProp::Full32.mHash );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::getFastShaderBuildHack() const { return mFastShaderBuildHack; }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setMaxNonCasterDirectionalLights( uint16 maxLights ) { mNumLightsLimit = maxLights; }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setStaticBranchingLights( bool staticBranchingLights )
+    {
+        mStaticBranchingLights = staticBranchingLights;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setAreaLightForwardSettings( uint16 areaLightsApproxLimit, uint16 areaLightsLtcLimit )
+    {
+        mNumAreaApproxLightsLimit = areaLightsApproxLimit;
+        mNumAreaLtcLightsLimit = areaLightsLtcLimit;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::saveAllTexturesFromDatablocks( const String &folderPath, set<String>::type &savedTextures,
+                                              bool saveOitd, bool saveOriginal,
+                                              HlmsTextureExportListener *listener )
+    {
+        HlmsDatablockMap::const_iterator itor = mDatablocks.begin();
+        HlmsDatablockMap::const_iterator endt = mDatablocks.end();
+
+        while( itor != endt )
+        {
+            itor->second.datablock->saveTextures( folderPath, savedTextures, saveOitd, saveOriginal,
+                                                  listener );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::reloadFrom( Archive *newDataFolder, ArchiveVec *libraryFolders )
+    {
+        clearShaderCache();
+
+        if( libraryFolders )
+        {
+            mLibrary.clear();
+
+            ArchiveVec::const_iterator itor = libraryFolders->begin();
+            ArchiveVec::const_iterator endt = libraryFolders->end();
+
+            while( itor != endt )
             {
                 Library library;
                 library.dataFolder = *itor;
@@ -1974,6 +2693,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Hlms::clearShaderCache()
     {
+        // The worker threads may be reading mTemplateSources
+        waitForAsyncShaderGeneration();
+
         mPassCache.clear();
 
         // Empty mShaderCache so that mHlmsManager->destroyMacroblock would
@@ -1996,9 +2718,159 @@ namespace Ogre
         shaderCache.clear();
 
         mShaderCodeCache.clear();
+        mPendingShaderCode.clear();
+        mPendingFinalHashes.clear();
+        mAsyncShaderCode.clear();
+        mAsyncGeneratedShaderCode.clear();
+
+        // Templates may have changed on disk (e.g. hot reload)
+        if( mTemplateSources )
+        {
+            OGRE_DELETE_T( mTemplateSources, TemplateSources, MEMCATEGORY_GENERAL );
+            mTemplateSources = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::processPieces( const TemplateSources &sources, ShaderType shaderType,
+                              ThreadData &td, bool useCompiledTemplates )
+    {
+        String inString;
+        String outString;
+
+        const StringVector &pieceFiles = sources.pieceFiles[shaderType];
+        const size_t numPieceFiles = pieceFiles.size();
+
+        for( size_t i = 0; i < numPieceFiles; ++i )
+        {
+            td.currentFile = sources.pieceFileIds[shaderType][i];
+
+            if( useCompiledTemplates )
+            {
+                parseCompiled( sources.compiledPieceFiles[shaderType][i], inString, outString, td,
+                               false );
+            }
+            else
+            {
+                parseMath( pieceFiles[i], outString, td );
+                while( outString.find( "@foreach" ) != String::npos )
+                {
+                    parseForEach( outString, inString, td );
+                    inString.swap( outString );
+                }
+                parseProperties( outString, inString, td );
+            }
+            parseUndefPieces( inString, outString, td );
+            collectPieces( outString, inString, td );
+            parseCounter( inString, outString, td );
+        }
+
+        td.currentFile = TemplateSources::NoFile;
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::ThreadData::ThreadData() : currentFile( TemplateSources::NoFile ) {}
+    //-----------------------------------------------------------------------------------
+    Hlms::TemplateSources::TemplateSources()
+    {
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            hasTemplate[i] = false;
+            templateFileId[i] = NoFile;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    static bool modifiesProperties( const String &contents )
+    {
+        const char *c_directives[] = { "@set",  "@add",  "@sub",  "@mul",  "@div",    "@mod",
+                                       "@min",  "@max",  "@pset", "@padd", "@psub",   "@pmul",
+                                       "@pdiv", "@pmod", "@pmin", "@pmax", "@counter", "@undefpiece" };
+
+        for( size_t i = 0; i < sizeof( c_directives ) / sizeof( c_directives[0] ); ++i )
+        {
+            if( contents.find( c_directives[i] ) != String::npos )
+                return true;
+        }
+
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    uint16 Hlms::TemplateSources::addFile( const String &fileName, const String &contents )
+    {
+        uint16 fileId = findFile( fileName );
+        if( fileId == NoFile )
+        {
+            OGRE_ASSERT_LOW( fileNames.size() < NoFile && "Too many template files" );
+
+            fileId = static_cast<uint16>( fileNames.size() );
+            fileNames.push_back( fileName );
+
+            uint64 hashResult[2];
+            memset( hashResult, 0, sizeof( hashResult ) );
+            OGRE_HASH128_FUNC( contents.c_str(), static_cast<int>( contents.size() ), IdString::Seed,
+                               hashResult );
+            fileHashes.push_back( hashResult[0] );
+            fileHashes.push_back( hashResult[1] );
+
+            fileModifiesProperties.push_back( modifiesProperties( contents ) ? 1u : 0u );
+        }
+        return fileId;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::addDependency( ThreadData &td, uint16 fileId )
+    {
+        if( std::find( td.dependencies.begin(), td.dependencies.end(), fileId ) ==
+            td.dependencies.end() )
+        {
+            td.dependencies.push_back( fileId );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::storeDependencies( ThreadData &td, ShaderCodeCache &codeCache )
+    {
+        std::sort( td.dependencies.begin(), td.dependencies.end() );
+        codeCache.templateDependencies.swap( td.dependencies );
+        codeCache.missingPieces.swap( td.missingPieces );
+        td.dependencies.clear();
+        td.missingPieces.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    uint16 Hlms::TemplateSources::findFile( const String &fileName ) const
+    {
+        StringVector::const_iterator itor = std::find( fileNames.begin(), fileNames.end(), fileName );
+        if( itor == fileNames.end() )
+            return NoFile;
+        return static_cast<uint16>( itor - fileNames.begin() );
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::processPieces( Archive *archive, const StringVector &pieceFiles )
+    Hlms::PendingShaderCode::PendingShaderCode( const ShaderCodeCache &_codeCache ) :
+        codeCache( _codeCache ),
+        generationTimeUs( 0 )
+    {
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            syntaxError[i] = false;
+    }
+    //-----------------------------------------------------------------------------------
+    Hlms::ShaderGenerationStats::ShaderGenerationStats() :
+        numVariants( 0 ),
+        numParallelVariants( 0 ),
+        generationTimeUs( 0 ),
+        compileTimeUs( 0 ),
+        numSkippedRenderables( 0 )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::ShaderGenerationStats::reset()
+    {
+        numVariants = 0;
+        numParallelVariants = 0;
+        generationTimeUs = 0;
+        compileTimeUs = 0;
+        variantTimeUs.clear();
+        numSkippedRenderables = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::readPieceFiles( Archive *archive, const StringVector &pieceFiles,
+                               const String &shaderFileExt, const String &fileNamePrefix,
+                               ShaderType shaderType, TemplateSources &sources )
     {
         StringVector::const_iterator itor = pieceFiles.begin();
         StringVector::const_iterator endt = pieceFiles.end();
@@ -2006,34 +2878,86 @@ namespace Ogre
         while( itor != endt )
         {
             // Only open piece files with current render system extension
-            const String::size_type extPos0 = itor->find( mShaderFileExt );
+            const String::size_type extPos0 = itor->find( shaderFileExt );
             const String::size_type extPos1 = itor->find( ".any" );
-            if( extPos0 == itor->size() - mShaderFileExt.size() || extPos1 == itor->size() - 4u )
+            if( extPos0 == itor->size() - shaderFileExt.size() || extPos1 == itor->size() - 4u )
             {
                 DataStreamPtr inFile = archive->open( *itor );
+                sources.pieceFiles[shaderType].push_back( String() );
+                String &contents = sources.pieceFiles[shaderType].back();
+                contents.resize( inFile->size() );
+                if( !contents.empty() )
+                    inFile->read( &contents[0], inFile->size() );
+
+                sources.pieceFileIds[shaderType].push_back(
+                    sources.addFile( fileNamePrefix + *itor, contents ) );
 
-                String inString;
-                String outString;
+                sources.compiledPieceFiles[shaderType].push_back( CompiledTemplate() );
+                compileTemplate( contents, sources.compiledPieceFiles[shaderType].back() );
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::loadTemplateSources()
+    {
+        if( mTemplateSources )
+            return;
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
+        TemplateSources *sources = OGRE_NEW_T( TemplateSources, MEMCATEGORY_GENERAL );
 
-                this->parseMath( inString, outString );
-                while( outString.find( "@foreach" ) != String::npos )
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            const String filename = ShaderFiles[i] + mShaderFileExt;
+            if( mDataFolder->exists( filename ) )
+            {
+                sources->hasTemplate[i] = true;
+
+                // Library piece files first
+                LibraryVec::const_iterator itor = mLibrary.begin();
+                LibraryVec::const_iterator endt = mLibrary.end();
+
+                while( itor != endt )
                 {
-                    this->parseForEach( outString, inString );
-                    inString.swap( outString );
+                    const String prefix =
+                        "Library" + StringConverter::toString( itor - mLibrary.begin() ) + "/";
+                    readPieceFiles( itor->dataFolder, itor->pieceFiles[i], mShaderFileExt, prefix,
+                                    static_cast<ShaderType>( i ), *sources );
+                    ++itor;
                 }
-                this->parseProperties( outString, inString );
-                this->parseUndefPieces( inString, outString );
-                this->collectPieces( outString, inString );
-                this->parseCounter( inString, outString );
+
+                // Main piece files
+                readPieceFiles( mDataFolder, mPieceFiles[i], mShaderFileExt, BLANKSTRING,
+                                static_cast<ShaderType>( i ), *sources );
+
+                // The shader file
+                DataStreamPtr inFile = mDataFolder->open( filename );
+                String &templateFile = sources->templateFile[i];
+                templateFile.resize( inFile->size() );
+                if( !templateFile.empty() )
+                    inFile->read( &templateFile[0], inFile->size() );
+
+                sources->templateFileId[i] =
+                    sources->addFile( filename, templateFile );
+
+                compileTemplate( templateFile, sources->compiledTemplate[i] );
             }
-            ++itor;
         }
+
+        mTemplateSources = sources;
     }
     //-----------------------------------------------------------------------------------
     void Hlms::dumpProperties( std::ofstream &outFile )
+    {
+        ThreadData td;
+        td.setProperties.swap( mSetProperties );
+        td.pieces.swap( mPieces );
+        dumpProperties( outFile, td );
+        td.setProperties.swap( mSetProperties );
+        td.pieces.swap( mPieces );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::dumpProperties( std::ofstream &outFile, const ThreadData &td ) const
     {
         outFile.write( "#if 0", sizeof( "#if 0" ) - 1u );
 
@@ -2042,8 +2966,8 @@ namespace Ogre
         LwString value( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
 
         {
-            HlmsPropertyVec::const_iterator itor = mSetProperties.begin();
-            HlmsPropertyVec::const_iterator endt = mSetProperties.end();
+            HlmsPropertyVec::const_iterator itor = td.setProperties.begin();
+            HlmsPropertyVec::const_iterator endt = td.setProperties.end();
 
             while( itor != endt )
             {
@@ -2063,8 +2987,8 @@ namespace Ogre
         outFile.write( "\n\tDONE DUMPING PROPERTIES", sizeof( "\n\tDONE DUMPING PROPERTIES" ) - 1u );
 
         {
-            PiecesMap::const_iterator itor = mPieces.begin();
-            PiecesMap::const_iterator endt = mPieces.end();
+            PiecesMap::const_iterator itor = td.pieces.begin();
+            PiecesMap::const_iterator endt = td.pieces.end();
 
             while( itor != endt )
             {
@@ -2210,113 +3134,169 @@ namespace Ogre
         mShaderCodeCache.push_back( codeCache );
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::compileShaderCode( ShaderCodeCache &codeCache )
+    bool Hlms::expandTemplate( ShaderType shaderType, uint32 finalHash, ThreadData &td,
+                               String &outSource, String &outDebugFilenameOutput ) const
     {
-        OgreProfileExhaustive( "Hlms::compileShaderCode" );
+        HlmsPropertyVec &properties = td.setProperties;
 
-        // Give the shaders friendly base-10 names
-        const uint32 finalHash = mType * 100000000u + static_cast<uint32>( mShaderCodeCache.size() );
-
-        mSetProperties = codeCache.mergedCache.setProperties;
-
-        // Generate the shaders
-        for( size_t i = 0; i < NumShaderTypes; ++i )
+        if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
         {
-            // Collect pieces
-            mPieces = codeCache.mergedCache.pieces[i];
-
-            const String filename = ShaderFiles[i] + mShaderFileExt;
-            if( mDataFolder->exists( filename ) )
-            {
-                if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
-                {
-                    setProperty( HlmsBaseProp::GL3Plus,
-                                 mRenderSystem->getNativeShadingLanguageVersion() );
-                }
-                else if( mShaderProfile == "glsles" )  // TODO: String comparision
-                {
-                    setProperty( HlmsBaseProp::GLES, mRenderSystem->getNativeShadingLanguageVersion() );
-                }
+            setProperty( properties, HlmsBaseProp::GL3Plus,
+                         mRenderSystem->getNativeShadingLanguageVersion() );
+        }
+        else if( mShaderProfile == "glsles" )  // TODO: String comparision
+        {
+            setProperty( properties, HlmsBaseProp::GLES,
+                         mRenderSystem->getNativeShadingLanguageVersion() );
+        }
 
-                setProperty( HlmsBaseProp::Syntax, static_cast<int32>( mShaderSyntax.mHash ) );
-                setProperty( HlmsBaseProp::Hlsl, static_cast<int32>( HlmsBaseProp::Hlsl.mHash ) );
-                setProperty( HlmsBaseProp::Glsl, static_cast<int32>( HlmsBaseProp::Glsl.mHash ) );
-                setProperty( HlmsBaseProp::Glsles, static_cast<int32>( HlmsBaseProp::Glsles.mHash ) );
-                setProperty( HlmsBaseProp::Glslvk, static_cast<int32>( HlmsBaseProp::Glslvk.mHash ) );
-                setProperty( HlmsBaseProp::Hlslvk, static_cast<int32>( HlmsBaseProp::Hlslvk.mHash ) );
-                setProperty( HlmsBaseProp::Metal, static_cast<int32>( HlmsBaseProp::Metal.mHash ) );
+        setProperty( properties, HlmsBaseProp::Syntax, static_cast<int32>( mShaderSyntax.mHash ) );
+        setProperty( properties, HlmsBaseProp::Hlsl, static_cast<int32>( HlmsBaseProp::Hlsl.mHash ) );
+        setProperty( properties, HlmsBaseProp::Glsl, static_cast<int32>( HlmsBaseProp::Glsl.mHash ) );
+        setProperty( properties, HlmsBaseProp::Glsles,
+                     static_cast<int32>( HlmsBaseProp::Glsles.mHash ) );
+        setProperty( properties, HlmsBaseProp::Glslvk,
+                     static_cast<int32>( HlmsBaseProp::Glslvk.mHash ) );
+        setProperty( properties, HlmsBaseProp::Hlslvk,
+                     static_cast<int32>( HlmsBaseProp::Hlslvk.mHash ) );
+        setProperty( properties, HlmsBaseProp::Metal, static_cast<int32>( HlmsBaseProp::Metal.mHash ) );
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
-                setProperty( HlmsBaseProp::iOS, 1 );
+        setProperty( properties, HlmsBaseProp::iOS, 1 );
 #endif
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
-                setProperty( HlmsBaseProp::macOS, 1 );
+        setProperty( properties, HlmsBaseProp::macOS, 1 );
 #endif
-                setProperty( HlmsBaseProp::Full32, static_cast<int32>( HlmsBaseProp::Full32.mHash ) );
-                setProperty( HlmsBaseProp::Midf16, static_cast<int32>( HlmsBaseProp::Midf16.mHash ) );
-                setProperty( HlmsBaseProp::Relaxed, static_cast<int32>( HlmsBaseProp::Relaxed.mHash ) );
-                setProperty( HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
+        setProperty( properties, HlmsBaseProp::Full32,
+                     static_cast<int32>( HlmsBaseProp::Full32.mHash ) );
+        setProperty( properties, HlmsBaseProp::Midf16,
+                     static_cast<int32>( HlmsBaseProp::Midf16.mHash ) );
+        setProperty( properties, HlmsBaseProp::Relaxed,
+                     static_cast<int32>( HlmsBaseProp::Relaxed.mHash ) );
+        setProperty( properties, HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
+
+        if( mFastShaderBuildHack )
+            setProperty( properties, HlmsBaseProp::FastShaderBuildHack, 1 );
+
+        std::ofstream debugDumpFile;
+        if( mDebugOutput )
+        {
+            outDebugFilenameOutput = mOutputPath + "./" + StringConverter::toString( finalHash ) +
+                                     ShaderFiles[shaderType] + mShaderFileExt;
+            debugDumpFile.open( Ogre::fileSystemPathFromString( outDebugFilenameOutput ).c_str(),
+                                std::ios::out | std::ios::binary );
+
+            // We need to dump the properties before processing the files, as these
+            // may be overwritten or polluted by the files, thus hiding why we
+            // got this permutation.
+            if( mDebugOutputProperties )
+                dumpProperties( debugDumpFile, td );
+        }
 
-                if( mFastShaderBuildHack )
-                    setProperty( HlmsBaseProp::FastShaderBuildHack, 1 );
+        {
+            // The template always affects the output. So do the piece files that
+            // modify properties, whether their pieces get inserted or not.
+            addDependency( td, mTemplateSources->templateFileId[shaderType] );
 
-                String debugFilenameOutput;
-                std::ofstream debugDumpFile;
-                if( mDebugOutput )
-                {
-                    debugFilenameOutput = mOutputPath + "./" + StringConverter::toString( finalHash ) +
-                                          ShaderFiles[i] + mShaderFileExt;
-                    debugDumpFile.open( Ogre::fileSystemPathFromString( debugFilenameOutput ).c_str(),
-                                        std::ios::out | std::ios::binary );
+            FastArray<uint16>::const_iterator itor =
+                mTemplateSources->pieceFileIds[shaderType].begin();
+            FastArray<uint16>::const_iterator endt = mTemplateSources->pieceFileIds[shaderType].end();
 
-                    // We need to dump the properties before processing the files, as these
-                    // may be overwritten or polluted by the files, thus hiding why we
-                    // got this permutation.
-                    if( mDebugOutputProperties )
-                        dumpProperties( debugDumpFile );
-                }
+            while( itor != endt )
+            {
+                if( mTemplateSources->fileModifiesProperties[*itor] )
+                    addDependency( td, *itor );
+                ++itor;
+            }
+        }
 
-                // Library piece files first
-                LibraryVec::const_iterator itor = mLibrary.begin();
-                LibraryVec::const_iterator endt = mLibrary.end();
+        const bool syntaxError =
+            preprocessTemplate( *mTemplateSources, shaderType, td, outSource, mUseCompiledTemplates );
 
-                while( itor != endt )
-                {
-                    processPieces( itor->dataFolder, itor->pieceFiles[i] );
-                    ++itor;
-                }
+        // Now dump the processed file.
+        if( mDebugOutput )
+        {
+            debugDumpFile.write( &outSource[0], static_cast<std::streamsize>( outSource.size() ) );
+        }
 
-                // Main piece files
-                processPieces( mDataFolder, mPieceFiles[i] );
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::preprocessTemplate( const TemplateSources &sources, ShaderType shaderType,
+                                   ThreadData &td, String &outSource, bool useCompiledTemplates )
+    {
+        // Library piece files first, then the main ones
+        td.pieceOrigins.clear();
+        processPieces( sources, shaderType, td, useCompiledTemplates );
 
-                // Generate the shader file.
-                DataStreamPtr inFile = mDataFolder->open( filename );
+        // Generate the shader file.
+        td.currentFile = sources.templateFileId[shaderType];
+        String inString;
+
+        bool syntaxError = false;
+
+        if( useCompiledTemplates )
+        {
+            syntaxError |=
+                parseCompiled( sources.compiledTemplate[shaderType], inString, outSource, td, true );
+        }
+        else
+        {
+            inString = sources.templateFile[shaderType];
 
-                String inString;
-                String outString;
+            syntaxError |= parseMath( inString, outSource, td );
+            while( !syntaxError && outSource.find( "@foreach" ) != String::npos )
+            {
+                syntaxError |= parseForEach( outSource, inString, td );
+                inString.swap( outSource );
+            }
+            syntaxError |= parseProperties( outSource, inString, td );
+        }
+        syntaxError |= parseUndefPieces( inString, outSource, td );
+        while( !syntaxError && ( outSource.find( "@piece" ) != String::npos ||
+                                 outSource.find( "@insertpiece" ) != String::npos ) )
+        {
+            syntaxError |= collectPieces( outSource, inString, td );
+            syntaxError |= insertPieces( inString, outSource, td );
+        }
+        syntaxError |= parseCounter( outSource, inString, td );
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
+        td.currentFile = TemplateSources::NoFile;
 
-                bool syntaxError = false;
+        outSource.swap( inString );
 
-                syntaxError |= this->parseMath( inString, outString );
-                while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-                {
-                    syntaxError |= this->parseForEach( outString, inString );
-                    inString.swap( outString );
-                }
-                syntaxError |= this->parseProperties( outString, inString );
-                syntaxError |= this->parseUndefPieces( inString, outString );
-                while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
-                                         outString.find( "@insertpiece" ) != String::npos ) )
-                {
-                    syntaxError |= this->collectPieces( outString, inString );
-                    syntaxError |= this->insertPieces( inString, outString );
-                }
-                syntaxError |= this->parseCounter( outString, inString );
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::compileShaderCode( ShaderCodeCache &codeCache )
+    {
+        OgreProfileExhaustive( "Hlms::compileShaderCode" );
+
+        uint64 generationTime = 0u;
+        const uint64 startTime = mTimer->getMicroseconds();
+
+        // Give the shaders friendly base-10 names
+        const uint32 finalHash = mType * 100000000u + static_cast<uint32>( mShaderCodeCache.size() );
+
+        loadTemplateSources();
 
-                outString.swap( inString );
+        ThreadData td;
+        td.setProperties = codeCache.mergedCache.setProperties;
+
+        // Generate the shaders
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( mTemplateSources->hasTemplate[i] )
+            {
+                // Collect pieces
+                td.pieces = codeCache.mergedCache.pieces[i];
+
+                String source;
+                String debugFilenameOutput;
+                const uint64 generationStart = mTimer->getMicroseconds();
+                const bool syntaxError = expandTemplate( static_cast<ShaderType>( i ), finalHash, td,
+                                                         source, debugFilenameOutput );
+                generationTime += mTimer->getMicroseconds() - generationStart;
 
                 if( syntaxError )
                 {
@@ -2325,34 +3305,39 @@ namespace Ogre
                         StringConverter::toString( finalHash ) + ShaderFiles[i] );
                 }
 
-                // Now dump the processed file.
-                if( mDebugOutput )
-                {
-                    debugDumpFile.write( &outString[0],
-                                         static_cast<std::streamsize>( outString.size() ) );
-                }
-
                 // Don't create and compile if template requested not to
-                if( !getProperty( HlmsBaseProp::DisableStage ) )
+                if( !getProperty( td.setProperties, HlmsBaseProp::DisableStage ) )
                 {
-                    codeCache.shaders[i] = compileShaderCode( outString, debugFilenameOutput, finalHash,
+                    // compileShaderCode & setupRootLayout read mSetProperties
+                    mSetProperties.swap( td.setProperties );
+                    codeCache.shaders[i] = compileShaderCode( source, debugFilenameOutput, finalHash,
                                                               static_cast<ShaderType>( i ) );
+                    mSetProperties.swap( td.setProperties );
                 }
 
                 // Reset the disable flag.
-                setProperty( HlmsBaseProp::DisableStage, 0 );
+                setProperty( td.setProperties, HlmsBaseProp::DisableStage, 0 );
             }
         }
 
+        // Leave the properties modified by the templates in mSetProperties,
+        // derived implementations may want to look at them
+        mSetProperties.swap( td.setProperties );
+
+        storeDependencies( td, codeCache );
+
         mShaderCodeCache.push_back( codeCache );
+
+        const uint64 elapsedTime = mTimer->getMicroseconds() - startTime;
+        ++mCurrentFrameStats.numVariants;
+        mCurrentFrameStats.generationTimeUs += generationTime;
+        mCurrentFrameStats.compileTimeUs += elapsedTime - generationTime;
+        mCurrentFrameStats.variantTimeUs.push_back( static_cast<uint32>( elapsedTime ) );
     }
     //-----------------------------------------------------------------------------------
-    const HlmsCache *Hlms::createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
-                                                   uint32 finalHash,
-                                                   const QueuedRenderable &queuedRenderable )
+    void Hlms::mergeShaderCacheEntryProperties( uint32 renderableHash, const HlmsCache &passCache,
+                                                const QueuedRenderable &queuedRenderable )
     {
-        OgreProfileExhaustive( "Hlms::createShaderCacheEntry" );
-
         // Set the properties by merging the cache from the pass, with the cache from renderable
         mSetProperties.clear();
         // If retVal is null, we did something wrong earlier
@@ -2392,11 +3377,75 @@ namespace Ogre
                                                       renderableCache.pieces, mSetProperties,
                                                       queuedRenderable );
 
-        // Retrieve the shader code from the code cache
-        ShaderCodeCache codeCache( renderableCache.pieces );
         unsetProperty( HlmsPsoProp::Macroblock );
         unsetProperty( HlmsPsoProp::Blendblock );
         unsetProperty( HlmsPsoProp::InputLayoutId );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::containsShaderCode( const PendingShaderCodeVec &pendingShaderCode,
+                                   const ShaderCodeCache      &codeCache )
+    {
+        PendingShaderCodeVec::const_iterator itor = pendingShaderCode.begin();
+        PendingShaderCodeVec::const_iterator endt = pendingShaderCode.end();
+
+        while( itor != endt && !( itor->codeCache == codeCache ) )
+            ++itor;
+
+        return itor != endt;
+    }
+    //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::createShaderCacheEntryAsync( uint32 renderableHash,
+                                                        const HlmsCache &passCache, uint32 finalHash,
+                                                        const QueuedRenderable &queuedRenderable )
+    {
+        OgreProfileExhaustive( "Hlms::createShaderCacheEntryAsync" );
+
+        mergeShaderCacheEntryProperties( renderableHash, passCache, queuedRenderable );
+
+        const RenderableCache &renderableCache = getRenderableCache( renderableHash );
+        ShaderCodeCache codeCache( renderableCache.pieces );
+        codeCache.mergedCache.setProperties.swap( mSetProperties );
+
+        if( std::find( mShaderCodeCache.begin(), mShaderCodeCache.end(), codeCache ) !=
+            mShaderCodeCache.end() )
+        {
+            // Shaders are ready. Creating the PSO is cheap enough. The properties are
+            // already merged; don't merge them (nor notify the listener) again.
+            codeCache.mergedCache.setProperties.swap( mSetProperties );
+            mShaderCacheEntryPropertiesMerged = true;
+            return createShaderCacheEntry( renderableHash, passCache, finalHash, queuedRenderable );
+        }
+
+        // mAsyncGeneratingShaderCode is being written by the worker threads, but not
+        // the part operator== reads.
+        if( !containsShaderCode( mAsyncShaderCode, codeCache ) &&
+            !containsShaderCode( mAsyncGeneratingShaderCode, codeCache ) &&
+            !containsShaderCode( mAsyncGeneratedShaderCode, codeCache ) )
+        {
+            // The worker threads must not touch the Archives
+            loadTemplateSources();
+            mAsyncShaderCode.push_back( PendingShaderCode( codeCache ) );
+        }
+
+        ++mCurrentFrameStats.numSkippedRenderables;
+
+        return 0;
+    }
+    //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
+                                                   uint32 finalHash,
+                                                   const QueuedRenderable &queuedRenderable )
+    {
+        OgreProfileExhaustive( "Hlms::createShaderCacheEntry" );
+
+        if( mShaderCacheEntryPropertiesMerged )
+            mShaderCacheEntryPropertiesMerged = false;
+        else
+            mergeShaderCacheEntryProperties( renderableHash, passCache, queuedRenderable );
+
+        // Retrieve the shader code from the code cache
+        const RenderableCache &renderableCache = getRenderableCache( renderableHash );
+        ShaderCodeCache codeCache( renderableCache.pieces );
         codeCache.mergedCache.setProperties.swap( mSetProperties );
         {
             ShaderCodeCacheVec::iterator itCodeCache =
@@ -3391,14 +4440,263 @@ namespace Ogre
 
             if( !lastReturnedValue )
             {
-                lastReturnedValue =
-                    createShaderCacheEntry( hash[0], passCache, finalHash, queuedRenderable );
+                if( mAsyncShaderCompilation && mDataFolder )
+                {
+                    lastReturnedValue =
+                        createShaderCacheEntryAsync( hash[0], passCache, finalHash, queuedRenderable );
+                }
+                else
+                {
+                    lastReturnedValue =
+                        createShaderCacheEntry( hash[0], passCache, finalHash, queuedRenderable );
+                }
             }
         }
 
         return lastReturnedValue;
     }
     //-----------------------------------------------------------------------------------
+    void Hlms::setParallelShaderGeneration( bool bParallel )
+    {
+        mParallelShaderGeneration = bParallel;
+        if( !mParallelShaderGeneration )
+        {
+            mPendingShaderCode.clear();
+            mPendingFinalHashes.clear();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setParallelCommandGeneration( bool bParallel )
+    {
+        mParallelCommandGeneration = bParallel;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_queueShaderGeneration( const HlmsCache &passCache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass )
+    {
+        if( !mParallelShaderGeneration || mAsyncShaderCompilation || !mDataFolder )
+            return;
+
+        const uint32 renderableHash = casterPass ? queuedRenderable.renderable->getHlmsCasterHash()
+                                                 : queuedRenderable.renderable->getHlmsHash();
+        const uint32 finalHash = renderableHash | passCache.hash;
+
+        if( getShaderCache( finalHash ) )
+            return;  // PSO already exists
+
+        FastArray<uint32>::iterator itHash =
+            std::lower_bound( mPendingFinalHashes.begin(), mPendingFinalHashes.end(), finalHash );
+        if( itHash != mPendingFinalHashes.end() && *itHash == finalHash )
+            return;  // Already scheduled
+        mPendingFinalHashes.insert( itHash, finalHash );
+
+        mergeShaderCacheEntryProperties( renderableHash, passCache, queuedRenderable );
+
+        const RenderableCache &renderableCache = getRenderableCache( renderableHash );
+        ShaderCodeCache codeCache( renderableCache.pieces );
+        codeCache.mergedCache.setProperties.swap( mSetProperties );
+
+        // Different PSOs often share the same shaders (e.g. only the macroblock differs)
+        if( std::find( mShaderCodeCache.begin(), mShaderCodeCache.end(), codeCache ) !=
+            mShaderCodeCache.end() )
+        {
+            return;
+        }
+
+        if( !containsShaderCode( mPendingShaderCode, codeCache ) )
+        {
+            // The worker threads must not touch the Archives
+            loadTemplateSources();
+            mPendingShaderCode.push_back( PendingShaderCode( codeCache ) );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_generatePendingShader( size_t idx )
+    {
+        // Must match the names _compilePendingShaders will give to these shaders
+        generatePendingShader( mPendingShaderCode[idx],
+                               mType * 100000000u +
+                                   static_cast<uint32>( mShaderCodeCache.size() + idx ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::generatePendingShader( PendingShaderCode &pending, uint32 finalHash ) const
+    {
+        OgreProfileExhaustive( "Hlms::generatePendingShader" );
+
+        // mTemplateSources is only read in here.
+        // Each task chunk writes to a different PendingShaderCode entry.
+        ThreadData td;
+
+        const uint64 startTime = mTimer->getMicroseconds();
+
+        td.setProperties = pending.codeCache.mergedCache.setProperties;
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( mTemplateSources->hasTemplate[i] )
+            {
+                td.pieces = pending.codeCache.mergedCache.pieces[i];
+                pending.syntaxError[i] =
+                    expandTemplate( static_cast<ShaderType>( i ), finalHash, td, pending.source[i],
+                                    pending.debugFilenameOutput[i] );
+
+                // Don't create and compile if template requested not to
+                if( getProperty( td.setProperties, HlmsBaseProp::DisableStage ) )
+                    pending.source[i].clear();
+
+                // Reset the disable flag.
+                setProperty( td.setProperties, HlmsBaseProp::DisableStage, 0 );
+            }
+        }
+
+        storeDependencies( td, pending.codeCache );
+        pending.finalProperties.swap( td.setProperties );
+        pending.generationTimeUs = mTimer->getMicroseconds() - startTime;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::compilePendingShader( PendingShaderCode &pending )
+    {
+        const uint64 startTime = mTimer->getMicroseconds();
+
+        const uint32 finalHash = mType * 100000000u + static_cast<uint32>( mShaderCodeCache.size() );
+
+        // compileShaderCode & setupRootLayout read mSetProperties
+        mSetProperties.swap( pending.finalProperties );
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( pending.syntaxError[i] )
+            {
+                LogManager::getSingleton().logMessage( "There were HLMS syntax errors while parsing " +
+                                                       StringConverter::toString( finalHash ) +
+                                                       ShaderFiles[i] );
+            }
+
+            if( !pending.source[i].empty() )
+            {
+                pending.codeCache.shaders[i] =
+                    compileShaderCode( pending.source[i], pending.debugFilenameOutput[i], finalHash,
+                                       static_cast<ShaderType>( i ) );
+            }
+        }
+
+        mSetProperties.swap( pending.finalProperties );
+
+        mShaderCodeCache.push_back( pending.codeCache );
+
+        const uint64 compileTime = mTimer->getMicroseconds() - startTime;
+        ++mCurrentFrameStats.numVariants;
+        ++mCurrentFrameStats.numParallelVariants;
+        mCurrentFrameStats.generationTimeUs += pending.generationTimeUs;
+        mCurrentFrameStats.compileTimeUs += compileTime;
+        mCurrentFrameStats.variantTimeUs.push_back(
+            static_cast<uint32>( pending.generationTimeUs + compileTime ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_compilePendingShaders()
+    {
+        OgreProfileExhaustive( "Hlms::_compilePendingShaders" );
+
+        PendingShaderCodeVec::iterator itor = mPendingShaderCode.begin();
+        PendingShaderCodeVec::iterator endt = mPendingShaderCode.end();
+
+        while( itor != endt )
+            compilePendingShader( *itor++ );
+
+        mPendingShaderCode.clear();
+        mPendingFinalHashes.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setUseCompiledTemplates( bool bUseCompiledTemplates )
+    {
+        mUseCompiledTemplates = bUseCompiledTemplates;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::setAsyncShaderCompilation( bool bAsync, TaskScheduler *taskScheduler,
+                                          uint32 maxCompilesPerFrame )
+    {
+        OGRE_ASSERT_LOW( maxCompilesPerFrame > 0u );
+        OGRE_ASSERT_LOW( ( !bAsync || taskScheduler ) && "A TaskScheduler is required" );
+
+        // The previous scheduler may be about to be destroyed
+        waitForAsyncShaderGeneration();
+
+        mAsyncShaderCompilation = bAsync;
+        mMaxAsyncCompilesPerFrame = maxCompilesPerFrame;
+        mAsyncTaskScheduler = bAsync ? taskScheduler : 0;
+        if( !mAsyncShaderCompilation )
+        {
+            mAsyncShaderCode.clear();
+            mAsyncGeneratedShaderCode.clear();
+        }
+        else if( !mAsyncGenerationTask )
+        {
+            mAsyncGenerationTask = OGRE_NEW AsyncShaderGenerationTask( this );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::waitForAsyncShaderGeneration()
+    {
+        if( mAsyncGenerationTaskId != TaskScheduler::FinishedTask )
+        {
+            mAsyncTaskScheduler->wait( mAsyncGenerationTaskId );
+            mAsyncGenerationTaskId = TaskScheduler::FinishedTask;
+        }
+
+        mAsyncGeneratedShaderCode.insert( mAsyncGeneratedShaderCode.end(),
+                                          mAsyncGeneratingShaderCode.begin(),
+                                          mAsyncGeneratingShaderCode.end() );
+        mAsyncGeneratingShaderCode.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::updateAsyncShaders()
+    {
+        OgreProfileExhaustive( "Hlms::updateAsyncShaders" );
+
+        if( mAsyncGenerationTaskId != TaskScheduler::FinishedTask &&
+            mAsyncTaskScheduler->isTaskFinished( mAsyncGenerationTaskId ) )
+        {
+            // Won't block
+            waitForAsyncShaderGeneration();
+        }
+
+        if( mAsyncGenerationTaskId == TaskScheduler::FinishedTask && !mAsyncShaderCode.empty() )
+        {
+            // Expand the next batch in the background while we compile the previous one.
+            // The names match the ones compilePendingShader will give them, since
+            // variants get compiled in the same order.
+            mAsyncGeneratingShaderCode.swap( mAsyncShaderCode );
+            mAsyncGenerationTask->mFirstFinalHash =
+                mType * 100000000u +
+                static_cast<uint32>( mShaderCodeCache.size() + mAsyncGeneratedShaderCode.size() );
+            mAsyncGenerationTaskId = mAsyncTaskScheduler->submit(
+                mAsyncGenerationTask, mAsyncGeneratingShaderCode.size() );
+
+            // Without worker threads the task already ran inside submit()
+            if( mAsyncGenerationTaskId == TaskScheduler::FinishedTask )
+                waitForAsyncShaderGeneration();
+        }
+
+        const size_t numToCompile =
+            std::min<size_t>( mAsyncGeneratedShaderCode.size(), mMaxAsyncCompilesPerFrame );
+
+        for( size_t i = 0; i < numToCompile; ++i )
+            compilePendingShader( mAsyncGeneratedShaderCode[i] );
+
+        mAsyncGeneratedShaderCode.erase(
+            mAsyncGeneratedShaderCode.begin(),
+            mAsyncGeneratedShaderCode.begin() + static_cast<ptrdiff_t>( numToCompile ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_notifyFrameEnded()
+    {
+        if( getNumPendingAsyncShaders() )
+            updateAsyncShaders();
+
+        mLastFrameStats = mCurrentFrameStats;
+        mCurrentFrameStats.reset();
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::setDebugOutputPath( bool enableDebugOutput, bool outputProperties, const String &path )
     {
         mDebugOutput = enableDebugOutput;
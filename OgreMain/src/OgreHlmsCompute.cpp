@@ -115,6 +115,11 @@ namespace Ogre
     {
         ResourceGroupManager &resourceGroupMgr = ResourceGroupManager::getSingleton();
 
+        // The preprocessor works on a ThreadData; lend it our properties & pieces
+        ThreadData td;
+        td.setProperties.swap( mSetProperties );
+        td.pieces.swap( mPieces );
+
         StringVector::const_iterator itor = pieceFiles.begin();
         StringVector::const_iterator endt = pieceFiles.end();
 
@@ -144,19 +149,22 @@ namespace Ogre
             inString.resize( inFile->size() );
             inFile->read( &inString[0], inFile->size() );
 
-            this->parseMath( inString, outString );
+            this->parseMath( inString, outString, td );
             while( outString.find( "@foreach" ) != String::npos )
             {
-                this->parseForEach( outString, inString );
+                this->parseForEach( outString, inString, td );
                 inString.swap( outString );
             }
-            this->parseProperties( outString, inString );
-            this->parseUndefPieces( inString, outString );
-            this->collectPieces( outString, inString );
-            this->parseCounter( inString, outString );
+            this->parseProperties( outString, inString, td );
+            this->parseUndefPieces( inString, outString, td );
+            this->collectPieces( outString, inString, td );
+            this->parseCounter( inString, outString, td );
 
             ++itor;
         }
+
+        mSetProperties.swap( td.setProperties );
+        mPieces.swap( td.pieces );
     }
     //-----------------------------------------------------------------------------------
     HlmsComputePso HlmsCompute::compileShader( HlmsComputeJob *job, uint32 finalHash )
@@ -226,21 +234,30 @@ namespace Ogre
 
         bool syntaxError = false;
 
-        syntaxError |= this->parseMath( inString, outString );
-        while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-        {
-            syntaxError |= this->parseForEach( outString, inString );
-            inString.swap( outString );
-        }
-        syntaxError |= this->parseProperties( outString, inString );
-        syntaxError |= this->parseUndefPieces( inString, outString );
-        while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
-                                 outString.find( "@insertpiece" ) != String::npos ) )
         {
-            syntaxError |= this->collectPieces( outString, inString );
-            syntaxError |= this->insertPieces( inString, outString );
+            ThreadData td;
+            td.setProperties.swap( mSetProperties );
+            td.pieces.swap( mPieces );
+
+            syntaxError |= this->parseMath( inString, outString, td );
+            while( !syntaxError && outString.find( "@foreach" ) != String::npos )
+            {
+                syntaxError |= this->parseForEach( outString, inString, td );
+                inString.swap( outString );
+            }
+            syntaxError |= this->parseProperties( outString, inString, td );
+            syntaxError |= this->parseUndefPieces( inString, outString, td );
+            while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
+                                     outString.find( "@insertpiece" ) != String::npos ) )
+            {
+                syntaxError |= this->collectPieces( outString, inString, td );
+                syntaxError |= this->insertPieces( inString, outString, td );
+            }
+            syntaxError |= this->parseCounter( outString, inString, td );
+
+            mSetProperties.swap( td.setProperties );
+            mPieces.swap( td.pieces );
         }
-        syntaxError |= this->parseCounter( outString, inString );
 
         outString.swap( inString );
 
@@ -496,6 +496,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void HlmsDatablock::preload() {}
     //-----------------------------------------------------------------------------------
+    void HlmsDatablock::_addTextureScreenCoverage( float coverage ) {}
+    //-----------------------------------------------------------------------------------
     bool HlmsDatablock::hasCustomShadowMacroblock() const
     {
         const HlmsMacroblock *macroblock0 = mMacroblock[0];
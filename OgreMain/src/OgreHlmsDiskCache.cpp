@@ -30,19 +30,32 @@ THE SOFTWARE.
 
 #include "OgreHlmsDiskCache.h"
 
+#include "OgreArchive.h"
 #include "OgreHlmsManager.h"
 #include "OgreLogManager.h"
 #include "OgreProfiler.h"
 #include "OgreRenderSystem.h"
+#include "OgreString.h"
 #include "OgreStringConverter.h"
 
+#include "Hash/MurmurHash3.h"
+
+#include <time.h>
+
+#if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+#    define OGRE_HASH128_FUNC MurmurHash3_x86_128
+#else
+#    define OGRE_HASH128_FUNC MurmurHash3_x64_128
+#endif
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
 #    include "iOS/macUtils.h"
 #endif
 
 namespace Ogre
 {
-    static const uint16 c_hlmsDiskCacheVersion = 3u;
+    static const uint16 c_hlmsDiskCacheVersion = 5u;
+    static const uint32 c_hlmsDiskCacheEntryMagic = 0x45434448u;  // "HDCE"
 
     HlmsDiskCache::HlmsDiskCache( HlmsManager *hlmsManager ) :
         mTemplatesOutOfDate( false ),
@@ -57,6 +70,7 @@ namespace Ogre
         mTemplatesOutOfDate = false;
         memset( mCache.templateHash, 0, sizeof( mCache.templateHash ) );
         mCache.type = 255;
+        mCache.templateFiles.clear();
         mCache.sourceCode.clear();
         mCache.pso.clear();
         mShaderProfile.clear();
@@ -71,7 +85,9 @@ namespace Ogre
     HlmsDiskCache::SourceCode::SourceCode() : mergedCache( HlmsPropertyVec(), 0 ) {}
     //-----------------------------------------------------------------------------------
     HlmsDiskCache::SourceCode::SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache ) :
-        mergedCache( shaderCodeCache.mergedCache )
+        mergedCache( shaderCodeCache.mergedCache ),
+        templateDependencies( shaderCodeCache.templateDependencies ),
+        missingPieces( shaderCodeCache.missingPieces )
     {
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
@@ -105,6 +121,21 @@ namespace Ogre
         mFastShaderBuildHack = hlms->getFastShaderBuildHack();
         hlms->getTemplateChecksum( mCache.templateHash );
 
+        {
+            // Copy the files the shaders depend on. We keep the same indices as the Hlms
+            hlms->loadTemplateSources();
+            const Hlms::TemplateSources &sources = *hlms->mTemplateSources;
+
+            const size_t numFiles = sources.fileNames.size();
+            mCache.templateFiles.resize( numFiles );
+            for( size_t i = 0; i < numFiles; ++i )
+            {
+                mCache.templateFiles[i].name = sources.fileNames[i];
+                mCache.templateFiles[i].hash[0] = sources.fileHashes[i * 2u + 0u];
+                mCache.templateFiles[i].hash[1] = sources.fileHashes[i * 2u + 1u];
+            }
+        }
+
         {
             // Copy shaders
             mCache.sourceCode.reserve( hlms->mShaderCodeCache.size() );
@@ -196,20 +227,91 @@ namespace Ogre
                 "'. This increases loading times." );
         }
 
+        bool templatesChanged = false;
         {
             uint64 currentHash[2];
             hlms->getTemplateChecksum( currentHash );
             if( mCache.templateHash[0] != currentHash[0] || mCache.templateHash[1] != currentHash[1] )
             {
-                mTemplatesOutOfDate = true;
-                LogManager::getSingleton().logMessage(
-                    "WARNING: The cached Hlms is out of date. The templates have changed. "
-                    "We will parse the templates again. If you experience crashes or shader "
-                    "compiler errors, delete the cache" );
+                // Caches loaded through loadEntriesFrom don't have a global hash.
+                // Every entry is checked individually.
+                templatesChanged = true;
+                if( mCache.templateHash[0] != 0u || mCache.templateHash[1] != 0u )
+                {
+                    LogManager::getSingleton().logMessage(
+                        "WARNING: The cached Hlms is out of date. The templates have changed. "
+                        "We will parse the templates again for the affected shaders. If you "
+                        "experience crashes or shader compiler errors, delete the cache" );
+                }
             }
         }
 
         hlms->clearShaderCache();
+        hlms->loadTemplateSources();
+
+        const Hlms::TemplateSources &sources = *hlms->mTemplateSources;
+
+        FastArray<uint8> outOfDate;
+        if( mTemplatesOutOfDate )
+            outOfDate.resize( mCache.sourceCode.size(), 1u );
+        else if( templatesChanged )
+        {
+            const size_t numOutOfDate = findOutOfDateEntries( sources, outOfDate );
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: " + StringConverter::toString( numOutOfDate ) + " out of " +
+                StringConverter::toString( mCache.sourceCode.size() ) +
+                " shaders are out of date and will be parsed again." );
+        }
+        else
+            outOfDate.resize( mCache.sourceCode.size(), 0u );
+
+        // Map our indices to the Hlms' indices
+        FastArray<uint16> fileIds;
+        fileIds.reserve( mCache.templateFiles.size() );
+        {
+            TemplateFileVec::const_iterator itor = mCache.templateFiles.begin();
+            TemplateFileVec::const_iterator endt = mCache.templateFiles.end();
+
+            while( itor != endt )
+            {
+                fileIds.push_back( sources.findFile( itor->name ) );
+                ++itor;
+            }
+        }
+
+        {
+            // An entry that depends on a file the Hlms doesn't have (e.g. the cache was created
+            // with a different set of libraries) can't be trusted even if the global hash
+            // matches. Parse it again instead of keeping a dependency we can't resolve.
+            size_t numUnresolved = 0u;
+            const size_t numEntries = mCache.sourceCode.size();
+            for( size_t i = 0; i < numEntries; ++i )
+            {
+                if( outOfDate[i] )
+                    continue;
+
+                const SourceCode &sourceCode = mCache.sourceCode[i];
+                FastArray<uint16>::const_iterator itDep = sourceCode.templateDependencies.begin();
+                FastArray<uint16>::const_iterator enDep = sourceCode.templateDependencies.end();
+                while( itDep != enDep && !outOfDate[i] )
+                {
+                    if( *itDep >= fileIds.size() || fileIds[*itDep] == Hlms::TemplateSources::NoFile )
+                        outOfDate[i] = 1u;
+                    ++itDep;
+                }
+
+                if( outOfDate[i] )
+                    ++numUnresolved;
+            }
+
+            if( numUnresolved > 0u )
+            {
+                LogManager::getSingleton().logMessage(
+                    "HlmsDiskCache: " + StringConverter::toString( numUnresolved ) +
+                    " shaders depend on template files that no longer exist and will be "
+                    "parsed again." );
+            }
+        }
 
         {
             // Compile shaders
@@ -218,10 +320,20 @@ namespace Ogre
 
             while( itor != endt )
             {
-                if( !mTemplatesOutOfDate )
+                if( !outOfDate[static_cast<size_t>( itor - mCache.sourceCode.begin() )] )
                 {
                     // Templates haven't changed, send the Hlms-processed shader code for compilation
                     hlms->_compileShaderFromPreprocessedSource( itor->mergedCache, itor->sourceFile );
+
+                    // Keep track of the dependencies in case the cache gets saved again
+                    Hlms::ShaderCodeCache &shaderCodeCache = hlms->mShaderCodeCache.back();
+                    FastArray<uint16>::const_iterator itDep = itor->templateDependencies.begin();
+                    FastArray<uint16>::const_iterator enDep = itor->templateDependencies.end();
+                    while( itDep != enDep )
+                        shaderCodeCache.templateDependencies.push_back( fileIds[*itDep++] );
+                    std::sort( shaderCodeCache.templateDependencies.begin(),
+                               shaderCodeCache.templateDependencies.end() );
+                    shaderCodeCache.missingPieces = itor->missingPieces;
                 }
                 else
                 {
@@ -275,6 +387,133 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    /// Adds to outPieceNames the names of all the pieces defined in the file,
+    /// regardless of whether they're inside an @property block
+    static void collectPieceNames( const String &contents, IdStringVec &outPieceNames )
+    {
+        size_t pos = contents.find( "@piece" );
+        while( pos != String::npos )
+        {
+            const size_t nameStart = contents.find( '(', pos );
+            const size_t nameEnd = contents.find( ')', pos );
+            if( nameStart == String::npos || nameEnd == String::npos || nameEnd < nameStart )
+                return;
+
+            String pieceName = contents.substr( nameStart + 1u, nameEnd - nameStart - 1u );
+            StringUtil::trim( pieceName );
+            outPieceNames.push_back( pieceName );
+
+            pos = contents.find( "@piece", nameEnd );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    size_t HlmsDiskCache::findOutOfDateEntries( const Hlms::TemplateSources &sources,
+                                                FastArray<uint8> &outOutOfDate ) const
+    {
+        const size_t numCachedFiles = mCache.templateFiles.size();
+
+        // Find which of the files the cache knows about have changed or no longer exist
+        FastArray<uint8> fileChanged;
+        fileChanged.resize( numCachedFiles, 0u );
+        for( size_t i = 0; i < numCachedFiles; ++i )
+        {
+            const TemplateFile &templateFile = mCache.templateFiles[i];
+            const uint16 fileId = sources.findFile( templateFile.name );
+            if( fileId == Hlms::TemplateSources::NoFile ||
+                sources.fileHashes[fileId * 2u + 0u] != templateFile.hash[0] ||
+                sources.fileHashes[fileId * 2u + 1u] != templateFile.hash[1] )
+            {
+                fileChanged[i] = 1u;
+            }
+        }
+
+        // Now look at the current files that are new or have changed. If they modify the
+        // properties, or they're new templates, every shader may be affected. Otherwise
+        // they can only affect shaders that tried to insert one of their pieces.
+        bool everythingOutOfDate = false;
+        IdStringVec changedPieces;
+        for( size_t i = 0; i < NumShaderTypes && !everythingOutOfDate; ++i )
+        {
+            if( !sources.hasTemplate[i] )
+                continue;
+
+            const size_t numPieceFiles = sources.pieceFiles[i].size();
+            for( size_t j = 0; j <= numPieceFiles && !everythingOutOfDate; ++j )
+            {
+                const bool isTemplate = j == numPieceFiles;
+                const uint16 fileId =
+                    isTemplate ? sources.templateFileId[i] : sources.pieceFileIds[i][j];
+
+                TemplateFile templateFile;
+                templateFile.name = sources.fileNames[fileId];
+                templateFile.hash[0] = sources.fileHashes[fileId * 2u + 0u];
+                templateFile.hash[1] = sources.fileHashes[fileId * 2u + 1u];
+
+                if( std::find( mCache.templateFiles.begin(), mCache.templateFiles.end(),
+                               templateFile ) != mCache.templateFiles.end() )
+                {
+                    continue;  // Unchanged
+                }
+
+                if( isTemplate )
+                {
+                    bool isNew = true;
+                    for( size_t k = 0; k < numCachedFiles && isNew; ++k )
+                        isNew = mCache.templateFiles[k].name != templateFile.name;
+                    // Changed templates are handled through the dependencies (fileChanged)
+                    everythingOutOfDate = isNew;
+                }
+                else if( sources.fileModifiesProperties[fileId] )
+                    everythingOutOfDate = true;
+                else
+                    collectPieceNames( sources.pieceFiles[i][j], changedPieces );
+            }
+        }
+
+        const size_t numEntries = mCache.sourceCode.size();
+        outOutOfDate.resize( numEntries, 0u );
+
+        size_t numOutOfDate = 0u;
+
+        for( size_t i = 0; i < numEntries; ++i )
+        {
+            const SourceCode &sourceCode = mCache.sourceCode[i];
+
+            bool entryOutOfDate = everythingOutOfDate;
+
+            FastArray<uint16>::const_iterator itDep = sourceCode.templateDependencies.begin();
+            FastArray<uint16>::const_iterator enDep = sourceCode.templateDependencies.end();
+            while( itDep != enDep && !entryOutOfDate )
+                entryOutOfDate = fileChanged[*itDep++] != 0u;
+
+            IdStringVec::const_iterator itPiece = sourceCode.missingPieces.begin();
+            IdStringVec::const_iterator enPiece = sourceCode.missingPieces.end();
+            while( itPiece != enPiece && !entryOutOfDate )
+            {
+                entryOutOfDate = std::find( changedPieces.begin(), changedPieces.end(), *itPiece ) !=
+                                 changedPieces.end();
+                ++itPiece;
+            }
+
+            outOutOfDate[i] = entryOutOfDate ? 1u : 0u;
+            if( entryOutOfDate )
+                ++numOutOfDate;
+        }
+
+        return numOutOfDate;
+    }
+    //-----------------------------------------------------------------------------------
+    uint16 HlmsDiskCache::addTemplateFile( const TemplateFile &templateFile )
+    {
+        TemplateFileVec::const_iterator itor =
+            std::find( mCache.templateFiles.begin(), mCache.templateFiles.end(), templateFile );
+        if( itor != mCache.templateFiles.end() )
+            return static_cast<uint16>( itor - mCache.templateFiles.begin() );
+
+        mCache.templateFiles.push_back( templateFile );
+        return static_cast<uint16>( mCache.templateFiles.size() - 1u );
+    }
+    //-----------------------------------------------------------------------------------
     template <typename T>
     void write( DataStreamPtr &dataStream, const T &value )
     {
@@ -340,6 +579,13 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::save( DataStreamPtr &dataStream, const SourceCode &sourceCode )
+    {
+        save( dataStream, sourceCode.mergedCache );
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            save( dataStream, sourceCode.sourceFile[i] );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDiskCache::saveTo( DataStreamPtr &dataStream )
     {
         LogManager::getSingleton().logMessage( "Saving HlmsDiskCache to " + dataStream->getName() );
@@ -358,6 +604,21 @@ namespace Ogre
         write<uint8>( dataStream, mPrecisionMode );
         write<bool>( dataStream, mFastShaderBuildHack );
 
+        {
+            // Save the files the shaders depend on
+            write<uint32>( dataStream, static_cast<uint32>( mCache.templateFiles.size() ) );
+
+            TemplateFileVec::const_iterator itor = mCache.templateFiles.begin();
+            TemplateFileVec::const_iterator endt = mCache.templateFiles.end();
+
+            while( itor != endt )
+            {
+                save( dataStream, itor->name );
+                write( dataStream, itor->hash );
+                ++itor;
+            }
+        }
+
         {
             // Save shaders
             write<uint32>( dataStream, static_cast<uint32>( mCache.sourceCode.size() ) );
@@ -367,9 +628,20 @@ namespace Ogre
 
             while( itor != endt )
             {
-                save( dataStream, itor->mergedCache );
-                for( size_t i = 0; i < NumShaderTypes; ++i )
-                    save( dataStream, itor->sourceFile[i] );
+                save( dataStream, *itor );
+
+                write<uint32>( dataStream,
+                               static_cast<uint32>( itor->templateDependencies.size() ) );
+                FastArray<uint16>::const_iterator itDep = itor->templateDependencies.begin();
+                FastArray<uint16>::const_iterator enDep = itor->templateDependencies.end();
+                while( itDep != enDep )
+                    write<uint16>( dataStream, *itDep++ );
+
+                write<uint32>( dataStream, static_cast<uint32>( itor->missingPieces.size() ) );
+                IdStringVec::const_iterator itPiece = itor->missingPieces.begin();
+                IdStringVec::const_iterator enPiece = itor->missingPieces.end();
+                while( itPiece != enPiece )
+                    save( dataStream, *itPiece++ );
 
                 ++itor;
             }
@@ -534,6 +806,13 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::load( DataStreamPtr &dataStream, SourceCode &sourceCode )
+    {
+        load( dataStream, sourceCode.mergedCache );
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            load( dataStream, sourceCode.sourceFile[i] );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDiskCache::loadFrom( DataStreamPtr &dataStream )
     {
         LogManager::getSingleton().logMessage( "Loading HlmsDiskCache from " + dataStream->getName() );
@@ -566,6 +845,18 @@ namespace Ogre
         read<uint8>( dataStream, mPrecisionMode );
         read<bool>( dataStream, mFastShaderBuildHack );
 
+        {
+            // Load the files the shaders depend on
+            const uint32 numEntries = read<uint32>( dataStream );
+            mCache.templateFiles.resize( numEntries );
+
+            for( size_t i = 0; i < numEntries; ++i )
+            {
+                load( dataStream, mCache.templateFiles[i].name );
+                read( dataStream, mCache.templateFiles[i].hash );
+            }
+        }
+
         {
             // Load shaders
             uint32 numEntries = read<uint32>( dataStream );
@@ -574,9 +865,18 @@ namespace Ogre
             SourceCode sourceCode;
             for( size_t i = 0; i < numEntries; ++i )
             {
-                load( dataStream, sourceCode.mergedCache );
-                for( size_t j = 0; j < NumShaderTypes; ++j )
-                    load( dataStream, sourceCode.sourceFile[j] );
+                load( dataStream, sourceCode );
+
+                const uint32 numDependencies = read<uint32>( dataStream );
+                sourceCode.templateDependencies.resize( numDependencies );
+                for( size_t j = 0; j < numDependencies; ++j )
+                    read( dataStream, sourceCode.templateDependencies[j] );
+
+                const uint32 numMissingPieces = read<uint32>( dataStream );
+                sourceCode.missingPieces.resize( numMissingPieces );
+                for( size_t j = 0; j < numMissingPieces; ++j )
+                    load( dataStream, sourceCode.missingPieces[j] );
+
                 mCache.sourceCode.push_back( sourceCode );
             }
         }
@@ -663,4 +963,288 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    static void appendBytes( FastArray<uint8> &outBytes, const void *data, size_t sizeBytes )
+    {
+        const uint8 *bytes = reinterpret_cast<const uint8 *>( data );
+        outBytes.appendPOD( bytes, bytes + sizeBytes );
+    }
+    //-----------------------------------------------------------------------------------
+    static void appendHex( String &outString, uint64 value )
+    {
+        const char c_hexDigits[] = "0123456789abcdef";
+        for( int i = 60; i >= 0; i -= 4 )
+            outString.push_back( c_hexDigits[( value >> i ) & 0xFu] );
+    }
+    //-----------------------------------------------------------------------------------
+    String HlmsDiskCache::getEntryFilename( const SourceCode &sourceCode ) const
+    {
+        // Everything that determines the generated shader, except the templates.
+        // When the templates change, the entry gets overwritten.
+        FastArray<uint8> key;
+        appendBytes( key, &mCache.type, sizeof( mCache.type ) );
+        appendBytes( key, mShaderProfile.c_str(), mShaderProfile.size() );
+        appendBytes( key, &mNativeShadingLangVer, sizeof( mNativeShadingLangVer ) );
+        appendBytes( key, &mPrecisionMode, sizeof( mPrecisionMode ) );
+        appendBytes( key, &mFastShaderBuildHack, sizeof( mFastShaderBuildHack ) );
+
+        HlmsPropertyVec::const_iterator itor = sourceCode.mergedCache.setProperties.begin();
+        HlmsPropertyVec::const_iterator endt = sourceCode.mergedCache.setProperties.end();
+
+        while( itor != endt )
+        {
+            appendBytes( key, &itor->keyName.mHash, sizeof( itor->keyName.mHash ) );
+            appendBytes( key, &itor->value, sizeof( itor->value ) );
+            ++itor;
+        }
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            const uint32 numPieces = static_cast<uint32>( sourceCode.mergedCache.pieces[i].size() );
+            appendBytes( key, &numPieces, sizeof( numPieces ) );
+
+            PiecesMap::const_iterator itPiece = sourceCode.mergedCache.pieces[i].begin();
+            PiecesMap::const_iterator enPiece = sourceCode.mergedCache.pieces[i].end();
+
+            while( itPiece != enPiece )
+            {
+                appendBytes( key, &itPiece->first.mHash, sizeof( itPiece->first.mHash ) );
+                appendBytes( key, itPiece->second.c_str(), itPiece->second.size() );
+                ++itPiece;
+            }
+        }
+
+        uint64 hashResult[2];
+        memset( hashResult, 0, sizeof( hashResult ) );
+        OGRE_HASH128_FUNC( key.begin(), static_cast<int>( key.size() ), IdString::Seed, hashResult );
+
+        String filename = "HlmsDiskCache_" + StringConverter::toString( mCache.type ) + "_";
+        appendHex( filename, hashResult[0] );
+        appendHex( filename, hashResult[1] );
+        filename += ".hlmscache";
+        return filename;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveEntry( DataStreamPtr &dataStream, const SourceCode &sourceCode )
+    {
+        write<uint32>( dataStream, c_hlmsDiskCacheEntryMagic );
+        write<uint16>( dataStream, c_hlmsDiskCacheVersion );
+#if OGRE_DEBUG_STR_SIZE > 0
+        write<uint16>( dataStream, OGRE_DEBUG_STR_SIZE );
+#else
+        write<uint16>( dataStream, 0 );
+#endif
+        write( dataStream, mCache.type );
+        save( dataStream, mShaderProfile );
+        write<uint16>( dataStream, mNativeShadingLangVer );
+        write<uint8>( dataStream, mPrecisionMode );
+        write<bool>( dataStream, mFastShaderBuildHack );
+
+        // Dependencies go first, so that saveEntriesTo can tell whether an existing
+        // entry is up to date without reading all of it
+        write<uint32>( dataStream, static_cast<uint32>( sourceCode.templateDependencies.size() ) );
+        FastArray<uint16>::const_iterator itDep = sourceCode.templateDependencies.begin();
+        FastArray<uint16>::const_iterator enDep = sourceCode.templateDependencies.end();
+        while( itDep != enDep )
+        {
+            const TemplateFile &templateFile = mCache.templateFiles[*itDep];
+            save( dataStream, templateFile.name );
+            write( dataStream, templateFile.hash );
+            ++itDep;
+        }
+
+        write<uint32>( dataStream, static_cast<uint32>( sourceCode.missingPieces.size() ) );
+        IdStringVec::const_iterator itPiece = sourceCode.missingPieces.begin();
+        IdStringVec::const_iterator enPiece = sourceCode.missingPieces.end();
+        while( itPiece != enPiece )
+            save( dataStream, *itPiece++ );
+
+        save( dataStream, sourceCode );
+
+        // The footer is written last. If it's missing, the entry is incomplete
+        write<uint32>( dataStream, static_cast<uint32>( dataStream->tell() ) );
+        write<uint32>( dataStream, c_hlmsDiskCacheEntryMagic );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::loadEntryHeader( DataStreamPtr &dataStream )
+    {
+        const size_t footerSize = sizeof( uint32 ) * 2u;
+        const size_t fileSize = dataStream->size();
+        if( fileSize < footerSize )
+            return false;
+
+        dataStream->seek( fileSize - footerSize );
+        const uint32 entrySize = read<uint32>( dataStream );
+        const uint32 footerMagic = read<uint32>( dataStream );
+        if( entrySize != fileSize - footerSize || footerMagic != c_hlmsDiskCacheEntryMagic )
+            return false;
+
+        dataStream->seek( 0 );
+
+        if( read<uint32>( dataStream ) != c_hlmsDiskCacheEntryMagic ||
+            read<uint16>( dataStream ) != c_hlmsDiskCacheVersion )
+        {
+            return false;
+        }
+
+        mDebugStrSize = read<uint16>( dataStream );
+#if OGRE_DEBUG_STR_SIZE > 0
+        if( OGRE_DEBUG_STR_SIZE != mDebugStrSize )
+            return false;
+#endif
+
+        const uint8 type = read<uint8>( dataStream );
+        String shaderProfile;
+        load( dataStream, shaderProfile );
+        const uint16 nativeShadingLangVer = read<uint16>( dataStream );
+        const uint8 precisionMode = read<uint8>( dataStream );
+        const bool fastShaderBuildHack = read<bool>( dataStream );
+
+        return type == mCache.type && shaderProfile == mShaderProfile &&
+               nativeShadingLangVer == mNativeShadingLangVer && precisionMode == mPrecisionMode &&
+               fastShaderBuildHack == mFastShaderBuildHack;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::loadEntryDependencies( DataStreamPtr &dataStream,
+                                               TemplateFileVec &outTemplateFiles,
+                                               IdStringVec &outMissingPieces )
+    {
+        const uint32 numDependencies = read<uint32>( dataStream );
+        outTemplateFiles.resize( numDependencies );
+        for( size_t i = 0; i < numDependencies; ++i )
+        {
+            load( dataStream, outTemplateFiles[i].name );
+            read( dataStream, outTemplateFiles[i].hash );
+        }
+
+        const uint32 numMissingPieces = read<uint32>( dataStream );
+        outMissingPieces.resize( numMissingPieces );
+        for( size_t i = 0; i < numMissingPieces; ++i )
+            load( dataStream, outMissingPieces[i] );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveEntriesTo( Archive *archive )
+    {
+        LogManager::getSingleton().logMessage( "Saving HlmsDiskCache entries to " +
+                                               archive->getName() );
+
+        size_t numSaved = 0u;
+
+        // Entries are written under a temporary name and then renamed over the old one, so that
+        // a crash or another process saving to the same folder never leaves a truncated entry.
+        // The suffix only needs to differ between processes (and calls) writing at the same time
+        String tmpSuffix = ".tmp";
+        {
+            const uint64 uniqueKey[3] = { static_cast<uint64>( time( 0 ) ),
+                                          static_cast<uint64>( clock() ),
+                                          static_cast<uint64>( reinterpret_cast<uintptr_t>( this ) ) };
+            uint64 hashResult[2];
+            OGRE_HASH128_FUNC( uniqueKey, static_cast<int>( sizeof( uniqueKey ) ), IdString::Seed,
+                               hashResult );
+            appendHex( tmpSuffix, hashResult[0] );
+        }
+
+        TemplateFileVec dependencies;
+        TemplateFileVec existingDependencies;
+        IdStringVec existingMissingPieces;
+
+        SourceCodeVec::const_iterator itor = mCache.sourceCode.begin();
+        SourceCodeVec::const_iterator endt = mCache.sourceCode.end();
+
+        while( itor != endt )
+        {
+            const String filename = getEntryFilename( *itor );
+
+            bool upToDate = false;
+            if( archive->exists( filename ) )
+            {
+                dependencies.clear();
+                FastArray<uint16>::const_iterator itDep = itor->templateDependencies.begin();
+                FastArray<uint16>::const_iterator enDep = itor->templateDependencies.end();
+                while( itDep != enDep )
+                    dependencies.push_back( mCache.templateFiles[*itDep++] );
+
+                DataStreamPtr dataStream = archive->open( filename );
+                if( loadEntryHeader( dataStream ) )
+                {
+                    loadEntryDependencies( dataStream, existingDependencies,
+                                           existingMissingPieces );
+                    upToDate = existingDependencies == dependencies &&
+                               existingMissingPieces == itor->missingPieces;
+                }
+                dataStream->close();
+            }
+
+            if( !upToDate )
+            {
+                const String tmpFilename = filename + tmpSuffix;
+                {
+                    DataStreamPtr dataStream = archive->create( tmpFilename );
+                    saveEntry( dataStream, *itor );
+                    dataStream->close();
+                }
+                archive->rename( tmpFilename, filename );
+                ++numSaved;
+            }
+
+            ++itor;
+        }
+
+        LogManager::getSingleton().logMessage(
+            "HlmsDiskCache: Saved " + StringConverter::toString( numSaved ) + " entries. " +
+            StringConverter::toString( mCache.sourceCode.size() - numSaved ) +
+            " were already up to date." );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::loadEntriesFrom( Archive *archive, Hlms *hlms )
+    {
+        LogManager::getSingleton().logMessage( "Loading HlmsDiskCache entries from " +
+                                               archive->getName() );
+
+        clearCache();
+
+        // Entries are only loaded if they match these
+        mCache.type = hlms->getType();
+        mShaderProfile = hlms->getShaderProfile();
+        mNativeShadingLangVer = hlms->getRenderSystem()->getNativeShadingLanguageVersion();
+        mPrecisionMode = hlms->getSupportedPrecisionMode();
+        mFastShaderBuildHack = hlms->getFastShaderBuildHack();
+
+        StringVectorPtr filenames = archive->find(
+            "HlmsDiskCache_" + StringConverter::toString( mCache.type ) + "_*.hlmscache", false );
+
+        TemplateFileVec dependencies;
+        SourceCode sourceCode;
+
+        StringVector::const_iterator itor = filenames->begin();
+        StringVector::const_iterator endt = filenames->end();
+
+        while( itor != endt )
+        {
+            DataStreamPtr dataStream = archive->open( *itor );
+            if( loadEntryHeader( dataStream ) )
+            {
+                loadEntryDependencies( dataStream, dependencies, sourceCode.missingPieces );
+                load( dataStream, sourceCode );
+
+                sourceCode.templateDependencies.clear();
+                TemplateFileVec::const_iterator itDep = dependencies.begin();
+                TemplateFileVec::const_iterator enDep = dependencies.end();
+                while( itDep != enDep )
+                    sourceCode.templateDependencies.push_back( addTemplateFile( *itDep++ ) );
+
+                mCache.sourceCode.push_back( sourceCode );
+            }
+            dataStream->close();
+            ++itor;
+        }
+
+        LogManager::getSingleton().logMessage(
+            "HlmsDiskCache: Loaded " + StringConverter::toString( mCache.sourceCode.size() ) +
+            " out of " + StringConverter::toString( filenames->size() ) + " entries." );
+    }
 }  // namespace Ogre
+
+#undef OGRE_HASH128_FUNC
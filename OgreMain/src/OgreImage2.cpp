@@ -866,7 +866,7 @@ namespace Ogre
                                           bool gammaCorrected,                     //
                                           uint32 depthOrSlices,                    //
                                           TextureTypes::TextureTypes textureType,  //
-                                          Filter filter )
+                                          Filter filter, bool useSimd )
     {
         bool retVal = true;
 
@@ -998,6 +998,9 @@ namespace Ogre
             break;
         }
 
+        if( useSimd && downsampler2DFunc )
+            downsampler2DFunc = getSimdImageDownsampler2D( downsampler2DFunc );
+
         *imageDownsampler2D = (void *)downsampler2DFunc;
         *imageDownsampler3D = (void *)downsampler3DFunc;
         *imageDownsamplerCube = (void *)downsamplerCubeFunc;
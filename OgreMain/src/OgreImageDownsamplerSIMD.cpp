@@ -0,0 +1,532 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreImageDownsampler.h"
+
+#include "OgrePlatformInformation.h"
+
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#endif
+
+namespace Ogre
+{
+#if __OGRE_HAVE_SSE || __OGRE_HAVE_NEON
+    /// Returns true if the kernel is the 2x2 box used by FILTER_LINEAR and FILTER_BILINEAR
+    static bool isBoxKernel( const uint8 kernel[5][5], const int8 kernelStartX,
+                             const int8 kernelEndX, const int8 kernelStartY, const int8 kernelEndY )
+    {
+        return kernelStartX == 0 && kernelEndX == 1 && kernelStartY == 0 && kernelEndY == 1 &&
+               kernel[2][2] == 1u && kernel[2][3] == 1u && kernel[3][2] == 1u && kernel[3][3] == 1u;
+    }
+    //-----------------------------------------------------------------------------------
+    /** Downsamples every pixel that is neither in the last row nor in the last column using
+        RowDownsampler, several pixels at a time. The kernel gets clamped on the last row and
+        column, so those (and the columns left over) are handed to the scalar version.
+    @remarks
+        RowDownsampler must produce exactly the same output as scalarFunc would.
+    */
+    template <typename RowDownsampler>
+    static void downscale2xBox( ImageDownsampler2D *scalarFunc, uint8 *dstPtr, uint8 const *srcPtr,
+                                int32 dstWidth, int32 dstHeight, int32 dstBytesPerRow,
+                                int32 srcWidth, int32 srcBytesPerRow, const uint8 kernel[5][5],
+                                const int8 kernelStartX, const int8 kernelEndX,
+                                const int8 kernelStartY, const int8 kernelEndY )
+    {
+        const int32 pixelsPerIteration = RowDownsampler::PixelsPerIteration;
+        const int32 simdWidth = ( ( dstWidth - 1 ) / pixelsPerIteration ) * pixelsPerIteration;
+
+        if( simdWidth <= 0 || dstHeight <= 1 ||
+            !isBoxKernel( kernel, kernelStartX, kernelEndX, kernelStartY, kernelEndY ) )
+        {
+            ( *scalarFunc )( dstPtr, srcPtr, dstWidth, dstHeight, dstBytesPerRow, srcWidth,
+                             srcBytesPerRow, kernel, kernelStartX, kernelEndX, kernelStartY,
+                             kernelEndY );
+            return;
+        }
+
+        for( int32 y = 0; y < dstHeight - 1; ++y )
+        {
+            uint8 const *srcRow0 = srcPtr + size_t( y ) * 2u * size_t( srcBytesPerRow );
+            RowDownsampler::downsampleRow( dstPtr + size_t( y ) * size_t( dstBytesPerRow ), srcRow0,
+                                           srcRow0 + srcBytesPerRow, simdWidth );
+        }
+
+        const int32 bytesPerPixel = RowDownsampler::BytesPerPixel;
+
+        // Leftover columns, for every row
+        ( *scalarFunc )( dstPtr + simdWidth * bytesPerPixel, srcPtr + simdWidth * 2 * bytesPerPixel,
+                         dstWidth - simdWidth, dstHeight, dstBytesPerRow, srcWidth - simdWidth * 2,
+                         srcBytesPerRow, kernel, kernelStartX, kernelEndX, kernelStartY, kernelEndY );
+
+        // Last row. Its leftover columns get overwritten with the same values
+        const size_t lastRow = size_t( dstHeight - 1 );
+        ( *scalarFunc )( dstPtr + lastRow * size_t( dstBytesPerRow ),
+                         srcPtr + lastRow * 2u * size_t( srcBytesPerRow ), dstWidth, 1, dstBytesPerRow,
+                         srcWidth, srcBytesPerRow, kernel, kernelStartX, kernelEndX, kernelStartY,
+                         kernelEndY );
+    }
+#endif
+
+#if __OGRE_HAVE_SSE
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_XXXA8888
+    {
+        enum
+        {
+            PixelsPerIteration = 4,
+            BytesPerPixel = 4
+        };
+
+        static void downsampleRow( uint8 *dstPtr, uint8 const *srcRow0, uint8 const *srcRow1,
+                                   int32 numPixels )
+        {
+            const __m128i zero = _mm_setzero_si128();
+            // Colour rounds to nearest, alpha rounds up; like the scalar version
+            const __m128i bias = _mm_set_epi16( 3, 2, 2, 2, 3, 2, 2, 2 );
+
+            for( int32 x = 0; x < numPixels; x += 4 )
+            {
+                const __m128i a0 = _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow0 ) );
+                const __m128i a1 =
+                    _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow0 + 16u ) );
+                const __m128i b0 = _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow1 ) );
+                const __m128i b1 =
+                    _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow1 + 16u ) );
+
+                // Vertical sums in 16 bits. Two source pixels per register
+                const __m128i v01 =
+                    _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+                const __m128i v23 =
+                    _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+                const __m128i v45 =
+                    _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+                const __m128i v67 =
+                    _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+                // Horizontal sums. Two destination pixels per register
+                __m128i d01 = _mm_add_epi16( _mm_unpacklo_epi64( v01, v23 ),
+                                             _mm_unpackhi_epi64( v01, v23 ) );
+                __m128i d23 = _mm_add_epi16( _mm_unpacklo_epi64( v45, v67 ),
+                                             _mm_unpackhi_epi64( v45, v67 ) );
+
+                d01 = _mm_srli_epi16( _mm_add_epi16( d01, bias ), 2 );
+                d23 = _mm_srli_epi16( _mm_add_epi16( d23, bias ), 2 );
+
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dstPtr ),
+                                  _mm_packus_epi16( d01, d23 ) );
+
+                dstPtr += 16u;
+                srcRow0 += 32u;
+                srcRow1 += 32u;
+            }
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_sRGB_XXXA8888
+    {
+        enum
+        {
+            PixelsPerIteration = 4,
+            BytesPerPixel = 4
+        };
+
+        /// Splits 4 pixels into two registers with the channels of horizontally adjacent pixels
+        /// interleaved, in 16 bits: [p0.r p1.r p0.g p1.g p0.b p1.b p0.a p1.a]
+        static inline void interleavePairs( __m128i pixels, __m128i zero, __m128i &outPair01,
+                                            __m128i &outPair23 )
+        {
+            pixels = _mm_shuffle_epi32( pixels, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+            pixels = _mm_unpacklo_epi8( pixels, _mm_srli_si128( pixels, 8 ) );
+            outPair01 = _mm_unpacklo_epi8( pixels, zero );
+            outPair23 = _mm_unpackhi_epi8( pixels, zero );
+        }
+
+        /// Returns one destination pixel in 32 bits per channel, given the interleaved
+        /// pairs from both source rows
+        static inline __m128i resolve( __m128i pair0, __m128i pair1, __m128i ones,
+                                       __m128i alphaMask )
+        {
+            // Same as the scalar version: colour = sqrt( sum( x * x ) / 4 ), alpha is linear
+            const __m128i sqSum =
+                _mm_add_epi32( _mm_madd_epi16( pair0, pair0 ), _mm_madd_epi16( pair1, pair1 ) );
+            const __m128i sum =
+                _mm_add_epi32( _mm_madd_epi16( pair0, ones ), _mm_madd_epi16( pair1, ones ) );
+
+            __m128 colour = _mm_mul_ps( _mm_cvtepi32_ps( sqSum ), _mm_set1_ps( 0.25f ) );
+            colour = _mm_add_ps( _mm_sqrt_ps( colour ), _mm_set1_ps( 0.5f ) );
+
+            const __m128i alpha = _mm_srli_epi32( _mm_add_epi32( sum, _mm_set1_epi32( 3 ) ), 2 );
+
+            return _mm_or_si128( _mm_andnot_si128( alphaMask, _mm_cvttps_epi32( colour ) ),
+                                 _mm_and_si128( alphaMask, alpha ) );
+        }
+
+        static void downsampleRow( uint8 *dstPtr, uint8 const *srcRow0, uint8 const *srcRow1,
+                                   int32 numPixels )
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i ones = _mm_set1_epi16( 1 );
+            const __m128i alphaMask = _mm_set_epi32( -1, 0, 0, 0 );
+
+            for( int32 x = 0; x < numPixels; x += 4 )
+            {
+                __m128i a01, a23, a45, a67;
+                __m128i b01, b23, b45, b67;
+                interleavePairs( _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow0 ) ),
+                                 zero, a01, a23 );
+                interleavePairs(
+                    _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow0 + 16u ) ), zero,
+                    a45, a67 );
+                interleavePairs( _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow1 ) ),
+                                 zero, b01, b23 );
+                interleavePairs(
+                    _mm_loadu_si128( reinterpret_cast<const __m128i *>( srcRow1 + 16u ) ), zero,
+                    b45, b67 );
+
+                const __m128i d0 = resolve( a01, b01, ones, alphaMask );
+                const __m128i d1 = resolve( a23, b23, ones, alphaMask );
+                const __m128i d2 = resolve( a45, b45, ones, alphaMask );
+                const __m128i d3 = resolve( a67, b67, ones, alphaMask );
+
+                _mm_storeu_si128(
+                    reinterpret_cast<__m128i *>( dstPtr ),
+                    _mm_packus_epi16( _mm_packs_epi32( d0, d1 ), _mm_packs_epi32( d2, d3 ) ) );
+
+                dstPtr += 16u;
+                srcRow0 += 32u;
+                srcRow1 += 32u;
+            }
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_Float32_XXXA
+    {
+        enum
+        {
+            PixelsPerIteration = 1,
+            BytesPerPixel = 16
+        };
+
+        static void downsampleRow( uint8 *_dstPtr, uint8 const *_srcRow0, uint8 const *_srcRow1,
+                                   int32 numPixels )
+        {
+            float *dstPtr = reinterpret_cast<float *>( _dstPtr );
+            const float *srcRow0 = reinterpret_cast<const float *>( _srcRow0 );
+            const float *srcRow1 = reinterpret_cast<const float *>( _srcRow1 );
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 quarter = _mm_set1_ps( 0.25f );
+            const __m128 alphaMask = _mm_castsi128_ps( _mm_set_epi32( -1, 0, 0, 0 ) );
+
+            for( int32 x = 0; x < numPixels; ++x )
+            {
+                // Same order of operations as the scalar version, so the output is identical
+                __m128 accum = _mm_add_ps( zero, _mm_loadu_ps( srcRow0 ) );
+                accum = _mm_add_ps( accum, _mm_loadu_ps( srcRow0 + 4u ) );
+                accum = _mm_add_ps( accum, _mm_loadu_ps( srcRow1 ) );
+                accum = _mm_add_ps( accum, _mm_loadu_ps( srcRow1 + 4u ) );
+
+                const __m128 colour = _mm_add_ps( _mm_mul_ps( accum, quarter ), zero );
+                const __m128 alpha = _mm_mul_ps(
+                    _mm_sub_ps( _mm_add_ps( accum, _mm_set1_ps( 4.0f ) ), _mm_set1_ps( 1.0f ) ),
+                    quarter );
+
+                _mm_storeu_ps( dstPtr, _mm_or_ps( _mm_andnot_ps( alphaMask, colour ),
+                                                  _mm_and_ps( alphaMask, alpha ) ) );
+
+                dstPtr += 4u;
+                srcRow0 += 8u;
+                srcRow1 += 8u;
+            }
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_Float32_X
+    {
+        enum
+        {
+            PixelsPerIteration = 4,
+            BytesPerPixel = 4
+        };
+
+        static void downsampleRow( uint8 *_dstPtr, uint8 const *_srcRow0, uint8 const *_srcRow1,
+                                   int32 numPixels )
+        {
+            float *dstPtr = reinterpret_cast<float *>( _dstPtr );
+            const float *srcRow0 = reinterpret_cast<const float *>( _srcRow0 );
+            const float *srcRow1 = reinterpret_cast<const float *>( _srcRow1 );
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 quarter = _mm_set1_ps( 0.25f );
+
+            for( int32 x = 0; x < numPixels; x += 4 )
+            {
+                const __m128 a0 = _mm_loadu_ps( srcRow0 );
+                const __m128 a1 = _mm_loadu_ps( srcRow0 + 4u );
+                const __m128 b0 = _mm_loadu_ps( srcRow1 );
+                const __m128 b1 = _mm_loadu_ps( srcRow1 + 4u );
+
+                // Same order of operations as the scalar version, so the output is identical
+                __m128 accum = _mm_add_ps( zero, _mm_shuffle_ps( a0, a1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+                accum = _mm_add_ps( accum, _mm_shuffle_ps( a0, a1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+                accum = _mm_add_ps( accum, _mm_shuffle_ps( b0, b1, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+                accum = _mm_add_ps( accum, _mm_shuffle_ps( b0, b1, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+
+                _mm_storeu_ps( dstPtr, _mm_add_ps( _mm_mul_ps( accum, quarter ), zero ) );
+
+                dstPtr += 4u;
+                srcRow0 += 8u;
+                srcRow1 += 8u;
+            }
+        }
+    };
+#elif __OGRE_HAVE_NEON
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_XXXA8888
+    {
+        enum
+        {
+            PixelsPerIteration = 8,
+            BytesPerPixel = 4
+        };
+
+        static void downsampleRow( uint8 *dstPtr, uint8 const *srcRow0, uint8 const *srcRow1,
+                                   int32 numPixels )
+        {
+            const uint16x8_t three = vdupq_n_u16( 3u );
+
+            for( int32 x = 0; x < numPixels; x += 8 )
+            {
+                const uint8x16x4_t a = vld4q_u8( srcRow0 );
+                const uint8x16x4_t b = vld4q_u8( srcRow1 );
+
+                uint8x8x4_t result;
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    const uint16x8_t sum = vpadalq_u8( vpaddlq_u8( a.val[c] ), b.val[c] );
+                    result.val[c] = vrshrn_n_u16( sum, 2 );
+                }
+                // Colour rounds to nearest, alpha rounds up; like the scalar version
+                const uint16x8_t sumA = vpadalq_u8( vpaddlq_u8( a.val[3] ), b.val[3] );
+                result.val[3] = vshrn_n_u16( vaddq_u16( sumA, three ), 2 );
+
+                vst4_u8( dstPtr, result );
+
+                dstPtr += 32u;
+                srcRow0 += 64u;
+                srcRow1 += 64u;
+            }
+        }
+    };
+#    if defined( __aarch64__ ) || defined( _M_ARM64 )
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_sRGB_XXXA8888
+    {
+        enum
+        {
+            PixelsPerIteration = 8,
+            BytesPerPixel = 4
+        };
+
+        /// Same as the scalar version: sqrt( sum( x * x ) / 4 )
+        static inline uint16x4_t toGamma( uint32x4_t sqSum )
+        {
+            float32x4_t colour = vmulq_n_f32( vcvtq_f32_u32( sqSum ), 0.25f );
+            colour = vaddq_f32( vsqrtq_f32( colour ), vdupq_n_f32( 0.5f ) );
+            return vmovn_u32( vcvtq_u32_f32( colour ) );
+        }
+
+        static void downsampleRow( uint8 *dstPtr, uint8 const *srcRow0, uint8 const *srcRow1,
+                                   int32 numPixels )
+        {
+            const uint16x8_t three = vdupq_n_u16( 3u );
+
+            for( int32 x = 0; x < numPixels; x += 8 )
+            {
+                const uint8x16x4_t a = vld4q_u8( srcRow0 );
+                const uint8x16x4_t b = vld4q_u8( srcRow1 );
+
+                uint8x8x4_t result;
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    const uint8x8_t aLo = vget_low_u8( a.val[c] );
+                    const uint8x8_t aHi = vget_high_u8( a.val[c] );
+                    const uint8x8_t bLo = vget_low_u8( b.val[c] );
+                    const uint8x8_t bHi = vget_high_u8( b.val[c] );
+
+                    const uint32x4_t sqSumLo =
+                        vpadalq_u16( vpaddlq_u16( vmull_u8( aLo, aLo ) ), vmull_u8( bLo, bLo ) );
+                    const uint32x4_t sqSumHi =
+                        vpadalq_u16( vpaddlq_u16( vmull_u8( aHi, aHi ) ), vmull_u8( bHi, bHi ) );
+
+                    result.val[c] =
+                        vmovn_u16( vcombine_u16( toGamma( sqSumLo ), toGamma( sqSumHi ) ) );
+                }
+                const uint16x8_t sumA = vpadalq_u8( vpaddlq_u8( a.val[3] ), b.val[3] );
+                result.val[3] = vshrn_n_u16( vaddq_u16( sumA, three ), 2 );
+
+                vst4_u8( dstPtr, result );
+
+                dstPtr += 32u;
+                srcRow0 += 64u;
+                srcRow1 += 64u;
+            }
+        }
+    };
+#    endif
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_Float32_XXXA
+    {
+        enum
+        {
+            PixelsPerIteration = 1,
+            BytesPerPixel = 16
+        };
+
+        static void downsampleRow( uint8 *_dstPtr, uint8 const *_srcRow0, uint8 const *_srcRow1,
+                                   int32 numPixels )
+        {
+            float *dstPtr = reinterpret_cast<float *>( _dstPtr );
+            const float *srcRow0 = reinterpret_cast<const float *>( _srcRow0 );
+            const float *srcRow1 = reinterpret_cast<const float *>( _srcRow1 );
+
+            const uint32 c_alphaMask[4] = { 0u, 0u, 0u, 0xFFFFFFFFu };
+            const uint32x4_t alphaMask = vld1q_u32( c_alphaMask );
+            const float32x4_t zero = vdupq_n_f32( 0.0f );
+
+            for( int32 x = 0; x < numPixels; ++x )
+            {
+                // Same order of operations as the scalar version, so the output is identical
+                float32x4_t accum = vaddq_f32( zero, vld1q_f32( srcRow0 ) );
+                accum = vaddq_f32( accum, vld1q_f32( srcRow0 + 4u ) );
+                accum = vaddq_f32( accum, vld1q_f32( srcRow1 ) );
+                accum = vaddq_f32( accum, vld1q_f32( srcRow1 + 4u ) );
+
+                const float32x4_t colour = vaddq_f32( vmulq_n_f32( accum, 0.25f ), zero );
+                const float32x4_t alpha = vmulq_n_f32(
+                    vsubq_f32( vaddq_f32( accum, vdupq_n_f32( 4.0f ) ), vdupq_n_f32( 1.0f ) ),
+                    0.25f );
+
+                vst1q_f32( dstPtr, vbslq_f32( alphaMask, alpha, colour ) );
+
+                dstPtr += 4u;
+                srcRow0 += 8u;
+                srcRow1 += 8u;
+            }
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    struct BoxRow_Float32_X
+    {
+        enum
+        {
+            PixelsPerIteration = 4,
+            BytesPerPixel = 4
+        };
+
+        static void downsampleRow( uint8 *_dstPtr, uint8 const *_srcRow0, uint8 const *_srcRow1,
+                                   int32 numPixels )
+        {
+            float *dstPtr = reinterpret_cast<float *>( _dstPtr );
+            const float *srcRow0 = reinterpret_cast<const float *>( _srcRow0 );
+            const float *srcRow1 = reinterpret_cast<const float *>( _srcRow1 );
+
+            const float32x4_t zero = vdupq_n_f32( 0.0f );
+
+            for( int32 x = 0; x < numPixels; x += 4 )
+            {
+                // val[0] has the even pixels, val[1] the odd ones
+                const float32x4x2_t a = vld2q_f32( srcRow0 );
+                const float32x4x2_t b = vld2q_f32( srcRow1 );
+
+                // Same order of operations as the scalar version, so the output is identical
+                float32x4_t accum = vaddq_f32( zero, a.val[0] );
+                accum = vaddq_f32( accum, a.val[1] );
+                accum = vaddq_f32( accum, b.val[0] );
+                accum = vaddq_f32( accum, b.val[1] );
+
+                vst1q_f32( dstPtr, vaddq_f32( vmulq_n_f32( accum, 0.25f ), zero ) );
+
+                dstPtr += 4u;
+                srcRow0 += 8u;
+                srcRow1 += 8u;
+            }
+        }
+    };
+#endif
+
+#if __OGRE_HAVE_SSE || __OGRE_HAVE_NEON
+#    define OGRE_DECLARE_SIMD_DOWNSAMPLER( name ) \
+        static void downscale2x_##name##_SIMD( \
+            uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth, int32 dstHeight, \
+            int32 dstBytesPerRow, int32 srcWidth, int32 srcBytesPerRow, const uint8 kernel[5][5], \
+            const int8 kernelStartX, const int8 kernelEndX, const int8 kernelStartY, \
+            const int8 kernelEndY ) \
+        { \
+            downscale2xBox<BoxRow_##name>( downscale2x_##name, dstPtr, srcPtr, dstWidth, dstHeight, \
+                                           dstBytesPerRow, srcWidth, srcBytesPerRow, kernel, \
+                                           kernelStartX, kernelEndX, kernelStartY, kernelEndY ); \
+        }
+    //-----------------------------------------------------------------------------------
+    OGRE_DECLARE_SIMD_DOWNSAMPLER( XXXA8888 )
+    OGRE_DECLARE_SIMD_DOWNSAMPLER( Float32_XXXA )
+    OGRE_DECLARE_SIMD_DOWNSAMPLER( Float32_X )
+#    if __OGRE_HAVE_SSE || defined( __aarch64__ ) || defined( _M_ARM64 )
+#        define OGRE_HAVE_SIMD_SRGB_DOWNSAMPLER
+    OGRE_DECLARE_SIMD_DOWNSAMPLER( sRGB_XXXA8888 )
+#    endif
+
+#    undef OGRE_DECLARE_SIMD_DOWNSAMPLER
+#endif
+    //-----------------------------------------------------------------------------------
+    ImageDownsampler2D *getSimdImageDownsampler2D( ImageDownsampler2D *scalarFunc )
+    {
+#if __OGRE_HAVE_SSE || __OGRE_HAVE_NEON
+#    if __OGRE_HAVE_SSE
+        if( !PlatformInformation::hasCpuFeature( PlatformInformation::CPU_FEATURE_SSE2 ) )
+            return scalarFunc;
+#    endif
+        if( scalarFunc == downscale2x_XXXA8888 )
+            return downscale2x_XXXA8888_SIMD;
+        if( scalarFunc == downscale2x_Float32_XXXA )
+            return downscale2x_Float32_XXXA_SIMD;
+        if( scalarFunc == downscale2x_Float32_X )
+            return downscale2x_Float32_X_SIMD;
+#    ifdef OGRE_HAVE_SIMD_SRGB_DOWNSAMPLER
+        if( scalarFunc == downscale2x_sRGB_XXXA8888 )
+            return downscale2x_sRGB_XXXA8888_SIMD;
+#    endif
+#endif
+        return scalarFunc;
+    }
+}  // namespace Ogre
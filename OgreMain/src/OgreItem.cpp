@@ -152,6 +152,9 @@ namespace Ogre
         assert( mManager || !mSkeletonInstance );
         if( mSkeletonInstance )
         {
+            if( mSkeletonInstance->getUpdateLodSource() == this )
+                mSkeletonInstance->setUpdateLod( 0, FastArray<uint8>() );
+
             mSkeletonInstance->_decrementRefCount();
             if( mSkeletonInstance->_getRefCount() == 0u )
                 mManager->destroySkeletonInstance( mSkeletonInstance );
@@ -294,6 +297,9 @@ namespace Ogre
 
         if( mSkeletonInstance )
         {
+            if( mSkeletonInstance->getUpdateLodSource() == this )
+                mSkeletonInstance->setUpdateLod( 0, FastArray<uint8>() );
+
             mSkeletonInstance->_decrementRefCount();
             if( mSkeletonInstance->_getRefCount() == 0u )
                 mManager->destroySkeletonInstance( mSkeletonInstance );
@@ -310,6 +316,9 @@ namespace Ogre
             assert( mSkeletonInstance->_getRefCount() > 1u &&
                     "This skeleton is Item is not sharing its skeleton!" );
 
+            if( mSkeletonInstance->getUpdateLodSource() == this )
+                mSkeletonInstance->setUpdateLod( 0, FastArray<uint8>() );
+
             mSkeletonInstance->_decrementRefCount();
             if( mSkeletonInstance->_getRefCount() == 0u )
                 mManager->destroySkeletonInstance( mSkeletonInstance );
@@ -143,6 +143,10 @@ namespace Ogre
     {
         OgreProfileExhaustive( "Mesh2::prepareImpl" );
 
+        // Already read by MeshManager's background thread
+        if( mFreshFromDisk )
+            return;
+
         // Load from specified 'name'
         if( getCreator()->getVerbose() )
             LogManager::getSingleton().logMessage( "Mesh: Loading " + mName + "." );
@@ -155,6 +159,12 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
     //-----------------------------------------------------------------------
+    void Mesh::_setPreparedData( const DataStreamPtr &data )
+    {
+        OGRE_ASSERT_LOW( dynamic_cast<MemoryDataStream *>( data.get() ) );
+        mFreshFromDisk = data;
+    }
+    //-----------------------------------------------------------------------
     void Mesh::loadImpl()
     {
         OgreProfileExhaustive( "Mesh2::loadImpl" );
@@ -61,7 +61,10 @@ namespace Ogre
     /// stream overhead = ID + size
     const long MSTREAM_OVERHEAD_SIZE = sizeof( uint16 ) + sizeof( uint32 );
     //---------------------------------------------------------------------
-    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) : mVaoManager( vaoManager )
+    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) :
+        mVaoManager( vaoManager ),
+        mVertexDataInPlace( false ),
+        mIndexDataInPlace( false )
     {
         // Version number
         mVersion = "[MeshSerializer_v2.1 R2]";
@@ -127,6 +130,11 @@ namespace Ogre
         // Determine endianness (must be the first thing we do!)
         determineEndianness( stream );
 
+        // Mesh::prepareImpl already has the whole file in RAM. Don't copy it yet again
+        const bool isMemoryStream = dynamic_cast<MemoryDataStream *>( stream.get() ) != 0;
+        mVertexDataInPlace = isMemoryStream && !mFlipEndian && !pMesh->isVertexBufferShadowed();
+        mIndexDataInPlace = isMemoryStream && !mFlipEndian && !pMesh->isIndexBufferShadowed();
+
 #if OGRE_SERIALIZER_VALIDATE_CHUNKSIZE
         enableValidation();
 #endif
@@ -892,34 +900,40 @@ namespace Ogre
         }
         catch( Exception & )
         {
-            SubMeshLodVec::iterator itor = totalSubmeshLods.begin();
-            SubMeshLodVec::iterator endt = totalSubmeshLods.end();
+            freeSubMeshLodData( totalSubmeshLods );
 
-            while( itor != endt )
+            // TODO: Delete created mVaos. Don't erase the data from those vaos?
+
+            throw;
+        }
+
+        popInnerChunk( stream );
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::freeSubMeshLodData( SubMeshLodVec &submeshLods )
+    {
+        SubMeshLodVec::iterator itor = submeshLods.begin();
+        SubMeshLodVec::iterator endt = submeshLods.end();
+
+        while( itor != endt )
+        {
+            if( !itor->vertexDataInPlace )
             {
                 Uint8Vec::iterator it = itor->vertexBuffers.begin();
                 Uint8Vec::iterator en = itor->vertexBuffers.end();
 
                 while( it != en )
                     OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
-
-                itor->vertexBuffers.clear();
-
-                if( itor->indexData )
-                {
-                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
-                    itor->indexData = 0;
-                }
-
-                ++itor;
             }
 
-            // TODO: Delete created mVaos. Don't erase the data from those vaos?
+            itor->vertexBuffers.clear();
 
-            throw;
-        }
+            if( itor->indexData && !itor->indexDataInPlace )
+                OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
+            itor->indexData = 0;
 
-        popInnerChunk( stream );
+            ++itor;
+        }
     }
     //---------------------------------------------------------------------
     void MeshSerializerImpl::createSubMeshVao( SubMesh *sm, SubMeshLodVec &submeshLods,
@@ -948,7 +962,8 @@ namespace Ogre
 
                     if( !sm->mParent->isVertexBufferShadowed() )
                     {
-                        OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
+                        if( !subMeshLod.vertexDataInPlace )
+                            OGRE_FREE_SIMD( submeshLods[i].vertexBuffers[0], MEMCATEGORY_GEOMETRY );
                         submeshLods[i].vertexBuffers.erase( submeshLods[i].vertexBuffers.begin() );
                     }
 
@@ -994,7 +1009,8 @@ namespace Ogre
 
                 if( !sm->mParent->isIndexBufferShadowed() )
                 {
-                    OGRE_FREE_SIMD( subMeshLod.indexData, MEMCATEGORY_GEOMETRY );
+                    if( !subMeshLod.indexDataInPlace )
+                        OGRE_FREE_SIMD( subMeshLod.indexData, MEMCATEGORY_GEOMETRY );
                     submeshLods[i].indexData = 0;
                 }
             }
@@ -1080,7 +1096,13 @@ namespace Ogre
         {
             readBools( stream, &subLod->index32Bit, 1 );
 
-            if( subLod->index32Bit )
+            if( mIndexDataInPlace )
+            {
+                const size_t bytesPerIndex = subLod->index32Bit ? sizeof( uint32 ) : sizeof( uint16 );
+                subLod->indexData = readInPlace( stream, bytesPerIndex * subLod->numIndices );
+                subLod->indexDataInPlace = true;
+            }
+            else if( subLod->index32Bit )
             {
                 subLod->indexData =
                     OGRE_MALLOC_SIMD( sizeof( uint32 ) * subLod->numIndices, MEMCATEGORY_GEOMETRY );
@@ -1096,6 +1118,22 @@ namespace Ogre
         }
     }
     //---------------------------------------------------------------------
+    uint8 *MeshSerializerImpl::readInPlace( DataStreamPtr &stream, size_t numBytes )
+    {
+        MemoryDataStream *memoryStream = static_cast<MemoryDataStream *>( stream.get() );
+
+        if( memoryStream->tell() + numBytes > memoryStream->size() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Unexpected end of stream reading " + stream->getName(),
+                         "MeshSerializerImpl::readInPlace" );
+        }
+
+        uint8 *retVal = memoryStream->getCurrentPtr();
+        memoryStream->skip( static_cast<long>( numBytes ) );
+        return retVal;
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::readGeometry( DataStreamPtr &stream, SubMeshLod *subLod )
     {
         readInts( stream, &subLod->numVertices, 1 );
@@ -1187,6 +1225,14 @@ namespace Ogre
                          "MeshSerializerImpl::readVertexBuffer" );
         }
 
+        if( mVertexDataInPlace )
+        {
+            subLod->vertexBuffers[source] =
+                readInPlace( stream, sizeof( uint8 ) * bytesPerVertex * subLod->numVertices );
+            subLod->vertexDataInPlace = true;
+            return;
+        }
+
         uint8 *vertexData = reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD(
             sizeof( uint8 ) * bytesPerVertex * subLod->numVertices, MEMCATEGORY_GEOMETRY ) );
         subLod->vertexBuffers[source] = vertexData;
@@ -2287,7 +2333,9 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
         lodSource( 0 ),
         index32Bit( false ),
         numIndices( 0 ),
-        indexData( 0 )
+        indexData( 0 ),
+        vertexDataInPlace( false ),
+        indexDataInPlace( false )
     {
     }
 
@@ -2351,27 +2399,7 @@ edgeData->triangleFaceNormals.begin(); for ( ; t != edgeData->triangles.end(); +
         }
         catch( Exception & )
         {
-            SubMeshLodVec::iterator itor = totalSubmeshLods.begin();
-            SubMeshLodVec::iterator endt = totalSubmeshLods.end();
-
-            while( itor != endt )
-            {
-                Uint8Vec::iterator it = itor->vertexBuffers.begin();
-                Uint8Vec::iterator en = itor->vertexBuffers.end();
-
-                while( it != en )
-                    OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
-
-                itor->vertexBuffers.clear();
-
-                if( itor->indexData )
-                {
-                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
-                    itor->indexData = 0;
-                }
-
-                ++itor;
-            }
+            freeSubMeshLodData( totalSubmeshLods );
 
             // TODO: Delete created mVaos. Don't erase the data from those vaos?
 
@@ -29,16 +29,22 @@ THE SOFTWARE.
 
 #include "OgreMeshManager2.h"
 
+#include "OgreArchive.h"
 #include "OgreException.h"
+#include "OgreLogManager.h"
 #include "OgreMatrix4.h"
 #include "OgreMesh2.h"
 #include "OgreMeshManager.h"
 #include "OgrePatchMesh.h"
 #include "OgrePrefabFactory.h"
+#include "OgreStringConverter.h"
 #include "OgreSubMesh2.h"
 
 namespace Ogre
 {
+    unsigned long updateMeshBackgroundLoadThread( ThreadHandle *threadHandle );
+    THREAD_DECLARE( updateMeshBackgroundLoadThread );
+
     template <>
     MeshManager *Singleton<MeshManager>::msSingleton = 0;
     //-----------------------------------------------------------------------
@@ -49,7 +55,11 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
-    MeshManager::MeshManager() : mVaoManager( 0 ), mBoundsPaddingFactor( Real( 0.01 ) )
+    MeshManager::MeshManager() :
+        mVaoManager( 0 ),
+        mBoundsPaddingFactor( Real( 0.01 ) ),
+        mNumBackgroundLoadsInFlight( 0u ),
+        mShuttingDown( false )
     {
         mLoadOrder = 300.0f;
         mResourceType = "Mesh2";
@@ -59,9 +69,26 @@ namespace Ogre
     //-----------------------------------------------------------------------
     MeshManager::~MeshManager()
     {
+        destroyBackgroundLoadThread();
+
+        mPendingBackgroundLoads.clear();
+        mFinishedBackgroundLoads.clear();
+
         ResourceGroupManager::getSingleton()._unregisterResourceManager( mResourceType );
     }
     //-----------------------------------------------------------------------
+    void MeshManager::destroyBackgroundLoadThread()
+    {
+        if( mBackgroundLoadThread.empty() )
+            return;
+
+        mShuttingDown = true;
+        mBackgroundLoadEvent.wake();
+        Threads::WaitForThreads( mBackgroundLoadThread );
+        mBackgroundLoadThread.clear();
+        mShuttingDown = false;
+    }
+    //-----------------------------------------------------------------------
     MeshPtr MeshManager::getByName( const String &name, const String &groupName )
     {
         return std::static_pointer_cast<Mesh>( getResourceByName( name, groupName ) );
@@ -112,6 +139,210 @@ namespace Ogre
         return pMesh;
     }
     //-----------------------------------------------------------------------
+    MeshPtr MeshManager::loadInBackground( const String &filename, const String &groupName,
+                                           BufferType vertexBufferType, BufferType indexBufferType,
+                                           bool vertexBufferShadowed, bool indexBufferShadowed )
+    {
+        MeshPtr pMesh = std::static_pointer_cast<Mesh>(
+            createOrRetrieve( filename, groupName, false, 0, 0, vertexBufferType, indexBufferType,
+                              vertexBufferShadowed, indexBufferShadowed )
+                .first );
+
+        const Resource::LoadingState loadingState = pMesh->getLoadingState();
+        if( loadingState == Resource::LOADSTATE_PREPARED )
+        {
+            // The IO is already done. What remains must happen in this thread anyway
+            pMesh->load();
+        }
+
+        if( loadingState != Resource::LOADSTATE_UNLOADED || pMesh->isManuallyLoaded() )
+            return pMesh;
+
+        // The ResourceGroupManager is not thread safe. Resolve the archive here,
+        // like TextureGpuManager does, so that the worker only has to open it.
+        ResourceGroupManager &resourceGroupManager = ResourceGroupManager::getSingleton();
+        String resolvedGroup = pMesh->getGroup();
+        if( resolvedGroup == ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME )
+            resolvedGroup = resourceGroupManager.findGroupContainingResource( filename );
+
+        BackgroundLoadRequest request;
+        request.mesh = pMesh;
+        request.archive = resourceGroupManager._getArchiveToResource( filename, resolvedGroup );
+        request.errorCode = 0;
+
+#if OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN
+        if( mBackgroundLoadThread.empty() )
+        {
+            mBackgroundLoadThread.push_back(
+                Threads::CreateThread( THREAD_GET( updateMeshBackgroundLoadThread ), 0, this ) );
+        }
+#endif
+
+        mBackgroundLoadMutex.lock();
+        mPendingBackgroundLoads.push_back( request );
+        mBackgroundLoadMutex.unlock();
+        ++mNumBackgroundLoadsInFlight;
+
+        mBackgroundLoadEvent.wake();
+
+        return pMesh;
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::processBackgroundLoads()
+    {
+        mBackgroundLoadMutex.lock();
+        mWorkerBackgroundLoads.swap( mPendingBackgroundLoads );
+        mBackgroundLoadMutex.unlock();
+
+        if( mWorkerBackgroundLoads.empty() )
+            return;
+
+        BackgroundLoadRequestVec::iterator itor = mWorkerBackgroundLoads.begin();
+        BackgroundLoadRequestVec::iterator endt = mWorkerBackgroundLoads.end();
+
+        while( itor != endt )
+        {
+            try
+            {
+                const String &name = itor->mesh->getName();
+                DataStreamPtr data = itor->archive->open( name );
+                // Fully prebuffer into host RAM, same as Mesh::prepareImpl
+                itor->data = DataStreamPtr( OGRE_NEW MemoryDataStream( name, data ) );
+            }
+            catch( Exception &e )
+            {
+                itor->error = e.getFullDescription();
+                itor->errorCode = e.getNumber();
+            }
+            ++itor;
+        }
+
+        // Never release the last reference to a Mesh from this thread:
+        // hand them over to the main thread before clearing our list.
+        mBackgroundLoadMutex.lock();
+        mFinishedBackgroundLoads.insert( mFinishedBackgroundLoads.end(),
+                                         mWorkerBackgroundLoads.begin(), mWorkerBackgroundLoads.end() );
+        mBackgroundLoadMutex.unlock();
+
+        mWorkerBackgroundLoads.clear();
+
+        mBackgroundLoadDoneEvent.wake();
+    }
+    //-----------------------------------------------------------------------
+    bool MeshManager::_update( bool syncWithWorkerThread )
+    {
+        if( !mNumBackgroundLoadsInFlight )
+            return true;
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_EMSCRIPTEN
+        processBackgroundLoads();
+#endif
+
+        if( syncWithWorkerThread )
+            mBackgroundLoadMutex.lock();
+        else if( !mBackgroundLoadMutex.tryLock() )
+            return false;
+
+        BackgroundLoadRequestVec finishedLoads;
+        finishedLoads.swap( mFinishedBackgroundLoads );
+        mBackgroundLoadMutex.unlock();
+
+        BackgroundLoadRequestVec::iterator itor = finishedLoads.begin();
+        BackgroundLoadRequestVec::iterator endt = finishedLoads.end();
+
+        while( itor != endt )
+        {
+            OGRE_ASSERT_LOW( mNumBackgroundLoadsInFlight > 0u );
+            --mNumBackgroundLoadsInFlight;
+
+            Mesh *mesh = itor->mesh.get();
+            if( mesh->getLoadingState() == Resource::LOADSTATE_UNLOADED )
+            {
+                if( itor->error.empty() )
+                {
+                    try
+                    {
+                        mesh->_setPreparedData( itor->data );
+                        mesh->load();
+                    }
+                    catch( Exception &e )
+                    {
+                        itor->error = e.getFullDescription();
+                        itor->errorCode = e.getNumber();
+                    }
+                }
+
+                if( !itor->error.empty() )
+                    reportBackgroundLoadError( mesh, itor->errorCode, itor->error );
+            }
+            // else it got loaded while we were reading it. Nothing to do
+
+            ++itor;
+        }
+
+        return mNumBackgroundLoadsInFlight == 0u;
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::reportBackgroundLoadError( Mesh *mesh, int code, const String &description )
+    {
+        LogManager::getSingleton().logMessage(
+            "ERROR: Could not load Mesh " + mesh->getName() + " in background: " + description,
+            LML_CRITICAL );
+
+        BackgroundLoadError error;
+        error.meshName = mesh->getName();
+        error.groupName = mesh->getGroup();
+        error.code = code;
+        error.description = description;
+        mBackgroundLoadErrors.push_back( error );
+
+        mesh->_fireLoadingFailed( description );
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::waitForBackgroundLoads()
+    {
+        while( !_update( true ) )
+            mBackgroundLoadDoneEvent.wait();
+
+        if( !mBackgroundLoadErrors.empty() )
+        {
+            String description = StringConverter::toString( mBackgroundLoadErrors.size() ) +
+                                 " Mesh(es) failed to load in background:";
+
+            BackgroundLoadErrorVec::const_iterator itor = mBackgroundLoadErrors.begin();
+            BackgroundLoadErrorVec::const_iterator endt = mBackgroundLoadErrors.end();
+
+            while( itor != endt )
+            {
+                description += "\n" + itor->meshName + ": " + itor->description;
+                ++itor;
+            }
+
+            const int code = mBackgroundLoadErrors.front().code;
+            mBackgroundLoadErrors.clear();
+
+            OGRE_EXCEPT( static_cast<Exception::ExceptionCodes>( code ), description,
+                         "MeshManager::waitForBackgroundLoads" );
+        }
+    }
+    //-----------------------------------------------------------------------
+    unsigned long updateMeshBackgroundLoadThread( ThreadHandle *threadHandle )
+    {
+        MeshManager *meshManager = reinterpret_cast<MeshManager *>( threadHandle->getUserParam() );
+        return meshManager->_updateBackgroundLoadThread( threadHandle );
+    }
+    //-----------------------------------------------------------------------
+    unsigned long MeshManager::_updateBackgroundLoadThread( ThreadHandle * )
+    {
+        while( !mShuttingDown )
+        {
+            mBackgroundLoadEvent.wait();
+            processBackgroundLoads();
+        }
+
+        return 0;
+    }
+    //-----------------------------------------------------------------------
     MeshPtr MeshManager::create( const String &name, const String &group, bool isManual,
                                  ManualResourceLoader *loader, const NameValuePairList *createParams )
     {
@@ -67,6 +67,7 @@ namespace Ogre
         mManager( manager ),
         mLodMesh( &c_DefaultLodMesh ),
         mCurrentMeshLod( 0 ),
+        mIsOccluder( false ),
         mMinPixelSize( 0 ),
         mListener( 0 ),
         mSkeletonInstance( 0 ),
@@ -91,6 +92,7 @@ namespace Ogre
         mManager( 0 ),
         mLodMesh( &c_DefaultLodMesh ),
         mCurrentMeshLod( 0 ),
+        mIsOccluder( false ),
         mMinPixelSize( 0 ),
         mListener( 0 ),
         mSkeletonInstance( 0 ),
@@ -117,6 +119,9 @@ namespace Ogre
             static_cast<SceneNode *>( mParentNode )->detachObject( this );
         }
 
+        if( mIsOccluder )
+            mManager->_removeOccluder( this );
+
         if( mObjectMemoryManager )
             mObjectMemoryManager->objectDestroyed( mObjectData, mRenderQueueID );
 
@@ -124,6 +129,21 @@ namespace Ogre
         assert( !mSkeletonInstance );
     }
     //-----------------------------------------------------------------------
+    void MovableObject::setOccluder( bool bOccluder )
+    {
+        if( mIsOccluder == bOccluder )
+            return;
+
+        OGRE_ASSERT_LOW( mManager && "Only objects created by a SceneManager can be occluders" );
+
+        if( bOccluder )
+            mManager->_addOccluder( this );
+        else
+            mManager->_removeOccluder( this );
+
+        mIsOccluder = bOccluder;
+    }
+    //-----------------------------------------------------------------------
     void MovableObject::_notifyAttached( Node *parent )
     {
         assert( !mParentNode || !parent );
@@ -335,6 +355,9 @@ namespace Ogre
 
         mObjectData.mWorldAabb->setFromAabb( retVal, mObjectData.mIndex );
 
+        if( mObjectMemoryManager->getClusterCulling() )
+            mObjectMemoryManager->_growCluster( mObjectData, mRenderQueueID, retVal );
+
 #if OGRE_DEBUG_MODE
         mCachedAabbOutOfDate = false;
 #endif
@@ -449,141 +472,147 @@ namespace Ogre
         return cameraDir.dotProduct( worldAabb->mCenter - cameraPos ) - *worldRadius;
     }
     //-----------------------------------------------------------------------
-    void MovableObject::cullFrustum( const size_t numNodes, ObjectData objData, const Camera *frustum,
-                                     uint32 sceneVisibilityFlags, MovableObjectArray &outCulledObjects,
-                                     const Camera *lodCamera )
+    struct MovableObject::ArrayFrustumCullParams
     {
-        // On threaded environments, the internal variables from outCulledObjects cause
-        // a false cache sharing because they're too close to each other. Perfoming
-        // a swap places those internal vars in the local stack, increasing scalability
-        MovableObjectArray culledObjects;
-        culledObjects.swap( outCulledObjects );
-
         // Thanks to Fabian Giesen for summing up all known methods of frustum culling:
         // http://fgiesen.wordpress.com/2010/10/17/view-frustum-culling/
         // (we use method Method 5: "If you really don't care whether a box is
         // partially or fully inside"):
         // vector4 signFlip = componentwise_and(plane, 0x80000000);
         // return dot3(center + xor(extent, signFlip), plane) > -plane.w;
-        struct ArrayPlane
-        {
-            ArrayVector3 planeNormal;
-            ArrayVector3 signFlip;
-            ArrayReal planeNegD;
-        };
-
-        ArrayVector3 cameraPos, cameraDir, lodCameraPos;
-        cameraPos.setAll( frustum->_getCachedDerivedPosition() );
-        cameraDir.setAll( -frustum->_getCachedDerivedOrientation().zAxis() );
-        lodCameraPos.setAll( lodCamera->_getCachedDerivedPosition() );
+        ArrayVector3 planeNormal[6];
+        ArrayVector3 signFlip[6];
+        ArrayReal    planeNegD[6];
+
+        ArrayVector3 cameraPos;
+        ArrayVector3 cameraDir;
+        ArrayVector3 lodCameraPos;
+
+        ArrayInt   includeNonCasters;
+        ArrayInt   sceneFlags;
+        ArrayMaskR ignoreRenderingDistance;
+
+        uint32 cameraSortMode;
+        size_t isShadowMappingCasterPass;
+    };
+    //-----------------------------------------------------------------------
+    inline void MovableObject::setupFrustumCullParams( ArrayFrustumCullParams &outParams,
+                                                       const Camera *frustum,
+                                                       uint32 sceneVisibilityFlags,
+                                                       const Camera *lodCamera )
+    {
+        outParams.cameraPos.setAll( frustum->_getCachedDerivedPosition() );
+        outParams.cameraDir.setAll( -frustum->_getCachedDerivedOrientation().zAxis() );
+        outParams.lodCameraPos.setAll( lodCamera->_getCachedDerivedPosition() );
 
-        const Camera::CameraSortMode cameraSortMode = frustum->mSortMode;
+        outParams.cameraSortMode = frustum->mSortMode;
 
         // Flip the bit from shadow caster, and leave only that in "includeNonCasters"
         const uint32 includeNonCastersTest =
             ( ( ( sceneVisibilityFlags & LAYER_SHADOW_CASTER ) ^ std::numeric_limits<uint32>::max() ) &
               LAYER_SHADOW_CASTER );
 
-        ArrayInt includeNonCasters = Mathlib::SetAll( includeNonCastersTest );
+        outParams.includeNonCasters = Mathlib::SetAll( includeNonCastersTest );
 
-        const bool isShadowMappingCasterPass = includeNonCastersTest == 0;
+        outParams.isShadowMappingCasterPass = includeNonCastersTest == 0 ? 1u : 0u;
 
         sceneVisibilityFlags &= RESERVED_VISIBILITY_FLAGS;
 
-        ArrayInt sceneFlags = Mathlib::SetAll( sceneVisibilityFlags );
-        ArrayPlane planes[6];
+        outParams.sceneFlags = Mathlib::SetAll( sceneVisibilityFlags );
         const Plane *frustumPlanes = frustum->_getCachedFrustumPlanes();
 
         for( size_t i = 0; i < 6; ++i )
         {
-            planes[i].planeNormal.setAll( frustumPlanes[i].normal );
-            planes[i].signFlip.setAll( frustumPlanes[i].normal );
-            planes[i].signFlip.setToSign();
-            planes[i].planeNegD = Mathlib::SetAll( -frustumPlanes[i].d );
+            outParams.planeNormal[i].setAll( frustumPlanes[i].normal );
+            outParams.signFlip[i].setAll( frustumPlanes[i].normal );
+            outParams.signFlip[i].setToSign();
+            outParams.planeNegD[i] = Mathlib::SetAll( -frustumPlanes[i].d );
         }
 
-        const ArrayMaskR ignoreRenderingDistance =
+        outParams.ignoreRenderingDistance =
             CastIntToReal( Mathlib::SetAll( lodCamera->getUseRenderingDistance() ? 0 : 0xffffffff ) );
+    }
+    //-----------------------------------------------------------------------
+    inline uint32 MovableObject::cullFrustumPack( const ArrayFrustumCullParams &params,
+                                                  const ObjectData &objData )
+    {
+        ArrayInt *RESTRICT_ALIAS visibilityFlags =
+            reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
+        ArrayReal *RESTRICT_ALIAS worldRadius =
+            reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mWorldRadius );
+        ArrayReal *RESTRICT_ALIAS upperDistance = reinterpret_cast<ArrayReal * RESTRICT_ALIAS>(
+            objData.mUpperDistance[params.isShadowMappingCasterPass] );
+        ArrayReal *RESTRICT_ALIAS distanceToCamera =
+            reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mDistanceToCamera );
 
         // TODO: Profile whether we should use XOR to flip the sign or simple multiplication.
         // In theory xor is faster, but some archs have a penalty for switching between integer
         //& floating point, even if it's simd sse
-        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
-        {
-            ArrayInt *RESTRICT_ALIAS visibilityFlags =
-                reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
-            ArrayReal *RESTRICT_ALIAS worldRadius =
-                reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mWorldRadius );
-            ArrayReal *RESTRICT_ALIAS upperDistance = reinterpret_cast<ArrayReal * RESTRICT_ALIAS>(
-                objData.mUpperDistance[isShadowMappingCasterPass] );
-            ArrayReal *RESTRICT_ALIAS distanceToCamera =
-                reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( objData.mDistanceToCamera );
-
-            // Test all 6 planes and AND the dot product. If one is false, then we're not visible
-            ArrayReal dotResult;
-            ArrayMaskR mask;
-            ArrayVector3 centerPlusFlippedHS;
-            centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[0].signFlip;
-            dotResult = planes[0].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::CompareGreater( dotResult, planes[0].planeNegD );
 
-            centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[1].signFlip;
-            dotResult = planes[1].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[1].planeNegD ) );
-
-            centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[2].signFlip;
-            dotResult = planes[2].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[2].planeNegD ) );
+        // Test all 6 planes and AND the dot product. If one is false, then we're not visible
+        ArrayReal dotResult;
+        ArrayMaskR mask;
+        ArrayVector3 centerPlusFlippedHS;
+        centerPlusFlippedHS =
+            objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * params.signFlip[0];
+        dotResult = params.planeNormal[0].dotProduct( centerPlusFlippedHS );
+        mask = Mathlib::CompareGreater( dotResult, params.planeNegD[0] );
 
+        for( size_t i = 1; i < 6; ++i )
+        {
             centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[3].signFlip;
-            dotResult = planes[3].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[3].planeNegD ) );
+                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * params.signFlip[i];
+            dotResult = params.planeNormal[i].dotProduct( centerPlusFlippedHS );
+            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, params.planeNegD[i] ) );
+        }
 
-            centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[4].signFlip;
-            dotResult = planes[4].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[4].planeNegD ) );
+        // Always pass the test if any of the components were
+        // Infinity (dot product above could've caused nans)
+        ArrayMaskR tmpMask =
+            Mathlib::Or( Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[0] ),
+                         Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[1] ) );
+        mask = Mathlib::Or( Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[2] ), mask );
 
-            centerPlusFlippedHS =
-                objData.mWorldAabb->mCenter + objData.mWorldAabb->mHalfSize * planes[5].signFlip;
-            dotResult = planes[5].planeNormal.dotProduct( centerPlusFlippedHS );
-            mask = Mathlib::And( mask, Mathlib::CompareGreater( dotResult, planes[5].planeNegD ) );
+        ArrayReal distance = params.lodCameraPos.distance( objData.mWorldAabb->mCenter );
+        ArrayMaskR isCloseEnough = Mathlib::CompareLessEqual( distance, *worldRadius + *upperDistance );
+        isCloseEnough = Mathlib::Or( params.ignoreRenderingDistance, isCloseEnough );
 
-            // Always pass the test if any of the components were
-            // Infinity (dot product above could've caused nans)
-            ArrayMaskR tmpMask =
-                Mathlib::Or( Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[0] ),
-                             Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[1] ) );
-            mask =
-                Mathlib::Or( Mathlib::isInfinity( objData.mWorldAabb->mHalfSize.mChunkBase[2] ), mask );
+        mask = Mathlib::And( Mathlib::Or( mask, tmpMask ), isCloseEnough );
 
-            ArrayReal distance = lodCameraPos.distance( objData.mWorldAabb->mCenter );
-            ArrayMaskR isCloseEnough =
-                Mathlib::CompareLessEqual( distance, *worldRadius + *upperDistance );
-            isCloseEnough = Mathlib::Or( ignoreRenderingDistance, isCloseEnough );
+        // isVisible = isVisible() && (isCaster || includeNonCasters)
+        ArrayMaskI isVisible = Mathlib::And(
+            Mathlib::TestFlags4( *visibilityFlags, Mathlib::SetAll( LAYER_VISIBILITY ) ),
+            Mathlib::TestFlags4( Mathlib::Or( *visibilityFlags, params.includeNonCasters ),
+                                 Mathlib::SetAll( LAYER_SHADOW_CASTER ) ) );
 
-            mask = Mathlib::And( Mathlib::Or( mask, tmpMask ), isCloseEnough );
+        *distanceToCamera = calculateCameraDistance( params.cameraSortMode, params.cameraPos,
+                                                     params.cameraDir, objData.mWorldAabb, worldRadius );
 
-            // isVisible = isVisible() && (isCaster || includeNonCasters)
-            ArrayMaskI isVisible = Mathlib::And(
-                Mathlib::TestFlags4( *visibilityFlags, Mathlib::SetAll( LAYER_VISIBILITY ) ),
-                Mathlib::TestFlags4( Mathlib::Or( *visibilityFlags, includeNonCasters ),
-                                     Mathlib::SetAll( LAYER_SHADOW_CASTER ) ) );
+        // Fuse result with visibility flag
+        // finalMask = ((visible|infinite_aabb) & sceneFlags & visibilityFlags) != 0 ? 0xffffffff : 0
+        ArrayMaskI finalMask = Mathlib::TestFlags4( CastRealToInt( mask ),
+                                                    Mathlib::And( params.sceneFlags, *visibilityFlags ) );
+        finalMask = Mathlib::And( finalMask, isVisible );
 
-            *distanceToCamera = calculateCameraDistance( cameraSortMode, cameraPos, cameraDir,
-                                                         objData.mWorldAabb, worldRadius );
+        return BooleanMask4::getScalarMask( finalMask );
+    }
+    //-----------------------------------------------------------------------
+    void MovableObject::cullFrustum( const size_t numNodes, ObjectData objData, const Camera *frustum,
+                                     uint32 sceneVisibilityFlags, MovableObjectArray &outCulledObjects,
+                                     const Camera *lodCamera )
+    {
+        // On threaded environments, the internal variables from outCulledObjects cause
+        // a false cache sharing because they're too close to each other. Perfoming
+        // a swap places those internal vars in the local stack, increasing scalability
+        MovableObjectArray culledObjects;
+        culledObjects.swap( outCulledObjects );
 
-            // Fuse result with visibility flag
-            // finalMask = ((visible|infinite_aabb) & sceneFlags & visibilityFlags) != 0 ? 0xffffffff : 0
-            ArrayMaskI finalMask = Mathlib::TestFlags4( CastRealToInt( mask ),
-                                                        Mathlib::And( sceneFlags, *visibilityFlags ) );
-            finalMask = Mathlib::And( finalMask, isVisible );
+        ArrayFrustumCullParams params;
+        setupFrustumCullParams( params, frustum, sceneVisibilityFlags, lodCamera );
 
-            const uint32 scalarMask = BooleanMask4::getScalarMask( finalMask );
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
+            const uint32 scalarMask = cullFrustumPack( params, objData );
 
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
@@ -602,6 +631,42 @@ namespace Ogre
         culledObjects.swap( outCulledObjects );
     }
     //-----------------------------------------------------------------------
+    void MovableObject::cullFrustumBatch( const size_t numNodes, ObjectData objData,
+                                          const Camera *const *frustums,
+                                          const uint32 *sceneVisibilityFlags,
+                                          const Camera *const *lodCameras, const size_t numFrustums,
+                                          MovableObjectArray *outCulledObjects,
+                                          FastArray<RealAsUint> *outDistances )
+    {
+        ArrayFrustumCullParams *params =
+            OGRE_ALLOC_T_SIMD( ArrayFrustumCullParams, numFrustums, MEMCATEGORY_SCENE_CONTROL );
+
+        for( size_t i = 0; i < numFrustums; ++i )
+            setupFrustumCullParams( params[i], frustums[i], sceneVisibilityFlags[i], lodCameras[i] );
+
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
+            // Test the pack against all frustums while it's still in cache
+            for( size_t k = 0; k < numFrustums; ++k )
+            {
+                const uint32 scalarMask = cullFrustumPack( params[k], objData );
+
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    if( IS_BIT_SET( j, scalarMask ) )
+                    {
+                        outCulledObjects[k].push_back( objData.mOwner[j] );
+                        outDistances[k].push_back( objData.mDistanceToCamera[j] );
+                    }
+                }
+            }
+
+            objData.advanceFrustumPack();
+        }
+
+        OGRE_FREE_SIMD( params, MEMCATEGORY_SCENE_CONTROL );
+    }
+    //-----------------------------------------------------------------------
     void MovableObject::cullLights( const size_t numNodes, ObjectData objData, uint32 sceneLightMask,
                                     LightListInfo &outGlobalLightList, const FrustumVec &frustums,
                                     const FrustumVec &cubemapFrustums )
@@ -424,106 +424,150 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------
-    void Node::updateAllTransforms( const size_t numNodes, Transform t )
+    inline void Node::updateTransformPack( const Transform &t )
     {
-        ArrayMatrix4 derivedTransform;
-        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
-        {
 #if OGRE_NODE_INHERIT_TRANSFORM
-            // determine our transform, without parent part
-            ArrayMatrix4 trSoA;
-            trSoA.makeTransform( *t.mPosition, *t.mScale, *t.mOrientation );
+        // determine our transform, without parent part
+        ArrayMatrix4 trSoA;
+        trSoA.makeTransform( *t.mPosition, *t.mScale, *t.mOrientation );
 
-            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
-            {
-                const Transform &parentTransform = t.mParents[j]->mTransform;
-                const Matrix4 &parentFullTransform =
-                    parentTransform.mDerivedTransform[parentTransform.mIndex];
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            const Transform &parentTransform = t.mParents[j]->mTransform;
+            const Matrix4 &parentFullTransform =
+                parentTransform.mDerivedTransform[parentTransform.mIndex];
 
-                Matrix4 tr;
-                trSoA.getAsMatrix4( tr, j );
+            Matrix4 tr;
+            trSoA.getAsMatrix4( tr, j );
 
-                if( t.mInheritOrientation[j] && t.mInheritScale[j] )  // everything is inherited
-                {
-                    t.mDerivedTransform[j] = parentFullTransform * tr;
-                }
-                else if( !t.mInheritOrientation[j] &&
-                         !t.mInheritScale[j] )  // only position is inherited
-                {
-                    t.mDerivedTransform[j] = tr;
-                    t.mDerivedTransform[j].setTrans( tr.getTrans() + parentFullTransform.getTrans() );
-                }
-                else  // shear is inherited together with orientation, controlled by mInheritOrientation
-                {
-                    Ogre::Vector3 parentScale(
-                        parentFullTransform.transformDirectionAffine( Vector3::UNIT_X ).length(),
-                        parentFullTransform.transformDirectionAffine( Vector3::UNIT_Y ).length(),
-                        parentFullTransform.transformDirectionAffine( Vector3::UNIT_Z ).length() );
-
-                    assert( t.mInheritOrientation[j] ^ t.mInheritScale[j] );
-                    t.mDerivedTransform[j] =
-                        t.mInheritOrientation[j]
-                            ? Matrix4::getScale( 1.0f / parentScale ) * parentFullTransform * tr
-                            : Matrix4::getScale( parentScale ) * tr;
-                }
+            if( t.mInheritOrientation[j] && t.mInheritScale[j] )  // everything is inherited
+            {
+                t.mDerivedTransform[j] = parentFullTransform * tr;
+            }
+            else if( !t.mInheritOrientation[j] &&
+                     !t.mInheritScale[j] )  // only position is inherited
+            {
+                t.mDerivedTransform[j] = tr;
+                t.mDerivedTransform[j].setTrans( tr.getTrans() + parentFullTransform.getTrans() );
+            }
+            else  // shear is inherited together with orientation, controlled by mInheritOrientation
+            {
+                Ogre::Vector3 parentScale(
+                    parentFullTransform.transformDirectionAffine( Vector3::UNIT_X ).length(),
+                    parentFullTransform.transformDirectionAffine( Vector3::UNIT_Y ).length(),
+                    parentFullTransform.transformDirectionAffine( Vector3::UNIT_Z ).length() );
 
-                // Decompose full transform to position, orientation and scale, shear is lost here.
-                Vector3 pos, scale;
-                Quaternion qRot;
-                t.mDerivedTransform[j].decomposition( pos, scale, qRot );
-                t.mDerivedPosition->setFromVector3( pos, j );
-                t.mDerivedScale->setFromVector3( scale, j );
-                t.mDerivedOrientation->setFromQuaternion( qRot, j );
+                assert( t.mInheritOrientation[j] ^ t.mInheritScale[j] );
+                t.mDerivedTransform[j] =
+                    t.mInheritOrientation[j]
+                        ? Matrix4::getScale( 1.0f / parentScale ) * parentFullTransform * tr
+                        : Matrix4::getScale( parentScale ) * tr;
             }
+
+            // Decompose full transform to position, orientation and scale, shear is lost here.
+            Vector3 pos, scale;
+            Quaternion qRot;
+            t.mDerivedTransform[j].decomposition( pos, scale, qRot );
+            t.mDerivedPosition->setFromVector3( pos, j );
+            t.mDerivedScale->setFromVector3( scale, j );
+            t.mDerivedOrientation->setFromQuaternion( qRot, j );
+        }
 #else
-            // Retrieve from parents. Unfortunately we need to do SoA -> AoS -> SoA conversion
-            ArrayVector3 parentPos, parentScale;
-            ArrayQuaternion parentRot;
+        // Retrieve from parents. Unfortunately we need to do SoA -> AoS -> SoA conversion
+        ArrayVector3 parentPos, parentScale;
+        ArrayQuaternion parentRot;
 
-            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
-            {
-                Vector3 pos, scale;
-                Quaternion qRot;
-                const Transform &parentTransform = t.mParents[j]->mTransform;
-                parentTransform.mDerivedPosition->getAsVector3( pos, parentTransform.mIndex );
-                parentTransform.mDerivedOrientation->getAsQuaternion( qRot, parentTransform.mIndex );
-                parentTransform.mDerivedScale->getAsVector3( scale, parentTransform.mIndex );
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            Vector3 pos, scale;
+            Quaternion qRot;
+            const Transform &parentTransform = t.mParents[j]->mTransform;
+            parentTransform.mDerivedPosition->getAsVector3( pos, parentTransform.mIndex );
+            parentTransform.mDerivedOrientation->getAsQuaternion( qRot, parentTransform.mIndex );
+            parentTransform.mDerivedScale->getAsVector3( scale, parentTransform.mIndex );
 
-                parentPos.setFromVector3( pos, j );
-                parentRot.setFromQuaternion( qRot, j );
-                parentScale.setFromVector3( scale, j );
-            }
+            parentPos.setFromVector3( pos, j );
+            parentRot.setFromQuaternion( qRot, j );
+            parentScale.setFromVector3( scale, j );
+        }
 
-            // Change position vector based on parent's orientation & scale
-            *t.mDerivedPosition = parentRot * ( parentScale * ( *t.mPosition ) );
+        // Change position vector based on parent's orientation & scale
+        *t.mDerivedPosition = parentRot * ( parentScale * ( *t.mPosition ) );
 
-            // Combine orientation with that of parent
-            *t.mDerivedOrientation =
-                ArrayQuaternion::Cmov4( parentRot * ( *t.mOrientation ), *t.mOrientation,
-                                        BooleanMask4::getMask( t.mInheritOrientation ) );
+        // Combine orientation with that of parent
+        *t.mDerivedOrientation =
+            ArrayQuaternion::Cmov4( parentRot * ( *t.mOrientation ), *t.mOrientation,
+                                    BooleanMask4::getMask( t.mInheritOrientation ) );
 
-            // Scale own position by parent scale, NB just combine
-            // as equivalent axes, no shearing
-            *t.mDerivedScale = ArrayVector3::Cmov4( parentScale * ( *t.mScale ), *t.mScale,
-                                                    BooleanMask4::getMask( t.mInheritScale ) );
+        // Scale own position by parent scale, NB just combine
+        // as equivalent axes, no shearing
+        *t.mDerivedScale = ArrayVector3::Cmov4( parentScale * ( *t.mScale ), *t.mScale,
+                                                BooleanMask4::getMask( t.mInheritScale ) );
 
-            // Add altered position vector to parents
-            *t.mDerivedPosition += parentPos;
+        // Add altered position vector to parents
+        *t.mDerivedPosition += parentPos;
 
-            derivedTransform.makeTransform( *t.mDerivedPosition, *t.mDerivedScale,
-                                            *t.mDerivedOrientation );
-            derivedTransform.storeToAoS( t.mDerivedTransform );
+        ArrayMatrix4 derivedTransform;
+        derivedTransform.makeTransform( *t.mDerivedPosition, *t.mDerivedScale,
+                                        *t.mDerivedOrientation );
+        derivedTransform.storeToAoS( t.mDerivedTransform );
 #endif
 #if OGRE_DEBUG_MODE >= OGRE_DEBUG_MEDIUM
+        for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+        {
+            if( t.mOwner[j] )
+                t.mOwner[j]->mCachedTransformOutOfDate = false;
+        }
+#endif
+    }
+    //-----------------------------------------------------------------------
+    size_t Node::updateAllTransforms( const size_t numNodes, Transform t )
+    {
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
+            updateTransformPack( t );
+
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                t.mDirty[j] = Transform::DirtyDerived;
+
+            t.advancePack();
+        }
+
+        return numNodes;
+    }
+    //-----------------------------------------------------------------------
+    size_t Node::updateDirtyTransforms( const size_t numNodes, Transform t )
+    {
+        size_t numUpdated = 0;
+
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
+            // We must be updated if we changed, or if our parent was updated
+            uint8 dirty[ARRAY_PACKED_REALS];
+            uint8 anyDirty = 0;
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
-                if( t.mOwner[j] )
-                    t.mOwner[j]->mCachedTransformOutOfDate = false;
+                const Transform &parentTransform = t.mParents[j]->mTransform;
+                dirty[j] = ( t.mDirty[j] & Transform::DirtyLocal ) |
+                           ( parentTransform.mDirty[parentTransform.mIndex] & Transform::DirtyDerived );
+                anyDirty |= dirty[j];
             }
-#endif
+
+            if( anyDirty )
+            {
+                // The whole pack is updated at once, but only the nodes that actually changed
+                // force their children to update. The rest got the same result as before.
+                updateTransformPack( t );
+                numUpdated += std::min<size_t>( numNodes - i, ARRAY_PACKED_REALS );
+            }
+
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                t.mDirty[j] = dirty[j] ? static_cast<uint8>( Transform::DirtyDerived ) : 0u;
 
             t.advancePack();
         }
+
+        return numUpdated;
     }
     //-----------------------------------------------------------------------
     Node *Node::createChild( SceneMemoryMgrTypes sceneType, const Vector3 &inTranslate,
@@ -607,6 +651,7 @@ namespace Ogre
         assert( !q.isNaN() && "Invalid orientation supplied as parameter" );
         q.normalise();
         mTransform.mOrientation->setFromQuaternion( q, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -618,6 +663,8 @@ namespace Ogre
     void Node::resetOrientation()
     {
         mTransform.mOrientation->setFromQuaternion( Quaternion::IDENTITY, mTransform.mIndex );
+        _notifyTransformDirty();
+        CACHED_TRANSFORM_OUT_OF_DATE();
     }
 
     //-----------------------------------------------------------------------
@@ -625,6 +672,7 @@ namespace Ogre
     {
         assert( !pos.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mPosition->setFromVector3( pos, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -681,6 +729,7 @@ namespace Ogre
         }
 
         mTransform.mPosition->setFromVector3( position, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -751,6 +800,7 @@ namespace Ogre
         orientation.normalise();
 
         mTransform.mOrientation->setFromQuaternion( orientation, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
 
@@ -890,6 +940,7 @@ namespace Ogre
     {
         assert( !inScale.isNaN() && "Invalid vector supplied as parameter" );
         mTransform.mScale->setFromVector3( inScale, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -900,6 +951,7 @@ namespace Ogre
     void Node::setInheritOrientation( bool inherit )
     {
         mTransform.mInheritOrientation[mTransform.mIndex] = inherit;
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -911,6 +963,7 @@ namespace Ogre
     void Node::setInheritScale( bool inherit )
     {
         mTransform.mInheritScale[mTransform.mIndex] = inherit;
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
@@ -920,6 +973,7 @@ namespace Ogre
     {
         mTransform.mScale->setFromVector3(
             mTransform.mScale->getAsVector3( mTransform.mIndex ) * inScale, mTransform.mIndex );
+        _notifyTransformDirty();
         CACHED_TRANSFORM_OUT_OF_DATE();
     }
     //-----------------------------------------------------------------------
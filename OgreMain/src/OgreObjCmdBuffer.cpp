@@ -45,6 +45,8 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    ObjCmdBuffer::ObjCmdBuffer() : mCurrentSequence( 0u ) {}
+    //-----------------------------------------------------------------------------------
     ObjCmdBuffer::~ObjCmdBuffer() { clear(); }
     //-----------------------------------------------------------------------------------
     void *ObjCmdBuffer::requestMemory( size_t sizeBytes )
@@ -90,6 +92,7 @@ namespace Ogre
         }
 
         mCommandBuffer.clear();
+        mCommandSequences.clear();
         mCommandAllocator.clear();
     }
     //-----------------------------------------------------------------------------------
@@ -105,6 +108,43 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void ObjCmdBuffer::executeMerged( ObjCmdBuffer *const *cmdBuffers, size_t numCmdBuffers )
+    {
+        if( numCmdBuffers == 1u )
+        {
+            cmdBuffers[0]->execute();
+            return;
+        }
+
+        FastArray<size_t> nextCmds;
+        nextCmds.resizePOD( numCmdBuffers, 0u );
+
+        while( true )
+        {
+            // Pick the lowest sequence among the next command of each buffer.
+            // On ties, the buffer that comes first wins.
+            size_t bufferIdx = numCmdBuffers;
+            uint64 lowestSequence = 0u;
+            for( size_t i = 0u; i < numCmdBuffers; ++i )
+            {
+                const ObjCmdBuffer *cmdBuffer = cmdBuffers[i];
+                if( nextCmds[i] < cmdBuffer->mCommandBuffer.size() &&
+                    ( bufferIdx == numCmdBuffers ||
+                      cmdBuffer->mCommandSequences[nextCmds[i]] < lowestSequence ) )
+                {
+                    bufferIdx = i;
+                    lowestSequence = cmdBuffer->mCommandSequences[nextCmds[i]];
+                }
+            }
+
+            if( bufferIdx == numCmdBuffers )
+                break;
+
+            cmdBuffers[bufferIdx]->mCommandBuffer[nextCmds[bufferIdx]]->execute();
+            ++nextCmds[bufferIdx];
+        }
+    }
+    //-----------------------------------------------------------------------------------
     ObjCmdBuffer::TransitionToLoaded::TransitionToLoaded( TextureGpu *_texture, void *_sysRamCopy,
                                                           GpuResidency::GpuResidency _targetResidency ) :
         texture( _texture ),
@@ -153,13 +193,19 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     ObjCmdBuffer::ExceptionThrown::ExceptionThrown( TextureGpu *_texture, const Exception &_exception ) :
         texture( _texture ),
-        exception( _exception )
+        exception( OGRE_NEW Exception( _exception ) )
     {
     }
     //-----------------------------------------------------------------------------------
+    ObjCmdBuffer::ExceptionThrown::~ExceptionThrown()
+    {
+        OGRE_DELETE exception;
+        exception = 0;
+    }
+    //-----------------------------------------------------------------------------------
     void ObjCmdBuffer::ExceptionThrown::execute()
     {
-        texture->notifyAllListenersTextureChanged( TextureGpuListener::ExceptionThrown, &exception );
+        texture->notifyAllListenersTextureChanged( TextureGpuListener::ExceptionThrown, exception );
     }
     //-----------------------------------------------------------------------------------
     ObjCmdBuffer::UploadFromStagingTex::UploadFromStagingTex( StagingTexture *_stagingTexture,
@@ -205,4 +251,23 @@ namespace Ogre
 
         texture->notifyDataIsReady();
     }
+    //-----------------------------------------------------------------------------------
+    ObjCmdBuffer::NotifyMipsAreReady::NotifyMipsAreReady( TextureGpu *_texture,
+                                                          uint8 _mostDetailedMip ) :
+        texture( _texture ),
+        mostDetailedMip( _mostDetailedMip )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjCmdBuffer::NotifyMipsAreReady::execute()
+    {
+        texture->_notifyMostDetailedMipReady( mostDetailedMip );
+    }
+    //-----------------------------------------------------------------------------------
+    ObjCmdBuffer::LoadCancelled::LoadCancelled( TextureGpu *_texture ) : texture( _texture ) {}
+    //-----------------------------------------------------------------------------------
+    void ObjCmdBuffer::LoadCancelled::execute()
+    {
+        texture->getTextureManager()->_notifyLoadCancelled( texture );
+    }
 }  // namespace Ogre
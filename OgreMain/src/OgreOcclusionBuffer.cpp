@@ -0,0 +1,340 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreOcclusionBuffer.h"
+
+#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreMathlib.h"
+#include "OgreVector4.h"
+
+namespace Ogre
+{
+    /// Returns { 0, 1, 2, ... ARRAY_PACKED_REALS - 1 } + offset
+    static inline ArrayReal getLaneIndices( Real offset )
+    {
+        OGRE_ALIGNED_DECL( Real, laneIndices[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+            laneIndices[i] = static_cast<Real>( i ) + offset;
+        return *reinterpret_cast<const ArrayReal *>( laneIndices );
+    }
+    //-----------------------------------------------------------------------------------
+    /// Returns false for infinite, null and nan boxes
+    static inline bool isFinite( const Aabb &aabb )
+    {
+        const Real infinity = std::numeric_limits<Real>::infinity();
+        return std::abs( aabb.mHalfSize.x ) < infinity && std::abs( aabb.mHalfSize.y ) < infinity &&
+               std::abs( aabb.mHalfSize.z ) < infinity && std::abs( aabb.mCenter.x ) < infinity &&
+               std::abs( aabb.mCenter.y ) < infinity && std::abs( aabb.mCenter.z ) < infinity;
+    }
+    //-----------------------------------------------------------------------------------
+    /// Corners of the box faces, 4 per face. Bit 0 of the index selects the maximum x,
+    /// bit 1 the maximum y and bit 2 the maximum z.
+    static const uint8 c_boxFaces[6][4] = {
+        { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 },
+        { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 5, 7, 6 },
+    };
+    //-----------------------------------------------------------------------------------
+    OcclusionBuffer::OcclusionBuffer( uint32 width, uint32 height ) :
+        mWidth( 0 ),
+        mHeight( 0 ),
+        mRowPitch( 0 ),
+        mDepthBuffer( 0 ),
+        mViewProjMatrix( Matrix4::IDENTITY )
+    {
+        setResolution( width, height );
+    }
+    //-----------------------------------------------------------------------------------
+    OcclusionBuffer::~OcclusionBuffer()
+    {
+        OGRE_FREE_SIMD( mDepthBuffer, MEMCATEGORY_SCENE_CONTROL );
+        mDepthBuffer = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void OcclusionBuffer::setResolution( uint32 width, uint32 height )
+    {
+        OGRE_FREE_SIMD( mDepthBuffer, MEMCATEGORY_SCENE_CONTROL );
+        mDepthBuffer = 0;
+
+        mWidth = std::max( width, 1u );
+        mHeight = std::max( height, 1u );
+        mRowPitch = static_cast<uint32>( ( ( mWidth + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) *
+                                         ARRAY_PACKED_REALS );
+        mDepthBuffer = reinterpret_cast<Real *>( OGRE_MALLOC_SIMD(
+            sizeof( Real ) * mRowPitch * mHeight, MEMCATEGORY_SCENE_CONTROL ) );
+        std::fill( mDepthBuffer, mDepthBuffer + mRowPitch * mHeight,
+                   std::numeric_limits<Real>::infinity() );
+
+        mTriangles.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    inline bool OcclusionBuffer::projectToScreen( const Matrix4 &worldViewProj, const Vector3 &localPos,
+                                                  Real &outX, Real &outY, Real &outZ ) const
+    {
+        const Vector4 clipPos = worldViewProj * Vector4( localPos.x, localPos.y, localPos.z, 1.0f );
+
+        // Behind the near plane (or the camera itself, in which case the division below is bogus)
+        if( clipPos.w <= Real( 0.0f ) || clipPos.z < -clipPos.w )
+            return false;
+
+        const Real invW = Real( 1.0f ) / clipPos.w;
+        outX = ( clipPos.x * invW * Real( 0.5f ) + Real( 0.5f ) ) * static_cast<Real>( mWidth );
+        outY = ( Real( 0.5f ) - clipPos.y * invW * Real( 0.5f ) ) * static_cast<Real>( mHeight );
+        outZ = clipPos.z * invW;
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void OcclusionBuffer::beginOccluders( const Matrix4 &viewProjMatrix )
+    {
+        mViewProjMatrix = viewProjMatrix;
+        mTriangles.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    bool OcclusionBuffer::addOccluder( const Aabb &localBox, const Matrix4 &worldMatrix )
+    {
+        if( !isFinite( localBox ) )
+            return false;
+
+        const Matrix4 worldViewProj = mViewProjMatrix * worldMatrix;
+        const Vector3 corners[2] = { localBox.getMinimum(), localBox.getMaximum() };
+
+        Real screenX[8], screenY[8], screenZ[8];
+        for( size_t i = 0; i < 8u; ++i )
+        {
+            const Vector3 localPos( corners[i & 0x01].x, corners[( i >> 1u ) & 0x01].y,
+                                    corners[( i >> 2u ) & 0x01].z );
+            if( !projectToScreen( worldViewProj, localPos, screenX[i], screenY[i], screenZ[i] ) )
+                return false;
+        }
+
+        for( size_t i = 0; i < 6u; ++i )
+        {
+            for( size_t j = 0; j < 2u; ++j )
+            {
+                // Split each face (a, b, c, d) into (a, b, c) & (a, c, d)
+                const uint8 vertIdx[3] = { c_boxFaces[i][0], c_boxFaces[i][j + 1u],
+                                           c_boxFaces[i][j + 2u] };
+                Triangle triangle;
+                for( size_t k = 0; k < 3u; ++k )
+                {
+                    triangle.x[k] = screenX[vertIdx[k]];
+                    triangle.y[k] = screenY[vertIdx[k]];
+                    triangle.z[k] = screenZ[vertIdx[k]];
+                }
+                mTriangles.push_back( triangle );
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void OcclusionBuffer::rasterizeTriangle( const Triangle &triangle, uint32 firstRow,
+                                             uint32 lastRow )
+    {
+        Real x[3] = { triangle.x[0], triangle.x[1], triangle.x[2] };
+        Real y[3] = { triangle.y[0], triangle.y[1], triangle.y[2] };
+        Real z[3] = { triangle.z[0], triangle.z[1], triangle.z[2] };
+
+        Real area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( y[1] - y[0] ) * ( x[2] - x[0] );
+        if( area == Real( 0.0f ) )
+            return;
+        if( area < Real( 0.0f ) )
+        {
+            // We don't care about the facing, just make the winding consistent
+            std::swap( x[1], x[2] );
+            std::swap( y[1], y[2] );
+            std::swap( z[1], z[2] );
+            area = -area;
+        }
+
+        const Real fMinX = std::max( std::floor( std::min( x[0], std::min( x[1], x[2] ) ) ), Real( 0 ) );
+        const Real fMinY = std::max( std::floor( std::min( y[0], std::min( y[1], y[2] ) ) ),
+                                     static_cast<Real>( firstRow ) );
+        const Real fMaxX = std::min( std::ceil( std::max( x[0], std::max( x[1], x[2] ) ) ),
+                                     static_cast<Real>( mWidth ) );
+        const Real fMaxY = std::min( std::ceil( std::max( y[0], std::max( y[1], y[2] ) ) ),
+                                     static_cast<Real>( lastRow ) );
+
+        if( fMinX >= fMaxX || fMinY >= fMaxY )
+            return;
+
+        const uint32 minX = static_cast<uint32>( fMinX );
+        const uint32 minY = static_cast<uint32>( fMinY );
+        const uint32 maxX = static_cast<uint32>( fMaxX );
+        const uint32 maxY = static_cast<uint32>( fMaxY );
+
+        // Edge functions E(p) = A * p.x + B * p.y + C. edge[i] is the edge opposite to vertex i,
+        // so E_i(p) / area is the barycentric coordinate of vertex i.
+        Real edgeA[3], edgeB[3], edgeC[3];
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            const size_t a = ( i + 1u ) % 3u;
+            const size_t b = ( i + 2u ) % 3u;
+            edgeA[i] = y[a] - y[b];
+            edgeB[i] = x[b] - x[a];
+            edgeC[i] = x[a] * y[b] - y[a] * x[b];
+        }
+
+        // Depth is linear in screen space: z(p) = zA * p.x + zB * p.y + zC
+        const Real invArea = Real( 1.0f ) / area;
+        const Real zA = ( edgeA[0] * z[0] + edgeA[1] * z[1] + edgeA[2] * z[2] ) * invArea;
+        const Real zB = ( edgeB[0] * z[0] + edgeB[1] * z[1] + edgeB[2] * z[2] ) * invArea;
+        const Real zC = ( edgeC[0] * z[0] + edgeC[1] * z[1] + edgeC[2] * z[2] ) * invArea;
+
+        const ArrayReal laneOffsets = getLaneIndices( Real( 0.5f ) );
+        const ArrayReal vZero = Mathlib::SetAll( Real( 0.0f ) );
+        const ArrayReal vEdgeA0 = Mathlib::SetAll( edgeA[0] );
+        const ArrayReal vEdgeA1 = Mathlib::SetAll( edgeA[1] );
+        const ArrayReal vEdgeA2 = Mathlib::SetAll( edgeA[2] );
+        const ArrayReal vZA = Mathlib::SetAll( zA );
+
+        const uint32 startX = minX - ( minX % ARRAY_PACKED_REALS );
+
+        for( uint32 row = minY; row < maxY; ++row )
+        {
+            const Real py = static_cast<Real>( row ) + Real( 0.5f );
+            const ArrayReal rowEdge0 = Mathlib::SetAll( edgeB[0] * py + edgeC[0] );
+            const ArrayReal rowEdge1 = Mathlib::SetAll( edgeB[1] * py + edgeC[1] );
+            const ArrayReal rowEdge2 = Mathlib::SetAll( edgeB[2] * py + edgeC[2] );
+            const ArrayReal rowZ = Mathlib::SetAll( zB * py + zC );
+
+            ArrayReal *RESTRICT_ALIAS dstDepth =
+                reinterpret_cast<ArrayReal * RESTRICT_ALIAS>( mDepthBuffer + row * mRowPitch + startX );
+
+            for( uint32 col = startX; col < maxX; col += ARRAY_PACKED_REALS )
+            {
+                const ArrayReal px = Mathlib::SetAll( static_cast<Real>( col ) ) + laneOffsets;
+
+                ArrayMaskR inside =
+                    Mathlib::CompareGreaterEqual( vEdgeA0 * px + rowEdge0, vZero );
+                inside = Mathlib::And(
+                    inside, Mathlib::CompareGreaterEqual( vEdgeA1 * px + rowEdge1, vZero ) );
+                inside = Mathlib::And(
+                    inside, Mathlib::CompareGreaterEqual( vEdgeA2 * px + rowEdge2, vZero ) );
+
+                const ArrayReal depth = vZA * px + rowZ;
+                *dstDepth = Mathlib::CmovRobust( Mathlib::Min( *dstDepth, depth ), *dstDepth, inside );
+                ++dstDepth;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void OcclusionBuffer::rasterize( uint32 firstRow, uint32 numRows )
+    {
+        const uint32 lastRow = std::min( firstRow + numRows, mHeight );
+        if( firstRow >= lastRow )
+            return;
+
+        std::fill( mDepthBuffer + firstRow * mRowPitch, mDepthBuffer + lastRow * mRowPitch,
+                   std::numeric_limits<Real>::infinity() );
+
+        TriangleArray::const_iterator itor = mTriangles.begin();
+        TriangleArray::const_iterator endt = mTriangles.end();
+
+        while( itor != endt )
+        {
+            rasterizeTriangle( *itor, firstRow, lastRow );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool OcclusionBuffer::isOccluded( const Aabb &worldAabb ) const
+    {
+        if( !isFinite( worldAabb ) )
+            return false;
+
+        const Vector3 corners[2] = { worldAabb.getMinimum(), worldAabb.getMaximum() };
+
+        Real minX = std::numeric_limits<Real>::max();
+        Real minY = std::numeric_limits<Real>::max();
+        Real maxX = -std::numeric_limits<Real>::max();
+        Real maxY = -std::numeric_limits<Real>::max();
+        Real minZ = std::numeric_limits<Real>::max();
+
+        for( size_t i = 0; i < 8u; ++i )
+        {
+            const Vector3 worldPos( corners[i & 0x01].x, corners[( i >> 1u ) & 0x01].y,
+                                    corners[( i >> 2u ) & 0x01].z );
+            Real screenX, screenY, screenZ;
+            if( !projectToScreen( mViewProjMatrix, worldPos, screenX, screenY, screenZ ) )
+                return false;
+
+            minX = std::min( minX, screenX );
+            minY = std::min( minY, screenY );
+            maxX = std::max( maxX, screenX );
+            maxY = std::max( maxY, screenY );
+            minZ = std::min( minZ, screenZ );
+        }
+
+        // All the pixels the box touches
+        const Real fMinX = std::max( std::floor( minX ), Real( 0 ) );
+        const Real fMinY = std::max( std::floor( minY ), Real( 0 ) );
+        const Real fMaxX = std::min( std::ceil( maxX ), static_cast<Real>( mWidth ) );
+        const Real fMaxY = std::min( std::ceil( maxY ), static_cast<Real>( mHeight ) );
+
+        // Off screen. It's not up to us to decide
+        if( fMinX >= fMaxX || fMinY >= fMaxY )
+            return false;
+
+        const uint32 minCol = static_cast<uint32>( fMinX );
+        const uint32 minRow = static_cast<uint32>( fMinY );
+        const uint32 maxCol = static_cast<uint32>( fMaxX );
+        const uint32 maxRow = static_cast<uint32>( fMaxY );
+
+        const ArrayReal laneIndices = getLaneIndices( Real( 0.0f ) );
+        const ArrayReal vMinCol = Mathlib::SetAll( fMinX );
+        const ArrayReal vMaxCol = Mathlib::SetAll( fMaxX );
+        const ArrayReal vMinZ = Mathlib::SetAll( minZ );
+
+        const uint32 startCol = minCol - ( minCol % ARRAY_PACKED_REALS );
+
+        for( uint32 row = minRow; row < maxRow; ++row )
+        {
+            const ArrayReal *RESTRICT_ALIAS srcDepth = reinterpret_cast<const ArrayReal * RESTRICT_ALIAS>(
+                mDepthBuffer + row * mRowPitch + startCol );
+
+            for( uint32 col = startCol; col < maxCol; col += ARRAY_PACKED_REALS )
+            {
+                const ArrayReal vCol = Mathlib::SetAll( static_cast<Real>( col ) ) + laneIndices;
+                const ArrayMaskR inRect = Mathlib::And( Mathlib::CompareGreaterEqual( vCol, vMinCol ),
+                                                        Mathlib::CompareLess( vCol, vMaxCol ) );
+
+                // Any pixel where the occluders are not in front of the box?
+                const ArrayMaskR notHidden =
+                    Mathlib::And( inRect, Mathlib::CompareGreaterEqual( *srcDepth, vMinZ ) );
+                if( BooleanMask4::getScalarMask( notHidden ) != 0u )
+                    return false;
+
+                ++srcDepth;
+            }
+        }
+
+        return true;
+    }
+}  // namespace Ogre
@@ -12,9 +12,32 @@
 
 namespace Ogre
 {
+    namespace
+    {
+        void appendJsonString( String &outJson, const char *str )
+        {
+            outJson += '"';
+            while( *str )
+            {
+                const char c = *str++;
+                if( c == '"' || c == '\\' )
+                {
+                    outJson += '\\';
+                    outJson += c;
+                }
+                else if( static_cast<unsigned char>( c ) < 0x20u )
+                    outJson += ' ';
+                else
+                    outJson += c;
+            }
+            outJson += '"';
+        }
+    }  // namespace
+
     OfflineProfiler::OfflineProfiler() :
         mPaused( false ),
         mTlsHandle( OGRE_TLS_INVALID_HANDLE ),
+        mTimer( OGRE_NEW Ogre::Timer() ),
         mBytesPerPool( sizeof( ProfileSample ) * 10000 )
     {
         Threads::CreateTls( &mTlsHandle );
@@ -22,6 +45,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     OfflineProfiler::~OfflineProfiler()
     {
+        if( !mThreadData.empty() && !mOnShutdownTimelinePath.empty() )
+            dumpTimeline( mOnShutdownTimelinePath );
+
         if( !mThreadData.empty() &&
             ( !mOnShutdownPerFramePath.empty() || !mOnShutdownAccumPath.empty() ) )
         {
@@ -39,19 +65,26 @@ namespace Ogre
 
         Threads::DestroyTls( mTlsHandle );
         mTlsHandle = OGRE_TLS_INVALID_HANDLE;
+
+        OGRE_DELETE mTimer;
+        mTimer = 0;
     }
     //-----------------------------------------------------------------------------------
-    OfflineProfiler::PerThreadData::PerThreadData( bool startPaused, size_t bytesPerPool ) :
+    OfflineProfiler::PerThreadData::PerThreadData( bool startPaused, size_t bytesPerPool,
+                                                   Timer *profilerTimer ) :
         mPaused( startPaused ),
         mPauseRequest( startPaused ),
         mResetRequest( false ),
         mRoot( 0 ),
         mCurrentSample( 0 ),
         mTimer( OGRE_NEW Ogre::Timer() ),
+        mUsTimerOffset( profilerTimer->getMicroseconds() - mTimer->getMicroseconds() ),
         mTotalAccumTime( 0 ),
         mCurrMemoryPoolOffset( 0 ),
         mBytesPerPool( bytesPerPool )
     {
+        mThreadName[0] = '\0';
+
         createNewPool();
         mCurrentSample = allocateSample( 0 );
         mRoot = mCurrentSample;
@@ -69,6 +102,14 @@ namespace Ogre
         mTimer = 0;
     }
     //-----------------------------------------------------------------------------------
+    void OfflineProfiler::PerThreadData::setThreadName( const char *name )
+    {
+        mMutex.lock();
+        strncpy( mThreadName, name, OGRE_OFFLINE_PROFILER_NAME_STR_LENGTH - 1u );
+        mThreadName[OGRE_OFFLINE_PROFILER_NAME_STR_LENGTH - 1u] = '\0';
+        mMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
     void OfflineProfiler::PerThreadData::destroySampleAndChildren( ProfileSample *sample )
     {
         FastArray<ProfileSample *>::const_iterator itor = sample->children.begin();
@@ -205,9 +246,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     OfflineProfiler::PerThreadData *OfflineProfiler::allocatePerThreadData()
     {
-        PerThreadData *perThreadData = new PerThreadData( mPaused, mBytesPerPool );
-
         mMutex.lock();
+        PerThreadData *perThreadData = new PerThreadData( mPaused, mBytesPerPool, mTimer );
         mThreadData.push_back( perThreadData );
         mMutex.unlock();
 
@@ -334,6 +374,80 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    bool OfflineProfiler::PerThreadData::isSampleOpen( const ProfileSample *sample ) const
+    {
+        const ProfileSample *openSample = mCurrentSample;
+        while( openSample && openSample != sample )
+            openSample = openSample->parent;
+        return openSample != 0;
+    }
+    //-----------------------------------------------------------------------------------
+    void OfflineProfiler::PerThreadData::dumpTimelineSample( const ProfileSample *sample,
+                                                             LwString &tmpStr, String &outJson,
+                                                             size_t threadIdx, uint64 usNow ) const
+    {
+        outJson += ",\n{\"name\":";
+        appendJsonString( outJson, (const char *)sample->nameStr );
+
+        // Samples still open (e.g. we're being called from inside one) last until now,
+        // otherwise their children would end after them
+        const uint64 usTaken = isSampleOpen( sample ) ? usNow - sample->usStart : sample->usTaken;
+
+        tmpStr.clear();
+        tmpStr.a( ",\"cat\":\"Ogre\",\"ph\":\"X\",\"pid\":0,\"tid\":", (uint64)threadIdx );
+        tmpStr.a( ",\"ts\":", sample->usStart + mUsTimerOffset, ",\"dur\":", usTaken, "}" );
+        outJson += tmpStr.c_str();
+
+        FastArray<ProfileSample *>::const_iterator itor = sample->children.begin();
+        FastArray<ProfileSample *>::const_iterator endt = sample->children.end();
+
+        while( itor != endt )
+        {
+            dumpTimelineSample( *itor, tmpStr, outJson, threadIdx, usNow );
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void OfflineProfiler::PerThreadData::dumpTimelineStr( String &outJson, size_t threadIdx )
+    {
+        char tmpBuffer[128];
+        LwString tmpStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        mMutex.lock();
+
+        tmpStr.a( ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":",
+                  (uint64)threadIdx, ",\"args\":{\"name\":" );
+        outJson += tmpStr.c_str();
+        if( mThreadName[0] != '\0' )
+            appendJsonString( outJson, mThreadName );
+        else
+        {
+            tmpStr.clear();
+            tmpStr.a( "\"Thread ", (uint64)threadIdx, "\"" );
+            outJson += tmpStr.c_str();
+        }
+        outJson += "}}";
+
+        // Keep the tracks in the order threads were registered
+        tmpStr.clear();
+        tmpStr.a( ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":",
+                  (uint64)threadIdx, ",\"args\":{\"sort_index\":", (uint64)threadIdx, "}}" );
+        outJson += tmpStr.c_str();
+
+        const uint64 usNow = mTimer->getMicroseconds();
+
+        FastArray<ProfileSample *>::const_iterator itor = mRoot->children.begin();
+        FastArray<ProfileSample *>::const_iterator endt = mRoot->children.end();
+
+        while( itor != endt )
+        {
+            dumpTimelineSample( *itor, tmpStr, outJson, threadIdx, usNow );
+            ++itor;
+        }
+
+        mMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
     void OfflineProfiler::setPaused( bool bPaused )
     {
         if( mPaused == bPaused )
@@ -361,6 +475,8 @@ namespace Ogre
     {
         mMutex.lock();
 
+        mFrameMarkers.clear();
+
         PerThreadDataArray::const_iterator itor = mThreadData.begin();
         PerThreadDataArray::const_iterator endt = mThreadData.end();
 
@@ -394,6 +510,27 @@ namespace Ogre
         perThreadData->profileEnd();
     }
     //-----------------------------------------------------------------------------------
+    void OfflineProfiler::markFrame()
+    {
+        if( mPaused )
+            return;
+
+        mMutex.lock();
+        mFrameMarkers.push_back( mTimer->getMicroseconds() );
+        mMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
+    void OfflineProfiler::setCurrentThreadName( const char *name )
+    {
+        PerThreadData *perThreadData =
+            reinterpret_cast<PerThreadData *>( Threads::GetTls( mTlsHandle ) );
+
+        if( !perThreadData )
+            perThreadData = allocatePerThreadData();
+
+        perThreadData->setThreadName( name );
+    }
+    //-----------------------------------------------------------------------------------
     void OfflineProfiler::dumpProfileResults( const String &fullPathPerFrame,
                                               const String &fullPathAccum )
     {
@@ -422,19 +559,81 @@ namespace Ogre
             ++itor;
         }
 
+        // Threads' samples were reset, the markers belong to those frames
+        mFrameMarkers.clear();
+
         mMutex.unlock();
     }
     //-----------------------------------------------------------------------------------
+    void OfflineProfiler::dumpTimelineStr( String &outJson )
+    {
+        String jsonString;
+        jsonString += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        jsonString += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+                      "\"args\":{\"name\":\"Ogre\"}}";
+
+        char tmpBuffer[128];
+        LwString tmpStr( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        mMutex.lock();
+
+        FastArray<uint64>::const_iterator itMarker = mFrameMarkers.begin();
+        FastArray<uint64>::const_iterator enMarker = mFrameMarkers.end();
+
+        while( itMarker != enMarker )
+        {
+            tmpStr.clear();
+            tmpStr.a( ",\n{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":",
+                      *itMarker, "}" );
+            jsonString += tmpStr.c_str();
+            ++itMarker;
+        }
+
+        size_t idx = 0;
+
+        PerThreadDataArray::const_iterator itor = mThreadData.begin();
+        PerThreadDataArray::const_iterator endt = mThreadData.end();
+
+        while( itor != endt )
+        {
+            ( *itor )->dumpTimelineStr( jsonString, idx );
+            ++idx;
+            ++itor;
+        }
+
+        mMutex.unlock();
+
+        jsonString += "\n]}\n";
+        outJson.swap( jsonString );
+    }
+    //-----------------------------------------------------------------------------------
+    void OfflineProfiler::dumpTimeline( const String &fullPath )
+    {
+        String jsonString;
+        dumpTimelineStr( jsonString );
+
+        std::ofstream outFile( fullPath.c_str(), std::ios::binary | std::ios::out );
+        outFile.write( (const char *)&jsonString[0], static_cast<std::streamsize>( jsonString.size() ) );
+        outFile.close();
+    }
+    //-----------------------------------------------------------------------------------
     void OfflineProfiler::setDumpPathsOnShutdown( const String &fullPathPerFrame,
-                                                  const String &fullPathAccum )
+                                                  const String &fullPathAccum,
+                                                  const String &fullPathTimeline )
     {
         mOnShutdownPerFramePath = fullPathPerFrame;
         mOnShutdownAccumPath = fullPathAccum;
+        mOnShutdownTimelinePath = fullPathTimeline;
 
         if( !fullPathPerFrame.empty() || !fullPathAccum.empty() )
         {
             LogManager::getSingleton().logMessage( "[INFO] Will log profiling results on shutdown to " +
                                                    fullPathPerFrame + " and " + fullPathAccum );
         }
+        if( !fullPathTimeline.empty() )
+        {
+            LogManager::getSingleton().logMessage(
+                "[INFO] Will dump profiling timeline on shutdown to " + fullPathTimeline );
+        }
     }
 }  // namespace Ogre
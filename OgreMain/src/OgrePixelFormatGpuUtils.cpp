@@ -35,8 +35,16 @@ THE SOFTWARE.
 #include "OgreCommon.h"
 #include "OgreException.h"
 #include "OgreMath.h"
+#include "OgrePlatformInformation.h"
 #include "OgreProfiler.h"
 #include "OgreTextureBox.h"
+#include "Threading/OgreThreads.h"
+
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#endif
 
 namespace Ogre
 {
@@ -1440,6 +1448,356 @@ namespace Ogre
             while (width--) { dst[0] = src[0]; src += 2; dst += 1; }
         }
         // clang-format on
+
+#if __OGRE_HAVE_SSE
+        void convRGBAtoBGRA_SIMD( uint8 *src, uint8 *dst, size_t width )
+        {
+            const __m128i maskGA = _mm_set1_epi32( static_cast<int>( 0xFF00FF00 ) );
+            const size_t simdWidth = width & ~size_t( 3u );
+            for( size_t x = 0; x < simdWidth; x += 4u )
+            {
+                const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src ) );
+                const __m128i rb = _mm_andnot_si128( maskGA, pixels );
+                const __m128i br = _mm_or_si128( _mm_srli_epi32( rb, 16 ), _mm_slli_epi32( rb, 16 ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst ),
+                                  _mm_or_si128( _mm_and_si128( maskGA, pixels ), br ) );
+                src += 16u;
+                dst += 16u;
+            }
+            convRGBAtoBGRA( src, dst, width - simdWidth );
+        }
+
+        template <bool swapRB>
+        void convRGBtoRGBA_SIMD( uint8 *src, uint8 *dst, size_t width )
+        {
+            const __m128i alpha = _mm_set1_epi32( static_cast<int>( 0xFF000000 ) );
+            const __m128i maskGA = _mm_set1_epi32( static_cast<int>( 0xFF00FF00 ) );
+
+            // Each iteration reads 16 bytes but only consumes 12 of them
+            size_t x = 0;
+            for( ; x + 6u <= width; x += 4u )
+            {
+                const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src ) );
+                const __m128i p01 = _mm_unpacklo_epi32( pixels, _mm_srli_si128( pixels, 3 ) );
+                const __m128i p23 =
+                    _mm_unpacklo_epi32( _mm_srli_si128( pixels, 6 ), _mm_srli_si128( pixels, 9 ) );
+                __m128i rgbx = _mm_unpacklo_epi64( p01, p23 );
+                if( swapRB )
+                {
+                    const __m128i rb = _mm_andnot_si128( maskGA, rgbx );
+                    rgbx = _mm_or_si128( _mm_and_si128( maskGA, rgbx ),
+                                         _mm_or_si128( _mm_srli_epi32( rb, 16 ), _mm_slli_epi32( rb, 16 ) ) );
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst ), _mm_or_si128( rgbx, alpha ) );
+                src += 12u;
+                dst += 16u;
+            }
+            if( swapRB )
+                convRGBtoBGRA( src, dst, width - x );
+            else
+                convRGBtoRGBA( src, dst, width - x );
+        }
+#elif __OGRE_HAVE_NEON
+        void convRGBAtoBGRA_SIMD( uint8 *src, uint8 *dst, size_t width )
+        {
+            const size_t simdWidth = width & ~size_t( 15u );
+            for( size_t x = 0; x < simdWidth; x += 16u )
+            {
+                uint8x16x4_t pixels = vld4q_u8( src );
+                const uint8x16_t r = pixels.val[0];
+                pixels.val[0] = pixels.val[2];
+                pixels.val[2] = r;
+                vst4q_u8( dst, pixels );
+                src += 64u;
+                dst += 64u;
+            }
+            convRGBAtoBGRA( src, dst, width - simdWidth );
+        }
+
+        template <bool swapRB>
+        void convRGBtoRGBA_SIMD( uint8 *src, uint8 *dst, size_t width )
+        {
+            const size_t simdWidth = width & ~size_t( 15u );
+            for( size_t x = 0; x < simdWidth; x += 16u )
+            {
+                const uint8x16x3_t rgb = vld3q_u8( src );
+                uint8x16x4_t rgba;
+                rgba.val[0] = swapRB ? rgb.val[2] : rgb.val[0];
+                rgba.val[1] = rgb.val[1];
+                rgba.val[2] = swapRB ? rgb.val[0] : rgb.val[2];
+                rgba.val[3] = vdupq_n_u8( 0xFF );
+                vst4q_u8( dst, rgba );
+                src += 48u;
+                dst += 64u;
+            }
+            if( swapRB )
+                convRGBtoBGRA( src, dst, width - simdWidth );
+            else
+                convRGBtoRGBA( src, dst, width - simdWidth );
+        }
+#endif
+
+        struct BulkConversion;
+        typedef void ( *bulk_conversion_func_t )( uint8 *src, uint8 *dst, size_t width,
+                                                  const BulkConversion &conv );
+
+        /// Everything needed to convert any range of rows of a bulkPixelConversion call
+        struct BulkConversion
+        {
+            bulk_conversion_func_t convertRowFunc;
+
+            uint8 *srcData;
+            uint8 *dstData;
+            size_t srcBytesPerRow;
+            size_t srcBytesPerImage;
+            size_t dstBytesPerRow;
+            size_t dstBytesPerImage;
+            size_t width;
+            size_t height;
+            bool   verticalFlip;
+
+            /// Used by convRowFunc
+            row_conversion_func_t rowConversionFunc;
+
+            /// Used by convGeneric
+            PixelFormatGpu srcFormat;
+            PixelFormatGpu dstFormat;
+            float          rangeM;
+            float          rangeA;
+
+            /// Used by convLut. Source's channel i goes to dst[swizzle[i]]
+            uint8 swizzle[4];
+            /// Used by convFloatToUnorm8
+            bool toSRGB;
+            /// Used by convLut. Raw destination channel for each 8-bit source value.
+            /// [0] is for R, G & B; [1] for alpha.
+            uint32 lut[2][256];
+
+            /// Rows are numbered across slices, i.e. row = z * height + y
+            void convertRows( size_t firstRow, size_t numRows ) const
+            {
+                for( size_t row = firstRow; row < firstRow + numRows; ++row )
+                {
+                    const size_t z = row / height;
+                    const size_t y = row - z * height;
+                    const size_t dstY = verticalFlip ? height - 1u - y : y;
+                    uint8 *srcPtr = srcData + srcBytesPerImage * z + srcBytesPerRow * y;
+                    uint8 *dstPtr = dstData + dstBytesPerImage * z + dstBytesPerRow * dstY;
+                    convertRowFunc( srcPtr, dstPtr, width, *this );
+                }
+            }
+        };
+
+        void convRowFunc( uint8 *src, uint8 *dst, size_t width, const BulkConversion &conv )
+        {
+            conv.rowConversionFunc( src, dst, width );
+        }
+
+        /// The brute force fallback
+        void convGeneric( uint8 *src, uint8 *dst, size_t width, const BulkConversion &conv )
+        {
+            const size_t srcBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( conv.srcFormat );
+            const size_t dstBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( conv.dstFormat );
+
+            float rgba[4];
+            for( size_t x = 0; x < width; ++x )
+            {
+                PixelFormatGpuUtils::unpackColour( rgba, conv.srcFormat, src );
+                for( int i = 0; i < 4; ++i )
+                    rgba[i] = rgba[i] * conv.rangeM + conv.rangeA;
+                PixelFormatGpuUtils::packColour( rgba, conv.dstFormat, dst );
+                src += srcBytesPerPixel;
+                dst += dstBytesPerPixel;
+            }
+        }
+
+        /// From RGBA8 / BGRA8 to any 4 channel format with 8, 16 or 32 bits per channel
+        template <typename T>
+        void convLut( uint8 *src, uint8 *_dst, size_t width, const BulkConversion &conv )
+        {
+            T *dst = reinterpret_cast<T *>( _dst );
+            const size_t dstR = conv.swizzle[0];
+            const size_t dstB = conv.swizzle[2];
+            while( width-- )
+            {
+                dst[dstR] = static_cast<T>( conv.lut[0][src[0]] );
+                dst[1] = static_cast<T>( conv.lut[0][src[1]] );
+                dst[dstB] = static_cast<T>( conv.lut[0][src[2]] );
+                dst[3] = static_cast<T>( conv.lut[1][src[3]] );
+                src += 4;
+                dst += 4;
+            }
+        }
+
+        inline float channelToFloat( float value ) { return value; }
+        inline float channelToFloat( uint16 value ) { return Bitwise::halfToFloat( value ); }
+
+        /// Must match exactly what PixelFormatGpuUtils::packColour does for each format.
+        /// RGBA8 goes through convertFromFloat, which rounds, while BGRA8 is special cased
+        /// and truncates after adding 0.5
+        template <bool bgra>
+        inline uint8 floatToUnorm8( float value, bool toSRGB )
+        {
+            if( bgra )
+            {
+                if( toSRGB )
+                    value = PixelFormatGpuUtils::toSRGB( value );
+                return static_cast<uint8>( Math::saturate( value ) * 255.0f + 0.5f );
+            }
+            else
+            {
+                value = Math::saturate( value );
+                if( toSRGB )
+                    value = PixelFormatGpuUtils::toSRGB( value );
+                return static_cast<uint8>( roundf( value * 255.0f ) );
+            }
+        }
+
+        /// From RGBA32_FLOAT / RGBA16_FLOAT to RGBA8 (bgra = false) / BGRA8 (bgra = true)
+        template <typename T, bool bgra>
+        void convFloatToUnorm8( uint8 *_src, uint8 *dst, size_t width, const BulkConversion &conv )
+        {
+            const T *src = reinterpret_cast<const T *>( _src );
+            const bool toSRGB = conv.toSRGB;
+            while( width-- )
+            {
+                dst[bgra ? 2 : 0] = floatToUnorm8<bgra>( channelToFloat( src[0] ), toSRGB );
+                dst[1] = floatToUnorm8<bgra>( channelToFloat( src[1] ), toSRGB );
+                dst[bgra ? 0 : 2] = floatToUnorm8<bgra>( channelToFloat( src[2] ), toSRGB );
+                dst[3] = floatToUnorm8<bgra>( channelToFloat( src[3] ), false );
+                src += 4;
+                dst += 4;
+            }
+        }
+
+#if __OGRE_HAVE_SSE
+        /// convFloatToUnorm8<float, bgra> when there's no sRGB conversion
+        template <bool bgra>
+        void convFloatToUnorm8_SIMD( uint8 *_src, uint8 *dst, size_t width,
+                                     const BulkConversion &conv )
+        {
+            float *src = reinterpret_cast<float *>( _src );
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const __m128 maxValue = _mm_set1_ps( 255.0f );
+            const __m128 half = _mm_set1_ps( 0.5f );
+
+            const size_t simdWidth = width & ~size_t( 3u );
+            for( size_t x = 0; x < simdWidth; x += 4u )
+            {
+                __m128i pixels[4];
+                for( size_t i = 0; i < 4u; ++i )
+                {
+                    __m128 value = _mm_loadu_ps( src + i * 4u );
+                    value = _mm_mul_ps( _mm_min_ps( _mm_max_ps( value, zero ), one ), maxValue );
+                    if( bgra )
+                    {
+                        value = _mm_shuffle_ps( value, value, _MM_SHUFFLE( 3, 0, 1, 2 ) );
+                        pixels[i] = _mm_cvttps_epi32( _mm_add_ps( value, half ) );
+                    }
+                    else
+                    {
+                        // Same as roundf (values are positive): truncate, then add 1 if the
+                        // fraction is >= 0.5. The mask is -1 when true, hence the subtraction.
+                        const __m128i truncated = _mm_cvttps_epi32( value );
+                        const __m128 fraction = _mm_sub_ps( value, _mm_cvtepi32_ps( truncated ) );
+                        pixels[i] = _mm_sub_epi32(
+                            truncated, _mm_castps_si128( _mm_cmpge_ps( fraction, half ) ) );
+                    }
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( dst ),
+                                  _mm_packus_epi16( _mm_packs_epi32( pixels[0], pixels[1] ),
+                                                    _mm_packs_epi32( pixels[2], pixels[3] ) ) );
+                src += 16u;
+                dst += 16u;
+            }
+            convFloatToUnorm8<float, bgra>( reinterpret_cast<uint8 *>( src ), dst, width - simdWidth,
+                                            conv );
+        }
+#endif
+
+        /// RGBA8 / BGRA8, either UNORM or UNORM_SRGB
+        bool isUnorm8x4( PixelFormatGpu format )
+        {
+            const PixelFormatGpuUtils::PixelFormatLayout layout =
+                PixelFormatGpuUtils::getPixelLayout( format );
+            return ( layout == PixelFormatGpuUtils::PFL_RGBA8 ||
+                     layout == PixelFormatGpuUtils::PFL_BGRA8 ) &&
+                   ( PixelFormatGpuUtils::getFlags( format ) & ~PixelFormatGpuUtils::PFF_SRGB ) ==
+                       PixelFormatGpuUtils::PFF_NORMALIZED;
+        }
+
+        /// Sets the swizzle to go from RGBA to BGRA if the layouts don't match
+        void setSwizzle( BulkConversion &conv, bool srcIsBgra, bool dstIsBgra )
+        {
+            const bool swapRB = srcIsBgra != dstIsBgra;
+            conv.swizzle[0] = swapRB ? 2u : 0u;
+            conv.swizzle[1] = 1u;
+            conv.swizzle[2] = swapRB ? 0u : 2u;
+            conv.swizzle[3] = 3u;
+        }
+
+        /// Images with less pixels than this are not worth spawning threads for
+        static const size_t c_minPixelsPerThread = 64u * 1024u;
+        /// Threads::WaitForThreads supports up to 128
+        static const uint32 c_maxBulkConversionThreads = 64u;
+
+        struct BulkConversionSlice
+        {
+            const BulkConversion *conversion;
+            size_t firstRow;
+            size_t numRows;
+        };
+
+        unsigned long bulkConversionThread( ThreadHandle *threadHandle )
+        {
+            const BulkConversionSlice *slice =
+                reinterpret_cast<const BulkConversionSlice *>( threadHandle->getUserParam() );
+            slice->conversion->convertRows( slice->firstRow, slice->numRows );
+            return 0;
+        }
+        THREAD_DECLARE( bulkConversionThread );
+
+        void runBulkConversion( const BulkConversion &conv, size_t numRows, uint32 maxThreads )
+        {
+            size_t numThreads = std::min<size_t>( maxThreads, c_maxBulkConversionThreads );
+            numThreads = std::min( numThreads, ( conv.width * numRows ) / c_minPixelsPerThread );
+            numThreads = std::min( numThreads, numRows / 2u );
+
+            if( numThreads <= 1u )
+            {
+                conv.convertRows( 0u, numRows );
+                return;
+            }
+
+            // Convert the first row here before spawning any thread. If the conversion is
+            // not supported it throws here, instead of inside a thread.
+            conv.convertRows( 0u, 1u );
+
+            BulkConversionSlice slices[c_maxBulkConversionThreads];
+            ThreadHandlePtr threadHandles[c_maxBulkConversionThreads];
+
+            const size_t remainingRows = numRows - 1u;
+            size_t firstRow = 1u;
+            for( size_t i = 0; i < numThreads; ++i )
+            {
+                const size_t nextRow = 1u + ( remainingRows * ( i + 1u ) ) / numThreads;
+                slices[i].conversion = &conv;
+                slices[i].firstRow = firstRow;
+                slices[i].numRows = nextRow - firstRow;
+                firstRow = nextRow;
+            }
+
+            // The calling thread takes the first slice
+            for( size_t i = 1u; i < numThreads; ++i )
+            {
+                threadHandles[i] =
+                    Threads::CreateThread( THREAD_GET( bulkConversionThread ), i, &slices[i] );
+            }
+            conv.convertRows( slices[0].firstRow, slices[0].numRows );
+            Threads::WaitForThreads( numThreads - 1u, &threadHandles[1] );
+        }
     }  // namespace
     //-----------------------------------------------------------------------------------
     void PixelFormatGpuUtils::bulkPixelConversion( const TextureBox &src, PixelFormatGpu srcFormat,
@@ -1588,24 +1946,40 @@ namespace Ogre
         }
 #undef PFL_PAIR
 
-        if( rowConversionFunc )
+#if __OGRE_HAVE_SSE || __OGRE_HAVE_NEON
+#    if __OGRE_HAVE_SSE
+        const bool bHasSimd = PlatformInformation::hasCpuFeature( PlatformInformation::CPU_FEATURE_SSE2 );
+#    else
+        const bool bHasSimd = true;
+#    endif
+        if( bHasSimd )
         {
-            for( size_t z = 0; z < depthOrSlices; ++z )
-            {
-                for( size_t y = 0; y < height; ++y )
-                {
-                    size_t dest_y = verticalFlip ? height - 1 - y : y;
-                    uint8 *srcPtr = srcData + src.bytesPerImage * z + src.bytesPerRow * y;
-                    uint8 *dstPtr = dstData + dst.bytesPerImage * z + dst.bytesPerRow * dest_y;
-                    rowConversionFunc( srcPtr, dstPtr, width );
-                }
-            }
-            return;
+            if( rowConversionFunc == convRGBAtoBGRA )
+                rowConversionFunc = convRGBAtoBGRA_SIMD;
+            else if( rowConversionFunc == convRGBtoRGBA )
+                rowConversionFunc = convRGBtoRGBA_SIMD<false>;
+            else if( rowConversionFunc == convRGBtoBGRA )
+                rowConversionFunc = convRGBtoRGBA_SIMD<true>;
         }
+#endif
 
-        // The brute force fallback
-        float rangeM = 1.0f;
-        float rangeA = 0.0f;
+        BulkConversion conv;
+        conv.srcData = srcData;
+        conv.dstData = dstData;
+        conv.srcBytesPerRow = src.bytesPerRow;
+        conv.srcBytesPerImage = src.bytesPerImage;
+        conv.dstBytesPerRow = dst.bytesPerRow;
+        conv.dstBytesPerImage = dst.bytesPerImage;
+        conv.width = width;
+        conv.height = height;
+        conv.verticalFlip = verticalFlip;
+        conv.rowConversionFunc = rowConversionFunc;
+        conv.srcFormat = srcFormat;
+        conv.dstFormat = dstFormat;
+        conv.rangeM = 1.0f;
+        conv.rangeA = 0.0f;
+        conv.toSRGB = false;
+        setSwizzle( conv, false, false );
 
         const bool bSrcSigned = isSigned( srcFormat );
         if( bSrcSigned != isSigned( dstFormat ) && isNormalized( srcFormat ) )
@@ -1613,39 +1987,109 @@ namespace Ogre
             if( !bSrcSigned )
             {
                 // unormToSnorm
-                rangeM = 2.0f;
-                rangeA = -1.0f;
+                conv.rangeM = 2.0f;
+                conv.rangeA = -1.0f;
             }
             else
             {
                 // snormToUnorm
-                rangeM = 0.5f;
-                rangeA = 0.5f;
+                conv.rangeM = 0.5f;
+                conv.rangeA = 0.5f;
             }
         }
 
-        float rgba[4];
-        for( size_t z = 0; z < depthOrSlices; ++z )
+        const size_t numRows = height * depthOrSlices;
+
+        if( rowConversionFunc )
         {
-            for( size_t y = 0; y < height; ++y )
+            conv.convertRowFunc = convRowFunc;
+        }
+        else if( isUnorm8x4( srcFormat ) &&
+                 ( isUnorm8x4( dstFormat ) || dstFormat == PFG_RGBA16_FLOAT ||
+                   dstFormat == PFG_RGBA32_FLOAT ) &&
+                 width * numRows >= 1024u )
+        {
+            // Every source channel can only have 256 values. Pack them all once,
+            // with the same code the brute force path would use.
+            const size_t dstBytesPerChannel = dstBytesPerPixel / 4u;
+            for( size_t i = 0; i < 256u; ++i )
             {
-                size_t dest_y = verticalFlip ? height - 1 - y : y;
-                uint8 *srcPtr = srcData + src.bytesPerImage * z + src.bytesPerRow * y;
-                uint8 *dstPtr = dstData + dst.bytesPerImage * z + dst.bytesPerRow * dest_y;
+                const uint8 srcPixel[4] = { uint8( i ), uint8( i ), uint8( i ), uint8( i ) };
+                uint8 dstPixel[16];
+                float rgba[4];
+                unpackColour( rgba, srcFormat, srcPixel );
+                packColour( rgba, dstFormat, dstPixel );
 
-                for( size_t x = 0; x < width; ++x )
+                if( dstBytesPerChannel == 1u )
                 {
-                    unpackColour( rgba, srcFormat, srcPtr );
-                    for( int i = 0; i < 4; ++i )
-                        rgba[i] = rgba[i] * rangeM + rangeA;
-                    packColour( rgba, dstFormat, dstPtr );
-                    srcPtr += srcBytesPerPixel;
-                    dstPtr += dstBytesPerPixel;
+                    conv.lut[0][i] = dstPixel[0];
+                    conv.lut[1][i] = dstPixel[3];
+                }
+                else if( dstBytesPerChannel == 2u )
+                {
+                    uint16 channels[4];
+                    memcpy( channels, dstPixel, sizeof( channels ) );
+                    conv.lut[0][i] = channels[0];
+                    conv.lut[1][i] = channels[3];
+                }
+                else
+                {
+                    uint32 channels[4];
+                    memcpy( channels, dstPixel, sizeof( channels ) );
+                    conv.lut[0][i] = channels[0];
+                    conv.lut[1][i] = channels[3];
                 }
             }
+
+            setSwizzle( conv, getPixelLayout( srcFormat ) == PFL_BGRA8,
+                        getPixelLayout( dstFormat ) == PFL_BGRA8 );
+
+            if( dstBytesPerChannel == 1u )
+                conv.convertRowFunc = convLut<uint8>;
+            else if( dstBytesPerChannel == 2u )
+                conv.convertRowFunc = convLut<uint16>;
+            else
+                conv.convertRowFunc = convLut<uint32>;
         }
+        else if( ( srcFormat == PFG_RGBA32_FLOAT || srcFormat == PFG_RGBA16_FLOAT ) &&
+                 isUnorm8x4( dstFormat ) )
+        {
+            conv.toSRGB = ( getFlags( dstFormat ) & PFF_SRGB ) != 0u;
+
+            const bool bDstBgra = getPixelLayout( dstFormat ) == PFL_BGRA8;
+            if( srcFormat == PFG_RGBA16_FLOAT )
+            {
+                conv.convertRowFunc =
+                    bDstBgra ? convFloatToUnorm8<uint16, true> : convFloatToUnorm8<uint16, false>;
+            }
+            else
+            {
+                conv.convertRowFunc =
+                    bDstBgra ? convFloatToUnorm8<float, true> : convFloatToUnorm8<float, false>;
+#if __OGRE_HAVE_SSE
+                if( !conv.toSRGB && bHasSimd )
+                {
+                    conv.convertRowFunc =
+                        bDstBgra ? convFloatToUnorm8_SIMD<true> : convFloatToUnorm8_SIMD<false>;
+                }
+#endif
+            }
+        }
+        else
+        {
+            conv.convertRowFunc = convGeneric;
+        }
+
+        runBulkConversion( conv, numRows, msMaxBulkConversionThreads );
+    }
+    //-----------------------------------------------------------------------------------
+    void PixelFormatGpuUtils::setMaxBulkConversionThreads( uint32 maxThreads )
+    {
+        msMaxBulkConversionThreads = std::max( maxThreads, 1u );
     }
     //-----------------------------------------------------------------------------------
+    uint32 PixelFormatGpuUtils::getMaxBulkConversionThreads() { return msMaxBulkConversionThreads; }
+    //-----------------------------------------------------------------------------------
     uint32 PixelFormatGpuUtils::getFlags( PixelFormatGpu format )
     {
         const PixelFormatDesc &desc = getDescriptionFor( format );
@@ -1937,6 +2381,8 @@ namespace Ogre
                                                 PixelFormatGpuUtils::PFF_NORMALIZED;
 
     // clang-format off
+    uint32 PixelFormatGpuUtils::msMaxBulkConversionThreads = 1u;
+    //-----------------------------------------------------------------------------------
     PixelFormatGpuUtils::PixelFormatDesc PixelFormatGpuUtils::msPixelFormatDesc[PFG_COUNT + 1u] =
     {
         {"PFG_UNKNOWN", 1u, 0, 0, 0 },
@@ -0,0 +1,388 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreRadixSort64.h"
+
+#include "Threading/OgreTaskScheduler.h"
+
+namespace Ogre
+{
+    /// Below this size a plain insertion sort beats the setup of the histograms
+    static const size_t c_minRadixSortEntries = 32u;
+    /// Smallest chunk worth sending to a worker thread
+    static const size_t c_minEntriesPerChunk = 4096u;
+    /// Value of CountTask::mByteIdx to count all bytes at once
+    static const size_t c_allBytes = 8u;
+
+    class RadixSort64::CountTask : public Task
+    {
+    public:
+        RadixSort64              *mSorter;
+        const RadixSort64::Entry *mSrc;
+        size_t                    mByteIdx;
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            if( mByteIdx == c_allBytes )
+                mSorter->countAllBytes( mSrc, chunkIdx );
+            else
+                mSorter->countByte( mSrc, chunkIdx, mByteIdx );
+        }
+    };
+
+    class RadixSort64::ScatterTask : public Task
+    {
+    public:
+        RadixSort64              *mSorter;
+        const RadixSort64::Entry *mSrc;
+        RadixSort64::Entry       *mDst;
+        size_t                    mByteIdx;
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            mSorter->scatter( mSrc, mDst, chunkIdx, mByteIdx );
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    RadixSort64::RadixSort64() :
+        mNumChunks( 1u ),
+        mChunkSize( 0u ),
+        mNumEntries( 0u ),
+        mParallelThreshold( 16384u )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void RadixSort64::countAllBytes( const Entry *src, size_t chunkIdx )
+    {
+        uint32 *histograms = mHistograms.begin() + chunkIdx * 8u * 256u;
+        memset( histograms, 0, 8u * 256u * sizeof( uint32 ) );
+
+        const size_t begin = std::min( chunkIdx * mChunkSize, mNumEntries );
+        const size_t end = std::min( begin + mChunkSize, mNumEntries );
+
+        for( size_t i = begin; i < end; ++i )
+        {
+            const uint64 key = src[i].key;
+            for( size_t byteIdx = 0u; byteIdx < 8u; ++byteIdx )
+                ++histograms[byteIdx * 256u + ( ( key >> ( byteIdx * 8u ) ) & 0xFF )];
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void RadixSort64::countByte( const Entry *src, size_t chunkIdx, size_t byteIdx )
+    {
+        uint32 *histogram = mHistograms.begin() + ( chunkIdx * 8u + byteIdx ) * 256u;
+        memset( histogram, 0, 256u * sizeof( uint32 ) );
+
+        const size_t begin = std::min( chunkIdx * mChunkSize, mNumEntries );
+        const size_t end = std::min( begin + mChunkSize, mNumEntries );
+        const size_t shift = byteIdx * 8u;
+
+        for( size_t i = begin; i < end; ++i )
+            ++histogram[( src[i].key >> shift ) & 0xFF];
+    }
+    //-----------------------------------------------------------------------------------
+    void RadixSort64::scatter( const Entry *src, Entry *dst, size_t chunkIdx, size_t byteIdx )
+    {
+        // Where this chunk starts writing each value: after all the smaller values,
+        // and after the same value from the chunks before it (which keeps it stable)
+        uint32 offsets[256];
+        const uint32 *histograms = mHistograms.begin() + byteIdx * 256u;
+        size_t runningOffset = 0;
+        for( size_t value = 0u; value < 256u; ++value )
+        {
+            size_t countBefore = 0;
+            size_t total = 0;
+            for( size_t i = 0u; i < mNumChunks; ++i )
+            {
+                const uint32 count = histograms[i * 8u * 256u + value];
+                if( i < chunkIdx )
+                    countBefore += count;
+                total += count;
+            }
+            offsets[value] = static_cast<uint32>( runningOffset + countBefore );
+            runningOffset += total;
+        }
+
+        const size_t begin = std::min( chunkIdx * mChunkSize, mNumEntries );
+        const size_t end = std::min( begin + mChunkSize, mNumEntries );
+        const size_t shift = byteIdx * 8u;
+
+        for( size_t i = begin; i < end; ++i )
+            dst[offsets[( src[i].key >> shift ) & 0xFF]++] = src[i];
+    }
+    //-----------------------------------------------------------------------------------
+    void RadixSort64::sort( EntryArray &entries, TaskScheduler *taskScheduler )
+    {
+        mNumEntries = entries.size();
+
+        if( mNumEntries <= c_minRadixSortEntries )
+        {
+            insertionSort( entries.begin(), entries.end(), std::numeric_limits<size_t>::max() );
+            return;
+        }
+
+        OGRE_ASSERT_LOW( mNumEntries <= std::numeric_limits<uint32>::max() );
+
+        const bool parallel = taskScheduler && taskScheduler->getNumThreads() > 1u &&
+                              mNumEntries >= mParallelThreshold;
+
+        mNumChunks = 1u;
+        if( parallel )
+        {
+            mNumChunks = std::min( taskScheduler->getNumThreads() * 2u,
+                                   std::max<size_t>( mNumEntries / c_minEntriesPerChunk, 1u ) );
+        }
+        mChunkSize = ( mNumEntries + mNumChunks - 1u ) / mNumChunks;
+
+        mHistograms.resizePOD( mNumChunks * 8u * 256u );
+        mScratch.resizePOD( mNumEntries );
+
+        Entry *src = entries.begin();
+        Entry *dst = mScratch.begin();
+
+        if( parallel )
+        {
+            CountTask countTask;
+            countTask.mSorter = this;
+            countTask.mSrc = src;
+            countTask.mByteIdx = c_allBytes;
+            taskScheduler->wait( taskScheduler->submit( &countTask, mNumChunks ) );
+        }
+        else
+        {
+            countAllBytes( src, 0u );
+        }
+
+        // Skip the bytes that are the same in all keys. They'd be a copy that changes nothing.
+        size_t passes[8];
+        size_t numPasses = 0u;
+        for( size_t byteIdx = 0u; byteIdx < 8u; ++byteIdx )
+        {
+            size_t firstBucketCount = 0u;
+            for( size_t value = 0u; value < 256u && !firstBucketCount; ++value )
+            {
+                for( size_t i = 0u; i < mNumChunks; ++i )
+                    firstBucketCount += mHistograms[( i * 8u + byteIdx ) * 256u + value];
+            }
+
+            if( firstBucketCount != mNumEntries )
+                passes[numPasses++] = byteIdx;
+        }
+
+        if( parallel )
+        {
+            CountTask   countTasks[8];
+            ScatterTask scatterTasks[8];
+
+            TaskScheduler::TaskId lastTask = TaskScheduler::FinishedTask;
+            for( size_t i = 0u; i < numPasses; ++i )
+            {
+                // The histograms from countAllBytes are still valid for the first pass
+                if( i != 0u )
+                {
+                    countTasks[i].mSorter = this;
+                    countTasks[i].mSrc = src;
+                    countTasks[i].mByteIdx = passes[i];
+                    lastTask = taskScheduler->submit( &countTasks[i], mNumChunks, &lastTask, 1u );
+                }
+
+                scatterTasks[i].mSorter = this;
+                scatterTasks[i].mSrc = src;
+                scatterTasks[i].mDst = dst;
+                scatterTasks[i].mByteIdx = passes[i];
+                lastTask = taskScheduler->submit( &scatterTasks[i], mNumChunks, &lastTask,
+                                                  i != 0u ? 1u : 0u );
+                std::swap( src, dst );
+            }
+
+            if( numPasses )
+                taskScheduler->wait( lastTask );
+        }
+        else
+        {
+            for( size_t i = 0u; i < numPasses; ++i )
+            {
+                if( i != 0u )
+                    countByte( src, 0u, passes[i] );
+                scatter( src, dst, 0u, passes[i] );
+                std::swap( src, dst );
+            }
+        }
+
+        if( numPasses & 0x01 )
+            entries.swap( mScratch );
+    }
+    //-----------------------------------------------------------------------------------
+    bool RadixSort64::insertionSort( Entry *begin, Entry *end, size_t maxMoves )
+    {
+        if( begin == end )
+            return true;
+
+        size_t numMoves = 0;
+        for( Entry *itor = begin + 1; itor < end; ++itor )
+        {
+            if( !( itor->key < ( itor - 1 )->key ) )
+                continue;
+
+            const Entry entry = *itor;
+            Entry *hole = itor;
+            do
+            {
+                *hole = *( hole - 1 );
+                --hole;
+                ++numMoves;
+            } while( hole != begin && entry.key < ( hole - 1 )->key );
+            *hole = entry;
+
+            if( numMoves > maxMoves )
+                return false;
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void RadixSort64::setParallelThreshold( size_t numEntries ) { mParallelThreshold = numEntries; }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    FrameCoherentSortOrder::FrameCoherentSortOrder() : mNumRanks( 0u ) {}
+    //-----------------------------------------------------------------------------------
+    size_t FrameCoherentSortOrder::findSlot( uint64 id ) const
+    {
+        // Fibonacci hashing. Addresses have their low bits mostly zero, so use the high ones
+        const size_t mask = mTable.size() - 1u;
+        size_t slotIdx = static_cast<size_t>( ( id * 0x9E3779B97F4A7C15ull ) >> 32u ) & mask;
+        while( mTable[slotIdx].rank != NoRank && mTable[slotIdx].id != id )
+            slotIdx = ( slotIdx + 1u ) & mask;
+        return slotIdx;
+    }
+    //-----------------------------------------------------------------------------------
+    bool FrameCoherentSortOrder::applyLastOrder( RadixSort64::EntryArray &entries, const uint64 *ids )
+    {
+        const size_t numEntries = entries.size();
+
+        // If a quarter of the objects came or went, the set is too different
+        if( !mNumRanks || std::max<size_t>( numEntries, mNumRanks ) -
+                                  std::min<size_t>( numEntries, mNumRanks ) >
+                              numEntries / 4u )
+        {
+            return false;
+        }
+
+        // Place each entry at the position it had last time, leaving gaps for those that are
+        // gone. The ones that are new (or repeated ids) go to the end, in input order.
+        mScratch.resizePOD( mNumRanks + numEntries );
+        mRankTaken.resizePOD( mNumRanks );
+        memset( mRankTaken.begin(), 0, mNumRanks );
+
+        size_t numNew = 0u;
+        RadixSort64::Entry *newEntries = mScratch.begin() + mNumRanks;
+        for( size_t i = 0u; i < numEntries; ++i )
+        {
+            const Slot &slot = mTable[findSlot( ids[i] )];
+            if( slot.rank != NoRank && !mRankTaken[slot.rank] )
+            {
+                mRankTaken[slot.rank] = 1u;
+                mScratch[slot.rank] = entries[i];
+            }
+            else
+            {
+                newEntries[numNew++] = entries[i];
+            }
+        }
+
+        if( numNew > numEntries / 4u )
+            return false;
+
+        // Close the gaps
+        RadixSort64::Entry *dst = entries.begin();
+        for( size_t i = 0u; i < mNumRanks; ++i )
+        {
+            if( mRankTaken[i] )
+                *dst++ = mScratch[i];
+        }
+        for( size_t i = 0u; i < numNew; ++i )
+            *dst++ = newEntries[i];
+
+        OGRE_ASSERT_LOW( dst == entries.end() );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool FrameCoherentSortOrder::sort( RadixSort64::EntryArray &entries, const uint64 *ids,
+                                       RadixSort64 &radixSort, TaskScheduler *taskScheduler )
+    {
+        const size_t numEntries = entries.size();
+
+        bool sorted = false;
+        if( applyLastOrder( entries, ids ) )
+        {
+            // Allow each entry to move a few slots on average. If the order changed more than
+            // that, a full sort is cheaper than carrying on with the insertion sort.
+            sorted = RadixSort64::insertionSort( entries.begin(), entries.end(), numEntries * 4u );
+        }
+
+        const bool usedLastOrder = sorted;
+        if( !sorted )
+            radixSort.sort( entries, taskScheduler );
+
+        // Remember the new order. Keep the table at most half full so probing stays short
+        OGRE_ASSERT_LOW( numEntries < NoRank );
+        size_t tableSize = 16u;
+        while( tableSize < numEntries * 2u )
+            tableSize <<= 1u;
+
+        Slot emptySlot;
+        emptySlot.id = 0u;
+        emptySlot.rank = NoRank;
+        mTable.resizePOD( tableSize );
+        std::fill( mTable.begin(), mTable.end(), emptySlot );
+
+        for( size_t i = 0u; i < numEntries; ++i )
+        {
+            const uint64 id = ids[entries[i].idx];
+            Slot &slot = mTable[findSlot( id )];
+            if( slot.rank == NoRank )  // Repeated ids keep the first rank
+            {
+                slot.id = id;
+                slot.rank = static_cast<uint32>( i );
+            }
+        }
+        mNumRanks = static_cast<uint32>( numEntries );
+
+        return usedLastOrder;
+    }
+    //-----------------------------------------------------------------------------------
+    void FrameCoherentSortOrder::clear()
+    {
+        mTable.clear();
+        mNumRanks = 0u;
+    }
+}  // namespace Ogre
@@ -46,6 +46,7 @@ THE SOFTWARE.
 #include "OgreSceneManager.h"
 #include "OgreSceneManagerEnumerator.h"
 #include "OgreTechnique.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreIndirectBufferPacked.h"
 #include "Vao/OgreVaoManager.h"
@@ -57,6 +58,76 @@ namespace Ogre
 
     const HlmsCache c_dummyCache( 0, HLMS_MAX, HlmsPso() );
 
+    namespace
+    {
+        /// Expands the templates of the shaders scheduled by Hlms::_queueShaderGeneration.
+        /// One chunk per variant, so a few expensive variants don't hold back a whole thread.
+        class ParallelShaderGenerationTask : public Task
+        {
+            Hlms  *mHlms[HLMS_MAX];
+            size_t mFirstChunk[HLMS_MAX];
+            size_t mNumHlms;
+            size_t mNumChunks;
+
+        public:
+            ParallelShaderGenerationTask( HlmsManager *hlmsManager ) : mNumHlms( 0 ), mNumChunks( 0 )
+            {
+                for( size_t i = 0; i < HLMS_MAX; ++i )
+                {
+                    Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                    if( hlms && hlms->_hasPendingShaderGeneration() )
+                    {
+                        mHlms[mNumHlms] = hlms;
+                        mFirstChunk[mNumHlms] = mNumChunks;
+                        mNumChunks += hlms->_getNumPendingShaders();
+                        ++mNumHlms;
+                    }
+                }
+            }
+
+            size_t getNumChunks() const { return mNumChunks; }
+
+            void execute( size_t chunkIdx, size_t threadIdx ) override
+            {
+                size_t hlmsIdx = mNumHlms - 1u;
+                while( mFirstChunk[hlmsIdx] > chunkIdx )
+                    --hlmsIdx;
+                mHlms[hlmsIdx]->_generatePendingShader( chunkIdx - mFirstChunk[hlmsIdx] );
+            }
+        };
+    }  // namespace
+
+    /// Records one CommandSlice per chunk. See RenderQueue::renderGL3Parallel
+    class RenderQueue::CommandSliceTask : public Task
+    {
+        RenderQueue                 *mRenderQueue;
+        bool                         mCasterPass;
+        HlmsCache                   *mPassCache;
+        const QueuedRenderableArray &mQueuedRenderables;
+        IndirectBufferPacked        *mIndirectBuffer;
+        unsigned char               *mStartIndirectDraw;
+
+    public:
+        CommandSliceTask( RenderQueue *renderQueue, bool casterPass, HlmsCache *passCache,
+                          const QueuedRenderableArray &queuedRenderables,
+                          IndirectBufferPacked *indirectBuffer, unsigned char *startIndirectDraw ) :
+            mRenderQueue( renderQueue ),
+            mCasterPass( casterPass ),
+            mPassCache( passCache ),
+            mQueuedRenderables( queuedRenderables ),
+            mIndirectBuffer( indirectBuffer ),
+            mStartIndirectDraw( startIndirectDraw )
+        {
+        }
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            mRenderQueue->renderGL3Range( mRenderQueue->mCommandSlices[chunkIdx], mCasterPass,
+                                          mPassCache, mQueuedRenderables, mIndirectBuffer,
+                                          mStartIndirectDraw, chunkIdx );
+        }
+    };
+
     // clang-format off
     const int RqBits::SubRqIdBits           = 3;
     const int RqBits::TransparencyBits      = 1;
@@ -93,6 +164,9 @@ namespace Ogre
         mLastIndexData( 0 ),
         mLastTextureHash( 0 ),
         mCommandBuffer( 0 ),
+        mMinRenderablesPerSlice( 512u ),
+        mFrameCoherentSorting( false ),
+        mFrameCount( 0u ),
         mRenderingStarted( 0u )
     {
         mCommandBuffer = new CommandBuffer();
@@ -113,6 +187,14 @@ namespace Ogre
     {
         delete mCommandBuffer;
 
+        FastArray<CommandBuffer *>::const_iterator itCmdBuffer = mSliceCommandBuffers.begin();
+        FastArray<CommandBuffer *>::const_iterator enCmdBuffer = mSliceCommandBuffers.end();
+        while( itCmdBuffer != enCmdBuffer )
+        {
+            delete *itCmdBuffer;
+            ++itCmdBuffer;
+        }
+
         assert( mUsedIndirectBuffers.empty() );
 
         IndirectBufferPackedVec::const_iterator itor = mFreeIndirectBuffers.begin();
@@ -374,58 +456,11 @@ namespace Ogre
             startIndirectDraw = indirectDraw;
         }
 
+        sortRenderQueues( firstRq, lastRq );
+        generateShaders( firstRq, lastRq, casterPass );
+
         for( size_t i = firstRq; i < lastRq; ++i )
         {
-            QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
-            QueuedRenderableArrayPerThread &perThreadQueue =
-                mRenderQueues[i].mQueuedRenderablesPerThread;
-
-            if( !mRenderQueues[i].mSorted )
-            {
-                OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
-
-                size_t numRenderables = 0;
-                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
-                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
-
-                while( itor != endt )
-                {
-                    numRenderables += itor->q.size();
-                    ++itor;
-                }
-
-                queuedRenderables.reserve( numRenderables );
-
-                itor = perThreadQueue.begin();
-                while( itor != endt )
-                {
-                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
-                    ++itor;
-                }
-
-                // TODO: Exploit temporal coherence across frames then use insertion sorts.
-                // As explained by L. Spiro in
-                // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
-                // Keep a list of sorted indices from the previous frame (one per camera).
-                // If we have the sorted list "5, 1, 4, 3, 2, 0":
-                //  * If it grew from last frame, append: 5, 1, 4, 3, 2, 0, 6, 7 and use insertion sort.
-                //  * If it's the same, leave it as is, and use insertion sort just in case.
-                //  * If it's shorter, reset the indices 0, 1, 2, 3, 4; probably use quicksort or other
-                //  generic sort
-                //
-                // TODO2: Explore sorting first on multiple threads, then merge sort into one.
-                if( mRenderQueues[i].mSortMode == NormalSort )
-                {
-                    std::sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-                else if( mRenderQueues[i].mSortMode == StableSort )
-                {
-                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-            }
-
             if( mRenderQueues[i].mMode == V1_LEGACY )
             {
                 if( mLastVaoName )
@@ -482,6 +517,140 @@ namespace Ogre
         OgreProfileEndGroup( "Command Execution", OGREPROF_RENDERING );
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderQueues( uint8 firstRq, uint8 lastRq )
+    {
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
+            QueuedRenderableArrayPerThread &perThreadQueue =
+                mRenderQueues[i].mQueuedRenderablesPerThread;
+
+            if( !mRenderQueues[i].mSorted )
+            {
+                OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
+
+                size_t numRenderables = 0;
+                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
+                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
+
+                while( itor != endt )
+                {
+                    numRenderables += itor->q.size();
+                    ++itor;
+                }
+
+                queuedRenderables.reserve( numRenderables );
+
+                itor = perThreadQueue.begin();
+                while( itor != endt )
+                {
+                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
+                    ++itor;
+                }
+
+                if( mRenderQueues[i].mSortMode != DisableSort )
+                {
+                    sortRenderQueue( static_cast<uint8>( i ) );
+                    mRenderQueues[i].mSorted = true;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderQueue( uint8 rqId )
+    {
+        // Sort (hash, index) pairs rather than QueuedRenderables directly; so that the
+        // radix passes move less memory and we can keep the order for the next frame.
+        QueuedRenderableArray &queuedRenderables = mRenderQueues[rqId].mQueuedRenderables;
+        const size_t numRenderables = queuedRenderables.size();
+
+        if( numRenderables < 2u )
+            return;
+
+        mSortEntries.resizePOD( numRenderables );
+        for( size_t i = 0u; i < numRenderables; ++i )
+        {
+            mSortEntries[i].key = queuedRenderables[i].hash;
+            mSortEntries[i].idx = static_cast<uint32>( i );
+        }
+
+        if( mFrameCoherentSorting && mRenderQueues[rqId].mSortMode == NormalSort )
+        {
+            const FrameCoherentOrderKey key( mSceneManager->getCamerasInProgress().cullingCamera,
+                                             rqId );
+            FrameCoherentOrder &frameCoherentOrder = mFrameCoherentOrders[key];
+            frameCoherentOrder.lastFrame = mFrameCount;
+
+            mSortIds.resizePOD( numRenderables );
+            for( size_t i = 0u; i < numRenderables; ++i )
+            {
+                // The same Renderable can be queued by different MovableObjects (and
+                // vice versa), so both are needed to tell them apart
+                const uint64 renderable =
+                    static_cast<uint64>( reinterpret_cast<uintptr_t>( queuedRenderables[i].renderable ) );
+                const uint64 movableObject = static_cast<uint64>(
+                    reinterpret_cast<uintptr_t>( queuedRenderables[i].movableObject ) );
+                mSortIds[i] = renderable ^ ( ( movableObject << 29u ) | ( movableObject >> 35u ) );
+            }
+
+            frameCoherentOrder.order.sort( mSortEntries, mSortIds.begin(), mRadixSort,
+                                           mSceneManager->getTaskScheduler() );
+        }
+        else
+        {
+            mRadixSort.sort( mSortEntries, mSceneManager->getTaskScheduler() );
+        }
+
+        mSortScratch.resizePOD( numRenderables );
+        for( size_t i = 0u; i < numRenderables; ++i )
+            mSortScratch[i] = queuedRenderables[mSortEntries[i].idx];
+        queuedRenderables.swap( mSortScratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::generateShaders( uint8 firstRq, uint8 lastRq, bool casterPass )
+    {
+        bool anyParallel = false;
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+        {
+            Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+            if( hlms && hlms->getParallelShaderGeneration() )
+                anyParallel = true;
+        }
+
+        if( !anyParallel )
+            return;
+
+        OgreProfileGroupAggregate( "Shader Generation", OGREPROF_RENDERING );
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            QueuedRenderableArray::const_iterator itor = mRenderQueues[i].mQueuedRenderables.begin();
+            QueuedRenderableArray::const_iterator endt = mRenderQueues[i].mQueuedRenderables.end();
+
+            while( itor != endt )
+            {
+                const HlmsDatablock *datablock = itor->renderable->getDatablock();
+                Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+                hlms->_queueShaderGeneration( mPassCache[datablock->mType], *itor, casterPass );
+                ++itor;
+            }
+        }
+
+        ParallelShaderGenerationTask task( mHlmsManager );
+        if( !task.getNumChunks() )
+            return;
+
+        TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        taskScheduler->wait( taskScheduler->submit( &task, task.getNumChunks() ) );
+
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+        {
+            Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+            if( hlms && hlms->_hasPendingShaderGeneration() )
+                hlms->_compilePendingShaders();
+        }
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::renderES2( RenderSystem *rs, bool casterPass, bool dualParaboloid,
                                  HlmsCache passCache[HLMS_MAX],
                                  const RenderQueueGroup &renderQueueGroup )
@@ -522,6 +691,13 @@ namespace Ogre
             lastHlmsCacheHash = lastHlmsCache->hash;
             const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
                                                             queuedRenderable, casterPass );
+            if( !hlmsCache )
+            {
+                // Shaders not ready yet (see Hlms::setAsyncShaderCompilation)
+                ++itor;
+                continue;
+            }
+
             if( lastHlmsCacheHash != hlmsCache->hash )
             {
                 rs->_setPipelineStateObject( &hlmsCache->pso );
@@ -551,8 +727,46 @@ namespace Ogre
                                            unsigned char *indirectDraw,
                                            unsigned char *startIndirectDraw )
     {
+        const size_t numSlices = getNumCommandSlices( renderQueueGroup );
+        if( numSlices > 1u )
+        {
+            return renderGL3Parallel( rs, casterPass, passCache, renderQueueGroup, indirectBuffer,
+                                      indirectDraw, startIndirectDraw, numSlices );
+        }
+
+        CommandSlice slice;
+        slice.commandBuffer = mCommandBuffer;
+        slice.firstIdx = 0u;
+        slice.lastIdx = renderQueueGroup.mQueuedRenderables.size();
+        slice.resumeIdx = 0u;
+        slice.indirectDraw = indirectDraw;
+        slice.lastVaoName = mLastVaoName;
+
+        renderGL3Range( slice, casterPass, passCache, renderQueueGroup.mQueuedRenderables,
+                        indirectBuffer, startIndirectDraw, std::numeric_limits<size_t>::max() );
+
+        rs->_addMetrics( slice.stats );
+
+        mLastVaoName = slice.lastVaoName;
+        mLastVertexData = 0;
+        mLastIndexData = 0;
+        mLastTextureHash = 0;
+
+        return slice.indirectDraw;
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::renderGL3Range( CommandSlice &slice, bool casterPass, HlmsCache passCache[],
+                                      const QueuedRenderableArray &queuedRenderables,
+                                      IndirectBufferPacked *indirectBuffer,
+                                      unsigned char *startIndirectDraw, size_t sliceIdx )
+    {
+        const bool isRenderThread = sliceIdx == std::numeric_limits<size_t>::max();
+
+        CommandBuffer *commandBuffer = slice.commandBuffer;
+        unsigned char *indirectDraw = slice.indirectDraw;
+
         VertexArrayObject *lastVao = 0;
-        uint32 lastVaoName = mLastVaoName;
+        uint32 lastVaoName = slice.lastVaoName;
         HlmsCache const *lastHlmsCache = &c_dummyCache;
         uint32 lastHlmsCacheHash = 0;
 
@@ -570,16 +784,14 @@ namespace Ogre
         CbDrawCall *drawCmd = 0;
         CbSharedDraw *drawCountPtr = 0;
 
-        RenderingMetrics stats;
-
-        const QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        RenderingMetrics &stats = slice.stats;
 
-        QueuedRenderableArray::const_iterator itor = queuedRenderables.begin();
-        QueuedRenderableArray::const_iterator endt = queuedRenderables.end();
+        size_t idx = slice.resumeIdx;
+        const size_t lastIdx = slice.lastIdx;
 
-        while( itor != endt )
+        while( idx != lastIdx )
         {
-            const QueuedRenderable &queuedRenderable = *itor;
+            const QueuedRenderable &queuedRenderable = queuedRenderables[idx];
             uint8 meshLod = queuedRenderable.movableObject->getCurrentMeshLod();
             const VertexArrayObjectArray &vaos =
                 queuedRenderable.renderable->getVaos( static_cast<VertexPass>( casterPass ) );
@@ -590,11 +802,32 @@ namespace Ogre
             Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
 
             lastHlmsCacheHash = lastHlmsCache->hash;
-            const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
-                                                            queuedRenderable, casterPass );
+            const HlmsCache *hlmsCache;
+            if( isRenderThread )
+            {
+                hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
+                                               queuedRenderable, casterPass );
+            }
+            else
+            {
+                // getMaterial may create shaders, which can only happen in the render thread
+                hlmsCache = mSliceHlmsCaches[idx];
+            }
+
+            if( !hlmsCache )
+            {
+                // Shaders not ready yet (see Hlms::setAsyncShaderCompilation)
+                ++idx;
+                continue;
+            }
+
+            // Where this renderable's commands start, in case the slice has to give it up
+            const size_t cmdBufferOffset = commandBuffer->getEndOffset();
+            const uint32 prevVaoName = lastVaoName;
+
             if( lastHlmsCacheHash != hlmsCache->hash )
             {
-                CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
+                CbPipelineStateObject *psoCmd = commandBuffer->addCommand<CbPipelineStateObject>();
                 *psoCmd = CbPipelineStateObject( &hlmsCache->pso );
                 lastHlmsCache = hlmsCache;
 
@@ -602,18 +835,36 @@ namespace Ogre
                 lastVaoName = 0;
             }
 
-            uint32 baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
-                                                          lastHlmsCacheHash, mCommandBuffer );
+            uint32 baseInstance;
+            if( isRenderThread )
+            {
+                baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
+                                                       lastHlmsCacheHash, commandBuffer );
+            }
+            else
+            {
+                baseInstance = hlms->_fillBuffersForV2Slice( sliceIdx, hlmsCache, queuedRenderable,
+                                                             casterPass, lastHlmsCacheHash,
+                                                             commandBuffer );
+                if( baseInstance == Hlms::c_retryFillInRenderThread )
+                {
+                    // Discard what we and the Hlms recorded for it. The render
+                    // thread records it again, after the rest of the slice.
+                    commandBuffer->rollbackTo( cmdBufferOffset );
+                    lastVaoName = prevVaoName;
+                    break;
+                }
+            }
 
-            if( drawCmd != mCommandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() )
+            if( drawCmd != commandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() )
             {
                 // Different mesh, vertex buffers or layout. Make a new draw call.
                 //(or also the the Hlms made a batch-breaking command)
 
                 if( lastVaoName != vao->getVaoName() )
                 {
-                    *mCommandBuffer->addCommand<CbVao>() = CbVao( vao );
-                    *mCommandBuffer->addCommand<CbIndirectBuffer>() = CbIndirectBuffer( indirectBuffer );
+                    *commandBuffer->addCommand<CbVao>() = CbVao( vao );
+                    *commandBuffer->addCommand<CbIndirectBuffer>() = CbIndirectBuffer( indirectBuffer );
                     lastVaoName = vao->getVaoName();
                 }
 
@@ -623,13 +874,13 @@ namespace Ogre
 
                 if( vao->getIndexBuffer() )
                 {
-                    CbDrawCallIndexed *drawCall = mCommandBuffer->addCommand<CbDrawCallIndexed>();
+                    CbDrawCallIndexed *drawCall = commandBuffer->addCommand<CbDrawCallIndexed>();
                     *drawCall = CbDrawCallIndexed( baseInstanceAndIndirectBuffers, vao, offset );
                     drawCmd = drawCall;
                 }
                 else
                 {
-                    CbDrawCallStrip *drawCall = mCommandBuffer->addCommand<CbDrawCallStrip>();
+                    CbDrawCallStrip *drawCall = commandBuffer->addCommand<CbDrawCallStrip>();
                     *drawCall = CbDrawCallStrip( baseInstanceAndIndirectBuffers, vao, offset );
                     drawCmd = drawCall;
                 }
@@ -701,17 +952,168 @@ namespace Ogre
 
             stats.mVertexCount += vao->mPrimCount * instancesPerDraw;
 
+            ++idx;
+        }
+
+        slice.resumeIdx = idx;
+        slice.indirectDraw = indirectDraw;
+        slice.lastVaoName = lastVaoName;
+    }
+    //-----------------------------------------------------------------------
+    size_t RenderQueue::getNumCommandSlices( const RenderQueueGroup &renderQueueGroup ) const
+    {
+        const size_t numRenderables = renderQueueGroup.mQueuedRenderables.size();
+        if( numRenderables < mMinRenderablesPerSlice * 2u )
+            return 1u;
+
+        const TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        const size_t numSlices = std::min( taskScheduler->getNumThreads(),
+                                           numRenderables / mMinRenderablesPerSlice );
+        if( numSlices <= 1u )
+            return 1u;
+
+        bool usesHlms[HLMS_MAX];
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+            usesHlms[i] = false;
+
+        QueuedRenderableArray::const_iterator itor = renderQueueGroup.mQueuedRenderables.begin();
+        QueuedRenderableArray::const_iterator endt = renderQueueGroup.mQueuedRenderables.end();
+
+        while( itor != endt )
+        {
+            usesHlms[itor->renderable->getDatablock()->mType] = true;
             ++itor;
         }
 
-        rs->_addMetrics( stats );
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+        {
+            if( usesHlms[i] &&
+                !mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) )->getParallelCommandGeneration() )
+            {
+                return 1u;
+            }
+        }
+
+        return numSlices;
+    }
+    //-----------------------------------------------------------------------
+    unsigned char *RenderQueue::renderGL3Parallel( RenderSystem *rs, bool casterPass,
+                                                   HlmsCache passCache[],
+                                                   const RenderQueueGroup &renderQueueGroup,
+                                                   IndirectBufferPacked *indirectBuffer,
+                                                   unsigned char *indirectDraw,
+                                                   unsigned char *startIndirectDraw, size_t numSlices )
+    {
+        OgreProfileGroupAggregate( "Parallel Command Generation", OGREPROF_RENDERING );
+
+        const QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
+        const size_t numRenderables = queuedRenderables.size();
+
+        while( mSliceCommandBuffers.size() < numSlices )
+            mSliceCommandBuffers.push_back( new CommandBuffer() );
+        mCommandSlices.resizePOD( numSlices );
+
+        // Each renderable writes at most one indirect draw. Give each slice the region
+        // its renderables would've used if recorded serially, so they can't overlap.
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            CommandSlice &slice = mCommandSlices[i];
+            slice.commandBuffer = mSliceCommandBuffers[i];
+            slice.firstIdx = ( numRenderables * i ) / numSlices;
+            slice.lastIdx = ( numRenderables * ( i + 1u ) ) / numSlices;
+            slice.resumeIdx = slice.firstIdx;
+            slice.indirectDraw = indirectDraw + slice.firstIdx * sizeof( CbDrawIndexed );
+            slice.lastVaoName = 0;
+            slice.stats = RenderingMetrics();
+        }
+
+        // Retrieve the HlmsCaches here, as getMaterial may need to create shaders
+        mSliceHlmsCaches.resizePOD( numRenderables );
+        mSliceRenderablesPerHlms.resizePOD( HLMS_MAX * numSlices );
+        memset( mSliceRenderablesPerHlms.begin(), 0,
+                mSliceRenderablesPerHlms.size() * sizeof( size_t ) );
+
+        bool usesHlms[HLMS_MAX];
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+            usesHlms[i] = false;
+
+        HlmsCache const *lastHlmsCache = &c_dummyCache;
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            const CommandSlice &slice = mCommandSlices[i];
+            for( size_t j = slice.firstIdx; j < slice.lastIdx; ++j )
+            {
+                const QueuedRenderable &queuedRenderable = queuedRenderables[j];
+                const uint8 hlmsType = queuedRenderable.renderable->getDatablock()->mType;
+                Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( hlmsType ) );
+
+                const HlmsCache *hlmsCache =
+                    hlms->getMaterial( lastHlmsCache, passCache[hlmsType], queuedRenderable,
+                                       casterPass );
+                mSliceHlmsCaches[j] = hlmsCache;
+                if( hlmsCache )
+                    lastHlmsCache = hlmsCache;
+
+                ++mSliceRenderablesPerHlms[hlmsType * numSlices + i];
+                usesHlms[hlmsType] = true;
+            }
+        }
+
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+        {
+            if( usesHlms[i] )
+            {
+                Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                hlms->_beginParallelCommandGeneration( mCommandBuffer, casterPass, numSlices,
+                                                       &mSliceRenderablesPerHlms[i * numSlices] );
+            }
+        }
+
+        CommandSliceTask task( this, casterPass, passCache, queuedRenderables, indirectBuffer,
+                               startIndirectDraw );
+        TaskScheduler *taskScheduler = mSceneManager->getTaskScheduler();
+        taskScheduler->wait( taskScheduler->submit( &task, numSlices ) );
+
+        for( size_t i = 0; i < HLMS_MAX; ++i )
+        {
+            if( usesHlms[i] )
+            {
+                Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                hlms->_endParallelCommandGeneration( mSliceCommandBuffers.begin() );
+            }
+        }
+
+        // Stitch the slices in order. Each slice started from scratch (as if the previous
+        // renderable belonged to another Hlms), so they don't depend on each other's state.
+        // Whatever a slice couldn't record gets recorded here, right after it.
+        uint32 lastVaoName = mLastVaoName;
+        for( size_t i = 0u; i < numSlices; ++i )
+        {
+            CommandSlice &slice = mCommandSlices[i];
+            mCommandBuffer->appendAndClear( slice.commandBuffer );
+
+            if( slice.resumeIdx != slice.lastIdx )
+            {
+                CommandSlice remainder = slice;
+                remainder.commandBuffer = mCommandBuffer;
+                remainder.stats = RenderingMetrics();
+                renderGL3Range( remainder, casterPass, passCache, queuedRenderables, indirectBuffer,
+                                startIndirectDraw, std::numeric_limits<size_t>::max() );
+                slice.indirectDraw = remainder.indirectDraw;
+                slice.lastVaoName = remainder.lastVaoName;
+                rs->_addMetrics( remainder.stats );
+            }
+
+            rs->_addMetrics( slice.stats );
+            lastVaoName = slice.lastVaoName;
+        }
 
         mLastVaoName = lastVaoName;
         mLastVertexData = 0;
         mLastIndexData = 0;
         mLastTextureHash = 0;
 
-        return indirectDraw;
+        return mCommandSlices[numSlices - 1u].indirectDraw;
     }
     //-----------------------------------------------------------------------
     void RenderQueue::renderGL3V1( RenderSystem *rs, bool casterPass, bool dualParaboloid,
@@ -753,6 +1155,13 @@ namespace Ogre
             lastHlmsCacheHash = lastHlmsCache->hash;
             const HlmsCache *hlmsCache = hlms->getMaterial( lastHlmsCache, passCache[datablock->mType],
                                                             queuedRenderable, casterPass );
+            if( !hlmsCache )
+            {
+                // Shaders not ready yet (see Hlms::setAsyncShaderCompilation)
+                ++itor;
+                continue;
+            }
+
             if( lastHlmsCache != hlmsCache )
             {
                 CbPipelineStateObject *psoCmd = mCommandBuffer->addCommand<CbPipelineStateObject>();
@@ -901,15 +1310,20 @@ namespace Ogre
 
         const HlmsCache *hlmsCache =
             hlms->getMaterial( &c_dummyCache, passCache, queuedRenderable, casterPass );
-        rs->_setPipelineStateObject( &hlmsCache->pso );
 
-        mLastTextureHash =
-            hlms->fillBuffersFor( hlmsCache, queuedRenderable, casterPass, 0, mLastTextureHash );
+        // Null if the shaders aren't ready yet (see Hlms::setAsyncShaderCompilation)
+        if( hlmsCache )
+        {
+            rs->_setPipelineStateObject( &hlmsCache->pso );
 
-        const v1::CbRenderOp cmd( op );
-        rs->_setRenderOperation( &cmd );
+            mLastTextureHash =
+                hlms->fillBuffersFor( hlmsCache, queuedRenderable, casterPass, 0, mLastTextureHash );
 
-        rs->_render( op );
+            const v1::CbRenderOp cmd( op );
+            rs->_setRenderOperation( &cmd );
+
+            rs->_render( op );
+        }
 
         mLastVaoName = 0;
         --mRenderingStarted;
@@ -929,6 +1343,19 @@ namespace Ogre
         mFreeIndirectBuffers.insert( mFreeIndirectBuffers.end(), mUsedIndirectBuffers.begin(),
                                      mUsedIndirectBuffers.end() );
         mUsedIndirectBuffers.clear();
+
+        // Forget the orders of cameras that didn't render this frame
+        FrameCoherentOrderMap::iterator itOrder = mFrameCoherentOrders.begin();
+        FrameCoherentOrderMap::iterator enOrder = mFrameCoherentOrders.end();
+        while( itOrder != enOrder )
+        {
+            if( itOrder->second.lastFrame != mFrameCount )
+                mFrameCoherentOrders.erase( itOrder++ );
+            else
+                ++itOrder;
+        }
+
+        ++mFrameCount;
     }
     //-----------------------------------------------------------------------
     void RenderQueue::setRenderQueueMode( uint8 rqId, Modes newMode )
@@ -950,4 +1377,17 @@ namespace Ogre
     {
         return mRenderQueues[rqId].mSortMode;
     }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setMinRenderablesPerSlice( size_t minRenderables )
+    {
+        assert( minRenderables > 0u );
+        mMinRenderablesPerSlice = std::max<size_t>( minRenderables, 1u );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::setFrameCoherentSorting( bool frameCoherentSorting )
+    {
+        mFrameCoherentSorting = frameCoherentSorting;
+        if( !mFrameCoherentSorting )
+            mFrameCoherentOrders.clear();
+    }
 }  // namespace Ogre
@@ -411,6 +411,16 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void Resource::_fireLoadingFailed( const String &description )
+    {
+        // Lock the listener list
+        OGRE_LOCK_MUTEX( mListenerListMutex );
+        for( ListenerList::iterator i = mListenerList.begin(); i != mListenerList.end(); ++i )
+        {
+            ( *i )->loadingFailed( this, description );
+        }
+    }
+    //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     ManualResourceLoader::~ManualResourceLoader() {}
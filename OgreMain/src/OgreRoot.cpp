@@ -147,6 +147,7 @@ namespace Ogre
         mNextMovableObjectTypeFlag( 1 ),
         mIsInitialised( false ),
         mFrameStarted( false ),
+        mLastStreamingStallTimeUs( 0u ),
         mIsBlendIndicesGpuRedundant( true ),
         mIsBlendWeightsGpuRedundant( true )
     {
@@ -237,6 +238,9 @@ namespace Ogre
         // Profiler
         mProfiler = OGRE_NEW Profiler();
         Profiler::getSingleton().setTimer( mTimer );
+#    if OGRE_PROFILING == OGRE_PROFILING_INTERNAL_OFFLINE
+        mProfiler->getOfflineProfiler().setCurrentThreadName( "Main Thread" );
+#    endif
 #endif
 
         mFileSystemArchiveFactory = OGRE_NEW FileSystemArchiveFactory();
@@ -331,6 +335,7 @@ namespace Ogre
             << "Average time: \t" << mFrameStats->getAvgTime() << " ms\n"
             << "Best time: \t" << mFrameStats->getBestTime() << " ms\n"
             << "Worst time: \t" << mFrameStats->getWorstTime() << " ms";
+        mFrameStats->logStats();
 
 #if OGRE_PROFILING && OGRE_PROFILING != OGRE_PROFILING_INTERNAL_OFFLINE
         OGRE_DELETE mProfiler;
@@ -914,6 +919,9 @@ namespace Ogre
             OgreProfileBeginDynamicHashed( frameNum.c_str(), &hashValue );
             OgreProfileGpuBeginDynamicHashed( frameNum.c_str(), &hashValue );
         }
+#    if OGRE_PROFILING == OGRE_PROFILING_INTERNAL_OFFLINE
+        Profiler::getSingleton().getOfflineProfiler().markFrame();
+#    endif
 #endif
 
         if( !mActiveRenderer->validateDevice() )
@@ -921,6 +929,9 @@ namespace Ogre
 
         _syncAddedRemovedFrameListeners();
 
+        // Finish loading the meshes read by MeshManager::loadInBackground
+        mMeshManager->_update( false );
+
         // Tell all listeners
         {
             OgreProfile( "Root::frameStarted Listeners" );
@@ -1092,6 +1103,8 @@ namespace Ogre
         if( !_fireFrameStarted() )
             return false;
 
+        uint64 stageStartUs = mTimer->getMicroseconds();
+
         SceneManagerEnumerator::SceneManagerIterator itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
@@ -1099,9 +1112,15 @@ namespace Ogre
             sceneManager->updateSceneGraph();
         }
 
+        uint64 stageEndUs = mTimer->getMicroseconds();
+        mFrameStats->addStageTime( FrameStage::SceneUpdate, stageEndUs - stageStartUs );
+        stageStartUs = stageEndUs;
+
         if( !_updateAllRenderTargets() )
             return false;
 
+        mFrameStats->addStageTime( FrameStage::Compositor, mTimer->getMicroseconds() - stageStartUs );
+
         itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
@@ -1125,6 +1144,8 @@ namespace Ogre
         if( !_fireFrameStarted( evt ) )
             return false;
 
+        uint64 stageStartUs = mTimer->getMicroseconds();
+
         SceneManagerEnumerator::SceneManagerIterator itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
@@ -1132,9 +1153,15 @@ namespace Ogre
             sceneManager->updateSceneGraph();
         }
 
+        uint64 stageEndUs = mTimer->getMicroseconds();
+        mFrameStats->addStageTime( FrameStage::SceneUpdate, stageEndUs - stageStartUs );
+        stageStartUs = stageEndUs;
+
         if( !_updateAllRenderTargets( evt ) )
             return false;
 
+        mFrameStats->addStageTime( FrameStage::Compositor, mTimer->getMicroseconds() - stageStartUs );
+
         itor = mSceneManagerEnum->getSceneManagerIterator();
         while( itor.hasMoreElements() )
         {
@@ -1625,7 +1652,23 @@ namespace Ogre
         {
             Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
             if( hlms )
+            {
                 hlms->frameEnded();
+                hlms->_notifyFrameEnded();
+                mFrameStats->addStageTime( FrameStage::ShaderCompile,
+                                           hlms->getShaderGenerationStats().compileTimeUs );
+            }
+        }
+
+        TextureGpuManager *textureGpuManager = mActiveRenderer->getTextureGpuManager();
+        if( textureGpuManager )
+        {
+            const uint64 stallTimeUs = textureGpuManager->getStreamingStallTimeUs();
+            if( stallTimeUs < mLastStreamingStallTimeUs )
+                mLastStreamingStallTimeUs = 0u;  // The RenderSystem was recreated
+            mFrameStats->addStageTime( FrameStage::TextureStreamingStall,
+                                       stallTimeUs - mLastStreamingStallTimeUs );
+            mLastStreamingStallTimeUs = stallTimeUs;
         }
 
         mFrameStarted = false;
@@ -58,6 +58,7 @@ THE SOFTWARE.
 #include "OgreMaterialManager.h"
 #include "OgreMesh2.h"
 #include "OgreMeshManager.h"
+#include "OgreOcclusionBuffer.h"
 #include "OgreOldNode.h"
 #include "OgreParticleSystem.h"
 #include "OgreParticleSystemManager.h"
@@ -74,15 +75,20 @@ THE SOFTWARE.
 #include "OgreTextureGpuManager.h"
 #include "OgreViewport.h"
 #include "OgreWireAabb.h"
-#include "Threading/OgreBarrier.h"
+#include "Threading/OgreTaskScheduler.h"
 #include "Threading/OgreUniformScalableTask.h"
 
 // This class implements the most basic scene manager
 
 #include <cstdio>
+#include <limits>
 
 namespace Ogre
 {
+    /// Objects & nodes are split in about this many chunks per worker thread
+    static const size_t c_chunksPerThread = 8u;
+    /// Chunks never get smaller than this
+    static const size_t c_minObjectsPerChunk = 128u;
     //-----------------------------------------------------------------------
     uint32 SceneManager::QUERY_ENTITY_DEFAULT_MASK = 0x80000000;
     uint32 SceneManager::QUERY_FX_DEFAULT_MASK = 0x40000000;
@@ -92,9 +98,12 @@ namespace Ogre
     //-----------------------------------------------------------------------
     SceneManager::SceneManager( const String &name, size_t numWorkerThreads ) :
         IdObject( Id::generateNewId<SceneManager>() ),
+        mIncrementalDefragSlotsPerFrame( 0u ),
         mNumDecals( 0 ),
         mNumCubemapProbes( 0 ),
         mStaticMinDepthLevelDirty( 0 ),
+        mStaticDirtyFlagsMinDepth( std::numeric_limits<uint16>::max() ),
+        mTransformDirtyTracking( true ),
         mStaticEntitiesDirty( true ),
         mPrePassMode( PrePassNone ),
         mSsrTexture( 0 ),
@@ -145,10 +154,18 @@ namespace Ogre
         mFindVisibleObjects( true ),
         mNumWorkerThreads( std::max<size_t>( numWorkerThreads, 1u ) ),
         mForceMainThread( numWorkerThreads == 0u ? true : false ),
-        mUpdateBoundsRequest( 0 ),
-        mUserTask( 0 ),
         mRequestType( NUM_REQUESTS ),
-        mWorkerThreadsBarrier( 0 ),
+        mTaskScheduler( 0 ),
+        mUniformRequestTask( this ),
+        mChunkedRequestTask( this ),
+        mUserTaskId( TaskScheduler::FinishedTask ),
+        mBatchedCullCameraIdx( 0 ),
+        mBatchedCullFired( false ),
+        mOcclusionBuffer( 0 ),
+        mOcclusionBufferWidth( 256u ),
+        mOcclusionBufferHeight( 128u ),
+        mOcclusionRowsPerBand( 0u ),
+        mOcclusionCullingInPass( false ),
         mSuppressRenderStateChanges( false ),
         mLastLightHash( 0 ),
         mLastLightLimit( 0 ),
@@ -188,6 +205,9 @@ namespace Ogre
         mBuildLightListRequestPerThread.resize( mNumWorkerThreads );
         mVisibleObjects.resize( mNumWorkerThreads );
         mTmpVisibleObjects.resize( mNumWorkerThreads );
+        mSharedSkeletonPoses.resize( mNumWorkerThreads );
+        mOcclusionCullingStatsPerThread.resize( mNumWorkerThreads );
+        mTextureScreenCoveragePerThread.resize( mNumWorkerThreads );
 
         startWorkerThreads();
 
@@ -268,6 +288,9 @@ namespace Ogre
             OGRE_DELETE mSceneRoot[i];
             mSceneRoot[i] = 0;
         }
+        OGRE_DELETE mOcclusionBuffer;
+        mOcclusionBuffer = 0;
+
         OGRE_DELETE mRenderQueue;
         OGRE_DELETE mAutoParamDataSource;
 
@@ -480,6 +503,69 @@ namespace Ogre
         mTagPointNodeMemoryManager.defragment();
     }
     //-----------------------------------------------------------------------
+    size_t SceneManager::defragmentMemoryPoolsIncremental( size_t maxSlotsToMove,
+                                                           bool onlyPendingCleanups )
+    {
+        size_t slotsMoved = 0;
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            slotsMoved += mNodeMemoryManager[i].defragmentIncremental( maxSlotsToMove - slotsMoved,
+                                                                       onlyPendingCleanups );
+            slotsMoved += mEntityMemoryManager[i].defragmentIncremental( maxSlotsToMove - slotsMoved,
+                                                                         onlyPendingCleanups );
+            slotsMoved += mForwardPlusMemoryManager[i].defragmentIncremental(
+                maxSlotsToMove - slotsMoved, onlyPendingCleanups );
+        }
+
+        slotsMoved += mLightMemoryManager.defragmentIncremental( maxSlotsToMove - slotsMoved,
+                                                                 onlyPendingCleanups );
+        slotsMoved += mTagPointNodeMemoryManager.defragmentIncremental( maxSlotsToMove - slotsMoved,
+                                                                        onlyPendingCleanups );
+
+        return slotsMoved;
+    }
+    //-----------------------------------------------------------------------
+    float SceneManager::getMemoryPoolsFragmentationRatio() const
+    {
+        size_t numFragmented = 0;
+        size_t numUsed = 0;
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            numFragmented += mNodeMemoryManager[i].getNumFragmentedSlots() +
+                             mEntityMemoryManager[i].getNumFragmentedSlots() +
+                             mForwardPlusMemoryManager[i].getNumFragmentedSlots();
+            numUsed += mNodeMemoryManager[i].getNumUsedSlotsIncludingFragmented() +
+                       mEntityMemoryManager[i].getNumUsedSlotsIncludingFragmented() +
+                       mForwardPlusMemoryManager[i].getNumUsedSlotsIncludingFragmented();
+        }
+
+        numFragmented += mLightMemoryManager.getNumFragmentedSlots() +
+                         mTagPointNodeMemoryManager.getNumFragmentedSlots();
+        numUsed += mLightMemoryManager.getNumUsedSlotsIncludingFragmented() +
+                   mTagPointNodeMemoryManager.getNumUsedSlotsIncludingFragmented();
+
+        return numUsed ? static_cast<float>( numFragmented ) / static_cast<float>( numUsed ) : 0.0f;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::setIncrementalDefragmentation( size_t maxSlotsPerFrame )
+    {
+        mIncrementalDefragSlotsPerFrame = maxSlotsPerFrame;
+
+        // When disabling, the managers perform their pending cleanups right away
+        const bool bDeferred = maxSlotsPerFrame != 0u;
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            mNodeMemoryManager[i].setDeferredCleanup( bDeferred );
+            mEntityMemoryManager[i].setDeferredCleanup( bDeferred );
+            mForwardPlusMemoryManager[i].setDeferredCleanup( bDeferred );
+        }
+
+        mLightMemoryManager.setDeferredCleanup( bDeferred );
+        mTagPointNodeMemoryManager.setDeferredCleanup( bDeferred );
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::shrinkToFitMemoryPools()
     {
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
@@ -1271,31 +1357,36 @@ namespace Ogre
                 // Quick way of reducing overhead/stress on VisibleObjectsBoundsInfo
                 // calculation (lastRq can be up to 255)
                 uint8 realFirstRq = firstRq;
-                uint8 realLastRq = 0;
-                {
-                    ObjectMemoryManagerVec::const_iterator itor =
-                        mEntitiesMemoryManagerCulledList.begin();
-                    ObjectMemoryManagerVec::const_iterator endt = mEntitiesMemoryManagerCulledList.end();
-                    while( itor != endt )
-                    {
-                        realFirstRq =
-                            (uint8)std::min<size_t>( realFirstRq, ( *itor )->_getTotalRenderQueues() );
-                        realLastRq =
-                            (uint8)std::max<size_t>( realLastRq, ( *itor )->_getTotalRenderQueues() );
-                        ++itor;
-                    }
-
-                    // clamp RQ values to the real RQ range
-                    realFirstRq = std::min( realLastRq, std::max( realFirstRq, firstRq ) );
-                    realLastRq = std::min( realLastRq, std::max( realFirstRq, lastRq ) );
-                }
+                uint8 realLastRq = lastRq;
+                clampToUsedRenderQueues( realFirstRq, realLastRq );
 
                 cullCamera->_setRenderedRqs( realFirstRq, realLastRq );
 
                 CullFrustumRequest cullRequest(
                     realFirstRq, realLastRq, mIlluminationStage == IRS_RENDER_TO_TEXTURE, true, false,
                     &mEntitiesMemoryManagerCulledList, cullCamera, lodCamera );
-                fireCullFrustumThreads( cullRequest );
+                cullRequest.occlusionCulling =
+                    mOcclusionCullingInPass && !cullRequest.casterPass &&
+                    prepareOcclusionBuffer( cullCamera, realFirstRq, realLastRq );
+                cullRequest.textureScreenCoverage =
+                    !cullRequest.casterPass &&
+                    mDestRenderSystem->getTextureGpuManager()->getAutomaticLoadPriorities();
+
+                if( !addBatchedCullResults( cullRequest ) )
+                    fireCullFrustumTasks( cullRequest );
+
+                if( cullRequest.occlusionCulling )
+                {
+                    for( size_t i = 0; i < mNumWorkerThreads; ++i )
+                    {
+                        const OcclusionCullingStats &threadStats = mOcclusionCullingStatsPerThread[i];
+                        mOcclusionCullingStats.numTested += threadStats.numTested;
+                        mOcclusionCullingStats.numRejected += threadStats.numRejected;
+                    }
+                }
+
+                if( cullRequest.textureScreenCoverage )
+                    collectTextureScreenCoverage();
             }
         }  // end lock on scene graph mutex
         else
@@ -1317,6 +1408,396 @@ namespace Ogre
         Root::getSingleton()._popCurrentSceneManager( this );
     }
     //-----------------------------------------------------------------------
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#    pragma GCC diagnostic push
+// FastArray::resize copy-constructs the new lists from an empty one. GCC doesn't see
+// the copy loop never runs when the source is empty and warns about the zero-sized buffer
+#    pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+    static void resetVisibleObjects( VisibleObjectsPerRq &visibleObjectsPerRq )
+    {
+        visibleObjectsPerRq.resize( 255 );
+        VisibleObjectsPerRq::iterator itor = visibleObjectsPerRq.begin();
+        VisibleObjectsPerRq::iterator endt = visibleObjectsPerRq.end();
+
+        while( itor != endt )
+        {
+            itor->clear();
+            ++itor;
+        }
+    }
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#    pragma GCC diagnostic pop
+#endif
+    //-----------------------------------------------------------------------
+    void SceneManager::_addOccluder( MovableObject *occluder ) { mOccluders.push_back( occluder ); }
+    //-----------------------------------------------------------------------
+    void SceneManager::_removeOccluder( MovableObject *occluder )
+    {
+        FastArray<MovableObject *>::iterator itor =
+            std::find( mOccluders.begin(), mOccluders.end(), occluder );
+        if( itor != mOccluders.end() )
+            efficientVectorRemove( mOccluders, itor );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::setOcclusionBufferResolution( uint32 width, uint32 height )
+    {
+        mOcclusionBufferWidth = std::max( width, 1u );
+        mOcclusionBufferHeight = std::max( height, 1u );
+        if( mOcclusionBuffer )
+            mOcclusionBuffer->setResolution( mOcclusionBufferWidth, mOcclusionBufferHeight );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::accumulateTextureScreenCoverage(
+        const Camera *camera, const MovableObject::MovableObjectArray &visibleObjects,
+        size_t firstIdx, size_t threadIdx )
+    {
+        // We want the radius of the bounding sphere projected to the screen, relative to
+        // half the screen's height. The coverage is its square, saturated to 1.
+        const bool isOrtho = camera->getProjectionType() == PT_ORTHOGRAPHIC;
+        const Real invHalfHeight = isOrtho
+                                       ? Real( 2.0 ) / camera->getOrthoWindowHeight()
+                                       : Real( 1.0 ) / Math::Tan( camera->getFOVy() * Real( 0.5 ) );
+        const Vector3 cameraPos = camera->_getCachedDerivedPosition();
+
+        DatablockScreenCoverageMap &screenCoverage = mTextureScreenCoveragePerThread[threadIdx];
+
+        MovableObject::MovableObjectArray::const_iterator itor = visibleObjects.begin() + firstIdx;
+        MovableObject::MovableObjectArray::const_iterator endt = visibleObjects.end();
+
+        while( itor != endt )
+        {
+            const MovableObject *movableObject = *itor;
+
+            Real projectedRadius = movableObject->getWorldRadius() * invHalfHeight;
+            if( !isOrtho )
+            {
+                const Real distance = cameraPos.distance( movableObject->getWorldAabb().mCenter );
+                projectedRadius /= std::max( distance, Real( 1e-6f ) );
+            }
+            const float coverage =
+                static_cast<float>( std::min( projectedRadius * projectedRadius, Real( 1 ) ) );
+
+            HlmsDatablock *lastDatablock = 0;
+
+            RenderableArray::const_iterator itRend = movableObject->mRenderables.begin();
+            RenderableArray::const_iterator enRend = movableObject->mRenderables.end();
+
+            while( itRend != enRend )
+            {
+                HlmsDatablock *datablock = ( *itRend )->getDatablock();
+                // Submeshes often share the material
+                if( datablock && datablock != lastDatablock )
+                {
+                    std::pair<DatablockScreenCoverageMap::iterator, bool> inserted =
+                        screenCoverage.insert(
+                            DatablockScreenCoverageMap::value_type( datablock, coverage ) );
+                    if( !inserted.second )
+                        inserted.first->second = std::max( inserted.first->second, coverage );
+                    lastDatablock = datablock;
+                }
+                ++itRend;
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::collectTextureScreenCoverage()
+    {
+        OgreProfileExhaustive( "SceneManager::collectTextureScreenCoverage" );
+
+        vector<DatablockScreenCoverageMap>::type::iterator it =
+            mTextureScreenCoveragePerThread.begin();
+        vector<DatablockScreenCoverageMap>::type::iterator en = mTextureScreenCoveragePerThread.end();
+
+        while( it != en )
+        {
+            DatablockScreenCoverageMap::const_iterator itor = it->begin();
+            DatablockScreenCoverageMap::const_iterator endt = it->end();
+
+            while( itor != endt )
+            {
+                itor->first->_addTextureScreenCoverage( itor->second );
+                ++itor;
+            }
+
+            it->clear();
+            ++it;
+        }
+    }
+    //-----------------------------------------------------------------------
+    bool SceneManager::prepareOcclusionBuffer( const Camera *camera, uint8 firstRq, uint8 lastRq )
+    {
+        OgreProfileGroup( "Occluder Rasterization", OGREPROF_CULLING );
+
+        mOcclusionCullingStats = OcclusionCullingStats();
+        for( size_t i = 0; i < mNumWorkerThreads; ++i )
+            mOcclusionCullingStatsPerThread[i] = OcclusionCullingStats();
+
+        if( mOccluders.empty() )
+            return false;
+
+        if( !mOcclusionBuffer )
+            mOcclusionBuffer = OGRE_NEW OcclusionBuffer( mOcclusionBufferWidth, mOcclusionBufferHeight );
+
+        mOcclusionBuffer->beginOccluders( camera->getProjectionMatrix() * camera->getViewMatrix() );
+
+        const uint32 visibilityMask =
+            getCombinedVisibilityMask( camera->getLastViewport()->getVisibilityMask() );
+
+        FastArray<MovableObject *>::const_iterator itor = mOccluders.begin();
+        FastArray<MovableObject *>::const_iterator endt = mOccluders.end();
+
+        while( itor != endt )
+        {
+            const MovableObject *occluder = *itor;
+            const uint8 renderQueueId = occluder->getRenderQueueGroup();
+
+            // Objects that won't be rendered by this pass can't hide anything
+            if( occluder->isAttached() && occluder->getVisible() &&
+                ( occluder->getVisibilityFlags() & visibilityMask ) && renderQueueId >= firstRq &&
+                renderQueueId < lastRq )
+            {
+                if( mOcclusionBuffer->addOccluder( occluder->getLocalAabb(),
+                                                   occluder->_getParentNodeFullTransform() ) )
+                {
+                    ++mOcclusionCullingStats.numOccluders;
+                }
+            }
+
+            ++itor;
+        }
+
+        if( !mOcclusionCullingStats.numOccluders )
+            return false;
+
+        // Split the buffer in bands of rows, a few per thread so they balance better
+        const uint32 height = mOcclusionBuffer->getHeight();
+        const uint32 numBands = std::min( height, static_cast<uint32>( mNumWorkerThreads * 4u ) );
+        mOcclusionRowsPerBand = ( height + numBands - 1u ) / numBands;
+
+        mRequestType = RASTERIZE_OCCLUDERS;
+        mTaskScheduler->wait( mTaskScheduler->submit(
+            &mChunkedRequestTask, ( height + mOcclusionRowsPerBand - 1u ) / mOcclusionRowsPerBand ) );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::applyOcclusionCulling( MovableObject::MovableObjectArray &inOutVisibleObjects,
+                                              size_t firstIdx, size_t threadIdx )
+    {
+        MovableObject::MovableObjectArray::iterator itor = inOutVisibleObjects.begin() + firstIdx;
+        MovableObject::MovableObjectArray::iterator endt = inOutVisibleObjects.end();
+        MovableObject::MovableObjectArray::iterator dst = itor;
+
+        OcclusionCullingStats &stats = mOcclusionCullingStatsPerThread[threadIdx];
+        stats.numTested += static_cast<size_t>( endt - itor );
+
+        while( itor != endt )
+        {
+            // Precision errors could make an occluder hide behind its own bounds
+            if( ( *itor )->isOccluder() || !mOcclusionBuffer->isOccluded( ( *itor )->getWorldAabb() ) )
+                *dst++ = *itor;
+            ++itor;
+        }
+
+        stats.numRejected += static_cast<size_t>( endt - dst );
+        inOutVisibleObjects.resizePOD( static_cast<size_t>( dst - inOutVisibleObjects.begin() ) );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::setClusterCulling( SceneMemoryMgrTypes sceneType, bool bEnable )
+    {
+        mEntityMemoryManager[sceneType].setClusterCulling( bEnable );
+        // Force the static clusters to be built
+        if( sceneType == SCENE_STATIC )
+            mStaticEntitiesDirty = true;
+    }
+    //-----------------------------------------------------------------------
+    bool SceneManager::getClusterCulling( SceneMemoryMgrTypes sceneType ) const
+    {
+        return mEntityMemoryManager[sceneType].getClusterCulling();
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::clampToUsedRenderQueues( uint8 &inOutFirstRq, uint8 &inOutLastRq ) const
+    {
+        const uint8 firstRq = inOutFirstRq;
+        const uint8 lastRq = inOutLastRq;
+
+        uint8 realFirstRq = firstRq;
+        uint8 realLastRq = 0;
+
+        ObjectMemoryManagerVec::const_iterator itor = mEntitiesMemoryManagerCulledList.begin();
+        ObjectMemoryManagerVec::const_iterator endt = mEntitiesMemoryManagerCulledList.end();
+        while( itor != endt )
+        {
+            realFirstRq = (uint8)std::min<size_t>( realFirstRq, ( *itor )->_getTotalRenderQueues() );
+            realLastRq = (uint8)std::max<size_t>( realLastRq, ( *itor )->_getTotalRenderQueues() );
+            ++itor;
+        }
+
+        // clamp RQ values to the real RQ range
+        realFirstRq = std::min( realLastRq, std::max( realFirstRq, firstRq ) );
+        realLastRq = std::min( realLastRq, std::max( realFirstRq, lastRq ) );
+
+        inOutFirstRq = realFirstRq;
+        inOutLastRq = realLastRq;
+    }
+    //-----------------------------------------------------------------------
+    uint32 SceneManager::getCombinedVisibilityMask( uint32 viewportVisibilityMask ) const
+    {
+        return ( viewportVisibilityMask & this->getVisibilityMask() ) |
+               ( viewportVisibilityMask & ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_addBatchedCull( const Camera *cullCamera, const Camera *lodCamera,
+                                        uint32 viewportVisibilityMask, uint8 firstRq, uint8 lastRq )
+    {
+        if( mBatchedCullFired )
+            _clearBatchedCull();
+
+        clampToUsedRenderQueues( firstRq, lastRq );
+
+        BatchedCullCamera batchedCamera;
+        batchedCamera.camera = cullCamera;
+        batchedCamera.lodCamera = lodCamera;
+        batchedCamera.visibilityMask = getCombinedVisibilityMask( viewportVisibilityMask );
+        batchedCamera.firstRq = firstRq;
+        batchedCamera.lastRq = lastRq;
+        mBatchedCullCameras.push_back( batchedCamera );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_fireBatchedCull()
+    {
+        OgreProfileGroup( "Batched Frustum Culling", OGREPROF_CULLING );
+
+        if( mBatchedCullCameras.empty() || !mFindVisibleObjects )
+            return;
+
+        mBatchedCullFrustums.clear();
+        mBatchedCullLodCameras.clear();
+        mBatchedCullVisibilityMasks.clear();
+
+        size_t firstRq = std::numeric_limits<uint8>::max();
+        size_t lastRq = 0u;
+
+        FastArray<BatchedCullCamera>::iterator itor = mBatchedCullCameras.begin();
+        FastArray<BatchedCullCamera>::iterator endt = mBatchedCullCameras.end();
+
+        while( itor != endt )
+        {
+            // See fireCullFrustumThreads. Also remember the state we cull with, so that
+            // addBatchedCullResults can tell if the camera was changed afterwards
+            const Plane *frustumPlanes = itor->camera->getFrustumPlanes();
+            itor->lodCamera->getFrustumPlanes();
+            for( size_t i = 0; i < 6u; ++i )
+                itor->frustumPlanes[i] = frustumPlanes[i];
+            itor->cameraPos = itor->camera->_getCachedDerivedPosition();
+            itor->lodCameraPos = itor->lodCamera->_getCachedDerivedPosition();
+
+            mBatchedCullFrustums.push_back( itor->camera );
+            mBatchedCullLodCameras.push_back( itor->lodCamera );
+            mBatchedCullVisibilityMasks.push_back( itor->visibilityMask );
+
+            // Cameras are culled against the union of all ranges. The results of render
+            // queues outside a camera's range are ignored by addBatchedCullResultsChunk.
+            firstRq = std::min<size_t>( firstRq, itor->firstRq );
+            lastRq = std::max<size_t>( lastRq, itor->lastRq );
+            ++itor;
+        }
+
+        prepareObjectChunks( mEntitiesMemoryManagerCulledList, firstRq, lastRq );
+        mBatchedCullChunks.swap( mObjectChunks );
+
+        const size_t numResults = mBatchedCullChunks.size() * mBatchedCullCameras.size();
+        // Keep the capacity of the lists from previous frames
+        if( mBatchedCullObjects.size() < numResults )
+        {
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#    pragma GCC diagnostic push
+// See resetVisibleObjects
+#    pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+            mBatchedCullObjects.resize( numResults );
+            mBatchedCullDistances.resize( numResults );
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#    pragma GCC diagnostic pop
+#endif
+        }
+        for( size_t i = 0; i < numResults; ++i )
+        {
+            mBatchedCullObjects[i].clear();
+            mBatchedCullDistances[i].clear();
+        }
+
+        mRequestType = CULL_FRUSTUM_BATCH;
+        mTaskScheduler->wait(
+            mTaskScheduler->submit( &mChunkedRequestTask, mBatchedCullChunks.size() ) );
+
+        mBatchedCullFired = true;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::_clearBatchedCull()
+    {
+        mBatchedCullCameras.clear();
+        mBatchedCullChunks.clear();
+        mBatchedCullFired = false;
+    }
+    //-----------------------------------------------------------------------
+    bool SceneManager::addBatchedCullResults( const CullFrustumRequest &request )
+    {
+        if( !mBatchedCullFired )
+            return false;
+
+        const Camera *camera = request.camera;
+        const uint32 visibilityMask =
+            getCombinedVisibilityMask( camera->getLastViewport()->getVisibilityMask() );
+
+        size_t cameraIdx = mBatchedCullCameras.size();
+        for( size_t i = 0; i < mBatchedCullCameras.size() && cameraIdx == mBatchedCullCameras.size();
+             ++i )
+        {
+            const BatchedCullCamera &batchedCamera = mBatchedCullCameras[i];
+            if( batchedCamera.camera == camera && batchedCamera.lodCamera == request.lodCamera &&
+                batchedCamera.visibilityMask == visibilityMask &&
+                batchedCamera.firstRq == request.firstRq && batchedCamera.lastRq == request.lastRq )
+            {
+                // Listeners may have changed the camera after it was culled
+                const Plane *frustumPlanes = camera->getFrustumPlanes();
+                request.lodCamera->getFrustumPlanes();
+
+                bool sameFrustum = batchedCamera.cameraPos == camera->_getCachedDerivedPosition() &&
+                                   batchedCamera.lodCameraPos ==
+                                       request.lodCamera->_getCachedDerivedPosition();
+                for( size_t j = 0; j < 6u && sameFrustum; ++j )
+                    sameFrustum = batchedCamera.frustumPlanes[j] == frustumPlanes[j];
+
+                if( sameFrustum )
+                    cameraIdx = i;
+            }
+        }
+
+        if( cameraIdx == mBatchedCullCameras.size() )
+            return false;
+
+        mCurrentCullFrustumRequest = request;
+        mBatchedCullCameraIdx = cameraIdx;
+
+        VisibleObjectsPerThreadArray::iterator itor = mVisibleObjects.begin();
+        VisibleObjectsPerThreadArray::iterator endt = mVisibleObjects.end();
+        while( itor != endt )
+        {
+            resetVisibleObjects( *itor );
+            ++itor;
+        }
+
+        mRequestType = ADD_BATCHED_CULL_RESULTS;
+        mTaskScheduler->wait(
+            mTaskScheduler->submit( &mChunkedRequestTask, mBatchedCullChunks.size() ) );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::_renderPhase02( Camera *camera, const Camera *lodCamera, uint8 firstRq,
                                        uint8 lastRq, bool includeOverlays )
     {
@@ -1559,6 +2040,10 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllAnimationsThread( size_t threadIdx )
     {
+        // Poses can only be shared within the same thread, otherwise we'd
+        // be reading from instances that may still be being evaluated
+        SkeletonInstance::SharedPoseMap &sharedPoses = mSharedSkeletonPoses[threadIdx];
+
         SkeletonAnimManagerVec::const_iterator it = mSkeletonAnimManagerCulledList.begin();
         SkeletonAnimManagerVec::const_iterator en = mSkeletonAnimManagerCulledList.end();
 
@@ -1569,13 +2054,15 @@ namespace Ogre
 
             while( itByDef != enByDef )
             {
+                sharedPoses.clear();
+
                 FastArray<SkeletonInstance *>::iterator itor =
                     itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx];
                 FastArray<SkeletonInstance *>::iterator endt =
                     itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx + 1];
                 while( itor != endt )
                 {
-                    ( *itor )->update();
+                    ( *itor )->_update( sharedPoses );
                     ++itor;
                 }
 
@@ -1646,60 +2133,77 @@ namespace Ogre
         fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllTransformsThread( const UpdateTransformRequest &request,
-                                                  size_t threadIdx )
+    size_t SceneManager::getObjectsPerChunk( size_t numObjects ) const
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        Node::updateAllTransforms( numNodes, t );
+        // A few chunks per thread so that idle threads have something to steal, but not
+        // so small that the scheduling overhead dominates.
+        const size_t numChunks = mTaskScheduler->getNumThreads() * c_chunksPerThread;
+        size_t objsPerChunk = ( numObjects + numChunks - 1u ) / numChunks;
+        objsPerChunk = std::max( objsPerChunk, c_minObjectsPerChunk );
+        return ( ( objsPerChunk + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllTransforms()
+    SceneManager::TransformUpdateStats SceneManager::updateTransformsInTasks(
+        const NodeMemoryManagerVec &nodeMemoryManagers,
+        UpdateTransformTask::UpdateFunction rootUpdateFunction,
+        UpdateTransformTask::UpdateFunction updateFunction, size_t staticStartDepth )
     {
-        mRequestType = UPDATE_ALL_TRANSFORMS;
-        NodeMemoryManagerVec::const_iterator it = mNodeMemoryManagerUpdateList.begin();
-        NodeMemoryManagerVec::const_iterator en = mNodeMemoryManagerUpdateList.end();
+        TransformUpdateStats stats;
 
+        NodeMemoryManagerVec::const_iterator it = nodeMemoryManagers.begin();
+        NodeMemoryManagerVec::const_iterator en = nodeMemoryManagers.end();
         while( it != en )
         {
             NodeMemoryManager *nodeMemoryManager = *it;
-            const size_t numDepths = nodeMemoryManager->getNumDepths();
+            const size_t numDepthsInManager = nodeMemoryManager->getNumDepths();
 
-            size_t start = nodeMemoryManager->getMemoryManagerType() == SCENE_STATIC
-                               ? mStaticMinDepthLevelDirty
-                               : 0;
+            const size_t start =
+                nodeMemoryManager->getMemoryManagerType() == SCENE_STATIC ? staticStartDepth : 0;
 
-            // Start from the zeroth level (root) unless static (start from first dirty)
-            for( size_t i = start; i < numDepths; ++i )
+            for( size_t i = start; i < numDepthsInManager; ++i )
             {
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
-
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
-                if( numNodes )
-                {
-                    // Send them to worker threads. We need to go depth by depth because
-                    // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
-                    fireWorkerThreadsAndWait();
-                    // Node::updateAllTransforms( numNodes, t );
-                }
+                mTransformUpdateScheduler.addLevel( t, numNodes, getObjectsPerChunk( numNodes ),
+                                                    i == 0 ? rootUpdateFunction : updateFunction );
+                stats.numNodes += numNodes;
             }
 
             ++it;
         }
 
+        stats.numNodesUpdated = mTransformUpdateScheduler.execute( mTaskScheduler );
+        stats.numTasks = mTransformUpdateScheduler.getNumTasks();
+
+        return stats;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::updateAllTransforms()
+    {
+        UpdateTransformTask::UpdateFunction updateFunction =
+            mTransformDirtyTracking ? &Node::updateDirtyTransforms : &Node::updateAllTransforms;
+
+        // Start from the zeroth level (root) unless static (start from first dirty)
+        mTransformUpdateStats = updateTransformsInTasks(
+            mNodeMemoryManagerUpdateList, updateFunction, updateFunction, mStaticMinDepthLevelDirty );
+
+        // Static nodes are updated after dynamic ones, thus their dynamic children will see
+        // the flags of the static nodes that changed in the next frame. Clear them afterwards,
+        // unless they got updated again (clearing would lose the new changes).
+        const bool staticNodesUpdated =
+            mStaticMinDepthLevelDirty < mNodeMemoryManager[SCENE_STATIC].getNumDepths();
+        if( !staticNodesUpdated &&
+            mStaticDirtyFlagsMinDepth != std::numeric_limits<uint16>::max() )
+        {
+            mNodeMemoryManager[SCENE_STATIC]._clearDirtyFlags( mStaticDirtyFlagsMinDepth );
+            mStaticDirtyFlagsMinDepth = std::numeric_limits<uint16>::max();
+        }
+        if( staticNodesUpdated )
+        {
+            mStaticDirtyFlagsMinDepth =
+                std::min( mStaticDirtyFlagsMinDepth, mStaticMinDepthLevelDirty );
+        }
+
         // Call all listeners
         SceneNodeList::const_iterator itor = mSceneNodesWithListeners.begin();
         SceneNodeList::const_iterator endt = mSceneNodesWithListeners.end();
@@ -1713,119 +2217,173 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTagPoints()
     {
-        NodeMemoryManagerVec::const_iterator it = mTagPointNodeMemoryManagerUpdateList.begin();
-        NodeMemoryManagerVec::const_iterator en = mTagPointNodeMemoryManagerUpdateList.end();
+        updateTransformsInTasks( mTagPointNodeMemoryManagerUpdateList,
+                                 &TagPoint::updateAllTransformsBoneToTag,
+                                 &TagPoint::updateAllTransformsTagOnTag, 0u );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::prepareObjectChunks( const ObjectMemoryManagerVec &objectMemManager,
+                                            size_t firstRq, size_t lastRq )
+    {
+        mObjectChunks.clear();
+
+        size_t totalObjsInAllRqs = 0;
+
+        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
 
         while( it != en )
         {
-            NodeMemoryManager *nodeMemoryManager = *it;
-            const size_t numDepths = nodeMemoryManager->getNumDepths();
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+            const size_t realLastRq = std::min( lastRq, numRenderQueues );
 
-            // Start from the first level (not root) unless static (start from first dirty)
-            for( size_t i = 0; i < numDepths; ++i )
+            for( size_t i = std::min( firstRq, numRenderQueues ); i < realLastRq; ++i )
             {
-                mRequestType =
-                    i == 0 ? UPDATE_ALL_BONE_TO_TAG_TRANSFORMS : UPDATE_ALL_TAG_ON_TAG_TRANSFORMS;
-
-                Transform t;
-                const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
-
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
-                if( numNodes )
-                {
-                    // Send them to worker threads. We need to go depth by depth because
-                    // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
-                    fireWorkerThreadsAndWait();
-                }
+                ObjectData objData;
+                totalObjsInAllRqs += memoryManager->getFirstObjectData( objData, i );
             }
 
             ++it;
         }
-    }
-    //-----------------------------------------------------------------------
-    void SceneManager::updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
-                                                           size_t threadIdx )
-    {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
 
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        TagPoint::updateAllTransformsBoneToTag( numNodes, t );
-    }
-    //-----------------------------------------------------------------------
-    void SceneManager::updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
-                                                          size_t threadIdx )
-    {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        TagPoint::updateAllTransformsTagOnTag( numNodes, t );
-    }
-    //-----------------------------------------------------------------------
-    void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
-                                              size_t threadIdx )
-    {
-        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
-        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
+        const size_t objsPerChunk = getObjectsPerChunk( totalObjsInAllRqs );
+        // Chunks must not split clusters. See ObjectMemoryManager::_updateClusters
+        const size_t clusteredObjsPerChunk =
+            ( ( objsPerChunk + ObjectMemoryManager::c_objsPerCluster - 1u ) /
+              ObjectMemoryManager::c_objsPerCluster ) *
+            ObjectMemoryManager::c_objsPerCluster;
 
+        it = objectMemManager.begin();
         while( it != en )
         {
             ObjectMemoryManager *memoryManager = *it;
             const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+            const size_t realLastRq = std::min( lastRq, numRenderQueues );
+            const size_t memoryManagerObjsPerChunk =
+                memoryManager->getClusterCulling() ? clusteredObjsPerChunk : objsPerChunk;
 
-            for( size_t i = 0; i < numRenderQueues; ++i )
+            for( size_t i = std::min( firstRq, numRenderQueues ); i < realLastRq; ++i )
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+                for( size_t firstObj = 0; firstObj < totalObjs;
+                     firstObj += memoryManagerObjsPerChunk )
+                {
+                    ObjectChunk chunk;
+                    chunk.objData = objData;
+                    chunk.objData.advancePack( firstObj / ARRAY_PACKED_REALS );
+                    chunk.numObjs = std::min( memoryManagerObjsPerChunk, totalObjs - firstObj );
+                    chunk.renderQueueId = static_cast<uint8>( i );
+                    chunk.memoryManager = memoryManager;
+                    chunk.firstObj = firstObj;
+                    mObjectChunks.push_back( chunk );
+                }
+            }
 
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
+            ++it;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::executeChunkedRequest( size_t chunkIdx, size_t threadIdx )
+    {
+        // These split mBatchedCullChunks, not mObjectChunks
+        if( mRequestType == CULL_FRUSTUM_BATCH )
+        {
+            OgreProfileWorker( "Worker: Batched Cull" );
+            cullFrustumBatchChunk( chunkIdx );
+            return;
+        }
+        if( mRequestType == ADD_BATCHED_CULL_RESULTS )
+        {
+            OgreProfileWorker( "Worker: Batched Cull Results" );
+            addBatchedCullResultsChunk( chunkIdx, threadIdx );
+            return;
+        }
+        // Each chunk is a band of rows of the occlusion buffer
+        if( mRequestType == RASTERIZE_OCCLUDERS )
+        {
+            OgreProfileWorker( "Worker: Rasterize Occluders" );
+            mOcclusionBuffer->rasterize( static_cast<uint32>( chunkIdx ) * mOcclusionRowsPerBand,
+                                         mOcclusionRowsPerBand );
+            return;
+        }
 
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+        const ObjectChunk &chunk = mObjectChunks[chunkIdx];
 
-                MovableObject::updateAllBounds( numObjs, objData );
+        switch( mRequestType )
+        {
+        case CULL_FRUSTUM:
+        {
+            OgreProfileWorker( "Worker: Cull" );
+            const ObjectMemoryManager::Cluster *clusters =
+                chunk.memoryManager->_getClusters( chunk.renderQueueId );
+            if( clusters )
+                clusters += chunk.firstObj / ObjectMemoryManager::c_objsPerCluster;
+            cullFrustumRange( mCurrentCullFrustumRequest, chunk.objData, chunk.numObjs,
+                              chunk.renderQueueId, threadIdx, clusters );
+            break;
+        }
+        case UPDATE_ALL_BOUNDS:
+        {
+            OgreProfileWorker( "Worker: Bounds" );
+            MovableObject::updateAllBounds( chunk.numObjs, chunk.objData );
+            if( chunk.memoryManager->getClusterCulling() )
+            {
+                chunk.memoryManager->_updateClusters( chunk.renderQueueId, chunk.firstObj,
+                                                      chunk.numObjs, chunk.objData );
             }
-
-            ++it;
+            break;
+        }
+        case UPDATE_ALL_LODS:
+        {
+            OgreProfileWorker( "Worker: LOD" );
+            LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
+            lodStrategy->lodUpdateImpl( chunk.numObjs, chunk.objData, mUpdateLodRequest.lodCamera,
+                                        mUpdateLodRequest.lodBias );
+            break;
+        }
+        default:
+            OGRE_ASSERT_LOW( false && "Request can't be split in object chunks" );
+            break;
         }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
     {
-        mUpdateBoundsRequest = &objectMemManager;
+        ObjectMemoryManagerVec::const_iterator itor = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator endt = objectMemManager.end();
+        while( itor != endt )
+        {
+            if( ( *itor )->getClusterCulling() )
+                ( *itor )->_prepareClusters();
+            ++itor;
+        }
+
         mRequestType = UPDATE_ALL_BOUNDS;
-        fireWorkerThreadsAndWait();
+        prepareObjectChunks( objectMemManager, 0u, std::numeric_limits<size_t>::max() );
+        fireChunkedRequestAndWait();
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx )
+    void SceneManager::updateAllLods( const Camera *lodCamera, Real lodBias, uint8 firstRq,
+                                      uint8 lastRq )
     {
-        LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
+        mRequestType = UPDATE_ALL_LODS;
+        mUpdateLodRequest = UpdateLodRequest( firstRq, lastRq, &mEntitiesMemoryManagerCulledList,
+                                              lodCamera, lodCamera, lodBias );
+
+        mUpdateLodRequest.camera->getFrustumPlanes();
+        mUpdateLodRequest.lodCamera->getFrustumPlanes();
+
+        prepareObjectChunks( mEntitiesMemoryManagerCulledList, firstRq, lastRq );
+        fireChunkedRequestAndWait();
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::cullFrustum( const CullFrustumRequest &request, size_t threadIdx )
+    {
+        resetVisibleObjects( *( mVisibleObjects.begin() + threadIdx ) );
 
-        const Camera *lodCamera = request.lodCamera;
         ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
         ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
@@ -1855,41 +2413,48 @@ namespace Ogre
                 numObjs = std::min( numObjs, totalObjs - toAdvance );
                 objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
 
-                lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
+                cullFrustumRange( request, objData, numObjs, static_cast<uint8>( i ), threadIdx, 0 );
             }
 
             ++it;
         }
     }
     //-----------------------------------------------------------------------
-    void SceneManager::updateAllLods( const Camera *lodCamera, Real lodBias, uint8 firstRq,
-                                      uint8 lastRq )
+    /// Returns false if all the objects in the cluster are outside the frustum
+    static bool isClusterInFrustum( const ObjectMemoryManager::Cluster &cluster,
+                                    const Plane *frustumPlanes )
     {
-        mRequestType = UPDATE_ALL_LODS;
-        mUpdateLodRequest = UpdateLodRequest( firstRq, lastRq, &mEntitiesMemoryManagerCulledList,
-                                              lodCamera, lodCamera, lodBias );
-
-        mUpdateLodRequest.camera->getFrustumPlanes();
-        mUpdateLodRequest.lodCamera->getFrustumPlanes();
+        // All the slots in the cluster are unused
+        if( cluster.vMin.x > cluster.vMax.x )
+            return false;
 
-        fireWorkerThreadsAndWait();
-    }
-    //-----------------------------------------------------------------------
-    void SceneManager::cullFrustum( const CullFrustumRequest &request, size_t threadIdx )
-    {
-        VisibleObjectsPerRq &visibleObjectsPerRq = *( mVisibleObjects.begin() + threadIdx );
+        // Infinite bounds would turn the dot products below into nans
+        const Real infinity = std::numeric_limits<Real>::infinity();
+        if( cluster.vMax.x == infinity || cluster.vMax.y == infinity || cluster.vMax.z == infinity ||
+            cluster.vMin.x == -infinity || cluster.vMin.y == -infinity || cluster.vMin.z == -infinity )
         {
-            visibleObjectsPerRq.resize( 255 );
-            VisibleObjectsPerRq::iterator itor = visibleObjectsPerRq.begin();
-            VisibleObjectsPerRq::iterator endt = visibleObjectsPerRq.end();
+            return true;
+        }
 
-            while( itor != endt )
-            {
-                itor->clear();
-                ++itor;
-            }
+        // Same test as MovableObject::cullFrustum, using the corner
+        // that is furthest along the plane's normal
+        for( size_t i = 0; i < 6u; ++i )
+        {
+            const Vector3 &normal = frustumPlanes[i].normal;
+            const Vector3 corner( normal.x >= 0 ? cluster.vMax.x : cluster.vMin.x,
+                                  normal.y >= 0 ? cluster.vMax.y : cluster.vMin.y,
+                                  normal.z >= 0 ? cluster.vMax.z : cluster.vMin.z );
+            if( normal.dotProduct( corner ) <= -frustumPlanes[i].d )
+                return false;
         }
 
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::cullFrustumRange( const CullFrustumRequest &request, ObjectData objData,
+                                         size_t numObjs, uint8 renderQueueId, size_t threadIdx,
+                                         const ObjectMemoryManager::Cluster *clusters )
+    {
         const Camera *camera = request.camera;
         const Camera *lodCamera = request.lodCamera;
 
@@ -1900,74 +2465,139 @@ namespace Ogre
                     ( camera->getLastViewport()->getVisibilityMask() &
                       ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
 
-        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
-        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
+        MovableObject::MovableObjectArray &outVisibleObjects =
+            *( ( mVisibleObjects.begin() + threadIdx )->begin() + renderQueueId );
+        const size_t prevNumVisibleObjects = outVisibleObjects.size();
 
-        while( it != en )
+        if( !clusters )
         {
-            ObjectMemoryManager *memoryManager = *it;
-            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
-
-            size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
-            size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
+            MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask, outVisibleObjects,
+                                        lodCamera );
+        }
+        else
+        {
+            // Cull each run of consecutive clusters that intersect the frustum in one go
+            const Plane *frustumPlanes = camera->_getCachedFrustumPlanes();
+            const size_t objsPerCluster = ObjectMemoryManager::c_objsPerCluster;
 
-            for( size_t i = firstRq; i < lastRq; ++i )
+            size_t runStart = 0u;
+            for( size_t i = 0u; i < numObjs; i += objsPerCluster )
             {
-                MovableObject::MovableObjectArray &outVisibleObjects =
-                    *( visibleObjectsPerRq.begin() + i );
-
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
+                if( !isClusterInFrustum( *clusters++, frustumPlanes ) )
+                {
+                    if( runStart != i )
+                    {
+                        ObjectData runData = objData;
+                        runData.advancePack( runStart / ARRAY_PACKED_REALS );
+                        MovableObject::cullFrustum( i - runStart, runData, camera, visibilityMask,
+                                                    outVisibleObjects, lodCamera );
+                    }
+                    runStart = i + objsPerCluster;
+                }
+            }
 
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+            if( runStart < numObjs )
+            {
+                objData.advancePack( runStart / ARRAY_PACKED_REALS );
+                MovableObject::cullFrustum( numObjs - runStart, objData, camera, visibilityMask,
+                                            outVisibleObjects, lodCamera );
+            }
+        }
 
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
+        if( request.occlusionCulling )
+            applyOcclusionCulling( outVisibleObjects, prevNumVisibleObjects, threadIdx );
 
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+        if( request.textureScreenCoverage )
+        {
+            accumulateTextureScreenCoverage( camera, outVisibleObjects, prevNumVisibleObjects,
+                                             threadIdx );
+        }
 
-                MovableObject::cullFrustum( numObjs, objData, camera, visibilityMask, outVisibleObjects,
-                                            lodCamera );
+        addVisibleObjectsToRenderQueue( request, outVisibleObjects, renderQueueId, threadIdx );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addVisibleObjectsToRenderQueue(
+        const CullFrustumRequest &request, MovableObject::MovableObjectArray &inOutVisibleObjects,
+        uint8 renderQueueId, size_t threadIdx )
+    {
+        if( mRenderQueue->getRenderQueueMode( renderQueueId ) == RenderQueue::FAST &&
+            request.addToRenderQueue )
+        {
+            // V2 meshes can be added to the render queue in parallel
+            bool casterPass = request.casterPass;
+            MovableObject::MovableObjectArray::const_iterator itor = inOutVisibleObjects.begin();
+            MovableObject::MovableObjectArray::const_iterator endt = inOutVisibleObjects.end();
 
-                const uint8 currRqId = static_cast<uint8>( i );
+            while( itor != endt )
+            {
+                RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
+                RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
 
-                if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
-                    request.addToRenderQueue )
+                while( itRend != enRend )
                 {
-                    // V2 meshes can be added to the render queue in parallel
-                    bool casterPass = request.casterPass;
-                    MovableObject::MovableObjectArray::const_iterator itor = outVisibleObjects.begin();
-                    MovableObject::MovableObjectArray::const_iterator endt = outVisibleObjects.end();
-
-                    while( itor != endt )
+                    if( ( *itRend )->mRenderableVisible )
                     {
-                        RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
-                        RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
-
-                        while( itRend != enRend )
-                        {
-                            if( ( *itRend )->mRenderableVisible )
-                            {
-                                mRenderQueue->addRenderableV2( threadIdx, currRqId, casterPass, *itRend,
-                                                               *itor );
-                            }
-                            ++itRend;
-                        }
-                        ++itor;
+                        mRenderQueue->addRenderableV2( threadIdx, renderQueueId, casterPass, *itRend,
+                                                       *itor );
                     }
-
-                    outVisibleObjects.clear();
+                    ++itRend;
                 }
+                ++itor;
             }
 
-            ++it;
+            inOutVisibleObjects.clear();
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::cullFrustumBatchChunk( size_t chunkIdx )
+    {
+        const ObjectChunk &chunk = mBatchedCullChunks[chunkIdx];
+        const size_t numCameras = mBatchedCullCameras.size();
+
+        MovableObject::cullFrustumBatch(
+            chunk.numObjs, chunk.objData, mBatchedCullFrustums.begin(),
+            mBatchedCullVisibilityMasks.begin(), mBatchedCullLodCameras.begin(), numCameras,
+            &mBatchedCullObjects[chunkIdx * numCameras], &mBatchedCullDistances[chunkIdx * numCameras] );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addBatchedCullResultsChunk( size_t chunkIdx, size_t threadIdx )
+    {
+        const ObjectChunk &chunk = mBatchedCullChunks[chunkIdx];
+
+        if( chunk.renderQueueId < mCurrentCullFrustumRequest.firstRq ||
+            chunk.renderQueueId >= mCurrentCullFrustumRequest.lastRq )
+        {
+            return;
+        }
+
+        const size_t resultIdx = chunkIdx * mBatchedCullCameras.size() + mBatchedCullCameraIdx;
+        const MovableObject::MovableObjectArray &culledObjects = mBatchedCullObjects[resultIdx];
+        const FastArray<RealAsUint> &distances = mBatchedCullDistances[resultIdx];
+
+        MovableObject::MovableObjectArray &outVisibleObjects =
+            *( ( mVisibleObjects.begin() + threadIdx )->begin() + chunk.renderQueueId );
+
+        const size_t prevNumVisibleObjects = outVisibleObjects.size();
+
+        // Other cameras overwrote the distance to camera after we were culled
+        const size_t numObjs = culledObjects.size();
+        for( size_t i = 0; i < numObjs; ++i )
+        {
+            culledObjects[i]->_setCachedDistanceToCamera( distances[i] );
+            outVisibleObjects.push_back( culledObjects[i] );
         }
+
+        if( mCurrentCullFrustumRequest.occlusionCulling )
+            applyOcclusionCulling( outVisibleObjects, prevNumVisibleObjects, threadIdx );
+
+        if( mCurrentCullFrustumRequest.textureScreenCoverage )
+        {
+            accumulateTextureScreenCoverage( mCurrentCullFrustumRequest.camera, outVisibleObjects,
+                                             prevNumVisibleObjects, threadIdx );
+        }
+
+        addVisibleObjectsToRenderQueue( mCurrentCullFrustumRequest, outVisibleObjects,
+                                        chunk.renderQueueId, threadIdx );
     }
     //-----------------------------------------------------------------------
     inline bool OrderLightByShadowCastThenId( const Light *_l, const Light *_r )
@@ -2148,13 +2778,7 @@ namespace Ogre
             }
         }
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        fireWorkerThreadsAndWait();
 
         // Now merge the results into a single list.
 
@@ -2186,13 +2810,7 @@ namespace Ogre
         {
             // Now fire the threads again, to build the per-MovableObject lists
             mRequestType = BUILD_LIGHT_LIST02;
-            if( mForceMainThread )
-                updateWorkerThreadImpl( 0 );
-            else
-            {
-                mWorkerThreadsBarrier->sync();  // Fire threads
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
-            }
+            fireWorkerThreadsAndWait();
         }
     }
     //-----------------------------------------------------------------------
@@ -2338,6 +2956,15 @@ namespace Ogre
 
         OgreProfileGroup( "updateSceneGraph", OGREPROF_GENERAL );
 
+        // Objects are about to move, batched results can no longer be trusted
+        _clearBatchedCull();
+
+        if( mIncrementalDefragSlotsPerFrame )
+        {
+            OgreProfile( "Incremental defragmentation" );
+            defragmentMemoryPoolsIncremental( mIncrementalDefragSlotsPerFrame, true );
+        }
+
         // Update controllers
         ControllerManager::getSingleton().updateAllControllers();
 
@@ -4458,13 +5085,22 @@ namespace Ogre
     }
     void SceneManager::fireWorkerThreadsAndWait()
     {
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
-        {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        mTaskScheduler->wait( mTaskScheduler->submit( &mUniformRequestTask ) );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::fireChunkedRequestAndWait()
+    {
+        mTaskScheduler->wait( mTaskScheduler->submit( &mChunkedRequestTask, mObjectChunks.size() ) );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::UniformRequestTask::execute( size_t threadId, size_t numThreads )
+    {
+        mSceneManager->updateWorkerThreadImpl( threadId );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::ChunkedRequestTask::execute( size_t chunkIdx, size_t threadIdx )
+    {
+        mSceneManager->executeChunkedRequest( chunkIdx, threadIdx );
     }
     //---------------------------------------------------------------------
     //---------------------------------------------------------------------
@@ -4480,123 +5116,79 @@ namespace Ogre
         fireWorkerThreadsAndWait();
     }
     //---------------------------------------------------------------------
-    void SceneManager::executeUserScalableTask( UniformScalableTask *task, bool bBlock )
+    void SceneManager::fireCullFrustumTasks( const CullFrustumRequest &request )
     {
-        mRequestType = USER_UNIFORM_SCALABLE_TASK;
-        mUserTask = task;
+        mCurrentCullFrustumRequest = request;
+        mRequestType = CULL_FRUSTUM;
+        // See fireCullFrustumThreads
+        mCurrentCullFrustumRequest.camera->getFrustumPlanes();
+        mCurrentCullFrustumRequest.lodCamera->getFrustumPlanes();
 
-        if( mForceMainThread )
-            updateWorkerThreadImpl( 0 );
-        else
+        // A thread may run several chunks, so its lists can't be cleared by each chunk
+        VisibleObjectsPerThreadArray::iterator itor = mVisibleObjects.begin();
+        VisibleObjectsPerThreadArray::iterator endt = mVisibleObjects.end();
+        while( itor != endt )
         {
-            mWorkerThreadsBarrier->sync();  // Fire threads
-            if( bBlock )
-                mWorkerThreadsBarrier->sync();  // Wait them to complete
+            resetVisibleObjects( *itor );
+            ++itor;
         }
+
+        prepareObjectChunks( *request.objectMemManager, request.firstRq, request.lastRq );
+        fireChunkedRequestAndWait();
     }
     //---------------------------------------------------------------------
-    void SceneManager::waitForPendingUserScalableTask()
+    void SceneManager::executeUserScalableTask( UniformScalableTask *task, bool bBlock )
     {
-        if( !mForceMainThread )
-        {
-            assert( mRequestType == USER_UNIFORM_SCALABLE_TASK );
-            mWorkerThreadsBarrier->sync();  // Wait them to complete
-        }
+        mUserTaskId = mTaskScheduler->submit( task );
+        if( bBlock )
+            mTaskScheduler->wait( mUserTaskId );
     }
     //---------------------------------------------------------------------
-    unsigned long updateWorkerThread( ThreadHandle *threadHandle )
-    {
-        SceneManager *sceneManager = reinterpret_cast<SceneManager *>( threadHandle->getUserParam() );
-        return sceneManager->_updateWorkerThread( threadHandle );
-    }
-    THREAD_DECLARE( updateWorkerThread );
+    void SceneManager::waitForPendingUserScalableTask() { mTaskScheduler->wait( mUserTaskId ); }
     //---------------------------------------------------------------------
     void SceneManager::startWorkerThreads()
     {
-        if( !mForceMainThread )
-        {
-            mWorkerThreadsBarrier = new Barrier( mNumWorkerThreads + 1 );
-            mWorkerThreads.reserve( mNumWorkerThreads );
-            for( size_t i = 0; i < mNumWorkerThreads; ++i )
-            {
-                ThreadHandlePtr th = Threads::CreateThread( THREAD_GET( updateWorkerThread ), i, this );
-                mWorkerThreads.push_back( th );
-            }
-        }
+        mTaskScheduler = OGRE_NEW TaskScheduler( mForceMainThread ? 0u : mNumWorkerThreads );
     }
     //---------------------------------------------------------------------
     void SceneManager::stopWorkerThreads()
     {
-        if( !mForceMainThread )
-        {
-            mRequestType = STOP_THREADS;
-            fireWorkerThreadsAndWait();
-
-            Threads::WaitForThreads( mWorkerThreads );
-
-            delete mWorkerThreadsBarrier;
-            mWorkerThreadsBarrier = 0;
-        }
+        OGRE_DELETE mTaskScheduler;
+        mTaskScheduler = 0;
     }
     //---------------------------------------------------------------------
-    unsigned long SceneManager::_updateWorkerThread( ThreadHandle *threadHandle )
+    inline void SceneManager::updateWorkerThreadImpl( size_t threadIdx )
     {
-        bool exitThread = false;
-        size_t threadIdx = threadHandle->getThreadIdx();
-        while( !exitThread )
-        {
-            mWorkerThreadsBarrier->sync();
-            exitThread = updateWorkerThreadImpl( threadIdx );
-            mWorkerThreadsBarrier->sync();
-        }
-
-        return 0;
-    }
-    //---------------------------------------------------------------------
-    inline bool SceneManager::updateWorkerThreadImpl( size_t threadIdx )
-    {
-        bool exitThread = false;
-
         switch( mRequestType )
         {
         case CULL_FRUSTUM:
+        {
+            OgreProfileWorker( "Worker: Cull" );
             cullFrustum( mCurrentCullFrustumRequest, threadIdx );
             break;
+        }
         case UPDATE_ALL_ANIMATIONS:
+        {
+            OgreProfileWorker( "Worker: Animations" );
             updateAllAnimationsThread( threadIdx );
             break;
-        case UPDATE_ALL_TRANSFORMS:
-            updateAllTransformsThread( mUpdateTransformRequest, threadIdx );
-            break;
-        case UPDATE_ALL_BONE_TO_TAG_TRANSFORMS:
-            updateAllTransformsBoneToTagThread( mUpdateTransformRequest, threadIdx );
-            break;
-        case UPDATE_ALL_TAG_ON_TAG_TRANSFORMS:
-            updateAllTransformsTagOnTagThread( mUpdateTransformRequest, threadIdx );
-            break;
-        case UPDATE_ALL_BOUNDS:
-            updateAllBoundsThread( *mUpdateBoundsRequest, threadIdx );
-            break;
-        case UPDATE_ALL_LODS:
-            updateAllLodsThread( mUpdateLodRequest, threadIdx );
-            break;
+        }
         case BUILD_LIGHT_LIST01:
+        {
+            OgreProfileWorker( "Worker: Light List" );
             buildLightListThread01( mBuildLightListRequestPerThread[threadIdx], threadIdx );
             break;
+        }
         case BUILD_LIGHT_LIST02:
+        {
+            OgreProfileWorker( "Worker: Light List" );
             buildLightListThread02( threadIdx );
             break;
-        case USER_UNIFORM_SCALABLE_TASK:
-            mUserTask->execute( threadIdx, mNumWorkerThreads );
-            break;
-        case STOP_THREADS:
-            exitThread = true;
-            break;
+        }
         default:
+            OGRE_ASSERT_LOW( false && "Request must be split in object chunks" );
             break;
         }
-
-        return exitThread;
     }
     SceneManagerFactory::~SceneManagerFactory() {}
 }  // namespace Ogre
@@ -1296,6 +1296,7 @@ namespace Ogre
         mIds["lod_camera"] = ID_LOD_CAMERA;
         mIds["cull_reuse_data"] = ID_CULL_REUSE_DATA;
         mIds["cull_camera"] = ID_CULL_CAMERA;
+        mIds["occlusion_culling"] = ID_OCCLUSION_CULLING;
         mIds["material_scheme"] = ID_MATERIAL_SCHEME;
         mIds["visibility_mask"] = ID_VISIBILITY_MASK;
         mIds["light_visibility_mask"] = ID_LIGHT_VISIBILITY_MASK;
@@ -9480,6 +9480,21 @@ namespace Ogre{
                         }
                     }
                     break;
+                case ID_OCCLUSION_CULLING:
+                    {
+                        if( prop->values.empty() )
+                        {
+                            compiler->addError( ScriptCompiler::CE_STRINGEXPECTED, prop->file, prop->line );
+                            return;
+                        }
+
+                        AbstractNodeList::const_iterator it0 = prop->values.begin();
+                        if( !getBoolean( *it0, &passScene->mOcclusionCulling ) )
+                        {
+                             compiler->addError( ScriptCompiler::CE_NUMBEREXPECTED, prop->file, prop->line );
+                        }
+                    }
+                    break;
                 case ID_VISIBILITY_MASK:
                     {
                         if(prop->values.empty())
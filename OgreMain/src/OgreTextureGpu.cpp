@@ -60,10 +60,12 @@ namespace Ogre
         mInternalSliceStart( 0 ),
         mSourceType( TextureSourceType::Standard ),
         mDataPreparationsPending( 0u ),
+        mMostDetailedMipToLoad( 0u ),
         mTextureType( initialType ),
         mPixelFormat( PFG_UNKNOWN ),
         mTextureFlags( textureFlags ),
         mPoolId( 0 ),
+        mLoadPriority( 0.0f ),
         mSysRamCopy( 0 ),
         mTextureManager( textureManager ),
         mTexturePool( 0 )
@@ -168,6 +170,31 @@ namespace Ogre
             unsafeScheduleTransitionTo( nextResidency, image, autoDeleteImage );
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpu::setLoadPriority( float priority )
+    {
+        if( mLoadPriority != priority )
+        {
+            mLoadPriority = priority;
+            // Only bother the streaming threads if we're being loaded
+            if( !isManualTexture() && !isDataReady() )
+                mTextureManager->_notifyLoadPriorityChanged( this );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpu::setMostDetailedMipToLoad( uint8 mipLevel )
+    {
+        if( mMostDetailedMipToLoad != mipLevel )
+        {
+            mMostDetailedMipToLoad = mipLevel;
+            // Reload from file using the new resolution
+            if( !isManualTexture() && mNextResidencyStatus == GpuResidency::Resident )
+            {
+                scheduleTransitionTo( GpuResidency::OnStorage );
+                scheduleTransitionTo( GpuResidency::Resident );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpu::scheduleReupload( Image2 *image, bool autoDeleteImage )
     {
         OGRE_ASSERT_LOW( mNextResidencyStatus != GpuResidency::OnStorage );
@@ -856,6 +883,8 @@ namespace Ogre
                          "Cannot explicitly transition CopyEncoderManaged layouts" );
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpu::_notifyMostDetailedMipReady( uint8 mipLevel ) {}
+    //-----------------------------------------------------------------------------------
     void TextureGpu::_notifyTextureSlotChanged( const TexturePool *newPool, uint16 slice )
     {
         mTexturePool = newPool;
@@ -34,6 +34,7 @@ THE SOFTWARE.
 #include "OgreBitset.inl"
 #include "OgreBitwise.h"
 #include "OgreCommon.h"
+#include "OgreDataStream.h"
 #include "OgreException.h"
 #include "OgreHlmsDatablock.h"
 #include "OgreId.h"
@@ -50,6 +51,7 @@ THE SOFTWARE.
 #include "OgreTextureFilters.h"
 #include "OgreTextureGpu.h"
 #include "OgreTextureGpuManagerListener.h"
+#include "OgreTimer.h"
 #include "Threading/OgreThreads.h"
 #include "Vao/OgreVaoManager.h"
 
@@ -88,11 +90,16 @@ namespace Ogre
         mDefaultMipmapGen( DefaultMipmapGen::HwMode ),
         mDefaultMipmapGenCubemaps( DefaultMipmapGen::SwMode ),
         mShuttingDown( false ),
-        mTryLockMutexFailureCount( 0u ),
         mTryLockMutexFailureLimit( 1200u ),
         mLoadRequestsCounter( 0u ),
         mLastUpdateIsStreamingDone( true ),
         mAddedNewLoadRequests( false ),
+        mAutomaticLoadPriorities( false ),
+        mScreenCoverageDirty( false ),
+        mProgressiveStreaming( false ),
+        mSupportsProgressiveStreaming( false ),
+        mStallTimer( OGRE_NEW Timer() ),
+        mStreamingStallTimeUs( 0u ),
         mEntriesToProcessPerIteration( 3u ),
         mMaxPreloadBytes( 256u * 1024u * 1024u ),  // A value of 512MB begins to shake driver bugs.
         mTextureGpuManagerListener( &sDefaultTextureGpuManagerListener ),
@@ -159,13 +166,12 @@ namespace Ogre
         mStreamingData.workerThreadRan = true;
         mStreamingData.bytesPreloaded = 0;
         mStreamingData.maxPerStagingTextureRequestBytes = 64u * 1024u * 1024u;
+        mStreamingData.progressiveBytesUploaded = 0;
+        mStreamingData.maxProgressiveBytesPerFrame = 4u * 1024u * 1024u;
+        mStreamingData.progressiveMipTailResolution = 128u;
 
-        for( int i = 0; i < 2; ++i )
-            mThreadData[i].objCmdBuffer = new ObjCmdBuffer();
-
-#if OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN && !OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
-        mWorkerThread = Threads::CreateThread( THREAD_GET( updateStreamingWorkerThread ), 0, this );
-#endif
+        mStreamingThreads.push_back( new StreamingThread() );
+        createWorkerThreads();
     }
     //-----------------------------------------------------------------------------------
     TextureGpuManager::~TextureGpuManager()
@@ -177,72 +183,159 @@ namespace Ogre
         assert( mEntries.empty() && "Derived class didn't call destroyAll!" );
         assert( mTexturePool.empty() && "Derived class didn't call destroyAll!" );
 
-        for( int i = 0; i < 2; ++i )
+        StreamingThreadVec::const_iterator itor = mStreamingThreads.begin();
+        StreamingThreadVec::const_iterator endt = mStreamingThreads.end();
+
+        while( itor != endt )
         {
-            delete mThreadData[i].objCmdBuffer;
-            mThreadData[i].objCmdBuffer = 0;
+            delete *itor;
+            ++itor;
         }
 
+        mStreamingThreads.clear();
+
+        OGRE_DELETE mStallTimer;
+        mStallTimer = 0;
+
         mTextureGpuManagerListener = 0;
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::shutdown()
     {
         if( !mShuttingDown )
+            destroyWorkerThreads();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setNumStreamingThreads( size_t numThreads )
+    {
+        OGRE_ASSERT_LOW( numThreads > 0u );
+#if OGRE_PLATFORM == OGRE_PLATFORM_EMSCRIPTEN || OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
+        numThreads = 1u;
+#endif
+        numThreads = std::max<size_t>( numThreads, 1u );
+
+        if( numThreads == mStreamingThreads.size() || mShuttingDown )
+            return;
+
+        waitForStreamingCompletion();
+        destroyWorkerThreads();
+
+        while( mStreamingThreads.size() > numThreads )
         {
-            mShuttingDown = true;
+            delete mStreamingThreads.back();
+            mStreamingThreads.pop_back();
+        }
+        while( mStreamingThreads.size() < numThreads )
+            mStreamingThreads.push_back( new StreamingThread() );
+
+        createWorkerThreads();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::createWorkerThreads()
+    {
+        mShuttingDown = false;
 #if OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN && !OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
-            mWorkerWaitableEvent.wake();
-            Threads::WaitForThreads( 1u, &mWorkerThread );
+        OGRE_ASSERT_LOW( mWorkerThreads.empty() );
+        const size_t numThreads = mStreamingThreads.size();
+        for( size_t i = 0u; i < numThreads; ++i )
+        {
+            mWorkerThreads.push_back(
+                Threads::CreateThread( THREAD_GET( updateStreamingWorkerThread ), i, this ) );
+        }
 #endif
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::destroyWorkerThreads()
+    {
+        mShuttingDown = true;
+#if OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN && !OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
+        StreamingThreadVec::const_iterator itor = mStreamingThreads.begin();
+        StreamingThreadVec::const_iterator endt = mStreamingThreads.end();
+
+        while( itor != endt )
+        {
+            ( *itor )->wakeUpEvent.wake();
+            ++itor;
         }
+
+        Threads::WaitForThreads( mWorkerThreads );
+        mWorkerThreads.clear();
+#endif
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::destroyAll()
     {
+        // Worker threads grab their own mutex before mMutex. We must follow the same order.
+        StreamingThreadVec::const_iterator itor = mStreamingThreads.begin();
+        StreamingThreadVec::const_iterator endt = mStreamingThreads.end();
+
+        while( itor != endt )
+        {
+            ( *itor )->mutex.lock();
+            ++itor;
+        }
+
         mMutex.lock();
         abortAllRequests();
+        mScreenCoverage.clear();
         destroyAllStagingBuffers();
         destroyAllAsyncTextureTicket();
         destroyAllTextures();
         destroyAllPools();
         mMutex.unlock();
+
+        itor = mStreamingThreads.begin();
+        while( itor != endt )
+        {
+            ( *itor )->mutex.unlock();
+            ++itor;
+        }
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::abortAllRequests()
     {
-        ThreadData &workerData = mThreadData[c_workerThread];
-        ThreadData &mainData = mThreadData[c_mainThread];
-        mLoadRequestsMutex.lock();
-        mainData.loadRequests
-            .clear();  // TODO: if( loadRequest.autoDeleteImage ) delete loadRequest.image;
-        mainData.objCmdBuffer->clear();
-        mainData.usedStagingTex.clear();
-        workerData.loadRequests
-            .clear();  // TODO: if( loadRequest.autoDeleteImage ) delete loadRequest.image;
-        workerData.objCmdBuffer->clear();
-        workerData.usedStagingTex.clear();
-        mLoadRequestsMutex.unlock();
+        StreamingThreadVec::const_iterator itThread = mStreamingThreads.begin();
+        StreamingThreadVec::const_iterator enThread = mStreamingThreads.end();
 
-        while( !mStreamingData.queuedImages.empty() )
+        while( itThread != enThread )
         {
-            TextureFilter::FilterBase::destroyFilters( mStreamingData.queuedImages.back().filters );
-            mStreamingData.queuedImages.pop_back();
-        }
+            StreamingThread &streamingThread = **itThread;
 
-        {
-            // These partial images were supposed to transfer ownership of sysRamPtr to TextureGpu
-            // But we now must free these ptrs ourselves
-            PartialImageMap::const_iterator itor = mStreamingData.partialImages.begin();
-            PartialImageMap::const_iterator endt = mStreamingData.partialImages.end();
+            ThreadData &workerData = streamingThread.threadData[c_workerThread];
+            ThreadData &mainData = streamingThread.threadData[c_mainThread];
+            mLoadRequestsMutex.lock();
+            mainData.loadRequests
+                .clear();  // TODO: if( loadRequest.autoDeleteImage ) delete loadRequest.image;
+            mainData.objCmdBuffer->clear();
+            mainData.usedStagingTex.clear();
+            workerData.loadRequests
+                .clear();  // TODO: if( loadRequest.autoDeleteImage ) delete loadRequest.image;
+            workerData.objCmdBuffer->clear();
+            workerData.usedStagingTex.clear();
+            mLoadRequestsMutex.unlock();
 
-            while( itor != endt )
+            while( !streamingThread.queuedImages.empty() )
             {
-                if( itor->second.sysRamPtr )
-                    OGRE_FREE_SIMD( itor->second.sysRamPtr, MEMCATEGORY_RESOURCE );
-                ++itor;
+                TextureFilter::FilterBase::destroyFilters( streamingThread.queuedImages.back().filters );
+                streamingThread.queuedImages.pop_back();
             }
-            mStreamingData.partialImages.clear();
+
+            {
+                // These partial images were supposed to transfer ownership of sysRamPtr to
+                // TextureGpu. But we now must free these ptrs ourselves
+                PartialImageMap::const_iterator itor = streamingThread.partialImages.begin();
+                PartialImageMap::const_iterator endt = streamingThread.partialImages.end();
+
+                while( itor != endt )
+                {
+                    if( itor->second.sysRamPtr )
+                        OGRE_FREE_SIMD( itor->second.sysRamPtr, MEMCATEGORY_RESOURCE );
+                    ++itor;
+                }
+                streamingThread.partialImages.clear();
+            }
+
+            ++itThread;
         }
 
         mScheduledTasks.clear();
@@ -521,6 +614,8 @@ namespace Ogre
 
         texture->notifyAllListenersTextureChanged( TextureGpuListener::Deleted );
 
+        mScreenCoverage.erase( texture );
+
         BarrierSolver &barrierSolver = mRenderSystem->getBarrierSolver();
         barrierSolver.textureDeleted( texture );
 
@@ -578,8 +673,10 @@ namespace Ogre
                 else
                 {
                     // No pending tasks, but the texture is being loaded. Delay execution
+                    // and try to cancel the load if the worker hasn't started it yet
                     texture->_addPendingResidencyChanges( 1u );
                     mScheduledTasks[texture].push_back( task );
+                    addLoadRequestUpdate( texture, LoadRequestCancel );
                 }
             }
             else
@@ -894,6 +991,10 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     bool TextureGpuManager::applyMetadataCacheTo( TextureGpu *texture )
     {
+        // The cache holds the resolution of the file, not the one we'll load
+        if( texture->getMostDetailedMipToLoad() != 0u )
+            return false;
+
         bool retVal = false;
         MetadataCacheMap::const_iterator itor = mMetadataCache.find( texture->getName() );
         if( itor != mMetadataCache.end() )
@@ -911,6 +1012,9 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_updateMetadataCache( TextureGpu *texture )
     {
+        if( texture->getMostDetailedMipToLoad() != 0u )
+            return;
+
         ResourceEntryMap::const_iterator itor = mEntries.find( texture->getName() );
 
         if( itor != mEntries.end() )
@@ -1688,15 +1792,13 @@ namespace Ogre
                 texture->_transitionTo( GpuResidency::Resident, 0 );
         }
 
-        mAddedNewLoadRequests = true;
-        ++mLoadRequestsCounter;
-        ThreadData &mainData = mThreadData[c_mainThread];
-        mLoadRequestsMutex.lock();
-        mainData.loadRequests.push_back( LoadRequest( name, archive, loadingListener, image, texture,
-                                                      sliceOrDepth, filters, autoDeleteImage,
-                                                      toSysRam ) );
-        mLoadRequestsMutex.unlock();
-        mWorkerWaitableEvent.wake();
+        LoadRequest loadRequest( name, archive, loadingListener, image, texture, sliceOrDepth,
+                                 filters, autoDeleteImage, toSysRam );
+        loadRequest.cancellable = !toSysRam && !reuploadOnly;
+        loadRequest.mostDetailedMip = texture->getMostDetailedMipToLoad();
+        loadRequest.progressive = mProgressiveStreaming && !toSysRam && !reuploadOnly &&
+                                  !texture->hasAutomaticBatching();
+        addLoadRequest( loadRequest );
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_scheduleUpdate( TextureGpu *texture, uint32 filters, Image2 *image,
@@ -1706,14 +1808,8 @@ namespace Ogre
         Archive *archive = 0;
         ResourceLoadingListener *loadingListener = 0;
 
-        mAddedNewLoadRequests = true;
-        ++mLoadRequestsCounter;
-        ThreadData &mainData = mThreadData[c_mainThread];
-        mLoadRequestsMutex.lock();
-        mainData.loadRequests.push_back( LoadRequest( "", archive, loadingListener, image, texture,
-                                                      sliceOrDepth, filters, autoDeleteImage, false ) );
-        mLoadRequestsMutex.unlock();
-        mWorkerWaitableEvent.wake();
+        addLoadRequest( LoadRequest( "", archive, loadingListener, image, texture, sliceOrDepth,
+                                     filters, autoDeleteImage, false ) );
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::scheduleLoadRequest( TextureGpu *texture, Image2 *image,
@@ -1824,14 +1920,145 @@ namespace Ogre
 
         texture->_transitionTo( GpuResidency::Resident, texture->_getSysRamCopy( 0 ), false );
 
+        addLoadRequest( LoadRequest( name, 0, 0, image, texture, 0, filters, true, false ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::addLoadRequest( const LoadRequest &loadRequest )
+    {
+        // All requests of a texture must go to the same thread, otherwise they could be
+        // processed out of order (e.g. a cubemap's faces, or a rescheduled texture)
+        StreamingThread &streamingThread =
+            *mStreamingThreads[loadRequest.texture->getName().mHash % mStreamingThreads.size()];
+
         mAddedNewLoadRequests = true;
         ++mLoadRequestsCounter;
-        ThreadData &mainData = mThreadData[c_mainThread];
+        ThreadData &mainData = streamingThread.threadData[c_mainThread];
+        mLoadRequestsMutex.lock();
+        mainData.loadRequests.push_back( loadRequest );
+        mainData.loadRequests.back().priority = getEffectiveLoadPriority( loadRequest.texture );
+        mainData.loadRequests.back().sequence = mLoadRequestsCounter;
+        mLoadRequestsMutex.unlock();
+        streamingThread.wakeUpEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::addLoadRequestUpdate( TextureGpu *texture, LoadRequestType requestType )
+    {
+        OGRE_ASSERT_MEDIUM( requestType != LoadRequestLoad );
+
+        LoadRequest loadRequest( BLANKSTRING, 0, 0, 0, texture, 0u, 0u, false, false );
+        loadRequest.requestType = requestType;
+        loadRequest.priority = getEffectiveLoadPriority( texture );
+        loadRequest.sequence = mLoadRequestsCounter;
+
+        StreamingThread &streamingThread =
+            *mStreamingThreads[texture->getName().mHash % mStreamingThreads.size()];
+
+        ThreadData &mainData = streamingThread.threadData[c_mainThread];
         mLoadRequestsMutex.lock();
-        mainData.loadRequests.push_back(
-            LoadRequest( name, 0, 0, image, texture, 0, filters, true, false ) );
+        mainData.loadRequests.push_back( loadRequest );
         mLoadRequestsMutex.unlock();
-        mWorkerWaitableEvent.wake();
+        streamingThread.wakeUpEvent.wake();
+    }
+    //-----------------------------------------------------------------------------------
+    float TextureGpuManager::getEffectiveLoadPriority( TextureGpu *texture ) const
+    {
+        float retVal = texture->getLoadPriority();
+        ScreenCoverageMap::const_iterator itor = mScreenCoverage.find( texture );
+        if( itor != mScreenCoverage.end() )
+            retVal += itor->second.sent;
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setProgressiveStreaming( bool bEnable, size_t maxBytesPerFrame,
+                                                     uint32 mipTailResolution )
+    {
+        mProgressiveStreaming = bEnable && mSupportsProgressiveStreaming;
+        mStreamingData.maxProgressiveBytesPerFrame = maxBytesPerFrame;
+        mStreamingData.progressiveMipTailResolution = mipTailResolution;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setAutomaticLoadPriorities( bool bEnable )
+    {
+        mAutomaticLoadPriorities = bEnable;
+        if( !bEnable )
+        {
+            mScreenCoverage.clear();
+            mScreenCoverageDirty = false;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_addScreenCoverage( TextureGpu *texture, float coverage )
+    {
+        if( !mAutomaticLoadPriorities || texture->isManualTexture() )
+            return;
+
+        ScreenCoverageMap::iterator itor = mScreenCoverage.find( texture );
+        if( itor == mScreenCoverage.end() )
+        {
+            ScreenCoverage screenCoverage;
+            screenCoverage.sent = 0.0f;
+            screenCoverage.current = coverage;
+            mScreenCoverage.insert( ScreenCoverageMap::value_type( texture, screenCoverage ) );
+        }
+        else
+        {
+            itor->second.current = std::max( itor->second.current, coverage );
+        }
+
+        mScreenCoverageDirty = true;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::flushScreenCoverage()
+    {
+        if( !mScreenCoverageDirty )
+            return;
+
+        OgreProfileExhaustive( "TextureGpuManager::flushScreenCoverage" );
+
+        ScreenCoverageMap::iterator itor = mScreenCoverage.begin();
+        ScreenCoverageMap::iterator endt = mScreenCoverage.end();
+
+        while( itor != endt )
+        {
+            TextureGpu *texture = itor->first;
+            if( texture->isDataReady() )
+            {
+                // Done loading. Nothing to prioritize anymore
+                mScreenCoverage.erase( itor++ );
+            }
+            else
+            {
+                // Textures that weren't seen since the last flush drop to 0
+                if( itor->second.current != itor->second.sent )
+                {
+                    itor->second.sent = itor->second.current;
+                    addLoadRequestUpdate( texture, LoadRequestUpdatePriority );
+                }
+                itor->second.current = 0.0f;
+                ++itor;
+            }
+        }
+
+        mScreenCoverageDirty = false;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_notifyLoadPriorityChanged( TextureGpu *texture )
+    {
+        addLoadRequestUpdate( texture, LoadRequestUpdatePriority );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_notifyLoadCancelled( TextureGpu *texture )
+    {
+        // The texture is Resident, but it never got its data. The task that asked for
+        // the cancellation (going OnStorage or destroying it) is the first one in queue.
+        // Execute it as if the data were ready; TextureGpu::_transitionTo knows how
+        // to abort a load.
+        OGRE_ASSERT_MEDIUM( texture->getResidencyStatus() == GpuResidency::Resident &&
+                            !texture->_isDataReadyImpl() );
+        OGRE_ASSERT_MEDIUM( mScheduledTasks.find( texture ) != mScheduledTasks.end() );
+
+        mScreenCoverage.erase( texture );
+        notifyTextureChanged( texture, TextureGpuListener::ReadyForRendering, false );
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_scheduleTransitionTo( TextureGpu *texture,
@@ -1898,7 +2125,9 @@ namespace Ogre
                     else
                     {
                         // No pending tasks, but the texture is being loaded. Delay execution
+                        // and try to cancel the load if the worker hasn't started it yet
                         mScheduledTasks[texture].push_back( task );
+                        addLoadRequestUpdate( texture, LoadRequestCancel );
                     }
                 }
             }
@@ -2239,7 +2468,7 @@ namespace Ogre
         mStreamingData.bytesPreloaded = 0;
     }
     //-----------------------------------------------------------------------------------
-    void TextureGpuManager::mergeUsageStatsIntoPrevStats()
+    void TextureGpuManager::mergeUsageStatsIntoPrevStats( StreamingThread &streamingThread )
     {
         // The sole purpose of this function is to perform a moving average
         //(https://en.wikipedia.org/wiki/Moving_average) between past records
@@ -2256,8 +2485,8 @@ namespace Ogre
         // low loopCount)
         uint32 c_loopResetValue = 15u;
 
-        UsageStatsVec::const_iterator itor = mStreamingData.usageStats.begin();
-        UsageStatsVec::const_iterator endt = mStreamingData.usageStats.end();
+        UsageStatsVec::const_iterator itor = streamingThread.usageStats.begin();
+        UsageStatsVec::const_iterator endt = streamingThread.usageStats.end();
 
         while( itor != endt )
         {
@@ -2322,19 +2551,22 @@ namespace Ogre
             ++itor;
         }
 
-        mStreamingData.usageStats.clear();
+        streamingThread.usageStats.clear();
     }
     //-----------------------------------------------------------------------------------
-    TextureBox TextureGpuManager::getStreaming( ThreadData &workerData, StreamingData &streamingData,
-                                                const TextureBox &box, PixelFormatGpu pixelFormat,
+    TextureBox TextureGpuManager::getStreaming( StreamingThread &streamingThread, const TextureBox &box,
+                                                PixelFormatGpu pixelFormat,
                                                 StagingTexture **outStagingTexture )
     {
         // No need to check if streamingData.bytesPreloaded >= mMaxPreloadBytes because
-        // our caller's caller already does that. Besides this is a static function.
+        // our caller's caller already does that.
         // This gives us slightly broader granularity control over memory consumption
         //(we may to try to preload all the mipmaps even if mMaxPreloadBytes is exceeded)
         TextureBox retVal;
 
+        ThreadData &workerData = streamingThread.threadData[c_workerThread];
+        StreamingData &streamingData = mStreamingData;
+
         StagingTextureVec::iterator itor = workerData.usedStagingTex.begin();
         StagingTextureVec::iterator endt = workerData.usedStagingTex.end();
 
@@ -2354,6 +2586,9 @@ namespace Ogre
             ++itor;
         }
 
+        // Other worker threads may be looking for one too
+        ScopedLock lock( mMutex );
+
         itor = streamingData.availableStagingTex.begin();
         endt = streamingData.availableStagingTex.end();
 
@@ -2386,8 +2621,8 @@ namespace Ogre
 
         // Keep track of requests so main thread knows our current workload.
         const PixelFormatGpu formatFamily = PixelFormatGpuUtils::getFamily( pixelFormat );
-        UsageStatsVec::iterator itStats = streamingData.usageStats.begin();
-        UsageStatsVec::iterator enStats = streamingData.usageStats.end();
+        UsageStatsVec::iterator itStats = streamingThread.usageStats.begin();
+        UsageStatsVec::iterator enStats = streamingThread.usageStats.end();
 
         // Always split tracking of textures that are bigger than c_maxSplitResolution in any dimension
         if( box.width >= streamingData.maxSplitResolution ||
@@ -2408,7 +2643,7 @@ namespace Ogre
 
         if( itStats == enStats )
         {
-            streamingData.usageStats.push_back(
+            streamingThread.usageStats.push_back(
                 UsageStats( box.width, box.height, box.getDepthOrSlices(), formatFamily ) );
         }
         else
@@ -2423,28 +2658,39 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void TextureGpuManager::processQueuedImage( QueuedImage &queuedImage, ThreadData &workerData,
-                                                StreamingData &streamingData )
+    void TextureGpuManager::processQueuedImage( QueuedImage &queuedImage,
+                                                StreamingThread &streamingThread )
     {
         OgreProfileExhaustive( "TextureGpuManager::processQueuedImage" );
 
         Image2 &img = queuedImage.image;
         TextureGpu *texture = queuedImage.dstTexture;
-        ObjCmdBuffer *commandBuffer = workerData.objCmdBuffer;
+        ObjCmdBuffer *commandBuffer = streamingThread.threadData[c_workerThread].objCmdBuffer;
+        commandBuffer->setSequence( queuedImage.sequence );
 
         const bool is3DVolume = img.getDepth() > 1u;
 
         const uint8 firstMip = queuedImage.getMinMipLevel();
         const uint8 numMips = queuedImage.getMaxMipLevelPlusOne();
 
-        for( uint8 i = firstMip; i < numMips; ++i )
+        // Progressive images are uploaded from the coarsest mip to the finest one, and
+        // stop as soon as something fails so that the ones that are ready are contiguous.
+        const bool progressive = queuedImage.mipTail > 0u;
+        bool stopUploading = false;
+
+        for( uint8 mipIdx = firstMip; mipIdx < numMips && !stopUploading; ++mipIdx )
         {
+            const uint8 i = progressive ? uint8( numMips - 1u - ( mipIdx - firstMip ) ) : mipIdx;
+
+            if( progressive && i < queuedImage.mipTail && isProgressiveBudgetExceeded() )
+                break;
+
             TextureBox srcBox = img.getData( i );
             const uint32 imgDepthOrSlices = srcBox.getDepthOrSlices();
 
             OGRE_ASSERT_MEDIUM( imgDepthOrSlices < std::numeric_limits<uint8>::max() );
 
-            for( uint32 z = 0; z < imgDepthOrSlices; ++z )
+            for( uint32 z = 0; z < imgDepthOrSlices && !stopUploading; ++z )
             {
                 if( queuedImage.isMipSliceQueued( i, (uint8)z ) )
                 {
@@ -2454,8 +2700,8 @@ namespace Ogre
                     srcBox.numSlices = 1u;
 
                     StagingTexture *stagingTexture = 0;
-                    TextureBox dstBox = getStreaming( workerData, streamingData, srcBox,
-                                                      img.getPixelFormat(), &stagingTexture );
+                    TextureBox dstBox =
+                        getStreaming( streamingThread, srcBox, img.getPixelFormat(), &stagingTexture );
                     if( dstBox.data )
                     {
                         // Upload to staging area. CPU -> GPU
@@ -2475,18 +2721,44 @@ namespace Ogre
                                                                              texture, srcBox, i );
                         // This mip has been processed, flag it as done.
                         queuedImage.unqueueMipSlice( i, (uint8)z );
+
+                        if( progressive && i < queuedImage.mipTail )
+                            addProgressiveBytesUploaded( dstBox.getSizeBytes() );
+                    }
+                    else
+                    {
+                        stopUploading = progressive;
                     }
                 }
             }
         }
 
+        if( progressive )
+        {
+            // All mips coarser than the last queued one are uploaded.
+            const uint8 mostDetailedMipReady =
+                queuedImage.empty() ? 0u : queuedImage.getMaxMipLevelPlusOne();
+            const bool wasDisplayed = queuedImage.mostDetailedMipReady < img.getNumMipmaps();
+
+            // Don't bother if it got fully uploaded at once: NotifyDataIsReady is enough.
+            if( mostDetailedMipReady < queuedImage.mostDetailedMipReady &&
+                mostDetailedMipReady <= queuedImage.mipTail &&
+                ( wasDisplayed || !queuedImage.empty() ) )
+            {
+                ObjCmdBuffer::NotifyMipsAreReady *cmd =
+                    commandBuffer->addCommand<ObjCmdBuffer::NotifyMipsAreReady>();
+                new( cmd ) ObjCmdBuffer::NotifyMipsAreReady( texture, mostDetailedMipReady );
+                queuedImage.mostDetailedMipReady = mostDetailedMipReady;
+            }
+        }
+
         if( queuedImage.empty() )
         {
             // We're done uploading this image. Time to run NotifyDataIsReady,
             // unless there's more QueuedImage like us because the Texture is
             // being loaded from multiple files.
-            PartialImageMap::iterator itor = streamingData.partialImages.find( texture );
-            PartialImageMap::iterator endt = streamingData.partialImages.end();
+            PartialImageMap::iterator itor = streamingThread.partialImages.find( texture );
+            PartialImageMap::iterator endt = streamingThread.partialImages.end();
 
             if( itor != endt )
                 itor->second.numProcessedDepthOrSlices += img.getDepthOrSlices();
@@ -2501,7 +2773,7 @@ namespace Ogre
                         addTransitionToLoadedCmd( commandBuffer, texture, itor->second.sysRamPtr,
                                                   itor->second.toSysRam );
                     }
-                    streamingData.partialImages.erase( itor );
+                    streamingThread.partialImages.erase( itor );
                 }
 
                 // Filters will be destroyed by NotifyDataIsReady in main thread
@@ -2534,6 +2806,25 @@ namespace Ogre
         new( transitionCmd ) ObjCmdBuffer::TransitionToLoaded( texture, sysRamCopy, targetResidency );
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::copyLeastDetailedMips( const Image2 &srcImage, Image2 &dstImage,
+                                                   uint8 mostDetailedMip )
+    {
+        uint32 depthOrSlices = srcImage.getDepthOrSlices();
+        if( srcImage.getTextureType() == TextureTypes::Type3D )
+            depthOrSlices = std::max( depthOrSlices >> mostDetailedMip, 1u );
+
+        dstImage.createEmptyImage( std::max( srcImage.getWidth() >> mostDetailedMip, 1u ),
+                                   std::max( srcImage.getHeight() >> mostDetailedMip, 1u ),
+                                   depthOrSlices, srcImage.getTextureType(),
+                                   srcImage.getPixelFormat(),
+                                   static_cast<uint8>( srcImage.getNumMipmaps() - mostDetailedMip ) );
+
+        // Mips are stored contiguously from most to least detailed, so the ones we keep
+        // have the exact same layout as an image that starts at mostDetailedMip.
+        memcpy( dstImage.getData( 0 ).data, srcImage.getData( mostDetailedMip ).data,
+                dstImage.getSizeBytes() );
+    }
+    //-----------------------------------------------------------------------------------
     unsigned long updateStreamingWorkerThread( ThreadHandle *threadHandle )
     {
         TextureGpuManager *textureManager =
@@ -2543,29 +2834,73 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     unsigned long TextureGpuManager::_updateStreamingWorkerThread( ThreadHandle *threadHandle )
     {
+        const size_t threadIdx = threadHandle->getThreadIdx();
+        StreamingThread &streamingThread = *mStreamingThreads[threadIdx];
         while( !mShuttingDown )
         {
-            mWorkerWaitableEvent.wait();
-            _updateStreaming();
+            streamingThread.wakeUpEvent.wait();
+            _updateStreaming( threadIdx );
         }
 
         return 0;
     }
     //-----------------------------------------------------------------------------------
-    void TextureGpuManager::processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
+    DataStreamPtr TextureGpuManager::openLoadRequest( ObjCmdBuffer *commandBuffer,
+                                                      const LoadRequest &loadRequest,
+                                                      bool readIntoMemory )
+    {
+        DataStreamPtr data;
+        try
+        {
+            if( !loadRequest.archive )
+            {
+                data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
+            }
+            else
+            {
+                data = loadRequest.archive->open( loadRequest.name );
+                if( loadRequest.loadingListener )
+                {
+                    loadRequest.loadingListener->grouplessResourceOpened( loadRequest.name,
+                                                                          loadRequest.archive, data );
+                }
+            }
+
+            if( readIntoMemory && data )
+                data = DataStreamPtr( OGRE_NEW MemoryDataStream( data ) );
+        }
+        catch( Exception &e )
+        {
+            // Log the exception
+            LogManager::getSingleton().logMessage( e.getFullDescription() );
+            // Tell the main thread this happened
+            ObjCmdBuffer::ExceptionThrown *exceptionCmd =
+                commandBuffer->addCommand<ObjCmdBuffer::ExceptionThrown>();
+            new( exceptionCmd ) ObjCmdBuffer::ExceptionThrown( loadRequest.texture, e );
+
+            data.reset();
+        }
+
+        return data;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::processLoadRequest( ObjCmdBuffer *commandBuffer,
+                                                StreamingThread &streamingThread,
                                                 const LoadRequest &loadRequest )
     {
         OgreProfileExhaustive( "TextureGpuManager::processLoadRequest LoadRequest for first time" );
 
+        commandBuffer->setSequence( loadRequest.sequence );
+
         bool wasRescheduled = false;
 
         // WARNING: loadRequest.texture->isMetadataReady and
         // loadRequest.texture->getResidencyStatus are NOT thread safe
-        // if it's in mStreamingData.rescheduledTextures and
+        // if it's in streamingThread.rescheduledTextures and
         // loadRequest.sliceOrDepth != 0 or uint32::max
         set<TextureGpu *>::type::iterator itReschedule =
-            mStreamingData.rescheduledTextures.find( loadRequest.texture );
-        if( itReschedule != mStreamingData.rescheduledTextures.end() )
+            streamingThread.rescheduledTextures.find( loadRequest.texture );
+        if( itReschedule != streamingThread.rescheduledTextures.end() )
         {
             if( ( loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() ||
                   loadRequest.sliceOrDepth == 0 ) )
@@ -2573,7 +2908,7 @@ namespace Ogre
                 // This is the original first load request that is making it's
                 // roundtrip back to us: Worker -> Main -> Worker
                 // because the metadata cache lied the last time we parsed it
-                mStreamingData.rescheduledTextures.erase( itReschedule );
+                streamingThread.rescheduledTextures.erase( itReschedule );
             }
             else
             {
@@ -2594,29 +2929,19 @@ namespace Ogre
         }
 
         DataStreamPtr data;
-        if( !loadRequest.archive && !loadRequest.image )
-            data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
-        else if( !loadRequest.image )
+        if( !loadRequest.image )
         {
-            try
+            if( mStreamingThreads.size() > 1u )
             {
-                data = loadRequest.archive->open( loadRequest.name );
-                if( loadRequest.loadingListener )
-                {
-                    loadRequest.loadingListener->grouplessResourceOpened( loadRequest.name,
-                                                                          loadRequest.archive, data );
-                }
+                // Archives & listeners may not be thread safe. With more than one streaming
+                // thread, read the whole file into memory while holding a lock, and decode
+                // it afterwards.
+                ScopedLock lock( mStreamingIoMutex );
+                data = openLoadRequest( commandBuffer, loadRequest, true );
             }
-            catch( Exception &e )
+            else
             {
-                // Log the exception
-                LogManager::getSingleton().logMessage( e.getFullDescription() );
-                // Tell the main thread this happened
-                ObjCmdBuffer::ExceptionThrown *exceptionCmd =
-                    commandBuffer->addCommand<ObjCmdBuffer::ExceptionThrown>();
-                new( exceptionCmd ) ObjCmdBuffer::ExceptionThrown( loadRequest.texture, e );
-
-                data.reset();
+                data = openLoadRequest( commandBuffer, loadRequest, false );
             }
         }
 
@@ -2666,6 +2991,17 @@ namespace Ogre
             }
         }
 
+        // Drop the most detailed mips if asked to. We can only do that if they're in the file;
+        // we don't downscale images that have no mipmaps.
+        Image2 imgLowRes;
+        if( !wasRescheduled && loadRequest.mostDetailedMip > 0u && img->getNumMipmaps() > 1u )
+        {
+            const uint8 mostDetailedMip =
+                std::min<uint8>( loadRequest.mostDetailedMip, uint8( img->getNumMipmaps() - 1u ) );
+            copyLeastDetailedMips( *img, imgLowRes, mostDetailedMip );
+            img = &imgLowRes;
+        }
+
         if( ( loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() ||
               loadRequest.sliceOrDepth == 0 ) &&
             loadRequest.texture->getResidencyStatus() != GpuResidency::OnStorage )
@@ -2694,7 +3030,7 @@ namespace Ogre
                 ObjCmdBuffer::OutOfDateCache *transitionCmd =
                     commandBuffer->addCommand<ObjCmdBuffer::OutOfDateCache>();
                 new( transitionCmd ) ObjCmdBuffer::OutOfDateCache( loadRequest.texture, *img );
-                mStreamingData.rescheduledTextures.insert( loadRequest.texture );
+                streamingThread.rescheduledTextures.insert( loadRequest.texture );
                 wasRescheduled = true;
 
                 LogManager::getSingleton().logMessage(
@@ -2795,7 +3131,7 @@ namespace Ogre
                 if( needsMultipleImages )
                 {
                     // We'll need more than one Image to load this texture, so track progress
-                    mStreamingData.partialImages[loadRequest.texture] =
+                    streamingThread.partialImages[loadRequest.texture] =
                         PartialImage( sysRamCopy, loadRequest.toSysRam );
                 }
 
@@ -2823,9 +3159,9 @@ namespace Ogre
                                                 GpuPageOutStrategy::AlwaysKeepSystemRamCopy )
                 {
                     PartialImageMap::iterator itPartImg =
-                        mStreamingData.partialImages.find( loadRequest.texture );
+                        streamingThread.partialImages.find( loadRequest.texture );
 
-                    OGRE_ASSERT_LOW( itPartImg != mStreamingData.partialImages.end() );
+                    OGRE_ASSERT_LOW( itPartImg != streamingThread.partialImages.end() );
                     OGRE_ASSERT_LOW( itPartImg->second.sysRamPtr );
 
                     Image2 imgDst;
@@ -2854,7 +3190,7 @@ namespace Ogre
                             // We couldn't transition earlier, so we have to do it now that we're done
                             addTransitionToLoadedCmd( commandBuffer, loadRequest.texture,
                                                       itPartImg->second.sysRamPtr, true );
-                            mStreamingData.partialImages.erase( itPartImg );
+                            streamingThread.partialImages.erase( itPartImg );
 
                             // Filters will be destroyed by NotifyDataIsReady in main thread
                             ObjCmdBuffer::NotifyDataIsReady *cmd =
@@ -2872,16 +3208,37 @@ namespace Ogre
             if( !loadRequest.toSysRam )
             {
                 // Queue the image for upload to GPU.
-                mStreamingData.queuedImages.push_back(
-                    QueuedImage( *img, loadRequest.texture, loadRequest.sliceOrDepth, filters ) );
+                streamingThread.queuedImages.push_back(
+                    QueuedImage( *img, loadRequest.texture, loadRequest.sliceOrDepth, filters,
+                                 loadRequest.sequence ) );
                 if( loadRequest.autoDeleteImage )
                     delete loadRequest.image;
 
+                // We can only show the mip tail first if the file has all the mips
+                // (otherwise we must wait for the filters to generate them).
+                QueuedImage &queuedImage = streamingThread.queuedImages.back();
+                const Image2 &queuedImg = queuedImage.image;
+                if( loadRequest.progressive &&
+                    loadRequest.sliceOrDepth == std::numeric_limits<uint32>::max() &&
+                    queuedImg.getNumMipmaps() > 1u &&
+                    queuedImg.getNumMipmaps() == loadRequest.texture->getNumMipmaps() )
+                {
+                    const uint32 mipTailResolution = mStreamingData.progressiveMipTailResolution;
+                    uint8 mipTail = 0u;
+                    while( mipTail < queuedImg.getNumMipmaps() - 1u &&
+                           ( ( queuedImg.getWidth() >> mipTail ) > mipTailResolution ||
+                             ( queuedImg.getHeight() >> mipTail ) > mipTailResolution ) )
+                    {
+                        ++mipTail;
+                    }
+                    queuedImage.mipTail = mipTail;
+                }
+
                 // Try to upload the queued image right now (all of its mipmaps).
-                processQueuedImage( mStreamingData.queuedImages.back(), workerData, mStreamingData );
+                processQueuedImage( queuedImage, streamingThread );
 
-                if( mStreamingData.queuedImages.back().empty() )
-                    mStreamingData.queuedImages.pop_back();
+                if( streamingThread.queuedImages.back().empty() )
+                    streamingThread.queuedImages.pop_back();
             }
             else
             {
@@ -2896,7 +3253,120 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::applyLoadRequestUpdates( StreamingThread &streamingThread )
+    {
+        OgreProfileExhaustive( "TextureGpuManager::applyLoadRequestUpdates" );
+
+        ThreadData &workerData = streamingThread.threadData[c_workerThread];
+        LoadRequestVec &loadRequests = workerData.loadRequests;
+
+        // Every request in loadRequests hasn't started yet (processed ones are removed).
+        // Updates only affect the requests sent before them.
+        size_t i = 0u;
+        while( i < loadRequests.size() )
+        {
+            if( loadRequests[i].requestType == LoadRequestLoad )
+            {
+                ++i;
+                continue;
+            }
+
+            TextureGpu *texture = loadRequests[i].texture;
+
+            if( loadRequests[i].requestType == LoadRequestUpdatePriority )
+            {
+                const float priority = loadRequests[i].priority;
+                for( size_t j = 0u; j < i; ++j )
+                {
+                    if( loadRequests[j].texture == texture )
+                        loadRequests[j].priority = priority;
+                }
+            }
+            else
+            {
+                // We can only cancel if nothing of this texture has been processed yet
+                bool canCancel =
+                    streamingThread.partialImages.find( texture ) ==
+                        streamingThread.partialImages.end() &&
+                    streamingThread.rescheduledTextures.find( texture ) ==
+                        streamingThread.rescheduledTextures.end();
+
+                QueuedImageVec::const_iterator itQueue = streamingThread.queuedImages.begin();
+                QueuedImageVec::const_iterator enQueue = streamingThread.queuedImages.end();
+                while( itQueue != enQueue && canCancel )
+                {
+                    canCancel = itQueue->dstTexture != texture;
+                    ++itQueue;
+                }
+
+                size_t numToCancel = 0u;
+                for( size_t j = 0u; j < i && canCancel; ++j )
+                {
+                    if( loadRequests[j].texture == texture )
+                    {
+                        canCancel = loadRequests[j].cancellable;
+                        ++numToCancel;
+                    }
+                }
+
+                if( canCancel && numToCancel > 0u )
+                {
+                    size_t j = 0u;
+                    while( j < i )
+                    {
+                        if( loadRequests[j].texture == texture )
+                        {
+                            if( loadRequests[j].autoDeleteImage )
+                                delete loadRequests[j].image;
+                            loadRequests.erase( loadRequests.begin() + static_cast<ptrdiff_t>( j ) );
+                            --i;
+                        }
+                        else
+                        {
+                            ++j;
+                        }
+                    }
+
+                    ObjCmdBuffer *commandBuffer = workerData.objCmdBuffer;
+                    commandBuffer->setSequence( loadRequests[i].sequence );
+                    ObjCmdBuffer::LoadCancelled *cancelCmd =
+                        commandBuffer->addCommand<ObjCmdBuffer::LoadCancelled>();
+                    new( cancelCmd ) ObjCmdBuffer::LoadCancelled( texture );
+                }
+            }
+
+            loadRequests.erase( loadRequests.begin() + static_cast<ptrdiff_t>( i ) );
+        }
+
+        std::stable_sort( loadRequests.begin(), loadRequests.end(), LoadRequest::PriorityCmp() );
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::_updateStreaming()
+    {
+        const size_t numThreads = mStreamingThreads.size();
+        for( size_t i = 0u; i < numThreads; ++i )
+            _updateStreaming( i );
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::isPreloadBudgetExceeded()
+    {
+        ScopedLock lock( mMutex );
+        return mStreamingData.bytesPreloaded >= mMaxPreloadBytes;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TextureGpuManager::isProgressiveBudgetExceeded()
+    {
+        ScopedLock lock( mMutex );
+        return mStreamingData.progressiveBytesUploaded >= mStreamingData.maxProgressiveBytesPerFrame;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::addProgressiveBytesUploaded( size_t bytes )
+    {
+        ScopedLock lock( mMutex );
+        mStreamingData.progressiveBytesUploaded += bytes;
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::_updateStreaming( size_t threadIdx )
     {
         OgreProfileExhaustive( "TextureGpuManager::_updateStreaming" );
 
@@ -2915,24 +3385,28 @@ namespace Ogre
         Set textures is not protected, so reading pixel format, resolution or type
         could potentially invoke a race condition.
 
-        The rest is protected by mMutex, which takes longer. That means the worker
-        thread processes a batch of textures together and when it cannot continue
-        (whether it's because it ran out of space or it ran out of work) it delivers
-        the commands to the main thread.
-        */
+        The rest of this thread's data is protected by streamingThread.mutex, which
+        takes longer. That means the worker thread processes a batch of textures together
+        and when it cannot continue (whether it's because it ran out of space or it ran
+        out of work) it delivers the commands to the main thread.
 
-        mMutex.lock();
+        What's shared with the other worker threads (available StagingTextures, usage
+        stats, bytes preloaded) is protected by mMutex, which is only held briefly so
+        that worker threads don't wait on each other while decoding images.
+        */
 
-        mStreamingData.workerThreadRan = true;
+        StreamingThread &streamingThread = *mStreamingThreads[threadIdx];
+        streamingThread.mutex.lock();
 
-        ThreadData &workerData = mThreadData[c_workerThread];
-        ThreadData &mainData = mThreadData[c_mainThread];
+        ThreadData &workerData = streamingThread.threadData[c_workerThread];
+        ThreadData &mainData = streamingThread.threadData[c_mainThread];
 
         mLoadRequestsMutex.lock();
-        // Lock while inside mMutex because _update has access to our
+        // Lock while inside streamingThread.mutex because _update has access to our
         // workerData.loadRequests. We still need mLoadRequestsMutex
         // to keep our access to mainData.loadRequests as short as possible
         //(we don't want to block the main thread for long).
+        const bool receivedRequests = !mainData.loadRequests.empty();
         if( workerData.loadRequests.empty() )
         {
             workerData.loadRequests.swap( mainData.loadRequests );
@@ -2945,22 +3419,27 @@ namespace Ogre
         }
         mLoadRequestsMutex.unlock();
 
+        if( receivedRequests )
+            applyLoadRequestUpdates( streamingThread );
+
         ObjCmdBuffer *commandBuffer = workerData.objCmdBuffer;
 
-        const bool processedAnyImage =
-            !workerData.loadRequests.empty() || !mStreamingData.queuedImages.empty();
+        // receivedRequests: even if they all were updates or cancelled loads, main thread
+        // may be waiting for them to be consumed.
+        const bool processedAnyImage = receivedRequests || !workerData.loadRequests.empty() ||
+                                       !streamingThread.queuedImages.empty();
 
         // First, try to upload the queued images that failed in the previous iteration.
-        QueuedImageVec::iterator itQueue = mStreamingData.queuedImages.begin();
-        QueuedImageVec::iterator enQueue = mStreamingData.queuedImages.end();
+        QueuedImageVec::iterator itQueue = streamingThread.queuedImages.begin();
+        QueuedImageVec::iterator enQueue = streamingThread.queuedImages.end();
 
-        while( itQueue != enQueue && mStreamingData.bytesPreloaded < mMaxPreloadBytes )
+        while( itQueue != enQueue && !isPreloadBudgetExceeded() )
         {
-            processQueuedImage( *itQueue, workerData, mStreamingData );
+            processQueuedImage( *itQueue, streamingThread );
             if( itQueue->empty() )
             {
-                itQueue = efficientVectorRemove( mStreamingData.queuedImages, itQueue );
-                enQueue = mStreamingData.queuedImages.end();
+                itQueue = efficientVectorRemove( streamingThread.queuedImages, itQueue );
+                enQueue = streamingThread.queuedImages.end();
             }
             else
             {
@@ -2975,9 +3454,9 @@ namespace Ogre
         LoadRequestVec::const_iterator endt = workerData.loadRequests.end();
 
         while( itor != endt && entriesProcessed < entriesToProcessPerIteration &&
-               mStreamingData.bytesPreloaded < mMaxPreloadBytes )
+               !isPreloadBudgetExceeded() )
         {
-            processLoadRequest( commandBuffer, workerData, *itor );
+            processLoadRequest( commandBuffer, streamingThread, *itor );
             ++entriesProcessed;
             ++itor;
         }
@@ -2990,8 +3469,8 @@ namespace Ogre
         // Note that normally main thread isn't sleeping, but it could be if
         // waitForStreamingCompletion was called.
         bool wakeUpMainThread = false;
-        if( ( processedAnyImage && mStreamingData.queuedImages.empty() ) ||
-            !mStreamingData.queuedImages.empty() )
+        if( ( processedAnyImage && streamingThread.queuedImages.empty() ) ||
+            !streamingThread.queuedImages.empty() )
         {
             wakeUpMainThread = true;
         }
@@ -2999,10 +3478,15 @@ namespace Ogre
         workerData.loadRequests.erase(
             workerData.loadRequests.begin(),
             workerData.loadRequests.begin() + static_cast<ptrdiff_t>( entriesProcessed ) );
-        mergeUsageStatsIntoPrevStats();
+
+        mMutex.lock();
+        mStreamingData.workerThreadRan = true;
+        mergeUsageStatsIntoPrevStats( streamingThread );
         mMutex.unlock();
 
-        // Wake up outside mMutex to avoid unnecessary contention.
+        streamingThread.mutex.unlock();
+
+        // Wake up outside the mutexes to avoid unnecessary contention.
         if( wakeUpMainThread )
             mRequestToMainThreadEvent.wake();
     }
@@ -3193,22 +3677,60 @@ namespace Ogre
 
         mAddedNewLoadRequests = false;
 
+        flushScreenCoverage();
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_EMSCRIPTEN || OGRE_FORCE_TEXTURE_STREAMING_ON_MAIN_THREAD
         _updateStreaming();
 #endif
-        bool isDone = false;
+        bool isDone = true;
+
+        {
+            bool lockSucceeded = false;
+            if( !syncWithWorkerThread )
+            {
+                lockSucceeded = mMutex.tryLock();
+            }
+            else
+            {
+                lockSucceeded = true;
+                mMutex.lock();
+            }
+
+            if( lockSucceeded )
+            {
+                if( mStreamingData.workerThreadRan )
+                {
+                    fullfillBudget();
+                    mStreamingData.workerThreadRan = false;
+                }
+                mStreamingData.progressiveBytesUploaded = 0;
+                mMutex.unlock();
+            }
+            else
+            {
+                isDone = false;
+            }
+        }
 
-        ThreadData &mainData = mThreadData[c_mainThread];
+        StreamingThreadVec::const_iterator itThread = mStreamingThreads.begin();
+        StreamingThreadVec::const_iterator enThread = mStreamingThreads.end();
+
+        while( itThread != enThread )
         {
-            ThreadData &workerData = mThreadData[c_workerThread];
+            StreamingThread &streamingThread = **itThread;
+            ThreadData &mainData = streamingThread.threadData[c_mainThread];
+            ThreadData &workerData = streamingThread.threadData[c_workerThread];
+
+            bool syncWithThisThread = syncWithWorkerThread;
             bool lockSucceeded = false;
 
-            if( mTryLockMutexFailureCount >= mTryLockMutexFailureLimit &&
+            if( streamingThread.tryLockFailureCount >= mTryLockMutexFailureLimit &&
                 mTryLockMutexFailureLimit != std::numeric_limits<uint32>::max() )
             {
-                syncWithWorkerThread = true;
+                syncWithThisThread = true;
                 LogManager::getSingleton().logMessage(
-                    "WARNING: We failed " + StringConverter::toString( mTryLockMutexFailureCount ) +
+                    "WARNING: We failed " +
+                        StringConverter::toString( streamingThread.tryLockFailureCount ) +
                         " times to acquire lock from texture background streaming thread. "
                         "Stalling. If you see this message more than once, something is going "
                         "terribly wrong, or disk loading is incredibly slow. "
@@ -3216,38 +3738,39 @@ namespace Ogre
                     LML_CRITICAL );
             }
 
-            if( !syncWithWorkerThread )
+            if( !syncWithThisThread )
             {
-                lockSucceeded = mMutex.tryLock();
+                lockSucceeded = streamingThread.mutex.tryLock();
             }
             else
             {
                 lockSucceeded = true;
-                mMutex.lock();
+                streamingThread.mutex.lock();
             }
 
             if( lockSucceeded )
             {
-                mTryLockMutexFailureCount = 0;
+                streamingThread.tryLockFailureCount = 0;
                 std::swap( mainData.objCmdBuffer, workerData.objCmdBuffer );
                 mainData.usedStagingTex.swap( workerData.usedStagingTex );
-                if( mStreamingData.workerThreadRan )
-                {
-                    fullfillBudget();
-                    mStreamingData.workerThreadRan = false;
-                }
 
-                isDone = mainData.loadRequests.empty() && workerData.loadRequests.empty() &&
-                         mStreamingData.queuedImages.empty();
-                mMutex.unlock();
+                isDone &= mainData.loadRequests.empty() && workerData.loadRequests.empty() &&
+                          streamingThread.queuedImages.empty();
+                streamingThread.mutex.unlock();
             }
             else
             {
-                ++mTryLockMutexFailureCount;
+                ++streamingThread.tryLockFailureCount;
+                isDone = false;
             }
+
+            ++itThread;
         }
 
+        for( itThread = mStreamingThreads.begin(); itThread != enThread; ++itThread )
         {
+            ThreadData &mainData = ( *itThread )->threadData[c_mainThread];
+
             StagingTextureVec::const_iterator itor = mainData.usedStagingTex.begin();
             StagingTextureVec::const_iterator endt = mainData.usedStagingTex.end();
 
@@ -3280,11 +3803,23 @@ namespace Ogre
 
         {
             OgreProfileExhaustive( "TextureGpuManager::_update cmd buffer execution" );
-            mainData.objCmdBuffer->execute();
-            mainData.objCmdBuffer->clear();
+            // Interleave the threads in the order their requests were made, otherwise
+            // listeners would be notified grouped by thread.
+            FastArray<ObjCmdBuffer *> cmdBuffers;
+            cmdBuffers.reserve( mStreamingThreads.size() );
+            for( itThread = mStreamingThreads.begin(); itThread != enThread; ++itThread )
+                cmdBuffers.push_back( ( *itThread )->threadData[c_mainThread].objCmdBuffer );
+
+            ObjCmdBuffer::executeMerged( cmdBuffers.begin(), cmdBuffers.size() );
+
+            for( size_t i = 0u; i < cmdBuffers.size(); ++i )
+                cmdBuffers[i]->clear();
         }
 
+        for( itThread = mStreamingThreads.begin(); itThread != enThread; ++itThread )
         {
+            ThreadData &mainData = ( *itThread )->threadData[c_mainThread];
+
             StagingTextureVec::const_iterator itor = mainData.usedStagingTex.begin();
             StagingTextureVec::const_iterator endt = mainData.usedStagingTex.end();
 
@@ -3307,7 +3842,8 @@ namespace Ogre
         if( mAddedNewLoadRequests )
             isDone = false;
 
-        mWorkerWaitableEvent.wake();
+        for( itThread = mStreamingThreads.begin(); itThread != enThread; ++itThread )
+            ( *itThread )->wakeUpEvent.wake();
 
 #if OGRE_DEBUG_MODE && 0
         dumpStats();
@@ -3328,6 +3864,8 @@ namespace Ogre
     {
         OgreProfileExhaustive( "TextureGpuManager::waitForStreamingCompletion" );
 
+        const uint64 startUs = mStallTimer->getMicroseconds();
+
         bool bDone = false;
         while( !bDone )
         {
@@ -3351,10 +3889,14 @@ namespace Ogre
             dumpStats();
 #endif
         }
+
+        mStreamingStallTimeUs += mStallTimer->getMicroseconds() - startUs;
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_waitFor( TextureGpu *texture, bool metadataOnly )
     {
+        const uint64 startUs = mStallTimer->getMicroseconds();
+
         bool bDone = false;
         while( !bDone )
         {
@@ -3380,6 +3922,8 @@ namespace Ogre
                 }
             }
         }
+
+        mStreamingStallTimeUs += mStallTimer->getMicroseconds() - startUs;
     }
     //-----------------------------------------------------------------------------------
     void TextureGpuManager::_waitForPendingGpuToCpuSyncs( TextureGpu *texture )
@@ -3435,12 +3979,32 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
+    TextureGpuManager::StreamingThread::StreamingThread() : tryLockFailureCount( 0u )
+    {
+        for( size_t i = 0; i < 2u; ++i )
+            threadData[i].objCmdBuffer = new ObjCmdBuffer();
+    }
+    //-----------------------------------------------------------------------------------
+    TextureGpuManager::StreamingThread::~StreamingThread()
+    {
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            delete threadData[i].objCmdBuffer;
+            threadData[i].objCmdBuffer = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
     TextureGpuManager::QueuedImage::QueuedImage( Image2 &srcImage, TextureGpu *_dstTexture,
                                                  uint32 _dstSliceOrDepth,
-                                                 FilterBaseArray &inOutFilters ) :
+                                                 FilterBaseArray &inOutFilters, uint64 _sequence ) :
         dstTexture( _dstTexture ),
         autoDeleteImage( srcImage.getAutoDelete() ),
-        dstSliceOrDepth( _dstSliceOrDepth )
+        dstSliceOrDepth( _dstSliceOrDepth ),
+        mipTail( 0u ),
+        mostDetailedMipReady( srcImage.getNumMipmaps() ),
+        sequence( _sequence )
     {
         assert( srcImage.getDepthOrSlices() >= 1u );
 
@@ -0,0 +1,158 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreTransformUpdateScheduler.h"
+
+#include "OgreProfiler.h"
+
+namespace Ogre
+{
+    void UpdateTransformTask::execute( size_t chunkIdx, size_t threadIdx )
+    {
+        OgreProfileWorker( "Worker: Transforms" );
+
+        Transform t( request.t );
+        const size_t toAdvance = chunkIdx * request.numNodesPerChunk;
+
+        // Prevent going out of bounds (usually in the last chunk)
+        const size_t numNodes = std::min( request.numNodesPerChunk, request.numTotalNodes - toAdvance );
+        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+
+        const size_t numUpdated = updateFunction( numNodes, t );
+        if( numUpdatedPerThread )
+            numUpdatedPerThread[threadIdx] += numUpdated;
+    }
+    //-----------------------------------------------------------------------
+    void UpdateTransformLevelsTask::execute( size_t chunkIdx, size_t threadIdx )
+    {
+        for( size_t i = 0; i < numLevels; ++i )
+        {
+            assert( levels[i].request.getNumChunks() == 1u );
+            levels[i].execute( 0u, threadIdx );
+        }
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    TransformUpdateScheduler::TransformUpdateScheduler() :
+        mScheduling( SchedulingMergeNarrowLevels ),
+        mNumTasks( 0 )
+    {
+    }
+    //-----------------------------------------------------------------------
+    void TransformUpdateScheduler::addLevel( const Transform &t, size_t numNodes,
+                                             size_t numNodesPerChunk,
+                                             UpdateTransformTask::UpdateFunction updateFunction )
+    {
+        assert( numNodesPerChunk > 0u && ( numNodesPerChunk % ARRAY_PACKED_REALS ) == 0u );
+
+        if( numNodes )
+        {
+            // numUpdatedPerThread gets patched in execute; mNumUpdatedPerThread may be resized
+            mLevels.push_back( UpdateTransformTask(
+                UpdateTransformRequest( t, numNodesPerChunk, numNodes ), updateFunction ) );
+        }
+    }
+    //-----------------------------------------------------------------------
+    TaskScheduler::TaskId TransformUpdateScheduler::submitMergedLevels(
+        TaskScheduler *taskScheduler, size_t firstLevel, size_t lastLevel,
+        TaskScheduler::TaskId dependency )
+    {
+        ++mNumTasks;
+
+        if( lastLevel - firstLevel == 1u )
+        {
+            // Not worth the indirection
+            UpdateTransformTask &task = mLevels[firstLevel];
+            return taskScheduler->submit( &task, 1u, &dependency, 1u );
+        }
+
+        mMergedLevels.push_back(
+            UpdateTransformLevelsTask( &mLevels[firstLevel], lastLevel - firstLevel ) );
+        UpdateTransformLevelsTask &task = mMergedLevels.back();
+        return taskScheduler->submit( &task, 1u, &dependency, 1u );
+    }
+    //-----------------------------------------------------------------------
+    size_t TransformUpdateScheduler::execute( TaskScheduler *taskScheduler )
+    {
+        mNumTasks = 0;
+
+        mNumUpdatedPerThread.resize( taskScheduler->getNumThreads() );
+        std::fill( mNumUpdatedPerThread.begin(), mNumUpdatedPerThread.end(), 0u );
+
+        // The merged tasks must not move in memory while they run
+        mMergedLevels.clear();
+        mMergedLevels.reserve( mLevels.size() );
+
+        TaskScheduler::TaskId lastTaskId = TaskScheduler::FinishedTask;
+
+        // [firstNarrowLevel; i) are narrow levels waiting to be merged
+        size_t firstNarrowLevel = 0;
+
+        const size_t numLevels = mLevels.size();
+        for( size_t i = 0; i < numLevels; ++i )
+        {
+            UpdateTransformTask &task = mLevels[i];
+            task.numUpdatedPerThread = mNumUpdatedPerThread.begin();
+
+            const size_t numChunks = task.request.getNumChunks();
+            if( numChunks > 1u || mScheduling == SchedulingPerLevel )
+            {
+                if( firstNarrowLevel != i )
+                {
+                    lastTaskId =
+                        submitMergedLevels( taskScheduler, firstNarrowLevel, i, lastTaskId );
+                }
+
+                // We need to go depth by depth because we depend on the parents.
+                // Managers go one after the other too (dynamic children can have static
+                // parents). But there is no need to return to the main thread in between.
+                lastTaskId = taskScheduler->submit( &task, numChunks, &lastTaskId, 1u );
+                ++mNumTasks;
+                firstNarrowLevel = i + 1u;
+            }
+        }
+
+        if( firstNarrowLevel != numLevels )
+            lastTaskId = submitMergedLevels( taskScheduler, firstNarrowLevel, numLevels, lastTaskId );
+
+        taskScheduler->wait( lastTaskId );
+
+        mLevels.clear();
+
+        size_t numUpdated = 0;
+        FastArray<size_t>::const_iterator itor = mNumUpdatedPerThread.begin();
+        FastArray<size_t>::const_iterator endt = mNumUpdatedPerThread.end();
+        while( itor != endt )
+            numUpdated += *itor++;
+
+        return numUpdated;
+    }
+}  // namespace Ogre
@@ -0,0 +1,383 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Threading/OgreTaskScheduler.h"
+
+#include "Threading/OgreUniformScalableTask.h"
+
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL_OFFLINE
+#    include "OgreLwString.h"
+#    include "OgreProfiler.h"
+#endif
+
+namespace Ogre
+{
+    const TaskScheduler::TaskId TaskScheduler::FinishedTask = ~static_cast<TaskScheduler::TaskId>( 0u );
+
+    Task::~Task() {}
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskRecord::TaskRecord() :
+        task( 0 ),
+        uniformTask( 0 ),
+        generation( 0 ),
+        numChunks( 0 ),
+        remainingChunks( 0 ),
+        pendingDependencies( 0 )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    unsigned long taskSchedulerWorkerThread( ThreadHandle *threadHandle )
+    {
+        TaskScheduler *taskScheduler = reinterpret_cast<TaskScheduler *>( threadHandle->getUserParam() );
+        return taskScheduler->_workerThread( threadHandle );
+    }
+    THREAD_DECLARE( taskSchedulerWorkerThread );
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskScheduler( size_t numWorkerThreads ) :
+        mNumWorkerThreads( numWorkerThreads ),
+        mWorkers( 0 ),
+        mExitThreads( false ),
+        mNumActiveTasks( 0 )
+    {
+        if( mNumWorkerThreads > 0u )
+        {
+            mWorkers = new Worker[mNumWorkerThreads];
+            mThreads.reserve( mNumWorkerThreads );
+            for( size_t i = 0; i < mNumWorkerThreads; ++i )
+            {
+                ThreadHandlePtr th =
+                    Threads::CreateThread( THREAD_GET( taskSchedulerWorkerThread ), i, this );
+                mThreads.push_back( th );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::~TaskScheduler()
+    {
+        if( mNumWorkerThreads > 0u )
+        {
+            waitForAll();
+
+            mExitThreads = true;
+            for( size_t i = 0; i < mNumWorkerThreads; ++i )
+                mWorkers[i].wakeUpEvent.wake();
+
+            Threads::WaitForThreads( mThreads );
+            mThreads.clear();
+
+            delete[] mWorkers;
+            mWorkers = 0;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool TaskScheduler::isFinished( TaskId taskId ) const
+    {
+        const size_t taskIdx = static_cast<size_t>( taskId & 0xFFFFFFFFu );
+        const uint32 generation = static_cast<uint32>( taskId >> 32u );
+        return taskIdx >= mTasks.size() || mTasks[taskIdx].generation != generation;
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::WorkItem TaskScheduler::getReadyTask( uint32 taskIdx ) const
+    {
+        const TaskRecord &record = mTasks[taskIdx];
+        WorkItem retVal;
+        retVal.task = record.task;
+        retVal.uniformTask = record.uniformTask;
+        retVal.taskIdx = taskIdx;
+        retVal.chunkIdx = 0u;
+        retVal.numChunks = record.numChunks;
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskId TaskScheduler::submitImpl( Task *task, UniformScalableTask *uniformTask,
+                                                     size_t numChunks, const TaskId *dependencies,
+                                                     size_t numDependencies )
+    {
+        assert( numChunks < 0xFFFFFFFFu );
+
+        if( mNumWorkerThreads == 0u )
+        {
+            // Everything runs synchronously, thus the dependencies have already finished
+            for( size_t i = 0; i < numChunks; ++i )
+            {
+                if( uniformTask )
+                    uniformTask->execute( i, numChunks );
+                else
+                    task->execute( i, 0u );
+            }
+            return FinishedTask;
+        }
+
+        FastArray<WorkItem> readyTasks;
+        TaskId retVal;
+
+        {
+            ScopedLock lock( mTasksMutex );
+
+            uint32 taskIdx;
+            if( mFreeTasks.empty() )
+            {
+                taskIdx = static_cast<uint32>( mTasks.size() );
+                mTasks.push_back( TaskRecord() );
+            }
+            else
+            {
+                taskIdx = mFreeTasks.back();
+                mFreeTasks.pop_back();
+            }
+
+            TaskRecord &record = mTasks[taskIdx];
+            record.task = task;
+            record.uniformTask = uniformTask;
+            record.numChunks = static_cast<uint32>( numChunks );
+            record.remainingChunks = static_cast<uint32>( numChunks );
+            record.pendingDependencies = 0u;
+
+            for( size_t i = 0; i < numDependencies; ++i )
+            {
+                if( !isFinished( dependencies[i] ) )
+                {
+                    const size_t dependencyIdx = static_cast<size_t>( dependencies[i] & 0xFFFFFFFFu );
+                    mTasks[dependencyIdx].dependents.push_back( taskIdx );
+                    ++record.pendingDependencies;
+                }
+            }
+
+            ++mNumActiveTasks;
+            retVal = ( static_cast<TaskId>( record.generation ) << 32u ) | taskIdx;
+
+            if( record.pendingDependencies == 0u )
+                readyTasks.push_back( getReadyTask( taskIdx ) );
+        }
+
+        startTasks( readyTasks );
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskId TaskScheduler::submit( Task *task, size_t numChunks,
+                                                 const TaskId *dependencies, size_t numDependencies )
+    {
+        return submitImpl( task, 0, numChunks, dependencies, numDependencies );
+    }
+    //-----------------------------------------------------------------------------------
+    TaskScheduler::TaskId TaskScheduler::submit( UniformScalableTask *task, const TaskId *dependencies,
+                                                 size_t numDependencies )
+    {
+        return submitImpl( 0, task, getNumThreads(), dependencies, numDependencies );
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::finishTask( uint32 taskIdx, FastArray<WorkItem> &outReadyTasks )
+    {
+        TaskRecord &record = mTasks[taskIdx];
+
+        FastArray<uint32>::const_iterator itor = record.dependents.begin();
+        FastArray<uint32>::const_iterator endt = record.dependents.end();
+
+        while( itor != endt )
+        {
+            TaskRecord &dependent = mTasks[*itor];
+            assert( dependent.pendingDependencies > 0u );
+            if( --dependent.pendingDependencies == 0u )
+                outReadyTasks.push_back( getReadyTask( *itor ) );
+            ++itor;
+        }
+
+        record.dependents.clear();
+        record.task = 0;
+        record.uniformTask = 0;
+        ++record.generation;
+        mFreeTasks.push_back( taskIdx );
+        --mNumActiveTasks;
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::startTasks( FastArray<WorkItem> &readyTasks )
+    {
+        bool wakeUpWorkers = false;
+
+        while( !readyTasks.empty() )
+        {
+            WorkItem workItem = readyTasks.back();
+            readyTasks.pop_back();
+
+            if( workItem.numChunks == 0u )
+            {
+                {
+                    ScopedLock lock( mTasksMutex );
+                    finishTask( workItem.taskIdx, readyTasks );
+                }
+                mTaskFinishedEvent.wake();
+                continue;
+            }
+
+            // Give each worker a contiguous block of chunks so they walk the data in order.
+            // Rotate the first worker so that small tasks don't always land on the same thread.
+            const size_t numChunks = workItem.numChunks;
+            const size_t numWorkers = std::min( numChunks, mNumWorkerThreads );
+            size_t chunkIdx = 0u;
+            for( size_t i = 0; i < numWorkers; ++i )
+            {
+                const size_t chunkEnd = ( numChunks * ( i + 1u ) ) / numWorkers;
+                Worker &worker = mWorkers[( workItem.taskIdx + i ) % mNumWorkerThreads];
+
+                ScopedLock lock( worker.mutex );
+                while( chunkIdx < chunkEnd )
+                {
+                    workItem.chunkIdx = static_cast<uint32>( chunkIdx );
+                    worker.workItems.push_back( workItem );
+                    ++chunkIdx;
+                }
+            }
+
+            wakeUpWorkers = true;
+        }
+
+        // Wake everyone, idle workers will steal from the busy ones
+        if( wakeUpWorkers )
+        {
+            for( size_t i = 0; i < mNumWorkerThreads; ++i )
+                mWorkers[i].wakeUpEvent.wake();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool TaskScheduler::grabWorkItem( size_t threadIdx, WorkItem &outWorkItem )
+    {
+        {
+            Worker &worker = mWorkers[threadIdx];
+            ScopedLock lock( worker.mutex );
+            if( !worker.workItems.empty() )
+            {
+                outWorkItem = worker.workItems.front();
+                worker.workItems.pop_front();
+                return true;
+            }
+        }
+
+        for( size_t i = 1u; i < mNumWorkerThreads; ++i )
+        {
+            // Steal from the back, where the owner will get last
+            Worker &victim = mWorkers[( threadIdx + i ) % mNumWorkerThreads];
+            ScopedLock lock( victim.mutex );
+            if( !victim.workItems.empty() )
+            {
+                outWorkItem = victim.workItems.back();
+                victim.workItems.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::executeWorkItem( const WorkItem &workItem, size_t threadIdx )
+    {
+        if( workItem.uniformTask )
+            workItem.uniformTask->execute( workItem.chunkIdx, workItem.numChunks );
+        else
+            workItem.task->execute( workItem.chunkIdx, threadIdx );
+
+        FastArray<WorkItem> readyTasks;
+        bool taskFinished = false;
+
+        {
+            ScopedLock lock( mTasksMutex );
+            TaskRecord &record = mTasks[workItem.taskIdx];
+            assert( record.remainingChunks > 0u );
+            if( --record.remainingChunks == 0u )
+            {
+                finishTask( workItem.taskIdx, readyTasks );
+                taskFinished = true;
+            }
+        }
+
+        if( taskFinished )
+        {
+            mTaskFinishedEvent.wake();
+            startTasks( readyTasks );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::wait( TaskId taskId )
+    {
+        mTasksMutex.lock();
+        while( !isFinished( taskId ) )
+        {
+            mTasksMutex.unlock();
+            mTaskFinishedEvent.wait();
+            mTasksMutex.lock();
+        }
+        mTasksMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
+    bool TaskScheduler::isTaskFinished( TaskId taskId )
+    {
+        ScopedLock lock( mTasksMutex );
+        return isFinished( taskId );
+    }
+    //-----------------------------------------------------------------------------------
+    void TaskScheduler::waitForAll()
+    {
+        mTasksMutex.lock();
+        while( mNumActiveTasks != 0u )
+        {
+            mTasksMutex.unlock();
+            mTaskFinishedEvent.wait();
+            mTasksMutex.lock();
+        }
+        mTasksMutex.unlock();
+    }
+    //-----------------------------------------------------------------------------------
+    unsigned long TaskScheduler::_workerThread( ThreadHandle *threadHandle )
+    {
+        const size_t threadIdx = threadHandle->getThreadIdx();
+
+#if OGRE_PROFILING == OGRE_PROFILING_INTERNAL_OFFLINE
+        if( Profiler::getSingletonPtr() )
+        {
+            char tmpBuffer[32];
+            LwString threadName( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+            threadName.a( "Worker ", (uint32)threadIdx );
+            Profiler::getSingleton().getOfflineProfiler().setCurrentThreadName( threadName.c_str() );
+        }
+#endif
+
+        while( !mExitThreads )
+        {
+            WorkItem workItem;
+            if( grabWorkItem( threadIdx, workItem ) )
+                executeWorkItem( workItem, threadIdx );
+            else
+                mWorkers[threadIdx].wakeUpEvent.wait();
+        }
+
+        return 0;
+    }
+}  // namespace Ogre
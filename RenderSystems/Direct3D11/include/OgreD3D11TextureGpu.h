@@ -93,6 +93,8 @@ namespace Ogre
         void notifyDataIsReady() override;
         bool _isDataReadyImpl() const override;
 
+        void _notifyMostDetailedMipReady( uint8 mipLevel ) override;
+
         void setTextureType( TextureTypes::TextureTypes textureType ) override;
 
         void copyTo(
@@ -390,6 +390,34 @@ namespace Ogre
         notifyAllListenersTextureChanged( TextureGpuListener::ReadyForRendering );
     }
     //-----------------------------------------------------------------------------------
+    void D3D11TextureGpu::_notifyMostDetailedMipReady( uint8 mipLevel )
+    {
+        assert( mResidencyStatus == GpuResidency::Resident );
+        assert( !hasAutomaticBatching() );
+
+        // Prevent sampling from the mips that aren't uploaded yet
+        D3D11TextureGpuManager *textureManagerD3d =
+            static_cast<D3D11TextureGpuManager *>( mTextureManager );
+        D3D11Device &device = textureManagerD3d->getDevice();
+        device.GetImmediateContext()->SetResourceMinLOD( mFinalTextureName.Get(),
+                                                         static_cast<float>( mipLevel ) );
+
+        if( mDisplayTextureName != mFinalTextureName.Get() )
+        {
+            mDefaultDisplaySrv.Reset();
+
+            mDisplayTextureName = mFinalTextureName.Get();
+            if( isTexture() )
+            {
+                DescriptorSetTexture2::TextureSlot texSlot(
+                    DescriptorSetTexture2::TextureSlot::makeEmpty() );
+                mDefaultDisplaySrv = createSrv( texSlot );
+            }
+
+            notifyAllListenersTextureChanged( TextureGpuListener::PartiallyReadyForRendering );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     bool D3D11TextureGpu::_isDataReadyImpl() const
     {
         return mDisplayTextureName == mFinalTextureName.Get() && mDataPreparationsPending == 0u;
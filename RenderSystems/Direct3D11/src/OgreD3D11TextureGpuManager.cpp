@@ -48,6 +48,7 @@ namespace Ogre
         TextureGpuManager( vaoManager, renderSystem ),
         mDevice( device )
     {
+        mSupportsProgressiveStreaming = true;
         _createD3DResources();
     }
     //-----------------------------------------------------------------------------------
@@ -102,6 +102,8 @@ namespace Ogre
         void notifyDataIsReady() override;
         bool _isDataReadyImpl() const override;
 
+        void _notifyMostDetailedMipReady( uint8 mipLevel ) override;
+
         void _setToDisplayDummyTexture() override;
         void _notifyTextureSlotChanged( const TexturePool *newPool, uint16 slice ) override;
 
@@ -54,6 +54,9 @@ namespace Ogre
 
         const GL3PlusSupport &mSupport;
 
+        /// GL 4.5 or GL_ARB_direct_state_access. See hasDirectStateAccess
+        bool mHasDirectStateAccess;
+
         TextureGpu     *createTextureImpl( GpuPageOutStrategy::GpuPageOutStrategy pageOutStrategy,
                                            IdString name, uint32 textureFlags,
                                            TextureTypes::TextureTypes initialType ) override;
@@ -88,6 +91,10 @@ namespace Ogre
 
         const GL3PlusSupport &getGlSupport() const { return mSupport; }
 
+        /// When true, texture parameters can be changed without binding the texture
+        /// (e.g. glTextureParameteri). Binding it would overwrite what the RenderSystem bound.
+        bool hasDirectStateAccess() const { return mHasDirectStateAccess; }
+
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
         virtual bool checkSupport( PixelFormatGpu format, TextureTypes::TextureTypes textureType,
                                    uint32 textureFlags ) const;
@@ -252,6 +252,58 @@ namespace Ogre
         notifyAllListenersTextureChanged( TextureGpuListener::ReadyForRendering );
     }
     //-----------------------------------------------------------------------------------
+    /// Returns the glGetIntegerv query for the texture bound to the given target
+    static GLenum getTextureBindingQuery( GLenum target )
+    {
+        switch( target )
+        {
+        case GL_TEXTURE_1D:
+            return GL_TEXTURE_BINDING_1D;
+        case GL_TEXTURE_1D_ARRAY:
+            return GL_TEXTURE_BINDING_1D_ARRAY;
+        case GL_TEXTURE_2D_ARRAY:
+            return GL_TEXTURE_BINDING_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP:
+            return GL_TEXTURE_BINDING_CUBE_MAP;
+        case GL_TEXTURE_CUBE_MAP_ARRAY:
+            return GL_TEXTURE_BINDING_CUBE_MAP_ARRAY;
+        case GL_TEXTURE_3D:
+            return GL_TEXTURE_BINDING_3D;
+        case GL_TEXTURE_2D:
+        default:
+            return GL_TEXTURE_BINDING_2D;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void GL3PlusTextureGpu::_notifyMostDetailedMipReady( uint8 mipLevel )
+    {
+        assert( mResidencyStatus == GpuResidency::Resident );
+        assert( !hasAutomaticBatching() );
+
+        // Prevent sampling from the mips that aren't uploaded yet. This may happen in the
+        // middle of rendering: the texture that the RenderSystem bound must stay bound.
+        GL3PlusTextureGpuManager *textureManagerGl =
+            static_cast<GL3PlusTextureGpuManager *>( mTextureManager );
+        if( textureManagerGl->hasDirectStateAccess() )
+        {
+            OCGE( glTextureParameteri( mFinalTextureName, GL_TEXTURE_BASE_LEVEL, mipLevel ) );
+        }
+        else
+        {
+            GLint prevTextureName = 0;
+            OCGE( glGetIntegerv( getTextureBindingQuery( mGlTextureTarget ), &prevTextureName ) );
+            OCGE( glBindTexture( mGlTextureTarget, mFinalTextureName ) );
+            OCGE( glTexParameteri( mGlTextureTarget, GL_TEXTURE_BASE_LEVEL, mipLevel ) );
+            OCGE( glBindTexture( mGlTextureTarget, static_cast<GLuint>( prevTextureName ) ) );
+        }
+
+        if( mDisplayTextureName != mFinalTextureName )
+        {
+            mDisplayTextureName = mFinalTextureName;
+            notifyAllListenersTextureChanged( TextureGpuListener::PartiallyReadyForRendering );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     bool GL3PlusTextureGpu::_isDataReadyImpl() const
     {
         return mDisplayTextureName == mFinalTextureName && mDataPreparationsPending == 0u;
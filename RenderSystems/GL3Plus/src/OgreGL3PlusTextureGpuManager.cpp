@@ -47,8 +47,12 @@ namespace Ogre
                                                         RenderSystem *renderSystem,
                                                         const GL3PlusSupport &support ) :
         TextureGpuManager( vaoManager, renderSystem ),
-        mSupport( support )
+        mSupport( support ),
+        mHasDirectStateAccess( support.hasMinGLVersion( 4, 5 ) ||
+                               support.checkExtension( "GL_ARB_direct_state_access" ) )
     {
+        mSupportsProgressiveStreaming = true;
+
         memset( mBlankTexture, 0, sizeof( mBlankTexture ) );
         memset( mTmpFbo, 0, sizeof( mTmpFbo ) );
 
@@ -47,6 +47,10 @@ namespace Ogre
     class _OgreNULLExport NULLTextureGpu : public TextureGpu
     {
     protected:
+        /// Mips [mMostDetailedMipReady; mNumMipmaps) have been uploaded.
+        /// See _notifyMostDetailedMipReady
+        uint8 mMostDetailedMipReady;
+
         void createInternalResourcesImpl() override;
         void destroyInternalResourcesImpl() override;
 
@@ -58,6 +62,11 @@ namespace Ogre
 
         void getSubsampleLocations( vector<Vector2>::type locations ) override;
         void notifyDataIsReady() override;
+        void _notifyMostDetailedMipReady( uint8 mipLevel ) override;
+
+        /// Lets tests follow progressive streaming, which NULL only pretends to do.
+        /// Equals getNumMipmaps() while nothing can be displayed.
+        uint8 getMostDetailedMipReady() const { return mMostDetailedMipReady; }
 
         void _autogenerateMipmaps( CopyEncTransitionMode::CopyEncTransitionMode transitionMode =
                                        CopyEncTransitionMode::Auto ) override;
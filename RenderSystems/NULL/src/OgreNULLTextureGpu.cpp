@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "OgreNULLTextureGpu.h"
 
 #include "OgreException.h"
+#include "OgreTextureGpuListener.h"
 #include "OgreVector2.h"
 
 namespace Ogre
@@ -37,13 +38,14 @@ namespace Ogre
                                     VaoManager *vaoManager, IdString name, uint32 textureFlags,
                                     TextureTypes::TextureTypes initialType,
                                     TextureGpuManager *textureManager ) :
-        TextureGpu( pageOutStrategy, vaoManager, name, textureFlags, initialType, textureManager )
+        TextureGpu( pageOutStrategy, vaoManager, name, textureFlags, initialType, textureManager ),
+        mMostDetailedMipReady( 0u )
     {
     }
     //-----------------------------------------------------------------------------------
     NULLTextureGpu::~NULLTextureGpu() {}
     //-----------------------------------------------------------------------------------
-    void NULLTextureGpu::createInternalResourcesImpl() {}
+    void NULLTextureGpu::createInternalResourcesImpl() { mMostDetailedMipReady = mNumMipmaps; }
     //-----------------------------------------------------------------------------------
     void NULLTextureGpu::destroyInternalResourcesImpl() {}
     //-----------------------------------------------------------------------------------
@@ -60,6 +62,22 @@ namespace Ogre
                          "Calling notifyDataIsReady too often! Remove this call"
                          "See https://github.com/OGRECave/ogre-next/issues/101" );
         --mDataPreparationsPending;
+
+        mMostDetailedMipReady = 0u;
+
+        notifyAllListenersTextureChanged( TextureGpuListener::ReadyForRendering );
+    }
+    //-----------------------------------------------------------------------------------
+    void NULLTextureGpu::_notifyMostDetailedMipReady( uint8 mipLevel )
+    {
+        OGRE_ASSERT_LOW( mResidencyStatus == GpuResidency::Resident );
+        OGRE_ASSERT_LOW( mipLevel < mMostDetailedMipReady );
+
+        const bool wasDisplayed = mMostDetailedMipReady < mNumMipmaps;
+        mMostDetailedMipReady = mipLevel;
+
+        if( !wasDisplayed )
+            notifyAllListenersTextureChanged( TextureGpuListener::PartiallyReadyForRendering );
     }
     //-----------------------------------------------------------------------------------
     void NULLTextureGpu::_autogenerateMipmaps( CopyEncTransitionMode::CopyEncTransitionMode
@@ -41,6 +41,7 @@ namespace Ogre
     NULLTextureGpuManager::NULLTextureGpuManager( VaoManager *vaoManager, RenderSystem *renderSystem ) :
         TextureGpuManager( vaoManager, renderSystem )
     {
+        mSupportsProgressiveStreaming = true;
     }
     //-----------------------------------------------------------------------------------
     NULLTextureGpuManager::~NULLTextureGpuManager() { destroyAll(); }
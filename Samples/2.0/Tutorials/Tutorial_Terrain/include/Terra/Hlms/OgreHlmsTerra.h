@@ -109,6 +109,14 @@ namespace Ogre
                                  bool casterPass, uint32 lastCacheHash,
                                  CommandBuffer *commandBuffer ) override;
 
+        /// Terra doesn't support parallel command generation. Don't inherit HlmsPbs'
+        uint32 _fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass,
+                                       uint32 lastCacheHash, CommandBuffer *commandBuffer ) override
+        {
+            return c_retryFillInRenderThread;
+        }
+
         static void getDefaultPaths( String &outDataFolderPath, StringVector &outLibraryFoldersPaths );
 
 #if !OGRE_NO_JSON
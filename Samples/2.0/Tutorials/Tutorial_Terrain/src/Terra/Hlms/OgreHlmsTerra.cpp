@@ -566,20 +566,22 @@ namespace Ogre
                 }
             }
 
-            mLastDescTexture = 0;
-            mLastDescSampler = 0;
+            mMainState.lastDescTexture = 0;
+            mMainState.lastDescSampler = 0;
             mLastMovableObject = 0;
-            mLastBoundPool = 0;
+            mMainState.lastBoundPool = 0;
 
             // layout(binding = 2) uniform InstanceBuffer {} instance
-            if( mCurrentConstBuffer < mConstBuffers.size() &&
-                (size_t)( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) + 4 ) <=
-                    mCurrentConstBufferSize )
+            if( mMainState.currentConstBuffer < mConstBuffers.size() &&
+                (size_t)( ( mMainState.currentMappedConstBuffer -
+                            mMainState.startMappedConstBuffer ) +
+                          4 ) <= mMainState.currentConstBufferSize )
             {
+                ConstBufferPacked *constBuffer = mConstBuffers[mMainState.currentConstBuffer];
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( VertexShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( VertexShader, 2, constBuffer, 0, 0 );
                 *commandBuffer->addCommand<CbShaderBuffer>() =
-                    CbShaderBuffer( PixelShader, 2, mConstBuffers[mCurrentConstBuffer], 0, 0 );
+                    CbShaderBuffer( PixelShader, 2, constBuffer, 0, 0 );
             }
 
             // rebindTexBuffer( commandBuffer );
@@ -592,7 +594,7 @@ namespace Ogre
 
         // Don't bind the material buffer on caster passes (important to keep
         // MDI & auto-instancing running on shadow map passes)
-        if( mLastBoundPool != datablock->getAssignedPool() )
+        if( mMainState.lastBoundPool != datablock->getAssignedPool() )
         {
             // layout(binding = 1) uniform MaterialBuf {} materialArray
             const ConstBufferPool::BufferPool *newPool = datablock->getAssignedPool();
@@ -602,7 +604,7 @@ namespace Ogre
             *commandBuffer->addCommand<CbShaderBuffer>() =
                 CbShaderBuffer( PixelShader, 1, newPool->materialBuffer, 0,
                                 (uint32)newPool->materialBuffer->getTotalSizeBytes() );
-            mLastBoundPool = newPool;
+            mMainState.lastBoundPool = newPool;
         }
 
         if( mLastMovableObject != queuedRenderable.movableObject )
@@ -626,15 +628,16 @@ namespace Ogre
             mLastMovableObject = queuedRenderable.movableObject;
         }
 
-        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mCurrentMappedConstBuffer;
+        uint32 *RESTRICT_ALIAS currentMappedConstBuffer = mMainState.currentMappedConstBuffer;
 
         //---------------------------------------------------------------------------
         //                          ---- VERTEX SHADER ----
         //---------------------------------------------------------------------------
         // We need to correct currentMappedConstBuffer to point to the right texture buffer's
         // offset, which may not be in sync if the previous draw had skeletal animation.
-        bool exceedsConstBuffer = (size_t)( ( currentMappedConstBuffer - mStartMappedConstBuffer ) +
-                                            12 ) > mCurrentConstBufferSize;
+        bool exceedsConstBuffer =
+            (size_t)( ( currentMappedConstBuffer - mMainState.startMappedConstBuffer ) + 12 ) >
+            mMainState.currentConstBufferSize;
 
         if( exceedsConstBuffer )
             currentMappedConstBuffer = mapNextConstBuffer( commandBuffer );
@@ -661,7 +664,7 @@ namespace Ogre
                 mLastBoundPlanarReflection = queuedRenderable.renderable->mCustomParameter;
             }
 #endif
-            if( datablock->mTexturesDescSet != mLastDescTexture )
+            if( datablock->mTexturesDescSet != mMainState.lastDescTexture )
             {
                 if( datablock->mTexturesDescSet )
                 {
@@ -680,10 +683,10 @@ namespace Ogre
                     // texUnit += datablock->mTexturesDescSet->mTextures.size();
                 }
 
-                mLastDescTexture = datablock->mTexturesDescSet;
+                mMainState.lastDescTexture = datablock->mTexturesDescSet;
             }
 
-            if( datablock->mSamplersDescSet != mLastDescSampler && mHasSeparateSamplers )
+            if( datablock->mSamplersDescSet != mMainState.lastDescSampler && mHasSeparateSamplers )
             {
                 if( datablock->mSamplersDescSet )
                 {
@@ -691,14 +694,16 @@ namespace Ogre
                     size_t texUnit = mTexUnitSlotStart;
                     *commandBuffer->addCommand<CbSamplers>() =
                         CbSamplers( (uint16)texUnit, datablock->mSamplersDescSet );
-                    mLastDescSampler = datablock->mSamplersDescSet;
+                    mMainState.lastDescSampler = datablock->mSamplersDescSet;
                 }
             }
         }
 
-        mCurrentMappedConstBuffer = currentMappedConstBuffer;
+        mMainState.currentMappedConstBuffer = currentMappedConstBuffer;
 
-        return uint32( ( ( mCurrentMappedConstBuffer - mStartMappedConstBuffer ) >> 4u ) - 1u );
+        return uint32(
+            ( ( mMainState.currentMappedConstBuffer - mMainState.startMappedConstBuffer ) >> 4u ) -
+            1u );
     }
     //-----------------------------------------------------------------------------------
     void HlmsTerra::getDefaultPaths( String &outDataFolderPath, StringVector &outLibraryFoldersPaths )
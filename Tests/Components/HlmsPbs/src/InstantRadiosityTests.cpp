@@ -0,0 +1,296 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "InstantRadiosityTests.h"
+#include "InstantRadiosity/OgreInstantRadiosity.h"
+#include "OgreMatrix4.h"
+#include "OgreNULLPlugin.h"
+#include "OgreRay.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+
+#include "UnitTestSuite.h"
+
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(InstantRadiosityTests);
+
+namespace
+{
+    Real randomReal( Real minValue, Real maxValue )
+    {
+        return minValue + ( maxValue - minValue ) * Real( rand() ) / Real( RAND_MAX );
+    }
+
+    /// Raycasts with the BVH and with the brute force loop, and checks that every ray
+    /// hit the same triangle at the same distance. Returns the number of rays that hit.
+    /// Without a SceneManager the BVH is raycast in this thread, otherwise the rays are
+    /// split across its worker threads.
+    size_t compareRaycasts( SceneManager *sceneManager, const std::vector<float> &positions,
+                            const void *indexData, size_t numIndices, bool useIndices16bit,
+                            const Matrix4 &worldMatrix, const std::vector<Ray> &rays )
+    {
+        const Real maxDistance = 1000.0f;
+        const size_t numVertices = positions.size() / 3u;
+
+        InstantRadiosity instantRadiosity( sceneManager, 0 );
+
+        std::vector<Real> bvhDistances( rays.size() );
+        std::vector<Vector3> bvhTriVerts( rays.size() * 3u, Vector3::ZERO );
+        instantRadiosity.setDeterministicRaycast( false );
+        instantRadiosity._raycastMesh( &positions[0], numVertices, indexData, numIndices,
+                                       useIndices16bit, worldMatrix, &rays[0], rays.size(),
+                                       maxDistance, &bvhDistances[0], &bvhTriVerts[0] );
+
+        std::vector<Real> refDistances( rays.size() );
+        std::vector<Vector3> refTriVerts( rays.size() * 3u, Vector3::ZERO );
+        instantRadiosity.setDeterministicRaycast( true );
+        instantRadiosity._raycastMesh( &positions[0], numVertices, indexData, numIndices,
+                                       useIndices16bit, worldMatrix, &rays[0], rays.size(),
+                                       maxDistance, &refDistances[0], &refTriVerts[0] );
+
+        size_t numHits = 0u;
+        for( size_t i = 0; i < rays.size(); ++i )
+        {
+            // Bit-identical, not just close
+            CPPUNIT_ASSERT_EQUAL( refDistances[i], bvhDistances[i] );
+            for( size_t j = 0; j < 3u; ++j )
+                CPPUNIT_ASSERT( refTriVerts[i * 3u + j] == bvhTriVerts[i * 3u + j] );
+            if( refDistances[i] < maxDistance )
+                ++numHits;
+        }
+
+        return numHits;
+    }
+
+    /// Overlapping triangles of all sizes, so the BVH nodes overlap too. The rays come from
+    /// outside towards the middle, from all directions: more than one packet and a number
+    /// that isn't a multiple of the packet size.
+    void generateRandomTriangles( std::vector<float> &outPositions, std::vector<uint32> &outIndices,
+                                  std::vector<Ray> &outRays )
+    {
+        const size_t numTriangles = 5000u;
+        for( size_t i = 0; i < numTriangles; ++i )
+        {
+            const Vector3 centre( randomReal( -10, 10 ), randomReal( -10, 10 ), randomReal( -10, 10 ) );
+            const Real size = randomReal( 0.05f, 2.0f );
+            for( size_t j = 0; j < 3u; ++j )
+            {
+                outIndices.push_back( static_cast<uint32>( outPositions.size() / 3u ) );
+                outPositions.push_back( centre.x + randomReal( -size, size ) );
+                outPositions.push_back( centre.y + randomReal( -size, size ) );
+                outPositions.push_back( centre.z + randomReal( -size, size ) );
+            }
+        }
+
+        for( size_t i = 0; i < 997u; ++i )
+        {
+            Vector3 origin( randomReal( -1, 1 ), randomReal( -1, 1 ), randomReal( -1, 1 ) );
+            origin.normalise();
+            origin *= 30.0f;
+            const Vector3 target( randomReal( -8, 8 ), randomReal( -8, 8 ), randomReal( -8, 8 ) );
+            outRays.push_back( Ray( origin, ( target - origin ).normalisedCopy() ) );
+        }
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup( __FUNCTION__ );
+    srand( 0 );
+}
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::tearDown() {}
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::testRandomTriangles()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod( __FUNCTION__ );
+
+    std::vector<float> positions;
+    std::vector<uint32> indices;
+    std::vector<Ray> rays;
+    generateRandomTriangles( positions, indices, rays );
+
+    const size_t numHits =
+        compareRaycasts( 0, positions, &indices[0], indices.size(), false, Matrix4::IDENTITY, rays );
+    CPPUNIT_ASSERT( numHits > rays.size() / 2u );
+}
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::testGridThroughVertices()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod( __FUNCTION__ );
+
+    // Flat grid on the XZ plane, 16-bit indices. Rays go straight through its vertices
+    // and edges, where several triangles are hit at the same distance.
+    const uint16 gridSize = 40u;
+    std::vector<float> positions;
+    for( uint16 z = 0; z <= gridSize; ++z )
+    {
+        for( uint16 x = 0; x <= gridSize; ++x )
+        {
+            positions.push_back( Real( x ) );
+            positions.push_back( 0.0f );
+            positions.push_back( Real( z ) );
+        }
+    }
+
+    std::vector<uint16> indices;
+    const uint16 rowSize = gridSize + 1u;
+    for( uint16 z = 0; z < gridSize; ++z )
+    {
+        for( uint16 x = 0; x < gridSize; ++x )
+        {
+            const uint16 i0 = static_cast<uint16>( z * rowSize + x );
+            const uint16 i1 = static_cast<uint16>( i0 + 1u );
+            const uint16 i2 = static_cast<uint16>( i0 + rowSize );
+            const uint16 i3 = static_cast<uint16>( i2 + 1u );
+            indices.push_back( i0 );
+            indices.push_back( i2 );
+            indices.push_back( i1 );
+            indices.push_back( i1 );
+            indices.push_back( i2 );
+            indices.push_back( i3 );
+        }
+    }
+
+    std::vector<Ray> rays;
+    for( uint16 z = 0; z <= gridSize; z += 3u )
+    {
+        for( uint16 x = 0; x <= gridSize; x += 2u )
+        {
+            // Through a vertex, and through the middle of an edge
+            rays.push_back( Ray( Vector3( Real( x ), 5.0f, Real( z ) ), Vector3::NEGATIVE_UNIT_Y ) );
+            rays.push_back(
+                Ray( Vector3( Real( x ) + 0.5f, 5.0f, Real( z ) ), Vector3::NEGATIVE_UNIT_Y ) );
+        }
+    }
+
+    // Slanted rays too
+    for( size_t i = 0; i < 200u; ++i )
+    {
+        const Vector3 origin( randomReal( 0, gridSize ), 10.0f, randomReal( 0, gridSize ) );
+        const Vector3 target( Real( rand() % gridSize ), 0.0f, Real( rand() % gridSize ) );
+        rays.push_back( Ray( origin, ( target - origin ).normalisedCopy() ) );
+    }
+
+    const size_t numHits =
+        compareRaycasts( 0, positions, &indices[0], indices.size(), true, Matrix4::IDENTITY, rays );
+    CPPUNIT_ASSERT( numHits > rays.size() / 2u );
+}
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::testTransformedNonIndexed()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod( __FUNCTION__ );
+
+    // A closed, double-sided, non-indexed box made of many small triangles, moved far from
+    // the origin, rotated and non-uniformly scaled. Rays shoot from inside, so each one hits.
+    const size_t tessellation = 12u;
+    std::vector<float> positions;
+    for( size_t face = 0; face < 6u; ++face )
+    {
+        const size_t axis = face / 2u;
+        const Real side = face % 2u ? 1.0f : -1.0f;
+        for( size_t v = 0; v < tessellation; ++v )
+        {
+            for( size_t u = 0; u < tessellation; ++u )
+            {
+                Vector3 corners[4];
+                for( size_t c = 0; c < 4u; ++c )
+                {
+                    const Real cu = ( Real( u + ( c & 1u ) ) / Real( tessellation ) ) * 2.0f - 1.0f;
+                    const Real cv = ( Real( v + ( c >> 1u ) ) / Real( tessellation ) ) * 2.0f - 1.0f;
+                    corners[c][axis] = side;
+                    corners[c][( axis + 1u ) % 3u] = cu;
+                    corners[c][( axis + 2u ) % 3u] = cv;
+                }
+
+                // Both windings, so it's hit from either side. The two triangles of each
+                // pair are hit at exactly the same distance, and the first one must win
+                const size_t triCorners[12] = { 0u, 1u, 2u, 2u, 1u, 3u, 0u, 2u, 1u, 2u, 3u, 1u };
+                for( size_t k = 0; k < 12u; ++k )
+                {
+                    positions.push_back( corners[triCorners[k]].x );
+                    positions.push_back( corners[triCorners[k]].y );
+                    positions.push_back( corners[triCorners[k]].z );
+                }
+            }
+        }
+    }
+
+    Matrix4 worldMatrix;
+    worldMatrix.makeTransform( Vector3( 150.0f, -30.0f, 75.0f ), Vector3( 3.0f, 0.5f, 7.0f ),
+                               Quaternion( Degree( 37.0f ), Vector3( 1.0f, 2.0f, 3.0f ).normalisedCopy() ) );
+
+    std::vector<Ray> rays;
+    for( size_t i = 0; i < 500u; ++i )
+    {
+        const Vector3 localOrigin( randomReal( -0.5f, 0.5f ), randomReal( -0.5f, 0.5f ),
+                                   randomReal( -0.5f, 0.5f ) );
+        Vector3 dir( randomReal( -1, 1 ), randomReal( -1, 1 ), randomReal( -1, 1 ) );
+        dir.normalise();
+        rays.push_back( Ray( worldMatrix * localOrigin, dir ) );
+    }
+
+    const size_t numHits = compareRaycasts( 0, positions, 0, 0u, false, worldMatrix, rays );
+    CPPUNIT_ASSERT_EQUAL( rays.size(), numHits );
+}
+//--------------------------------------------------------------------------
+void InstantRadiosityTests::testWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod( __FUNCTION__ );
+
+    // The BVH is raycast in InstantRadiosityRaycastTask, with each worker thread
+    // taking its own share of the rays (the last one ends in a partial packet).
+    // The SceneManager needs a RenderSystem
+    Root *root = OGRE_NEW Root( 0, "", "", "" );
+    NULLPlugin *nullPlugin = OGRE_NEW NULLPlugin();
+    root->installPlugin( nullPlugin );
+    root->setRenderSystem( root->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+    root->initialise( false );
+    root->createRenderWindow( "InstantRadiosityTests", 1u, 1u, false );
+    SceneManager *sceneManager = root->createSceneManager( ST_GENERIC, 4u );
+    CPPUNIT_ASSERT_EQUAL( size_t( 4u ), sceneManager->getNumWorkerThreads() );
+
+    std::vector<float> positions;
+    std::vector<uint32> indices;
+    std::vector<Ray> rays;
+    generateRandomTriangles( positions, indices, rays );
+
+    const size_t numHits = compareRaycasts( sceneManager, positions, &indices[0], indices.size(),
+                                            false, Matrix4::IDENTITY, rays );
+    CPPUNIT_ASSERT( numHits > rays.size() / 2u );
+
+    root->destroySceneManager( sceneManager );
+    OGRE_DELETE root;
+    OGRE_DELETE nullPlugin;
+}
+//--------------------------------------------------------------------------
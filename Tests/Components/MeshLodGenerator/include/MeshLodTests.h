@@ -46,6 +46,7 @@ class MeshLodTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testLodConfigSerializer);
     CPPUNIT_TEST(testMeshLodGenerator);
     CPPUNIT_TEST(testManualLodLevels);
+    CPPUNIT_TEST(testBatchLodGeneration);
     CPPUNIT_TEST_SUITE_END();
 
 #ifdef OGRE_STATIC_LIB
@@ -60,6 +61,7 @@ public:
     void testMeshLodGenerator();
     void testManualLodLevels();
     void testQuadricError();
+    void testBatchLodGeneration();
     void runMeshLodConfigTests(LodConfig::Advanced& advanced);
     void blockedWaitForLodGeneration(const MeshPtr& mesh);
     void addProfile(LodConfig& config);
@@ -18,6 +18,7 @@
 #include "OgreRenderWindow.h"
 #include "OgreLodConfigSerializer.h"
 #include "OgreWorkQueue.h"
+#include "OgreLogManager.h"
 
 #include "UnitTestSuite.h"
 
@@ -238,6 +239,79 @@ void MeshLodTests::testQuadricError()
     gen.generateLodLevels(config, LodCollapseCostPtr(new LodCollapseCostQuadric()));
 }
 //--------------------------------------------------------------------------
+/// Number of LOD levels, followed by the index count of every LOD of every submesh
+static std::vector<size_t> getLodIndexCounts(const MeshPtr& mesh)
+{
+    std::vector<size_t> lodIndexCounts;
+    lodIndexCounts.push_back(mesh->getNumLodLevels());
+    for (unsigned short i = 0; i < mesh->getNumSubMeshes(); i++)
+    {
+        const SubMesh::LODFaceList& lodFaceList = mesh->getSubMesh(i)->mLodFaceList[VpNormal];
+        for (size_t j = 0; j < lodFaceList.size(); j++)
+            lodIndexCounts.push_back(lodFaceList[j] ? lodFaceList[j]->indexCount : 0u);
+    }
+    return lodIndexCounts;
+}
+//--------------------------------------------------------------------------
+void MeshLodTests::testBatchLodGeneration()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const char* meshNames[] = { "ogrehead.mesh", "penguin.mesh", "athene.mesh" };
+    const size_t numMeshes = sizeof(meshNames) / sizeof(meshNames[0]) + 1u;
+
+    MeshLodGenerator& gen = MeshLodGenerator::getSingleton();
+    MeshLodGenerator::LodConfigList configs(numMeshes);
+    MeshLodGenerator::LodConfigList serialConfigs(numMeshes);
+    // serialConfigs share their meshes with configs, so record the serial results
+    // before the LODs are removed for the batch
+    std::vector<std::vector<size_t> > serialLodIndexCounts(numMeshes);
+    for (size_t i = 0; i < numMeshes; i++)
+    {
+        setTestLodConfig(configs[i]);
+        if (i > 0)
+        {
+            configs[i].mesh = MeshManager::getSingleton().load(
+                meshNames[i - 1], ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME);
+        }
+        serialConfigs[i] = configs[i];
+        gen.generateLodLevels(serialConfigs[i]);
+        serialLodIndexCounts[i] = getLodIndexCounts(serialConfigs[i].mesh);
+        CPPUNIT_ASSERT(serialLodIndexCounts[i][0] > 1u);
+
+        configs[i].mesh->removeLodLevels();
+        CPPUNIT_ASSERT(configs[i].mesh->getNumLodLevels() == 1u);
+    }
+
+    MeshLodGenerator::BatchStats stats = gen.generateLodLevelsBatch(configs);
+
+    // Reducing many meshes at once must give the same result as reducing them one by one
+    CPPUNIT_ASSERT(stats.numMeshes == numMeshes);
+    CPPUNIT_ASSERT(stats.numCollapsedTriangles > 0);
+    for (size_t i = 0; i < numMeshes; i++)
+    {
+        CPPUNIT_ASSERT(getLodIndexCounts(configs[i].mesh) == serialLodIndexCounts[i]);
+        CPPUNIT_ASSERT(configs[i].levels.size() == serialConfigs[i].levels.size());
+        for (size_t j = 0; j < configs[i].levels.size(); j++)
+        {
+            CPPUNIT_ASSERT(configs[i].levels[j].outSkipped == serialConfigs[i].levels[j].outSkipped);
+            CPPUNIT_ASSERT(configs[i].levels[j].outUniqueVertexCount ==
+                           serialConfigs[i].levels[j].outUniqueVertexCount);
+        }
+    }
+
+    const double seconds = static_cast<double>(std::max<uint64>(stats.reductionTimeUs, 1u)) / 1000000.0;
+    LogManager::getSingleton().logMessage(
+        "MeshLodTests::testBatchLodGeneration: " + StringConverter::toString(stats.numMeshes) +
+        " meshes, " + StringConverter::toString(stats.numCollapsedTriangles) +
+        " triangles collapsed in " + StringConverter::toString(stats.reductionTimeUs) + " us (" +
+        StringConverter::toString(Real(stats.numCollapsedTriangles / seconds)) +
+        " triangles/s). Total " + StringConverter::toString(stats.totalTimeUs) + " us");
+
+    for (size_t i = 1; i < numMeshes; i++)
+        configs[i].mesh->unload();
+}
+//--------------------------------------------------------------------------
 void MeshLodTests::setTestLodConfig(LodConfig& config)
 {
     config.mesh = mMesh;
@@ -0,0 +1,75 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __HlmsTemplateTests_H__
+#define __HlmsTemplateTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgreFileSystem.h"
+#include "OgreHlmsCommon.h"
+#include "OgreStringVector.h"
+
+/** Checks the compiled Hlms template path produces exactly the same shaders as the
+    text parser, and reports how many variants per second each path generates.
+    Also checks expanding variants from the worker threads matches expanding them serially.
+*/
+class HlmsTemplateTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(HlmsTemplateTests);
+    CPPUNIT_TEST(testPbsCompiledMatchesParser);
+    CPPUNIT_TEST(testUnlitCompiledMatchesParser);
+    CPPUNIT_TEST(testPbsParallelMatchesSerial);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    Ogre::String mMediaPath;
+
+    void openArchives( const Ogre::String &hlmsName, const Ogre::StringVector &libraryFolders,
+                       Ogre::vector<Ogre::FileSystemArchive *>::type &outArchives,
+                       Ogre::ArchiveVec &outLibraries );
+    void closeArchives( Ogre::vector<Ogre::FileSystemArchive *>::type &archives );
+    void generatePropertySets( const Ogre::vector<Ogre::FileSystemArchive *>::type &archives,
+                               size_t numVariants,
+                               Ogre::vector<Ogre::HlmsPropertyVec>::type &outPropertySets );
+
+    void runTemplates( const Ogre::String &hlmsName, const Ogre::StringVector &libraryFolders );
+    void runParallel( const Ogre::String &hlmsName, const Ogre::StringVector &libraryFolders );
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testPbsCompiledMatchesParser();
+    void testUnlitCompiledMatchesParser();
+    void testPbsParallelMatchesSerial();
+};
+
+#endif
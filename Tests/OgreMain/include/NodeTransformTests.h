@@ -0,0 +1,62 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __NodeTransformTests_H__
+#define __NodeTransformTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+/** Checks Node::updateDirtyTransforms gives the same results as Node::updateAllTransforms
+    while skipping the packs of nodes that didn't change, and that TransformUpdateScheduler
+    gives the same results regardless of how it schedules the depth levels.
+*/
+class NodeTransformTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(NodeTransformTests);
+    CPPUNIT_TEST(testMatchesFullUpdate);
+    CPPUNIT_TEST(testSkipsUnchangedNodes);
+    CPPUNIT_TEST(testReparenting);
+    CPPUNIT_TEST(testMergeNarrowLevels);
+    CPPUNIT_TEST(testSchedulingBenchmark);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testMatchesFullUpdate();
+    void testSkipsUnchangedNodes();
+    void testReparenting();
+    void testMergeNarrowLevels();
+    /// Not a test. Logs the time it takes to update deep & wide hierarchies
+    void testSchedulingBenchmark();
+};
+
+#endif
@@ -42,6 +42,11 @@ class RadixSortTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testIntList);
     CPPUNIT_TEST(testUnsignedIntVector);
     CPPUNIT_TEST(testIntVector);
+    CPPUNIT_TEST(testUint64Keys);
+    CPPUNIT_TEST(testUint64ConstantBytes);
+    CPPUNIT_TEST(testUint64Parallel);
+    CPPUNIT_TEST(testUint64InsertionSort);
+    CPPUNIT_TEST(testUint64FrameCoherent);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -56,6 +61,11 @@ public:
     void testIntList();
     void testUnsignedIntVector();
     void testIntVector();
+    void testUint64Keys();
+    void testUint64ConstantBytes();
+    void testUint64Parallel();
+    void testUint64InsertionSort();
+    void testUint64FrameCoherent();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,293 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ArrayMemoryManagerTests.h"
+#include "Math/Array/OgreArrayMemoryManager.h"
+#include "Math/Array/OgreTransform.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayMemoryManagerTests);
+
+namespace
+{
+    /// Keeps a Transform per node, identified by a fake owner pointer, the same way
+    /// NodeMemoryManager keeps the Transform of each Node updated.
+    class TestRebaseListener : public ArrayMemoryManager::RebaseListener
+    {
+    public:
+        NodeArrayMemoryManager *mManager;
+        vector<Transform>::type mTransforms;
+        vector<bool>::type      mAlive;
+
+        TestRebaseListener() : mManager( 0 ) {}
+
+        static Node *idToOwner( size_t id ) { return reinterpret_cast<Node *>( ( id + 1u ) * 16u ); }
+        static size_t ownerToId( Node *owner ) { return reinterpret_cast<size_t>( owner ) / 16u - 1u; }
+
+        void updateTransforms( size_t startInstance, size_t endInstance )
+        {
+            Transform transform;
+            const size_t numNodes = std::min( mManager->getFirstNode( transform ), endInstance );
+
+            const size_t roundedStart = startInstance / ARRAY_PACKED_REALS;
+            transform.advancePack( roundedStart );
+
+            for( size_t i = roundedStart * ARRAY_PACKED_REALS; i < numNodes; i += ARRAY_PACKED_REALS )
+            {
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    if( transform.mOwner[j] )
+                    {
+                        transform.mIndex = (uint8)j;
+                        mTransforms[ownerToId( transform.mOwner[j] )] = transform;
+                    }
+                }
+                transform.advancePack();
+            }
+        }
+
+        void buildDiffList( uint16 level, const MemoryPoolVec &basePtrs,
+                            ArrayMemoryManager::PtrdiffVec &outDiffsList ) override
+        {
+        }
+        void applyRebase( uint16 level, const MemoryPoolVec &newBasePtrs,
+                          const ArrayMemoryManager::PtrdiffVec &diffsList ) override
+        {
+            updateTransforms( 0u, std::numeric_limits<size_t>::max() );
+        }
+        void performCleanup( uint16 level, const MemoryPoolVec &basePtrs, size_t const *elementsMemSizes,
+                             size_t startInstance, size_t diffInstances ) override
+        {
+            updateTransforms( startInstance, std::numeric_limits<size_t>::max() );
+        }
+        void performPartialCleanup( uint16 level, const MemoryPoolVec &basePtrs,
+                                    size_t const *elementsMemSizes, size_t startInstance,
+                                    size_t endInstance, size_t diffInstances ) override
+        {
+            updateTransforms( startInstance, endInstance );
+        }
+    };
+
+    void createNodes( NodeArrayMemoryManager &manager, TestRebaseListener &listener,
+                      size_t numNodes )
+    {
+        listener.mTransforms.resize( numNodes );
+        listener.mAlive.resize( numNodes, true );
+        for( size_t i = 0; i < numNodes; ++i )
+        {
+            Transform &transform = listener.mTransforms[i];
+            manager.createNewNode( transform );
+            transform.mOwner[transform.mIndex] = TestRebaseListener::idToOwner( i );
+            transform.mPosition->setFromVector3( Vector3( Real( i ), 0, 0 ), transform.mIndex );
+        }
+    }
+
+    /// Destroys every node whose id is not a multiple of 3, except for a few
+    /// consecutive ones to have ranges of different sizes.
+    void destroyNodes( NodeArrayMemoryManager &manager, TestRebaseListener &listener )
+    {
+        const size_t numNodes = listener.mTransforms.size();
+        for( size_t i = 0; i < numNodes; ++i )
+        {
+            if( ( i % 3u ) != 0u && ( i % 50u ) > 7u )
+            {
+                Transform transform = listener.mTransforms[i];
+                manager.destroyNode( transform );
+                listener.mAlive[i] = false;
+            }
+        }
+    }
+
+    /// Checks the Transforms tracked by the listener still point to the right data,
+    /// and that the nodes kept their relative order.
+    void checkNodes( NodeArrayMemoryManager &manager, const TestRebaseListener &listener )
+    {
+        Transform firstTransform;
+        const size_t numSlots = manager.getFirstNode( firstTransform );
+        const Node **owners = const_cast<const Node **>( firstTransform.mOwner );
+
+        size_t lastSlot = 0u;
+        bool firstAlive = true;
+        const size_t numNodes = listener.mTransforms.size();
+        for( size_t i = 0; i < numNodes; ++i )
+        {
+            if( !listener.mAlive[i] )
+                continue;
+
+            const Transform &transform = listener.mTransforms[i];
+            CPPUNIT_ASSERT( transform.mOwner[transform.mIndex] == TestRebaseListener::idToOwner( i ) );
+            Vector3 position;
+            transform.mPosition->getAsVector3( position, transform.mIndex );
+            CPPUNIT_ASSERT( position == Vector3( Real( i ), 0, 0 ) );
+
+            const size_t slot =
+                static_cast<size_t>( transform.mOwner + transform.mIndex - firstTransform.mOwner );
+            CPPUNIT_ASSERT( slot < numSlots );
+            CPPUNIT_ASSERT( firstAlive || slot > lastSlot );
+            CPPUNIT_ASSERT( owners[slot] == TestRebaseListener::idToOwner( i ) );
+            lastSlot = slot;
+            firstAlive = false;
+        }
+
+        // Unused slots must be safe to process
+        const size_t numFragmented = manager.getNumFragmentedSlots();
+        size_t numUnused = 0;
+        for( size_t i = 0; i < numSlots; ++i )
+        {
+            if( !owners[i] )
+            {
+                ++numUnused;
+                Vector3 position;
+                Transform transform = firstTransform;
+                transform.advancePack( i / ARRAY_PACKED_REALS );
+                transform.mScale->getAsVector3( position, i % ARRAY_PACKED_REALS );
+                CPPUNIT_ASSERT( position == Vector3::UNIT_SCALE );
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL( numFragmented, numUnused );
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testCase( bool incremental, size_t maxSlotsPerStep )
+{
+    const size_t numNodes = 1000u;
+
+    TestRebaseListener listener;
+    NodeArrayMemoryManager manager( 0u, 16u, 0, ArrayMemoryManager::MAX_MEMORY_SLOTS,
+                                    ArrayMemoryManager::MAX_MEMORY_SLOTS, &listener );
+    listener.mManager = &manager;
+    manager.initialize();
+
+    createNodes( manager, listener, numNodes );
+    destroyNodes( manager, listener );
+    checkNodes( manager, listener );
+
+    const size_t numAlive =
+        static_cast<size_t>( std::count( listener.mAlive.begin(), listener.mAlive.end(), true ) );
+    CPPUNIT_ASSERT( manager.getNumFragmentedSlots() > 0u );
+    CPPUNIT_ASSERT( manager.getFragmentationRatio() > 0.0f );
+
+    if( incremental )
+    {
+        size_t numSteps = 0;
+        while( manager.getNumFragmentedSlots() )
+        {
+            const size_t slotsMoved = manager.defragmentIncremental( maxSlotsPerStep );
+            CPPUNIT_ASSERT( slotsMoved <= maxSlotsPerStep );
+            checkNodes( manager, listener );
+            ++numSteps;
+            CPPUNIT_ASSERT( numSteps < numNodes * numNodes );
+        }
+    }
+    else
+    {
+        manager.defragment();
+        checkNodes( manager, listener );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( numAlive, manager.getNumUsedSlotsIncludingFragmented() );
+    CPPUNIT_ASSERT_EQUAL( 0.0f, manager.getFragmentationRatio() );
+
+    // The pool must still be usable after defragmenting
+    Transform transform;
+    manager.createNewNode( transform );
+    CPPUNIT_ASSERT_EQUAL( numAlive + 1u, manager.getNumUsedSlotsIncludingFragmented() );
+
+    manager.destroy();
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testDefragment()
+{
+    testCase( false, 0u );
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testDefragmentIncremental()
+{
+    testCase( true, 1u );
+    testCase( true, 7u );
+    testCase( true, 64u );
+    testCase( true, 100000u );
+}
+//--------------------------------------------------------------------------
+void ArrayMemoryManagerTests::testDeferredCleanup()
+{
+    const size_t numNodes = 200u;
+
+    TestRebaseListener listener;
+    NodeArrayMemoryManager manager( 0u, 16u, 0, 10u, ArrayMemoryManager::MAX_MEMORY_SLOTS,
+                                    &listener );
+    listener.mManager = &manager;
+    manager.initialize();
+    manager.setDeferredCleanup( true );
+
+    createNodes( manager, listener, numNodes );
+    destroyNodes( manager, listener );
+
+    // Reaching the threshold must not defragment
+    CPPUNIT_ASSERT( manager.isCleanupPending() );
+    CPPUNIT_ASSERT( manager.getNumFragmentedSlots() > 10u );
+    checkNodes( manager, listener );
+
+    while( manager.isCleanupPending() )
+    {
+        manager.defragmentIncremental( 16u );
+        checkNodes( manager, listener );
+    }
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, manager.getNumFragmentedSlots() );
+
+    // Without deferring, the threshold triggers a full defragmentation
+    manager.setDeferredCleanup( false );
+    for( size_t i = 0; i < numNodes; ++i )
+    {
+        if( listener.mAlive[i] && ( i % 2u ) == 0u )
+        {
+            Transform transform = listener.mTransforms[i];
+            manager.destroyNode( transform );
+            listener.mAlive[i] = false;
+        }
+    }
+    CPPUNIT_ASSERT( !manager.isCleanupPending() );
+    CPPUNIT_ASSERT( manager.getNumFragmentedSlots() <= 10u );
+    checkNodes( manager, listener );
+
+    manager.destroy();
+}
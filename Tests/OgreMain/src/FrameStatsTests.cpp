@@ -0,0 +1,132 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "FrameStatsTests.h"
+#include "OgreFrameStats.h"
+#include "OgreMath.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(FrameStatsTests);
+
+//--------------------------------------------------------------------------
+void FrameStatsTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void FrameStatsTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void FrameStatsTests::testPercentiles()
+{
+    FrameStats frameStats;
+    frameStats.setWindowSize( 100u );
+
+    // Frames of 1ms, 2ms, ..., 150ms. Only the last 100 (51ms..150ms) remain in the window
+    uint64 timeUs = 0;
+    for( uint64 i = 1u; i <= 150u; ++i )
+    {
+        timeUs += i * 1000u;
+        frameStats.addSample( timeUs );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( (size_t)100u, frameStats.getNumWindowFrames() );
+    CPPUNIT_ASSERT( Math::RealEqual( 100.0f, frameStats.getPercentile( 50.0f ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 140.0f, frameStats.getPercentile( 90.0f ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 149.0f, frameStats.getPercentile( 99.0f ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 150.0f, frameStats.getPercentile( 100.0f ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 51.0f, frameStats.getPercentile( 0.0f ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 150.0f, frameStats.getWindowWorstTime(), 1e-3f ) );
+    // (51 + 150) / 2
+    CPPUNIT_ASSERT( Math::RealEqual( 100.5f, frameStats.getWindowAvgTime(), 1e-3f ) );
+
+    frameStats.reset( timeUs );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, frameStats.getNumWindowFrames() );
+    CPPUNIT_ASSERT( Math::RealEqual( 0.0f, frameStats.getPercentile( 50.0f ), 1e-3f ) );
+}
+//--------------------------------------------------------------------------
+void FrameStatsTests::testHitchesAndHistogram()
+{
+    FrameStats frameStats;
+
+    const float thresholds[2] = { 20.0f, 40.0f };
+    frameStats.setHitchThresholds( thresholds, 2u );
+
+    const uint64 frameTimesUs[] = { 16600u, 16700u, 25000u, 45000u, 500000u };
+    const size_t numFrames = sizeof( frameTimesUs ) / sizeof( frameTimesUs[0] );
+
+    uint64 timeUs = 0;
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        timeUs += frameTimesUs[i];
+        frameStats.addSample( timeUs );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( (size_t)2u, frameStats.getNumHitchThresholds() );
+    CPPUNIT_ASSERT_EQUAL( (uint64)3u, frameStats.getNumHitches( 0u ) );
+    CPPUNIT_ASSERT_EQUAL( (uint64)2u, frameStats.getNumHitches( 1u ) );
+
+    CPPUNIT_ASSERT_EQUAL( (uint64)numFrames, frameStats.getTotalFrames() );
+    CPPUNIT_ASSERT_EQUAL( (uint64)2u, frameStats.getHistogramBucket( 16u ) );
+    CPPUNIT_ASSERT_EQUAL( (uint64)1u, frameStats.getHistogramBucket( 25u ) );
+    CPPUNIT_ASSERT_EQUAL( (uint64)1u, frameStats.getHistogramBucket( 45u ) );
+    // Anything longer than the histogram goes into the last bucket
+    CPPUNIT_ASSERT_EQUAL( (uint64)1u,
+                          frameStats.getHistogramBucket( OGRE_FRAME_STATS_HISTOGRAM_BUCKETS - 1u ) );
+}
+//--------------------------------------------------------------------------
+void FrameStatsTests::testStageTimes()
+{
+    FrameStats frameStats;
+    frameStats.setWindowSize( 4u );
+
+    uint64 timeUs = 0;
+    for( uint64 i = 0u; i < 4u; ++i )
+    {
+        // Stage times added several times within the same frame are accumulated
+        frameStats.addStageTime( FrameStage::SceneUpdate, 1000u );
+        frameStats.addStageTime( FrameStage::SceneUpdate, 1000u );
+        frameStats.addStageTime( FrameStage::ShaderCompile, i * 4000u );
+        timeUs += 16000u;
+        frameStats.addSample( timeUs );
+    }
+
+    const FrameStage::FrameStage sceneUpdate = FrameStage::SceneUpdate;
+    const FrameStage::FrameStage shaderCompile = FrameStage::ShaderCompile;
+    CPPUNIT_ASSERT( Math::RealEqual( 2.0f, frameStats.getStageAvgTime( sceneUpdate ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 2.0f, frameStats.getStageWorstTime( sceneUpdate ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 6.0f, frameStats.getStageAvgTime( shaderCompile ), 1e-3f ) );
+    CPPUNIT_ASSERT( Math::RealEqual( 12.0f, frameStats.getStageWorstTime( shaderCompile ), 1e-3f ) );
+    CPPUNIT_ASSERT(
+        Math::RealEqual( 0.0f, frameStats.getStageAvgTime( FrameStage::Compositor ), 1e-3f ) );
+}
@@ -0,0 +1,451 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "HlmsTemplateTests.h"
+#include "OgreHlms.h"
+#include "OgreFileSystem.h"
+#include "OgreLogManager.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "Threading/OgreTaskScheduler.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsTemplateTests);
+
+namespace
+{
+    /// Bare Hlms that only loads templates and runs the preprocessor.
+    class TemplateOnlyHlms : public Hlms
+    {
+    public:
+        using Hlms::PendingShaderCode;
+
+        TemplateOnlyHlms( Archive *dataFolder, ArchiveVec *libraryFolders ) :
+            Hlms( HLMS_USER0, "TemplateOnly", dataFolder, libraryFolders )
+        {
+            mShaderFileExt = ".glsl";
+            mShaderSyntax = "glsl";
+            loadTemplateSources();
+        }
+
+        void setupRootLayout( RootLayout &rootLayout ) override {}
+
+        HlmsDatablock *createDatablockImpl( IdString datablockName,
+                                            const HlmsMacroblock *macroblockRef,
+                                            const HlmsBlendblock *blendblockRef,
+                                            const HlmsParamVec &paramVec ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                               bool casterPass, uint32 lastCacheHash,
+                               uint32 lastTextureHash ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV1( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        bool hasTemplate( ShaderType shaderType ) const
+        {
+            return mTemplateSources->hasTemplate[shaderType];
+        }
+
+        bool generate( ShaderType shaderType, const HlmsPropertyVec &properties,
+                       bool useCompiledTemplates, String &outSource,
+                       HlmsPropertyVec &outProperties, PiecesMap &outPieces )
+        {
+            ThreadData td;
+            td.setProperties = properties;
+            const bool syntaxError = preprocessTemplate( *mTemplateSources, shaderType, td,
+                                                         outSource, useCompiledTemplates );
+            outProperties.swap( td.setProperties );
+            outPieces.swap( td.pieces );
+            return syntaxError;
+        }
+
+        static void setTestProperty( HlmsPropertyVec &properties, IdString key, int32 value )
+        {
+            setProperty( properties, key, value );
+        }
+
+        /// Expands all shader stages the way compileShaderCode does, on the calling thread
+        void expandSerial( const HlmsPropertyVec &properties, String outSource[NumShaderTypes],
+                           HlmsPropertyVec &outProperties, FastArray<uint16> &outDependencies )
+        {
+            ThreadData td;
+            td.setProperties = properties;
+
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+            {
+                if( mTemplateSources->hasTemplate[i] )
+                {
+                    td.pieces = mNoPieces[i];
+                    String debugFilenameOutput;
+                    expandTemplate( static_cast<ShaderType>( i ), 0u, td, outSource[i],
+                                    debugFilenameOutput );
+                    if( getProperty( td.setProperties, HlmsBaseProp::DisableStage ) )
+                        outSource[i].clear();
+                    setProperty( td.setProperties, HlmsBaseProp::DisableStage, 0 );
+                }
+            }
+
+            ShaderCodeCache codeCache( mNoPieces );
+            storeDependencies( td, codeCache );
+            outProperties.swap( td.setProperties );
+            outDependencies.swap( codeCache.templateDependencies );
+        }
+
+        /// Schedules a variant the way _queueShaderGeneration does, to be expanded by
+        /// _generatePendingShader from the worker threads
+        void queueVariant( const HlmsPropertyVec &properties )
+        {
+            ShaderCodeCache codeCache( mNoPieces );
+            codeCache.mergedCache.setProperties = properties;
+            mPendingShaderCode.push_back( PendingShaderCode( codeCache ) );
+        }
+
+        const PendingShaderCode &getPendingShaderCode( size_t idx ) const
+        {
+            return mPendingShaderCode[idx];
+        }
+
+    private:
+        PiecesMap mNoPieces[NumShaderTypes];
+    };
+
+    /// Same as RenderQueue's ParallelShaderGenerationTask: one chunk per variant
+    class GeneratePendingShadersTask : public Task
+    {
+        Hlms *mHlms;
+
+    public:
+        GeneratePendingShadersTask( Hlms *hlms ) : mHlms( hlms ) {}
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            mHlms->_generatePendingShader( chunkIdx );
+        }
+    };
+
+    /// Collects every identifier that appears inside the arguments of an @command(...)
+    void gatherPropertyNames( Archive *archive, set<String>::type &outNames )
+    {
+        StringVectorPtr files = archive->list( false, false );
+        StringVector::const_iterator itor = files->begin();
+        StringVector::const_iterator endt = files->end();
+
+        while( itor != endt )
+        {
+            DataStreamPtr stream = archive->open( *itor );
+            const String source = stream->getAsString();
+
+            size_t pos = source.find( '@' );
+            while( pos != String::npos )
+            {
+                const size_t openParen = source.find( '(', pos );
+                const size_t closeParen = source.find( ')', openParen );
+                if( openParen != String::npos && closeParen != String::npos &&
+                    openParen - pos <= 16u )
+                {
+                    size_t i = openParen + 1u;
+                    while( i < closeParen )
+                    {
+                        const char c = source[i];
+                        if( isalpha( c ) || c == '_' )
+                        {
+                            const size_t wordStart = i;
+                            while( i < closeParen && ( isalnum( source[i] ) || source[i] == '_' ) )
+                                ++i;
+                            outNames.insert( source.substr( wordStart, i - wordStart ) );
+                        }
+                        else
+                        {
+                            ++i;
+                        }
+                    }
+                }
+
+                pos = source.find( '@', pos + 1u );
+            }
+
+            ++itor;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+    mMediaPath = "../../Samples/Media/";
+#else
+    mMediaPath = "./Samples/Media/";
+#endif
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::openArchives( const String &hlmsName, const StringVector &libraryFolders,
+                                      vector<FileSystemArchive *>::type &outArchives,
+                                      ArchiveVec &outLibraries )
+{
+    FileSystemArchive *dataFolder =
+        OGRE_NEW FileSystemArchive( mMediaPath + "Hlms/" + hlmsName + "/GLSL", "FileSystem", true );
+    dataFolder->load();
+    outArchives.push_back( dataFolder );
+
+    StringVector::const_iterator itor = libraryFolders.begin();
+    StringVector::const_iterator endt = libraryFolders.end();
+    while( itor != endt )
+    {
+        FileSystemArchive *library =
+            OGRE_NEW FileSystemArchive( mMediaPath + *itor, "FileSystem", true );
+        library->load();
+        outArchives.push_back( library );
+        outLibraries.push_back( library );
+        ++itor;
+    }
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::closeArchives( vector<FileSystemArchive *>::type &archives )
+{
+    for( size_t i = 0; i < archives.size(); ++i )
+    {
+        archives[i]->unload();
+        OGRE_DELETE archives[i];
+    }
+    archives.clear();
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::generatePropertySets( const vector<FileSystemArchive *>::type &archives,
+                                              size_t numVariants,
+                                              vector<HlmsPropertyVec>::type &outPropertySets )
+{
+    set<String>::type propertyNames;
+    for( size_t i = 0; i < archives.size(); ++i )
+        gatherPropertyNames( archives[i], propertyNames );
+
+    // Random but reproducible property sets. Odd variants define every property,
+    // even ones leave roughly 40% undefined so @property branches go both ways.
+    outPropertySets.reserve( numVariants );
+    for( size_t i = 0; i < numVariants; ++i )
+    {
+        HlmsPropertyVec properties;
+        set<String>::type::const_iterator itName = propertyNames.begin();
+        set<String>::type::const_iterator enName = propertyNames.end();
+        while( itName != enName )
+        {
+            const int r = rand() % 100;
+            if( r >= 40 || ( i & 0x01u ) )
+            {
+                const int32 value = r < 70 ? 1 : ( r < 85 ? 0 : rand() % 5 );
+                TemplateOnlyHlms::setTestProperty( properties, *itName, value );
+            }
+            ++itName;
+        }
+        TemplateOnlyHlms::setTestProperty( properties, HlmsBaseProp::Syntax,
+                                           static_cast<int32>( HlmsBaseProp::Glsl.mHash ) );
+        outPropertySets.push_back( properties );
+    }
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::runTemplates( const String &hlmsName, const StringVector &libraryFolders )
+{
+    const size_t numVariants = 200u;
+
+    vector<FileSystemArchive *>::type archives;
+    ArchiveVec libraries;
+    openArchives( hlmsName, libraryFolders, archives, libraries );
+    FileSystemArchive *dataFolder = archives.front();
+
+    vector<HlmsPropertyVec>::type propertySets;
+    generatePropertySets( archives, numVariants, propertySets );
+
+    uint64 elapsedUs[2] = { 0u, 0u };
+    size_t numGenerated = 0u;
+
+    {
+        TemplateOnlyHlms hlms( dataFolder, &libraries );
+        Timer timer;
+
+        for( size_t shaderType = 0u; shaderType < NumShaderTypes; ++shaderType )
+        {
+            if( !hlms.hasTemplate( static_cast<ShaderType>( shaderType ) ) )
+                continue;
+
+            vector<HlmsPropertyVec>::type::const_iterator itSet = propertySets.begin();
+            vector<HlmsPropertyVec>::type::const_iterator enSet = propertySets.end();
+            while( itSet != enSet )
+            {
+                String source[2];
+                HlmsPropertyVec properties[2];
+                PiecesMap pieces[2];
+                bool syntaxError[2];
+                for( size_t i = 0u; i < 2u; ++i )
+                {
+                    const uint64 startUs = timer.getMicroseconds();
+                    syntaxError[i] = hlms.generate( static_cast<ShaderType>( shaderType ), *itSet,
+                                                    i == 1u, source[i], properties[i], pieces[i] );
+                    elapsedUs[i] += timer.getMicroseconds() - startUs;
+                }
+
+                CPPUNIT_ASSERT( source[0] == source[1] );
+                CPPUNIT_ASSERT( properties[0] == properties[1] );
+                CPPUNIT_ASSERT( pieces[0] == pieces[1] );
+                CPPUNIT_ASSERT_EQUAL( syntaxError[0], syntaxError[1] );
+
+                ++numGenerated;
+                ++itSet;
+            }
+        }
+    }
+
+    CPPUNIT_ASSERT( numGenerated > 0u );
+
+    size_t variantsPerSecond[2];
+    for( size_t i = 0u; i < 2u; ++i )
+    {
+        variantsPerSecond[i] = static_cast<size_t>( ( numGenerated * 1000000u ) /
+                                                    std::max<uint64>( elapsedUs[i], 1u ) );
+    }
+
+    LogManager::getSingleton().logMessage(
+        "HlmsTemplateTests: " + hlmsName + " " + StringConverter::toString( numGenerated ) +
+        " variants. Parser: " + StringConverter::toString( variantsPerSecond[0] ) +
+        " variants/s. Compiled: " + StringConverter::toString( variantsPerSecond[1] ) +
+        " variants/s." );
+
+    closeArchives( archives );
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::runParallel( const String &hlmsName, const StringVector &libraryFolders )
+{
+    const size_t numVariants = 64u;
+
+    vector<FileSystemArchive *>::type archives;
+    ArchiveVec libraries;
+    openArchives( hlmsName, libraryFolders, archives, libraries );
+
+    vector<HlmsPropertyVec>::type propertySets;
+    generatePropertySets( archives, numVariants, propertySets );
+
+    {
+        TemplateOnlyHlms hlms( archives.front(), &libraries );
+
+        for( size_t i = 0u; i < numVariants; ++i )
+            hlms.queueVariant( propertySets[i] );
+
+        // All the variants are expanded at the same time from the worker threads,
+        // sharing the Hlms' TemplateSources
+        TaskScheduler taskScheduler( 4u );
+        GeneratePendingShadersTask task( &hlms );
+        taskScheduler.wait( taskScheduler.submit( &task, numVariants ) );
+
+        size_t numNonEmpty = 0u;
+        for( size_t i = 0u; i < numVariants; ++i )
+        {
+            String source[NumShaderTypes];
+            HlmsPropertyVec properties;
+            FastArray<uint16> dependencies;
+            hlms.expandSerial( propertySets[i], source, properties, dependencies );
+
+            const TemplateOnlyHlms::PendingShaderCode &pending = hlms.getPendingShaderCode( i );
+            for( size_t j = 0u; j < NumShaderTypes; ++j )
+            {
+                CPPUNIT_ASSERT( pending.source[j] == source[j] );
+                if( !source[j].empty() )
+                    ++numNonEmpty;
+            }
+            CPPUNIT_ASSERT( pending.finalProperties == properties );
+            CPPUNIT_ASSERT_EQUAL( dependencies.size(), pending.codeCache.templateDependencies.size() );
+            CPPUNIT_ASSERT( std::equal( dependencies.begin(), dependencies.end(),
+                                        pending.codeCache.templateDependencies.begin() ) );
+        }
+
+        CPPUNIT_ASSERT( numNonEmpty > 0u );
+    }
+
+    closeArchives( archives );
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::testPbsCompiledMatchesParser()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    StringVector libraryFolders;
+    libraryFolders.push_back( "Hlms/Common/GLSL" );
+    libraryFolders.push_back( "Hlms/Common/Any" );
+    libraryFolders.push_back( "Hlms/Pbs/Any" );
+    libraryFolders.push_back( "Hlms/Pbs/Any/Main" );
+    runTemplates( "Pbs", libraryFolders );
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::testUnlitCompiledMatchesParser()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    StringVector libraryFolders;
+    libraryFolders.push_back( "Hlms/Common/GLSL" );
+    libraryFolders.push_back( "Hlms/Common/Any" );
+    libraryFolders.push_back( "Hlms/Unlit/Any" );
+    runTemplates( "Unlit", libraryFolders );
+}
+//--------------------------------------------------------------------------
+void HlmsTemplateTests::testPbsParallelMatchesSerial()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    StringVector libraryFolders;
+    libraryFolders.push_back( "Hlms/Common/GLSL" );
+    libraryFolders.push_back( "Hlms/Common/Any" );
+    libraryFolders.push_back( "Hlms/Pbs/Any" );
+    libraryFolders.push_back( "Hlms/Pbs/Any/Main" );
+    runParallel( "Pbs", libraryFolders );
+}
@@ -0,0 +1,219 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ImageDownsamplerTests.h"
+#include "OgreImage2.h"
+#include "OgreImageDownsampler.h"
+#include "OgreLogManager.h"
+#include "OgreMath.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageDownsamplerTests);
+
+namespace
+{
+    // Same kernels as c_filterKernels, which are not exported
+    const FilterKernel c_testKernels[3] =
+    {
+        {
+            //Point
+            {
+                { 0, 0, 0, 0, 0 },
+                { 0, 0, 0, 0, 0 },
+                { 0, 0, 1, 0, 0 },
+                { 0, 0, 0, 0, 0 },
+                { 0, 0, 0, 0, 0 }
+            },
+            0, 0,
+            0, 0
+        },
+        {
+            //Linear
+            {
+                { 0, 0, 0, 0, 0 },
+                { 0, 0, 0, 0, 0 },
+                { 0, 0, 1, 1, 0 },
+                { 0, 0, 1, 1, 0 },
+                { 0, 0, 0, 0, 0 }
+            },
+            0, 1,
+            0, 1
+        },
+        {
+            //Gaussian
+            {
+                { 1,  4,  7,  4, 1 },
+                { 4, 16, 26, 16, 4 },
+                { 7, 26, 41, 26, 7 },
+                { 4, 16, 26, 16, 4 },
+                { 1,  4,  7,  4, 1 }
+            },
+            -2, 2,
+            -2, 2
+        }
+    };
+
+    void fillRandom( vector<uint8>::type &buffer, bool isFloat )
+    {
+        if( isFloat )
+        {
+            float *data = reinterpret_cast<float *>( &buffer[0] );
+            const size_t numFloats = buffer.size() / sizeof( float );
+            for( size_t i = 0; i < numFloats; ++i )
+                data[i] = Math::RangeRandom( -4.0f, 4.0f );
+        }
+        else
+        {
+            for( size_t i = 0; i < buffer.size(); ++i )
+                buffer[i] = static_cast<uint8>( rand() & 0xFF );
+        }
+    }
+
+    void getDownsampler( PixelFormatGpu format, bool useSimd, ImageDownsampler2D **outDownsampler )
+    {
+        void *downsampler3D, *downsamplerCube, *blur2D;
+        const bool supported = Image2::getDownsamplerFunctions(
+            format, reinterpret_cast<void **>( outDownsampler ), &downsampler3D, &downsamplerCube,
+            &blur2D, false, 1u, TextureTypes::Type2D, Image2::FILTER_BILINEAR, useSimd );
+        CPPUNIT_ASSERT( supported && *outDownsampler );
+    }
+}
+
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand( 0 );
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::runDownsampler( PixelFormatGpu format )
+{
+    ImageDownsampler2D *downsamplers[2];
+    getDownsampler( format, false, &downsamplers[0] );
+    getDownsampler( format, true, &downsamplers[1] );
+
+    const bool isFloat = PixelFormatGpuUtils::isFloat( format );
+    const int32 bytesPerPixel = static_cast<int32>( PixelFormatGpuUtils::getBytesPerPixel( format ) );
+
+    // Odd sizes, sizes smaller than a SIMD register, and rows with padding at the end
+    const int32 c_sizes[][2] = { { 1, 1 },   { 2, 2 },   { 3, 5 },    { 9, 2 },    { 2, 9 },
+                                 { 16, 16 }, { 17, 33 }, { 31, 30 },  { 130, 66 }, { 257, 129 } };
+
+    for( size_t i = 0; i < sizeof( c_sizes ) / sizeof( c_sizes[0] ); ++i )
+    {
+        const int32 srcWidth = c_sizes[i][0];
+        const int32 srcHeight = c_sizes[i][1];
+        const int32 dstWidth = std::max( 1, srcWidth >> 1 );
+        const int32 dstHeight = std::max( 1, srcHeight >> 1 );
+        const int32 srcBytesPerRow = srcWidth * bytesPerPixel + 16;
+        const int32 dstBytesPerRow = dstWidth * bytesPerPixel + 8;
+
+        vector<uint8>::type src( static_cast<size_t>( srcBytesPerRow * srcHeight ) );
+        fillRandom( src, isFloat );
+
+        for( size_t k = 0; k < 3u; ++k )
+        {
+            const FilterKernel &kernel = c_testKernels[k];
+
+            vector<uint8>::type dst[2];
+            for( size_t j = 0; j < 2u; ++j )
+            {
+                dst[j].resize( static_cast<size_t>( dstBytesPerRow * dstHeight ), 0xCD );
+                ( *downsamplers[j] )( &dst[j][0], &src[0], dstWidth, dstHeight, dstBytesPerRow,
+                                      srcWidth, srcBytesPerRow, kernel.kernel, kernel.kernelStartX,
+                                      kernel.kernelEndX, kernel.kernelStartY, kernel.kernelEndY );
+            }
+
+            CPPUNIT_ASSERT( dst[0] == dst[1] );
+        }
+    }
+
+    // Benchmark
+    const int32 srcWidth = 2048;
+    const int32 srcHeight = 2048;
+    const uint32 numRuns = 4u;
+    vector<uint8>::type src( static_cast<size_t>( srcWidth * srcHeight * bytesPerPixel ) );
+    vector<uint8>::type dst( src.size() / 4u );
+    fillRandom( src, isFloat );
+
+    const FilterKernel &kernel = c_testKernels[1];
+    uint64 megapixelsPerSecond[2];
+    Timer timer;
+    for( size_t j = 0; j < 2u; ++j )
+    {
+        const uint64 startUs = timer.getMicroseconds();
+        for( uint32 run = 0u; run < numRuns; ++run )
+        {
+            ( *downsamplers[j] )( &dst[0], &src[0], srcWidth >> 1, srcHeight >> 1,
+                                  ( srcWidth >> 1 ) * bytesPerPixel, srcWidth,
+                                  srcWidth * bytesPerPixel, kernel.kernel, kernel.kernelStartX,
+                                  kernel.kernelEndX, kernel.kernelStartY, kernel.kernelEndY );
+        }
+        const uint64 elapsedUs = std::max<uint64>( timer.getMicroseconds() - startUs, 1u );
+        megapixelsPerSecond[j] = uint64( srcWidth * srcHeight ) * numRuns / elapsedUs;
+    }
+
+    LogManager::getSingleton().logMessage(
+        "ImageDownsamplerTests: " + String( PixelFormatGpuUtils::toString( format ) ) +
+        " Scalar: " + StringConverter::toString( megapixelsPerSecond[0] ) +
+        " MP/s. SIMD: " + StringConverter::toString( megapixelsPerSecond[1] ) + " MP/s." );
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testRgba8()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    runDownsampler( PFG_RGBA8_UNORM );
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testRgba8Srgb()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    runDownsampler( PFG_RGBA8_UNORM_SRGB );
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testRgba32Float()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    runDownsampler( PFG_RGBA32_FLOAT );
+}
+//--------------------------------------------------------------------------
+void ImageDownsamplerTests::testR32Float()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+    runDownsampler( PFG_R32_FLOAT );
+}
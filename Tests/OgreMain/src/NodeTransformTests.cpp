@@ -0,0 +1,393 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "NodeTransformTests.h"
+#include "Math/Array/OgreNodeMemoryManager.h"
+#include "OgreLogManager.h"
+#include "OgreNode.h"
+#include "OgreStringConverter.h"
+#include "OgreTimer.h"
+#include "OgreTransformUpdateScheduler.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(NodeTransformTests);
+
+namespace
+{
+    class TestNode : public Node
+    {
+    public:
+        TestNode( NodeMemoryManager *nodeMemoryManager, Node *parent ) :
+            Node( 0, nodeMemoryManager, parent )
+        {
+        }
+
+        void _callMemoryChangeListeners() override {}
+        NodeMemoryManager *getDefaultNodeMemoryManager( SceneMemoryMgrTypes sceneType ) override
+        {
+            return mNodeMemoryManager;
+        }
+
+    protected:
+        Node *createChildImpl( SceneMemoryMgrTypes sceneType ) override
+        {
+            return OGRE_NEW TestNode( mNodeMemoryManager, this );
+        }
+    };
+
+    /// Roots, each with numChildren children, each with numGrandChildren children
+    struct TestScene
+    {
+        NodeMemoryManager   nodeMemoryManager;
+        vector<Node *>::type roots;
+        vector<Node *>::type nodes;  // Parents always before their children
+
+        TestScene( size_t numRoots, size_t numChildren, size_t numGrandChildren )
+        {
+            for( size_t i = 0; i < numRoots; ++i )
+            {
+                Node *root = OGRE_NEW TestNode( &nodeMemoryManager, 0 );
+                root->setPosition( Real( i ) * 10.0f, 0, 0 );
+                roots.push_back( root );
+                nodes.push_back( root );
+            }
+            for( size_t i = 0; i < numRoots; ++i )
+            {
+                for( size_t j = 0; j < numChildren; ++j )
+                {
+                    Node *child = roots[i]->createChild(
+                        SCENE_DYNAMIC, Vector3( 0, Real( j ), 0 ),
+                        Quaternion( Radian( Real( j ) * 0.1f ), Vector3::UNIT_Y ) );
+                    nodes.push_back( child );
+                    for( size_t k = 0; k < numGrandChildren; ++k )
+                    {
+                        Node *grandChild =
+                            child->createChild( SCENE_DYNAMIC, Vector3( 0, 0, Real( k ) ) );
+                        grandChild->setScale( 1.0f + Real( k ) * 0.5f, 1.0f, 1.0f );
+                        nodes.push_back( grandChild );
+                    }
+                }
+            }
+        }
+
+        /// numChains chains of chainLength nodes each, i.e. numChains nodes per depth level
+        TestScene( size_t numChains, size_t chainLength )
+        {
+            for( size_t i = 0; i < numChains; ++i )
+            {
+                Node *node = OGRE_NEW TestNode( &nodeMemoryManager, 0 );
+                node->setPosition( Real( i ) * 10.0f, 0, 0 );
+                roots.push_back( node );
+                nodes.push_back( node );
+            }
+            for( size_t i = 0; i < numChains; ++i )
+            {
+                Node *node = roots[i];
+                for( size_t j = 1; j < chainLength; ++j )
+                {
+                    node = node->createChild(
+                        SCENE_DYNAMIC, Vector3( 0, 1.0f, 0 ),
+                        Quaternion( Radian( Real( i + j ) * 0.05f ), Vector3::UNIT_Z ) );
+                    nodes.push_back( node );
+                }
+            }
+        }
+
+        ~TestScene()
+        {
+            // Children first, so nobody gets detached and moved around
+            vector<Node *>::type::const_reverse_iterator itor = nodes.rbegin();
+            vector<Node *>::type::const_reverse_iterator endt = nodes.rend();
+            while( itor != endt )
+                OGRE_DELETE *itor++;
+        }
+
+        /// Does what SceneManager::updateAllTransforms does. Returns the number of updated nodes
+        size_t update( bool dirtyTracking )
+        {
+            size_t numUpdated = 0;
+            const size_t numDepths = nodeMemoryManager.getNumDepths();
+            for( size_t i = 0; i < numDepths; ++i )
+            {
+                Transform t;
+                const size_t numNodes = nodeMemoryManager.getFirstNode( t, i );
+                numUpdated += dirtyTracking ? Node::updateDirtyTransforms( numNodes, t )
+                                            : Node::updateAllTransforms( numNodes, t );
+            }
+            return numUpdated;
+        }
+
+        /// Same as update( false ), but the way SceneManager does it with multiple threads
+        void update( TransformUpdateScheduler &scheduler, TaskScheduler *taskScheduler )
+        {
+            // Same chunk size SceneManager would use
+            const size_t numChunks = taskScheduler->getNumThreads() * 8u;
+
+            const size_t numDepths = nodeMemoryManager.getNumDepths();
+            for( size_t i = 0; i < numDepths; ++i )
+            {
+                Transform t;
+                const size_t numNodes = nodeMemoryManager.getFirstNode( t, i );
+                size_t numNodesPerChunk =
+                    std::max<size_t>( ( numNodes + numChunks - 1u ) / numChunks, 128u );
+                numNodesPerChunk = alignToNextMultiple<size_t>( numNodesPerChunk, ARRAY_PACKED_REALS );
+                scheduler.addLevel( t, numNodes, numNodesPerChunk, &Node::updateAllTransforms );
+            }
+            scheduler.execute( taskScheduler );
+        }
+
+        size_t getNumSlots()
+        {
+            size_t numSlots = 0;
+            const size_t numDepths = nodeMemoryManager.getNumDepths();
+            for( size_t i = 0; i < numDepths; ++i )
+            {
+                Transform t;
+                numSlots += nodeMemoryManager.getFirstNode( t, i );
+            }
+            return numSlots;
+        }
+    };
+
+    bool sameDerivedTransforms( const TestScene &a, const TestScene &b )
+    {
+        bool retVal = a.nodes.size() == b.nodes.size();
+        for( size_t i = 0; i < a.nodes.size() && retVal; ++i )
+        {
+            retVal = a.nodes[i]->_getFullTransform() == b.nodes[i]->_getFullTransform() &&
+                     a.nodes[i]->_getDerivedPosition() == b.nodes[i]->_getDerivedPosition() &&
+                     a.nodes[i]->_getDerivedOrientation() == b.nodes[i]->_getDerivedOrientation() &&
+                     a.nodes[i]->_getDerivedScale() == b.nodes[i]->_getDerivedScale();
+        }
+        return retVal;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void NodeTransformTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::testMatchesFullUpdate()
+{
+    TestScene fullScene( 5u, 6u, 7u );
+    TestScene dirtyScene( 5u, 6u, 7u );
+
+    fullScene.update( false );
+    dirtyScene.update( true );
+    CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, dirtyScene ) );
+
+    // Move ~10% of the nodes every frame, at random depths
+    uint32 seed = 12345u;
+    const size_t numNodes = fullScene.nodes.size();
+    for( size_t frame = 0; frame < 20u; ++frame )
+    {
+        for( size_t i = 0; i < numNodes / 10u; ++i )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const size_t nodeIdx = ( seed >> 8u ) % numNodes;
+            const Real value = Real( ( seed >> 4u ) & 0xFF ) / 255.0f;
+
+            switch( seed % 4u )
+            {
+            case 0:
+                fullScene.nodes[nodeIdx]->setPosition( value, 1.0f - value, value * 2.0f );
+                dirtyScene.nodes[nodeIdx]->setPosition( value, 1.0f - value, value * 2.0f );
+                break;
+            case 1:
+                fullScene.nodes[nodeIdx]->yaw( Radian( value ) );
+                dirtyScene.nodes[nodeIdx]->yaw( Radian( value ) );
+                break;
+            case 2:
+                fullScene.nodes[nodeIdx]->setScale( Vector3( 1.0f + value ) );
+                dirtyScene.nodes[nodeIdx]->setScale( Vector3( 1.0f + value ) );
+                break;
+            case 3:
+                fullScene.nodes[nodeIdx]->setInheritScale( value < 0.5f );
+                dirtyScene.nodes[nodeIdx]->setInheritScale( value < 0.5f );
+                break;
+            }
+        }
+
+        const size_t numUpdated = dirtyScene.update( true );
+        fullScene.update( false );
+
+        CPPUNIT_ASSERT( numUpdated <= dirtyScene.getNumSlots() );
+        CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, dirtyScene ) );
+    }
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::testSkipsUnchangedNodes()
+{
+    TestScene scene( 2u, 8u, 4u );
+
+    // Everything is new
+    CPPUNIT_ASSERT_EQUAL( scene.getNumSlots(), scene.update( true ) );
+
+    // Nothing changed
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), scene.update( true ) );
+
+    // Only the pack of the last grandchild
+    scene.nodes.back()->setPosition( 1.0f, 2.0f, 3.0f );
+    size_t numUpdated = scene.update( true );
+    CPPUNIT_ASSERT( numUpdated > 0u && numUpdated <= ARRAY_PACKED_REALS );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), scene.update( true ) );
+
+    // The first root and its whole subtree, but not the subtree of the other root
+    scene.roots[0]->setPosition( 5.0f, 0.0f, 0.0f );
+    numUpdated = scene.update( true );
+    CPPUNIT_ASSERT( numUpdated >= 1u + 8u + 8u * 4u );
+    CPPUNIT_ASSERT( numUpdated < scene.getNumSlots() );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), scene.update( true ) );
+
+    // Full updates always update everything
+    CPPUNIT_ASSERT_EQUAL( scene.getNumSlots(), scene.update( false ) );
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::testReparenting()
+{
+    TestScene fullScene( 3u, 4u, 4u );
+    TestScene dirtyScene( 3u, 4u, 4u );
+
+    fullScene.update( false );
+    dirtyScene.update( true );
+
+    TestScene *scenes[2] = { &fullScene, &dirtyScene };
+    for( size_t i = 0; i < 2u; ++i )
+    {
+        TestScene &scene = *scenes[i];
+        // Move a grandchild under another root, and a child of the first root to the root level.
+        // They change depth level and thus memory slot; they must be updated even though
+        // their local transform didn't change.
+        Node *grandChild = scene.nodes.back();
+        grandChild->getParent()->removeChild( grandChild );
+        scene.roots[1]->addChild( grandChild );
+
+        Node *child = scene.nodes[scene.roots.size()];
+        child->getParent()->removeChild( child );
+    }
+
+    fullScene.update( false );
+    dirtyScene.update( true );
+    CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, dirtyScene ) );
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::testMergeNarrowLevels()
+{
+    TaskScheduler taskScheduler( 3u );
+
+    TransformUpdateScheduler schedulers[2];
+    schedulers[0].setScheduling( TransformUpdateScheduler::SchedulingPerLevel );
+    schedulers[1].setScheduling( TransformUpdateScheduler::SchedulingMergeNarrowLevels );
+
+    {
+        // Deep: every level fits in a single chunk, thus they all get merged into one task
+        TestScene fullScene( 4u, 48u );
+        TestScene perLevelScene( 4u, 48u );
+        TestScene mergedScene( 4u, 48u );
+
+        fullScene.update( false );
+        perLevelScene.update( schedulers[0], &taskScheduler );
+        mergedScene.update( schedulers[1], &taskScheduler );
+
+        CPPUNIT_ASSERT_EQUAL( size_t( 48u ), schedulers[0].getNumTasks() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 1u ), schedulers[1].getNumTasks() );
+        CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, perLevelScene ) );
+        CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, mergedScene ) );
+    }
+    {
+        // Wide with a narrow level in between: the wide levels must still be split
+        TestScene fullScene( 600u, 3u, 2u );
+        TestScene perLevelScene( 600u, 3u, 2u );
+        TestScene mergedScene( 600u, 3u, 2u );
+
+        // Make the last grandchild a chain, so that there are a few narrow levels at the end
+        TestScene *scenes[3] = { &fullScene, &perLevelScene, &mergedScene };
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            Node *node = scenes[i]->nodes.back();
+            for( size_t j = 0; j < 3u; ++j )
+            {
+                node = node->createChild( SCENE_DYNAMIC, Vector3( 1.0f, 0, 0 ) );
+                scenes[i]->nodes.push_back( node );
+            }
+        }
+
+        fullScene.update( false );
+        perLevelScene.update( schedulers[0], &taskScheduler );
+        mergedScene.update( schedulers[1], &taskScheduler );
+
+        CPPUNIT_ASSERT_EQUAL( size_t( 6u ), schedulers[0].getNumTasks() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 4u ), schedulers[1].getNumTasks() );
+        CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, perLevelScene ) );
+        CPPUNIT_ASSERT( sameDerivedTransforms( fullScene, mergedScene ) );
+    }
+}
+//--------------------------------------------------------------------------
+void NodeTransformTests::testSchedulingBenchmark()
+{
+    TaskScheduler taskScheduler( 3u );
+
+    const char *shapeNames[2] = { "Deep (8 x 256 levels)", "Wide (64 x 64 x 4)" };
+    const uint32 numFrames = 200u;
+
+    for( size_t shape = 0; shape < 2u; ++shape )
+    {
+        uint64 microseconds[2];
+        for( size_t j = 0; j < 2u; ++j )
+        {
+            TestScene *scene =
+                shape == 0u ? new TestScene( 8u, 256u ) : new TestScene( 64u, 64u, 4u );
+
+            TransformUpdateScheduler scheduler;
+            scheduler.setScheduling( j == 0u ? TransformUpdateScheduler::SchedulingPerLevel
+                                             : TransformUpdateScheduler::SchedulingMergeNarrowLevels );
+            Timer timer;
+            for( uint32 frame = 0u; frame < numFrames; ++frame )
+                scene->update( scheduler, &taskScheduler );
+            microseconds[j] = timer.getMicroseconds();
+
+            delete scene;
+        }
+
+        LogManager::getSingleton().logMessage(
+            "NodeTransformTests: " + String( shapeNames[shape] ) +
+            " Per level: " + StringConverter::toString( microseconds[0] / numFrames ) +
+            " us/frame. Merged narrow levels: " +
+            StringConverter::toString( microseconds[1] / numFrames ) + " us/frame." );
+    }
+}
@@ -0,0 +1,171 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OcclusionBufferTests.h"
+#include "OgreOcclusionBuffer.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(OcclusionBufferTests);
+
+namespace
+{
+    /// A wall 10x10 units wide, 10 units in front of the camera
+    const Aabb c_wall( Vector3( 0, 0, -10 ), Vector3( 5, 5, 0.5f ) );
+}
+
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    // 90 degrees vertical FOV, 2:1 aspect ratio (matches the default resolution), near = 1, far = 100
+    const Real nearDist = 1.0f;
+    const Real farDist = 100.0f;
+    mViewProj = Matrix4( 0.5f, 0, 0, 0,
+                         0, 1.0f, 0, 0,
+                         0, 0, ( farDist + nearDist ) / ( nearDist - farDist ),
+                         2.0f * farDist * nearDist / ( nearDist - farDist ),
+                         0, 0, -1.0f, 0 );
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::testHiddenBehindOccluder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OcclusionBuffer buffer;
+    buffer.beginOccluders( mViewProj );
+    CPPUNIT_ASSERT( buffer.addOccluder( c_wall, Matrix4::IDENTITY ) );
+    CPPUNIT_ASSERT_EQUAL( (size_t)12u, buffer.getNumTriangles() );
+    buffer.rasterize( 0u, buffer.getHeight() );
+
+    CPPUNIT_ASSERT( buffer.isOccluded( Aabb( Vector3( 0, 0, -20 ), Vector3( 1, 1, 1 ) ) ) );
+    CPPUNIT_ASSERT( buffer.isOccluded( Aabb( Vector3( 3, -3, -15 ), Vector3( 1, 1, 1 ) ) ) );
+
+    // Same wall, moved away by a transform. The box is now in front of it
+    Matrix4 worldMatrix;
+    worldMatrix.makeTransform( Vector3( 0, 0, -30 ), Vector3::UNIT_SCALE, Quaternion::IDENTITY );
+    buffer.beginOccluders( mViewProj );
+    CPPUNIT_ASSERT( buffer.addOccluder( c_wall, worldMatrix ) );
+    buffer.rasterize( 0u, buffer.getHeight() );
+
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 0, -20 ), Vector3( 1, 1, 1 ) ) ) );
+    CPPUNIT_ASSERT( buffer.isOccluded( Aabb( Vector3( 0, 0, -60 ), Vector3( 1, 1, 1 ) ) ) );
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::testInFrontOfOccluder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OcclusionBuffer buffer;
+    buffer.beginOccluders( mViewProj );
+    buffer.addOccluder( c_wall, Matrix4::IDENTITY );
+    buffer.rasterize( 0u, buffer.getHeight() );
+
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 0, -5 ), Vector3( 1, 1, 1 ) ) ) );
+    // Intersecting the wall
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 0, -10 ), Vector3( 1, 1, 1 ) ) ) );
+    // Crossing the near plane
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 0, -12 ), Vector3( 1, 1, 12 ) ) ) );
+    // Infinite
+    Aabb infiniteBox = Aabb::BOX_INFINITE;
+    CPPUNIT_ASSERT( !buffer.isOccluded( infiniteBox ) );
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::testBesidesOccluder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OcclusionBuffer buffer;
+    buffer.beginOccluders( mViewProj );
+    buffer.addOccluder( c_wall, Matrix4::IDENTITY );
+    buffer.rasterize( 0u, buffer.getHeight() );
+
+    // Fully visible next to the wall
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 20, 0, -20 ), Vector3( 1, 1, 1 ) ) ) );
+    // Partially peeking behind the wall's edge
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 10, 0, -20 ), Vector3( 1, 1, 1 ) ) ) );
+    // Above the wall
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 15, -20 ), Vector3( 1, 1, 1 ) ) ) );
+
+    // Nothing was rasterized: nothing can be occluded
+    buffer.beginOccluders( mViewProj );
+    buffer.rasterize( 0u, buffer.getHeight() );
+    CPPUNIT_ASSERT( !buffer.isOccluded( Aabb( Vector3( 0, 0, -20 ), Vector3( 1, 1, 1 ) ) ) );
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::testNearPlaneOccluder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OcclusionBuffer buffer;
+    buffer.beginOccluders( mViewProj );
+
+    // Crosses the near plane, and can't be rasterized without clipping
+    CPPUNIT_ASSERT( !buffer.addOccluder( Aabb( Vector3( 0, 0, -2 ), Vector3( 5, 5, 2 ) ),
+                                         Matrix4::IDENTITY ) );
+    CPPUNIT_ASSERT( !buffer.addOccluder( Aabb::BOX_INFINITE, Matrix4::IDENTITY ) );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, buffer.getNumTriangles() );
+}
+//--------------------------------------------------------------------------
+void OcclusionBufferTests::testRasterizeInBands()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Odd resolution so rows aren't a multiple of the SIMD width, and the bands are uneven
+    OcclusionBuffer fullBuffer( 203u, 101u );
+    OcclusionBuffer bandBuffer( 203u, 101u );
+
+    Matrix4 worldMatrix;
+    worldMatrix.makeTransform( Vector3( 2, 1, -15 ), Vector3( 1, 2, 1 ),
+                               Quaternion( Degree( 30 ), Vector3( 1, 1, 0 ).normalisedCopy() ) );
+
+    fullBuffer.beginOccluders( mViewProj );
+    fullBuffer.addOccluder( c_wall, Matrix4::IDENTITY );
+    fullBuffer.addOccluder( c_wall, worldMatrix );
+    fullBuffer.rasterize( 0u, fullBuffer.getHeight() );
+
+    bandBuffer.beginOccluders( mViewProj );
+    bandBuffer.addOccluder( c_wall, Matrix4::IDENTITY );
+    bandBuffer.addOccluder( c_wall, worldMatrix );
+    for( uint32 row = 0u; row < bandBuffer.getHeight(); row += 7u )
+        bandBuffer.rasterize( row, 7u );
+
+    const size_t numValues = fullBuffer.getRowPitch() * fullBuffer.getHeight();
+    const Real *fullDepth = fullBuffer.getDepthBuffer();
+    const Real *bandDepth = bandBuffer.getDepthBuffer();
+    for( size_t i = 0; i < numValues; ++i )
+        CPPUNIT_ASSERT_EQUAL( fullDepth[i], bandDepth[i] );
+}
+//--------------------------------------------------------------------------
@@ -0,0 +1,479 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OfflineProfilerTests.h"
+#include "OgreOfflineProfiler.h"
+#include "OgreStringConverter.h"
+#include "Threading/OgreThreads.h"
+
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(OfflineProfilerTests);
+
+namespace
+{
+    /// Just enough of a JSON DOM to look at trace events
+    struct JsonValue
+    {
+        enum Type
+        {
+            Null,
+            Bool,
+            Number,
+            Str,
+            Array,
+            Object
+        };
+
+        Type   type;
+        double number;
+        String str;
+
+        std::vector<JsonValue>              array;
+        std::vector<std::pair<String, JsonValue> > object;
+
+        JsonValue() : type( Null ), number( 0 ) {}
+
+        const JsonValue *find( const String &key ) const
+        {
+            for( size_t i = 0u; i < object.size(); ++i )
+            {
+                if( object[i].first == key )
+                    return &object[i].second;
+            }
+            return 0;
+        }
+    };
+
+    /// Strict parser: returns false on anything RFC 8259 doesn't allow
+    class JsonParser
+    {
+        const char *mPos;
+        const char *mEnd;
+
+        void skipWhitespace()
+        {
+            while( mPos != mEnd &&
+                   ( *mPos == ' ' || *mPos == '\n' || *mPos == '\r' || *mPos == '\t' ) )
+            {
+                ++mPos;
+            }
+        }
+
+        bool consume( const char *literal )
+        {
+            const char *pos = mPos;
+            while( *literal )
+            {
+                if( pos == mEnd || *pos != *literal )
+                    return false;
+                ++pos;
+                ++literal;
+            }
+            mPos = pos;
+            return true;
+        }
+
+        bool parseString( String &outStr )
+        {
+            if( !consume( "\"" ) )
+                return false;
+            while( mPos != mEnd && *mPos != '"' )
+            {
+                const char c = *mPos++;
+                if( static_cast<unsigned char>( c ) < 0x20u )
+                    return false;
+                if( c == '\\' )
+                {
+                    if( mPos == mEnd )
+                        return false;
+                    const char escaped = *mPos++;
+                    if( escaped == '"' || escaped == '\\' || escaped == '/' )
+                        outStr += escaped;
+                    else if( escaped == 'n' )
+                        outStr += '\n';
+                    else if( escaped == 't' )
+                        outStr += '\t';
+                    else
+                        return false;  // Not needed by these tests (e.g. \u)
+                }
+                else
+                {
+                    outStr += c;
+                }
+            }
+            return consume( "\"" );
+        }
+
+        bool parseNumber( double &outNumber )
+        {
+            const char *start = mPos;
+            if( mPos != mEnd && *mPos == '-' )
+                ++mPos;
+            if( mPos == mEnd || *mPos < '0' || *mPos > '9' )
+                return false;
+            // No leading zeroes
+            if( *mPos == '0' && mPos + 1 != mEnd && mPos[1] >= '0' && mPos[1] <= '9' )
+                return false;
+            while( mPos != mEnd && ( ( *mPos >= '0' && *mPos <= '9' ) || *mPos == '.' ||
+                                     *mPos == 'e' || *mPos == 'E' || *mPos == '+' ||
+                                     *mPos == '-' ) )
+            {
+                ++mPos;
+            }
+            outNumber = StringConverter::parseReal( String( start, mPos ) );
+            return true;
+        }
+
+    public:
+        JsonParser( const String &json ) : mPos( json.c_str() ), mEnd( json.c_str() + json.size() )
+        {
+        }
+
+        bool parseValue( JsonValue &outValue )
+        {
+            skipWhitespace();
+            if( mPos == mEnd )
+                return false;
+
+            bool retVal = true;
+            if( *mPos == '{' )
+            {
+                ++mPos;
+                outValue.type = JsonValue::Object;
+                skipWhitespace();
+                if( !consume( "}" ) )
+                {
+                    do
+                    {
+                        skipWhitespace();
+                        outValue.object.push_back( std::pair<String, JsonValue>() );
+                        retVal = parseString( outValue.object.back().first );
+                        skipWhitespace();
+                        retVal = retVal && consume( ":" ) &&
+                                 parseValue( outValue.object.back().second );
+                        skipWhitespace();
+                    } while( retVal && consume( "," ) );
+                    retVal = retVal && consume( "}" );
+                }
+            }
+            else if( *mPos == '[' )
+            {
+                ++mPos;
+                outValue.type = JsonValue::Array;
+                skipWhitespace();
+                if( !consume( "]" ) )
+                {
+                    do
+                    {
+                        outValue.array.push_back( JsonValue() );
+                        retVal = parseValue( outValue.array.back() );
+                        skipWhitespace();
+                    } while( retVal && consume( "," ) );
+                    retVal = retVal && consume( "]" );
+                }
+            }
+            else if( *mPos == '"' )
+            {
+                outValue.type = JsonValue::Str;
+                retVal = parseString( outValue.str );
+            }
+            else if( consume( "true" ) || consume( "false" ) )
+            {
+                outValue.type = JsonValue::Bool;
+            }
+            else if( consume( "null" ) )
+            {
+                outValue.type = JsonValue::Null;
+            }
+            else
+            {
+                outValue.type = JsonValue::Number;
+                retVal = parseNumber( outValue.number );
+            }
+            return retVal;
+        }
+
+        /// Parses the whole document, which must hold exactly one value
+        bool parseDocument( JsonValue &outValue )
+        {
+            const bool retVal = parseValue( outValue );
+            skipWhitespace();
+            return retVal && mPos == mEnd;
+        }
+    };
+
+    struct TraceEvent
+    {
+        String name;
+        uint64 ts;
+        uint64 dur;
+    };
+
+    struct TimelineTrace
+    {
+        /// Complete ("X") events of each thread, in the order they were written
+        std::map<uint64, std::vector<TraceEvent> > eventsPerThread;
+        std::map<uint64, String>                   threadNames;
+        size_t                                     numFrames;
+    };
+
+    /// Checks it's valid JSON in the trace event format, and collects its events
+    void parseTimeline( const String &json, TimelineTrace &outTrace )
+    {
+        JsonValue root;
+        JsonParser parser( json );
+        CPPUNIT_ASSERT( parser.parseDocument( root ) );
+        CPPUNIT_ASSERT( root.type == JsonValue::Object );
+
+        const JsonValue *traceEvents = root.find( "traceEvents" );
+        CPPUNIT_ASSERT( traceEvents && traceEvents->type == JsonValue::Array );
+
+        outTrace.numFrames = 0u;
+        for( size_t i = 0u; i < traceEvents->array.size(); ++i )
+        {
+            const JsonValue &event = traceEvents->array[i];
+            CPPUNIT_ASSERT( event.type == JsonValue::Object );
+
+            const JsonValue *name = event.find( "name" );
+            const JsonValue *ph = event.find( "ph" );
+            const JsonValue *pid = event.find( "pid" );
+            CPPUNIT_ASSERT( name && name->type == JsonValue::Str );
+            CPPUNIT_ASSERT( ph && ph->type == JsonValue::Str );
+            CPPUNIT_ASSERT( pid && pid->type == JsonValue::Number );
+
+            const JsonValue *tid = event.find( "tid" );
+            if( ph->str == "X" )
+            {
+                const JsonValue *ts = event.find( "ts" );
+                const JsonValue *dur = event.find( "dur" );
+                CPPUNIT_ASSERT( tid && tid->type == JsonValue::Number );
+                CPPUNIT_ASSERT( ts && ts->type == JsonValue::Number );
+                CPPUNIT_ASSERT( dur && dur->type == JsonValue::Number );
+
+                TraceEvent traceEvent;
+                traceEvent.name = name->str;
+                traceEvent.ts = static_cast<uint64>( ts->number );
+                traceEvent.dur = static_cast<uint64>( dur->number );
+                outTrace.eventsPerThread[static_cast<uint64>( tid->number )].push_back( traceEvent );
+            }
+            else if( ph->str == "M" && name->str == "thread_name" )
+            {
+                const JsonValue *args = event.find( "args" );
+                CPPUNIT_ASSERT( tid && args );
+                const JsonValue *threadName = args->find( "name" );
+                CPPUNIT_ASSERT( threadName && threadName->type == JsonValue::Str );
+                outTrace.threadNames[static_cast<uint64>( tid->number )] = threadName->str;
+            }
+            else if( ph->str == "i" )
+            {
+                CPPUNIT_ASSERT_EQUAL( String( "Frame" ), name->str );
+                ++outTrace.numFrames;
+            }
+        }
+    }
+
+    /// Samples of a thread are written depth first. Each one must begin after and end
+    /// before its parent, and after its previous sibling ended; i.e. if we turn them into
+    /// begin/end event pairs, they're balanced.
+    /// Returns the maximum depth.
+    size_t checkBalanced( const std::vector<TraceEvent> &events )
+    {
+        size_t maxDepth = 0u;
+        // Ends of the samples still open at each point
+        std::vector<uint64> openEnds;
+        for( size_t i = 0u; i < events.size(); ++i )
+        {
+            const TraceEvent &event = events[i];
+            while( !openEnds.empty() && event.ts >= openEnds.back() )
+                openEnds.pop_back();
+            if( !openEnds.empty() )
+                CPPUNIT_ASSERT( event.ts + event.dur <= openEnds.back() );
+            openEnds.push_back( event.ts + event.dur );
+            maxDepth = std::max( maxDepth, openEnds.size() );
+        }
+        return maxDepth;
+    }
+
+    size_t countEvents( const std::vector<TraceEvent> &events, const String &name )
+    {
+        size_t retVal = 0u;
+        for( size_t i = 0u; i < events.size(); ++i )
+        {
+            if( events[i].name == name )
+                ++retVal;
+        }
+        return retVal;
+    }
+
+    const size_t c_numSamplesPerWorker = 10u;
+
+    void profileWork( OfflineProfiler *profiler )
+    {
+        profiler->profileBegin( "Work", ProfileSampleFlags::FlagsNone );
+        for( size_t i = 0u; i < 3u; ++i )
+        {
+            profiler->profileBegin( "Step", ProfileSampleFlags::FlagsNone );
+            Threads::Sleep( 1u );
+            profiler->profileEnd();
+        }
+        profiler->profileEnd();
+    }
+
+    unsigned long profilerWorkerThread( ThreadHandle *threadHandle )
+    {
+        OfflineProfiler *profiler = reinterpret_cast<OfflineProfiler *>( threadHandle->getUserParam() );
+        profiler->setCurrentThreadName(
+            ( "Worker " + StringConverter::toString( threadHandle->getThreadIdx() ) ).c_str() );
+        for( size_t i = 0u; i < c_numSamplesPerWorker; ++i )
+            profileWork( profiler );
+        return 0;
+    }
+    THREAD_DECLARE( profilerWorkerThread );
+}
+//--------------------------------------------------------------------------
+void OfflineProfilerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void OfflineProfilerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void OfflineProfilerTests::testTimelineMultiThread()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OfflineProfiler profiler;
+    // Must be escaped
+    profiler.setCurrentThreadName( "Main \"Thread\" \\" );
+
+    const size_t numWorkers = 3u;
+    ThreadHandleVec threadHandles;
+    for( size_t i = 0u; i < numWorkers; ++i )
+    {
+        threadHandles.push_back(
+            Threads::CreateThread( THREAD_GET( profilerWorkerThread ), i, &profiler ) );
+    }
+
+    for( size_t i = 0u; i < 2u; ++i )
+    {
+        profiler.markFrame();
+        profiler.profileBegin( "Frame \"Begin\"", ProfileSampleFlags::FlagsNone );
+        profileWork( &profiler );
+        // Merged into one sample that spans the three of them
+        for( size_t j = 0u; j < 3u; ++j )
+        {
+            profiler.profileBegin( "Aggregated", ProfileSampleFlags::Aggregate );
+            profiler.profileEnd();
+        }
+        profiler.profileEnd();
+    }
+
+    Threads::WaitForThreads( threadHandles );
+
+    String json;
+    profiler.dumpTimelineStr( json );
+
+    TimelineTrace trace;
+    parseTimeline( json, trace );
+
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), trace.numFrames );
+    CPPUNIT_ASSERT_EQUAL( numWorkers + 1u, trace.eventsPerThread.size() );
+    CPPUNIT_ASSERT_EQUAL( numWorkers + 1u, trace.threadNames.size() );
+
+    std::map<uint64, std::vector<TraceEvent> >::const_iterator itor = trace.eventsPerThread.begin();
+    std::map<uint64, std::vector<TraceEvent> >::const_iterator endt = trace.eventsPerThread.end();
+
+    size_t numWorkersFound = 0u;
+    while( itor != endt )
+    {
+        const std::vector<TraceEvent> &events = itor->second;
+        const String &threadName = trace.threadNames[itor->first];
+        if( threadName == "Main \"Thread\" \\" )
+        {
+            CPPUNIT_ASSERT_EQUAL( size_t( 3u ), checkBalanced( events ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 2u ), countEvents( events, "Frame \"Begin\"" ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 2u ), countEvents( events, "Work" ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 6u ), countEvents( events, "Step" ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 2u ), countEvents( events, "Aggregated" ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 12u ), events.size() );
+        }
+        else
+        {
+            CPPUNIT_ASSERT_EQUAL( String( "Worker " ), threadName.substr( 0u, 7u ) );
+            CPPUNIT_ASSERT_EQUAL( size_t( 2u ), checkBalanced( events ) );
+            CPPUNIT_ASSERT_EQUAL( c_numSamplesPerWorker, countEvents( events, "Work" ) );
+            CPPUNIT_ASSERT_EQUAL( c_numSamplesPerWorker * 3u, countEvents( events, "Step" ) );
+            CPPUNIT_ASSERT_EQUAL( c_numSamplesPerWorker * 4u, events.size() );
+            ++numWorkersFound;
+        }
+        ++itor;
+    }
+    CPPUNIT_ASSERT_EQUAL( numWorkers, numWorkersFound );
+}
+//--------------------------------------------------------------------------
+void OfflineProfilerTests::testTimelineOpenSamples()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    OfflineProfiler profiler;
+
+    // Dump from inside a sample, e.g. from a key press handler
+    profiler.profileBegin( "Outer", ProfileSampleFlags::FlagsNone );
+    profiler.profileBegin( "Open", ProfileSampleFlags::FlagsNone );
+    Threads::Sleep( 2u );
+    profiler.profileBegin( "Closed", ProfileSampleFlags::FlagsNone );
+    Threads::Sleep( 2u );
+    profiler.profileEnd();
+    Threads::Sleep( 2u );
+
+    String json;
+    profiler.dumpTimelineStr( json );
+
+    profiler.profileEnd();
+    profiler.profileEnd();
+
+    TimelineTrace trace;
+    parseTimeline( json, trace );
+
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), trace.eventsPerThread.size() );
+    const std::vector<TraceEvent> &events = trace.eventsPerThread.begin()->second;
+    CPPUNIT_ASSERT_EQUAL( size_t( 3u ), events.size() );
+    CPPUNIT_ASSERT_EQUAL( size_t( 3u ), checkBalanced( events ) );
+    // The open ones last at least until the closed one ended, plus the time slept after it
+    CPPUNIT_ASSERT( events[1].ts + events[1].dur >= events[2].ts + events[2].dur + 2000u );
+}
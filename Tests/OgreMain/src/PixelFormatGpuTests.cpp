@@ -0,0 +1,189 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "PixelFormatGpuTests.h"
+#include "OgreBitwise.h"
+#include "OgreLogManager.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureBox.h"
+#include "OgreTimer.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(PixelFormatGpuTests);
+
+namespace
+{
+    const PixelFormatGpu c_formatPairs[][2] =
+    {
+        { PFG_RGB8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGB8_UNORM, PFG_BGRA8_UNORM },
+        { PFG_BGR8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_BGRA8_UNORM },
+        { PFG_BGRA8_UNORM, PFG_RGBA8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_RGBA16_FLOAT },
+        { PFG_RGBA8_UNORM, PFG_RGBA32_FLOAT },
+        { PFG_BGRA8_UNORM_SRGB, PFG_RGBA32_FLOAT },
+        { PFG_RGBA8_UNORM_SRGB, PFG_RGBA8_UNORM },
+        { PFG_RGBA8_UNORM, PFG_BGRA8_UNORM_SRGB },
+        { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM },
+        { PFG_RGBA32_FLOAT, PFG_BGRA8_UNORM },
+        { PFG_RGBA32_FLOAT, PFG_RGBA8_UNORM_SRGB },
+        { PFG_RGBA16_FLOAT, PFG_RGBA8_UNORM },
+        { PFG_RGBA16_FLOAT, PFG_BGRA8_UNORM_SRGB },
+        { PFG_RGBA32_FLOAT, PFG_RGBA16_FLOAT },
+    };
+
+    void fillRandom( vector<uint8>::type &data, PixelFormatGpu format )
+    {
+        // Floats slightly out of [0; 1] to also exercise the clamping
+        if( format == PFG_RGBA32_FLOAT )
+        {
+            float *values = reinterpret_cast<float *>( &data[0] );
+            for( size_t i = 0; i < data.size() / sizeof( float ); ++i )
+                values[i] = static_cast<float>( rand() % 3000 ) / 2550.0f - 0.1f;
+        }
+        else if( format == PFG_RGBA16_FLOAT )
+        {
+            uint16 *values = reinterpret_cast<uint16 *>( &data[0] );
+            for( size_t i = 0; i < data.size() / sizeof( uint16 ); ++i )
+            {
+                values[i] =
+                    Bitwise::floatToHalf( static_cast<float>( rand() % 3000 ) / 2550.0f - 0.1f );
+            }
+        }
+        else
+        {
+            for( size_t i = 0; i < data.size(); ++i )
+                data[i] = static_cast<uint8>( rand() );
+        }
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void PixelFormatGpuTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand( 0 );
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuTests::tearDown()
+{
+    PixelFormatGpuUtils::setMaxBulkConversionThreads( 1u );
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuTests::testCase( PixelFormatGpu srcFormat, PixelFormatGpu dstFormat,
+                                    uint32 width, uint32 height, bool verticalFlip )
+{
+    const uint32 srcBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( srcFormat );
+    const uint32 dstBytesPerPixel = PixelFormatGpuUtils::getBytesPerPixel( dstFormat );
+    // Padding at the end of each row, to catch out of bounds writes
+    const uint32 srcBytesPerRow = width * srcBytesPerPixel + 8u;
+    const uint32 dstBytesPerRow = width * dstBytesPerPixel + 4u;
+
+    vector<uint8>::type src( srcBytesPerRow * height );
+    fillRandom( src, srcFormat );
+
+    vector<uint8>::type naive( dstBytesPerRow * height, 0xCD );
+    vector<uint8>::type bulk( dstBytesPerRow * height, 0xCD );
+
+    float rgba[4];
+    for( uint32 y = 0; y < height; ++y )
+    {
+        const uint32 dstY = verticalFlip ? height - 1u - y : y;
+        for( uint32 x = 0; x < width; ++x )
+        {
+            PixelFormatGpuUtils::unpackColour( rgba, srcFormat,
+                                               &src[y * srcBytesPerRow + x * srcBytesPerPixel] );
+            PixelFormatGpuUtils::packColour( rgba, dstFormat,
+                                             &naive[dstY * dstBytesPerRow + x * dstBytesPerPixel] );
+        }
+    }
+
+    TextureBox srcBox( width, height, 1u, 1u, srcBytesPerPixel, srcBytesPerRow,
+                       srcBytesPerRow * height );
+    srcBox.data = &src[0];
+    TextureBox dstBox( width, height, 1u, 1u, dstBytesPerPixel, dstBytesPerRow,
+                       dstBytesPerRow * height );
+    dstBox.data = &bulk[0];
+
+    Timer timer;
+    PixelFormatGpuUtils::bulkPixelConversion( srcBox, srcFormat, dstBox, dstFormat, verticalFlip );
+    const uint64 elapsedUs = timer.getMicroseconds();
+
+    CPPUNIT_ASSERT( naive == bulk );
+
+    if( width * height >= 1024u * 1024u )
+    {
+        LogManager::getSingleton().logMessage(
+            "PixelFormatGpuTests: " + String( PixelFormatGpuUtils::toString( srcFormat ) ) +
+            " -> " + String( PixelFormatGpuUtils::toString( dstFormat ) ) + " " +
+            StringConverter::toString( width ) + "x" + StringConverter::toString( height ) + ": " +
+            StringConverter::toString( elapsedUs ) + " us. Threads: " +
+            StringConverter::toString( PixelFormatGpuUtils::getMaxBulkConversionThreads() ) );
+    }
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuTests::testBulkConversion()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Odd widths so that the SIMD paths also have leftover pixels
+    const uint32 c_widths[] = { 1u, 3u, 7u, 17u, 67u };
+
+    const size_t numPairs = sizeof( c_formatPairs ) / sizeof( c_formatPairs[0] );
+    for( size_t i = 0; i < numPairs; ++i )
+    {
+        for( size_t j = 0; j < sizeof( c_widths ) / sizeof( c_widths[0] ); ++j )
+        {
+            testCase( c_formatPairs[i][0], c_formatPairs[i][1], c_widths[j], 41u, false );
+            testCase( c_formatPairs[i][0], c_formatPairs[i][1], c_widths[j], 41u, true );
+        }
+        testCase( c_formatPairs[i][0], c_formatPairs[i][1], 1024u, 1024u, false );
+    }
+}
+//--------------------------------------------------------------------------
+void PixelFormatGpuTests::testBulkConversionThreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PixelFormatGpuUtils::setMaxBulkConversionThreads( 4u );
+
+    const size_t numPairs = sizeof( c_formatPairs ) / sizeof( c_formatPairs[0] );
+    for( size_t i = 0; i < numPairs; ++i )
+    {
+        testCase( c_formatPairs[i][0], c_formatPairs[i][1], 1024u, 1024u, false );
+        testCase( c_formatPairs[i][0], c_formatPairs[i][1], 1021u, 1023u, true );
+    }
+
+    // Brute force fallback
+    testCase( PFG_RGBA8_UNORM, PFG_RGBA8_SNORM, 1024u, 1024u, false );
+}
@@ -27,7 +27,9 @@ THE SOFTWARE.
 */
 #include "RadixSortTests.h"
 #include "OgreRadixSort.h"
+#include "OgreRadixSort64.h"
 #include "OgreMath.h"
+#include "Threading/OgreTaskScheduler.h"
 
 #include "UnitTestSuite.h"
 
@@ -219,5 +221,270 @@ void RadixSortTests::testIntVector()
     }
 }
 //--------------------------------------------------------------------------
+static uint64 randomUint64()
+{
+    uint64 retVal = 0;
+    for (int i = 0; i < 4; ++i)
+        retVal = (retVal << 16u) | (uint64)(rand() & 0xFFFF);
+    return retVal;
+}
+//--------------------------------------------------------------------------
+/// Checks the entries are in ascending key order, and entries with equal keys kept their
+/// original order (i.e. the idx it was given when filling the array).
+static void checkSortedAndStable(const RadixSort64::EntryArray& entries, size_t expectedSize)
+{
+    CPPUNIT_ASSERT_EQUAL(expectedSize, entries.size());
+
+    std::vector<bool> seen(expectedSize, false);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        CPPUNIT_ASSERT(entries[i].idx < expectedSize);
+        CPPUNIT_ASSERT(!seen[entries[i].idx]);
+        seen[entries[i].idx] = true;
+
+        if (i > 0)
+        {
+            CPPUNIT_ASSERT(entries[i - 1].key <= entries[i].key);
+            if (entries[i - 1].key == entries[i].key)
+                CPPUNIT_ASSERT(entries[i - 1].idx < entries[i].idx);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void RadixSortTests::testUint64Keys()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RadixSort64 sorter;
+    RadixSort64::EntryArray entries;
+
+    // Few distinct values, so there are plenty of repeated keys to check stability
+    for (uint32 i = 0; i < 5000; ++i)
+    {
+        RadixSort64::Entry entry;
+        entry.key = randomUint64() % 300u + ((uint64)(rand() % 3) << 60u);
+        entry.idx = i;
+        entries.push_back(entry);
+    }
+
+    sorter.sort(entries);
+    checkSortedAndStable(entries, 5000u);
+
+    // Small arrays take a different path
+    entries.clear();
+    for (uint32 i = 0; i < 20; ++i)
+    {
+        RadixSort64::Entry entry;
+        entry.key = (uint64)(rand() % 5);
+        entry.idx = i;
+        entries.push_back(entry);
+    }
+
+    sorter.sort(entries);
+    checkSortedAndStable(entries, 20u);
+}
+//--------------------------------------------------------------------------
+void RadixSortTests::testUint64ConstantBytes()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RadixSort64 sorter;
+    RadixSort64::EntryArray entries;
+
+    // Only bytes 1 and 6 vary. The rest must be skipped without breaking the result,
+    // including when an odd number of passes leaves the result in the scratch array.
+    for (uint32 i = 0; i < 1000; ++i)
+    {
+        RadixSort64::Entry entry;
+        entry.key = 0xAB00CD00EF0012ABull | ((uint64)(rand() & 0xFF) << 8u) |
+                    ((uint64)(rand() & 0xFF) << 48u);
+        entry.idx = i;
+        entries.push_back(entry);
+    }
+
+    sorter.sort(entries);
+    checkSortedAndStable(entries, 1000u);
+
+    for (size_t i = 0; i < entries.size(); ++i)
+        entries[i].key = 0xAB00CD00EF0012ABull | ((uint64)(rand() & 0xFF) << 8u);
+
+    sorter.sort(entries);
+    for (size_t i = 1; i < entries.size(); ++i)
+        CPPUNIT_ASSERT(entries[i - 1].key <= entries[i].key);
+
+    // All keys equal: nothing to do
+    for (uint32 i = 0; i < entries.size(); ++i)
+    {
+        entries[i].key = 0x0123456789ABCDEFull;
+        entries[i].idx = i;
+    }
+
+    sorter.sort(entries);
+    checkSortedAndStable(entries, 1000u);
+}
+//--------------------------------------------------------------------------
+void RadixSortTests::testUint64Parallel()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler(3u);
+    RadixSort64 sorter;
+    sorter.setParallelThreshold(0u);
 
+    RadixSort64::EntryArray entries;
+    for (uint32 i = 0; i < 50000; ++i)
+    {
+        RadixSort64::Entry entry;
+        entry.key = randomUint64() & 0xFFFF0000FFFFFFFFull;
+        if (i % 7u == 0u)
+            entry.key = 42u;
+        entry.idx = i;
+        entries.push_back(entry);
+    }
+
+    sorter.sort(entries, &taskScheduler);
+    checkSortedAndStable(entries, 50000u);
+}
+//--------------------------------------------------------------------------
+void RadixSortTests::testUint64InsertionSort()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RadixSort64::EntryArray entries;
+    for (uint32 i = 0; i < 1000; ++i)
+    {
+        RadixSort64::Entry entry;
+        entry.key = i * 2u;
+        entry.idx = i;
+        entries.push_back(entry);
+    }
+
+    // Almost sorted (like last frame's order): a few neighbours swapped
+    for (size_t i = 10; i < entries.size(); i += 100)
+        std::swap(entries[i].key, entries[i + 1].key);
+
+    CPPUNIT_ASSERT(RadixSort64::insertionSort(entries.begin(), entries.end(), 100u));
+    for (size_t i = 1; i < entries.size(); ++i)
+        CPPUNIT_ASSERT(entries[i - 1].key <= entries[i].key);
+
+    // Reversed: it must give up without losing entries
+    for (uint32 i = 0; i < entries.size(); ++i)
+    {
+        entries[i].key = entries.size() - i;
+        entries[i].idx = i;
+    }
+
+    CPPUNIT_ASSERT(!RadixSort64::insertionSort(entries.begin(), entries.end(), 100u));
+
+    std::vector<bool> seen(entries.size(), false);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        CPPUNIT_ASSERT(!seen[entries[i].idx]);
+        seen[entries[i].idx] = true;
+    }
+}
+//--------------------------------------------------------------------------
+void RadixSortTests::testUint64FrameCoherent()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RadixSort64 sorter;
+    FrameCoherentSortOrder frameCoherentOrder;
+
+    // Objects with a stable id and a sort key (like renderables and their hash)
+    const size_t numObjects = 2000u;
+    std::vector<uint64> objectIds(numObjects);
+    std::vector<uint64> objectKeys(numObjects);
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        objectIds[i] = randomUint64();
+        objectKeys[i] = randomUint64() & 0x0000FFFFFFFFFFFFull;
+    }
+
+    std::vector<size_t> gatherOrder(numObjects);
+    for (size_t i = 0; i < numObjects; ++i)
+        gatherOrder[i] = i;
+
+    RadixSort64::EntryArray entries;
+    FastArray<uint64> ids;
+
+    // Gathers the objects in the given order and sorts them. Returns whether the
+    // remembered order was good enough for the insertion sort
+    struct Frame
+    {
+        static bool run(FrameCoherentSortOrder &order, RadixSort64 &radixSort,
+                        const std::vector<size_t> &gather, const std::vector<uint64> &keys,
+                        const std::vector<uint64> &objIds, RadixSort64::EntryArray &outEntries,
+                        FastArray<uint64> &outIds)
+        {
+            outEntries.resizePOD(gather.size());
+            outIds.resizePOD(gather.size());
+            for (size_t i = 0; i < gather.size(); ++i)
+            {
+                outEntries[i].key = keys[gather[i]];
+                outEntries[i].idx = static_cast<uint32>(i);
+                outIds[i] = objIds[gather[i]];
+            }
+            return order.sort(outEntries, outIds.begin(), radixSort);
+        }
+    };
+
+    // First frame: nothing to start from
+    CPPUNIT_ASSERT(!Frame::run(frameCoherentOrder, sorter, gatherOrder, objectKeys, objectIds,
+                               entries, ids));
+    checkSortedAndStable(entries, numObjects);
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        // The objects are gathered in a different order every frame (e.g. the worker
+        // threads cull them in a different order) and a few hashes change
+        for (size_t i = numObjects - 1u; i > 0; --i)
+            std::swap(gatherOrder[i], gatherOrder[static_cast<size_t>(rand()) % (i + 1u)]);
+        for (size_t i = 0; i < 10u; ++i)
+            objectKeys[static_cast<size_t>(rand()) % numObjects] += 1u;
+
+        // Steady state: the order from last frame must be reused
+        CPPUNIT_ASSERT(Frame::run(frameCoherentOrder, sorter, gatherOrder, objectKeys, objectIds,
+                                  entries, ids));
+        for (size_t i = 1; i < entries.size(); ++i)
+            CPPUNIT_ASSERT(entries[i - 1].key <= entries[i].key);
+    }
+
+    // Some objects go away and a couple of new ones appear
+    {
+        std::vector<size_t> newGather(gatherOrder.begin() + 50, gatherOrder.end());
+        for (size_t i = 0; i < 3u; ++i)
+        {
+            objectIds.push_back(randomUint64());
+            objectKeys.push_back(randomUint64() & 0x0000FFFFFFFFFFFFull);
+            newGather.push_back(objectIds.size() - 1u);
+        }
+        gatherOrder.swap(newGather);
+
+        CPPUNIT_ASSERT(Frame::run(frameCoherentOrder, sorter, gatherOrder, objectKeys, objectIds,
+                                  entries, ids));
+        std::vector<bool> seen(entries.size(), false);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            CPPUNIT_ASSERT(!seen[entries[i].idx]);
+            seen[entries[i].idx] = true;
+            if (i > 0)
+                CPPUNIT_ASSERT(entries[i - 1].key <= entries[i].key);
+        }
+    }
 
+    // Most objects replaced: it must fall back to the radix sort
+    {
+        for (size_t i = 0; i < gatherOrder.size() / 2u; ++i)
+        {
+            objectIds.push_back(randomUint64());
+            objectKeys.push_back(randomUint64() & 0x0000FFFFFFFFFFFFull);
+            gatherOrder[i] = objectIds.size() - 1u;
+        }
+
+        CPPUNIT_ASSERT(!Frame::run(frameCoherentOrder, sorter, gatherOrder, objectKeys, objectIds,
+                                   entries, ids));
+        checkSortedAndStable(entries, gatherOrder.size());
+    }
+}
+//--------------------------------------------------------------------------
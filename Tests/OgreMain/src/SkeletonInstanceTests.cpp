@@ -0,0 +1,516 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "SkeletonInstanceTests.h"
+#include "Animation/OgreBone.h"
+#include "Animation/OgreSkeletonAnimation.h"
+#include "Animation/OgreSkeletonDef.h"
+#include "Animation/OgreSkeletonInstance.h"
+#include "Math/Array/OgreBoneMemoryManager.h"
+#include "OgreAnimation.h"
+#include "OgreAnimationTrack.h"
+#include "OgreKeyFrame.h"
+#include "OgreMovableObject.h"
+#include "OgreOldBone.h"
+#include "OgreSkeleton.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SkeletonInstanceTests);
+
+namespace
+{
+    enum TestBones
+    {
+        BoneRoot,
+        BoneArmL,
+        BoneArmR,
+        BoneFinger0,
+        BoneFinger1,
+        BoneFinger2,
+        NumTestBones
+    };
+
+    const char *c_boneNames[NumTestBones] = { "Root",    "ArmL",    "ArmR",
+                                              "Finger0", "Finger1", "Finger2" };
+
+    /** One root, two arms and three fingers hanging from the left arm. With SIMD, the
+        root and arms of several instances are packed in the same blocks (each instance
+        uses different lanes), while the fingers of each instance start a block of their own.
+    */
+    const v1::Skeleton *buildOldSkeleton( v1::Skeleton &skeleton )
+    {
+        v1::OldBone *bones[NumTestBones];
+        for( size_t i = 0; i < NumTestBones; ++i )
+            bones[i] = skeleton.createBone( c_boneNames[i], static_cast<unsigned short>( i ) );
+
+        bones[BoneRoot]->addChild( bones[BoneArmL] );
+        bones[BoneRoot]->addChild( bones[BoneArmR] );
+        bones[BoneArmL]->setPosition( Vector3( -1.0f, 1.0f, 0.0f ) );
+        bones[BoneArmR]->setPosition( Vector3( 1.0f, 1.0f, 0.0f ) );
+        for( size_t i = BoneFinger0; i <= BoneFinger2; ++i )
+        {
+            bones[BoneArmL]->addChild( bones[i] );
+            bones[i]->setPosition( Vector3( Real( i - BoneFinger0 ) * 0.2f, -0.5f, 0.0f ) );
+        }
+        skeleton.setBindingPose();
+
+        // Every bone moves and rotates at a different speed
+        v1::Animation *animation = skeleton.createAnimation( "Walk", 100.0f );
+        for( size_t i = 0; i < NumTestBones; ++i )
+        {
+            v1::OldNodeAnimationTrack *track =
+                animation->createOldNodeTrack( static_cast<unsigned short>( i ), bones[i] );
+
+            v1::TransformKeyFrame *keyFrame = track->createNodeKeyFrame( 0.0f );
+            keyFrame->setTranslate( Vector3::ZERO );
+            keyFrame->setRotation( Quaternion::IDENTITY );
+
+            Vector3 axis( 1.0f, Real( i ), 0.5f );
+            axis.normalise();
+            keyFrame = track->createNodeKeyFrame( 100.0f );
+            keyFrame->setTranslate( Vector3( Real( i + 1u ), Real( i ) * 0.5f, -Real( i ) ) * 10.0f );
+            keyFrame->setRotation( Quaternion( Radian( 1.0f + Real( i ) * 0.25f ), axis ) );
+        }
+
+        return &skeleton;
+    }
+
+    struct TestSkeleton
+    {
+        v1::Skeleton oldSkeleton;
+        SkeletonDef  definition;
+
+        TestSkeleton() :
+            oldSkeleton( 0, "SkeletonInstanceTests", 0, "General" ),
+            definition( buildOldSkeleton( oldSkeleton ), 1.0f )
+        {
+        }
+    };
+
+    /// Stands in for the Item that drives the update LOD
+    class TestLodSource final : public MovableObject
+    {
+    public:
+        TestLodSource() : MovableObject( (ObjectData *)0 ) {}
+
+        void setCurrentMeshLod( uint8 lod ) { mCurrentMeshLod = lod; }
+
+        const String &getMovableType() const override { return BLANKSTRING; }
+    };
+
+    struct BonePose
+    {
+        Vector3    position;
+        Quaternion orientation;
+        Vector3    scale;
+    };
+    typedef std::vector<BonePose> SkeletonPose;
+
+    SkeletonPose getPose( SkeletonInstance &instance )
+    {
+        SkeletonPose retVal;
+        for( size_t i = 0; i < instance.getNumBones(); ++i )
+        {
+            const Bone *bone = instance.getBone( i );
+            BonePose bonePose;
+            bonePose.position = bone->getPosition();
+            bonePose.orientation = bone->getOrientation();
+            bonePose.scale = bone->getScale();
+            retVal.push_back( bonePose );
+        }
+        return retVal;
+    }
+
+    bool bonePosesMatch( const BonePose &a, const BonePose &b, Real tolerance )
+    {
+        // acos( dot ) is too imprecise for such small angles. Use the chord instead
+        const Quaternion diff = a.orientation.Dot( b.orientation ) < 0.0f
+                                    ? a.orientation + b.orientation
+                                    : a.orientation - b.orientation;
+        return a.position.positionEquals( b.position, tolerance ) &&
+               Math::Sqrt( diff.Norm() ) <= tolerance && a.scale.positionEquals( b.scale, tolerance );
+    }
+
+    bool posesMatch( const SkeletonPose &a, const SkeletonPose &b, Real tolerance )
+    {
+        bool retVal = a.size() == b.size();
+        for( size_t i = 0; i < a.size() && retVal; ++i )
+            retVal = bonePosesMatch( a[i], b[i], tolerance );
+        return retVal;
+    }
+
+    /// What SkeletonInstance does in the frames between two evaluations
+    SkeletonPose interpolatePoses( const SkeletonPose &a, const SkeletonPose &b, Real alpha )
+    {
+        SkeletonPose retVal( a.size() );
+        for( size_t i = 0; i < a.size(); ++i )
+        {
+            retVal[i].position = Math::lerp( a[i].position, b[i].position, alpha );
+            retVal[i].orientation = Quaternion::nlerp( alpha, a[i].orientation, b[i].orientation, true );
+            retVal[i].scale = Math::lerp( a[i].scale, b[i].scale, alpha );
+        }
+        return retVal;
+    }
+
+    SkeletonAnimation *playWalk( SkeletonInstance &instance )
+    {
+        SkeletonAnimation *animation = instance.getAnimation( "Walk" );
+        animation->setEnabled( true );
+        return animation;
+    }
+
+    /// Time is not linear in frames, so that interpolating two poses differs from
+    /// evaluating the frames in between.
+    Real getAnimationTime( size_t frame ) { return Real( frame * frame ) * 0.05f; }
+
+    const Real c_tolerance = 1e-3f;
+
+    /// Where user code (e.g. IK) places the manual bones in a given frame
+    BonePose getManualPose( size_t boneIdx, size_t frame )
+    {
+        BonePose retVal;
+        retVal.position = Vector3( 5.0f, Real( boneIdx ), -Real( frame ) );
+        retVal.orientation = Quaternion( Radian( Real( frame + boneIdx ) * 0.1f ), Vector3::UNIT_Z );
+        retVal.scale = Vector3( 2.0f );
+        return retVal;
+    }
+
+    void setManualPoses( SkeletonInstance &instance, const size_t manualBones[2], size_t frame )
+    {
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            const BonePose pose = getManualPose( manualBones[i], frame );
+            Bone *bone = instance.getBone( manualBones[i] );
+            bone->setPosition( pose.position );
+            bone->setOrientation( pose.orientation );
+            bone->setScale( pose.scale );
+        }
+    }
+
+    bool manualPosesKept( SkeletonInstance &instance, const size_t manualBones[2], size_t frame )
+    {
+        const SkeletonPose pose = getPose( instance );
+        return bonePosesMatch( pose[manualBones[0]], getManualPose( manualBones[0], frame ),
+                               c_tolerance ) &&
+               bonePosesMatch( pose[manualBones[1]], getManualPose( manualBones[1], frame ),
+                               c_tolerance );
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::testUpdateLod()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t interval = 4u;
+    const size_t numFrames = 40u;
+
+    TestSkeleton skeleton;
+    BoneMemoryManager boneMemoryManager;
+    SkeletonInstance reference( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance lodInstance( &skeleton.definition, &boneMemoryManager );
+
+    TestLodSource lodSource;
+    lodSource.setCurrentMeshLod( 1u );
+    FastArray<uint8> updateIntervals;
+    updateIntervals.push_back( 1u );
+    updateIntervals.push_back( static_cast<uint8>( interval ) );
+    lodInstance.setUpdateLod( &lodSource, updateIntervals );
+
+    SkeletonAnimation *referenceAnim = playWalk( reference );
+    SkeletonAnimation *lodAnim = playWalk( lodInstance );
+
+    std::vector<SkeletonPose> referencePoses;
+    std::vector<SkeletonPose> lodPoses;
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        referenceAnim->setTime( getAnimationTime( i ) );
+        reference.update();
+        referencePoses.push_back( getPose( reference ) );
+
+        lodAnim->setTime( getAnimationTime( i ) );
+        lodInstance.update();
+        lodPoses.push_back( getPose( lodInstance ) );
+    }
+
+    // The first evaluation happens right away. The second one is staggered per instance,
+    // and is shown on the frame after it, when we start moving away from the first pose.
+    size_t secondEvaluation = 1u;
+    while( secondEvaluation + 1u < numFrames &&
+           posesMatch( lodPoses[secondEvaluation + 1u], referencePoses[0], c_tolerance ) )
+    {
+        ++secondEvaluation;
+    }
+    CPPUNIT_ASSERT( secondEvaluation <= interval );
+
+    // From then on, evaluated once every interval frames. The pose lags one interval behind,
+    // and the frames in between interpolate the last two evaluations.
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        SkeletonPose expected = referencePoses[0];
+        if( i > secondEvaluation )
+        {
+            const size_t framesSinceEvaluation = ( i - secondEvaluation ) % interval;
+            const size_t lastEvaluation = i - framesSinceEvaluation;
+            const size_t prevEvaluation =
+                lastEvaluation == secondEvaluation ? 0u : lastEvaluation - interval;
+            expected = interpolatePoses( referencePoses[prevEvaluation], referencePoses[lastEvaluation],
+                                         Real( framesSinceEvaluation ) / Real( interval ) );
+        }
+        CPPUNIT_ASSERT( posesMatch( lodPoses[i], expected, c_tolerance ) );
+    }
+    CPPUNIT_ASSERT( !posesMatch( lodPoses.back(), referencePoses.back(), c_tolerance ) );
+
+    // Back to LOD 0: evaluated every frame again
+    lodSource.setCurrentMeshLod( 0u );
+    for( size_t i = numFrames; i < numFrames + interval; ++i )
+    {
+        referenceAnim->setTime( getAnimationTime( i ) );
+        reference.update();
+        lodAnim->setTime( getAnimationTime( i ) );
+        lodInstance.update();
+        CPPUNIT_ASSERT( posesMatch( getPose( lodInstance ), getPose( reference ), c_tolerance ) );
+    }
+}
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::testPoseSharing()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numFrames = 10u;
+    const Real frameQuantum = 1.0f;
+
+    TestSkeleton skeleton;
+    BoneMemoryManager boneMemoryManager;
+    SkeletonInstance provider( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance sharer( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance lateSharer( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance reference( &skeleton.definition, &boneMemoryManager );
+
+    // Copying the pose must cope with each instance using different lanes
+    if( ARRAY_PACKED_REALS > 1u )
+    {
+        CPPUNIT_ASSERT( provider.getBone( BoneRoot )->_getTransform().mIndex !=
+                        sharer.getBone( BoneRoot )->_getTransform().mIndex );
+        CPPUNIT_ASSERT( provider.getBone( BoneArmL )->_getTransform().mIndex !=
+                        sharer.getBone( BoneArmL )->_getTransform().mIndex );
+    }
+
+    provider.setPoseSharing( frameQuantum );
+    sharer.setPoseSharing( frameQuantum );
+    lateSharer.setPoseSharing( frameQuantum );
+
+    SkeletonAnimation *providerAnim = playWalk( provider );
+    SkeletonAnimation *sharerAnim = playWalk( sharer );
+    SkeletonAnimation *lateSharerAnim = playWalk( lateSharer );
+    SkeletonAnimation *referenceAnim = playWalk( reference );
+
+    SkeletonInstance::SharedPoseMap sharedPoses;
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        // lateSharer is ahead, but still within the same quantum
+        const Real time = Real( i ) * 2.0f + 0.25f;
+        providerAnim->setTime( time );
+        sharerAnim->setTime( time );
+        lateSharerAnim->setTime( time + 0.5f );
+
+        sharedPoses.clear();
+        provider._update( sharedPoses );
+        sharer._update( sharedPoses );
+        lateSharer._update( sharedPoses );
+        CPPUNIT_ASSERT_EQUAL( size_t( 1u ), sharedPoses.size() );
+
+        referenceAnim->setTime( time );
+        reference.update();
+        const SkeletonPose referencePose = getPose( reference );
+
+        CPPUNIT_ASSERT( posesMatch( getPose( provider ), referencePose, c_tolerance ) );
+        CPPUNIT_ASSERT( posesMatch( getPose( sharer ), referencePose, c_tolerance ) );
+        CPPUNIT_ASSERT( posesMatch( getPose( lateSharer ), referencePose, c_tolerance ) );
+
+        // Evaluating lateSharer on its own gives a different pose, thus it was copied
+        referenceAnim->setTime( time + 0.5f );
+        reference.update();
+        CPPUNIT_ASSERT( !posesMatch( getPose( lateSharer ), getPose( reference ), c_tolerance ) );
+    }
+}
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::testPoseSharingBoneWeights()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Real frameQuantum = 1.0f;
+
+    TestSkeleton skeleton;
+    BoneMemoryManager boneMemoryManager;
+    SkeletonInstance unweighted( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance weighted( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance lateWeighted( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance reference( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance weightedReference( &skeleton.definition, &boneMemoryManager );
+
+    unweighted.setPoseSharing( frameQuantum );
+    weighted.setPoseSharing( frameQuantum );
+    lateWeighted.setPoseSharing( frameQuantum );
+
+    SkeletonAnimation *unweightedAnim = playWalk( unweighted );
+    SkeletonAnimation *weightedAnim = playWalk( weighted );
+    SkeletonAnimation *lateWeightedAnim = playWalk( lateWeighted );
+    SkeletonAnimation *referenceAnim = playWalk( reference );
+    SkeletonAnimation *weightedReferenceAnim = playWalk( weightedReference );
+
+    // One bone in a level whose blocks are shared by several instances, another
+    // in a level that starts its own block
+    const size_t weightedBones[] = { BoneArmL, BoneFinger1 };
+    for( size_t i = 0; i < 2u; ++i )
+    {
+        weightedAnim->setBoneWeight( c_boneNames[weightedBones[i]], 0.5f );
+        lateWeightedAnim->setBoneWeight( c_boneNames[weightedBones[i]], 0.5f );
+        weightedReferenceAnim->setBoneWeight( c_boneNames[weightedBones[i]], 0.5f );
+    }
+
+    SkeletonInstance::SharedPoseMap sharedPoses;
+    for( size_t i = 0; i < 6u; ++i )
+    {
+        const Real time = Real( i ) * 3.0f + 0.25f;
+        unweightedAnim->setTime( time );
+        weightedAnim->setTime( time );
+        lateWeightedAnim->setTime( time + 0.5f );
+
+        // Different per-bone weights must not share their pose
+        sharedPoses.clear();
+        unweighted._update( sharedPoses );
+        weighted._update( sharedPoses );
+        lateWeighted._update( sharedPoses );
+        CPPUNIT_ASSERT_EQUAL( size_t( 2u ), sharedPoses.size() );
+
+        referenceAnim->setTime( time );
+        reference.update();
+        weightedReferenceAnim->setTime( time );
+        weightedReference.update();
+        const SkeletonPose referencePose = getPose( reference );
+        const SkeletonPose weightedReferencePose = getPose( weightedReference );
+        CPPUNIT_ASSERT( !posesMatch( referencePose, weightedReferencePose, c_tolerance ) );
+
+        CPPUNIT_ASSERT( posesMatch( getPose( unweighted ), referencePose, c_tolerance ) );
+        CPPUNIT_ASSERT( posesMatch( getPose( weighted ), weightedReferencePose, c_tolerance ) );
+        // The same weights do share it
+        CPPUNIT_ASSERT(
+            posesMatch( getPose( lateWeighted ), weightedReferencePose, c_tolerance ) );
+    }
+}
+//--------------------------------------------------------------------------
+void SkeletonInstanceTests::testManualBones()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Real frameQuantum = 1.0f;
+
+    TestSkeleton skeleton;
+    BoneMemoryManager boneMemoryManager;
+    SkeletonInstance provider( &skeleton.definition, &boneMemoryManager );
+    SkeletonInstance manual( &skeleton.definition, &boneMemoryManager );
+
+    provider.setPoseSharing( frameQuantum );
+    manual.setPoseSharing( frameQuantum );
+
+    SkeletonAnimation *providerAnim = playWalk( provider );
+    SkeletonAnimation *manualAnim = playWalk( manual );
+
+    // One manual bone in a level whose blocks are shared by several instances, another
+    // in a level that starts its own block
+    const size_t manualBones[] = { BoneArmR, BoneFinger1 };
+    for( size_t i = 0; i < 2u; ++i )
+    {
+        manual.setManualBone( manual.getBone( manualBones[i] ), true );
+        manualAnim->setBoneWeight( c_boneNames[manualBones[i]], 0.0f );
+    }
+
+    SkeletonInstance::SharedPoseMap sharedPoses;
+    size_t frame = 0u;
+
+    // Instances with manual bones don't provide their pose to others
+    setManualPoses( manual, manualBones, frame );
+    manualAnim->setTime( 0.25f );
+    manual._update( sharedPoses );
+    CPPUNIT_ASSERT( sharedPoses.empty() );
+    CPPUNIT_ASSERT( manualPosesKept( manual, manualBones, frame ) );
+
+    for( size_t i = 0; i < 6u; ++i )
+    {
+        const Real time = Real( i ) * 3.0f + 0.25f;
+        providerAnim->setTime( time );
+        manualAnim->setTime( time + 0.5f );
+
+        ++frame;
+        setManualPoses( manual, manualBones, frame );
+
+        sharedPoses.clear();
+        provider._update( sharedPoses );
+        manual._update( sharedPoses );
+        CPPUNIT_ASSERT( manualPosesKept( manual, manualBones, frame ) );
+
+        // The rest of the pose was copied from provider
+        const SkeletonPose providerPose = getPose( provider );
+        const SkeletonPose manualPose = getPose( manual );
+        for( size_t j = 0; j < NumTestBones; ++j )
+        {
+            if( j != manualBones[0] && j != manualBones[1] )
+                CPPUNIT_ASSERT( bonePosesMatch( manualPose[j], providerPose[j], c_tolerance ) );
+        }
+    }
+
+    // Update LOD: the evaluated frames as well as the interpolated ones
+    TestLodSource lodSource;
+    FastArray<uint8> updateIntervals;
+    updateIntervals.push_back( 3u );
+    manual.setPoseSharing( 0 );
+    manual.setUpdateLod( &lodSource, updateIntervals );
+    for( size_t i = 0; i < 10u; ++i )
+    {
+        ++frame;
+        setManualPoses( manual, manualBones, frame );
+        manualAnim->setTime( getAnimationTime( i ) );
+        manual.update();
+        CPPUNIT_ASSERT( manualPosesKept( manual, manualBones, frame ) );
+    }
+    manual.setUpdateLod( 0, FastArray<uint8>() );
+}
@@ -0,0 +1,284 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "SkeletonTrackCompressionTests.h"
+#include "Animation/OgreSkeletonTrack.h"
+#include "Math/Array/OgreBoneTransform.h"
+#include "Math/Array/OgreKfTransform.h"
+#include "Math/Array/OgreKfTransformArrayMemoryManager.h"
+#include "Math/Array/OgreMathlib.h"
+#include "OgreLogManager.h"
+#include "OgreRawPtr.h"
+#include "OgreStringConverter.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SkeletonTrackCompressionTests);
+
+namespace
+{
+    typedef void ( *KeyFrameGenerator )( Real time, size_t slot, Vector3 &outPos, Quaternion &outRot,
+                                         Vector3 &outScale );
+
+    /// Every bone moves all the time at different speeds, like motion capture does
+    void motionCaptureKeyFrame( Real time, size_t slot, Vector3 &outPos, Quaternion &outRot,
+                                Vector3 &outScale )
+    {
+        const Real speed = 1.0f + Real( slot ) * 0.5f;
+        outPos = Vector3( Math::Sin( time * speed ) * 0.5f, Math::Cos( time * 0.7f ) * 0.2f + Real( slot ),
+                          time * 0.01f );
+        Vector3 axis( 1.0f, Math::Sin( time * 0.3f ), Real( slot ) * 0.25f );
+        axis.normalise();
+        outRot = Quaternion( Radian( Math::Sin( time * speed ) * 1.5f ), axis );
+        outScale = Vector3::UNIT_SCALE;
+    }
+
+    /// Only rotates
+    void rotationOnlyKeyFrame( Real time, size_t slot, Vector3 &outPos, Quaternion &outRot,
+                               Vector3 &outScale )
+    {
+        outPos = Vector3( 0.0f, Real( slot ), 0.0f );
+        outRot = Quaternion( Radian( time * ( 1.0f + Real( slot ) ) ), Vector3::UNIT_Y );
+        outScale = Vector3( 2.0f );
+    }
+
+    /// Doesn't move at all
+    void staticKeyFrame( Real time, size_t slot, Vector3 &outPos, Quaternion &outRot,
+                         Vector3 &outScale )
+    {
+        outPos = Vector3( Real( slot ), 1.0f, 2.0f );
+        outRot = Quaternion( Radian( 0.5f ), Vector3::UNIT_X );
+        outScale = Vector3::UNIT_SCALE;
+    }
+
+    /// A SkeletonTrack with its own memory, which can be compressed
+    struct TestTrack
+    {
+        KfTransformArrayMemoryManager                        memoryManager;
+        SkeletonTrack                                        track;
+        RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> dequantization;
+        RawSimdUniquePtr<uint16, MEMCATEGORY_ANIMATION>      quantizedKeyFrames;
+
+        TestTrack( size_t numKeyFrames, Real frameRate, KeyFrameGenerator generator ) :
+            memoryManager( 0, numKeyFrames * ARRAY_PACKED_REALS, std::numeric_limits<size_t>::max(),
+                           numKeyFrames * ARRAY_PACKED_REALS ),
+            track( 0u, &memoryManager )
+        {
+            memoryManager.initialize();
+
+            track.setNumKeyFrame( numKeyFrames );
+            for( size_t i = 0; i < numKeyFrames; ++i )
+                track.addKeyFrame( Real( i ) / frameRate, frameRate );
+
+            KeyFrameRigVec &keyFrames = track._getKeyFrames();
+            for( size_t i = 0; i < numKeyFrames; ++i )
+            {
+                for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+                {
+                    Vector3 vPos, vScale;
+                    Quaternion qRot;
+                    generator( Real( i ) / frameRate, j, vPos, qRot, vScale );
+                    keyFrames[i].mBoneTransform->mPosition.setFromVector3( vPos, j );
+                    keyFrames[i].mBoneTransform->mOrientation.setFromQuaternion( qRot, j );
+                    keyFrames[i].mBoneTransform->mScale.setFromVector3( vScale, j );
+                }
+            }
+            track._setMaxUsedSlot( ARRAY_PACKED_REALS - 1u );
+        }
+
+        ~TestTrack() { memoryManager.destroy(); }
+
+        /// Does what SkeletonAnimationDef::build does
+        void compress( const SkeletonTrackCompression &settings )
+        {
+            const size_t numQuantizedValues = track._prepareCompression( settings );
+
+            RawSimdUniquePtr<KfTransform, MEMCATEGORY_ANIMATION> newDequantization( 2u );
+            RawSimdUniquePtr<uint16, MEMCATEGORY_ANIMATION> newQuantizedKeyFrames( numQuantizedValues );
+            dequantization.swap( newDequantization );
+            quantizedKeyFrames.swap( newQuantizedKeyFrames );
+
+            track._compress( dequantization.get(), numQuantizedValues ? quantizedKeyFrames.get() : 0 );
+        }
+
+        /// Samples all the slots of the track at the given frame
+        void sample( Real frame, KfTransform &outTransform ) const
+        {
+            outTransform.mPosition = ArrayVector3::ZERO;
+            outTransform.mOrientation = ArrayQuaternion::IDENTITY;
+            outTransform.mScale = ArrayVector3::UNIT_SCALE;
+
+            BoneTransform boneTransform;
+            boneTransform.mPosition = &outTransform.mPosition;
+            boneTransform.mOrientation = &outTransform.mOrientation;
+            boneTransform.mScale = &outTransform.mScale;
+            TransformArray boneTransforms;
+            boneTransforms.push_back( boneTransform );
+
+            const ArrayReal boneWeight = Mathlib::ONE;
+            KeyFrameRigVec::const_iterator lastKnownKeyFrame = track.getKeyFrames().begin();
+            track.applyKeyFrameRigAt( lastKnownKeyFrame, frame, Mathlib::ONE, &boneWeight,
+                                      boneTransforms );
+        }
+    };
+
+    struct CompressionError
+    {
+        Real position;
+        Real orientation;  // In radians
+        Real scale;
+
+        CompressionError() : position( 0 ), orientation( 0 ), scale( 0 ) {}
+    };
+
+    /// Compares both tracks at every keyframe and in between them
+    CompressionError measureError( const TestTrack &original, const TestTrack &compressed,
+                                   size_t numKeyFrames )
+    {
+        CompressionError retVal;
+
+        for( size_t i = 0; i < ( numKeyFrames - 1u ) * 4u; ++i )
+        {
+            const Real frame = Real( i ) * 0.25f;
+
+            KfTransform expected, result;
+            original.sample( frame, expected );
+            compressed.sample( frame, result );
+
+            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
+            {
+                Vector3 vExpected, vResult;
+                Quaternion qExpected, qResult;
+
+                expected.mPosition.getAsVector3( vExpected, j );
+                result.mPosition.getAsVector3( vResult, j );
+                retVal.position = std::max( retVal.position, vExpected.distance( vResult ) );
+
+                expected.mOrientation.getAsQuaternion( qExpected, j );
+                result.mOrientation.getAsQuaternion( qResult, j );
+                // acos( dot ) is too imprecise for such small angles. Use the chord instead
+                const Quaternion diff =
+                    qExpected.Dot( qResult ) < 0.0f ? qExpected + qResult : qExpected - qResult;
+                const Real halfChord = std::min( Math::Sqrt( diff.Norm() ) * 0.5f, Real( 1.0f ) );
+                retVal.orientation =
+                    std::max( retVal.orientation, 4.0f * Math::ASin( halfChord ).valueRadians() );
+
+                expected.mScale.getAsVector3( vExpected, j );
+                result.mScale.getAsVector3( vResult, j );
+                retVal.scale = std::max( retVal.scale, vExpected.distance( vResult ) );
+            }
+        }
+
+        return retVal;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::testMotionCapture()
+{
+    const size_t numKeyFrames = 1200u;  // 10 seconds at 120 fps
+    TestTrack original( numKeyFrames, 120.0f, motionCaptureKeyFrame );
+    TestTrack compressed( numKeyFrames, 120.0f, motionCaptureKeyFrame );
+
+    SkeletonTrackCompression settings;
+    settings.positionTolerance = 1e-3f;
+    settings.orientationTolerance = 2e-3f;
+    settings.scaleTolerance = 1e-3f;
+    compressed.compress( settings );
+
+    CPPUNIT_ASSERT( compressed.track.isCompressed() );
+    CPPUNIT_ASSERT_EQUAL( uint8( SkeletonTrack::AnimatedPosition | SkeletonTrack::AnimatedOrientation ),
+                          compressed.track.getAnimatedChannels() );
+
+    const size_t originalSize = original.track.getKeyFrameDataSize();
+    const size_t compressedSize = compressed.track.getKeyFrameDataSize();
+    CPPUNIT_ASSERT( compressedSize * 4u < originalSize );
+
+    // Keyframe reduction is bounded by the tolerances; quantization adds a tiny bit on top
+    const CompressionError error = measureError( original, compressed, numKeyFrames );
+    CPPUNIT_ASSERT( error.position <= settings.positionTolerance * 1.1f );
+    CPPUNIT_ASSERT( error.orientation <= settings.orientationTolerance * 1.1f );
+    CPPUNIT_ASSERT( error.scale <= settings.scaleTolerance );
+
+    LogManager::getSingleton().logMessage(
+        "SkeletonTrackCompressionTests: " + StringConverter::toString( numKeyFrames ) +
+        " keyframes. Uncompressed: " + StringConverter::toString( originalSize ) +
+        " bytes. Compressed: " + StringConverter::toString( compressedSize ) + " bytes (" +
+        StringConverter::toString( compressed.track.getKeyFrames().size() ) +
+        " keyframes). Max error: position " + StringConverter::toString( error.position ) +
+        ", orientation " + StringConverter::toString( error.orientation ) + " rad, scale " +
+        StringConverter::toString( error.scale ) );
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::testConstantChannels()
+{
+    const size_t numKeyFrames = 60u;
+    SkeletonTrackCompression settings;
+    {
+        TestTrack original( numKeyFrames, 30.0f, rotationOnlyKeyFrame );
+        TestTrack compressed( numKeyFrames, 30.0f, rotationOnlyKeyFrame );
+        compressed.compress( settings );
+
+        CPPUNIT_ASSERT_EQUAL( uint8( SkeletonTrack::AnimatedOrientation ),
+                              compressed.track.getAnimatedChannels() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 4u * ARRAY_PACKED_REALS ),
+                              size_t( compressed.track._getQuantizedStride() ) );
+
+        const CompressionError error = measureError( original, compressed, numKeyFrames );
+        CPPUNIT_ASSERT_EQUAL( Real( 0.0f ), error.position );
+        CPPUNIT_ASSERT_EQUAL( Real( 0.0f ), error.scale );
+        CPPUNIT_ASSERT( error.orientation <= settings.orientationTolerance * 1.1f );
+    }
+    {
+        // Nothing moves: only the first and last keyframes are needed, and they take no space
+        TestTrack original( numKeyFrames, 30.0f, staticKeyFrame );
+        TestTrack compressed( numKeyFrames, 30.0f, staticKeyFrame );
+        compressed.compress( settings );
+
+        CPPUNIT_ASSERT_EQUAL( uint8( 0u ), compressed.track.getAnimatedChannels() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 2u ), compressed.track.getKeyFrames().size() );
+        CPPUNIT_ASSERT_EQUAL( 2u * sizeof( KfTransform ), compressed.track.getKeyFrameDataSize() );
+
+        const CompressionError error = measureError( original, compressed, numKeyFrames );
+        CPPUNIT_ASSERT_EQUAL( Real( 0.0f ), error.position );
+        CPPUNIT_ASSERT( error.orientation <= settings.orientationTolerance );
+        CPPUNIT_ASSERT_EQUAL( Real( 0.0f ), error.scale );
+    }
+}
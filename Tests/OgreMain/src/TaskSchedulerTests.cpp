@@ -0,0 +1,349 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "TaskSchedulerTests.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreTaskScheduler.h"
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreUniformScalableTask.h"
+
+#include "UnitTestSuite.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TaskSchedulerTests);
+
+namespace
+{
+    /// How long a chunk waits for other chunks before giving up, in milliseconds.
+    /// Only reached when the scheduler is broken; keeps the test from hanging.
+    const size_t c_timeoutMs = 10000u;
+
+    /// Counts how many times each chunk ran
+    class RecordingTask : public Task
+    {
+    protected:
+        LightweightMutex mMutex;
+        size_t           mNumExecuted;
+
+    public:
+        FastArray<uint32> mTimesExecuted;
+        /// Dependencies that must be complete before any of our chunks runs
+        FastArray<RecordingTask *> mDependencies;
+        /// Set if a chunk ran before its dependencies were complete, or with a bad threadIdx
+        bool   mError;
+        size_t mNumThreads;
+
+        RecordingTask( size_t numChunks, size_t numThreads ) :
+            mNumExecuted( 0u ),
+            mError( false ),
+            mNumThreads( numThreads )
+        {
+            mTimesExecuted.resize( numChunks, 0u );
+        }
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            bool error = threadIdx >= mNumThreads;
+
+            FastArray<RecordingTask *>::const_iterator itor = mDependencies.begin();
+            FastArray<RecordingTask *>::const_iterator endt = mDependencies.end();
+            while( itor != endt )
+                error |= !( *itor++ )->isComplete();
+
+            // Different chunks write different slots
+            ++mTimesExecuted[chunkIdx];
+
+            ScopedLock lock( mMutex );
+            mError |= error;
+            ++mNumExecuted;
+        }
+
+        size_t getNumExecuted()
+        {
+            ScopedLock lock( mMutex );
+            return mNumExecuted;
+        }
+
+        bool isComplete() { return getNumExecuted() == mTimesExecuted.size(); }
+
+        /// Every chunk ran exactly once, after its dependencies
+        void checkExecutedOnce()
+        {
+            CPPUNIT_ASSERT( !mError );
+            CPPUNIT_ASSERT_EQUAL( mTimesExecuted.size(), getNumExecuted() );
+            for( size_t i = 0; i < mTimesExecuted.size(); ++i )
+                CPPUNIT_ASSERT_EQUAL( 1u, mTimesExecuted[i] );
+        }
+    };
+
+    /// Chunk 0 doesn't return until all the other chunks have run
+    class StallingTask : public RecordingTask
+    {
+    public:
+        bool mTimedOut;
+
+        StallingTask( size_t numChunks, size_t numThreads ) :
+            RecordingTask( numChunks, numThreads ),
+            mTimedOut( false )
+        {
+        }
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            if( chunkIdx == 0u )
+            {
+                size_t waitedMs = 0u;
+                while( getNumExecuted() + 1u < mTimesExecuted.size() && waitedMs < c_timeoutMs )
+                {
+                    Threads::Sleep( 1u );
+                    ++waitedMs;
+                }
+                mTimedOut = waitedMs == c_timeoutMs;
+            }
+
+            RecordingTask::execute( chunkIdx, threadIdx );
+        }
+    };
+
+    /// Doesn't return until released
+    class BlockingTask : public Task
+    {
+        LightweightMutex mMutex;
+        bool             mReleased;
+
+    public:
+        BlockingTask() : mReleased( false ) {}
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            size_t waitedMs = 0u;
+            while( !isReleased() && waitedMs < c_timeoutMs )
+            {
+                Threads::Sleep( 1u );
+                ++waitedMs;
+            }
+        }
+
+        void release()
+        {
+            ScopedLock lock( mMutex );
+            mReleased = true;
+        }
+
+        bool isReleased()
+        {
+            ScopedLock lock( mMutex );
+            return mReleased;
+        }
+    };
+
+    class RecordingUniformTask : public UniformScalableTask
+    {
+    public:
+        FastArray<size_t> mNumThreads;
+
+        RecordingUniformTask( size_t numThreads ) { mNumThreads.resize( numThreads, 0u ); }
+
+        void execute( size_t threadId, size_t numThreads ) override
+        {
+            mNumThreads[threadId] = numThreads;
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testAllChunksExecuted()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler( 4u );
+    CPPUNIT_ASSERT_EQUAL( size_t( 4u ), taskScheduler.getNumThreads() );
+
+    // More chunks than threads, fewer chunks than threads, and none at all
+    const size_t numChunks[3] = { 1000u, 3u, 0u };
+    RecordingTask bigTask( numChunks[0], taskScheduler.getNumThreads() );
+    RecordingTask smallTask( numChunks[1], taskScheduler.getNumThreads() );
+    RecordingTask emptyTask( numChunks[2], taskScheduler.getNumThreads() );
+
+    const TaskScheduler::TaskId bigTaskId = taskScheduler.submit( &bigTask, numChunks[0] );
+    const TaskScheduler::TaskId smallTaskId = taskScheduler.submit( &smallTask, numChunks[1] );
+    const TaskScheduler::TaskId emptyTaskId = taskScheduler.submit( &emptyTask, numChunks[2] );
+    taskScheduler.waitForAll();
+
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( bigTaskId ) );
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( smallTaskId ) );
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( emptyTaskId ) );
+    bigTask.checkExecutedOnce();
+    smallTask.checkExecutedOnce();
+    emptyTask.checkExecutedOnce();
+
+    RecordingUniformTask uniformTask( taskScheduler.getNumThreads() );
+    taskScheduler.wait( taskScheduler.submit( &uniformTask ) );
+    for( size_t i = 0; i < taskScheduler.getNumThreads(); ++i )
+        CPPUNIT_ASSERT_EQUAL( taskScheduler.getNumThreads(), uniformTask.mNumThreads[i] );
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testDependencies()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler( 4u );
+    const size_t numThreads = taskScheduler.getNumThreads();
+
+    for( size_t iteration = 0; iteration < 20u; ++iteration )
+    {
+        // Diamond: a -> (b, c) -> d, plus e which depends on d and on an already finished task.
+        // b is slow so that d would often start early if it didn't wait for it.
+        RecordingTask a( 64u, numThreads );
+        StallingTask b( 2u, numThreads );
+        RecordingTask c( 64u, numThreads );
+        RecordingTask d( 16u, numThreads );
+        RecordingTask e( 1u, numThreads );
+        b.mDependencies.push_back( &a );
+        c.mDependencies.push_back( &a );
+        d.mDependencies.push_back( &b );
+        d.mDependencies.push_back( &c );
+        e.mDependencies.push_back( &d );
+
+        // Dependents are submitted right away, without waiting for what they depend on
+        const TaskScheduler::TaskId aId = taskScheduler.submit( &a, 64u );
+        const TaskScheduler::TaskId bId = taskScheduler.submit( &b, 2u, &aId, 1u );
+        const TaskScheduler::TaskId cId = taskScheduler.submit( &c, 64u, &aId, 1u );
+        const TaskScheduler::TaskId bcIds[2] = { bId, cId };
+        const TaskScheduler::TaskId dId = taskScheduler.submit( &d, 16u, bcIds, 2u );
+        const TaskScheduler::TaskId eDeps[2] = { TaskScheduler::FinishedTask, dId };
+        const TaskScheduler::TaskId eId = taskScheduler.submit( &e, 1u, eDeps, 2u );
+
+        taskScheduler.wait( eId );
+        CPPUNIT_ASSERT( taskScheduler.isTaskFinished( aId ) );
+        CPPUNIT_ASSERT( taskScheduler.isTaskFinished( dId ) );
+        a.checkExecutedOnce();
+        b.checkExecutedOnce();
+        CPPUNIT_ASSERT( !b.mTimedOut );
+        c.checkExecutedOnce();
+        d.checkExecutedOnce();
+        e.checkExecutedOnce();
+
+        // Depending on a task that finished long ago (its slot may have been reused)
+        RecordingTask f( 8u, numThreads );
+        const TaskScheduler::TaskId fId = taskScheduler.submit( &f, 8u, &aId, 1u );
+        taskScheduler.wait( fId );
+        f.checkExecutedOnce();
+    }
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testWorkStealing()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Each worker gets a contiguous block of chunks. Chunk 0 stalls its worker until every
+    // other chunk has run, which only happens if the rest of its block gets stolen.
+    const size_t numChunks = 16u;
+    TaskScheduler taskScheduler( 2u );
+    StallingTask task( numChunks, taskScheduler.getNumThreads() );
+
+    taskScheduler.wait( taskScheduler.submit( &task, numChunks ) );
+
+    CPPUNIT_ASSERT( !task.mTimedOut );
+    task.checkExecutedOnce();
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testNoWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler( 0u );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), taskScheduler.getNumThreads() );
+
+    // Runs inside submit, on this thread
+    RecordingTask a( 10u, 1u );
+    const TaskScheduler::TaskId aId = taskScheduler.submit( &a, 10u );
+    CPPUNIT_ASSERT( aId == TaskScheduler::FinishedTask );
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( aId ) );
+    a.checkExecutedOnce();
+
+    RecordingTask b( 5u, 1u );
+    b.mDependencies.push_back( &a );
+    taskScheduler.wait( taskScheduler.submit( &b, 5u, &aId, 1u ) );
+    b.checkExecutedOnce();
+
+    RecordingUniformTask uniformTask( 1u );
+    taskScheduler.submit( &uniformTask );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), uniformTask.mNumThreads[0] );
+
+    taskScheduler.waitForAll();
+}
+//--------------------------------------------------------------------------
+void TaskSchedulerTests::testWait()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numWorkers = 2u;
+    BlockingTask blockingTask;
+    RecordingTask task( 100u, numWorkers );
+    RecordingTask dependent( 4u, numWorkers );
+    // Declared after the tasks, so that if an assert fails it finishes them before
+    // they get destroyed
+    TaskScheduler taskScheduler( numWorkers );
+
+    // wait() must only block on the given task, not on unrelated ones
+    const TaskScheduler::TaskId blockingId = taskScheduler.submit( &blockingTask, 1u );
+    const TaskScheduler::TaskId taskId = taskScheduler.submit( &task, 100u );
+    taskScheduler.wait( taskId );
+
+    CPPUNIT_ASSERT( !blockingTask.isReleased() );
+    CPPUNIT_ASSERT( !taskScheduler.isTaskFinished( blockingId ) );
+    task.checkExecutedOnce();
+
+    // A task that depends on the blocked one must not start either
+    const TaskScheduler::TaskId dependentId = taskScheduler.submit( &dependent, 4u, &blockingId, 1u );
+    Threads::Sleep( 10u );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), dependent.getNumExecuted() );
+    CPPUNIT_ASSERT( !taskScheduler.isTaskFinished( dependentId ) );
+
+    blockingTask.release();
+    taskScheduler.waitForAll();
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( blockingId ) );
+    CPPUNIT_ASSERT( taskScheduler.isTaskFinished( dependentId ) );
+    dependent.checkExecutedOnce();
+
+    // Waiting on finished tasks returns right away
+    taskScheduler.wait( taskId );
+    taskScheduler.wait( TaskScheduler::FinishedTask );
+}
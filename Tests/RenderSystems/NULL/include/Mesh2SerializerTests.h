@@ -0,0 +1,69 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __Mesh2SerializerTests_H__
+#define __Mesh2SerializerTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace Ogre
+{
+    class VaoManager;
+}
+
+/** Round-trips v2 meshes through MeshSerializer using the NULL VaoManager, covering
+    both the path that hands the GPU the stream's memory directly and the one that copies it.
+*/
+class Mesh2SerializerTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(Mesh2SerializerTests);
+    CPPUNIT_TEST(testRoundTripInPlace);
+    CPPUNIT_TEST(testRoundTripShadowed);
+    CPPUNIT_TEST(testRoundTripMixed);
+    CPPUNIT_TEST(testRoundTripFlippedEndian);
+    CPPUNIT_TEST(testTruncatedStream);
+    CPPUNIT_TEST(testBackgroundLoadFailure);
+    CPPUNIT_TEST_SUITE_END();
+
+    Ogre::VaoManager *mVaoManager;
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testRoundTripInPlace();
+    void testRoundTripShadowed();
+    void testRoundTripMixed();
+    void testRoundTripFlippedEndian();
+    void testTruncatedStream();
+    void testBackgroundLoadFailure();
+};
+
+#endif
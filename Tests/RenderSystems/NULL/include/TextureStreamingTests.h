@@ -0,0 +1,73 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __TextureStreamingTests_H__
+#define __TextureStreamingTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace Ogre
+{
+    class NULLPlugin;
+    class Root;
+    class Window;
+}
+
+/** Streams textures through TextureGpuManager against the NULL RenderSystem. The images
+    are kept in memory and handed over by a ResourceLoadingListener.
+*/
+class TextureStreamingTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(TextureStreamingTests);
+    CPPUNIT_TEST(testMultiThreadStreaming);
+    CPPUNIT_TEST(testMultiThreadListenerOrder);
+    CPPUNIT_TEST(testMultiThreadLoadingListenerThrows);
+    CPPUNIT_TEST(testScreenCoverageLoadOrder);
+    CPPUNIT_TEST(testProgressiveStreaming);
+    CPPUNIT_TEST(testMostDetailedMipToLoad);
+    CPPUNIT_TEST_SUITE_END();
+
+    Ogre::Root       *mRoot;
+    Ogre::NULLPlugin *mNullPlugin;
+    Ogre::Window     *mWindow;
+
+public:
+    void setUp();
+    void tearDown();
+
+    void testMultiThreadStreaming();
+    void testMultiThreadListenerOrder();
+    void testMultiThreadLoadingListenerThrows();
+    void testScreenCoverageLoadOrder();
+    void testProgressiveStreaming();
+    void testMostDetailedMipToLoad();
+};
+
+#endif
@@ -0,0 +1,444 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsAsyncShaderTests.h"
+#include "OgreFileSystem.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreHighLevelGpuProgram.h"
+#include "OgreHighLevelGpuProgramManager.h"
+#include "OgreHlms.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsListener.h"
+#include "OgreHlmsManager.h"
+#include "OgreNULLRenderSystem.h"
+#include "OgreRenderQueue.h"
+#include "OgreRenderable.h"
+#include "OgreResourceGroupManager.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreTaskScheduler.h"
+#include "Threading/OgreThreads.h"
+#include "Vao/OgreVertexArrayObject.h"
+
+#include "UnitTestSuite.h"
+
+#include <fstream>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsAsyncShaderTests);
+
+namespace
+{
+    /// Relative to the working directory. Where setUp writes the templates
+    const char *c_templateFolder = "HlmsAsyncShaderTests";
+    const char *c_vertexTemplate = "VertexShader_vs.glsl";
+    const char *c_pixelTemplate = "PixelShader_ps.glsl";
+
+    /// Hlms with two tiny templates. Counts how many times the properties get merged.
+    class AsyncTestHlms : public Hlms
+    {
+        PiecesMap mNoPieces[NumShaderTypes];
+
+    public:
+        size_t mNumMerges;
+
+        AsyncTestHlms( Archive *dataFolder ) :
+            Hlms( HLMS_USER0, "AsyncTest", dataFolder, 0 ),
+            mNumMerges( 0u )
+        {
+        }
+
+        /// The NULL RenderSystem doesn't support any shading language for
+        /// _changeRenderSystem to pick the syntax from.
+        void setupForTest() { mShaderSyntax = "glsl"; }
+
+        void setupRootLayout( RootLayout &rootLayout ) override {}
+
+        HlmsDatablock *createDatablockImpl( IdString datablockName,
+                                            const HlmsMacroblock *macroblockRef,
+                                            const HlmsBlendblock *blendblockRef,
+                                            const HlmsParamVec &paramVec ) override
+        {
+            return OGRE_NEW HlmsDatablock( datablockName, this, macroblockRef, blendblockRef,
+                                           paramVec );
+        }
+
+        uint32 fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                               bool casterPass, uint32 lastCacheHash,
+                               uint32 lastTextureHash ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV1( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        void notifyPropertiesMergedPreGenerationStep() override { ++mNumMerges; }
+
+        /// Does what getMaterial does when the renderable's properties are those of variantId
+        const HlmsCache *requestVariant( int32 variantId, uint32 passHash,
+                                         const QueuedRenderable &queuedRenderable )
+        {
+            HlmsPropertyVec properties;
+            setProperty( properties, "variant_id", variantId );
+            setProperty( properties, "variant_odd", variantId & 0x01 );
+            const uint32 renderableHash = addRenderableCache( properties, mNoPieces );
+
+            const HlmsCache passCache( passHash, mType, HlmsPso() );
+            const uint32 finalHash = renderableHash | passHash;
+
+            const HlmsCache *retVal = getShaderCache( finalHash );
+            if( !retVal )
+            {
+                retVal =
+                    createShaderCacheEntryAsync( renderableHash, passCache, finalHash, queuedRenderable );
+            }
+            return retVal;
+        }
+    };
+
+    class CountingListener : public HlmsListener
+    {
+    public:
+        size_t mNumMerges;
+
+        CountingListener() : mNumMerges( 0u ) {}
+
+        void propertiesMergedPreGenerationStep( Hlms *hlms, const HlmsCache &passCache,
+                                                const HlmsPropertyVec &renderableCacheProperties,
+                                                const PiecesMap renderableCachePieces[NumShaderTypes],
+                                                const HlmsPropertyVec &properties,
+                                                const QueuedRenderable &queuedRenderable ) override
+        {
+            ++mNumMerges;
+        }
+    };
+
+    /// Only the datablock & Vao are needed to build a PSO
+    class TestRenderable : public Renderable
+    {
+        LightList mLights;
+
+    public:
+        TestRenderable( HlmsDatablock *datablock, VertexArrayObject *vao )
+        {
+            mVaoPerLod[VpNormal].push_back( vao );
+            mVaoPerLod[VpShadow].push_back( vao );
+            // Not linked through setDatablock, which would calculate the Hlms hashes
+            mHlmsDatablock = datablock;
+        }
+        ~TestRenderable() override { mHlmsDatablock = 0; }
+
+        void getRenderOperation( v1::RenderOperation &op, bool casterPass ) override {}
+        void getWorldTransforms( Matrix4 *xform ) const override {}
+        const LightList &getLights() const override { return mLights; }
+    };
+
+    /// Keeps every worker thread busy until released
+    class BlockingTask : public Task
+    {
+        LightweightMutex mMutex;
+        size_t           mNumBlocked;
+        bool             mReleased;
+
+    public:
+        BlockingTask() : mNumBlocked( 0u ), mReleased( false ) {}
+
+        void execute( size_t chunkIdx, size_t threadIdx ) override
+        {
+            mMutex.lock();
+            ++mNumBlocked;
+            mMutex.unlock();
+
+            while( !isReleased() )
+                Threads::Sleep( 1u );
+        }
+
+        size_t getNumBlocked()
+        {
+            ScopedLock lock( mMutex );
+            return mNumBlocked;
+        }
+
+        bool isReleased()
+        {
+            ScopedLock lock( mMutex );
+            return mReleased;
+        }
+
+        void release()
+        {
+            ScopedLock lock( mMutex );
+            mReleased = true;
+        }
+    };
+
+    void writeFile( const String &path, const char *contents )
+    {
+        std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+        file << contents;
+        CPPUNIT_ASSERT( file.good() );
+    }
+
+    const String &getSource( const Hlms &hlms, size_t variantIdx, ShaderType shaderType )
+    {
+        const GpuProgramPtr &shader = hlms.getShaderCodeCache()[variantIdx].shaders[shaderType];
+        CPPUNIT_ASSERT( shader );
+        return shader->getSource();
+    }
+
+    /// variantId is the order in which the variants were requested
+    void checkSources( const Hlms &hlms, size_t variantId )
+    {
+        const String vertexExpected = ( variantId & 0x01u ? "odd vertex " : "even vertex " ) +
+                                      StringConverter::toString( variantId );
+        const String pixelExpected = "pixel " + StringConverter::toString( variantId );
+        CPPUNIT_ASSERT( getSource( hlms, variantId, VertexShader ).find( vertexExpected ) !=
+                        String::npos );
+        CPPUNIT_ASSERT( getSource( hlms, variantId, PixelShader ).find( pixelExpected ) !=
+                        String::npos );
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    OGRE_NEW ResourceGroupManager();
+    OGRE_NEW HighLevelGpuProgramManager();
+    mRenderSystem = OGRE_NEW NULLRenderSystem();
+    // Creates the capabilities and the VaoManager that Hlms & HlmsManager query
+    mRenderSystem->_createRenderWindow( "HlmsAsyncShaderTests", 1u, 1u, false );
+    mHlmsManager = OGRE_NEW HlmsManager();
+    mHlmsManager->_changeRenderSystem( mRenderSystem );
+
+    FileSystemLayer::createDirectory( c_templateFolder );
+    writeFile( String( c_templateFolder ) + "/" + c_vertexTemplate,
+               "@property( variant_odd )odd vertex @value( variant_id )\n@end\n"
+               "@property( !variant_odd )even vertex @value( variant_id )\n@end\n" );
+    writeFile( String( c_templateFolder ) + "/" + c_pixelTemplate,
+               "pixel @value( variant_id )\n" );
+
+    mDataFolder = OGRE_NEW FileSystemArchive( c_templateFolder, "FileSystem", true );
+    mDataFolder->load();
+}
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::tearDown()
+{
+    mDataFolder->unload();
+    OGRE_DELETE mDataFolder;
+    mDataFolder = 0;
+
+    OGRE_DELETE mHlmsManager;
+    mHlmsManager = 0;
+    OGRE_DELETE mRenderSystem;
+    mRenderSystem = 0;
+    OGRE_DELETE HighLevelGpuProgramManager::getSingletonPtr();
+    OGRE_DELETE ResourceGroupManager::getSingletonPtr();
+
+    FileSystemLayer::removeFile( String( c_templateFolder ) + "/" + c_vertexTemplate );
+    FileSystemLayer::removeFile( String( c_templateFolder ) + "/" + c_pixelTemplate );
+    FileSystemLayer::removeDirectory( c_templateFolder );
+}
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::testExpandedOnWorkerThreads()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numWorkers = 2u;
+    const size_t numVariants = 6u;
+
+    // Must outlive the Hlms
+    TaskScheduler taskScheduler( numWorkers );
+
+    AsyncTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    hlms.setAsyncShaderCompilation( true, &taskScheduler, numVariants );
+
+    const QueuedRenderable queuedRenderable;
+    for( size_t i = 0u; i < numVariants; ++i )
+        CPPUNIT_ASSERT( !hlms.requestVariant( static_cast<int32>( i ), 0u, queuedRenderable ) );
+    // Requesting it again must not schedule it twice
+    CPPUNIT_ASSERT( !hlms.requestVariant( 0, 0u, queuedRenderable ) );
+    CPPUNIT_ASSERT_EQUAL( numVariants, hlms.getNumPendingAsyncShaders() );
+
+    BlockingTask blockingTask;
+    taskScheduler.submit( &blockingTask, numWorkers );
+    while( blockingTask.getNumBlocked() != numWorkers )
+        Threads::Sleep( 1u );
+
+    // The worker threads are busy. The render thread must neither expand the
+    // templates itself nor wait for the workers to do it.
+    for( size_t i = 0u; i < 3u; ++i )
+    {
+        hlms._notifyFrameEnded();
+        CPPUNIT_ASSERT( hlms.getShaderCodeCache().empty() );
+        CPPUNIT_ASSERT_EQUAL( 0u, hlms.getShaderGenerationStats().numVariants );
+        CPPUNIT_ASSERT_EQUAL( numVariants, hlms.getNumPendingAsyncShaders() );
+    }
+
+    blockingTask.release();
+    taskScheduler.waitForAll();
+
+    hlms._notifyFrameEnded();
+    CPPUNIT_ASSERT_EQUAL( numVariants, hlms.getShaderCodeCache().size() );
+    CPPUNIT_ASSERT_EQUAL( static_cast<uint32>( numVariants ),
+                          hlms.getShaderGenerationStats().numParallelVariants );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), hlms.getNumPendingAsyncShaders() );
+
+    for( size_t i = 0u; i < numVariants; ++i )
+        checkSources( hlms, i );
+}
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::testCompileBudget()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numVariants = 5u;
+    const uint32 maxCompilesPerFrame = 2u;
+
+    TaskScheduler taskScheduler( 2u );
+
+    AsyncTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    hlms.setAsyncShaderCompilation( true, &taskScheduler, maxCompilesPerFrame );
+
+    const QueuedRenderable queuedRenderable;
+    for( size_t i = 0u; i < numVariants; ++i )
+        hlms.requestVariant( static_cast<int32>( i ), 0u, queuedRenderable );
+
+    // Hands the variants to the worker threads
+    hlms._notifyFrameEnded();
+    CPPUNIT_ASSERT( hlms.getShaderCodeCache().empty() );
+    taskScheduler.waitForAll();
+
+    size_t numCompiled = 0u;
+    while( numCompiled < numVariants )
+    {
+        hlms._notifyFrameEnded();
+        const size_t expected = std::min<size_t>( numVariants - numCompiled, maxCompilesPerFrame );
+        CPPUNIT_ASSERT_EQUAL( static_cast<uint32>( expected ),
+                              hlms.getShaderGenerationStats().numVariants );
+        numCompiled += expected;
+        CPPUNIT_ASSERT_EQUAL( numCompiled, hlms.getShaderCodeCache().size() );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), hlms.getNumPendingAsyncShaders() );
+    for( size_t i = 0u; i < numVariants; ++i )
+        checkSources( hlms, i );
+}
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::testPropertiesMergedOnce()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TaskScheduler taskScheduler( 2u );
+
+    AsyncTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    hlms.setAsyncShaderCompilation( true, &taskScheduler, 1u );
+
+    CountingListener listener;
+    hlms.setListener( &listener );
+
+    HlmsDatablock *datablock = hlms.createDatablock( "AsyncTest", "AsyncTest", HlmsMacroblock(),
+                                                     HlmsBlendblock(), HlmsParamVec() );
+    VertexArrayObject vao( 0u, 0u, 0u, VertexBufferPackedVec(), 0, OT_TRIANGLE_LIST );
+    TestRenderable renderable( datablock, &vao );
+    const QueuedRenderable queuedRenderable( 0u, &renderable, 0 );
+
+    CPPUNIT_ASSERT( !hlms.requestVariant( 0, 0u, queuedRenderable ) );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), hlms.mNumMerges );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), listener.mNumMerges );
+
+    hlms._notifyFrameEnded();
+    taskScheduler.waitForAll();
+    hlms._notifyFrameEnded();
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), hlms.getShaderCodeCache().size() );
+
+    // Same shaders, another pass (e.g. only the macroblock differs): the PSO is built right away
+    const uint32 otherPassHash = 1u << HlmsBits::PassShift;
+    const HlmsCache *hlmsCache = hlms.requestVariant( 0, otherPassHash, queuedRenderable );
+    CPPUNIT_ASSERT( hlmsCache );
+    CPPUNIT_ASSERT( hlmsCache->pso.vertexShader == hlms.getShaderCodeCache()[0].shaders[VertexShader] );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), hlms.mNumMerges );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), listener.mNumMerges );
+
+    // Already has a PSO
+    CPPUNIT_ASSERT( hlms.requestVariant( 0, otherPassHash, queuedRenderable ) == hlmsCache );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), hlms.mNumMerges );
+
+    hlms.setListener( 0 );
+}
+//--------------------------------------------------------------------------
+void HlmsAsyncShaderTests::testInlineScheduler()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numVariants = 3u;
+
+    // No worker threads: TaskScheduler::submit expands the templates right away
+    TaskScheduler taskScheduler( 0u );
+
+    AsyncTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    hlms.setAsyncShaderCompilation( true, &taskScheduler, numVariants );
+
+    const QueuedRenderable queuedRenderable;
+    for( size_t i = 0u; i < numVariants; ++i )
+        hlms.requestVariant( static_cast<int32>( i ), 0u, queuedRenderable );
+
+    hlms._notifyFrameEnded();
+    hlms._notifyFrameEnded();
+    CPPUNIT_ASSERT_EQUAL( numVariants, hlms.getShaderCodeCache().size() );
+    for( size_t i = 0u; i < numVariants; ++i )
+        checkSources( hlms, i );
+
+    // Disabling discards whatever was still scheduled
+    hlms.requestVariant( static_cast<int32>( numVariants ), 0u, queuedRenderable );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), hlms.getNumPendingAsyncShaders() );
+    hlms.setAsyncShaderCompilation( false, 0 );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), hlms.getNumPendingAsyncShaders() );
+}
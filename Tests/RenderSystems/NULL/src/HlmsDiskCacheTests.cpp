@@ -0,0 +1,458 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsDiskCacheTests.h"
+#include "OgreFileSystem.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreHighLevelGpuProgramManager.h"
+#include "OgreHlms.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsDiskCache.h"
+#include "OgreHlmsManager.h"
+#include "OgreNULLRenderSystem.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreStringConverter.h"
+
+#include "UnitTestSuite.h"
+
+#include <fstream>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsDiskCacheTests);
+
+namespace
+{
+    /// Relative to the working directory. Where setUp writes the templates
+    const char *c_templateFolder = "HlmsDiskCacheTests";
+    /// Where saveEntriesTo writes the entries
+    const char *c_cacheFolder = "HlmsDiskCacheTests/Cache";
+    const char *c_vertexTemplate = "VertexShader_vs.glsl";
+    const char *c_pixelTemplate = "PixelShader_ps.glsl";
+    /// Defines the piece odd variants insert
+    const char *c_oddPieceFile = "Odd_piece_vs.glsl";
+    /// Defines the piece even variants try to insert. Not there at first
+    const char *c_evenPieceFile = "Even_piece_vs.glsl";
+    /// Modifies the properties. Not there at first
+    const char *c_setPieceFile = "Set_piece_vs.glsl";
+
+    const char *c_oddPiece = "@piece( OddBody )odd body\n@end\n";
+
+    const int32 c_numVariants = 4;
+
+    /// Hlms with two tiny templates, whose variants can be compiled without a Renderable
+    class DiskCacheTestHlms : public Hlms
+    {
+        PiecesMap mNoPieces[NumShaderTypes];
+
+    public:
+        DiskCacheTestHlms( Archive *dataFolder ) : Hlms( HLMS_USER0, "DiskCacheTest", dataFolder, 0 )
+        {
+        }
+
+        /// The NULL RenderSystem doesn't support any shading language for
+        /// _changeRenderSystem to pick the syntax from.
+        void setupForTest() { mShaderSyntax = "glsl"; }
+
+        void setupRootLayout( RootLayout &rootLayout ) override {}
+
+        HlmsDatablock *createDatablockImpl( IdString datablockName,
+                                            const HlmsMacroblock *macroblockRef,
+                                            const HlmsBlendblock *blendblockRef,
+                                            const HlmsParamVec &paramVec ) override
+        {
+            return OGRE_NEW HlmsDatablock( datablockName, this, macroblockRef, blendblockRef,
+                                           paramVec );
+        }
+
+        uint32 fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                               bool casterPass, uint32 lastCacheHash,
+                               uint32 lastTextureHash ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV1( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        void compileVariant( int32 variantId )
+        {
+            ShaderCodeCache codeCache( mNoPieces );
+            setProperty( codeCache.mergedCache.setProperties, "variant_id", variantId );
+            setProperty( codeCache.mergedCache.setProperties, "variant_odd", variantId & 0x01 );
+            compileShaderCode( codeCache );
+        }
+
+        /// Checks the entries of diskCache against the templates currently on disk
+        size_t findOutOfDateEntries( const HlmsDiskCache &diskCache, FastArray<uint8> &outOutOfDate )
+        {
+            loadTemplateSources();
+            return diskCache.findOutOfDateEntries( *mTemplateSources, outOutOfDate );
+        }
+    };
+
+    void writeFile( const String &path, const char *contents )
+    {
+        std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+        file << contents;
+        CPPUNIT_ASSERT( file.good() );
+    }
+
+    void writeTemplateFile( const char *filename, const char *contents )
+    {
+        writeFile( String( c_templateFolder ) + "/" + filename, contents );
+    }
+
+    void removeTemplateFile( const char *filename )
+    {
+        FileSystemLayer::removeFile( String( c_templateFolder ) + "/" + filename );
+    }
+
+    /// Matches the files getEntryFilename names for DiskCacheTestHlms
+    String getEntryPattern()
+    {
+        return "HlmsDiskCache_" + StringConverter::toString( HLMS_USER0 ) + "_*.hlmscache";
+    }
+
+    /// Returns the index of the entry in diskCache that was generated for variantId
+    size_t findEntry( const HlmsDiskCache &diskCache, int32 variantId )
+    {
+        const size_t numEntries = diskCache.mCache.sourceCode.size();
+        for( size_t i = 0; i < numEntries; ++i )
+        {
+            const HlmsPropertyVec &properties =
+                diskCache.mCache.sourceCode[i].mergedCache.setProperties;
+            if( Hlms::getProperty( properties, "variant_id", -1 ) == variantId )
+                return i;
+        }
+
+        CPPUNIT_FAIL( "Entry for variant " + StringConverter::toString( variantId ) + " not found" );
+        return numEntries;
+    }
+
+    /// Compares the entry of every variant, including its dependencies by name & hash,
+    /// since each cache numbers its template files differently
+    void checkSameEntries( const HlmsDiskCache &expected, const HlmsDiskCache &actual )
+    {
+        CPPUNIT_ASSERT_EQUAL( expected.mCache.sourceCode.size(), actual.mCache.sourceCode.size() );
+
+        for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        {
+            const HlmsDiskCache::SourceCode &expectedEntry =
+                expected.mCache.sourceCode[findEntry( expected, variantId )];
+            const HlmsDiskCache::SourceCode &actualEntry =
+                actual.mCache.sourceCode[findEntry( actual, variantId )];
+
+            CPPUNIT_ASSERT( expectedEntry.mergedCache.setProperties ==
+                            actualEntry.mergedCache.setProperties );
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+            {
+                CPPUNIT_ASSERT( expectedEntry.mergedCache.pieces[i] ==
+                                actualEntry.mergedCache.pieces[i] );
+                CPPUNIT_ASSERT_EQUAL( expectedEntry.sourceFile[i], actualEntry.sourceFile[i] );
+            }
+
+            CPPUNIT_ASSERT( expectedEntry.missingPieces == actualEntry.missingPieces );
+
+            CPPUNIT_ASSERT_EQUAL( expectedEntry.templateDependencies.size(),
+                                  actualEntry.templateDependencies.size() );
+            for( size_t i = 0; i < expectedEntry.templateDependencies.size(); ++i )
+            {
+                const HlmsDiskCache::TemplateFile &expectedFile =
+                    expected.mCache.templateFiles[expectedEntry.templateDependencies[i]];
+                const HlmsDiskCache::TemplateFile &actualFile =
+                    actual.mCache.templateFiles[actualEntry.templateDependencies[i]];
+                CPPUNIT_ASSERT( expectedFile == actualFile );
+            }
+        }
+    }
+
+    /// Loads the entries in cacheFolder with a new Hlms that reads the templates as they
+    /// are now, and returns which variants findOutOfDateEntries flags
+    FastArray<uint8> findOutOfDateVariants( HlmsManager *hlmsManager, Archive *dataFolder,
+                                            Archive *cacheFolder )
+    {
+        DiskCacheTestHlms hlms( dataFolder );
+        hlmsManager->registerHlms( &hlms, false );
+        hlms.setupForTest();
+
+        HlmsDiskCache diskCache( hlmsManager );
+        diskCache.loadEntriesFrom( cacheFolder, &hlms );
+        CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants ), diskCache.mCache.sourceCode.size() );
+
+        FastArray<uint8> outOfDate;
+        const size_t numOutOfDate = hlms.findOutOfDateEntries( diskCache, outOfDate );
+        CPPUNIT_ASSERT_EQUAL( diskCache.mCache.sourceCode.size(), outOfDate.size() );
+
+        FastArray<uint8> retVal;
+        retVal.resize( size_t( c_numVariants ), 0u );
+        size_t numFlagged = 0u;
+        for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        {
+            retVal[size_t( variantId )] = outOfDate[findEntry( diskCache, variantId )];
+            numFlagged += retVal[size_t( variantId )] ? 1u : 0u;
+        }
+        CPPUNIT_ASSERT_EQUAL( numFlagged, numOutOfDate );
+
+        return retVal;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    OGRE_NEW ResourceGroupManager();
+    OGRE_NEW HighLevelGpuProgramManager();
+    mRenderSystem = OGRE_NEW NULLRenderSystem();
+    // Creates the capabilities and the VaoManager that Hlms & HlmsManager query
+    mRenderSystem->_createRenderWindow( "HlmsDiskCacheTests", 1u, 1u, false );
+    mHlmsManager = OGRE_NEW HlmsManager();
+    mHlmsManager->_changeRenderSystem( mRenderSystem );
+
+    FileSystemLayer::createDirectory( c_templateFolder );
+    FileSystemLayer::createDirectory( c_cacheFolder );
+    writeTemplateFile( c_vertexTemplate,
+                       "@property( variant_odd )@insertpiece( OddBody )\n@end\n"
+                       "@property( !variant_odd )@insertpiece( EvenBody )\n@end\n"
+                       "vertex @value( variant_id )\n" );
+    writeTemplateFile( c_pixelTemplate, "pixel @value( variant_id )\n" );
+    writeTemplateFile( c_oddPieceFile, c_oddPiece );
+
+    mDataFolder = OGRE_NEW FileSystemArchive( c_templateFolder, "FileSystem", true );
+    mDataFolder->load();
+    mCacheFolder = OGRE_NEW FileSystemArchive( c_cacheFolder, "FileSystem", false );
+    mCacheFolder->load();
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::tearDown()
+{
+    StringVectorPtr cacheFiles = mCacheFolder->list( false, false );
+    for( StringVector::const_iterator itor = cacheFiles->begin(); itor != cacheFiles->end(); ++itor )
+        FileSystemLayer::removeFile( String( c_cacheFolder ) + "/" + *itor );
+
+    mCacheFolder->unload();
+    OGRE_DELETE mCacheFolder;
+    mCacheFolder = 0;
+    mDataFolder->unload();
+    OGRE_DELETE mDataFolder;
+    mDataFolder = 0;
+
+    OGRE_DELETE mHlmsManager;
+    mHlmsManager = 0;
+    OGRE_DELETE mRenderSystem;
+    mRenderSystem = 0;
+    OGRE_DELETE HighLevelGpuProgramManager::getSingletonPtr();
+    OGRE_DELETE ResourceGroupManager::getSingletonPtr();
+
+    removeTemplateFile( c_vertexTemplate );
+    removeTemplateFile( c_pixelTemplate );
+    removeTemplateFile( c_oddPieceFile );
+    removeTemplateFile( c_evenPieceFile );
+    removeTemplateFile( c_setPieceFile );
+    FileSystemLayer::removeDirectory( c_cacheFolder );
+    FileSystemLayer::removeDirectory( c_templateFolder );
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testEntriesRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    DiskCacheTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        hlms.compileVariant( variantId );
+
+    HlmsDiskCache savedCache( mHlmsManager );
+    savedCache.copyFrom( &hlms );
+    CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants ), savedCache.mCache.sourceCode.size() );
+
+    {
+        // What the templates produced: odd variants use the piece, even ones miss theirs
+        const HlmsDiskCache::SourceCode &oddEntry =
+            savedCache.mCache.sourceCode[findEntry( savedCache, 1 )];
+        CPPUNIT_ASSERT( oddEntry.sourceFile[VertexShader].find( "odd body" ) != String::npos );
+        CPPUNIT_ASSERT( oddEntry.missingPieces.empty() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 3u ), oddEntry.templateDependencies.size() );
+
+        const HlmsDiskCache::SourceCode &evenEntry =
+            savedCache.mCache.sourceCode[findEntry( savedCache, 2 )];
+        CPPUNIT_ASSERT( evenEntry.sourceFile[VertexShader].find( "vertex 2" ) != String::npos );
+        CPPUNIT_ASSERT_EQUAL( size_t( 1u ), evenEntry.missingPieces.size() );
+        CPPUNIT_ASSERT( evenEntry.missingPieces[0] == IdString( "EvenBody" ) );
+        CPPUNIT_ASSERT_EQUAL( size_t( 2u ), evenEntry.templateDependencies.size() );
+    }
+
+    savedCache.saveEntriesTo( mCacheFolder );
+
+    // One file per entry, and no temporary file left behind
+    CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants ),
+                          mCacheFolder->find( getEntryPattern(), false )->size() );
+    CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants ), mCacheFolder->list( false, false )->size() );
+
+    HlmsDiskCache loadedCache( mHlmsManager );
+    loadedCache.loadEntriesFrom( mCacheFolder, &hlms );
+    checkSameEntries( savedCache, loadedCache );
+
+    // Saving again the same shaders must not add new files
+    loadedCache.saveEntriesTo( mCacheFolder );
+    CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants ), mCacheFolder->list( false, false )->size() );
+
+    HlmsDiskCache reloadedCache( mHlmsManager );
+    reloadedCache.loadEntriesFrom( mCacheFolder, &hlms );
+    checkSameEntries( savedCache, reloadedCache );
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testIncompleteEntriesSkipped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    DiskCacheTestHlms hlms( mDataFolder );
+    mHlmsManager->registerHlms( &hlms, false );
+    hlms.setupForTest();
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        hlms.compileVariant( variantId );
+
+    HlmsDiskCache savedCache( mHlmsManager );
+    savedCache.copyFrom( &hlms );
+    savedCache.saveEntriesTo( mCacheFolder );
+
+    {
+        // Simulate a process that got interrupted while writing an entry: no footer
+        StringVectorPtr filenames = mCacheFolder->find( getEntryPattern(), false );
+        CPPUNIT_ASSERT( !filenames->empty() );
+
+        DataStreamPtr inFile = mCacheFolder->open( filenames->front() );
+        const size_t entrySize = inFile->size();
+        vector<char>::type contents;
+        contents.resize( entrySize );
+        inFile->read( &contents[0], entrySize );
+        inFile->close();
+
+        const String truncatedName =
+            "HlmsDiskCache_" + StringConverter::toString( HLMS_USER0 ) + "_truncated.hlmscache";
+        DataStreamPtr outFile = mCacheFolder->create( truncatedName );
+        outFile->write( &contents[0], entrySize / 2u );
+        outFile->close();
+
+        // The footer is there, but the entry is shorter than the footer says
+        const String shortName =
+            "HlmsDiskCache_" + StringConverter::toString( HLMS_USER0 ) + "_short.hlmscache";
+        outFile = mCacheFolder->create( shortName );
+        outFile->write( &contents[0], entrySize / 2u );
+        outFile->write( &contents[entrySize - sizeof( uint32 ) * 2u], sizeof( uint32 ) * 2u );
+        outFile->close();
+    }
+
+    {
+        // Entries saved with other settings share the folder but must be ignored
+        HlmsDiskCache otherCache( mHlmsManager );
+        otherCache.copyFrom( &hlms );
+        otherCache.mShaderProfile = "other";
+        otherCache.saveEntriesTo( mCacheFolder );
+    }
+
+    CPPUNIT_ASSERT_EQUAL( size_t( c_numVariants * 2 + 2 ),
+                          mCacheFolder->find( getEntryPattern(), false )->size() );
+
+    HlmsDiskCache loadedCache( mHlmsManager );
+    loadedCache.loadEntriesFrom( mCacheFolder, &hlms );
+    checkSameEntries( savedCache, loadedCache );
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testOutOfDateEntries()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    {
+        DiskCacheTestHlms hlms( mDataFolder );
+        mHlmsManager->registerHlms( &hlms, false );
+        hlms.setupForTest();
+        for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+            hlms.compileVariant( variantId );
+
+        HlmsDiskCache diskCache( mHlmsManager );
+        diskCache.copyFrom( &hlms );
+        diskCache.saveEntriesTo( mCacheFolder );
+    }
+
+    FastArray<uint8> outOfDate;
+
+    // Nothing changed
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT( !outOfDate[size_t( variantId )] );
+
+    // Only the odd variants inserted the piece that changed
+    writeTemplateFile( c_oddPieceFile, "@piece( OddBody )new odd body\n@end\n" );
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT_EQUAL( bool( variantId & 0x01 ), outOfDate[size_t( variantId )] != 0u );
+    writeTemplateFile( c_oddPieceFile, c_oddPiece );
+
+    // A new file now defines the piece the even variants couldn't find
+    writeTemplateFile( c_evenPieceFile, "@piece( EvenBody )even body\n@end\n" );
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT_EQUAL( !( variantId & 0x01 ), outOfDate[size_t( variantId )] != 0u );
+    removeTemplateFile( c_evenPieceFile );
+
+    // A new file defining an unrelated piece doesn't affect anyone
+    writeTemplateFile( c_evenPieceFile, "@piece( Unused )unused\n@end\n" );
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT( !outOfDate[size_t( variantId )] );
+    removeTemplateFile( c_evenPieceFile );
+
+    // A new file that modifies the properties can affect every variant
+    writeTemplateFile( c_setPieceFile, "@set( variant_id, 7 )\n" );
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT( outOfDate[size_t( variantId )] );
+    removeTemplateFile( c_setPieceFile );
+
+    // Every variant depends on the pixel shader template
+    writeTemplateFile( c_pixelTemplate, "new pixel @value( variant_id )\n" );
+    outOfDate = findOutOfDateVariants( mHlmsManager, mDataFolder, mCacheFolder );
+    for( int32 variantId = 0; variantId < c_numVariants; ++variantId )
+        CPPUNIT_ASSERT( outOfDate[size_t( variantId )] );
+}
@@ -0,0 +1,477 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Mesh2SerializerTests.h"
+#include "Math/Simple/OgreAabb.h"
+#include "OgreArchiveManager.h"
+#include "OgreException.h"
+#include "OgreFileSystem.h"
+#include "OgreFileSystemLayer.h"
+#include "OgreLodStrategyManager.h"
+#include "OgreMesh2.h"
+#include "OgreMesh2Serializer.h"
+#include "OgreMeshManager2.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreSubMesh2.h"
+#include "Threading/OgreThreads.h"
+#include "Vao/OgreAsyncTicket.h"
+#include "Vao/OgreIndexBufferPacked.h"
+#include "Vao/OgreNULLVaoManager.h"
+#include "Vao/OgreVertexArrayObject.h"
+#include "Vao/OgreVertexBufferPacked.h"
+
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(Mesh2SerializerTests);
+
+namespace
+{
+    const char *c_groupName = "Mesh2SerializerTests";
+    /// Relative to the working directory. Where testBackgroundLoadFailure writes its files
+    const char *c_meshFolder = "Mesh2SerializerTests";
+    const char *c_validMeshName = "Valid.mesh";
+    const char *c_truncatedMeshName = "Truncated.mesh";
+
+    /// SubMesh 0 has 2 LODs sharing its vertex buffer, and 16-bit indices.
+    /// SubMesh 1 has a single LOD, and 32-bit indices.
+    const size_t c_numSubMeshes = 2u;
+    const size_t c_numVertices = 4u;
+    const uint16 c_indices16[6] = { 0u, 1u, 2u, 2u, 1u, 3u };
+    const uint32 c_indices32[3] = { 3u, 2u, 0u };
+
+    size_t getNumLods( size_t subMeshIdx ) { return subMeshIdx == 0u ? 2u : 1u; }
+
+    /// Positions of the vertices of the given SubMesh. The ones of SubMesh 0 are
+    /// looked for in the serialized bytes, so they must be distinctive.
+    void getPositions( size_t subMeshIdx, float outPositions[c_numVertices * 3u] )
+    {
+        const float firstVertex[3] = { 1234.5f, -987.25f, 42.125f };
+        for( size_t i = 0; i < c_numVertices * 3u; ++i )
+        {
+            outPositions[i] =
+                firstVertex[i % 3u] + float( i ) * 0.5f + float( subMeshIdx ) * 100.0f;
+        }
+    }
+
+    const void *getIndices( size_t subMeshIdx, size_t lodIdx, size_t &outNumIndices )
+    {
+        if( subMeshIdx == 0u )
+        {
+            // LOD 1 only keeps the first triangle
+            outNumIndices = lodIdx == 0u ? 6u : 3u;
+            return c_indices16;
+        }
+
+        outNumIndices = 3u;
+        return c_indices32;
+    }
+
+    MeshPtr createTestMesh( const String &name, VaoManager *vaoManager )
+    {
+        MeshPtr mesh = MeshManager::getSingleton().createManual( name, c_groupName );
+        // There's no loader. This just flags it as loaded, so that unloading it
+        // destroys the SubMeshes created below
+        mesh->load();
+
+        VertexElement2Vec vertexElements;
+        vertexElements.push_back( VertexElement2( VET_FLOAT3, VES_POSITION ) );
+
+        for( size_t i = 0; i < c_numSubMeshes; ++i )
+        {
+            SubMesh *subMesh = mesh->createSubMesh();
+
+            float *positions = reinterpret_cast<float *>( OGRE_MALLOC_SIMD(
+                sizeof( float ) * 3u * c_numVertices, MEMCATEGORY_GEOMETRY ) );
+            getPositions( i, positions );
+
+            VertexBufferPackedVec vertexBuffers;
+            vertexBuffers.push_back( vaoManager->createVertexBuffer(
+                vertexElements, c_numVertices, BT_IMMUTABLE, positions, true ) );
+
+            const bool index32Bit = i != 0u;
+            const size_t bytesPerIndex = index32Bit ? sizeof( uint32 ) : sizeof( uint16 );
+
+            for( size_t lodIdx = 0; lodIdx < getNumLods( i ); ++lodIdx )
+            {
+                size_t numIndices;
+                const void *srcIndices = getIndices( i, lodIdx, numIndices );
+                void *indices = OGRE_MALLOC_SIMD( bytesPerIndex * numIndices, MEMCATEGORY_GEOMETRY );
+                memcpy( indices, srcIndices, bytesPerIndex * numIndices );
+
+                IndexBufferPacked *indexBuffer = vaoManager->createIndexBuffer(
+                    index32Bit ? IndexBufferPacked::IT_32BIT : IndexBufferPacked::IT_16BIT,
+                    numIndices, BT_IMMUTABLE, indices, true );
+
+                subMesh->mVao[VpNormal].push_back( vaoManager->createVertexArrayObject(
+                    vertexBuffers, indexBuffer, OT_TRIANGLE_LIST ) );
+            }
+        }
+
+        mesh->prepareForShadowMapping( false );
+        mesh->_setBounds( Aabb( Vector3( 1240.0f, -980.0f, 50.0f ), Vector3( 60.0f ) ), false );
+        mesh->_setBoundingSphereRadius( 110.0f );
+
+        return mesh;
+    }
+
+    /// Returns a MemoryDataStream that ends exactly where the Mesh does
+    DataStreamPtr exportToMemory( const Mesh *mesh, VaoManager *vaoManager,
+                                  Serializer::Endian endianMode )
+    {
+        DataStreamPtr stream( OGRE_NEW MemoryDataStream( 64u * 1024u ) );
+        MeshSerializer meshSerializer( vaoManager );
+        meshSerializer.exportMesh( mesh, stream, endianMode );
+
+        const size_t sizeBytes = stream->tell();
+        MemoryDataStream *trimmed = OGRE_NEW MemoryDataStream( sizeBytes );
+        memcpy( trimmed->getPtr(), static_cast<MemoryDataStream *>( stream.get() )->getPtr(),
+                sizeBytes );
+        return DataStreamPtr( trimmed );
+    }
+
+    /// Returns a copy of the stream, cut in the middle of the first vertex of SubMesh 0,
+    /// i.e. after the indices of its first LOD were read.
+    DataStreamPtr truncateInFirstVertex( const DataStreamPtr &stream )
+    {
+        float positions[c_numVertices * 3u];
+        getPositions( 0u, positions );
+        const uint8 *pattern = reinterpret_cast<const uint8 *>( positions );
+
+        MemoryDataStream *memoryStream = static_cast<MemoryDataStream *>( stream.get() );
+        const uint8 *begin = memoryStream->getPtr();
+        const uint8 *end = begin + memoryStream->size();
+        const uint8 *firstVertex = std::search( begin, end, pattern, pattern + sizeof( positions ) );
+        CPPUNIT_ASSERT( firstVertex != end );
+
+        const size_t sizeBytes = size_t( firstVertex - begin ) + sizeof( float ) * 2u;
+        MemoryDataStream *truncated = OGRE_NEW MemoryDataStream( sizeBytes );
+        memcpy( truncated->getPtr(), begin, sizeBytes );
+        return DataStreamPtr( truncated );
+    }
+
+    MeshPtr importFromMemory( const String &name, DataStreamPtr &stream, VaoManager *vaoManager,
+                              bool vertexBufferShadowed, bool indexBufferShadowed )
+    {
+        MeshPtr mesh = MeshManager::getSingleton().createManual( name, c_groupName );
+        mesh->setVertexBufferPolicy( BT_IMMUTABLE, vertexBufferShadowed );
+        mesh->setIndexBufferPolicy( BT_IMMUTABLE, indexBufferShadowed );
+        mesh->load();
+
+        MeshSerializer meshSerializer( vaoManager );
+        meshSerializer.importMesh( stream, mesh.get() );
+
+        return mesh;
+    }
+
+    void writeFile( const String &path, const DataStreamPtr &stream )
+    {
+        MemoryDataStream *memoryStream = static_cast<MemoryDataStream *>( stream.get() );
+        std::ofstream file( path.c_str(), std::ios::out | std::ios::binary );
+        file.write( reinterpret_cast<const char *>( memoryStream->getPtr() ),
+                    static_cast<std::streamsize>( memoryStream->size() ) );
+        CPPUNIT_ASSERT( file.good() );
+    }
+
+    void checkBuffer( BufferPacked *buffer, const void *expectedData, size_t numElements,
+                      bool shadowed )
+    {
+        CPPUNIT_ASSERT_EQUAL( numElements, buffer->getNumElements() );
+        const size_t numBytes = numElements * buffer->getBytesPerElement();
+
+        if( shadowed )
+        {
+            CPPUNIT_ASSERT( buffer->getShadowCopy() );
+            CPPUNIT_ASSERT( memcmp( buffer->getShadowCopy(), expectedData, numBytes ) == 0 );
+        }
+        else
+        {
+            CPPUNIT_ASSERT( !buffer->getShadowCopy() );
+        }
+
+        AsyncTicketPtr asyncTicket = buffer->readRequest( 0, numElements );
+        const bool gpuDataMatches = memcmp( asyncTicket->map(), expectedData, numBytes ) == 0;
+        asyncTicket->unmap();
+        CPPUNIT_ASSERT( gpuDataMatches );
+    }
+
+    /// Checks the Mesh holds what createTestMesh put in it
+    void checkMesh( const Mesh *mesh, bool vertexBufferShadowed, bool indexBufferShadowed )
+    {
+        CPPUNIT_ASSERT_EQUAL( c_numSubMeshes, size_t( mesh->getNumSubMeshes() ) );
+
+        for( size_t i = 0; i < c_numSubMeshes; ++i )
+        {
+            const SubMesh *subMesh = mesh->getSubMesh( static_cast<unsigned>( i ) );
+            CPPUNIT_ASSERT_EQUAL( getNumLods( i ), subMesh->mVao[VpNormal].size() );
+
+            float positions[c_numVertices * 3u];
+            getPositions( i, positions );
+
+            for( size_t lodIdx = 0; lodIdx < getNumLods( i ); ++lodIdx )
+            {
+                const VertexArrayObject *vao = subMesh->mVao[VpNormal][lodIdx];
+
+                const VertexBufferPackedVec &vertexBuffers = vao->getVertexBuffers();
+                CPPUNIT_ASSERT_EQUAL( size_t( 1u ), vertexBuffers.size() );
+                // LODs must share the vertex buffer, not get a copy each
+                CPPUNIT_ASSERT( vertexBuffers[0] ==
+                                subMesh->mVao[VpNormal][0]->getVertexBuffers()[0] );
+                checkBuffer( vertexBuffers[0], positions, c_numVertices, vertexBufferShadowed );
+
+                size_t numIndices;
+                const void *indices = getIndices( i, lodIdx, numIndices );
+                IndexBufferPacked *indexBuffer = vao->getIndexBuffer();
+                CPPUNIT_ASSERT( indexBuffer );
+                const IndexBufferPacked::IndexType indexType =
+                    i == 0u ? IndexBufferPacked::IT_16BIT : IndexBufferPacked::IT_32BIT;
+                CPPUNIT_ASSERT( indexBuffer->getIndexType() == indexType );
+                checkBuffer( indexBuffer, indices, numIndices, indexBufferShadowed );
+            }
+        }
+    }
+
+    void roundTrip( VaoManager *vaoManager, bool vertexBufferShadowed, bool indexBufferShadowed,
+                    Serializer::Endian endianMode )
+    {
+        MeshPtr original = createTestMesh( "Original.mesh", vaoManager );
+        DataStreamPtr stream = exportToMemory( original.get(), vaoManager, endianMode );
+
+        MeshPtr imported = importFromMemory( "Imported.mesh", stream, vaoManager,
+                                             vertexBufferShadowed, indexBufferShadowed );
+
+        // Whatever the import read in place must have been copied by now
+        MemoryDataStream *memoryStream = static_cast<MemoryDataStream *>( stream.get() );
+        memset( memoryStream->getPtr(), 0, memoryStream->size() );
+
+        checkMesh( imported.get(), vertexBufferShadowed, indexBufferShadowed );
+    }
+
+    class LoadListener final : public Resource::Listener
+    {
+        std::vector<Resource *> mResources;
+
+    public:
+        size_t   numLoaded;
+        size_t   numFailed;
+        Resource *lastFailed;
+
+        LoadListener() : numLoaded( 0u ), numFailed( 0u ), lastFailed( 0 ) {}
+        ~LoadListener() override
+        {
+            for( size_t i = 0; i < mResources.size(); ++i )
+                mResources[i]->removeListener( this );
+        }
+
+        void listenTo( Resource *resource )
+        {
+            resource->addListener( this );
+            mResources.push_back( resource );
+        }
+
+        void loadingComplete( Resource * ) override { ++numLoaded; }
+        void loadingFailed( Resource *resource, const String & ) override
+        {
+            ++numFailed;
+            lastFailed = resource;
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    OGRE_NEW ResourceGroupManager();
+    OGRE_NEW LodStrategyManager();
+    ArchiveManager *archiveMgr = OGRE_NEW ArchiveManager();
+    archiveMgr->addArchiveFactory( OGRE_NEW FileSystemArchiveFactory() );
+
+    mVaoManager = OGRE_NEW NULLVaoManager();
+    MeshManager *meshManager = OGRE_NEW MeshManager();
+    meshManager->_setVaoManager( mVaoManager );
+
+    ResourceGroupManager::getSingleton().createResourceGroup( c_groupName );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::tearDown()
+{
+    // Meshes destroy their buffers through the VaoManager
+    OGRE_DELETE MeshManager::getSingletonPtr();
+    OGRE_DELETE mVaoManager;
+    mVaoManager = 0;
+
+    OGRE_DELETE ArchiveManager::getSingletonPtr();
+    OGRE_DELETE LodStrategyManager::getSingletonPtr();
+    OGRE_DELETE ResourceGroupManager::getSingletonPtr();
+
+    FileSystemLayer::removeFile( String( c_meshFolder ) + "/" + c_validMeshName );
+    FileSystemLayer::removeFile( String( c_meshFolder ) + "/" + c_truncatedMeshName );
+    FileSystemLayer::removeDirectory( c_meshFolder );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testRoundTripInPlace()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Vertex and index data are handed to the VaoManager straight from the stream
+    roundTrip( mVaoManager, false, false, Serializer::ENDIAN_NATIVE );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testRoundTripShadowed()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // The buffers keep their data, so it must be copied out of the stream
+    roundTrip( mVaoManager, true, true, Serializer::ENDIAN_NATIVE );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testRoundTripMixed()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    roundTrip( mVaoManager, true, false, Serializer::ENDIAN_NATIVE );
+    MeshManager::getSingleton().removeAll();
+    roundTrip( mVaoManager, false, true, Serializer::ENDIAN_NATIVE );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testRoundTripFlippedEndian()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // The data needs flipping, so it can't be used in place even if nothing is shadowed
+    const Serializer::Endian flippedEndian =
+        OGRE_ENDIAN == OGRE_ENDIAN_BIG ? Serializer::ENDIAN_LITTLE : Serializer::ENDIAN_BIG;
+    roundTrip( mVaoManager, false, false, flippedEndian );
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testTruncatedStream()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr original = createTestMesh( "Original.mesh", mVaoManager );
+    DataStreamPtr stream =
+        exportToMemory( original.get(), mVaoManager, Serializer::ENDIAN_NATIVE );
+    DataStreamPtr truncated = truncateInFirstVertex( stream );
+
+    // The indices read so far point into the stream. Cleaning up after
+    // the error must leave them alone, rather than trying to free them
+    bool threw = false;
+    try
+    {
+        importFromMemory( "Truncated.mesh", truncated, mVaoManager, false, false );
+    }
+    catch( Exception &e )
+    {
+        threw = true;
+        CPPUNIT_ASSERT_EQUAL( int( Exception::ERR_INVALIDPARAMS ), e.getNumber() );
+        CPPUNIT_ASSERT_EQUAL( String( "MeshSerializerImpl::readInPlace" ), e.getSource() );
+    }
+    CPPUNIT_ASSERT( threw );
+
+    truncated.reset();
+}
+//--------------------------------------------------------------------------
+void Mesh2SerializerTests::testBackgroundLoadFailure()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    {
+        MeshPtr original = createTestMesh( "Original.mesh", mVaoManager );
+        DataStreamPtr stream =
+            exportToMemory( original.get(), mVaoManager, Serializer::ENDIAN_NATIVE );
+
+        FileSystemLayer::createDirectory( c_meshFolder );
+        writeFile( String( c_meshFolder ) + "/" + c_validMeshName, stream );
+        writeFile( String( c_meshFolder ) + "/" + c_truncatedMeshName,
+                   truncateInFirstVertex( stream ) );
+    }
+
+    ResourceGroupManager::getSingleton().addResourceLocation( c_meshFolder, "FileSystem",
+                                                              c_groupName );
+
+    MeshManager &meshManager = MeshManager::getSingleton();
+
+    // Not shadowed, so that they are loaded in place from the file's contents
+    MeshPtr validMesh = meshManager.loadInBackground( c_validMeshName, c_groupName, BT_IMMUTABLE,
+                                                      BT_IMMUTABLE, false, false );
+    MeshPtr truncatedMesh = meshManager.loadInBackground(
+        c_truncatedMeshName, c_groupName, BT_IMMUTABLE, BT_IMMUTABLE, false, false );
+
+    LoadListener listener;
+    listener.listenTo( validMesh.get() );
+    listener.listenTo( truncatedMesh.get() );
+
+    String errorDescription;
+    try
+    {
+        meshManager.waitForBackgroundLoads();
+    }
+    catch( Exception &e )
+    {
+        CPPUNIT_ASSERT_EQUAL( int( Exception::ERR_INVALIDPARAMS ), e.getNumber() );
+        errorDescription = e.getDescription();
+    }
+    CPPUNIT_ASSERT( errorDescription.find( c_truncatedMeshName ) != String::npos );
+    CPPUNIT_ASSERT( errorDescription.find( c_validMeshName ) == String::npos );
+    CPPUNIT_ASSERT( meshManager.getBackgroundLoadErrors().empty() );
+
+    CPPUNIT_ASSERT( validMesh->isLoaded() );
+    checkMesh( validMesh.get(), false, false );
+    CPPUNIT_ASSERT( truncatedMesh->getLoadingState() == Resource::LOADSTATE_UNLOADED );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), size_t( truncatedMesh->getNumSubMeshes() ) );
+
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), listener.numLoaded );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), listener.numFailed );
+    CPPUNIT_ASSERT( listener.lastFailed == truncatedMesh.get() );
+
+    // Without anyone waiting, the error is kept until cleared
+    meshManager.loadInBackground( c_truncatedMeshName, c_groupName, BT_IMMUTABLE, BT_IMMUTABLE,
+                                  false, false );
+    while( !meshManager._update( true ) )
+        Threads::Sleep( 1u );
+
+    const MeshManager::BackgroundLoadErrorVec &errors = meshManager.getBackgroundLoadErrors();
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), errors.size() );
+    CPPUNIT_ASSERT_EQUAL( String( c_truncatedMeshName ), errors[0].meshName );
+    CPPUNIT_ASSERT_EQUAL( String( c_groupName ), errors[0].groupName );
+    CPPUNIT_ASSERT_EQUAL( int( Exception::ERR_INVALIDPARAMS ), errors[0].code );
+    CPPUNIT_ASSERT( errors[0].description.find( "MeshSerializerImpl::readInPlace" ) !=
+                    String::npos );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), listener.numFailed );
+
+    meshManager.clearBackgroundLoadErrors();
+    meshManager.waitForBackgroundLoads();
+}
@@ -0,0 +1,637 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ParallelCommandGenerationTests.h"
+#include "CommandBuffer/OgreCbDrawCall.h"
+#include "CommandBuffer/OgreCbPipelineStateObject.h"
+#include "CommandBuffer/OgreCbShaderBuffer.h"
+#include "CommandBuffer/OgreCommandBuffer.h"
+#include "OgreCamera.h"
+#include "OgreHlmsBufferManager.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsManager.h"
+#include "OgreId.h"
+#include "OgreMovableObject.h"
+#include "OgreNULLPlugin.h"
+#include "OgreRenderPassDescriptor.h"
+#include "OgreRenderQueue.h"
+#include "OgreRenderable.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreTextureGpu.h"
+#include "OgreWindow.h"
+#include "Vao/OgreConstBufferPacked.h"
+#include "Vao/OgreIndirectBufferPacked.h"
+#include "Vao/OgreReadOnlyBufferPacked.h"
+#include "Vao/OgreVaoManager.h"
+#include "Vao/OgreVertexArrayObject.h"
+
+#include "UnitTestSuite.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ParallelCommandGenerationTests);
+
+namespace
+{
+    const size_t c_numWorkerThreads = 4u;
+    const size_t c_numRenderables = 2048u;
+    const size_t c_numVariants = 3u;
+    const size_t c_numVaos = 2u;
+    const uint8 c_renderQueueId = 10u;
+    /// Tex. buffer floats each draw writes (the uint32 in the const buffer is always 4)
+    const size_t c_texFloatsPerDraw = 16u;
+    const uint32 c_invalidId = 0xFFFFFFFFu;
+
+    /// Has an id, which the Hlms writes as its per-draw data
+    class TestRenderable : public Renderable
+    {
+        LightList mLights;
+
+    public:
+        uint32 mId;
+
+        TestRenderable( uint32 id, HlmsDatablock *datablock, VertexArrayObject *vao,
+                        uint32 hlmsHash ) :
+            mId( id )
+        {
+            mVaoPerLod[VpNormal].push_back( vao );
+            mVaoPerLod[VpShadow].push_back( vao );
+            // Not linked through setDatablock, which would calculate the Hlms hashes
+            mHlmsDatablock = datablock;
+            _setHlmsHashes( hlmsHash, hlmsHash );
+        }
+        ~TestRenderable() override { mHlmsDatablock = 0; }
+
+        void getRenderOperation( v1::RenderOperation &op, bool casterPass ) override {}
+        void getWorldTransforms( Matrix4 *xform ) const override {}
+        const LightList &getLights() const override { return mLights; }
+    };
+
+    /// Owns nothing. All the renderables are queued with it
+    class TestObject : public MovableObject
+    {
+    public:
+        TestObject( SceneManager *sceneManager ) :
+            MovableObject( Id::generateNewId<MovableObject>(),
+                           &sceneManager->_getEntityMemoryManager( SCENE_DYNAMIC ), sceneManager,
+                           c_renderQueueId )
+        {
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType = "CommandTestObject";
+            return movableType;
+        }
+    };
+
+    class CommandTestSceneManager : public SceneManager
+    {
+    public:
+        CommandTestSceneManager() : SceneManager( "CommandTestSceneManager", c_numWorkerThreads ) {}
+
+        const String &getTypeName() const override
+        {
+            static const String typeName = "CommandTestSceneManager";
+            return typeName;
+        }
+    };
+
+    /// A draw, with what the shaders would see
+    struct ResolvedDraw
+    {
+        HlmsPso const *pso;
+        /// Tells the meshes apart, as meshes sharing their vertex layout get merged
+        /// in the same multi-draw call
+        uint32 primCount;
+        /// Read from the per-draw data, through both the const & the tex. buffer
+        uint32 renderableId;
+
+        bool operator==( const ResolvedDraw &other ) const
+        {
+            return pso == other.pso && primCount == other.primCount &&
+                   renderableId == other.renderableId;
+        }
+    };
+
+    struct RecordedPass
+    {
+        std::vector<ResolvedDraw> draws;
+        /// PSOs that got replaced before drawing anything with them
+        size_t numUnusedPsos;
+
+        RecordedPass() : numUnusedPsos( 0u ) {}
+    };
+
+    /** Writes the id of each renderable as its per-draw data into the const & tex. buffers
+        the same way HlmsUnlit does; and remembers where it wrote them so that the draws can
+        be resolved back to the renderables. It maps less tex. buffer memory per slice than
+        what it uses, so that every slice runs out of it.
+    */
+    class CommandTestHlms : public HlmsBufferManager
+    {
+        /// Where the per-draw data of a renderable was written
+        struct DrawData
+        {
+            BufferPacked const *constBuffer;
+            size_t              constBufferIdx;
+            BufferPacked const *texBuffer;
+            size_t              texBufferOffset;
+            uint32              renderableId;
+        };
+
+    public:
+        struct SliceRecord
+        {
+            std::vector<DrawData> drawData;
+            size_t                numFills;
+            size_t                numRetries;
+            /// Retries of renderables for which RenderQueue had recorded a PSO
+            size_t numRetriesOnPsoChange;
+
+            SliceRecord() : numFills( 0u ), numRetries( 0u ), numRetriesOnPsoChange( 0u ) {}
+        };
+
+        /// Written by the worker threads, one per slice
+        std::vector<SliceRecord> mSliceRecords;
+        SliceRecord              mMainRecord;
+        RecordedPass            *mRecordedPass;
+
+    private:
+        PiecesMap mNoPieces[NumShaderTypes];
+        uint32    mVariantHashes[c_numVariants];
+
+        uint32 fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                               uint32 lastCacheHash, CommandBuffer *commandBuffer,
+                               MappedState &state, SliceRecord &record )
+        {
+            ++record.numFills;
+
+            if( OGRE_EXTRACT_HLMS_TYPE_FROM_CACHE_HASH( lastCacheHash ) != mType )
+            {
+                // layout(binding = 2) uniform InstanceBuffer {} instance
+                if( state.currentConstBuffer < mConstBuffers.size() &&
+                    (size_t)( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) +
+                              4u ) <= state.currentConstBufferSize )
+                {
+                    *commandBuffer->addCommand<CbShaderBuffer>() =
+                        CbShaderBuffer( VertexShader, 2, mConstBuffers[state.currentConstBuffer], 0, 0 );
+                }
+
+                rebindTexBuffer( state, commandBuffer );
+            }
+
+            const bool exceedsConstBuffer =
+                (size_t)( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) + 4u ) >
+                state.currentConstBufferSize;
+            const bool exceedsTexBuffer =
+                static_cast<size_t>( state.currentMappedTexBuffer - state.startMappedTexBuffer ) +
+                    c_texFloatsPerDraw >=
+                state.currentTexBufferSize;
+
+            if( exceedsConstBuffer || exceedsTexBuffer )
+            {
+                if( !mapNextBuffers( state, commandBuffer, exceedsTexBuffer,
+                                     c_texFloatsPerDraw * sizeof( float ) ) )
+                {
+                    ++record.numRetries;
+                    if( lastCacheHash != cache->hash )
+                        ++record.numRetriesOnPsoChange;
+                    return c_retryFillInRenderThread;
+                }
+            }
+
+            const uint32 renderableId =
+                static_cast<const TestRenderable *>( queuedRenderable.renderable )->mId;
+
+            DrawData drawData;
+            drawData.constBuffer = mConstBuffers[state.currentConstBuffer];
+            drawData.constBufferIdx =
+                static_cast<size_t>( state.currentMappedConstBuffer - state.startMappedConstBuffer );
+            drawData.texBuffer = mTexBuffers[state.currentTexBuffer];
+            drawData.texBufferOffset =
+                state.texLastOffset +
+                static_cast<size_t>( state.currentMappedTexBuffer - state.realStartMappedTexBuffer ) *
+                    sizeof( float );
+            drawData.renderableId = renderableId;
+            record.drawData.push_back( drawData );
+
+            *state.currentMappedConstBuffer = renderableId;
+            state.currentMappedConstBuffer += 4u;
+            *state.currentMappedTexBuffer = static_cast<float>( renderableId );
+            state.currentMappedTexBuffer += c_texFloatsPerDraw;
+
+            return static_cast<uint32>(
+                ( ( state.currentMappedConstBuffer - state.startMappedConstBuffer ) >> 2u ) - 1u );
+        }
+
+        /// Replays the commands, resolving each draw's per-draw data to the renderable
+        /// that wrote it. The draws must read the same renderable from both buffers.
+        void resolveDraws( CommandBuffer *commandBuffer, RecordedPass &outPass ) const
+        {
+            typedef std::map<std::pair<BufferPacked const *, size_t>, uint32> LocationMap;
+            LocationMap constLocations;
+            LocationMap texLocations;
+
+            std::vector<const SliceRecord *> records;
+            records.push_back( &mMainRecord );
+            for( size_t i = 0u; i < mSliceRecords.size(); ++i )
+                records.push_back( &mSliceRecords[i] );
+
+            for( size_t i = 0u; i < records.size(); ++i )
+            {
+                for( size_t j = 0u; j < records[i]->drawData.size(); ++j )
+                {
+                    const DrawData &drawData = records[i]->drawData[j];
+                    constLocations[std::make_pair( drawData.constBuffer, drawData.constBufferIdx )] =
+                        drawData.renderableId;
+                    texLocations[std::make_pair( drawData.texBuffer, drawData.texBufferOffset )] =
+                        drawData.renderableId;
+                }
+            }
+
+            HlmsPso const *pso = 0;
+            bool psoUsed = true;
+            IndirectBufferPacked *indirectBuffer = 0;
+            CbShaderBuffer constBufferBind( VertexShader, 2, (ConstBufferPacked *)0, 0, 0 );
+            CbShaderBuffer texBufferBind( VertexShader, 0, (ReadOnlyBufferPacked *)0, 0, 0 );
+
+            // All commands take the same space
+            size_t commandSize;
+            {
+                CommandBuffer probe;
+                *probe.addCommand<CbPipelineStateObject>() = CbPipelineStateObject( 0 );
+                commandSize = probe.getEndOffset();
+            }
+
+            size_t offset = 0u;
+            CbBase *cmd;
+            while( ( cmd = commandBuffer->getCommandFromOffset( offset ) ) != 0 )
+            {
+                offset += commandSize;
+
+                switch( cmd->commandType )
+                {
+                case CB_SET_PSO:
+                    if( !psoUsed )
+                        ++outPass.numUnusedPsos;
+                    pso = static_cast<const CbPipelineStateObject *>( cmd )->pso;
+                    psoUsed = false;
+                    break;
+                case CB_SET_INDIRECT_BUFFER:
+                    indirectBuffer = static_cast<const CbIndirectBuffer *>( cmd )->indirectBuffer;
+                    break;
+                case CB_SET_CONSTANT_BUFFER_VS:
+                    if( static_cast<const CbShaderBuffer *>( cmd )->slot == 2u )
+                        constBufferBind = *static_cast<const CbShaderBuffer *>( cmd );
+                    break;
+                case CB_SET_TEXTURE_BUFFER_VS:
+                case CB_SET_READONLY_BUFFER_VS:
+                    if( static_cast<const CbShaderBuffer *>( cmd )->slot == 0u )
+                        texBufferBind = *static_cast<const CbShaderBuffer *>( cmd );
+                    break;
+                case CB_DRAW_CALL_STRIP_EMULATED_NO_BASE_INSTANCE:
+                case CB_DRAW_CALL_STRIP_EMULATED:
+                case CB_DRAW_CALL_STRIP:
+                {
+                    const CbDrawCall *drawCall = static_cast<const CbDrawCall *>( cmd );
+                    psoUsed = true;
+
+                    // The NULL RenderSystem has no indirect buffers. Same as GL3+ emulating them
+                    const CbDrawStrip *drawStrip = reinterpret_cast<const CbDrawStrip *>(
+                        indirectBuffer->getSwBufferPtr() +
+                        reinterpret_cast<size_t>( drawCall->indirectBufferOffset ) );
+
+                    for( uint32 i = 0u; i < drawCall->numDraws; ++i )
+                    {
+                        for( uint32 j = 0u; j < drawStrip[i].instanceCount; ++j )
+                        {
+                            const size_t drawId = drawStrip[i].baseInstance + j;
+
+                            ResolvedDraw resolvedDraw;
+                            resolvedDraw.pso = pso;
+                            resolvedDraw.primCount = drawStrip[i].primCount;
+                            resolvedDraw.renderableId = c_invalidId;
+
+                            LocationMap::const_iterator itConst = constLocations.find(
+                                std::make_pair( constBufferBind.bufferPacked, drawId * 4u ) );
+                            const size_t texOffset = drawId * c_texFloatsPerDraw * sizeof( float );
+                            LocationMap::const_iterator itTex = texLocations.find( std::make_pair(
+                                texBufferBind.bufferPacked, texBufferBind.bindOffset + texOffset ) );
+
+                            if( itConst != constLocations.end() && itTex != texLocations.end() &&
+                                itConst->second == itTex->second &&
+                                texOffset + c_texFloatsPerDraw * sizeof( float ) <=
+                                    texBufferBind.bindSizeBytes )
+                            {
+                                resolvedDraw.renderableId = itConst->second;
+                            }
+
+                            outPass.draws.push_back( resolvedDraw );
+                        }
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+        }
+
+    public:
+        CommandTestHlms() :
+            HlmsBufferManager( HLMS_USER0, "CommandTest", 0, 0 ),
+            mRecordedPass( 0 )
+        {
+            for( size_t i = 0u; i < c_numVariants; ++i )
+            {
+                HlmsPropertyVec properties;
+                setProperty( properties, "variant_id", static_cast<int32>( i ) );
+                mVariantHashes[i] = addRenderableCache( properties, mNoPieces );
+            }
+        }
+
+        uint32 getVariantHash( size_t variant ) const { return mVariantHashes[variant]; }
+
+        void setupRootLayout( RootLayout &rootLayout ) override {}
+
+        HlmsDatablock *createDatablockImpl( IdString datablockName,
+                                            const HlmsMacroblock *macroblockRef,
+                                            const HlmsBlendblock *blendblockRef,
+                                            const HlmsParamVec &paramVec ) override
+        {
+            return OGRE_NEW HlmsDatablock( datablockName, this, macroblockRef, blendblockRef,
+                                           paramVec );
+        }
+
+        /// Uses more than this, so that the slices run out of memory
+        size_t getTexBufferBytesPerDraw( bool casterPass ) const override
+        {
+            return c_texFloatsPerDraw * sizeof( float ) / 2u;
+        }
+
+        HlmsCache preparePassHash( const CompositorShadowNode *shadowNode, bool casterPass,
+                                   bool dualParaboloid, SceneManager *sceneManager ) override
+        {
+            HlmsCache retVal = HlmsBufferManager::preparePassHash( shadowNode, casterPass,
+                                                                   dualParaboloid, sceneManager );
+            // There are no templates to build shaders from. Each variant gets an empty PSO
+            for( size_t i = 0u; i < c_numVariants; ++i )
+            {
+                const uint32 finalHash = mVariantHashes[i] | retVal.hash;
+                if( !getShaderCache( finalHash ) )
+                    addShaderCache( finalHash, HlmsPso() );
+            }
+            return retVal;
+        }
+
+        uint32 fillBuffersFor( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                               bool casterPass, uint32 lastCacheHash,
+                               uint32 lastTextureHash ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV1( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return 0;
+        }
+
+        uint32 fillBuffersForV2( const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                 bool casterPass, uint32 lastCacheHash,
+                                 CommandBuffer *commandBuffer ) override
+        {
+            return fillBuffersFor( cache, queuedRenderable, lastCacheHash, commandBuffer,
+                                   mMainState, mMainRecord );
+        }
+
+        void _beginParallelCommandGeneration( CommandBuffer *commandBuffer, bool casterPass,
+                                              size_t numSlices, const size_t *numRenderables ) override
+        {
+            HlmsBufferManager::_beginParallelCommandGeneration( commandBuffer, casterPass, numSlices,
+                                                                numRenderables );
+            if( mSliceRecords.size() < numSlices )
+                mSliceRecords.resize( numSlices );
+        }
+
+        uint32 _fillBuffersForV2Slice( size_t sliceIdx, const HlmsCache *cache,
+                                       const QueuedRenderable &queuedRenderable, bool casterPass,
+                                       uint32 lastCacheHash, CommandBuffer *commandBuffer ) override
+        {
+            // Same as HlmsUnlit
+            MappedState &state = mSliceStates[sliceIdx];
+            const MappedState prevState = state;
+
+            const uint32 retVal = fillBuffersFor( cache, queuedRenderable, lastCacheHash,
+                                                  commandBuffer, state, mSliceRecords[sliceIdx] );
+
+            if( retVal == c_retryFillInRenderThread )
+                state = prevState;
+
+            return retVal;
+        }
+
+        void preCommandBufferExecution( CommandBuffer *commandBuffer ) override
+        {
+            // Writes the size of the last tex. buffer bind
+            HlmsBufferManager::preCommandBufferExecution( commandBuffer );
+
+            if( mRecordedPass )
+                resolveDraws( commandBuffer, *mRecordedPass );
+        }
+
+        void clearRecords()
+        {
+            mSliceRecords.clear();
+            mMainRecord = SliceRecord();
+        }
+    };
+
+    void recordPass( SceneManager *sceneManager, CommandTestHlms &hlms, MovableObject *object,
+                     const std::vector<TestRenderable *> &renderables, bool parallel,
+                     RecordedPass &outPass )
+    {
+        hlms.setParallelCommandGeneration( parallel );
+        hlms.clearRecords();
+        hlms.mRecordedPass = &outPass;
+
+        RenderQueue *renderQueue = sceneManager->getRenderQueue();
+        renderQueue->clear();
+        for( size_t i = 0u; i < renderables.size(); ++i )
+            renderQueue->addRenderableV2( 0u, c_renderQueueId, false, renderables[i], object );
+
+        renderQueue->renderPassPrepare( false, false );
+        renderQueue->render( sceneManager->getDestinationRenderSystem(), c_renderQueueId,
+                             c_renderQueueId + 1u, false, false );
+
+        renderQueue->frameEnded();
+        hlms.frameEnded();
+        hlms.mRecordedPass = 0;
+    }
+}
+//--------------------------------------------------------------------------
+void ParallelCommandGenerationTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = OGRE_NEW Root( 0, "", "", "" );
+    mNullPlugin = OGRE_NEW NULLPlugin();
+    mRoot->installPlugin( mNullPlugin );
+    mRoot->setRenderSystem( mRoot->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+    mRoot->initialise( false );
+    mWindow = mRoot->createRenderWindow( "ParallelCommandGenerationTests", 1u, 1u, false );
+
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    mRenderPassDesc = renderSystem->createRenderPassDescriptor();
+    mRenderPassDesc->mColour[0].texture = mWindow->getTexture();
+    mRenderPassDesc->entriesModified( RenderPassDescriptor::All );
+    const Vector4 fullVp( 0, 0, 1, 1 );
+    renderSystem->beginRenderPassDescriptor( mRenderPassDesc, mWindow->getTexture(), 0u, &fullVp,
+                                             &fullVp, 1u, false, false );
+}
+//--------------------------------------------------------------------------
+void ParallelCommandGenerationTests::tearDown()
+{
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    renderSystem->endRenderPassDescriptor();
+    renderSystem->destroyRenderPassDescriptor( mRenderPassDesc );
+    mRenderPassDesc = 0;
+
+    OGRE_DELETE mRoot;
+    mRoot = 0;
+    OGRE_DELETE mNullPlugin;
+    mNullPlugin = 0;
+    mWindow = 0;
+}
+//--------------------------------------------------------------------------
+void ParallelCommandGenerationTests::testParallelMatchesSerial()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    VaoManager *vaoManager = renderSystem->getVaoManager();
+    HlmsManager *hlmsManager = mRoot->getHlmsManager();
+
+    CommandTestHlms hlms;
+    hlmsManager->registerHlms( &hlms, false );
+
+    CommandTestSceneManager *sceneManager = OGRE_NEW CommandTestSceneManager();
+    sceneManager->_setDestinationRenderSystem( renderSystem );
+    RenderQueue *renderQueue = sceneManager->getRenderQueue();
+    // Keep them in the order they're queued, which is the order of their ids
+    renderQueue->setSortRenderQueue( c_renderQueueId, RenderQueue::DisableSort );
+    renderQueue->setMinRenderablesPerSlice( 256u );
+    // Hlms::preparePassHash reads the camera being rendered
+    Camera *camera = sceneManager->createCamera( "CommandTest" );
+    sceneManager->_setCamerasInProgress( CamerasInProgress( camera ) );
+
+    VertexElement2Vec vertexElements;
+    vertexElements.push_back( VertexElement2( VET_FLOAT3, VES_POSITION ) );
+    // The NULL VaoManager names the first vao 0, which RenderQueue takes as no vao
+    // having been set (and wouldn't set it). Create one to get it out of the way.
+    VertexArrayObject *vaos[c_numVaos + 1u];
+    for( size_t i = 0u; i < c_numVaos + 1u; ++i )
+    {
+        VertexBufferPackedVec vertexBuffers;
+        vertexBuffers.push_back(
+            vaoManager->createVertexBuffer( vertexElements, 3u * ( i + 1u ), BT_DEFAULT, 0, false ) );
+        vaos[i] = vaoManager->createVertexArrayObject( vertexBuffers, 0, OT_TRIANGLE_LIST );
+    }
+
+    HlmsDatablock *datablock = hlms.createDatablock( "CommandTest", "CommandTest", HlmsMacroblock(),
+                                                     HlmsBlendblock(), HlmsParamVec() );
+    TestObject *object = OGRE_NEW TestObject( sceneManager );
+
+    // Every renderable changes the PSO, so each slice runs out of memory right after
+    // RenderQueue recorded a PSO for the renderable it has to give up.
+    std::vector<TestRenderable *> renderables;
+    for( size_t i = 0u; i < c_numRenderables; ++i )
+    {
+        renderables.push_back( OGRE_NEW TestRenderable(
+            static_cast<uint32>( i ), datablock, vaos[( i / 4u ) % c_numVaos + 1u],
+            hlms.getVariantHash( i % c_numVariants ) ) );
+    }
+
+    RecordedPass serialPass;
+    recordPass( sceneManager, hlms, object, renderables, false, serialPass );
+    CPPUNIT_ASSERT( hlms.mSliceRecords.empty() );
+
+    RecordedPass parallelPass;
+    recordPass( sceneManager, hlms, object, renderables, true, parallelPass );
+
+    // Otherwise the test proves nothing
+    CPPUNIT_ASSERT( hlms.mSliceRecords.size() > 1u );
+    size_t numRetries = 0u;
+    size_t numRetriesOnPsoChange = 0u;
+    for( size_t i = 0u; i < hlms.mSliceRecords.size(); ++i )
+    {
+        const CommandTestHlms::SliceRecord &record = hlms.mSliceRecords[i];
+        CPPUNIT_ASSERT( !record.drawData.empty() );
+        numRetries += record.numRetries;
+        numRetriesOnPsoChange += record.numRetriesOnPsoChange;
+    }
+    CPPUNIT_ASSERT( numRetries > 0u );
+    CPPUNIT_ASSERT( numRetriesOnPsoChange > 0u );
+    CPPUNIT_ASSERT( !hlms.mMainRecord.drawData.empty() );
+
+    // Every renderable gets drawn once, in order, reading its own data
+    CPPUNIT_ASSERT_EQUAL( c_numRenderables, serialPass.draws.size() );
+    for( size_t i = 0u; i < c_numRenderables; ++i )
+    {
+        CPPUNIT_ASSERT_EQUAL( static_cast<uint32>( i ), serialPass.draws[i].renderableId );
+        CPPUNIT_ASSERT_EQUAL( vaos[( i / 4u ) % c_numVaos + 1u]->getPrimitiveCount(),
+                              serialPass.draws[i].primCount );
+    }
+
+    CPPUNIT_ASSERT( parallelPass.draws == serialPass.draws );
+    // What the slices recorded for the renderables they gave up must be gone
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), serialPass.numUnusedPsos );
+    CPPUNIT_ASSERT_EQUAL( size_t( 0u ), parallelPass.numUnusedPsos );
+
+    for( size_t i = 0u; i < c_numRenderables; ++i )
+        OGRE_DELETE renderables[i];
+    OGRE_DELETE object;
+    OGRE_DELETE sceneManager;
+    hlms.destroyDatablock( "CommandTest" );
+    hlmsManager->unregisterHlms( HLMS_USER0 );
+
+    for( size_t i = 0u; i < c_numVaos + 1u; ++i )
+    {
+        VertexBufferPacked *vertexBuffer = vaos[i]->getVertexBuffers()[0];
+        vaoManager->destroyVertexArrayObject( vaos[i] );
+        vaoManager->destroyVertexBuffer( vertexBuffer );
+    }
+}
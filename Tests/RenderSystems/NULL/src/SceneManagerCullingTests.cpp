@@ -0,0 +1,585 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+(Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "SceneManagerCullingTests.h"
+#include "OgreCamera.h"
+#include "OgreId.h"
+#include "OgreMovableObject.h"
+#include "OgreNULLPlugin.h"
+#include "OgreRenderPassDescriptor.h"
+#include "OgreRenderQueue.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreTextureGpu.h"
+#include "OgreViewport.h"
+#include "OgreWindow.h"
+
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SceneManagerCullingTests);
+
+namespace
+{
+    const size_t c_numWorkerThreads = 4u;
+    const size_t c_numObjects = 3000u;
+    const size_t c_numCameras = 5u;
+    const uint8 c_firstRq = 10u;
+    const uint8 c_lastRq = 13u;
+    /// Visibility flag of most objects
+    const uint32 c_defaultFlag = 1u << 0u;
+    /// Visibility flag of the remaining objects, seen by viewports that include it
+    const uint32 c_layerFlag = 1u << 4u;
+
+    /// Just a bounding box. It has nothing to render
+    class CullTestObject : public MovableObject
+    {
+    public:
+        CullTestObject( SceneManager *sceneManager, uint8 renderQueueId, const Aabb &aabb ) :
+            MovableObject( Id::generateNewId<MovableObject>(),
+                           &sceneManager->_getEntityMemoryManager( SCENE_DYNAMIC ), sceneManager,
+                           renderQueueId )
+        {
+            setLocalAabb( aabb );
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType = "CullTestObject";
+            return movableType;
+        }
+    };
+
+    /// Exposes the results of culling
+    class CullTestSceneManager : public SceneManager
+    {
+    public:
+        CullTestSceneManager( size_t numWorkerThreads ) :
+            SceneManager( "CullTestSceneManager", numWorkerThreads )
+        {
+        }
+
+        const String &getTypeName() const override
+        {
+            static const String typeName = "CullTestSceneManager";
+            return typeName;
+        }
+
+        /// Visible objects from all threads, with the distance to the camera they
+        /// were culled with. Sorted so that results from different paths can be compared.
+        typedef std::vector<std::pair<MovableObject *, RealAsUint> > VisibleObjectVec;
+        void getVisibleObjects( VisibleObjectVec &outVisibleObjects ) const
+        {
+            outVisibleObjects.clear();
+            for( size_t i = 0; i < mVisibleObjects.size(); ++i )
+            {
+                for( size_t rqId = 0; rqId < mVisibleObjects[i].size(); ++rqId )
+                {
+                    const MovableObject::MovableObjectArray &objects = mVisibleObjects[i][rqId];
+                    for( size_t j = 0; j < objects.size(); ++j )
+                    {
+                        outVisibleObjects.push_back(
+                            std::make_pair( objects[j], objects[j]->getCachedDistanceToCamera() ) );
+                    }
+                }
+            }
+            std::sort( outVisibleObjects.begin(), outVisibleObjects.end() );
+        }
+
+        /// Index of the batched camera whose results the last _cullPhase01 used, or
+        /// std::numeric_limits<size_t>::max() if it culled the camera by itself.
+        size_t getBatchedCullCameraIdx() const { return mBatchedCullCameraIdx; }
+        void resetBatchedCullCameraIdx() { mBatchedCullCameraIdx = std::numeric_limits<size_t>::max(); }
+
+        typedef SceneManager::ObjectChunk ObjectChunk;
+
+        /// Splits the objects like updateAllBounds and frustum culling do
+        const FastArray<ObjectChunk> &prepareAllObjectChunks( size_t &outObjsPerChunk )
+        {
+            size_t totalObjs = 0u;
+            for( size_t i = 0; i < mEntitiesMemoryManagerCulledList.size(); ++i )
+            {
+                ObjectMemoryManager *memoryManager = mEntitiesMemoryManagerCulledList[i];
+                for( size_t rqId = 0; rqId < memoryManager->getNumRenderQueues(); ++rqId )
+                {
+                    ObjectData objData;
+                    totalObjs += memoryManager->getFirstObjectData( objData, rqId );
+                }
+            }
+            outObjsPerChunk = getObjectsPerChunk( totalObjs );
+
+            prepareObjectChunks( mEntitiesMemoryManagerCulledList, 0u,
+                                 std::numeric_limits<size_t>::max() );
+            return mObjectChunks;
+        }
+    };
+
+    /// Deterministic, so that failures can be reproduced
+    Real nextRandom( uint32 &seed )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return Real( seed >> 8u ) / Real( 1u << 24u );
+    }
+
+    /** Creates objects of random sizes all over the place.
+    @param spatiallySorted
+        When true, consecutive objects are close to each other along the X axis
+        (like a level exported in order) so that clusters are small.
+    */
+    void createObjects( SceneManager *sceneManager, size_t numObjects, bool spatiallySorted,
+                        std::vector<MovableObject *> &outObjects )
+    {
+        uint32 seed = 12345u;
+        for( size_t i = 0; i < numObjects; ++i )
+        {
+            const uint8 renderQueueId = static_cast<uint8>( c_firstRq + i % ( c_lastRq - c_firstRq ) );
+            const Vector3 halfSize( 0.1f + nextRandom( seed ) * 2.0f );
+            MovableObject *object =
+                OGRE_NEW CullTestObject( sceneManager, renderQueueId, Aabb( Vector3::ZERO, halfSize ) );
+            object->setVisibilityFlags( i % 7u == 0u ? c_layerFlag : c_defaultFlag );
+
+            Vector3 position( nextRandom( seed ) - 0.5f, nextRandom( seed ) - 0.5f,
+                              nextRandom( seed ) - 0.5f );
+            if( spatiallySorted )
+                position.x = Real( i ) / Real( numObjects ) - 0.5f;
+
+            SceneNode *sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+            sceneNode->setPosition( position * Vector3( 400.0f, 100.0f, 400.0f ) );
+            sceneNode->attachObject( object );
+            outObjects.push_back( object );
+        }
+    }
+
+    void destroyObjects( std::vector<MovableObject *> &objects )
+    {
+        for( size_t i = 0; i < objects.size(); ++i )
+        {
+            SceneNode *sceneNode = objects[i]->getParentSceneNode();
+            sceneNode->detachObject( objects[i] );
+            sceneNode->getParentSceneNode()->removeAndDestroyChild( sceneNode );
+            OGRE_DELETE objects[i];
+        }
+        objects.clear();
+    }
+
+    struct TestCamera
+    {
+        Camera  *camera;
+        Viewport viewport;
+        uint8    firstRq;
+        uint8    lastRq;
+    };
+
+    void setupViewport( TestCamera &testCamera, Window *window, uint32 visibilityMask )
+    {
+        testCamera.viewport.setDimensions( window->getTexture(), Vector4( 0, 0, 1, 1 ),
+                                           Vector4( 0, 0, 1, 1 ), 0u );
+        testCamera.viewport._setVisibilityMask( visibilityMask, 0xFFFFFFFF );
+        testCamera.camera->_notifyViewport( &testCamera.viewport );
+    }
+
+    /// Cameras looking at different parts of the scene. Camera 1 only sees the objects
+    /// flagged with c_layerFlag, and camera 2 only culls some of the render queues
+    void createCameras( SceneManager *sceneManager, Window *window,
+                        TestCamera outCameras[c_numCameras] )
+    {
+        for( size_t i = 0; i < c_numCameras; ++i )
+        {
+            TestCamera &testCamera = outCameras[i];
+            testCamera.camera =
+                sceneManager->createCamera( "Camera " + StringConverter::toString( i ) );
+            testCamera.camera->setPosition( Real( i ) * 20.0f - 40.0f, Real( i ) * 5.0f, 150.0f );
+            testCamera.camera->lookAt( Real( i ) * 30.0f - 60.0f, 0.0f, 0.0f );
+            testCamera.camera->setNearClipDistance( 0.5f );
+            testCamera.camera->setFarClipDistance( 100.0f + Real( i ) * 40.0f );
+            testCamera.camera->setFOVy( Degree( 40.0f + Real( i ) * 10.0f ) );
+            setupViewport( testCamera, window, i == 1u ? c_layerFlag : c_defaultFlag );
+            testCamera.firstRq = i == 2u ? c_firstRq + 1u : c_firstRq;
+            testCamera.lastRq = c_lastRq;
+        }
+    }
+
+    void cullCamera( CullTestSceneManager *sceneManager, TestCamera &testCamera,
+                     CullTestSceneManager::VisibleObjectVec &outVisibleObjects )
+    {
+        testCamera.camera->_cullScenePhase01( testCamera.camera, testCamera.camera,
+                                              &testCamera.viewport, testCamera.firstRq,
+                                              testCamera.lastRq, false );
+        sceneManager->getVisibleObjects( outVisibleObjects );
+    }
+}
+//--------------------------------------------------------------------------
+void SceneManagerCullingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = OGRE_NEW Root( 0, "", "", "" );
+    mNullPlugin = OGRE_NEW NULLPlugin();
+    mRoot->installPlugin( mNullPlugin );
+    mRoot->setRenderSystem( mRoot->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+    mRoot->initialise( false );
+    mWindow = mRoot->createRenderWindow( "SceneManagerCullingTests", 1u, 1u, false );
+
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    mRenderPassDesc = renderSystem->createRenderPassDescriptor();
+    mRenderPassDesc->mColour[0].texture = mWindow->getTexture();
+    mRenderPassDesc->entriesModified( RenderPassDescriptor::All );
+    const Vector4 fullVp( 0, 0, 1, 1 );
+    renderSystem->beginRenderPassDescriptor( mRenderPassDesc, mWindow->getTexture(), 0u, &fullVp,
+                                             &fullVp, 1u, false, false );
+}
+//--------------------------------------------------------------------------
+void SceneManagerCullingTests::tearDown()
+{
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    renderSystem->endRenderPassDescriptor();
+    renderSystem->destroyRenderPassDescriptor( mRenderPassDesc );
+    mRenderPassDesc = 0;
+
+    OGRE_DELETE mRoot;
+    mRoot = 0;
+    OGRE_DELETE mNullPlugin;
+    mNullPlugin = 0;
+    mWindow = 0;
+}
+//--------------------------------------------------------------------------
+void SceneManagerCullingTests::testBatchedCullMatchesPerCamera()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CullTestSceneManager *sceneManager = OGRE_NEW CullTestSceneManager( c_numWorkerThreads );
+    sceneManager->_setDestinationRenderSystem( mRoot->getRenderSystem() );
+    // Keep the visible objects in the lists instead of adding them to the RenderQueue
+    for( uint8 rqId = c_firstRq; rqId < c_lastRq; ++rqId )
+        sceneManager->getRenderQueue()->setRenderQueueMode( rqId, RenderQueue::V1_FAST );
+
+    std::vector<MovableObject *> objects;
+    createObjects( sceneManager, c_numObjects, false, objects );
+
+    TestCamera cameras[c_numCameras];
+    createCameras( sceneManager, mWindow, cameras );
+
+    sceneManager->updateSceneGraph();
+
+    // Cull each camera by itself
+    CullTestSceneManager::VisibleObjectVec expected[c_numCameras];
+    for( size_t i = 0; i < c_numCameras; ++i )
+    {
+        sceneManager->resetBatchedCullCameraIdx();
+        cullCamera( sceneManager, cameras[i], expected[i] );
+        CPPUNIT_ASSERT_EQUAL( std::numeric_limits<size_t>::max(),
+                              sceneManager->getBatchedCullCameraIdx() );
+        // Otherwise the test proves nothing
+        CPPUNIT_ASSERT( !expected[i].empty() );
+        CPPUNIT_ASSERT( expected[i].size() < c_numObjects );
+    }
+
+    // Cull them all at once. Every camera must find its results in the batch, and they
+    // must match. Distances too: the cameras are culled in reverse order so that the
+    // distances the batch cached belong to another camera.
+    for( size_t i = 0; i < c_numCameras; ++i )
+    {
+        sceneManager->_addBatchedCull( cameras[i].camera, cameras[i].camera,
+                                       cameras[i].viewport.getVisibilityMask(), cameras[i].firstRq,
+                                       cameras[i].lastRq );
+    }
+    sceneManager->_fireBatchedCull();
+
+    CullTestSceneManager::VisibleObjectVec visibleObjects;
+    for( size_t i = c_numCameras; i--; )
+    {
+        sceneManager->resetBatchedCullCameraIdx();
+        cullCamera( sceneManager, cameras[i], visibleObjects );
+        CPPUNIT_ASSERT_EQUAL( i, sceneManager->getBatchedCullCameraIdx() );
+        CPPUNIT_ASSERT( visibleObjects == expected[i] );
+    }
+
+    // A camera that changed after the batch was culled must be culled again,
+    // while the ones that didn't keep using the batch
+    sceneManager->_addBatchedCull( cameras[0].camera, cameras[0].camera,
+                                   cameras[0].viewport.getVisibilityMask(), cameras[0].firstRq,
+                                   cameras[0].lastRq );
+    sceneManager->_addBatchedCull( cameras[3].camera, cameras[3].camera,
+                                   cameras[3].viewport.getVisibilityMask(), cameras[3].firstRq,
+                                   cameras[3].lastRq );
+    sceneManager->_fireBatchedCull();
+    cameras[3].camera->setFOVy( Degree( 20.0f ) );
+
+    sceneManager->resetBatchedCullCameraIdx();
+    CullTestSceneManager::VisibleObjectVec changedVisibleObjects;
+    cullCamera( sceneManager, cameras[3], changedVisibleObjects );
+    CPPUNIT_ASSERT_EQUAL( std::numeric_limits<size_t>::max(),
+                          sceneManager->getBatchedCullCameraIdx() );
+    CPPUNIT_ASSERT( changedVisibleObjects != expected[3] );
+
+    sceneManager->resetBatchedCullCameraIdx();
+    cullCamera( sceneManager, cameras[0], visibleObjects );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, sceneManager->getBatchedCullCameraIdx() );
+    CPPUNIT_ASSERT( visibleObjects == expected[0] );
+
+    // The changed camera got the same results as culling it without a batch
+    sceneManager->_clearBatchedCull();
+    cullCamera( sceneManager, cameras[3], visibleObjects );
+    CPPUNIT_ASSERT( visibleObjects == changedVisibleObjects );
+
+    destroyObjects( objects );
+    OGRE_DELETE sceneManager;
+}
+//--------------------------------------------------------------------------
+void SceneManagerCullingTests::testClusterCullMatchesLinear()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CullTestSceneManager *sceneManager = OGRE_NEW CullTestSceneManager( c_numWorkerThreads );
+    sceneManager->_setDestinationRenderSystem( mRoot->getRenderSystem() );
+    for( uint8 rqId = c_firstRq; rqId < c_lastRq; ++rqId )
+        sceneManager->getRenderQueue()->setRenderQueueMode( rqId, RenderQueue::V1_FAST );
+
+    // Enough objects for the chunks to not be a multiple of the cluster size by chance
+    const size_t numObjects = 10000u;
+    std::vector<MovableObject *> objects;
+    createObjects( sceneManager, numObjects, true, objects );
+
+    TestCamera cameras[c_numCameras];
+    createCameras( sceneManager, mWindow, cameras );
+
+    const size_t objsPerCluster = ObjectMemoryManager::c_objsPerCluster;
+    ObjectMemoryManager &memoryManager = sceneManager->_getEntityMemoryManager( SCENE_DYNAMIC );
+
+    sceneManager->updateSceneGraph();
+
+    // Without clusters, chunks are as big as the work split asks for
+    size_t objsPerChunk;
+    const FastArray<CullTestSceneManager::ObjectChunk> &linearChunks =
+        sceneManager->prepareAllObjectChunks( objsPerChunk );
+    CPPUNIT_ASSERT( objsPerChunk % objsPerCluster != 0u );
+    for( size_t i = 0; i < linearChunks.size(); ++i )
+    {
+        CPPUNIT_ASSERT_EQUAL( (size_t)0u, linearChunks[i].firstObj % objsPerChunk );
+        CPPUNIT_ASSERT( linearChunks[i].numObjs <= objsPerChunk );
+    }
+
+    CullTestSceneManager::VisibleObjectVec expected[c_numCameras];
+    for( size_t i = 0; i < c_numCameras; ++i )
+        cullCamera( sceneManager, cameras[i], expected[i] );
+
+    sceneManager->setClusterCulling( SCENE_DYNAMIC, true );
+
+    // With clusters, chunks are rounded up so that they don't split them
+    const size_t clusteredObjsPerChunk =
+        ( ( objsPerChunk + objsPerCluster - 1u ) / objsPerCluster ) * objsPerCluster;
+    const FastArray<CullTestSceneManager::ObjectChunk> &clusterChunks =
+        sceneManager->prepareAllObjectChunks( objsPerChunk );
+    for( size_t i = 0; i < clusterChunks.size(); ++i )
+    {
+        CPPUNIT_ASSERT_EQUAL( (size_t)0u, clusterChunks[i].firstObj % clusteredObjsPerChunk );
+        CPPUNIT_ASSERT( clusterChunks[i].numObjs <= clusteredObjsPerChunk );
+    }
+
+    sceneManager->updateSceneGraph();
+
+    for( uint8 rqId = c_firstRq; rqId < c_lastRq; ++rqId )
+        CPPUNIT_ASSERT( memoryManager._getClusters( rqId ) );
+
+    // Some clusters must be skipped, otherwise the test proves nothing
+    {
+        ObjectData objData;
+        const size_t numClusters =
+            ( memoryManager.getFirstObjectData( objData, c_firstRq ) + objsPerCluster - 1u ) /
+            objsPerCluster;
+        const ObjectMemoryManager::Cluster *clusters = memoryManager._getClusters( c_firstRq );
+        size_t numCulledClusters = 0u;
+        for( size_t i = 0; i < numClusters; ++i )
+        {
+            if( !cameras[0].camera->isVisible( AxisAlignedBox( clusters[i].vMin, clusters[i].vMax ) ) )
+                ++numCulledClusters;
+        }
+        CPPUNIT_ASSERT( numCulledClusters > 0u && numCulledClusters < numClusters );
+    }
+
+    CullTestSceneManager::VisibleObjectVec visibleObjects;
+    for( size_t i = 0; i < c_numCameras; ++i )
+    {
+        cullCamera( sceneManager, cameras[i], visibleObjects );
+        CPPUNIT_ASSERT( visibleObjects == expected[i] );
+    }
+
+    // Move some objects across the scene. The clusters are refitted the next update
+    for( size_t i = 0; i < numObjects; i += 37u )
+    {
+        Node *node = objects[i]->getParentNode();
+        node->setPosition( -node->getPosition() );
+    }
+    sceneManager->updateSceneGraph();
+
+    sceneManager->setClusterCulling( SCENE_DYNAMIC, false );
+    for( size_t i = 0; i < c_numCameras; ++i )
+        cullCamera( sceneManager, cameras[i], expected[i] );
+
+    sceneManager->setClusterCulling( SCENE_DYNAMIC, true );
+    sceneManager->updateSceneGraph();
+    for( size_t i = 0; i < c_numCameras; ++i )
+    {
+        cullCamera( sceneManager, cameras[i], visibleObjects );
+        CPPUNIT_ASSERT( visibleObjects == expected[i] );
+    }
+
+    // Creating an object invalidates the clusters of its render queue, which must fall
+    // back to linear culling until the next update. The object itself is hidden because
+    // its bounds haven't been updated yet.
+    std::vector<MovableObject *> newObjects;
+    createObjects( sceneManager, 1u, false, newObjects );
+    newObjects.back()->setVisible( false );
+    CPPUNIT_ASSERT( !memoryManager._getClusters( newObjects.back()->getRenderQueueGroup() ) );
+    for( size_t i = 0; i < c_numCameras; ++i )
+    {
+        cullCamera( sceneManager, cameras[i], visibleObjects );
+        CPPUNIT_ASSERT( visibleObjects == expected[i] );
+    }
+
+    destroyObjects( newObjects );
+    destroyObjects( objects );
+    OGRE_DELETE sceneManager;
+}
+//--------------------------------------------------------------------------
+void SceneManagerCullingTests::testOcclusionCulling()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CullTestSceneManager *sceneManager = OGRE_NEW CullTestSceneManager( c_numWorkerThreads );
+    sceneManager->_setDestinationRenderSystem( mRoot->getRenderSystem() );
+    sceneManager->getRenderQueue()->setRenderQueueMode( c_firstRq, RenderQueue::V1_FAST );
+
+    // A wall facing the camera, and objects around it. Objects are placed 80 units away from
+    // the camera, where the wall's edges are at x, y = +/-32 and the frustum's at +/-80
+    struct ObjectDesc
+    {
+        Vector3 position;
+        Vector3 halfSize;
+        bool    occluded;
+    };
+    const ObjectDesc objectDescs[] = {
+        // The wall
+        { Vector3( 0, 0, 0 ), Vector3( 20.0f, 20.0f, 0.5f ), false },
+        // Behind the wall
+        { Vector3( -5.0f, -5.0f, -30.0f ), Vector3( 1.0f ), true },
+        { Vector3( 5.0f, -5.0f, -30.0f ), Vector3( 1.0f ), true },
+        { Vector3( -5.0f, 5.0f, -30.0f ), Vector3( 1.0f ), true },
+        { Vector3( 20.0f, 20.0f, -30.0f ), Vector3( 1.0f ), true },
+        { Vector3( 0.0f, 0.0f, -200.0f ), Vector3( 10.0f ), true },
+        // In front of the wall
+        { Vector3( 0.0f, 0.0f, 20.0f ), Vector3( 1.0f ), false },
+        { Vector3( 10.0f, -10.0f, 20.0f ), Vector3( 1.0f ), false },
+        // Besides the wall
+        { Vector3( 60.0f, 0.0f, -30.0f ), Vector3( 1.0f ), false },
+        { Vector3( 0.0f, -50.0f, -30.0f ), Vector3( 1.0f ), false },
+        // Peeking from behind the wall's edge
+        { Vector3( 30.0f, 0.0f, -30.0f ), Vector3( 5.0f ), false },
+    };
+    const size_t numObjects = sizeof( objectDescs ) / sizeof( objectDescs[0] );
+
+    std::vector<MovableObject *> objects;
+    for( size_t i = 0; i < numObjects; ++i )
+    {
+        MovableObject *object = OGRE_NEW CullTestObject(
+            sceneManager, c_firstRq, Aabb( Vector3::ZERO, objectDescs[i].halfSize ) );
+        SceneNode *sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+        sceneNode->setPosition( objectDescs[i].position );
+        sceneNode->attachObject( object );
+        object->setVisibilityFlags( c_defaultFlag );
+        objects.push_back( object );
+    }
+    MovableObject *wall = objects[0];
+    wall->setOccluder( true );
+
+    TestCamera testCamera;
+    testCamera.camera = sceneManager->createCamera( "Camera" );
+    testCamera.camera->setPosition( 0.0f, 0.0f, 50.0f );
+    testCamera.camera->lookAt( 0.0f, 0.0f, 0.0f );
+    testCamera.camera->setNearClipDistance( 0.5f );
+    testCamera.camera->setFarClipDistance( 500.0f );
+    testCamera.camera->setFOVy( Degree( 90.0f ) );
+    testCamera.camera->setAspectRatio( 1.0f );
+    setupViewport( testCamera, mWindow, c_defaultFlag );
+    testCamera.firstRq = c_firstRq;
+    testCamera.lastRq = c_firstRq + 1u;
+
+    sceneManager->updateSceneGraph();
+
+    // Without occlusion culling, everything is in the frustum
+    CullTestSceneManager::VisibleObjectVec visibleObjects;
+    cullCamera( sceneManager, testCamera, visibleObjects );
+    CPPUNIT_ASSERT_EQUAL( numObjects, visibleObjects.size() );
+    const CullTestSceneManager::VisibleObjectVec frustumVisibleObjects = visibleObjects;
+
+    sceneManager->_setOcclusionCullingInPass( true );
+    cullCamera( sceneManager, testCamera, visibleObjects );
+
+    size_t numOccluded = 0u;
+    for( size_t i = 0; i < numObjects; ++i )
+    {
+        bool isVisible = false;
+        for( size_t j = 0; j < visibleObjects.size(); ++j )
+            isVisible |= visibleObjects[j].first == objects[i];
+        CPPUNIT_ASSERT_EQUAL( !objectDescs[i].occluded, isVisible );
+        if( objectDescs[i].occluded )
+            ++numOccluded;
+    }
+
+    const SceneManager::OcclusionCullingStats &stats = sceneManager->getOcclusionCullingStats();
+    CPPUNIT_ASSERT_EQUAL( (size_t)1u, stats.numOccluders );
+    CPPUNIT_ASSERT_EQUAL( numObjects, stats.numTested );
+    CPPUNIT_ASSERT_EQUAL( numOccluded, stats.numRejected );
+
+    // Occluders the pass doesn't render can't hide anything
+    wall->setVisibilityFlags( c_layerFlag );
+    cullCamera( sceneManager, testCamera, visibleObjects );
+    CPPUNIT_ASSERT_EQUAL( numObjects - 1u, visibleObjects.size() );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, stats.numOccluders );
+    CPPUNIT_ASSERT_EQUAL( (size_t)0u, stats.numRejected );
+
+    setupViewport( testCamera, mWindow, c_defaultFlag | c_layerFlag );
+    cullCamera( sceneManager, testCamera, visibleObjects );
+    CPPUNIT_ASSERT_EQUAL( numObjects - numOccluded, visibleObjects.size() );
+
+    // Neither can occluders that are no longer flagged as such
+    wall->setOccluder( false );
+    cullCamera( sceneManager, testCamera, visibleObjects );
+    CPPUNIT_ASSERT( visibleObjects == frustumVisibleObjects );
+
+    sceneManager->_setOcclusionCullingInPass( false );
+    destroyObjects( objects );
+    OGRE_DELETE sceneManager;
+}
@@ -0,0 +1,781 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "TextureStreamingTests.h"
+#include "OgreCamera.h"
+#include "OgreDataStream.h"
+#include "OgreException.h"
+#include "OgreHlms.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsManager.h"
+#include "OgreId.h"
+#include "OgreImage2.h"
+#include "OgreMovableObject.h"
+#include "OgreNULLPlugin.h"
+#include "OgreNULLTextureGpu.h"
+#include "OgreRenderPassDescriptor.h"
+#include "OgreRenderQueue.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreStringConverter.h"
+#include "OgreTextureGpu.h"
+#include "OgreTextureGpuListener.h"
+#include "OgreTextureGpuManager.h"
+#include "OgreViewport.h"
+#include "OgreWindow.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "Vao/OgreVaoManager.h"
+#include "Vao/OgreVertexArrayObject.h"
+
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TextureStreamingTests);
+
+namespace
+{
+    const size_t c_numStreamingThreads = 4u;
+    const size_t c_numTextures = 48u;
+
+    /// Hands over OITD files kept in memory. Called from the streaming threads
+    class MemoryLoadingListener : public ResourceLoadingListener
+    {
+        typedef std::map<String, std::vector<uint8> > FileMap;
+
+        FileMap          mFiles;
+        std::set<String> mFailingFiles;
+
+        LightweightMutex mMutex;
+        size_t           mActiveLoads;
+
+        /// See setBlockingFile
+        String mBlockingFile;
+        bool   mBlocked;
+        bool   mUnblocked;
+
+    public:
+        /// Most calls to grouplessResourceLoading that were running at the same time
+        size_t mMaxActiveLoads;
+        size_t mNumLoads;
+        /// Files in the order grouplessResourceLoading was asked for them
+        std::vector<String> mLoadOrder;
+
+        MemoryLoadingListener() :
+            mActiveLoads( 0u ),
+            mBlocked( false ),
+            mUnblocked( false ),
+            mMaxActiveLoads( 0u ),
+            mNumLoads( 0u )
+        {
+        }
+
+        void addImage( const String &name, uint32 width, uint32 height, uint8 numMipmaps = 1u )
+        {
+            Image2 image;
+            image.createEmptyImage( width, height, 1u, TextureTypes::Type2D, PFG_RGBA8_UNORM,
+                                    numMipmaps );
+            memset( image.getRawBuffer(), 0x7F, image.getSizeBytes() );
+
+            DataStreamPtr encoded = image.encode( "oitd", 0u, numMipmaps );
+            std::vector<uint8> &file = mFiles[name];
+            file.resize( encoded->size() );
+            encoded->read( &file[0], file.size() );
+        }
+
+        /// grouplessResourceLoading will throw for this file
+        void addFailingFile( const String &name ) { mFailingFiles.insert( name ); }
+
+        /// grouplessResourceLoading will hold the streaming thread that loads this
+        /// file until unblock is called
+        void setBlockingFile( const String &name ) { mBlockingFile = name; }
+
+        void waitUntilBlocked()
+        {
+            while( true )
+            {
+                {
+                    ScopedLock lock( mMutex );
+                    if( mBlocked )
+                        return;
+                }
+                Threads::Sleep( 1u );
+            }
+        }
+
+        void unblock()
+        {
+            ScopedLock lock( mMutex );
+            mUnblocked = true;
+        }
+
+        DataStreamPtr resourceLoading( const String &name, const String &group,
+                                       Resource *resource ) override
+        {
+            return DataStreamPtr();
+        }
+
+        bool grouplessResourceExists( const String &name ) override
+        {
+            return mFiles.find( name ) != mFiles.end() ||
+                   mFailingFiles.find( name ) != mFailingFiles.end();
+        }
+
+        DataStreamPtr grouplessResourceLoading( const String &name ) override
+        {
+            {
+                ScopedLock lock( mMutex );
+                ++mActiveLoads;
+                ++mNumLoads;
+                mMaxActiveLoads = std::max( mMaxActiveLoads, mActiveLoads );
+                mLoadOrder.push_back( name );
+                mBlocked = name == mBlockingFile;
+            }
+            if( name == mBlockingFile )
+            {
+                bool unblocked = false;
+                while( !unblocked )
+                {
+                    Threads::Sleep( 1u );
+                    ScopedLock lock( mMutex );
+                    unblocked = mUnblocked;
+                }
+            }
+            // Give the other streaming threads a chance to come in
+            Threads::Sleep( 1u );
+            {
+                ScopedLock lock( mMutex );
+                --mActiveLoads;
+            }
+
+            if( mFailingFiles.find( name ) != mFailingFiles.end() )
+            {
+                OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Failing on purpose: " + name,
+                             "MemoryLoadingListener::grouplessResourceLoading" );
+            }
+
+            // mFiles doesn't change while streaming
+            std::vector<uint8> &file = mFiles.find( name )->second;
+            return DataStreamPtr( OGRE_NEW MemoryDataStream( &file[0], file.size(), false, true ) );
+        }
+
+        DataStreamPtr grouplessResourceOpened( const String &name, Archive *archive,
+                                               DataStreamPtr &dataStream ) override
+        {
+            return dataStream;
+        }
+
+        void resourceStreamOpened( const String &name, const String &group, Resource *resource,
+                                   DataStreamPtr &dataStream ) override
+        {
+        }
+
+        bool resourceCollision( Resource *resource, ResourceManager *resourceManager ) override
+        {
+            return false;
+        }
+    };
+
+    /// Records the notifications of the textures it listens to, with the _update they came from
+    class NotificationRecorder : public TextureGpuListener
+    {
+    public:
+        struct Notification
+        {
+            TextureGpu                *texture;
+            TextureGpuListener::Reason reason;
+            size_t                     updateIdx;
+        };
+
+        std::vector<Notification> mNotifications;
+        size_t                    mUpdateIdx;
+
+        NotificationRecorder() : mUpdateIdx( 0u ) {}
+
+        void notifyTextureChanged( TextureGpu *texture, TextureGpuListener::Reason reason,
+                                   void *extraData ) override
+        {
+            Notification notification;
+            notification.texture = texture;
+            notification.reason = reason;
+            notification.updateIdx = mUpdateIdx;
+            mNotifications.push_back( notification );
+        }
+
+        size_t count( TextureGpu *texture, TextureGpuListener::Reason reason ) const
+        {
+            size_t retVal = 0u;
+            for( size_t i = 0u; i < mNotifications.size(); ++i )
+            {
+                if( mNotifications[i].texture == texture && mNotifications[i].reason == reason )
+                    ++retVal;
+            }
+            return retVal;
+        }
+    };
+
+    /// Raises the priority of its texture like HlmsTextureBaseClass does
+    class CoverageDatablock : public HlmsDatablock
+    {
+        TextureGpu *mTexture;
+
+    public:
+        CoverageDatablock( IdString name, Hlms *creator, TextureGpu *texture ) :
+            HlmsDatablock( name, creator,
+                           creator->getHlmsManager()->getMacroblock( HlmsMacroblock() ),
+                           creator->getHlmsManager()->getBlendblock( HlmsBlendblock() ),
+                           HlmsParamVec() ),
+            mTexture( texture )
+        {
+        }
+
+        void _addTextureScreenCoverage( float coverage ) override
+        {
+            if( !mTexture->isDataReady() )
+                mTexture->getTextureManager()->_addScreenCoverage( mTexture, coverage );
+        }
+    };
+
+    class CoverageRenderable : public Renderable
+    {
+        LightList mLights;
+
+    public:
+        CoverageRenderable( HlmsDatablock *datablock, VertexArrayObject *vao )
+        {
+            mVaoPerLod[VpNormal].push_back( vao );
+            mVaoPerLod[VpShadow].push_back( vao );
+            // Not linked through setDatablock, which would calculate the Hlms hashes
+            mHlmsDatablock = datablock;
+        }
+        ~CoverageRenderable() override { mHlmsDatablock = 0; }
+
+        void getRenderOperation( v1::RenderOperation &op, bool casterPass ) override {}
+        void getWorldTransforms( Matrix4 *xform ) const override {}
+        const LightList &getLights() const override { return mLights; }
+    };
+
+    /// Has nothing to render when there's no datablock
+    class CoverageObject : public MovableObject
+    {
+        CoverageRenderable mRenderable;
+
+    public:
+        CoverageObject( SceneManager *sceneManager, HlmsDatablock *datablock,
+                        VertexArrayObject *vao ) :
+            MovableObject( Id::generateNewId<MovableObject>(),
+                           &sceneManager->_getEntityMemoryManager( SCENE_DYNAMIC ), sceneManager,
+                           10u ),
+            mRenderable( datablock, vao )
+        {
+            setLocalAabb( Aabb( Vector3::ZERO, Vector3( 1.0f ) ) );
+            if( datablock )
+                mRenderables.push_back( &mRenderable );
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType = "CoverageObject";
+            return movableType;
+        }
+    };
+
+    class CoverageSceneManager : public SceneManager
+    {
+    public:
+        CoverageSceneManager( size_t numWorkerThreads ) :
+            SceneManager( "CoverageSceneManager", numWorkerThreads )
+        {
+        }
+
+        const String &getTypeName() const override
+        {
+            static const String typeName = "CoverageSceneManager";
+            return typeName;
+        }
+    };
+
+    String getTextureName( size_t idx ) { return "Tex" + StringConverter::toString( idx ) + ".oitd"; }
+
+    std::vector<TextureGpu *> createTextures( TextureGpuManager *textureManager,
+                                              NotificationRecorder &recorder, size_t numTextures )
+    {
+        std::vector<TextureGpu *> textures;
+        for( size_t i = 0u; i < numTextures; ++i )
+        {
+            TextureGpu *texture = textureManager->createTexture(
+                getTextureName( i ), GpuPageOutStrategy::Discard, 0u,
+                TextureTypes::Type2D, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
+            texture->addListener( &recorder );
+            textures.push_back( texture );
+        }
+        return textures;
+    }
+
+    void destroyTextures( TextureGpuManager *textureManager, NotificationRecorder &recorder,
+                          const std::vector<TextureGpu *> &textures )
+    {
+        for( size_t i = 0u; i < textures.size(); ++i )
+        {
+            textures[i]->removeListener( &recorder );
+            textureManager->destroyTexture( textures[i] );
+        }
+    }
+
+    /// Like TextureGpuManager::waitForStreamingCompletion, but gives the streaming threads
+    /// time to finish what they're doing before each _update, and counts the _update calls.
+    void streamUntilDone( TextureGpuManager *textureManager, VaoManager *vaoManager,
+                          NotificationRecorder &recorder )
+    {
+        bool done = false;
+        while( !done )
+        {
+            Threads::Sleep( 20u );
+            ++recorder.mUpdateIdx;
+            done = textureManager->_update( true );
+            if( !done )
+                vaoManager->_update();
+        }
+        textureManager->waitForStreamingCompletion();
+    }
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = OGRE_NEW Root( 0, "", "", "" );
+    mNullPlugin = OGRE_NEW NULLPlugin();
+    mRoot->installPlugin( mNullPlugin );
+    mRoot->setRenderSystem( mRoot->getRenderSystemByName( "NULL Rendering Subsystem" ) );
+    mRoot->initialise( false );
+    mWindow = mRoot->createRenderWindow( "TextureStreamingTests", 1u, 1u, false );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::tearDown()
+{
+    ResourceGroupManager::getSingleton().setLoadingListener( 0 );
+
+    OGRE_DELETE mRoot;
+    mRoot = 0;
+    OGRE_DELETE mNullPlugin;
+    mNullPlugin = 0;
+    mWindow = 0;
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testMultiThreadStreaming()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TextureGpuManager *textureManager = mRoot->getRenderSystem()->getTextureGpuManager();
+    textureManager->setNumStreamingThreads( c_numStreamingThreads );
+    CPPUNIT_ASSERT_EQUAL( c_numStreamingThreads, textureManager->getNumStreamingThreads() );
+
+    MemoryLoadingListener loadingListener;
+    for( size_t i = 0u; i < c_numTextures; ++i )
+    {
+        loadingListener.addImage( getTextureName( i ), static_cast<uint32>( 4u + i ),
+                                  static_cast<uint32>( 8u + 2u * i ) );
+    }
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, c_numTextures );
+    for( size_t i = 0u; i < c_numTextures; ++i )
+        textures[i]->scheduleTransitionTo( GpuResidency::Resident );
+
+    textureManager->waitForStreamingCompletion();
+
+    // The listener may not be thread safe
+    CPPUNIT_ASSERT_EQUAL( c_numTextures, loadingListener.mNumLoads );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), loadingListener.mMaxActiveLoads );
+
+    for( size_t i = 0u; i < c_numTextures; ++i )
+    {
+        TextureGpu *texture = textures[i];
+        CPPUNIT_ASSERT( texture->getResidencyStatus() == GpuResidency::Resident );
+        CPPUNIT_ASSERT( texture->isDataReady() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<uint32>( 4u + i ), texture->getWidth() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<uint32>( 8u + 2u * i ), texture->getHeight() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 1u ),
+                              recorder.count( texture, TextureGpuListener::ReadyForRendering ) );
+        CPPUNIT_ASSERT_EQUAL( size_t( 0u ),
+                              recorder.count( texture, TextureGpuListener::ExceptionThrown ) );
+    }
+
+    // Back to one thread, which waits for everything to finish first
+    textureManager->setNumStreamingThreads( 1u );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ), textureManager->getNumStreamingThreads() );
+
+    destroyTextures( textureManager, recorder, textures );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testMultiThreadListenerOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TextureGpuManager *textureManager = mRoot->getRenderSystem()->getTextureGpuManager();
+    VaoManager *vaoManager = mRoot->getRenderSystem()->getVaoManager();
+    textureManager->setNumStreamingThreads( c_numStreamingThreads );
+
+    MemoryLoadingListener loadingListener;
+    for( size_t i = 0u; i < c_numTextures; ++i )
+        loadingListener.addImage( getTextureName( i ), 16u, 16u );
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, c_numTextures );
+    for( size_t i = 0u; i < c_numTextures; ++i )
+        textures[i]->scheduleTransitionTo( GpuResidency::Resident );
+
+    streamUntilDone( textureManager, vaoManager, recorder );
+
+    // Textures that became ready in the same _update must be notified in the order they
+    // were scheduled when they come from different streaming threads. A single thread may
+    // still finish a texture before one it was given earlier (e.g. it had to wait for
+    // staging memory), and that order is kept.
+    const size_t numThreads = textureManager->getNumStreamingThreads();
+    size_t numReady = 0u;
+    bool sameUpdateAcrossThreads = false;
+    size_t prevUpdateIdx = 0u;
+    size_t prevTextureIdx = 0u;
+    for( size_t i = 0u; i < recorder.mNotifications.size(); ++i )
+    {
+        const NotificationRecorder::Notification &notification = recorder.mNotifications[i];
+        if( notification.reason != TextureGpuListener::ReadyForRendering )
+            continue;
+
+        const size_t textureIdx = static_cast<size_t>(
+            std::find( textures.begin(), textures.end(), notification.texture ) - textures.begin() );
+        CPPUNIT_ASSERT( textureIdx < c_numTextures );
+
+        // Same hashing TextureGpuManager uses to pick the streaming thread
+        if( numReady > 0u && notification.updateIdx == prevUpdateIdx &&
+            textures[prevTextureIdx]->getName().mHash % numThreads !=
+                notification.texture->getName().mHash % numThreads )
+        {
+            CPPUNIT_ASSERT( prevTextureIdx < textureIdx );
+            sameUpdateAcrossThreads = true;
+        }
+
+        prevUpdateIdx = notification.updateIdx;
+        prevTextureIdx = textureIdx;
+        ++numReady;
+    }
+
+    CPPUNIT_ASSERT_EQUAL( c_numTextures, numReady );
+    // Otherwise the test proves nothing
+    CPPUNIT_ASSERT( sameUpdateAcrossThreads );
+
+    destroyTextures( textureManager, recorder, textures );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testMultiThreadLoadingListenerThrows()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TextureGpuManager *textureManager = mRoot->getRenderSystem()->getTextureGpuManager();
+    textureManager->setNumStreamingThreads( c_numStreamingThreads );
+
+    // Every 4th file fails to load. The streaming threads must not be left waiting
+    // for the lock around the listener
+    MemoryLoadingListener loadingListener;
+    for( size_t i = 0u; i < c_numTextures; ++i )
+    {
+        if( i % 4u == 0u )
+            loadingListener.addFailingFile( getTextureName( i ) );
+        else
+            loadingListener.addImage( getTextureName( i ), 16u, 16u );
+    }
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, c_numTextures );
+    for( size_t i = 0u; i < c_numTextures; ++i )
+        textures[i]->scheduleTransitionTo( GpuResidency::Resident );
+
+    textureManager->waitForStreamingCompletion();
+
+    CPPUNIT_ASSERT_EQUAL( c_numTextures, loadingListener.mNumLoads );
+
+    for( size_t i = 0u; i < c_numTextures; ++i )
+    {
+        TextureGpu *texture = textures[i];
+        // The ones that failed get the fallback texture
+        CPPUNIT_ASSERT( texture->getResidencyStatus() == GpuResidency::Resident );
+        CPPUNIT_ASSERT( texture->isDataReady() );
+        CPPUNIT_ASSERT_EQUAL( size_t( 1u ),
+                              recorder.count( texture, TextureGpuListener::ReadyForRendering ) );
+        CPPUNIT_ASSERT_EQUAL( size_t( i % 4u == 0u ? 1u : 0u ),
+                              recorder.count( texture, TextureGpuListener::ExceptionThrown ) );
+        if( i % 4u != 0u )
+            CPPUNIT_ASSERT_EQUAL( uint32( 16u ), texture->getWidth() );
+    }
+
+    destroyTextures( textureManager, recorder, textures );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testScreenCoverageLoadOrder()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    TextureGpuManager *textureManager = renderSystem->getTextureGpuManager();
+    VaoManager *vaoManager = renderSystem->getVaoManager();
+    // One streaming thread, so that the loads happen one after the other
+    textureManager->setNumStreamingThreads( 1u );
+    textureManager->setAutomaticLoadPriorities( true );
+
+    const size_t numWorkerThreads = 4u;
+    const size_t numTextures = 16u;
+    // Objects created after each textured one, so that they all end up in different chunks
+    // (see SceneManager::getObjectsPerChunk) and thus culled by different threads
+    const size_t numFillerObjects = 127u;
+
+    const String blockingName = "Blocker.oitd";
+    MemoryLoadingListener loadingListener;
+    loadingListener.addImage( blockingName, 16u, 16u );
+    loadingListener.setBlockingFile( blockingName );
+    for( size_t i = 0u; i < numTextures; ++i )
+        loadingListener.addImage( getTextureName( i ), 16u, 16u );
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    // Hlms::preparePassHash expects a render pass to be in progress when culling
+    RenderPassDescriptor *renderPassDesc = renderSystem->createRenderPassDescriptor();
+    renderPassDesc->mColour[0].texture = mWindow->getTexture();
+    renderPassDesc->entriesModified( RenderPassDescriptor::All );
+    const Vector4 fullVp( 0, 0, 1, 1 );
+    renderSystem->beginRenderPassDescriptor( renderPassDesc, mWindow->getTexture(), 0u, &fullVp,
+                                             &fullVp, 1u, false, false );
+
+    CoverageSceneManager *sceneManager = OGRE_NEW CoverageSceneManager( numWorkerThreads );
+    sceneManager->_setDestinationRenderSystem( renderSystem );
+    // FAST: the cull threads move the visible objects into the RenderQueue
+    sceneManager->getRenderQueue()->setRenderQueueMode( 10u, RenderQueue::FAST );
+
+    Camera *camera = sceneManager->createCamera( "Camera" );
+    camera->setPosition( Vector3::ZERO );
+    camera->lookAt( 0.0f, 0.0f, -1.0f );
+    camera->setNearClipDistance( 0.5f );
+    camera->setFarClipDistance( 1000.0f );
+    Viewport viewport;
+    viewport.setDimensions( mWindow->getTexture(), fullVp, fullVp, 0u );
+    viewport._setVisibilityMask( 0xFFFFFFFF, 0xFFFFFFFF );
+    camera->_notifyViewport( &viewport );
+
+    // Texture i goes on an object placed (i * 7) % numTextures steps away from the camera,
+    // so the closest objects aren't the ones whose textures were scheduled first.
+    // The fillers are behind the camera.
+    Hlms *hlms = mRoot->getHlmsManager()->getHlms( HLMS_LOW_LEVEL );
+    VertexArrayObject vao( 0u, 0u, 0u, VertexBufferPackedVec(), 0, OT_TRIANGLE_LIST );
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, numTextures );
+    std::vector<HlmsDatablock *> datablocks;
+    std::vector<MovableObject *> objects;
+    for( size_t i = 0u; i < numTextures; ++i )
+    {
+        datablocks.push_back( OGRE_NEW CoverageDatablock( "CoverageTest" + StringConverter::toString( i ),
+                                                          hlms, textures[i] ) );
+        objects.push_back( OGRE_NEW CoverageObject( sceneManager, datablocks.back(), &vao ) );
+        const Real distance = Real( 10 ) + Real( ( i * 7u ) % numTextures ) * Real( 10 );
+        SceneNode *sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+        sceneNode->setPosition( 0.0f, 0.0f, -distance );
+        sceneNode->attachObject( objects.back() );
+
+        for( size_t j = 0u; j < numFillerObjects; ++j )
+        {
+            objects.push_back( OGRE_NEW CoverageObject( sceneManager, 0, &vao ) );
+            sceneNode = sceneManager->getRootSceneNode()->createChildSceneNode();
+            sceneNode->setPosition( 0.0f, 0.0f, 50.0f );
+            sceneNode->attachObject( objects.back() );
+        }
+    }
+    sceneManager->updateSceneGraph();
+
+    // Hold the streaming thread, so that all the textures are waiting by the time
+    // their priorities are known
+    TextureGpu *blockingTexture = textureManager->createTexture(
+        blockingName, GpuPageOutStrategy::Discard, 0u, TextureTypes::Type2D,
+        ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME );
+    blockingTexture->scheduleTransitionTo( GpuResidency::Resident );
+    loadingListener.waitUntilBlocked();
+
+    camera->_cullScenePhase01( camera, camera, &viewport, 10u, 11u, false );
+    textureManager->_update( false );
+    for( size_t i = 0u; i < numTextures; ++i )
+        textures[i]->scheduleTransitionTo( GpuResidency::Resident );
+
+    loadingListener.unblock();
+    // Keep culling every frame, like a real app would
+    bool done = false;
+    while( !done )
+    {
+        camera->_cullScenePhase01( camera, camera, &viewport, 10u, 11u, false );
+        done = textureManager->_update( false ) && textureManager->isDoneStreaming();
+        vaoManager->_update();
+        Threads::Sleep( 1u );
+    }
+    textureManager->waitForStreamingCompletion();
+
+    // The closest objects' textures load first
+    CPPUNIT_ASSERT_EQUAL( numTextures + 1u, loadingListener.mLoadOrder.size() );
+    CPPUNIT_ASSERT_EQUAL( blockingName, loadingListener.mLoadOrder[0] );
+    for( size_t i = 0u; i < numTextures; ++i )
+    {
+        size_t textureIdx = 0u;
+        while( ( textureIdx * 7u ) % numTextures != i )
+            ++textureIdx;
+        CPPUNIT_ASSERT_EQUAL( getTextureName( textureIdx ), loadingListener.mLoadOrder[i + 1u] );
+        CPPUNIT_ASSERT( textures[textureIdx]->isDataReady() );
+    }
+
+    for( size_t i = 0u; i < objects.size(); ++i )
+    {
+        SceneNode *sceneNode = objects[i]->getParentSceneNode();
+        sceneNode->detachObject( objects[i] );
+        sceneNode->getParentSceneNode()->removeAndDestroyChild( sceneNode );
+        OGRE_DELETE objects[i];
+    }
+    for( size_t i = 0u; i < numTextures; ++i )
+        OGRE_DELETE datablocks[i];
+    sceneManager->destroyCamera( camera );
+    OGRE_DELETE sceneManager;
+
+    renderSystem->endRenderPassDescriptor();
+    renderSystem->destroyRenderPassDescriptor( renderPassDesc );
+
+    textureManager->destroyTexture( blockingTexture );
+    destroyTextures( textureManager, recorder, textures );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testProgressiveStreaming()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TextureGpuManager *textureManager = mRoot->getRenderSystem()->getTextureGpuManager();
+    VaoManager *vaoManager = mRoot->getRenderSystem()->getVaoManager();
+    CPPUNIT_ASSERT( textureManager->supportsProgressiveStreaming() );
+    // Mips 3 to 6 (8x8 and smaller) are the tail. The budget only lets one of
+    // the other mips through per frame
+    textureManager->setProgressiveStreaming( true, 1u, 8u );
+
+    MemoryLoadingListener loadingListener;
+    loadingListener.addImage( getTextureName( 0u ), 64u, 64u, 7u );
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, 1u );
+    NULLTextureGpu *texture = static_cast<NULLTextureGpu *>( textures[0] );
+    texture->scheduleTransitionTo( GpuResidency::Resident );
+
+    // Mips that were ready after each _update, until they all were. The texture
+    // becomes Resident in the same _update its first mips are ready
+    std::vector<uint8> mostDetailedMipsReady;
+    bool done = false;
+    while( !done )
+    {
+        Threads::Sleep( 1u );
+        done = textureManager->_update( false ) && textureManager->isDoneStreaming();
+        vaoManager->_update();
+        if( texture->getResidencyStatus() == GpuResidency::Resident &&
+            ( mostDetailedMipsReady.empty() ||
+              mostDetailedMipsReady.back() != texture->getMostDetailedMipReady() ) )
+        {
+            mostDetailedMipsReady.push_back( texture->getMostDetailedMipReady() );
+            // Only fully uploaded textures are ready
+            CPPUNIT_ASSERT_EQUAL( texture->getMostDetailedMipReady() == 0u,
+                                  texture->isDataReady() );
+        }
+    }
+    textureManager->waitForStreamingCompletion();
+
+    CPPUNIT_ASSERT_EQUAL( uint8( 7u ), texture->getNumMipmaps() );
+    CPPUNIT_ASSERT( texture->isDataReady() );
+
+    // The tail and the first mip outside of it go together (the budget is only checked
+    // before each mip), then one more mip per frame, from the coarsest to the finest.
+    // Several frames may go by between two uploads, but never two mips in the same one
+    CPPUNIT_ASSERT_EQUAL( size_t( 3u ), mostDetailedMipsReady.size() );
+    for( size_t i = 0u; i < mostDetailedMipsReady.size(); ++i )
+        CPPUNIT_ASSERT_EQUAL( uint8( 2u - i ), mostDetailedMipsReady[i] );
+
+    CPPUNIT_ASSERT_EQUAL(
+        size_t( 1u ), recorder.count( texture, TextureGpuListener::PartiallyReadyForRendering ) );
+    CPPUNIT_ASSERT_EQUAL( size_t( 1u ),
+                          recorder.count( texture, TextureGpuListener::ReadyForRendering ) );
+
+    textureManager->setProgressiveStreaming( false );
+    destroyTextures( textureManager, recorder, textures );
+}
+//--------------------------------------------------------------------------
+void TextureStreamingTests::testMostDetailedMipToLoad()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    TextureGpuManager *textureManager = mRoot->getRenderSystem()->getTextureGpuManager();
+
+    MemoryLoadingListener loadingListener;
+    loadingListener.addImage( getTextureName( 0u ), 64u, 32u, 7u );
+    ResourceGroupManager::getSingleton().setLoadingListener( &loadingListener );
+
+    NotificationRecorder recorder;
+    std::vector<TextureGpu *> textures = createTextures( textureManager, recorder, 1u );
+    TextureGpu *texture = textures[0];
+
+    texture->setMostDetailedMipToLoad( 2u );
+    texture->scheduleTransitionTo( GpuResidency::Resident );
+    textureManager->waitForStreamingCompletion();
+
+    CPPUNIT_ASSERT( texture->isDataReady() );
+    CPPUNIT_ASSERT_EQUAL( uint32( 16u ), texture->getWidth() );
+    CPPUNIT_ASSERT_EQUAL( uint32( 8u ), texture->getHeight() );
+    CPPUNIT_ASSERT_EQUAL( uint8( 5u ), texture->getNumMipmaps() );
+
+    // Changing it while Resident reloads the file
+    texture->setMostDetailedMipToLoad( 0u );
+    textureManager->waitForStreamingCompletion();
+
+    CPPUNIT_ASSERT( texture->isDataReady() );
+    CPPUNIT_ASSERT_EQUAL( uint32( 64u ), texture->getWidth() );
+    CPPUNIT_ASSERT_EQUAL( uint32( 32u ), texture->getHeight() );
+    CPPUNIT_ASSERT_EQUAL( uint8( 7u ), texture->getNumMipmaps() );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ), loadingListener.mNumLoads );
+    CPPUNIT_ASSERT_EQUAL( size_t( 2u ),
+                          recorder.count( texture, TextureGpuListener::ReadyForRendering ) );
+
+    destroyTextures( textureManager, recorder, textures );
+}